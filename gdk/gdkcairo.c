@@ -52,6 +52,9 @@ gdk_cairo_create (GdkDrawable *drawable)
   cr = cairo_create (surface);
   cairo_surface_destroy (surface);
 
+  if (GDK_IS_WINDOW (drawable))
+    _gdk_window_clip_cairo (GDK_WINDOW (drawable), cr);
+
   return cr;
 }
 
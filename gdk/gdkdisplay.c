@@ -22,6 +22,7 @@
  */
 
 #include "config.h"
+#include <string.h>
 #include <glib.h>
 #include "gdk.h"		/* gdk_event_send_client_message() */
 #include "gdkdisplay.h"
@@ -38,6 +39,8 @@ enum {
 static void gdk_display_dispose    (GObject         *object);
 static void gdk_display_finalize   (GObject         *object);
 
+static void gdk_frame_scheduler_free (gpointer data);
+
 
 static void       singlehead_get_pointer (GdkDisplay       *display,
 					  GdkScreen       **screen,
@@ -65,6 +68,8 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 static char *gdk_sm_client_id;
 
+static GQuark quark_frame_scheduler = 0;
+
 static const GdkDisplayPointerHooks default_pointer_hooks = {
   _gdk_windowing_get_pointer,
   _gdk_windowing_window_get_pointer,
@@ -114,6 +119,8 @@ gdk_display_class_init (GdkDisplayClass *class)
 		  G_TYPE_NONE,
 		  1,
 		  G_TYPE_BOOLEAN);
+
+  quark_frame_scheduler = g_quark_from_static_string ("gdk-frame-scheduler");
 }
 
 static void
@@ -143,6 +150,9 @@ gdk_display_dispose (GObject *object)
   display->queued_events = NULL;
   display->queued_tail = NULL;
 
+  /* no more frames for a closed display */
+  g_object_set_qdata (object, quark_frame_scheduler, NULL);
+
   _gdk_displays = g_slist_remove (_gdk_displays, object);
 
   if (gdk_display_get_default() == display)
@@ -501,6 +511,8 @@ gdk_display_get_window_at_pointer (GdkDisplay *display,
   g_return_val_if_fail (GDK_IS_DISPLAY (display), NULL);
 
   window = display->pointer_hooks->window_at_pointer (display, &tmp_x, &tmp_y);
+  if (window)
+    window = _gdk_window_pick_emulated (window, &tmp_x, &tmp_y);
 
   if (win_x)
     *win_x = tmp_x;
@@ -632,5 +644,558 @@ gdk_set_pointer_hooks (const GdkPointerHooks *new_hooks)
   return (GdkPointerHooks *)result;
 }
 
+/* Frame scheduling
+ *
+ * Animation ticks, layout and painting of a display run together in
+ * one frame. While something animates, frames are paced to the frame
+ * interval, and everything else that comes up in between waits for the
+ * next frame; otherwise a frame runs as soon as the main loop is idle.
+ */
+
+/* the priority the layout idle of GTK+ used to run at */
+#define FRAME_PRIORITY (G_PRIORITY_HIGH_IDLE + 10)
+
+#define DEFAULT_FRAME_INTERVAL 16
+
+typedef struct _GdkFrameScheduler GdkFrameScheduler;
+typedef struct _GdkFrameHandler   GdkFrameHandler;
+
+struct _GdkFrameHandler
+{
+  guint          id;
+  GdkFramePhase  phase;
+  GdkFrameFunc   func;
+  gpointer       data;
+  GDestroyNotify notify;
+
+  guint queued : 1;
+  guint removed : 1;
+};
+
+struct _GdkFrameScheduler
+{
+  GdkDisplay *display;
+
+  GList *handlers;		/* sorted by phase */
+  guint next_handler_id;
+
+  guint source_id;
+  guint interval;		/* msecs */
+
+  GTimeVal frame_time;		/* start of the current or last frame */
+  GTimeVal target_time;		/* when the queued frame should run */
+
+  GdkFrameStats stats;
+
+  guint paint_queued : 1;
+  guint animating : 1;		/* a handler asked for the next frame */
+  guint in_frame : 1;
+};
+
+static void gdk_frame_scheduler_queue (GdkFrameScheduler *scheduler);
+
+static gdouble
+time_val_diff (const GTimeVal *a,
+	       const GTimeVal *b)
+{
+  return (a->tv_sec - b->tv_sec) * 1000.0 + (a->tv_usec - b->tv_usec) / 1000.0;
+}
+
+static void
+gdk_frame_handler_free (GdkFrameHandler *handler)
+{
+  if (handler->notify)
+    handler->notify (handler->data);
+  g_slice_free (GdkFrameHandler, handler);
+}
+
+static void
+gdk_frame_scheduler_free (gpointer data)
+{
+  GdkFrameScheduler *scheduler = data;
+
+  if (scheduler->source_id)
+    g_source_remove (scheduler->source_id);
+
+  g_list_foreach (scheduler->handlers, (GFunc) gdk_frame_handler_free, NULL);
+  g_list_free (scheduler->handlers);
+
+  g_slice_free (GdkFrameScheduler, scheduler);
+}
+
+static GdkFrameScheduler *
+gdk_display_get_frame_scheduler (GdkDisplay *display)
+{
+  GdkFrameScheduler *scheduler;
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (!scheduler && !display->closed)
+    {
+      scheduler = g_slice_new0 (GdkFrameScheduler);
+      scheduler->display = display;
+      scheduler->next_handler_id = 1;
+      scheduler->interval = DEFAULT_FRAME_INTERVAL;
+
+      g_object_set_qdata_full (G_OBJECT (display), quark_frame_scheduler,
+			       scheduler, gdk_frame_scheduler_free);
+    }
+
+  return scheduler;
+}
+
+static GdkFrameHandler *
+gdk_frame_scheduler_find (GdkFrameScheduler *scheduler,
+			  guint              handler_id)
+{
+  GList *l;
+
+  for (l = scheduler->handlers; l; l = l->next)
+    {
+      GdkFrameHandler *handler = l->data;
+
+      if (handler->id == handler_id && !handler->removed)
+	return handler;
+    }
+
+  return NULL;
+}
+
+/* Returns %FALSE if the display was closed by a handler, which
+ * also frees @scheduler.
+ */
+static gboolean
+gdk_frame_scheduler_run_phase (GdkFrameScheduler *scheduler,
+			       GdkFramePhase      phase)
+{
+  GdkDisplay *display = scheduler->display;
+  GList *l;
+
+  for (l = scheduler->handlers; l; l = l->next)
+    {
+      GdkFrameHandler *handler = l->data;
+
+      if (handler->phase < phase)
+	continue;
+      if (handler->phase > phase)
+	break;
+
+      if (handler->queued && !handler->removed)
+	{
+	  gboolean again;
+
+	  handler->queued = FALSE;
+	  again = handler->func (display, handler->data);
+
+	  if (display->closed)
+	    return FALSE;
+
+	  if (again && !handler->removed)
+	    {
+	      handler->queued = TRUE;
+	      scheduler->animating = TRUE;
+	    }
+	}
+    }
+
+  if (phase == GDK_FRAME_PHASE_PAINT && scheduler->paint_queued)
+    {
+      scheduler->paint_queued = FALSE;
+      gdk_window_process_all_updates ();
+    }
+
+  return !display->closed;
+}
+
+/* Removes the handlers that went away during a frame, and
+ * returns whether another frame is needed.
+ */
+static gboolean
+gdk_frame_scheduler_purge (GdkFrameScheduler *scheduler)
+{
+  gboolean pending = scheduler->paint_queued;
+  GList *l, *next;
+
+  for (l = scheduler->handlers; l; l = next)
+    {
+      GdkFrameHandler *handler = l->data;
+
+      next = l->next;
+      if (handler->removed)
+	{
+	  scheduler->handlers = g_list_delete_link (scheduler->handlers, l);
+	  gdk_frame_handler_free (handler);
+	}
+      else if (handler->queued)
+	pending = TRUE;
+    }
+
+  return pending;
+}
+
+static gboolean
+gdk_frame_scheduler_dispatch (gpointer data)
+{
+  GdkFrameScheduler *scheduler = data;
+  GdkDisplay *display = scheduler->display;
+  GdkFrameStats *stats = &scheduler->stats;
+  GTimeVal start, end;
+  gdouble frame_length;
+  gdouble lateness;
+
+  scheduler->source_id = 0;
+
+  g_object_ref (display);
+
+  g_get_current_time (&start);
+
+  if (scheduler->animating)
+    {
+      lateness = time_val_diff (&start, &scheduler->target_time);
+      if (lateness >= scheduler->interval)
+	stats->n_missed_frames += lateness / scheduler->interval;
+    }
+
+  scheduler->frame_time = start;
+  scheduler->animating = FALSE;
+  scheduler->in_frame = TRUE;
+
+  if (!gdk_frame_scheduler_run_phase (scheduler, GDK_FRAME_PHASE_UPDATE))
+    goto out;
+  g_get_current_time (&end);
+  stats->update_time += time_val_diff (&end, &start);
+
+  start = end;
+  if (!gdk_frame_scheduler_run_phase (scheduler, GDK_FRAME_PHASE_LAYOUT))
+    goto out;
+  g_get_current_time (&end);
+  stats->layout_time += time_val_diff (&end, &start);
+
+  start = end;
+  if (!gdk_frame_scheduler_run_phase (scheduler, GDK_FRAME_PHASE_PAINT))
+    goto out;
+  g_get_current_time (&end);
+  stats->paint_time += time_val_diff (&end, &start);
+
+  scheduler->in_frame = FALSE;
+
+  stats->n_frames++;
+  frame_length = time_val_diff (&end, &scheduler->frame_time);
+  if (frame_length > stats->max_frame_time)
+    stats->max_frame_time = frame_length;
+
+  if (gdk_frame_scheduler_purge (scheduler))
+    gdk_frame_scheduler_queue (scheduler);
+
+ out:
+  g_object_unref (display);
+
+  return FALSE;
+}
+
+static void
+gdk_frame_scheduler_queue (GdkFrameScheduler *scheduler)
+{
+  GTimeVal now;
+  gdouble delay;
+
+  /* requests during a frame are looked at once it is done */
+  if (scheduler->in_frame || scheduler->source_id)
+    return;
+
+  if (scheduler->animating)
+    {
+      scheduler->target_time = scheduler->frame_time;
+      g_time_val_add (&scheduler->target_time, scheduler->interval * 1000);
+
+      g_get_current_time (&now);
+      delay = time_val_diff (&scheduler->target_time, &now);
+
+      if (delay >= 1)
+	{
+	  scheduler->source_id =
+	    gdk_threads_add_timeout_full (FRAME_PRIORITY, delay,
+					  gdk_frame_scheduler_dispatch,
+					  scheduler, NULL);
+	  return;
+	}
+    }
+
+  scheduler->source_id =
+    gdk_threads_add_idle_full (FRAME_PRIORITY,
+			       gdk_frame_scheduler_dispatch,
+			       scheduler, NULL);
+}
+
+/**
+ * _gdk_display_queue_paint:
+ * @display: a #GdkDisplay
+ *
+ * Makes sure that the invalid regions of windows are exposed in the
+ * next frame of @display.
+ */
+void
+_gdk_display_queue_paint (GdkDisplay *display)
+{
+  GdkFrameScheduler *scheduler = gdk_display_get_frame_scheduler (display);
+
+  if (!scheduler)
+    return;
+
+  scheduler->paint_queued = TRUE;
+  gdk_frame_scheduler_queue (scheduler);
+}
+
+/**
+ * gdk_display_add_frame_handler:
+ * @display: a #GdkDisplay
+ * @phase: the phase of the frame to run @func in
+ * @func: the function to call
+ * @data: data to pass to @func
+ * @notify: function to call with @data when the handler is removed, or %NULL
+ *
+ * Adds a function to be called in frames of @display. Each frame
+ * first runs the handlers of the %GDK_FRAME_PHASE_UPDATE phase, where
+ * animations advance; then those of %GDK_FRAME_PHASE_LAYOUT, where
+ * sizes are negotiated; and then those of %GDK_FRAME_PHASE_PAINT,
+ * before the invalid regions of all windows are exposed.
+ *
+ * The handler is only called in the next frame after it has been
+ * queued with gdk_display_queue_frame_handler(). If @func returns
+ * %TRUE, it is queued again for the following frame; as long as
+ * handlers do that, frames are spaced by the frame interval of
+ * @display. See gdk_display_set_frame_interval().
+ *
+ * Return value: the ID of the handler
+ *
+ * Since: 2.16
+ */
+guint
+gdk_display_add_frame_handler (GdkDisplay    *display,
+			       GdkFramePhase  phase,
+			       GdkFrameFunc   func,
+			       gpointer       data,
+			       GDestroyNotify notify)
+{
+  GdkFrameScheduler *scheduler;
+  GdkFrameHandler *handler;
+  GList *l;
+
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  scheduler = gdk_display_get_frame_scheduler (display);
+  g_return_val_if_fail (scheduler != NULL, 0);
+
+  handler = g_slice_new0 (GdkFrameHandler);
+  handler->id = scheduler->next_handler_id++;
+  handler->phase = phase;
+  handler->func = func;
+  handler->data = data;
+  handler->notify = notify;
+
+  /* keep the order in which handlers of a phase were added */
+  for (l = scheduler->handlers; l; l = l->next)
+    if (((GdkFrameHandler *) l->data)->phase > phase)
+      break;
+
+  scheduler->handlers = g_list_insert_before (scheduler->handlers, l, handler);
+
+  return handler->id;
+}
+
+/**
+ * gdk_display_remove_frame_handler:
+ * @display: a #GdkDisplay
+ * @handler_id: the ID of a handler returned by gdk_display_add_frame_handler()
+ *
+ * Removes a frame handler. The destroy notify of the handler
+ * is called.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_remove_frame_handler (GdkDisplay *display,
+				  guint       handler_id)
+{
+  GdkFrameScheduler *scheduler;
+  GdkFrameHandler *handler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (!scheduler)
+    return;
+
+  handler = gdk_frame_scheduler_find (scheduler, handler_id);
+  g_return_if_fail (handler != NULL);
+
+  if (scheduler->in_frame)
+    handler->removed = TRUE;
+  else
+    {
+      scheduler->handlers = g_list_remove (scheduler->handlers, handler);
+      gdk_frame_handler_free (handler);
+    }
+}
+
+/**
+ * gdk_display_queue_frame_handler:
+ * @display: a #GdkDisplay
+ * @handler_id: the ID of a handler returned by gdk_display_add_frame_handler()
+ *
+ * Queues a frame handler to be called in the next frame of @display.
+ * If a frame is in progress and the phase of the handler has not
+ * been reached yet, the handler is called in that frame.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_queue_frame_handler (GdkDisplay *display,
+				 guint       handler_id)
+{
+  GdkFrameScheduler *scheduler;
+  GdkFrameHandler *handler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (!scheduler)
+    return;
+
+  handler = gdk_frame_scheduler_find (scheduler, handler_id);
+  g_return_if_fail (handler != NULL);
+
+  if (!handler->queued)
+    {
+      handler->queued = TRUE;
+      gdk_frame_scheduler_queue (scheduler);
+    }
+}
+
+/**
+ * gdk_display_get_frame_time:
+ * @display: a #GdkDisplay
+ * @result: return location for the time
+ *
+ * Gets the time at which the current frame of @display started,
+ * or the last one if no frame is in progress. Animations should
+ * use this time rather than the current time, so that everything
+ * drawn in a frame is in step.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_get_frame_time (GdkDisplay *display,
+			    GTimeVal   *result)
+{
+  GdkFrameScheduler *scheduler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+  g_return_if_fail (result != NULL);
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (scheduler && scheduler->frame_time.tv_sec != 0)
+    *result = scheduler->frame_time;
+  else
+    g_get_current_time (result);
+}
+
+/**
+ * gdk_display_set_frame_interval:
+ * @display: a #GdkDisplay
+ * @interval: the time between frames in milliseconds
+ *
+ * Sets the time between two frames of @display while frame
+ * handlers keep asking for more frames. The default is 16
+ * milliseconds, which matches the refresh rate of most monitors.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_set_frame_interval (GdkDisplay *display,
+				guint       interval)
+{
+  GdkFrameScheduler *scheduler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+  g_return_if_fail (interval > 0);
+
+  scheduler = gdk_display_get_frame_scheduler (display);
+  if (scheduler)
+    scheduler->interval = interval;
+}
+
+/**
+ * gdk_display_get_frame_interval:
+ * @display: a #GdkDisplay
+ *
+ * Gets the time between frames of @display, see
+ * gdk_display_set_frame_interval().
+ *
+ * Return value: the frame interval in milliseconds
+ *
+ * Since: 2.16
+ */
+guint
+gdk_display_get_frame_interval (GdkDisplay *display)
+{
+  GdkFrameScheduler *scheduler;
+
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), DEFAULT_FRAME_INTERVAL);
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+
+  return scheduler ? scheduler->interval : DEFAULT_FRAME_INTERVAL;
+}
+
+/**
+ * gdk_display_get_frame_stats:
+ * @display: a #GdkDisplay
+ * @stats: return location for the statistics
+ *
+ * Gets timing statistics for the frames of @display since it was
+ * opened, or since the last call to gdk_display_reset_frame_stats().
+ * The times are totals in milliseconds; divide them by the number
+ * of frames for averages. Frames that started more than a frame
+ * interval after they were due while animating count as missed.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_get_frame_stats (GdkDisplay    *display,
+			     GdkFrameStats *stats)
+{
+  GdkFrameScheduler *scheduler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+  g_return_if_fail (stats != NULL);
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (scheduler)
+    *stats = scheduler->stats;
+  else
+    memset (stats, 0, sizeof (GdkFrameStats));
+}
+
+/**
+ * gdk_display_reset_frame_stats:
+ * @display: a #GdkDisplay
+ *
+ * Resets the frame statistics of @display.
+ *
+ * Since: 2.16
+ */
+void
+gdk_display_reset_frame_stats (GdkDisplay *display)
+{
+  GdkFrameScheduler *scheduler;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  scheduler = g_object_get_qdata (G_OBJECT (display), quark_frame_scheduler);
+  if (scheduler)
+    memset (&scheduler->stats, 0, sizeof (GdkFrameStats));
+}
+
 #define __GDK_DISPLAY_C__
 #include "gdkaliasdef.c"
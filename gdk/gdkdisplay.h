@@ -35,6 +35,17 @@ G_BEGIN_DECLS
 
 typedef struct _GdkDisplayClass GdkDisplayClass;
 typedef struct _GdkDisplayPointerHooks GdkDisplayPointerHooks;
+typedef struct _GdkFrameStats GdkFrameStats;
+
+typedef enum
+{
+  GDK_FRAME_PHASE_UPDATE,
+  GDK_FRAME_PHASE_LAYOUT,
+  GDK_FRAME_PHASE_PAINT
+} GdkFramePhase;
+
+typedef gboolean (*GdkFrameFunc) (GdkDisplay *display,
+				  gpointer    data);
 
 #define GDK_TYPE_DISPLAY              (gdk_display_get_type ())
 #define GDK_DISPLAY_OBJECT(object)    (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_DISPLAY, GdkDisplay))
@@ -86,6 +97,16 @@ struct _GdkDisplayClass
 		  gboolean    is_error);
 };
 
+struct _GdkFrameStats
+{
+  guint   n_frames;
+  guint   n_missed_frames;
+  gdouble update_time;
+  gdouble layout_time;
+  gdouble paint_time;
+  gdouble max_frame_time;
+};
+
 struct _GdkDisplayPointerHooks
 {
   void (*get_pointer)              (GdkDisplay      *display,
@@ -186,6 +207,24 @@ gboolean gdk_display_supports_shapes           (GdkDisplay    *display);
 gboolean gdk_display_supports_input_shapes     (GdkDisplay    *display);
 gboolean gdk_display_supports_composite        (GdkDisplay    *display);
 
+guint    gdk_display_add_frame_handler         (GdkDisplay    *display,
+						GdkFramePhase  phase,
+						GdkFrameFunc   func,
+						gpointer       data,
+						GDestroyNotify notify);
+void     gdk_display_remove_frame_handler      (GdkDisplay    *display,
+						guint          handler_id);
+void     gdk_display_queue_frame_handler       (GdkDisplay    *display,
+						guint          handler_id);
+void     gdk_display_get_frame_time            (GdkDisplay    *display,
+						GTimeVal      *result);
+void     gdk_display_set_frame_interval        (GdkDisplay    *display,
+						guint          interval);
+guint    gdk_display_get_frame_interval        (GdkDisplay    *display);
+void     gdk_display_get_frame_stats           (GdkDisplay    *display,
+						GdkFrameStats *stats);
+void     gdk_display_reset_frame_stats         (GdkDisplay    *display);
+
 G_END_DECLS
 
 #endif	/* __GDK_DISPLAY_H__ */
@@ -110,6 +110,14 @@ GList *
 _gdk_event_queue_append (GdkDisplay *display,
 			 GdkEvent   *event)
 {
+  static guint32 trace_serial = 0;
+
+  if (G_UNLIKELY (gdk_trace_is_enabled ()))
+    {
+      ((GdkEventPrivate *)event)->trace_id = ++trace_serial;
+      gdk_trace_record (GDK_TRACE_EVENT_QUEUED, trace_serial, 0);
+    }
+
   display->queued_tail = g_list_append (display->queued_tail, event);
   
   if (!display->queued_events)
@@ -120,6 +128,78 @@ _gdk_event_queue_append (GdkDisplay *display,
   return display->queued_tail;
 }
 
+/* The sibling is normally the event being translated, which
+ * is at the end of the queue, so search from there.
+ */
+static GList *
+gdk_event_queue_find (GdkDisplay *display,
+		      GdkEvent   *event)
+{
+  GList *tmp_list;
+
+  for (tmp_list = display->queued_tail; tmp_list; tmp_list = tmp_list->prev)
+    if (tmp_list->data == event)
+      return tmp_list;
+
+  return NULL;
+}
+
+/**
+ * _gdk_event_queue_insert_after:
+ * @display: a #GdkDisplay
+ * @sibling: Event already on the queue
+ * @event: Event to insert.
+ *
+ * Inserts an event right after @sibling in the event queue.
+ * If @sibling isn't on the queue, @event is appended.
+ *
+ * Returns: the newly inserted list node.
+ **/
+GList *
+_gdk_event_queue_insert_after (GdkDisplay *display,
+			       GdkEvent   *sibling,
+			       GdkEvent   *event)
+{
+  GList *prev = gdk_event_queue_find (display, sibling);
+
+  if (prev && prev->next)
+    {
+      display->queued_events = g_list_insert_before (display->queued_events,
+						     prev->next, event);
+      return prev->next;
+    }
+  else
+    return _gdk_event_queue_append (display, event);
+}
+
+/**
+ * _gdk_event_queue_insert_before:
+ * @display: a #GdkDisplay
+ * @sibling: Event already on the queue
+ * @event: Event to insert.
+ *
+ * Inserts an event right before @sibling in the event queue.
+ * If @sibling isn't on the queue, @event is appended.
+ *
+ * Returns: the newly inserted list node.
+ **/
+GList *
+_gdk_event_queue_insert_before (GdkDisplay *display,
+				GdkEvent   *sibling,
+				GdkEvent   *event)
+{
+  GList *next = gdk_event_queue_find (display, sibling);
+
+  if (next)
+    {
+      display->queued_events = g_list_insert_before (display->queued_events,
+						     next, event);
+      return next->prev;
+    }
+  else
+    return _gdk_event_queue_append (display, event);
+}
+
 /**
  * _gdk_event_queue_remove_link:
  * @display: a #GdkDisplay
@@ -142,6 +222,49 @@ _gdk_event_queue_remove_link (GdkDisplay *display,
     display->queued_tail = node->prev;
 }
 
+/* Whether @event may be dropped in favour of @next, the motion
+ * event that follows it in the queue.
+ */
+static gboolean
+gdk_event_can_compress (GdkEvent *event,
+			GdkEvent *next)
+{
+  return (event->type == GDK_MOTION_NOTIFY &&
+	  next->type == GDK_MOTION_NOTIFY &&
+	  !(((GdkEventPrivate *)next)->flags & GDK_EVENT_PENDING) &&
+	  event->motion.window == next->motion.window &&
+	  event->motion.device == next->motion.device &&
+	  event->motion.state == next->motion.state &&
+	  !event->motion.is_hint && !next->motion.is_hint &&
+	  gdk_window_get_motion_compression (event->motion.window));
+}
+
+/**
+ * _gdk_event_queue_wants_motion:
+ * @display: a #GdkDisplay
+ * 
+ * Checks whether the last event on the queue is a motion event
+ * that a following motion event could be compressed with. Backends
+ * use this to read ahead through the motion events they have pending.
+ * 
+ * Return value: %TRUE if further motion events should be queued
+ **/
+gboolean
+_gdk_event_queue_wants_motion (GdkDisplay *display)
+{
+  GdkEvent *event;
+
+  if (!display->queued_tail)
+    return FALSE;
+
+  event = display->queued_tail->data;
+
+  return (event->type == GDK_MOTION_NOTIFY &&
+	  !(((GdkEventPrivate *)event)->flags & GDK_EVENT_PENDING) &&
+	  !event->motion.is_hint &&
+	  gdk_window_get_motion_compression (event->motion.window));
+}
+
 /**
  * _gdk_event_unqueue:
  * @display: a #GdkDisplay
@@ -163,6 +286,25 @@ _gdk_event_unqueue (GdkDisplay *display)
   if (tmp_list)
     {
       event = tmp_list->data;
+
+      /* Merge runs of motion events into the last one of them */
+      while (tmp_list->next && gdk_event_can_compress (event, tmp_list->next->data))
+	{
+	  GdkEventPrivate *private = (GdkEventPrivate *)event;
+	  GdkEventPrivate *next_private = tmp_list->next->data;
+	  GList *node = tmp_list;
+	  GList *history;
+
+	  history = g_list_append (private->motion_history, event);
+	  private->motion_history = NULL;
+	  next_private->motion_history = g_list_concat (history, next_private->motion_history);
+
+	  tmp_list = tmp_list->next;
+	  _gdk_event_queue_remove_link (display, node);
+	  g_list_free_1 (node);
+	  event = tmp_list->data;
+	}
+
       _gdk_event_queue_remove_link (display, tmp_list);
       g_list_free_1 (tmp_list);
     }
@@ -387,8 +529,15 @@ gdk_event_copy (const GdkEvent *event)
   if (gdk_event_is_allocated (event))
     {
       GdkEventPrivate *private = (GdkEventPrivate *)event;
+      GList *l;
 
       new_private->screen = private->screen;
+      new_private->trace_id = private->trace_id;
+
+      for (l = private->motion_history; l; l = l->next)
+	new_private->motion_history = g_list_prepend (new_private->motion_history,
+						      gdk_event_copy (l->data));
+      new_private->motion_history = g_list_reverse (new_private->motion_history);
     }
   
   switch (event->any.type)
@@ -509,6 +658,12 @@ gdk_event_free (GdkEvent *event)
 
   _gdk_windowing_event_data_free (event);
 
+  if (((GdkEventPrivate *)event)->motion_history)
+    {
+      g_list_foreach (((GdkEventPrivate *)event)->motion_history, (GFunc) gdk_event_free, NULL);
+      g_list_free (((GdkEventPrivate *)event)->motion_history);
+    }
+
   g_hash_table_remove (event_hash, event);
   g_slice_free (GdkEventPrivate, (GdkEventPrivate*) event);
 }
@@ -889,6 +1044,56 @@ gdk_event_request_motions (const GdkEventMotion *event)
     gdk_device_get_state (event->device, event->window, NULL, NULL);
 }
 
+/**
+ * gdk_event_get_motion_history:
+ * @event: a #GdkEvent
+ * 
+ * If motion compression is enabled for the window of @event
+ * (see gdk_window_set_motion_compression()), a motion event stands
+ * for all the motion events that were queued for the window before
+ * it, with the same device and modifier state. This function
+ * returns those earlier events, so that applications that need
+ * every sample, for instance for drawing with a tablet, can still
+ * get them.
+ * 
+ * Return value: a list of #GdkEvent<!-- -->s, oldest first, or %NULL
+ *   if @event does not stand for earlier events. The list and the
+ *   events are owned by @event and must not be modified or freed.
+ *
+ * Since: 2.16
+ **/
+GList *
+gdk_event_get_motion_history (const GdkEvent *event)
+{
+  g_return_val_if_fail (event != NULL, NULL);
+
+  if (event->type != GDK_MOTION_NOTIFY || !gdk_event_is_allocated (event))
+    return NULL;
+
+  return ((GdkEventPrivate *)event)->motion_history;
+}
+
+/**
+ * gdk_trace_get_event_id:
+ * @event: a #GdkEvent
+ * 
+ * Returns the id that trace records for @event carry. Events get
+ * an id when they are put on the event queue while tracing is
+ * enabled; see gdk_trace_is_enabled().
+ * 
+ * Return value: the trace id of @event, or 0
+ **/
+guint32
+gdk_trace_get_event_id (const GdkEvent *event)
+{
+  g_return_val_if_fail (event != NULL, 0);
+
+  if (!gdk_event_is_allocated (event))
+    return 0;
+
+  return ((GdkEventPrivate *)event)->trace_id;
+}
+
 /**
  * gdk_event_set_screen:
  * @event: a #GdkEvent
@@ -538,6 +538,7 @@ gboolean  gdk_event_get_axis            (const GdkEvent  *event,
                                          GdkAxisUse       axis_use,
                                          gdouble         *value);
 void      gdk_event_request_motions     (const GdkEventMotion *event);
+GList *   gdk_event_get_motion_history  (const GdkEvent  *event);
 void	  gdk_event_handler_set 	(GdkEventFunc    func,
 					 gpointer        data,
 					 GDestroyNotify  notify);
@@ -49,6 +49,9 @@ struct _GdkGCPrivate
   
   guint32 fg_pixel;
   guint32 bg_pixel;
+
+  guint subwindow_mode : 1;
+  guint have_clip_mask : 1;
 };
 
 #define GDK_GC_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), GDK_TYPE_GC, GdkGCPrivate))
@@ -172,6 +175,10 @@ _gdk_gc_init (GdkGC           *gc,
     priv->fg_pixel = values->foreground.pixel;
   if (values_mask & GDK_GC_BACKGROUND)
     priv->bg_pixel = values->background.pixel;
+  if (values_mask & GDK_GC_SUBWINDOW)
+    priv->subwindow_mode = values->subwindow_mode;
+  if (values_mask & GDK_GC_CLIP_MASK)
+    priv->have_clip_mask = values->clip_mask != NULL;
 
   gc->colormap = gdk_drawable_get_colormap (drawable);
   if (gc->colormap)
@@ -284,6 +291,7 @@ gdk_gc_set_values (GdkGC           *gc,
 	  gdk_region_destroy (priv->clip_region);
 	  priv->clip_region = NULL;
 	}
+      priv->have_clip_mask = values->clip_mask != NULL;
     }
   if (values_mask & GDK_GC_FILL)
     priv->fill = values->fill;
@@ -313,6 +321,8 @@ gdk_gc_set_values (GdkGC           *gc,
     priv->fg_pixel = values->foreground.pixel;
   if (values_mask & GDK_GC_BACKGROUND)
     priv->bg_pixel = values->background.pixel;
+  if (values_mask & GDK_GC_SUBWINDOW)
+    priv->subwindow_mode = values->subwindow_mode;
   
   GDK_GC_GET_CLASS (gc)->set_values (gc, values, values_mask);
 }
@@ -552,6 +562,7 @@ _gdk_gc_set_clip_region_internal (GdkGC     *gc,
     gdk_region_destroy (priv->clip_region);
 
   priv->clip_region = region;
+  priv->have_clip_mask = FALSE;
 
   _gdk_windowing_gc_set_clip_region (gc, region);
 }
@@ -710,6 +721,40 @@ _gdk_gc_get_bg_pixel (GdkGC *gc)
   return GDK_GC_GET_PRIVATE (gc)->bg_pixel;
 }
 
+/**
+ * _gdk_gc_has_clip_mask:
+ * @gc: a #GdkGC
+ * 
+ * Checks whether @gc clips to a bitmap set with
+ * gdk_gc_set_clip_mask(), which _gdk_gc_get_clip_region()
+ * doesn't report.
+ * 
+ * Return value: %TRUE if @gc has a clip mask
+ **/
+gboolean
+_gdk_gc_has_clip_mask (GdkGC *gc)
+{
+  g_return_val_if_fail (GDK_IS_GC (gc), FALSE);
+
+  return GDK_GC_GET_PRIVATE (gc)->have_clip_mask;
+}
+
+/**
+ * _gdk_gc_get_subwindow:
+ * @gc: a #GdkGC
+ * 
+ * Gets the subwindow mode of @gc.
+ * 
+ * Return value: the subwindow mode of the GC
+ **/
+GdkSubwindowMode
+_gdk_gc_get_subwindow (GdkGC *gc)
+{
+  g_return_val_if_fail (GDK_IS_GC (gc), GDK_CLIP_BY_CHILDREN);
+
+  return GDK_GC_GET_PRIVATE (gc)->subwindow_mode;
+}
+
 /**
  * gdk_gc_set_subwindow:
  * @gc: a #GdkGC.
@@ -907,6 +952,8 @@ gdk_gc_copy (GdkGC *dst_gc,
 
   dst_priv->fg_pixel = src_priv->fg_pixel;
   dst_priv->bg_pixel = src_priv->bg_pixel;
+  dst_priv->subwindow_mode = src_priv->subwindow_mode;
+  dst_priv->have_clip_mask = src_priv->have_clip_mask;
 }
 
 /**
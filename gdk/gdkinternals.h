@@ -86,7 +86,9 @@ typedef enum {
   GDK_DEBUG_MULTIHEAD	  = 1 <<12,
   GDK_DEBUG_XINERAMA	  = 1 <<13,
   GDK_DEBUG_DRAW	  = 1 <<14,
-  GDK_DEBUG_EVENTLOOP     = 1 <<15
+  GDK_DEBUG_EVENTLOOP     = 1 <<15,
+  GDK_DEBUG_TRACE         = 1 <<16,
+  GDK_DEBUG_ROUND_TRIPS   = 1 <<17
 } GdkDebugFlag;
 
 #ifndef GDK_DISABLE_DEPRECATED
@@ -168,6 +170,8 @@ struct _GdkEventPrivate
   guint      flags;
   GdkScreen *screen;
   gpointer   windowing_data;
+  GList     *motion_history;  /* compressed motion events, oldest first */
+  guint32    trace_id;
 };
 
 extern GdkEventFunc   _gdk_event_func;    /* Callback for events */
@@ -183,12 +187,19 @@ void      _gdk_events_queue  (GdkDisplay *display);
 GdkEvent* _gdk_event_unqueue (GdkDisplay *display);
 
 GList* _gdk_event_queue_find_first  (GdkDisplay *display);
+gboolean _gdk_event_queue_wants_motion (GdkDisplay *display);
 void   _gdk_event_queue_remove_link (GdkDisplay *display,
 				     GList      *node);
 GList*  _gdk_event_queue_prepend    (GdkDisplay *display,
 				     GdkEvent   *event);
 GList*  _gdk_event_queue_append     (GdkDisplay *display,
 				     GdkEvent   *event);
+GList*  _gdk_event_queue_insert_after  (GdkDisplay *display,
+				        GdkEvent   *sibling,
+				        GdkEvent   *event);
+GList*  _gdk_event_queue_insert_before (GdkDisplay *display,
+				        GdkEvent   *sibling,
+				        GdkEvent   *event);
 void _gdk_event_button_generate     (GdkDisplay *display,
 				     GdkEvent   *event);
 
@@ -248,6 +259,26 @@ void       _gdk_window_destroy           (GdkWindow     *window,
 					  gboolean       foreign_destroy);
 void       _gdk_window_clear_update_area (GdkWindow     *window);
 
+/* Client-side child windows share the native window (and thus the
+ * impl object) of their parent; GDK does their event routing.
+ */
+#define GDK_WINDOW_IS_EMULATED(window) \
+  (((GdkWindowObject *)(window))->parent != NULL && \
+   ((GdkWindowObject *)(window))->parent->impl == ((GdkWindowObject *)(window))->impl)
+
+GdkWindow *_gdk_window_get_native        (GdkWindow     *window);
+GdkWindow *_gdk_window_pick_emulated     (GdkWindow     *window,
+					  gint          *x,
+					  gint          *y);
+gboolean   _gdk_window_route_event       (GdkDisplay    *display,
+					  GdkEvent      *event);
+void       _gdk_window_invalidate_for_expose (GdkWindow       *window,
+					      const GdkRegion *region);
+void       _gdk_window_clip_cairo        (GdkWindow     *window,
+					  cairo_t       *cr);
+
+void       _gdk_display_queue_paint      (GdkDisplay    *display);
+
 void       _gdk_screen_close             (GdkScreen     *screen);
 
 const char *_gdk_get_sm_client_id (void);
@@ -263,6 +294,8 @@ GdkPixmap *_gdk_gc_get_tile        (GdkGC *gc);
 GdkBitmap *_gdk_gc_get_stipple     (GdkGC *gc);
 guint32    _gdk_gc_get_fg_pixel    (GdkGC *gc);
 guint32    _gdk_gc_get_bg_pixel    (GdkGC *gc);
+gboolean   _gdk_gc_has_clip_mask   (GdkGC *gc);
+GdkSubwindowMode _gdk_gc_get_subwindow (GdkGC *gc);
 
 /*****************************************
  * Interfaces provided by windowing code *
@@ -215,6 +215,8 @@ get_cairo_context (GdkPangoRenderer *gdk_renderer,
 				  color,
 				  priv->stipple[part],
 				  priv->gc_changed);
+	  if (GDK_IS_WINDOW (priv->drawable))
+	    _gdk_window_clip_cairo (GDK_WINDOW (priv->drawable), priv->cr);
 	}
 
       priv->last_part = part;
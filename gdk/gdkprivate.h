@@ -43,6 +43,54 @@ void gdk_synthesize_window_state (GdkWindow     *window,
                                   GdkWindowState unset_flags,
                                   GdkWindowState set_flags);
 
+/* Event dispatch tracing, enabled with GDK_DEBUG=trace. The records
+ * are kept in a ring buffer that is written to $GDK_TRACE_FILE (or
+ * gdk.trace) at exit, as a GdkTraceHeader followed by the records,
+ * oldest first, and a table of the signal names they refer to.
+ */
+typedef enum
+{
+  GDK_TRACE_EVENT_QUEUED,
+  GDK_TRACE_DISPATCH_BEGIN,
+  GDK_TRACE_DISPATCH_END,
+  GDK_TRACE_SIGNAL_BEGIN,
+  GDK_TRACE_SIGNAL_END,
+  GDK_TRACE_PAINT_BEGIN,
+  GDK_TRACE_PAINT_END
+} GdkTraceRecordType;
+
+#define GDK_TRACE_MAGIC   "GDKTRACE"
+#define GDK_TRACE_VERSION 1
+
+typedef struct _GdkTraceHeader GdkTraceHeader;
+typedef struct _GdkTraceRecord GdkTraceRecord;
+
+struct _GdkTraceHeader
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 n_records;
+  guint32 n_signals;    /* entries of the signal table */
+  guint32 n_dropped;    /* records overwritten in the ring buffer */
+};
+
+struct _GdkTraceRecord
+{
+  guint64 time;         /* microseconds */
+  guint32 type;         /* a GdkTraceRecordType */
+  guint32 id;           /* the event the record belongs to, or 0 */
+  guint32 detail;       /* event type, or signal id for signal records */
+  guint32 reserved;
+};
+
+gboolean gdk_trace_is_enabled    (void);
+guint32  gdk_trace_get_event_id  (const GdkEvent     *event);
+void     gdk_trace_record        (GdkTraceRecordType  type,
+				  guint32             id,
+				  guint32             detail);
+gboolean gdk_trace_dump          (const gchar        *filename,
+				  GError            **error);
+
 /* Tests whether a pair of x,y may cause overflows when converted to Pango
  * units (multiplied by PANGO_SCALE).  We don't allow the entire range, leave
  * some space for additions afterwards, to be safe...
@@ -0,0 +1,192 @@
+/* GDK - The GIMP Drawing Kit
+ * gdktrace.c: Event dispatch tracing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gdk.h"
+#include "gdkinternals.h"
+#include "gdkalias.h"
+
+/* Enough for a few minutes of busy input */
+#define TRACE_BUFFER_SIZE (1 << 16)
+
+static GdkTraceRecord *trace_buffer = NULL;
+static guint           trace_head = 0;
+static guint           trace_n_records = 0;
+static guint           trace_n_dropped = 0;
+
+/**
+ * gdk_trace_is_enabled:
+ * 
+ * Returns whether event dispatch is being traced. Tracing is
+ * turned on with GDK_DEBUG=trace in builds with debugging enabled.
+ * 
+ * Return value: %TRUE if gdk_trace_record() records anything
+ **/
+gboolean
+gdk_trace_is_enabled (void)
+{
+#ifdef G_ENABLE_DEBUG
+  return (_gdk_debug_flags & GDK_DEBUG_TRACE) != 0;
+#else
+  return FALSE;
+#endif
+}
+
+static void
+trace_dump_at_exit (void)
+{
+  const gchar *filename;
+  GError *error = NULL;
+
+  filename = g_getenv ("GDK_TRACE_FILE");
+  if (!filename)
+    filename = "gdk.trace";
+
+  if (!gdk_trace_dump (filename, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+    }
+}
+
+/**
+ * gdk_trace_record:
+ * @type: what happened
+ * @id: the trace id of the event being handled, or 0
+ * @detail: the event type, or for signal records the signal id
+ * 
+ * Adds a timestamped record to the trace buffer, if tracing is
+ * enabled. When the buffer is full, the oldest records are
+ * overwritten.
+ **/
+void
+gdk_trace_record (GdkTraceRecordType type,
+		  guint32            id,
+		  guint32            detail)
+{
+  GdkTraceRecord *record;
+  GTimeVal now;
+
+  if (!gdk_trace_is_enabled ())
+    return;
+
+  if (G_UNLIKELY (!trace_buffer))
+    {
+      trace_buffer = g_new (GdkTraceRecord, TRACE_BUFFER_SIZE);
+      g_atexit (trace_dump_at_exit);
+    }
+
+  g_get_current_time (&now);
+
+  record = &trace_buffer[trace_head];
+  record->time = (guint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+  record->type = type;
+  record->id = id;
+  record->detail = detail;
+  record->reserved = 0;
+
+  trace_head = (trace_head + 1) % TRACE_BUFFER_SIZE;
+  if (trace_n_records < TRACE_BUFFER_SIZE)
+    trace_n_records++;
+  else
+    trace_n_dropped++;
+}
+
+/**
+ * gdk_trace_dump:
+ * @filename: the file to write
+ * @error: return location for an error, or %NULL
+ * 
+ * Writes the records in the trace buffer to @filename, together
+ * with the names of the signals they refer to. The format is
+ * described in gdkprivate.h; perf/tracesummary prints latency
+ * histograms from it.
+ * 
+ * Return value: %TRUE if the file was written
+ **/
+gboolean
+gdk_trace_dump (const gchar  *filename,
+		GError      **error)
+{
+  GdkTraceHeader header;
+  GHashTable *signals;
+  GHashTableIter iter;
+  gpointer key, value;
+  GString *contents;
+  guint start, i;
+  gboolean retval;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, GDK_TRACE_MAGIC, sizeof (header.magic));
+  header.version = GDK_TRACE_VERSION;
+  header.n_records = trace_n_records;
+  header.n_dropped = trace_n_dropped;
+
+  contents = g_string_new (NULL);
+  g_string_append_len (contents, (gchar *) &header, sizeof (header));
+
+  signals = g_hash_table_new (NULL, NULL);
+  start = (trace_head + TRACE_BUFFER_SIZE - trace_n_records) % TRACE_BUFFER_SIZE;
+
+  for (i = 0; i < trace_n_records; i++)
+    {
+      GdkTraceRecord *record = &trace_buffer[(start + i) % TRACE_BUFFER_SIZE];
+
+      g_string_append_len (contents, (gchar *) record, sizeof (GdkTraceRecord));
+
+      if (record->type == GDK_TRACE_SIGNAL_BEGIN)
+	{
+	  const gchar *name = g_signal_name (record->detail);
+
+	  g_hash_table_insert (signals, GUINT_TO_POINTER (record->detail),
+			       (gpointer) (name ? name : ""));
+	}
+    }
+
+  /* The signal table follows the records: for each signal,
+   * its id and the length of its name, then the name.
+   */
+  g_hash_table_iter_init (&iter, signals);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      guint32 entry[2];
+
+      entry[0] = GPOINTER_TO_UINT (key);
+      entry[1] = strlen (value);
+      g_string_append_len (contents, (gchar *) entry, sizeof (entry));
+      g_string_append_len (contents, value, entry[1]);
+    }
+
+  header.n_signals = g_hash_table_size (signals);
+  memcpy (contents->str, &header, sizeof (header));
+
+  retval = g_file_set_contents (filename, contents->str, contents->len, error);
+
+  g_hash_table_destroy (signals);
+  g_string_free (contents, TRUE);
+
+  return retval;
+}
+
+#define __GDK_TRACE_C__
+#include "gdkaliasdef.c"
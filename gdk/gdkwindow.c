@@ -230,8 +230,96 @@ static GdkRegion *_gdk_window_calculate_full_clip_region (GdkWindow *window,
 							  gint *base_x_offset,
 							  gint *base_y_offset);
 
+static GdkWindow *gdk_window_new_emulated        (GdkWindow       *parent,
+						   GdkWindowAttr   *attributes,
+						   gint             attributes_mask);
+static gboolean   gdk_window_should_emulate      (GdkWindow       *parent,
+						   GdkWindowAttr   *attributes,
+						   gint             attributes_mask);
+static gboolean   gdk_window_can_emulate         (GdkWindow       *parent,
+						   gboolean         input_only,
+						   GdkVisual       *visual,
+						   GdkColormap     *colormap);
+static gboolean   gdk_window_has_emulated_children (GdkWindow     *window);
+static gboolean   gdk_window_needs_emulated_clip (GdkWindow       *window);
+static GdkRegion *gdk_window_get_emulated_clip   (GdkWindow       *window,
+						   gboolean         include_inferiors);
+static GdkRegion *gdk_window_get_emulated_visible_region (GdkWindow *window);
+static GdkRegion *gdk_window_get_native_visible_region (GdkWindow  *window,
+							GdkWindow  *native);
+static void       gdk_window_get_impl_offsets    (GdkWindow       *window,
+						   gint            *x_offset,
+						   gint            *y_offset);
+static gboolean   gdk_window_clip_gc             (GdkWindow       *window,
+						   GdkGC           *gc,
+						   GdkRegion      **old_clip_region);
+static void       gdk_window_unclip_gc           (GdkGC           *gc,
+						   GdkRegion       *old_clip_region);
+static void       gdk_window_emulated_clear_area (GdkWindow       *window,
+						   gint             x,
+						   gint             y,
+						   gint             width,
+						   gint             height,
+						   gboolean         send_expose);
+static void       gdk_window_emulated_set_background (GdkWindow   *window,
+						       const GdkColor *color);
+static void       gdk_window_emulated_set_back_pixmap (GdkWindow  *window,
+							GdkPixmap  *pixmap,
+							gboolean    parent_relative);
+static void       gdk_window_emulated_move_region (GdkWindow      *window,
+						   const GdkRegion *region,
+						   gint             dx,
+						   gint             dy);
+static void       gdk_window_add_emulated_events (GdkWindow       *window,
+						   GdkEventMask     event_mask);
+static void       gdk_window_select_native_events (GdkWindow      *native);
+static void       gdk_window_emulated_show       (GdkWindow       *window);
+static void       gdk_window_emulated_hide       (GdkWindow       *window);
+static void       gdk_window_emulated_restack    (GdkWindow       *window);
+static void       gdk_window_emulated_move_resize (GdkWindow      *window,
+						   gboolean         with_move,
+						   gint             x,
+						   gint             y,
+						   gint             width,
+						   gint             height);
+static void       gdk_window_emulated_scroll     (GdkWindow       *window,
+						   gint             dx,
+						   gint             dy);
+static gboolean   gdk_window_emulated_reparent   (GdkWindow       *window,
+						   GdkWindow       *new_parent,
+						   gint             x,
+						   gint             y);
+static void       gdk_window_emulated_set_cursor (GdkWindow       *window,
+						   GdkCursor       *cursor);
+static gboolean   gdk_window_emulated_under_pointer (GdkWindow    *window);
+static void       gdk_window_emulated_recheck_pointer (GdkWindow  *native);
+static void       gdk_window_emulated_break_grab (GdkWindow       *window);
+static void       gdk_window_forget_pointer      (GdkWindow       *window);
+static void       gdk_window_get_offset_in       (GdkWindow       *window,
+						   GdkWindow       *ancestor,
+						   gint            *x,
+						   gint            *y);
+
 static gpointer parent_class = NULL;
 
+typedef struct _GdkWindowEmulated GdkWindowEmulated;
+
+/* Size of a client-side window; the native window's impl
+ * can't hold it. The native window is kept alive for as long
+ * as the impl it shares is.
+ */
+struct _GdkWindowEmulated
+{
+  gint width;
+  gint height;
+  GdkWindow *native;
+};
+
+static GQuark quark_emulated = 0;
+static GQuark quark_emulated_events = 0;
+static GQuark quark_cursor = 0;
+static GQuark quark_pointer_emulation = 0;
+
 GType
 gdk_window_object_get_type (void)
 {
@@ -291,6 +379,11 @@ gdk_window_class_init (GdkWindowObjectClass *klass)
   
   parent_class = g_type_class_peek_parent (klass);
 
+  quark_emulated = g_quark_from_static_string ("gdk-window-emulated");
+  quark_emulated_events = g_quark_from_static_string ("gdk-window-emulated-events");
+  quark_cursor = g_quark_from_static_string ("gdk-window-cursor");
+  quark_pointer_emulation = g_quark_from_static_string ("gdk-pointer-emulation");
+
   object_class->finalize = gdk_window_finalize;
 
   drawable_class->create_gc = gdk_window_create_gc;
@@ -358,6 +451,14 @@ gdk_window_finalize (GObject *object)
  * @attributes. See #GdkWindowAttr and #GdkWindowAttributesType for
  * more details.  Note: to use this on displays other than the default
  * display, @parent must be specified.
+ *
+ * On X11, input-only child windows, and child windows that share
+ * the visual and colormap of their parent, don't get a window in
+ * the X server; GDK handles them itself, in the native window of
+ * their parent. Such a window gets an X window when it is needed,
+ * for instance for its XID or a shape, or when
+ * gdk_window_ensure_native() is called. Set the environment
+ * variable GDK_NATIVE_WINDOWS to create X windows for all windows.
  * 
  * Return value: the new #GdkWindow
  **/
@@ -372,7 +473,16 @@ gdk_window_new (GdkWindow     *parent,
   g_return_val_if_fail (parent == NULL || GDK_IS_WINDOW (parent), NULL);
   g_return_val_if_fail (attributes != NULL, NULL);
 
-  window = _gdk_window_new (parent, attributes, attributes_mask);
+  if (gdk_window_should_emulate (parent, attributes, attributes_mask))
+    window = gdk_window_new_emulated (parent, attributes, attributes_mask);
+  else
+    {
+      /* A native window can't be in a client-side one */
+      if (parent && GDK_WINDOW_IS_EMULATED (parent))
+	gdk_window_ensure_native (parent);
+
+      window = _gdk_window_new (parent, attributes, attributes_mask);
+    }
   g_return_val_if_fail (window != NULL, window);
 
   /* Inherit redirection from parent */
@@ -425,7 +535,23 @@ gdk_window_reparent (GdkWindow *window,
       private->redirect = NULL;
     }
   
-  show = GDK_WINDOW_IMPL_GET_IFACE (private->impl)->reparent (window, new_parent, x, y);
+  /* Client-side windows need a parent they can share the native
+   * window of, and native windows a native parent.
+   */
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      if (!gdk_window_can_emulate (new_parent, private->input_only,
+				   private->input_only ? NULL : gdk_drawable_get_visual (window),
+				   private->input_only ? NULL : gdk_drawable_get_colormap (window)))
+	gdk_window_ensure_native (window);
+    }
+  else if (new_parent && GDK_WINDOW_IS_EMULATED (new_parent))
+    gdk_window_ensure_native (new_parent);
+
+  if (GDK_WINDOW_IS_EMULATED (window))
+    show = gdk_window_emulated_reparent (window, new_parent, x, y);
+  else
+    show = GDK_WINDOW_IMPL_GET_IFACE (private->impl)->reparent (window, new_parent, x, y);
 
   /* Inherit parent redirect if we don't have our own */
   if (private->parent && private->redirect == NULL)
@@ -479,9 +605,13 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
   GdkWindowObject *private;
   GdkWindowObject *temp_private;
   GdkWindow *temp_window;
+  GdkWindow *native;
   GdkScreen *screen;
   GList *children;
   GList *tmp;
+  gboolean emulated;
+  gboolean had_pointer;
+  GdkRegion *exposed;
 
   g_return_if_fail (GDK_IS_WINDOW (window));
 
@@ -525,6 +655,15 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
 	}
       else
 	{
+	  emulated = GDK_WINDOW_IS_EMULATED (window);
+	  native = _gdk_window_get_native (window);
+	  had_pointer = emulated && !recursing && gdk_window_emulated_under_pointer (window);
+
+	  /* What a client-side window showed needs a repaint */
+	  exposed = NULL;
+	  if (emulated && !recursing && !private->input_only)
+	    exposed = gdk_window_get_native_visible_region (window, native);
+
 	  private->state |= GDK_WINDOW_STATE_WITHDRAWN;
 	  
 	  if (private->parent)
@@ -566,13 +705,31 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
 	      g_list_free (children);
 	    }
 	  
-	  _gdk_windowing_window_destroy (window, recursing, foreign_destroy);
+	  gdk_window_forget_pointer (window);
+
+	  /* Client-side windows share the native window of their
+	   * parent, so there is nothing to destroy in the window system.
+	   */
+	  if (emulated)
+	    gdk_window_emulated_break_grab (window);
+	  else
+	    _gdk_windowing_window_destroy (window, recursing, foreign_destroy);
 	  private->parent = NULL;
 	  private->destroyed = TRUE;
 
 	  window_remove_filters (window);
 
-          gdk_drawable_set_colormap (GDK_DRAWABLE (window), NULL);
+	  if (!emulated)
+	    gdk_drawable_set_colormap (GDK_DRAWABLE (window), NULL);
+
+	  if (exposed)
+	    {
+	      _gdk_window_invalidate_for_expose (native, exposed);
+	      gdk_region_destroy (exposed);
+	    }
+
+	  if (had_pointer)
+	    gdk_window_emulated_recheck_pointer (native);
 
 	  /* If we own the redirect, free it */
 	  if (private->redirect && private->redirect->redirected == private)
@@ -1053,6 +1210,7 @@ gdk_window_begin_paint_rect (GdkWindow          *window,
 
 #ifdef GDK_WINDOWING_X11
 #include "x11/gdkx.h"
+#include "x11/gdkprivate-x11.h"
 #endif
 
 /**
@@ -1179,6 +1337,7 @@ gdk_window_end_paint (GdkWindow *window)
   GdkWindowPaint *paint;
   GdkGC *tmp_gc;
   GdkRectangle clip_box;
+  GdkRegion *clip_region;
   gint x_offset, y_offset;
 
   g_return_if_fail (GDK_IS_WINDOW (window));
@@ -1205,11 +1364,21 @@ gdk_window_end_paint (GdkWindow *window)
   private->paint_stack = g_slist_delete_link (private->paint_stack, 
                                               private->paint_stack);
 
+  /* Client-side windows share the native window with their
+   * parent and siblings; only copy what shows of this window.
+   */
+  clip_region = gdk_window_get_emulated_clip (window, FALSE);
+  if (clip_region)
+    {
+      gdk_region_intersect (paint->region, clip_region);
+      gdk_region_destroy (clip_region);
+    }
+
   gdk_region_get_clipbox (paint->region, &clip_box);
 
   tmp_gc = _gdk_drawable_get_scratch_gc (window, FALSE);
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_offsets (window, &x_offset, &y_offset);
+  gdk_window_get_impl_offsets (window, &x_offset, &y_offset);
 
   gdk_gc_set_clip_region (tmp_gc, paint->region);
   gdk_gc_set_clip_origin (tmp_gc, - x_offset, - y_offset);
@@ -1313,7 +1482,28 @@ gdk_window_get_offsets (GdkWindow *window,
       *y_offset = paint->y_offset;
     }
   else
-    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_offsets (window, x_offset, y_offset);
+    gdk_window_get_impl_offsets (window, x_offset, y_offset);
+}
+
+/* Offsets of @window in the window system coordinates of its
+ * impl, which is the one of its native window.
+ */
+static void
+gdk_window_get_impl_offsets (GdkWindow *window,
+			     gint      *x_offset,
+			     gint      *y_offset)
+{
+  GdkWindowObject *private = (GdkWindowObject *)window;
+  gint x, y;
+
+  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_offsets (window, x_offset, y_offset);
+
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      gdk_window_get_offset_in (window, _gdk_window_get_native (window), &x, &y);
+      *x_offset -= x;
+      *y_offset -= y;
+    }
 }
 
 /**
@@ -1378,17 +1568,21 @@ gdk_window_get_internal_paint_info (GdkWindow    *window,
     gint old_clip_y = gc->clip_y_origin;    \
     gint old_ts_x = gc->ts_x_origin;        \
     gint old_ts_y = gc->ts_y_origin;        \
+    GdkRegion *old_clip_region = NULL;      \
+    gboolean clipped = gdk_window_clip_gc (drawable, gc, &old_clip_region); \
     gdk_window_get_offsets (drawable, &x_offset, &y_offset);  \
     if (x_offset != 0 || y_offset != 0)             	      \
       {                                                       \
-        gdk_gc_set_clip_origin (gc, old_clip_x - x_offset,    \
-	  	                old_clip_y - y_offset);       \
+        gdk_gc_set_clip_origin (gc, gc->clip_x_origin - x_offset, \
+	  	                gc->clip_y_origin - y_offset); \
         gdk_gc_set_ts_origin (gc, old_ts_x - x_offset,        \
 	  	              old_ts_y - y_offset);           \
       }
 
 #define RESTORE_GC(gc)                                      \
-    if (x_offset != 0 || y_offset != 0)       		    \
+    if (clipped)                                            \
+      gdk_window_unclip_gc (gc, old_clip_region);           \
+    if (clipped || x_offset != 0 || y_offset != 0)          \
      {                                                      \
        gdk_gc_set_clip_origin (gc, old_clip_x, old_clip_y); \
        gdk_gc_set_ts_origin (gc, old_ts_x, old_ts_y);       \
@@ -1584,9 +1778,9 @@ gdk_window_get_composite_drawable (GdkDrawable *drawable,
   GdkGC *tmp_gc;
   gboolean overlap_buffer;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_offsets (GDK_WINDOW (drawable),
-                                                          composite_x_offset,
-                                                          composite_y_offset);
+  gdk_window_get_impl_offsets (GDK_WINDOW (drawable),
+			       composite_x_offset,
+			       composite_y_offset);
   
   if ((GDK_IS_WINDOW (drawable) && GDK_WINDOW_DESTROYED (drawable))
       || private->paint_stack == NULL)
@@ -1670,8 +1864,19 @@ gdk_window_get_clip_region (GdkDrawable *drawable)
 {
   GdkWindowObject *private = (GdkWindowObject *)drawable;
   GdkRegion *result;
+  GdkRegion *clip_region;
+
+  if (GDK_WINDOW_IS_EMULATED (drawable))
+    result = gdk_window_get_emulated_visible_region (GDK_WINDOW (drawable));
+  else
+    result = gdk_drawable_get_clip_region (private->impl);
 
-  result = gdk_drawable_get_clip_region (private->impl);
+  clip_region = gdk_window_get_emulated_clip (GDK_WINDOW (drawable), FALSE);
+  if (clip_region)
+    {
+      gdk_region_intersect (result, clip_region);
+      gdk_region_destroy (clip_region);
+    }
 
   if (private->paint_stack)
     {
@@ -1698,6 +1903,9 @@ static GdkRegion*
 gdk_window_get_visible_region (GdkDrawable *drawable)
 {
   GdkWindowObject *private = (GdkWindowObject*) drawable;
+
+  if (GDK_WINDOW_IS_EMULATED (drawable))
+    return gdk_window_get_emulated_visible_region (GDK_WINDOW (drawable));
   
   return gdk_drawable_get_visible_region (private->impl);
 }
@@ -2191,8 +2399,13 @@ gdk_window_clear_area (GdkWindow *window,
 
   g_return_if_fail (GDK_IS_WINDOW (window));
 
+  if (GDK_WINDOW_IS_EMULATED (window) && private->input_only)
+    return;
+
   if (private->paint_stack)
     gdk_window_clear_backing_rect (window, x, y, width, height);
+  else if (gdk_window_needs_emulated_clip (window))
+    gdk_window_emulated_clear_area (window, x, y, width, height, FALSE);
   else
     {
       if (private->redirect)
@@ -2231,9 +2444,18 @@ gdk_window_clear_area_e (GdkWindow *window,
 
   g_return_if_fail (GDK_IS_WINDOW (window));
 
+  if (GDK_WINDOW_IS_EMULATED (window) && private->input_only)
+    return;
+
   if (private->paint_stack)
     gdk_window_clear_backing_rect (window, x, y, width, height);
 
+  if (gdk_window_needs_emulated_clip (window))
+    {
+      gdk_window_emulated_clear_area (window, x, y, width, height, TRUE);
+      return;
+    }
+
   if (private->redirect)
     gdk_window_clear_backing_rect_redirect (window, x, y, width, height);
 
@@ -2295,6 +2517,11 @@ gdk_window_draw_pixbuf (GdkDrawable     *drawable,
 
   if (GDK_WINDOW_DESTROYED (drawable))
     return;
+
+  /* Without a GC there would be no way to clip the pixbuf */
+  if (gc == NULL && private->paint_stack == NULL &&
+      gdk_window_needs_emulated_clip (drawable))
+    gc = _gdk_drawable_get_scratch_gc (drawable, FALSE);
   
   if (gc)
     {
@@ -2387,10 +2614,21 @@ gdk_window_real_get_size (GdkDrawable *drawable,
                           gint *width,
                           gint *height)
 {
+  GdkWindowEmulated *emulated;
+
   g_return_if_fail (GDK_IS_WINDOW (drawable));
 
-  gdk_drawable_get_size (GDK_WINDOW_OBJECT (drawable)->impl,
-                         width, height);
+  if (GDK_WINDOW_IS_EMULATED (drawable))
+    {
+      emulated = g_object_get_qdata (G_OBJECT (drawable), quark_emulated);
+      if (width)
+	*width = emulated->width;
+      if (height)
+	*height = emulated->height;
+    }
+  else
+    gdk_drawable_get_size (GDK_WINDOW_OBJECT (drawable)->impl,
+			   width, height);
 }
 
 static GdkVisual*
@@ -2426,6 +2664,11 @@ gdk_window_real_set_colormap (GdkDrawable *drawable,
 
   if (GDK_WINDOW_DESTROYED (drawable))
     return;
+
+  /* A client-side window uses the colormap of its native window */
+  if (GDK_WINDOW_IS_EMULATED (drawable) &&
+      cmap != gdk_drawable_get_colormap (drawable))
+    gdk_window_ensure_native (GDK_WINDOW (drawable));
   
   gdk_drawable_set_colormap (((GdkWindowObject*)drawable)->impl, cmap);
 }
@@ -2463,8 +2706,7 @@ gdk_window_copy_to_image (GdkDrawable     *drawable,
    * we can ignore the paint stack.
    */
   
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_offsets (drawable,
-                                                          &x_offset, &y_offset);
+  gdk_window_get_impl_offsets (drawable, &x_offset, &y_offset);
   
   return gdk_drawable_copy_to_image (private->impl,
 				     image,
@@ -2487,26 +2729,61 @@ gdk_window_ref_cairo_surface (GdkDrawable *drawable)
       surface = paint->surface;
       cairo_surface_reference (surface);
     }
+#ifdef GDK_WINDOWING_X11
+  else if (GDK_WINDOW_IS_EMULATED (drawable))
+    {
+      gint x_offset, y_offset;
+
+      /* The surface of the native window, moved to our origin */
+      gdk_window_get_impl_offsets (GDK_WINDOW (drawable), &x_offset, &y_offset);
+      surface = _gdk_x11_window_create_cairo_surface (GDK_WINDOW (drawable),
+						      x_offset, y_offset);
+    }
+#endif
   else
     surface = _gdk_drawable_ref_cairo_surface (private->impl);
 
   return surface;
 }
 
+/**
+ * _gdk_window_clip_cairo:
+ * @window: a #GdkWindow
+ * @cr: a cairo context drawing to @window
+ *
+ * Clips @cr to the part of @window its client-side children
+ * and siblings leave visible, when GDK can't leave that to the
+ * window system. Paints are clipped when they end.
+ **/
+void
+_gdk_window_clip_cairo (GdkWindow *window,
+			cairo_t   *cr)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkRegion *clip_region;
+
+  if (private->paint_stack)
+    return;
+
+  clip_region = gdk_window_get_emulated_clip (window, FALSE);
+  if (clip_region == NULL)
+    return;
+
+  cairo_save (cr);
+  cairo_identity_matrix (cr);
+  cairo_new_path (cr);
+  gdk_cairo_region (cr, clip_region);
+  cairo_restore (cr);
+  cairo_clip (cr);
+
+  gdk_region_destroy (clip_region);
+}
+
 /* Code for dirty-region queueing
  */
 static GSList *update_windows = NULL;
-static guint update_idle = 0;
 static gboolean debug_updates = FALSE;
 
-static gboolean
-gdk_window_update_idle (gpointer data)
-{
-  gdk_window_process_all_updates ();
-  
-  return FALSE;
-}
-
 static gboolean
 gdk_window_is_toplevel_frozen (GdkWindow *window)
 {
@@ -2525,11 +2802,9 @@ gdk_window_schedule_update (GdkWindow *window)
        gdk_window_is_toplevel_frozen (window)))
     return;
 
-  if (!update_idle)
-    {
-      update_idle = gdk_threads_add_idle_full (GDK_PRIORITY_REDRAW,
-				     gdk_window_update_idle, NULL, NULL);
-    }
+  /* updates are processed in the next frame of the display */
+  if (window)
+    _gdk_display_queue_paint (gdk_drawable_get_display (window));
 }
 
 static void
@@ -2553,6 +2828,7 @@ gdk_window_process_updates_internal (GdkWindow *window)
 	  GdkRegion *expose_region;
 	  GdkRegion *window_region;
           gint width, height;
+	  gboolean paint_background;
 
           if (debug_updates)
             {
@@ -2561,7 +2837,21 @@ gdk_window_process_updates_internal (GdkWindow *window)
               g_usleep (70000);
             }
           
-	  save_region = _gdk_windowing_window_queue_antiexpose (window, update_area);
+	  if (GDK_WINDOW_IS_EMULATED (window))
+	    {
+	      GdkWindow *native = _gdk_window_get_native (window);
+	      GdkRegion *native_area;
+	      gint x, y;
+
+	      /* Exposes come in on the native window */
+	      native_area = gdk_region_copy (update_area);
+	      gdk_window_get_offset_in (window, native, &x, &y);
+	      gdk_region_offset (native_area, x, y);
+	      if (!_gdk_windowing_window_queue_antiexpose (native, native_area))
+		gdk_region_destroy (native_area);
+	    }
+	  else
+	    save_region = _gdk_windowing_window_queue_antiexpose (window, update_area);
 
 	  if (save_region)
 	    expose_region = gdk_region_copy (update_area);
@@ -2580,6 +2870,20 @@ gdk_window_process_updates_internal (GdkWindow *window)
 				window_region);
 	  gdk_region_destroy (window_region);
 	  
+	  /* The window system doesn't clear client-side windows to
+	   * their background, so do it while the expose is handled.
+	   */
+	  paint_background = (GDK_WINDOW_IS_EMULATED (window) &&
+			      !private->input_only &&
+			      private->bg_pixmap != GDK_NO_BG &&
+			      !gdk_region_empty (expose_region));
+
+	  if (paint_background)
+	    {
+	      g_object_ref (window);
+	      gdk_window_begin_paint_region (window, expose_region);
+	    }
+
 	  if (!gdk_region_empty (expose_region) &&
 	      (private->event_mask & GDK_EXPOSURE_MASK))
 	    {
@@ -2597,6 +2901,12 @@ gdk_window_process_updates_internal (GdkWindow *window)
 	      g_object_unref (window);
 	    }
 
+	  if (paint_background)
+	    {
+	      gdk_window_end_paint (window);
+	      g_object_unref (window);
+	    }
+
 	  if (expose_region != update_area)
 	    gdk_region_destroy (expose_region);
 	}
@@ -2640,11 +2950,9 @@ gdk_window_process_all_updates (void)
   GSList *old_update_windows = update_windows;
   GSList *tmp_list = update_windows;
 
-  if (update_idle)
-    g_source_remove (update_idle);
-  
   update_windows = NULL;
-  update_idle = 0;
+
+  gdk_trace_record (GDK_TRACE_PAINT_BEGIN, 0, 0);
 
   g_slist_foreach (old_update_windows, (GFunc)g_object_ref, NULL);
   
@@ -2668,6 +2976,8 @@ gdk_window_process_all_updates (void)
   g_slist_free (old_update_windows);
 
   flush_all_displays ();
+
+  gdk_trace_record (GDK_TRACE_PAINT_END, 0, 0);
 }
 
 /**
@@ -2962,6 +3272,29 @@ gdk_window_invalidate_region (GdkWindow       *window,
 				       NULL);
 }
 
+static gboolean
+emulated_predicate (GdkWindow *window,
+		    gpointer   user_data)
+{
+  return GDK_WINDOW_IS_EMULATED (window);
+}
+
+/**
+ * _gdk_window_invalidate_for_expose:
+ * @window: a native #GdkWindow
+ * @region: the exposed region of @window
+ *
+ * Invalidates @region of @window, like the window system exposes
+ * it, for @window and the client-side windows drawing to it.
+ **/
+void
+_gdk_window_invalidate_for_expose (GdkWindow       *window,
+				   const GdkRegion *region)
+{
+  gdk_window_invalidate_maybe_recurse (window, region,
+				       emulated_predicate, NULL);
+}
+
 /**
  * gdk_window_get_update_area:
  * @window: a #GdkWindow
@@ -3294,6 +3627,7 @@ gdk_window_get_pointer (GdkWindow	  *window,
   GdkDisplay *display;
   gint tmp_x, tmp_y;
   GdkModifierType tmp_mask;
+  GdkWindow *native;
   GdkWindow *child;
   
   g_return_val_if_fail (window == NULL || GDK_IS_WINDOW (window), NULL);
@@ -3314,7 +3648,39 @@ gdk_window_get_pointer (GdkWindow	  *window,
 			   "is not multihead safe"));
     }
 
-  child = display->pointer_hooks->window_get_pointer (display, window, &tmp_x, &tmp_y, &tmp_mask);
+  native = _gdk_window_get_native (window);
+  child = display->pointer_hooks->window_get_pointer (display, native, &tmp_x, &tmp_y, &tmp_mask);
+
+  if (native != window || gdk_window_has_emulated_children (native))
+    {
+      gint dx, dy;
+      GList *l;
+
+      gdk_window_get_offset_in (window, native, &dx, &dy);
+      tmp_x -= dx;
+      tmp_y -= dy;
+
+      /* A native child of the native window isn't a child of
+       * a client-side window; if the pointer isn't in one, it
+       * may be in a client-side child.
+       */
+      if (native != window)
+	child = NULL;
+
+      for (l = GDK_WINDOW_OBJECT (window)->children; l && !child; l = l->next)
+	{
+	  GdkWindowObject *tmp = l->data;
+	  gint width, height;
+
+	  if (!GDK_WINDOW_IS_EMULATED (tmp) || !GDK_WINDOW_IS_MAPPED (tmp))
+	    continue;
+
+	  gdk_drawable_get_size (GDK_DRAWABLE (tmp), &width, &height);
+	  if (tmp_x >= tmp->x && tmp_x < tmp->x + width &&
+	      tmp_y >= tmp->y && tmp_y < tmp->y + height)
+	    child = (GdkWindow *) tmp;
+	}
+    }
 
   if (x)
     *x = tmp_x;
@@ -3405,7 +3771,10 @@ gdk_window_show_unraised (GdkWindow *window)
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->show (window, FALSE);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_show (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->show (window, FALSE);
 }
 
 static inline void
@@ -3447,7 +3816,10 @@ gdk_window_raise (GdkWindow *window)
   /* Keep children in (reverse) stacking order */
   gdk_window_raise_internal (window);
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->raise (window);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_restack (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->raise (window);
 }
 
 static void
@@ -3492,7 +3864,10 @@ gdk_window_lower (GdkWindow *window)
   /* Keep children in (reverse) stacking order */
   gdk_window_lower_internal (window);
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->lower (window);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_restack (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->lower (window);
 }
 
 /**
@@ -3523,7 +3898,10 @@ gdk_window_show (GdkWindow *window)
   /* Keep children in (reverse) stacking order */
   gdk_window_raise_internal (window);
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->show (window, TRUE);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_show (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->show (window, TRUE);
 }
 
 /**
@@ -3546,7 +3924,10 @@ gdk_window_hide (GdkWindow *window)
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->hide (window);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_hide (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->hide (window);
 }
 
 /**
@@ -3568,7 +3949,10 @@ gdk_window_withdraw (GdkWindow *window)
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->withdraw (window);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_hide (window);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->withdraw (window);
 }
 
 /**
@@ -3593,7 +3977,18 @@ gdk_window_set_events (GdkWindow       *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_events (window, event_mask);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      private->event_mask = event_mask;
+      gdk_window_add_emulated_events (window, event_mask);
+    }
+  else if (gdk_window_has_emulated_children (window))
+    {
+      private->event_mask = event_mask;
+      gdk_window_select_native_events (window);
+    }
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_events (window, event_mask);
 }
 
 /**
@@ -3615,6 +4010,12 @@ gdk_window_get_events (GdkWindow *window)
   if (private->destroyed)
     return 0;
 
+  /* The native window also selects the events of its client-side
+   * children, so the window system doesn't have the right mask.
+   */
+  if (GDK_WINDOW_IS_EMULATED (window) || gdk_window_has_emulated_children (window))
+    return private->event_mask;
+
   return GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_events (window);
 }
 
@@ -3646,7 +4047,10 @@ gdk_window_move (GdkWindow *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, TRUE, x, y, -1, -1);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_move_resize (window, TRUE, x, y, -1, -1);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, TRUE, x, y, -1, -1);
 }
 
 /**
@@ -3677,7 +4081,10 @@ gdk_window_resize (GdkWindow *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, FALSE, 0, 0, width, height);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_move_resize (window, FALSE, 0, 0, width, height);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, FALSE, 0, 0, width, height);
 }
 
 
@@ -3709,7 +4116,10 @@ gdk_window_move_resize (GdkWindow *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, TRUE, x, y, width, height);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_move_resize (window, TRUE, x, y, width, height);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_resize (window, TRUE, x, y, width, height);
 }
 
 
@@ -3746,7 +4156,16 @@ gdk_window_scroll (GdkWindow *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->scroll (window, dx, dy);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_scroll (window, dx, dy);
+  else
+    {
+      GDK_WINDOW_IMPL_GET_IFACE (private->impl)->scroll (window, dx, dy);
+
+      /* The client-side children moved with the contents */
+      if (gdk_window_has_emulated_children (window))
+	gdk_window_emulated_recheck_pointer (window);
+    }
 }
 
 /**
@@ -3781,7 +4200,10 @@ gdk_window_move_region (GdkWindow       *window,
   if (private->destroyed)
     return;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_region (window, region, dx, dy);
+  if (gdk_window_needs_emulated_clip (window))
+    gdk_window_emulated_move_region (window, region, dx, dy);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->move_region (window, region, dx, dy);
 }
 
 /**
@@ -3809,7 +4231,10 @@ gdk_window_set_background (GdkWindow      *window,
 
   private = (GdkWindowObject *) window;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_background (window, color);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_set_background (window, color);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_background (window, color);
 }
 
 /**
@@ -3851,7 +4276,10 @@ gdk_window_set_back_pixmap (GdkWindow *window,
 
   private = (GdkWindowObject *) window;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_back_pixmap (window, pixmap, parent_relative);
+  if (GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_emulated_set_back_pixmap (window, pixmap, parent_relative);
+  else
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_back_pixmap (window, pixmap, parent_relative);
 }
 
 /**
@@ -3876,7 +4304,11 @@ gdk_window_set_cursor (GdkWindow *window,
 
   private = (GdkWindowObject *) window;
 
-  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_cursor (window, cursor);
+  g_object_set_qdata_full (G_OBJECT (window), quark_cursor,
+			   cursor ? gdk_cursor_ref (cursor) : NULL,
+			   (GDestroyNotify) gdk_cursor_unref);
+
+  gdk_window_emulated_set_cursor (window, cursor);
 }
 
 /**
@@ -3933,7 +4365,20 @@ gdk_window_get_geometry (GdkWindow *window,
 
   private = (GdkWindowObject *) window;
 
-  if (!GDK_WINDOW_DESTROYED (window))
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      if (x)
+	*x = private->x;
+      if (y)
+	*y = private->y;
+      gdk_drawable_get_size (GDK_DRAWABLE (window), width, height);
+      if (depth)
+	*depth = private->depth;
+    }
+  else
     {
       GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_geometry (window, x, y,
 							       width, height,
@@ -3965,6 +4410,22 @@ gdk_window_get_origin (GdkWindow *window,
 
   private = (GdkWindowObject *) window;
 
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      GdkWindow *native = _gdk_window_get_native (window);
+      gint dx, dy;
+      gint retval;
+
+      retval = gdk_window_get_origin (native, x, y);
+      gdk_window_get_offset_in (window, native, &dx, &dy);
+      if (x)
+	*x += dx;
+      if (y)
+	*y += dy;
+
+      return retval;
+    }
+
   return GDK_WINDOW_IMPL_GET_IFACE (private->impl)->get_origin (window, x, y);
 }
 
@@ -4113,6 +4574,15 @@ gdk_window_set_static_gravities (GdkWindow *window,
 
   private = (GdkWindowObject *) window;
 
+  /* Client-side windows are moved by GDK, so they never
+   * need the window system to keep them in place.
+   */
+  if (GDK_WINDOW_IS_EMULATED (window))
+    {
+      private->guffaw_gravity = use_static;
+      return TRUE;
+    }
+
   return GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_static_gravities (window, use_static);
 }
 
@@ -4170,11 +4640,69 @@ gdk_window_set_composited (GdkWindow *window,
       return;
     }
 
+  /* Redirection works on window system windows */
+  if (composited && GDK_WINDOW_IS_EMULATED (window))
+    gdk_window_ensure_native (window);
+
   _gdk_windowing_window_set_composited (window, composited);
 
   private->composited = composited;
 }
 
+static GQuark quark_motion_compression = 0;
+
+/**
+ * gdk_window_set_motion_compression:
+ * @window: a #GdkWindow
+ * @compress: %TRUE to compress motion events for @window
+ *
+ * Sets whether motion events for @window are compressed. With
+ * high-rate pointing devices, many more motion events can arrive
+ * than an application can draw frames. If compression is enabled,
+ * motion events queued for @window one after the other, with the
+ * same device and modifier state, are delivered as a single event
+ * for the last position; the earlier events are available from
+ * gdk_event_get_motion_history().
+ *
+ * Motion hints and the order with respect to other events are not
+ * affected.
+ *
+ * Since: 2.16
+ */
+void
+gdk_window_set_motion_compression (GdkWindow *window,
+				   gboolean   compress)
+{
+  g_return_if_fail (GDK_IS_WINDOW (window));
+
+  if (!quark_motion_compression)
+    quark_motion_compression = g_quark_from_static_string ("gdk-motion-compression");
+
+  g_object_set_qdata (G_OBJECT (window), quark_motion_compression,
+		      GINT_TO_POINTER (compress != FALSE));
+}
+
+/**
+ * gdk_window_get_motion_compression:
+ * @window: a #GdkWindow
+ *
+ * Returns whether motion events for @window are compressed.
+ * See gdk_window_set_motion_compression().
+ *
+ * Return value: %TRUE if motion events are compressed
+ *
+ * Since: 2.16
+ */
+gboolean
+gdk_window_get_motion_compression (GdkWindow *window)
+{
+  g_return_val_if_fail (GDK_IS_WINDOW (window), FALSE);
+
+  if (!quark_motion_compression)
+    return FALSE;
+
+  return GPOINTER_TO_INT (g_object_get_qdata (G_OBJECT (window), quark_motion_compression));
+}
 
 static void
 remove_redirect_from_children (GdkWindowObject   *private,
@@ -4526,5 +5054,1829 @@ gdk_window_redirect_free (GdkWindowRedirect *redirect)
   g_free (redirect);
 }
 
+/* Client-side windows
+ *
+ * Child windows don't need a window in the window system as long
+ * as they are input-only, or draw with the visual and colormap of
+ * their parent. Such a window shares the impl object of its parent,
+ * and thus its native window, and the native window selects the
+ * pointer events of all its client-side children. GDK then looks
+ * up the client-side window the pointer is in, sends the event
+ * there if it selected it (or propagates it up the hierarchy,
+ * like the window system does), and synthesizes crossing events
+ * as the pointer moves between client-side windows.
+ *
+ * Client-side windows that draw do so to the native window, with
+ * their offset in it, clipped to what their client-side ancestors
+ * and siblings leave of them; native windows are clipped around
+ * their client-side children the same way. Exposes of the native
+ * window go to the client-side windows in the exposed area, and
+ * GDK exposes and moves their contents itself as they are mapped,
+ * moved or scrolled. A window gets a native window when it needs
+ * one, see gdk_window_ensure_native().
+ */
+
+#define GDK_EMULATED_EVENT_MASK (GDK_POINTER_MOTION_MASK | \
+				 GDK_BUTTON_MOTION_MASK |  \
+				 GDK_BUTTON1_MOTION_MASK | \
+				 GDK_BUTTON2_MOTION_MASK | \
+				 GDK_BUTTON3_MOTION_MASK | \
+				 GDK_BUTTON_PRESS_MASK |   \
+				 GDK_BUTTON_RELEASE_MASK | \
+				 GDK_ENTER_NOTIFY_MASK |   \
+				 GDK_LEAVE_NOTIFY_MASK |   \
+				 GDK_SCROLL_MASK |         \
+				 GDK_EXPOSURE_MASK)
+
+#define GDK_ANY_BUTTON_MASK (GDK_BUTTON1_MASK | \
+                             GDK_BUTTON2_MASK | \
+                             GDK_BUTTON3_MASK | \
+                             GDK_BUTTON4_MASK | \
+                             GDK_BUTTON5_MASK)
+
+typedef struct _GdkPointerEmulation GdkPointerEmulation;
+typedef struct _GdkCrossingData     GdkCrossingData;
+
+/* What GDK knows about the pointer on a display, from the last
+ * pointer event on a native window with client-side children.
+ */
+struct _GdkPointerEmulation
+{
+  GdkWindow *native_window;	/* native window containing the pointer */
+  gdouble native_x;
+  gdouble native_y;
+  gdouble x_root;
+  gdouble y_root;
+  guint32 time;
+  GdkModifierType state;
+
+  GdkWindow *pointer_window;	/* innermost window containing the pointer */
+  GdkWindow *button_window;	/* window of the implicit grab we routed */
+  GdkWindow *cursor_window;	/* window whose cursor the native window shows */
+};
+
+/* Crossing events synthesized for one pointer move */
+struct _GdkCrossingData
+{
+  GdkPointerEmulation *pointer;
+  GdkWindow *native;
+  GdkWindow *only_window;	/* the grab window, during a grab */
+  GdkCrossingMode mode;
+  gboolean include_native;
+  GList *events;
+};
+
+/* Whether a window can share the native window of @parent */
+static gboolean
+gdk_window_can_emulate (GdkWindow   *parent,
+			gboolean     input_only,
+			GdkVisual   *visual,
+			GdkColormap *colormap)
+{
+  GdkWindowObject *parent_private = (GdkWindowObject *) parent;
+
+  if (parent == NULL ||
+      GDK_WINDOW_DESTROYED (parent) ||
+      parent_private->window_type == GDK_WINDOW_ROOT ||
+      parent_private->window_type == GDK_WINDOW_FOREIGN)
+    return FALSE;
+
+  if (input_only)
+    return TRUE;
+
+  /* Drawing goes to the native window, which has to match */
+  return (!parent_private->input_only &&
+	  visual == gdk_drawable_get_visual (parent) &&
+	  colormap == gdk_drawable_get_colormap (parent));
+}
+
+static gboolean
+gdk_window_should_emulate (GdkWindow     *parent,
+			   GdkWindowAttr *attributes,
+			   gint           attributes_mask)
+{
+#ifdef GDK_WINDOWING_X11
+  static gint native_windows = -1;
+  GdkScreen *screen;
+  GdkVisual *visual = NULL;
+  GdkColormap *colormap = NULL;
+  gboolean input_only;
+
+  if (native_windows < 0)
+    native_windows = g_getenv ("GDK_NATIVE_WINDOWS") != NULL;
+
+  if (native_windows || parent == NULL ||
+      attributes->window_type != GDK_WINDOW_CHILD)
+    return FALSE;
+
+  input_only = attributes->wclass == GDK_INPUT_ONLY;
+  if (!input_only)
+    {
+      /* The defaults of _gdk_window_new() */
+      screen = gdk_drawable_get_screen (parent);
+
+      if (attributes_mask & GDK_WA_VISUAL)
+	visual = attributes->visual;
+      else
+	visual = gdk_screen_get_system_visual (screen);
+
+      if (attributes_mask & GDK_WA_COLORMAP)
+	colormap = attributes->colormap;
+      else if (visual == gdk_screen_get_system_visual (screen))
+	colormap = gdk_screen_get_system_colormap (screen);
+      else
+	return FALSE;
+    }
+
+  return gdk_window_can_emulate (parent, input_only, visual, colormap);
+#else
+  return FALSE;
+#endif
+}
+
+static void
+gdk_window_emulated_free (GdkWindowEmulated *emulated)
+{
+  g_object_unref (emulated->native);
+  g_slice_free (GdkWindowEmulated, emulated);
+}
+
+static GdkWindow *
+gdk_window_new_emulated (GdkWindow     *parent,
+			 GdkWindowAttr *attributes,
+			 gint           attributes_mask)
+{
+  GdkWindowObject *parent_private = (GdkWindowObject *) parent;
+  GdkWindowObject *private;
+  GdkWindowEmulated *emulated;
+  GdkWindow *window;
+
+  window = g_object_new (GDK_TYPE_WINDOW, NULL);
+  private = (GdkWindowObject *) window;
+
+  private->impl = g_object_ref (parent_private->impl);
+  private->parent = parent_private;
+  private->x = (attributes_mask & GDK_WA_X) ? attributes->x : 0;
+  private->y = (attributes_mask & GDK_WA_Y) ? attributes->y : 0;
+  private->window_type = GDK_WINDOW_CHILD;
+  private->input_only = attributes->wclass == GDK_INPUT_ONLY;
+  private->state = GDK_WINDOW_STATE_WITHDRAWN;
+  private->accept_focus = TRUE;
+  private->focus_on_map = TRUE;
+  private->event_mask = attributes->event_mask;
+
+  if (private->input_only)
+    private->depth = 0;
+  else
+    {
+      /* Black, like a new X window */
+      private->depth = parent_private->depth;
+      private->bg_color.red = private->bg_color.green = private->bg_color.blue = 0;
+      gdk_rgb_find_color (gdk_drawable_get_colormap (parent), &private->bg_color);
+      private->bg_pixmap = NULL;
+    }
+
+  emulated = g_slice_new (GdkWindowEmulated);
+  emulated->width = MAX (attributes->width, 1);
+  emulated->height = MAX (attributes->height, 1);
+  emulated->native = g_object_ref (_gdk_window_get_native (parent));
+  g_object_set_qdata_full (G_OBJECT (window), quark_emulated, emulated,
+			   (GDestroyNotify) gdk_window_emulated_free);
+
+  parent_private->children = g_list_prepend (parent_private->children, window);
+
+  if (attributes_mask & GDK_WA_CURSOR)
+    gdk_window_set_cursor (window, attributes->cursor);
+
+  gdk_window_add_emulated_events (window, private->event_mask);
+
+  return window;
+}
+
+/**
+ * _gdk_window_get_native:
+ * @window: a #GdkWindow
+ *
+ * Finds the window that has a window in the window system
+ * for @window: @window itself, unless it is a client-side window.
+ *
+ * Return value: the native window of @window
+ **/
+GdkWindow *
+_gdk_window_get_native (GdkWindow *window)
+{
+  while (GDK_WINDOW_IS_EMULATED (window))
+    window = (GdkWindow *) ((GdkWindowObject *) window)->parent;
+
+  return window;
+}
+
+static gboolean
+gdk_window_has_emulated_children (GdkWindow *window)
+{
+  return g_object_get_qdata (G_OBJECT (window), quark_emulated_events) != NULL;
+}
+
+/* Offset of @window in @ancestor, or in its toplevel if
+ * @ancestor is %NULL.
+ */
+static void
+gdk_window_get_offset_in (GdkWindow *window,
+			  GdkWindow *ancestor,
+			  gint      *x,
+			  gint      *y)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+
+  *x = 0;
+  *y = 0;
+
+  while (private && (GdkWindow *) private != ancestor &&
+	 private->window_type == GDK_WINDOW_CHILD)
+    {
+      *x += private->x;
+      *y += private->y;
+      private = private->parent;
+    }
+}
+
+/* Whether @window has mapped client-side children that draw */
+static gboolean
+gdk_window_has_emulated_output_children (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GList *l;
+
+  for (l = private->children; l; l = l->next)
+    {
+      GdkWindowObject *child = l->data;
+
+      if (GDK_WINDOW_IS_MAPPED (child) && !child->input_only &&
+	  GDK_WINDOW_IS_EMULATED (child))
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Whether drawing to @window needs clipping the window system
+ * can't do: @window shares its native window with its parent,
+ * or client-side children draw over it.
+ */
+static gboolean
+gdk_window_needs_emulated_clip (GdkWindow *window)
+{
+  return (GDK_WINDOW_IS_EMULATED (window) ||
+	  gdk_window_has_emulated_output_children (window));
+}
+
+/* Subtracts the mapped client-side windows that draw from
+ * @children, up to @stop, from @region; (@x, @y) is the offset
+ * of their parent in @region.
+ */
+static void
+gdk_window_subtract_emulated_children (GdkRegion *region,
+				       GList     *children,
+				       gpointer   stop,
+				       gint       x,
+				       gint       y)
+{
+  GdkRectangle rect;
+  GdkRegion *child_region;
+  GList *l;
+
+  for (l = children; l && l->data != stop; l = l->next)
+    {
+      GdkWindowObject *child = l->data;
+
+      if (!GDK_WINDOW_IS_MAPPED (child) || child->input_only ||
+	  !GDK_WINDOW_IS_EMULATED (child))
+	continue;
+
+      rect.x = x + child->x;
+      rect.y = y + child->y;
+      gdk_drawable_get_size (GDK_DRAWABLE (child), &rect.width, &rect.height);
+
+      child_region = gdk_region_rectangle (&rect);
+      gdk_region_subtract (region, child_region);
+      gdk_region_destroy (child_region);
+    }
+}
+
+/* The part of @window that drawing to it may touch, in window
+ * coordinates, as far as the window system doesn't take care
+ * of it: the area its client-side ancestors and the client-side
+ * siblings above them leave, minus its client-side children
+ * unless @include_inferiors. Returns %NULL if the window system
+ * does all the clipping.
+ */
+static GdkRegion *
+gdk_window_get_emulated_clip (GdkWindow *window,
+			      gboolean   include_inferiors)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindowObject *parent;
+  GdkRectangle rect;
+  GdkRegion *clip, *tmp;
+  gint x = 0, y = 0;
+
+  if (!gdk_window_needs_emulated_clip (window))
+    return NULL;
+
+  rect.x = 0;
+  rect.y = 0;
+  gdk_drawable_get_size (GDK_DRAWABLE (window), &rect.width, &rect.height);
+  clip = gdk_region_rectangle (&rect);
+
+  if (!include_inferiors)
+    gdk_window_subtract_emulated_children (clip, private->children, NULL, 0, 0);
+
+  while (GDK_WINDOW_IS_EMULATED (private))
+    {
+      if (!GDK_WINDOW_IS_MAPPED (private))
+	{
+	  gdk_region_destroy (clip);
+	  return gdk_region_new ();
+	}
+
+      /* (x, y) becomes the offset of the parent */
+      parent = private->parent;
+      x -= private->x;
+      y -= private->y;
+
+      rect.x = x;
+      rect.y = y;
+      gdk_drawable_get_size (GDK_DRAWABLE (parent), &rect.width, &rect.height);
+      tmp = gdk_region_rectangle (&rect);
+      gdk_region_intersect (clip, tmp);
+      gdk_region_destroy (tmp);
+
+      gdk_window_subtract_emulated_children (clip, parent->children, private, x, y);
+
+      private = parent;
+    }
+
+  return clip;
+}
+
+/* What the window system would report as visible of a
+ * client-side window: the visible part of the native window
+ * that is left to @window, children included.
+ */
+static GdkRegion *
+gdk_window_get_emulated_visible_region (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *native;
+  GdkRegion *region, *clip;
+  gint x, y;
+
+  if (private->input_only || !gdk_window_is_viewable (window))
+    return gdk_region_new ();
+
+  native = _gdk_window_get_native (window);
+  region = gdk_drawable_get_visible_region (GDK_DRAWABLE (native));
+  gdk_window_get_offset_in (window, native, &x, &y);
+  gdk_region_offset (region, -x, -y);
+
+  clip = gdk_window_get_emulated_clip (window, TRUE);
+  gdk_region_intersect (region, clip);
+  gdk_region_destroy (clip);
+
+  return region;
+}
+
+/* The visible region of @window, in the coordinates of @native */
+static GdkRegion *
+gdk_window_get_native_visible_region (GdkWindow *window,
+				      GdkWindow *native)
+{
+  GdkRegion *region;
+  gint x, y;
+
+  region = gdk_drawable_get_visible_region (GDK_DRAWABLE (window));
+  gdk_window_get_offset_in (window, native, &x, &y);
+  gdk_region_offset (region, x, y);
+
+  return region;
+}
+
+/* Copies the contents of @native to @region from (@dx, @dy)
+ * away; what can't be copied gets exposed.
+ */
+static void
+gdk_window_copy_native_region (GdkWindow       *native,
+			       const GdkRegion *region,
+			       gint             dx,
+			       gint             dy)
+{
+#ifdef GDK_WINDOWING_X11
+  _gdk_x11_window_copy_region (native, region, dx, dy);
+#endif
+}
+
+/* Clips @gc to what drawing to @window may touch, if the window
+ * system can't. The old clip region of @gc (or %NULL) is returned
+ * in @old_clip_region; the clip origin is reset to 0, 0.
+ */
+static gboolean
+gdk_window_clip_gc (GdkWindow  *window,
+		    GdkGC      *gc,
+		    GdkRegion **old_clip_region)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkRegion *clip, *old_clip;
+
+  /* Paints are clipped when they end; clip masks can't be
+   * combined with a region.
+   */
+  if (GDK_WINDOW_DESTROYED (window) || private->paint_stack ||
+      _gdk_gc_has_clip_mask (gc))
+    return FALSE;
+
+  clip = gdk_window_get_emulated_clip (window,
+				       _gdk_gc_get_subwindow (gc) == GDK_INCLUDE_INFERIORS);
+  if (clip == NULL)
+    return FALSE;
+
+  old_clip = _gdk_gc_get_clip_region (gc);
+  if (old_clip)
+    {
+      old_clip = gdk_region_copy (old_clip);
+      gdk_region_offset (old_clip, gc->clip_x_origin, gc->clip_y_origin);
+      gdk_region_intersect (clip, old_clip);
+      gdk_region_offset (old_clip, -gc->clip_x_origin, -gc->clip_y_origin);
+    }
+
+  *old_clip_region = old_clip;
+  gdk_gc_set_clip_region (gc, clip);
+  gdk_region_destroy (clip);
+
+  return TRUE;
+}
+
+static void
+gdk_window_unclip_gc (GdkGC     *gc,
+		      GdkRegion *old_clip_region)
+{
+  gdk_gc_set_clip_region (gc, old_clip_region);
+  if (old_clip_region)
+    gdk_region_destroy (old_clip_region);
+}
+
+static void
+gdk_window_select_native_events (GdkWindow *native)
+{
+  GdkWindowObject *private = (GdkWindowObject *) native;
+  GdkEventMask own_mask = private->event_mask;
+  GdkEventMask event_mask;
+
+  event_mask = own_mask | GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (native),
+								quark_emulated_events));
+
+  /* Client-side windows need every motion event to track the pointer */
+  if (event_mask & GDK_POINTER_MOTION_MASK)
+    event_mask &= ~GDK_POINTER_MOTION_HINT_MASK;
+
+  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_events (native, event_mask);
+
+  /* The backend stores the mask it selected */
+  private->event_mask = own_mask;
+}
+
+/* Makes the native window of @window select what it needs to
+ * route the events in @event_mask to @window. The set only grows.
+ */
+static void
+gdk_window_add_emulated_events (GdkWindow    *window,
+				GdkEventMask  event_mask)
+{
+  GdkWindow *native = _gdk_window_get_native (window);
+  GdkEventMask old_mask, new_mask;
+
+  old_mask = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (native),
+						   quark_emulated_events));
+
+  new_mask = old_mask | event_mask | GDK_ENTER_NOTIFY_MASK | GDK_LEAVE_NOTIFY_MASK;
+  if (!((GdkWindowObject *) window)->input_only)
+    new_mask |= GDK_EXPOSURE_MASK;
+  if (event_mask & (GDK_ENTER_NOTIFY_MASK | GDK_LEAVE_NOTIFY_MASK))
+    new_mask |= GDK_POINTER_MOTION_MASK;
+  if (event_mask & GDK_BUTTON_PRESS_MASK)
+    new_mask |= GDK_BUTTON_RELEASE_MASK;
+  new_mask &= GDK_EMULATED_EVENT_MASK;
+
+  if (new_mask == old_mask)
+    return;
+
+  g_object_set_qdata (G_OBJECT (native), quark_emulated_events,
+		      GUINT_TO_POINTER (new_mask));
+  gdk_window_select_native_events (native);
+}
+
+/* Finds the innermost window at (@x, @y) of @native: a mapped
+ * client-side descendant or @native itself. A native child stops
+ * the search, since it is stacked above all client-side windows.
+ * Returns %NULL if the point isn't in @native.
+ */
+static GdkWindow *
+gdk_window_pick (GdkWindow *native,
+		 gdouble    x,
+		 gdouble    y)
+{
+  GdkWindowObject *private = (GdkWindowObject *) native;
+  gint width, height;
+  GList *l;
+
+  gdk_drawable_get_size (GDK_DRAWABLE (native), &width, &height);
+  if (x < 0 || y < 0 || x >= width || y >= height)
+    return NULL;
+
+  l = private->children;
+  while (l)
+    {
+      GdkWindowObject *child = l->data;
+
+      l = l->next;
+
+      if (!GDK_WINDOW_IS_MAPPED (child))
+	continue;
+
+      gdk_drawable_get_size (GDK_DRAWABLE (child), &width, &height);
+      if (x < child->x || y < child->y ||
+	  x >= child->x + width || y >= child->y + height)
+	continue;
+
+      if (!GDK_WINDOW_IS_EMULATED (child))
+	break;
+
+      x -= child->x;
+      y -= child->y;
+      private = child;
+      l = private->children;
+    }
+
+  return (GdkWindow *) private;
+}
+
+/**
+ * _gdk_window_pick_emulated:
+ * @window: a #GdkWindow
+ * @x: X coordinate in @window, translated on return
+ * @y: Y coordinate in @window, translated on return
+ *
+ * Finds the client-side child of @window at (@x, @y), if any,
+ * and translates the coordinates into it.
+ *
+ * Return value: the innermost window at the point, or @window
+ **/
+GdkWindow *
+_gdk_window_pick_emulated (GdkWindow *window,
+			   gint      *x,
+			   gint      *y)
+{
+  GdkWindow *under;
+  gint dx, dy;
+
+  if (!gdk_window_has_emulated_children (window))
+    return window;
+
+  under = gdk_window_pick (window, *x, *y);
+  if (under == NULL)
+    return window;
+
+  gdk_window_get_offset_in (under, window, &dx, &dy);
+  *x -= dx;
+  *y -= dy;
+
+  return under;
+}
+
+static void
+gdk_pointer_emulation_free (GdkPointerEmulation *pointer)
+{
+  g_slice_free (GdkPointerEmulation, pointer);
+}
+
+static GdkPointerEmulation *
+gdk_pointer_emulation_get (GdkDisplay *display)
+{
+  GdkPointerEmulation *pointer;
+
+  pointer = g_object_get_qdata (G_OBJECT (display), quark_pointer_emulation);
+  if (pointer == NULL)
+    {
+      pointer = g_slice_new0 (GdkPointerEmulation);
+      g_object_set_qdata_full (G_OBJECT (display), quark_pointer_emulation, pointer,
+			       (GDestroyNotify) gdk_pointer_emulation_free);
+    }
+
+  return pointer;
+}
+
+static GdkPointerEmulation *
+gdk_pointer_emulation_peek (GdkWindow *window)
+{
+  return g_object_get_qdata (G_OBJECT (gdk_drawable_get_display (window)),
+			     quark_pointer_emulation);
+}
+
+static void
+gdk_pointer_emulation_update (GdkPointerEmulation *pointer,
+			      GdkEvent            *event)
+{
+  pointer->native_window = event->any.window;
+  gdk_event_get_coords (event, &pointer->native_x, &pointer->native_y);
+  gdk_event_get_root_coords (event, &pointer->x_root, &pointer->y_root);
+  gdk_event_get_state (event, &pointer->state);
+  pointer->time = gdk_event_get_time (event);
+}
+
+/* Returns the pointer grab that applies to events on @native.
+ * The implicit grab of a routed button press is reported without
+ * owner events, as the window system does.
+ */
+static GdkWindow *
+gdk_pointer_emulation_get_grab (GdkDisplay          *display,
+				GdkPointerEmulation *pointer,
+				GdkWindow           *native,
+				gboolean            *owner_events)
+{
+  GdkWindow *grab_window;
+
+  if (!gdk_pointer_grab_info_libgtk_only (display, &grab_window, owner_events))
+    {
+      pointer->button_window = NULL;
+      return NULL;
+    }
+
+  if (grab_window == pointer->button_window)
+    {
+      *owner_events = FALSE;
+      return grab_window;
+    }
+
+  pointer->button_window = NULL;
+
+  if (_gdk_window_get_native (grab_window) != native)
+    return NULL;
+
+  return grab_window;
+}
+
+/* Shows the cursor of the innermost window containing the
+ * pointer (that has a cursor) on @native.
+ */
+static void
+gdk_pointer_emulation_update_cursor (GdkPointerEmulation *pointer,
+				     GdkWindow           *native)
+{
+  GdkWindowObject *private = (GdkWindowObject *) native;
+  GdkWindow *window = native;
+
+  if (pointer->native_window == native && pointer->pointer_window)
+    window = pointer->pointer_window;
+
+  while (window != native &&
+	 !g_object_get_qdata (G_OBJECT (window), quark_cursor))
+    window = (GdkWindow *) ((GdkWindowObject *) window)->parent;
+
+  if (window == pointer->cursor_window)
+    return;
+
+  pointer->cursor_window = window;
+  GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_cursor (native,
+							 g_object_get_qdata (G_OBJECT (window),
+									     quark_cursor));
+}
+
+static void
+gdk_crossing_init (GdkCrossingData     *crossing,
+		   GdkPointerEmulation *pointer,
+		   GdkWindow           *native,
+		   GdkWindow           *only_window,
+		   GdkCrossingMode      mode,
+		   gboolean             include_native)
+{
+  crossing->pointer = pointer;
+  crossing->native = native;
+  crossing->only_window = only_window;
+  crossing->mode = mode;
+  crossing->include_native = include_native;
+  crossing->events = NULL;
+}
+
+static void
+gdk_crossing_add (GdkCrossingData *crossing,
+		  GdkWindow       *window,
+		  GdkEventType     type,
+		  GdkNotifyType    detail)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkPointerEmulation *pointer = crossing->pointer;
+  GdkEvent *event;
+  gint x, y;
+
+  if (window == crossing->native && !crossing->include_native)
+    return;
+
+  if (crossing->only_window && window != crossing->only_window)
+    return;
+
+  if (!(private->event_mask & (type == GDK_ENTER_NOTIFY ?
+			       GDK_ENTER_NOTIFY_MASK : GDK_LEAVE_NOTIFY_MASK)))
+    return;
+
+  gdk_window_get_offset_in (window, crossing->native, &x, &y);
+
+  event = gdk_event_new (type);
+  event->crossing.window = g_object_ref (window);
+  event->crossing.subwindow = NULL;
+  event->crossing.time = pointer->time;
+  event->crossing.x = pointer->native_x - x;
+  event->crossing.y = pointer->native_y - y;
+  event->crossing.x_root = pointer->x_root;
+  event->crossing.y_root = pointer->y_root;
+  event->crossing.mode = crossing->mode;
+  event->crossing.detail = detail;
+  event->crossing.focus = FALSE;
+  event->crossing.state = pointer->state;
+  gdk_event_set_screen (event, gdk_drawable_get_screen (window));
+
+  crossing->events = g_list_prepend (crossing->events, event);
+}
+
+/* Leaves @window and its ancestors below @ancestor */
+static void
+gdk_crossing_leave_chain (GdkCrossingData *crossing,
+			  GdkWindow       *window,
+			  GdkWindow       *ancestor,
+			  GdkNotifyType    detail,
+			  GdkNotifyType    virtual_detail)
+{
+  GdkWindowObject *tmp;
+
+  gdk_crossing_add (crossing, window, GDK_LEAVE_NOTIFY, detail);
+
+  for (tmp = ((GdkWindowObject *) window)->parent;
+       tmp && (GdkWindow *) tmp != ancestor;
+       tmp = tmp->parent)
+    gdk_crossing_add (crossing, (GdkWindow *) tmp, GDK_LEAVE_NOTIFY, virtual_detail);
+}
+
+/* Enters the ancestors of @window below @ancestor, then @window */
+static void
+gdk_crossing_enter_chain (GdkCrossingData *crossing,
+			  GdkWindow       *ancestor,
+			  GdkWindow       *window,
+			  GdkNotifyType    detail,
+			  GdkNotifyType    virtual_detail)
+{
+  GdkWindow *parent = (GdkWindow *) ((GdkWindowObject *) window)->parent;
+
+  if (parent && parent != ancestor)
+    gdk_crossing_enter_chain (crossing, ancestor, parent,
+			      virtual_detail, virtual_detail);
+
+  gdk_crossing_add (crossing, window, GDK_ENTER_NOTIFY, detail);
+}
+
+static GdkWindow *
+gdk_window_common_ancestor (GdkWindow *a,
+			    GdkWindow *b)
+{
+  GdkWindowObject *tmp_a, *tmp_b;
+
+  for (tmp_a = (GdkWindowObject *) a; tmp_a; tmp_a = tmp_a->parent)
+    for (tmp_b = (GdkWindowObject *) b; tmp_b; tmp_b = tmp_b->parent)
+      if (tmp_a == tmp_b)
+	return (GdkWindow *) tmp_a;
+
+  return NULL;
+}
+
+/* The crossing events the window system would send for a
+ * pointer move from @from to @to.
+ */
+static void
+gdk_crossing_move (GdkCrossingData *crossing,
+		   GdkWindow       *from,
+		   GdkWindow       *to)
+{
+  GdkWindow *ancestor;
+
+  if (from == to)
+    return;
+
+  ancestor = gdk_window_common_ancestor (from, to);
+
+  if (ancestor == from)
+    {
+      gdk_crossing_add (crossing, from, GDK_LEAVE_NOTIFY, GDK_NOTIFY_INFERIOR);
+      gdk_crossing_enter_chain (crossing, from, to,
+				GDK_NOTIFY_ANCESTOR, GDK_NOTIFY_VIRTUAL);
+    }
+  else if (ancestor == to)
+    {
+      gdk_crossing_leave_chain (crossing, from, to,
+				GDK_NOTIFY_ANCESTOR, GDK_NOTIFY_VIRTUAL);
+      gdk_crossing_add (crossing, to, GDK_ENTER_NOTIFY, GDK_NOTIFY_INFERIOR);
+    }
+  else
+    {
+      gdk_crossing_leave_chain (crossing, from, ancestor,
+				GDK_NOTIFY_NONLINEAR, GDK_NOTIFY_NONLINEAR_VIRTUAL);
+      gdk_crossing_enter_chain (crossing, ancestor, to,
+				GDK_NOTIFY_NONLINEAR, GDK_NOTIFY_NONLINEAR_VIRTUAL);
+    }
+}
+
+/* Queues the synthesized events before or after @sibling, or
+ * at the end of the queue if @sibling is %NULL.
+ */
+static void
+gdk_crossing_queue (GdkDisplay      *display,
+		    GdkCrossingData *crossing,
+		    GdkEvent        *sibling,
+		    gboolean         after)
+{
+  GList *l;
+
+  /* crossing->events is in reverse order */
+  if (sibling && after)
+    {
+      for (l = crossing->events; l; l = l->next)
+	_gdk_event_queue_insert_after (display, sibling, l->data);
+    }
+  else
+    {
+      crossing->events = g_list_reverse (crossing->events);
+
+      for (l = crossing->events; l; l = l->next)
+	{
+	  if (sibling)
+	    _gdk_event_queue_insert_before (display, sibling, l->data);
+	  else
+	    {
+	      gdk_display_put_event (display, l->data);
+	      gdk_event_free (l->data);
+	    }
+	}
+    }
+
+  g_list_free (crossing->events);
+  crossing->events = NULL;
+}
+
+static GdkEventMask
+gdk_motion_event_mask (GdkModifierType state)
+{
+  GdkEventMask event_mask = GDK_POINTER_MOTION_MASK;
+
+  if (state & GDK_ANY_BUTTON_MASK)
+    event_mask |= GDK_BUTTON_MOTION_MASK;
+  if (state & GDK_BUTTON1_MASK)
+    event_mask |= GDK_BUTTON1_MOTION_MASK;
+  if (state & GDK_BUTTON2_MASK)
+    event_mask |= GDK_BUTTON2_MOTION_MASK;
+  if (state & GDK_BUTTON3_MASK)
+    event_mask |= GDK_BUTTON3_MOTION_MASK;
+
+  return event_mask;
+}
+
+/* Finds the window an event of a type in @type_mask goes to when
+ * it happens in @window: the first one up the hierarchy that
+ * selected it.
+ */
+static GdkWindow *
+gdk_window_find_event_target (GdkWindow    *window,
+			      GdkEventMask  type_mask)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+
+  while (private)
+    {
+      if (private->event_mask & type_mask)
+	return (GdkWindow *) private;
+
+      if (private->window_type != GDK_WINDOW_CHILD)
+	break;
+
+      private = private->parent;
+    }
+
+  return NULL;
+}
+
+static void
+offset_event_coords (GdkEvent *event,
+		     gint      dx,
+		     gint      dy)
+{
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+      event->motion.x += dx;
+      event->motion.y += dy;
+      break;
+    case GDK_BUTTON_PRESS:
+    case GDK_BUTTON_RELEASE:
+      event->button.x += dx;
+      event->button.y += dy;
+      break;
+    case GDK_SCROLL:
+      event->scroll.x += dx;
+      event->scroll.y += dy;
+      break;
+    default:
+      break;
+    }
+}
+
+static gboolean
+gdk_window_route_pointer_event (GdkDisplay          *display,
+				GdkPointerEmulation *pointer,
+				GdkEvent            *event)
+{
+  GdkWindow *native = event->any.window;
+  GdkWindow *under, *from, *grab, *target;
+  GdkCrossingData crossing;
+  GdkEventMask type_mask;
+  gboolean owner_events;
+  gint native_x, native_y;
+  gint target_x, target_y;
+
+  from = native;
+  if (pointer->native_window == native && pointer->pointer_window)
+    from = pointer->pointer_window;
+
+  gdk_pointer_emulation_update (pointer, event);
+  grab = gdk_pointer_emulation_get_grab (display, pointer, native, &owner_events);
+
+  under = gdk_window_pick (native, pointer->native_x, pointer->native_y);
+  if (under == NULL)
+    under = native;
+
+  if (under != from)
+    {
+      gdk_crossing_init (&crossing, pointer, native,
+			 grab && !owner_events ? grab : NULL,
+			 GDK_CROSSING_NORMAL, TRUE);
+      gdk_crossing_move (&crossing, from, under);
+      gdk_crossing_queue (display, &crossing, event, FALSE);
+    }
+
+  pointer->pointer_window = under;
+  gdk_pointer_emulation_update_cursor (pointer, native);
+
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+      type_mask = gdk_motion_event_mask (pointer->state);
+      break;
+    case GDK_BUTTON_RELEASE:
+      type_mask = GDK_BUTTON_RELEASE_MASK;
+      break;
+    default:
+      /* The window system selects scroll events as button presses */
+      type_mask = GDK_BUTTON_PRESS_MASK | GDK_SCROLL_MASK;
+      break;
+    }
+
+  if (grab && !owner_events)
+    {
+      /* An implicit grab only reports what the window selected */
+      if (grab != pointer->button_window ||
+	  (((GdkWindowObject *) grab)->event_mask & type_mask))
+	target = grab;
+      else
+	target = NULL;
+    }
+  else
+    {
+      target = gdk_window_find_event_target (under, type_mask);
+      if (target == NULL)
+	target = grab;
+    }
+
+  if (event->type == GDK_BUTTON_PRESS && grab == NULL)
+    pointer->button_window = target ? target : native;
+  else if (event->type == GDK_BUTTON_RELEASE && grab == pointer->button_window &&
+	   (pointer->state & GDK_ANY_BUTTON_MASK & ~(GDK_BUTTON1_MASK << (event->button.button - 1))) == 0)
+    pointer->button_window = NULL;
+
+  if (target == NULL)
+    return FALSE;
+
+  gdk_window_get_offset_in (native, NULL, &native_x, &native_y);
+  gdk_window_get_offset_in (target, NULL, &target_x, &target_y);
+  offset_event_coords (event, native_x - target_x, native_y - target_y);
+  event->any.window = target;
+
+  return TRUE;
+}
+
+/* The pointer entered or left a native window with client-side
+ * children; sends the matching crossing events to the children.
+ */
+static gboolean
+gdk_window_route_native_crossing (GdkDisplay          *display,
+				  GdkPointerEmulation *pointer,
+				  GdkEvent            *event)
+{
+  GdkWindow *native = event->any.window;
+  GdkWindowObject *private = (GdkWindowObject *) native;
+  GdkWindow *grab, *child = NULL;
+  GdkCrossingData crossing;
+  GdkNotifyType detail, virtual_detail;
+  GdkEventMask type_mask;
+  gboolean owner_events;
+
+  switch (event->crossing.detail)
+    {
+    case GDK_NOTIFY_ANCESTOR:
+    case GDK_NOTIFY_VIRTUAL:
+      detail = GDK_NOTIFY_ANCESTOR;
+      virtual_detail = GDK_NOTIFY_VIRTUAL;
+      break;
+    default:
+      detail = GDK_NOTIFY_NONLINEAR;
+      virtual_detail = GDK_NOTIFY_NONLINEAR_VIRTUAL;
+      break;
+    }
+
+  grab = gdk_pointer_emulation_get_grab (display, pointer, native, &owner_events);
+  gdk_crossing_init (&crossing, pointer, native,
+		     grab && !owner_events ? grab : NULL,
+		     event->crossing.mode, FALSE);
+
+  if (event->type == GDK_ENTER_NOTIFY)
+    {
+      gdk_pointer_emulation_update (pointer, event);
+
+      /* On a virtual enter the pointer is in a native child */
+      if (event->crossing.detail == GDK_NOTIFY_VIRTUAL ||
+	  event->crossing.detail == GDK_NOTIFY_NONLINEAR_VIRTUAL)
+	{
+	  pointer->native_window = NULL;
+	  pointer->pointer_window = NULL;
+	}
+      else
+	{
+	  child = gdk_window_pick (native, pointer->native_x, pointer->native_y);
+	  if (child == native)
+	    child = NULL;
+
+	  pointer->pointer_window = child ? child : native;
+	}
+
+      if (child)
+	{
+	  gdk_crossing_enter_chain (&crossing, native, child, detail, virtual_detail);
+	  gdk_crossing_queue (display, &crossing, event, TRUE);
+	}
+    }
+  else
+    {
+      if (pointer->native_window == native &&
+	  pointer->pointer_window && pointer->pointer_window != native)
+	{
+	  child = pointer->pointer_window;
+
+	  gdk_pointer_emulation_update (pointer, event);
+	  gdk_crossing_leave_chain (&crossing, child, native, detail, virtual_detail);
+	  gdk_crossing_queue (display, &crossing, event, FALSE);
+	}
+
+      pointer->native_window = NULL;
+      pointer->pointer_window = NULL;
+    }
+
+  gdk_pointer_emulation_update_cursor (pointer, native);
+
+  if (crossing.only_window && crossing.only_window != native)
+    return FALSE;
+
+  /* To the native window, the pointer only passed through
+   * to or from its client-side child.
+   */
+  if (child)
+    {
+      switch (event->crossing.detail)
+	{
+	case GDK_NOTIFY_INFERIOR:
+	  return FALSE;
+	case GDK_NOTIFY_ANCESTOR:
+	  event->crossing.detail = GDK_NOTIFY_VIRTUAL;
+	  break;
+	case GDK_NOTIFY_NONLINEAR:
+	  event->crossing.detail = GDK_NOTIFY_NONLINEAR_VIRTUAL;
+	  break;
+	default:
+	  break;
+	}
+    }
+
+  type_mask = event->type == GDK_ENTER_NOTIFY ? GDK_ENTER_NOTIFY_MASK : GDK_LEAVE_NOTIFY_MASK;
+
+  return (private->event_mask & type_mask) != 0;
+}
+
+/**
+ * _gdk_window_route_event:
+ * @display: a #GdkDisplay
+ * @event: a pointer event for a native window
+ *
+ * Sends a pointer event on a native window with client-side
+ * children to the window it is for, changing @event->any.window
+ * (which must not hold a reference yet) and the coordinates, and
+ * queues the crossing events the window system would have sent.
+ * The queued crossing events are placed next to @event, if it is
+ * on the event queue.
+ *
+ * Return value: %FALSE if no window selected the event and it
+ * should be dropped.
+ **/
+gboolean
+_gdk_window_route_event (GdkDisplay *display,
+			 GdkEvent   *event)
+{
+  GdkWindow *native = event->any.window;
+  GdkPointerEmulation *pointer;
+
+  if (native == NULL || !gdk_window_has_emulated_children (native))
+    return TRUE;
+
+  pointer = gdk_pointer_emulation_get (display);
+
+  switch (event->type)
+    {
+    case GDK_MOTION_NOTIFY:
+    case GDK_BUTTON_PRESS:
+    case GDK_BUTTON_RELEASE:
+    case GDK_SCROLL:
+      return gdk_window_route_pointer_event (display, pointer, event);
+    case GDK_ENTER_NOTIFY:
+    case GDK_LEAVE_NOTIFY:
+      return gdk_window_route_native_crossing (display, pointer, event);
+    default:
+      return TRUE;
+    }
+}
+
+/* Whether the last known pointer position is in @window */
+static gboolean
+gdk_window_emulated_under_pointer (GdkWindow *window)
+{
+  GdkPointerEmulation *pointer;
+  GdkWindowObject *tmp;
+  GdkWindow *native;
+  gint x, y, width, height;
+
+  if (!GDK_WINDOW_IS_EMULATED (window))
+    return FALSE;
+
+  pointer = gdk_pointer_emulation_peek (window);
+  native = _gdk_window_get_native (window);
+  if (pointer == NULL || pointer->native_window != native)
+    return FALSE;
+
+  for (tmp = (GdkWindowObject *) window; (GdkWindow *) tmp != native; tmp = tmp->parent)
+    if (!GDK_WINDOW_IS_MAPPED (tmp))
+      return FALSE;
+
+  gdk_window_get_offset_in (window, native, &x, &y);
+  gdk_drawable_get_size (GDK_DRAWABLE (window), &width, &height);
+
+  return (pointer->native_x >= x && pointer->native_x < x + width &&
+	  pointer->native_y >= y && pointer->native_y < y + height);
+}
+
+/* Sends crossing events if the client-side windows of @native
+ * changed under the pointer.
+ */
+static void
+gdk_window_emulated_recheck_pointer (GdkWindow *native)
+{
+  GdkDisplay *display = gdk_drawable_get_display (native);
+  GdkPointerEmulation *pointer;
+  GdkCrossingData crossing;
+  GdkWindow *under, *from, *grab;
+  gboolean owner_events;
+
+  pointer = gdk_pointer_emulation_peek (native);
+  if (pointer == NULL || pointer->native_window != native ||
+      GDK_WINDOW_DESTROYED (native))
+    return;
+
+  under = gdk_window_pick (native, pointer->native_x, pointer->native_y);
+  if (under == NULL)
+    under = native;
+
+  from = pointer->pointer_window ? pointer->pointer_window : native;
+  if (under != from)
+    {
+      grab = gdk_pointer_emulation_get_grab (display, pointer, native, &owner_events);
+      gdk_crossing_init (&crossing, pointer, native,
+			 grab && !owner_events ? grab : NULL,
+			 GDK_CROSSING_NORMAL, TRUE);
+      gdk_crossing_move (&crossing, from, under);
+      gdk_crossing_queue (display, &crossing, NULL, FALSE);
+    }
+
+  pointer->pointer_window = under;
+  gdk_pointer_emulation_update_cursor (pointer, native);
+}
+
+/* Breaks pointer and keyboard grabs on @window or its descendants,
+ * as the window system does when a grab window becomes unviewable.
+ */
+static void
+gdk_window_emulated_break_grab (GdkWindow *window)
+{
+  GdkDisplay *display = gdk_drawable_get_display (window);
+  GdkPointerEmulation *pointer = gdk_pointer_emulation_peek (window);
+  GdkWindowObject *tmp;
+  GdkWindow *grab_window;
+  GdkEvent event;
+  gint i;
+
+  for (i = 0; i < 2; i++)
+    {
+      gboolean keyboard = i == 1;
+
+      if (keyboard ?
+	  !gdk_keyboard_grab_info_libgtk_only (display, &grab_window, NULL) :
+	  !gdk_pointer_grab_info_libgtk_only (display, &grab_window, NULL))
+	continue;
+
+      for (tmp = (GdkWindowObject *) grab_window;
+	   tmp && (GdkWindow *) tmp != window;
+	   tmp = tmp->parent)
+	;
+
+      if (tmp == NULL)
+	continue;
+
+      event.type = GDK_GRAB_BROKEN;
+      event.grab_broken.window = grab_window;
+      event.grab_broken.send_event = FALSE;
+      event.grab_broken.keyboard = keyboard;
+      event.grab_broken.implicit = !keyboard && pointer &&
+				   pointer->button_window == grab_window;
+      event.grab_broken.grab_window = NULL;
+      gdk_display_put_event (display, &event);
+
+      if (keyboard)
+	gdk_display_keyboard_ungrab (display, GDK_CURRENT_TIME);
+      else
+	{
+	  gdk_display_pointer_ungrab (display, GDK_CURRENT_TIME);
+	  if (pointer)
+	    pointer->button_window = NULL;
+	}
+    }
+}
+
+/* Drops the references the pointer state has to @window */
+static void
+gdk_window_forget_pointer (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkPointerEmulation *pointer = gdk_pointer_emulation_peek (window);
+
+  if (pointer == NULL)
+    return;
+
+  if (pointer->pointer_window == window)
+    pointer->pointer_window = GDK_WINDOW_IS_EMULATED (window) ?
+      (GdkWindow *) private->parent : NULL;
+
+  if (pointer->native_window == window)
+    {
+      pointer->native_window = NULL;
+      pointer->pointer_window = NULL;
+    }
+
+  if (pointer->button_window == window)
+    pointer->button_window = NULL;
+
+  if (pointer->cursor_window == window)
+    pointer->cursor_window = NULL;
+}
+
+static void
+gdk_window_emulated_show (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  gdk_synthesize_window_state (window, GDK_WINDOW_STATE_WITHDRAWN, 0);
+
+  /* The window system would expose the window, also when it
+   * got raised.
+   */
+  if (!private->input_only)
+    gdk_window_invalidate_rect (window, NULL, TRUE);
+
+  if (gdk_window_emulated_under_pointer (window))
+    gdk_window_emulated_recheck_pointer (_gdk_window_get_native (window));
+}
+
+static void
+gdk_window_emulated_hide (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *native;
+  GdkRegion *exposed = NULL;
+  gboolean had_pointer;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  native = _gdk_window_get_native (window);
+  had_pointer = gdk_window_emulated_under_pointer (window);
+  if (!private->input_only)
+    exposed = gdk_window_get_native_visible_region (window, native);
+
+  gdk_synthesize_window_state (window, 0, GDK_WINDOW_STATE_WITHDRAWN);
+  _gdk_window_clear_update_area (window);
+  gdk_window_emulated_break_grab (window);
+
+  /* Uncover what is below */
+  if (exposed)
+    {
+      _gdk_window_invalidate_for_expose (native, exposed);
+      gdk_region_destroy (exposed);
+    }
+
+  if (had_pointer)
+    gdk_window_emulated_recheck_pointer (native);
+}
+
+static void
+gdk_window_emulated_restack (GdkWindow *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *native = _gdk_window_get_native (window);
+  GdkRectangle rect;
+  GdkRegion *region;
+
+  /* Siblings may overlap it differently now */
+  if (!private->input_only && GDK_WINDOW_IS_MAPPED (window))
+    {
+      gdk_window_get_offset_in (window, native, &rect.x, &rect.y);
+      gdk_drawable_get_size (GDK_DRAWABLE (window), &rect.width, &rect.height);
+      region = gdk_region_rectangle (&rect);
+      _gdk_window_invalidate_for_expose (native, region);
+      gdk_region_destroy (region);
+    }
+
+  if (gdk_window_emulated_under_pointer (window))
+    gdk_window_emulated_recheck_pointer (native);
+}
+
+static void
+gdk_window_emulated_move_resize (GdkWindow *window,
+				 gboolean   with_move,
+				 gint       x,
+				 gint       y,
+				 gint       width,
+				 gint       height)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindowEmulated *emulated;
+  GdkWindow *native;
+  GdkRegion *old_region = NULL, *new_region, *copy_region;
+  gint old_x, old_y, new_x, new_y;
+  gboolean had_pointer;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  native = _gdk_window_get_native (window);
+  had_pointer = gdk_window_emulated_under_pointer (window);
+
+  if (!private->input_only)
+    {
+      old_region = gdk_window_get_native_visible_region (window, native);
+      gdk_window_get_offset_in (window, native, &old_x, &old_y);
+    }
+
+  if (with_move)
+    {
+      private->x = x;
+      private->y = y;
+    }
+
+  if (!with_move || width >= 0 || height >= 0)
+    {
+      emulated = g_object_get_qdata (G_OBJECT (window), quark_emulated);
+      emulated->width = MAX (width, 1);
+      emulated->height = MAX (height, 1);
+    }
+
+  if (old_region)
+    {
+      /* Move what stays visible, like the window system does
+       * with the contents of a window, and expose the rest of
+       * the old and new area.
+       */
+      new_region = gdk_window_get_native_visible_region (window, native);
+      gdk_window_get_offset_in (window, native, &new_x, &new_y);
+
+      copy_region = gdk_region_copy (old_region);
+      gdk_region_offset (copy_region, new_x - old_x, new_y - old_y);
+      gdk_region_intersect (copy_region, new_region);
+
+      if (new_x != old_x || new_y != old_y)
+	gdk_window_copy_native_region (native, copy_region,
+				       new_x - old_x, new_y - old_y);
+
+      gdk_region_union (old_region, new_region);
+      gdk_region_subtract (old_region, copy_region);
+      _gdk_window_invalidate_for_expose (native, old_region);
+
+      gdk_region_destroy (copy_region);
+      gdk_region_destroy (new_region);
+      gdk_region_destroy (old_region);
+    }
+
+  if (had_pointer || gdk_window_emulated_under_pointer (window))
+    gdk_window_emulated_recheck_pointer (native);
+}
+
+static void
+gdk_window_emulated_scroll (GdkWindow *window,
+			    gint       dx,
+			    gint       dy)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *native;
+  GdkRegion *region, *copy_region;
+  gint x, y;
+  GList *l;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  native = _gdk_window_get_native (window);
+
+  /* Move the invalid area along with the contents */
+  if (private->update_area)
+    gdk_region_offset (private->update_area, dx, dy);
+
+  for (l = private->children; l; l = l->next)
+    {
+      GdkWindowObject *child = l->data;
+
+      child->x += dx;
+      child->y += dy;
+    }
+
+  if (!private->input_only)
+    {
+      /* Copy what stays visible and expose the rest; the
+       * children moved with it.
+       */
+      region = gdk_drawable_get_visible_region (GDK_DRAWABLE (window));
+      copy_region = gdk_region_copy (region);
+      gdk_region_offset (copy_region, dx, dy);
+      gdk_region_intersect (copy_region, region);
+
+      gdk_window_get_offset_in (window, native, &x, &y);
+      gdk_region_offset (copy_region, x, y);
+      gdk_window_copy_native_region (native, copy_region, dx, dy);
+      gdk_region_offset (copy_region, -x, -y);
+
+      gdk_region_subtract (region, copy_region);
+      gdk_window_invalidate_region (window, region, TRUE);
+
+      gdk_region_destroy (copy_region);
+      gdk_region_destroy (region);
+    }
+
+  gdk_window_emulated_recheck_pointer (native);
+}
+
+/* gdk_window_move_region() for a client-side window, or a native
+ * window client-side children draw over: what the X11 backend
+ * does, clipped to what the window shows of itself.
+ */
+static void
+gdk_window_emulated_move_region (GdkWindow       *window,
+				 const GdkRegion *region,
+				 gint             dx,
+				 gint             dy)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *native = _gdk_window_get_native (window);
+  GdkRegion *window_clip, *clip;
+  GdkRegion *src_region, *brought_in, *dest_region;
+  GdkRegion *moving_invalid_region = NULL;
+  gint x, y;
+
+  window_clip = gdk_drawable_get_visible_region (GDK_DRAWABLE (window));
+  clip = gdk_window_get_emulated_clip (window, FALSE);
+  gdk_region_intersect (window_clip, clip);
+  gdk_region_destroy (clip);
+
+  /* compute source regions */
+  src_region = gdk_region_copy (region);
+  brought_in = gdk_region_copy (region);
+  gdk_region_intersect (src_region, window_clip);
+
+  gdk_region_subtract (brought_in, src_region);
+  gdk_region_offset (brought_in, dx, dy);
+
+  /* compute destination regions */
+  dest_region = gdk_region_copy (src_region);
+  gdk_region_offset (dest_region, dx, dy);
+  gdk_region_intersect (dest_region, window_clip);
+
+  gdk_region_destroy (window_clip);
+
+  /* calculating moving part of current invalid area */
+  if (private->update_area)
+    {
+      moving_invalid_region = gdk_region_copy (private->update_area);
+      gdk_region_intersect (moving_invalid_region, src_region);
+      gdk_region_offset (moving_invalid_region, dx, dy);
+    }
+
+  /* invalidate all of the src region, but the destination */
+  gdk_window_invalidate_region (window, src_region, FALSE);
+  if (private->update_area)
+    gdk_region_subtract (private->update_area, dest_region);
+
+  if (moving_invalid_region)
+    {
+      gdk_window_invalidate_region (window, moving_invalid_region, FALSE);
+      gdk_region_destroy (moving_invalid_region);
+    }
+
+  /* invalidate area brought in from off-screen */
+  gdk_window_invalidate_region (window, brought_in, FALSE);
+  gdk_region_destroy (brought_in);
+
+  /* Actually do the moving */
+  gdk_window_get_offset_in (window, native, &x, &y);
+  gdk_region_offset (dest_region, x, y);
+  gdk_window_copy_native_region (native, dest_region, dx, dy);
+
+  gdk_region_destroy (src_region);
+  gdk_region_destroy (dest_region);
+}
+
+static void
+gdk_window_emulated_set_background (GdkWindow      *window,
+				    const GdkColor *color)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+
+  if (private->input_only)
+    return;
+
+  private->bg_color = *color;
+  gdk_colormap_query_color (gdk_drawable_get_colormap (window),
+			    private->bg_color.pixel, &private->bg_color);
+
+  if (private->bg_pixmap &&
+      private->bg_pixmap != GDK_PARENT_RELATIVE_BG &&
+      private->bg_pixmap != GDK_NO_BG)
+    g_object_unref (private->bg_pixmap);
+
+  private->bg_pixmap = NULL;
+}
+
+static void
+gdk_window_emulated_set_back_pixmap (GdkWindow *window,
+				     GdkPixmap *pixmap,
+				     gboolean   parent_relative)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+
+  if (private->input_only)
+    return;
+
+  if (pixmap && !gdk_drawable_get_colormap (pixmap))
+    {
+      g_warning ("gdk_window_set_back_pixmap(): pixmap must have a colormap");
+      return;
+    }
+
+  if (private->bg_pixmap &&
+      private->bg_pixmap != GDK_PARENT_RELATIVE_BG &&
+      private->bg_pixmap != GDK_NO_BG)
+    g_object_unref (private->bg_pixmap);
+
+  if (parent_relative)
+    private->bg_pixmap = GDK_PARENT_RELATIVE_BG;
+  else if (pixmap)
+    private->bg_pixmap = g_object_ref (pixmap);
+  else
+    private->bg_pixmap = GDK_NO_BG;
+}
+
+/* Clears (part of) a window the window system can't clear
+ * without touching its client-side children or siblings.
+ */
+static void
+gdk_window_emulated_clear_area (GdkWindow *window,
+				gint       x,
+				gint       y,
+				gint       width,
+				gint       height,
+				gboolean   send_expose)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkRectangle rect;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  /* Zero means up to the edge, as in XClearArea() */
+  gdk_drawable_get_size (GDK_DRAWABLE (window), &rect.width, &rect.height);
+  rect.x = x;
+  rect.y = y;
+  rect.width = width ? width : rect.width - x;
+  rect.height = height ? height : rect.height - y;
+
+  if (private->paint_stack == NULL && private->bg_pixmap != GDK_NO_BG)
+    {
+      gdk_window_begin_paint_rect (window, &rect);
+      gdk_window_end_paint (window);
+    }
+
+  if (send_expose)
+    gdk_window_invalidate_rect (window, &rect, FALSE);
+}
+
+static void
+gdk_window_set_emulated_native (GdkWindow *window,
+				GdkWindow *native)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindowEmulated *emulated;
+  GdkWindow *old_native;
+  GList *l;
+
+  emulated = g_object_get_qdata (G_OBJECT (window), quark_emulated);
+  old_native = emulated->native;
+
+  /* The old native window outlives the impl it owns */
+  g_object_unref (private->impl);
+  private->impl = g_object_ref (GDK_WINDOW_OBJECT (native)->impl);
+  emulated->native = g_object_ref (native);
+  g_object_unref (old_native);
+
+  gdk_window_add_emulated_events (window, private->event_mask);
+  if (g_object_get_qdata (G_OBJECT (window), quark_cursor))
+    gdk_window_add_emulated_events (window, GDK_ENTER_NOTIFY_MASK);
+
+  for (l = private->children; l; l = l->next)
+    gdk_window_set_emulated_native (l->data, native);
+}
+
+static gboolean
+gdk_window_emulated_reparent (GdkWindow *window,
+			      GdkWindow *new_parent,
+			      gint       x,
+			      gint       y)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindowObject *old_parent = private->parent;
+  GdkWindowObject *parent_private = (GdkWindowObject *) new_parent;
+  GdkWindow *old_native, *native;
+  GdkRegion *exposed = NULL;
+  gboolean had_pointer;
+
+  old_native = _gdk_window_get_native (window);
+  native = _gdk_window_get_native (new_parent);
+  had_pointer = gdk_window_emulated_under_pointer (window);
+  if (!private->input_only)
+    exposed = gdk_window_get_native_visible_region (window, old_native);
+
+  old_parent->children = g_list_remove (old_parent->children, window);
+  parent_private->children = g_list_prepend (parent_private->children, window);
+  private->parent = parent_private;
+  private->x = x;
+  private->y = y;
+
+  if (native != old_native)
+    gdk_window_set_emulated_native (window, native);
+
+  /* Repaint where it was and where it is now */
+  if (exposed)
+    {
+      _gdk_window_invalidate_for_expose (old_native, exposed);
+      gdk_region_destroy (exposed);
+      gdk_window_invalidate_rect (window, NULL, TRUE);
+    }
+
+  if (had_pointer)
+    gdk_window_emulated_recheck_pointer (old_native);
+  if (gdk_window_emulated_under_pointer (window))
+    gdk_window_emulated_recheck_pointer (native);
+
+  return FALSE;
+}
+
+/* Client-side windows have no cursor in the window system;
+ * their native window shows the cursor of the innermost window
+ * under the pointer that has one.
+ */
+static void
+gdk_window_emulated_set_cursor (GdkWindow *window,
+				GdkCursor *cursor)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkPointerEmulation *pointer;
+  GdkWindow *native;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return;
+
+  native = _gdk_window_get_native (window);
+  if (native != window)
+    gdk_window_add_emulated_events (window, GDK_ENTER_NOTIFY_MASK);
+
+  pointer = gdk_pointer_emulation_peek (window);
+
+  if (pointer && pointer->native_window == native &&
+      gdk_window_has_emulated_children (native))
+    {
+      pointer->cursor_window = NULL;
+      gdk_pointer_emulation_update_cursor (pointer, native);
+    }
+  else if (native == window)
+    GDK_WINDOW_IMPL_GET_IFACE (private->impl)->set_cursor (window, cursor);
+}
+
+/**
+ * gdk_window_ensure_native:
+ * @window: a #GdkWindow
+ *
+ * Makes sure @window has a window in the window system. Child
+ * windows GDK handles on the client side (see gdk_window_new())
+ * get one, and so do their ancestors; their children stay on
+ * the client side. This is needed to use @window with native
+ * APIs, and happens automatically when GDK hands out the native
+ * handle of @window, as gdk_x11_drawable_get_xid() does.
+ *
+ * Return value: %TRUE if @window has a native window
+ *
+ * Since: 2.16
+ **/
+gboolean
+gdk_window_ensure_native (GdkWindow *window)
+{
+#ifdef GDK_WINDOWING_X11
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindow *old_native;
+  gboolean had_pointer;
+  gint width, height;
+  GList *l;
+#endif
+
+  g_return_val_if_fail (GDK_IS_WINDOW (window), FALSE);
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return FALSE;
+
+  if (!GDK_WINDOW_IS_EMULATED (window))
+    return TRUE;
+
+#ifdef GDK_WINDOWING_X11
+  if (!gdk_window_ensure_native ((GdkWindow *) private->parent))
+    return FALSE;
+
+  old_native = g_object_ref (_gdk_window_get_native (window));
+  had_pointer = gdk_window_emulated_under_pointer (window);
+  gdk_drawable_get_size (GDK_DRAWABLE (window), &width, &height);
+
+  _gdk_x11_window_make_native (window, width, height);
+  g_object_set_qdata (G_OBJECT (window), quark_emulated, NULL);
+
+  /* The children now share the new native window */
+  for (l = private->children; l; l = l->next)
+    gdk_window_set_emulated_native (l->data, window);
+
+  gdk_window_emulated_set_cursor (window,
+				  g_object_get_qdata (G_OBJECT (window), quark_cursor));
+
+  if (had_pointer)
+    gdk_window_emulated_recheck_pointer (old_native);
+  g_object_unref (old_native);
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
 #define __GDK_WINDOW_C__
 #include "gdkaliasdef.c"
@@ -407,6 +407,12 @@ void gdk_window_set_child_shapes (GdkWindow *window);
 void gdk_window_set_composited   (GdkWindow *window,
                                   gboolean   composited);
 
+void     gdk_window_set_motion_compression (GdkWindow *window,
+                                            gboolean   compress);
+gboolean gdk_window_get_motion_compression (GdkWindow *window);
+
+gboolean gdk_window_ensure_native (GdkWindow *window);
+
 /*
  * This routine allows you to merge (ie ADD) child shapes to your
  * own window's shape keeping its current shape and ADDING the child
@@ -50,6 +50,7 @@ in this Software without prior written authorization from The Open Group.
 #include <X11/Xlibint.h>
 #include "gdkasync.h"
 #include "gdkx.h"
+#include "gdkprivate-x11.h"
 #include "gdkalias.h"
 
 typedef struct _ChildInfoChildState ChildInfoChildState;
@@ -57,6 +58,7 @@ typedef struct _ChildInfoState ChildInfoState;
 typedef struct _ListChildrenState ListChildrenState;
 typedef struct _SendEventState SendEventState;
 typedef struct _SetInputFocusState SetInputFocusState;
+typedef struct _WindowInfoState WindowInfoState;
 
 typedef enum {
   CHILD_INFO_GET_PROPERTY,
@@ -112,6 +114,15 @@ struct _SetInputFocusState
   gulong get_input_focus_req;
 };
 
+struct _WindowInfoState
+{
+  GdkWindowInfoX11 *info;
+  gulong get_wa_req;
+  gulong get_geometry_req;
+  gulong query_tree_req;
+  gboolean have_error;
+};
+
 static gboolean
 callback_idle (gpointer data)
 {
@@ -639,6 +650,7 @@ _gdk_x11_get_window_child_info (GdkDisplay       *display,
   state.children = NULL;
   state.nchildren = 0;
 
+  GDK_X11_ROUND_TRIP (display, "QueryTree");
   gdk_error_trap_push ();
   result = list_children_and_wm_state (dpy, window,
 				       win_has_wm_state ? wm_state_atom : None,
@@ -715,6 +727,8 @@ _gdk_x11_get_window_child_info (GdkDisplay       *display,
        */
       xGetGeometryReply rep;
 
+      GDK_X11_ROUND_TRIP (display, "GetGeometry");
+
       /* On error, our async handler will get called
        */
       if (_XReply (dpy, (xReply *)&rep, 0, xTrue))
@@ -743,5 +757,134 @@ _gdk_x11_get_window_child_info (GdkDisplay       *display,
   return !state.have_error;
 }
 
+static Bool
+window_info_handler (Display *dpy,
+		     xReply  *rep,
+		     char    *buf,
+		     int      len,
+		     XPointer data)
+{
+  WindowInfoState *state = (WindowInfoState *)data;
+  GdkWindowInfoX11 *info = state->info;
+
+  if (dpy->last_request_read != state->get_wa_req &&
+      dpy->last_request_read != state->get_geometry_req &&
+      dpy->last_request_read != state->query_tree_req)
+    return False;
+
+  /* The reply or error of the QueryTree request is left to
+   * _XReply(), which passes errors to the error handler.
+   */
+  if (dpy->last_request_read == state->query_tree_req)
+    return False;
+
+  /* The window may be gone; QueryTree fails the same way
+   */
+  if (rep->generic.type == X_Error)
+    {
+      state->have_error = TRUE;
+      return True;
+    }
+
+  if (dpy->last_request_read == state->get_wa_req)
+    {
+      xGetWindowAttributesReply replbuf;
+      xGetWindowAttributesReply *repl;
+
+      repl = (xGetWindowAttributesReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(sizeof(xGetWindowAttributesReply) - sizeof(xReply)) >> 2,
+			True);
+
+      info->visual = repl->visualID;
+      info->colormap = repl->colormap;
+      info->your_event_mask = repl->yourEventMask;
+      info->is_mapped = repl->mapState != IsUnmapped;
+      info->window_class = repl->class;
+    }
+  else
+    {
+      xGetGeometryReply replbuf;
+      xGetGeometryReply *repl;
+
+      repl = (xGetGeometryReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(sizeof(xGetGeometryReply) - sizeof(xReply)) >> 2,
+			True);
+
+      info->x = cvtINT16toInt (repl->x);
+      info->y = cvtINT16toInt (repl->y);
+      info->width = repl->width;
+      info->height = repl->height;
+      info->depth = repl->depth;
+    }
+
+  return True;
+}
+
+/**
+ * _gdk_x11_get_window_info:
+ * @display: a #GdkDisplay
+ * @window: the window to query
+ * @info: return location for the information about @window
+ * 
+ * Gets the attributes, geometry and parent of @window with a
+ * single round trip; separate XGetWindowAttributes() and
+ * XQueryTree() calls would take three. If @window may have been
+ * destroyed, call this within an error trap, as for XQueryTree().
+ * 
+ * Return value: %FALSE if @window doesn't exist
+ **/
+gboolean
+_gdk_x11_get_window_info (GdkDisplay       *display,
+			  Window            window,
+			  GdkWindowInfoX11 *info)
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  WindowInfoState state;
+  xQueryTreeReply rep;
+  xResourceReq *req;
+
+  dpy = GDK_DISPLAY_XDISPLAY (display);
+
+  state.info = info;
+  state.have_error = FALSE;
+
+  GDK_X11_ROUND_TRIP (display, "QueryTree");
+
+  LockDisplay(dpy);
+
+  async.next = dpy->async_handlers;
+  async.handler = window_info_handler;
+  async.data = (XPointer) &state;
+  dpy->async_handlers = &async;
+
+  GetResReq(GetWindowAttributes, window, req);
+  state.get_wa_req = dpy->request;
+
+  GetResReq(GetGeometry, window, req);
+  state.get_geometry_req = dpy->request;
+
+  GetResReq(QueryTree, window, req);
+  state.query_tree_req = dpy->request;
+
+  if (_XReply(dpy, (xReply *)&rep, 0, xFalse))
+    {
+      info->root = rep.root;
+      info->parent = rep.parent;
+      if (rep.nChildren != 0)
+	_XEatData(dpy, (unsigned long) rep.nChildren << 2);
+    }
+  else
+    state.have_error = TRUE;
+
+  DeqAsyncHandler(dpy, &async);
+  UnlockDisplay(dpy);
+  SyncHandle();
+
+  return !state.have_error;
+}
+
 #define __GDK_ASYNC_C__
 #include "gdkaliasdef.c"
@@ -27,6 +27,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GdkChildInfoX11 GdkChildInfoX11;
+typedef struct _GdkWindowInfoX11 GdkWindowInfoX11;
 
 typedef void (*GdkSendXEventCallback) (Window   window,
 				       gboolean success,
@@ -44,6 +45,22 @@ struct _GdkChildInfoX11
   guint window_class : 2;
 };
 
+struct _GdkWindowInfoX11
+{
+  Window root;
+  Window parent;
+  gint x;
+  gint y;
+  gint width;
+  gint height;
+  gint depth;
+  VisualID visual;
+  Colormap colormap;
+  glong your_event_mask;
+  guint is_mapped : 1;
+  guint window_class : 2;
+};
+
 void _gdk_x11_send_client_message_async (GdkDisplay            *display,
 					 Window                 window,
 					 gboolean               propagate,
@@ -62,6 +79,9 @@ gboolean _gdk_x11_get_window_child_info (GdkDisplay       *display,
 					 gboolean         *win_has_wm_state,
 					 GdkChildInfoX11 **children,
 					 guint            *nchildren);
+gboolean _gdk_x11_get_window_info       (GdkDisplay       *display,
+					 Window            window,
+					 GdkWindowInfoX11 *info);
 
 G_END_DECLS
 
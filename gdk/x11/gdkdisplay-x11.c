@@ -582,6 +582,18 @@ _gdk_x11_display_is_root_window (GdkDisplay *display,
   return FALSE;
 }
 
+void
+_gdk_x11_display_note_round_trip (GdkDisplay  *display,
+				  const gchar *request,
+				  const gchar *function)
+{
+  GdkDisplayX11 *display_x11 = GDK_DISPLAY_X11 (display);
+
+  display_x11->n_round_trips++;
+  g_message ("round trip %u: %s in %s()",
+	     display_x11->n_round_trips, request, function);
+}
+
 #define XSERVER_TIME_IS_LATER(time1, time2)                        \
   ( (( time1 > time2 ) && ( time1 - time2 < ((guint32)-1)/2 )) ||  \
     (( time1 < time2 ) && ( time2 - time1 > ((guint32)-1)/2 ))     \
@@ -704,6 +716,7 @@ gdk_display_sync (GdkDisplay *display)
 {
   g_return_if_fail (GDK_IS_DISPLAY (display));
   
+  GDK_X11_ROUND_TRIP (display, "Sync");
   XSync (GDK_DISPLAY_XDISPLAY (display), False);
 }
 
@@ -140,6 +140,9 @@ struct _GdkDisplayX11
   /* translation queue */
   GQueue *translate_queue;
 
+  /* round trips counted with GDK_DEBUG=roundtrips */
+  guint n_round_trips;
+
   /* Input device */
   /* input GdkDevice list */
   GList *input_devices;
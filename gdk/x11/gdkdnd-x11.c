@@ -2988,6 +2988,9 @@ gdk_drag_begin (GdkWindow     *window,
   
   g_return_val_if_fail (window != NULL, NULL);
 
+  /* The protocols identify the source by its X window */
+  gdk_window_ensure_native (window);
+
   new_context = gdk_drag_context_new ();
   new_context->is_source = TRUE;
   new_context->source_window = window;
@@ -3191,6 +3194,10 @@ gdk_drag_find_window_for_screen (GdkDragContext  *context,
 
   window_cache = drag_context_find_window_cache (context, screen);
 
+  /* The drag window is skipped by its X window */
+  if (drag_window)
+    gdk_window_ensure_native (drag_window);
+
   dest = get_client_window_at_coords (window_cache,
 				      drag_window ? 
 				      GDK_DRAWABLE_XID (drag_window) : None,
@@ -3750,6 +3757,9 @@ gdk_window_register_dnd (GdkWindow      *window)
     return;
   else
     g_object_set_data (G_OBJECT (window), "gdk-dnd-registered", GINT_TO_POINTER (TRUE));
+
+  /* Drop sites are found by the properties on their X window */
+  gdk_window_ensure_native (window);
   
   /* Set Motif drag receiver information property */
 
@@ -870,7 +870,13 @@ gdk_x11_drawable_get_xid (GdkDrawable *drawable)
   GdkDrawable *impl;
   
   if (GDK_IS_WINDOW (drawable))
-    impl = ((GdkPixmapObject *)drawable)->impl;
+    {
+      /* Client-side windows need their own X window to be
+       * used from outside of GDK.
+       */
+      gdk_window_ensure_native (GDK_WINDOW (drawable));
+      impl = ((GdkPixmapObject *)drawable)->impl;
+    }
   else if (GDK_IS_PIXMAP (drawable))
     impl = ((GdkPixmapObject *)drawable)->impl;
   else
@@ -1494,5 +1500,47 @@ gdk_x11_ref_cairo_surface (GdkDrawable *drawable)
   return impl->cairo_surface;
 }
 
+/**
+ * _gdk_x11_window_create_cairo_surface:
+ * @window: a client-side #GdkWindow
+ * @x_offset: X offset of @window coordinates in its X window
+ * @y_offset: Y offset of @window coordinates in its X window
+ *
+ * Creates a surface for the X window @window draws to, with
+ * the origin at the origin of @window. Unlike the surface of
+ * the impl, it isn't cached, since the offset changes when
+ * @window moves.
+ *
+ * Return value: a new surface, or %NULL
+ **/
+cairo_surface_t *
+_gdk_x11_window_create_cairo_surface (GdkWindow *window,
+				      gint       x_offset,
+				      gint       y_offset)
+{
+  GdkDrawableImplX11 *impl;
+  GdkVisual *visual;
+  cairo_surface_t *surface;
+  int width, height;
+
+  if (GDK_WINDOW_DESTROYED (window))
+    return NULL;
+
+  impl = GDK_DRAWABLE_IMPL_X11 (GDK_WINDOW_OBJECT (window)->impl);
+  visual = gdk_drawable_get_visual (GDK_DRAWABLE (impl));
+  if (!visual)
+    return NULL;
+
+  gdk_drawable_get_size (GDK_DRAWABLE (impl), &width, &height);
+
+  surface = cairo_xlib_surface_create (GDK_SCREEN_XDISPLAY (impl->screen),
+				       impl->xid,
+				       GDK_VISUAL_XVISUAL (visual),
+				       width, height);
+  cairo_surface_set_device_offset (surface, - x_offset, - y_offset);
+
+  return surface;
+}
+
 #define __GDK_DRAWABLE_X11_C__
 #include "gdkaliasdef.c"
@@ -1141,6 +1141,12 @@ gdk_event_translate (GdkDisplay *display,
 	      return_val = FALSE;
 	      break;
 	    }
+
+	  if (!_gdk_window_route_event (display, event))
+	    {
+	      return_val = FALSE;
+	      break;
+	    }
 	  
           break;
           
@@ -1163,13 +1169,20 @@ gdk_event_translate (GdkDisplay *display,
 	      break;
 	    }
 
+	  if (!_gdk_window_route_event (display, event))
+	    {
+	      return_val = FALSE;
+	      break;
+	    }
+
 	  _gdk_event_button_generate (display, event);
           break;
 	}
 
       set_user_time (window, event);
 
-      _gdk_xgrab_check_button_event (window, xevent);
+      /* Record the implicit grab on the window the press was routed to */
+      _gdk_xgrab_check_button_event (event->any.window, xevent);
       break;
       
     case ButtonRelease:
@@ -1191,6 +1204,7 @@ gdk_event_translate (GdkDisplay *display,
       if (xevent->xbutton.button == 4 || xevent->xbutton.button == 5 ||
           xevent->xbutton.button == 6 || xevent->xbutton.button ==7)
 	{
+	  _gdk_xgrab_check_button_event (window, xevent);
 	  return_val = FALSE;
 	  break;
 	}
@@ -1213,6 +1227,9 @@ gdk_event_translate (GdkDisplay *display,
 	  break;
 	}
 
+      if (!_gdk_window_route_event (display, event))
+	return_val = FALSE;
+
       _gdk_xgrab_check_button_event (window, xevent);
       break;
       
@@ -1248,6 +1265,9 @@ gdk_event_translate (GdkDisplay *display,
 	  return_val = FALSE;
 	  break;
 	}
+
+      if (!_gdk_window_route_event (display, event))
+	return_val = FALSE;
             
       break;
       
@@ -1350,6 +1370,9 @@ gdk_event_translate (GdkDisplay *display,
       
       event->crossing.focus = xevent->xcrossing.focus;
       event->crossing.state = xevent->xcrossing.state;
+
+      if (!_gdk_window_route_event (display, event))
+	return_val = FALSE;
   
       break;
       
@@ -1445,6 +1468,9 @@ gdk_event_translate (GdkDisplay *display,
       
       event->crossing.focus = xevent->xcrossing.focus;
       event->crossing.state = xevent->xcrossing.state;
+
+      if (!_gdk_window_route_event (display, event))
+	return_val = FALSE;
       
       break;
       
@@ -2271,8 +2297,21 @@ _gdk_events_queue (GdkDisplay *display)
   XEvent xevent;
   Display *xdisplay = GDK_DISPLAY_XDISPLAY (display);
 
-  while (!_gdk_event_queue_find_first(display) && XPending (xdisplay))
+  while (XPending (xdisplay))
     {
+      if (_gdk_event_queue_find_first (display))
+	{
+	  /* Read ahead through the pending motion events, so that
+	   * they can be compressed with the one we have queued.
+	   */
+	  if (!_gdk_event_queue_wants_motion (display))
+	    break;
+
+	  XPeekEvent (xdisplay, &xevent);
+	  if (xevent.type != MotionNotify)
+	    break;
+	}
+
       XNextEvent (xdisplay, &xevent);
 
       switch (xevent.type)
@@ -249,7 +249,14 @@ gdk_window_copy_area_scroll (GdkWindow    *window,
       GdkWindow *child = (GdkWindow*) l->data;
       GdkWindowObject *child_obj = GDK_WINDOW_OBJECT (child);
 
-      gdk_window_move (child, child_obj->x + dx, child_obj->y + dy);
+      /* Client-side children were copied with the contents */
+      if (GDK_WINDOW_IS_EMULATED (child))
+	{
+	  child_obj->x += dx;
+	  child_obj->y += dy;
+	}
+      else
+	gdk_window_move (child, child_obj->x + dx, child_obj->y + dy);
     }
 }
 
@@ -405,6 +412,7 @@ _gdk_x11_window_scroll (GdkWindow *window,
   GdkWindowImplX11 *impl;
   GdkWindowObject *obj;
   GdkRectangle src_rect, dest_rect;
+  GList *l;
   
   obj = GDK_WINDOW_OBJECT (window);
   impl = GDK_WINDOW_IMPL_X11 (obj->impl);  
@@ -439,25 +447,33 @@ _gdk_x11_window_scroll (GdkWindow *window,
       gdk_region_subtract (invalidate_region, tmp_region);
       gdk_region_destroy (tmp_region);
     }
-  
-  gdk_window_invalidate_region (window, invalidate_region, TRUE);
-  gdk_region_destroy (invalidate_region);
 
   /* We can guffaw scroll if we are a child window, and the parent
    * does not extend beyond our edges. Otherwise, we use XCopyArea, then
-   * move any children later
+   * move any children later. Client-side children have to be
+   * copied along, which the guffaw scroll doesn't do.
    */
   if (GDK_WINDOW_TYPE (window) == GDK_WINDOW_CHILD)
     {
       GdkWindowImplX11 *parent_impl = GDK_WINDOW_IMPL_X11 (obj->parent->impl);  
       can_guffaw_scroll = ((dx == 0 || (obj->x <= 0 && obj->x + impl->width >= parent_impl->width)) &&
 			   (dy == 0 || (obj->y <= 0 && obj->y + impl->height >= parent_impl->height)));
+
+      for (l = obj->children; l && can_guffaw_scroll; l = l->next)
+	if (GDK_WINDOW_IS_EMULATED (l->data))
+	  can_guffaw_scroll = FALSE;
     }
 
   if (!obj->children || !can_guffaw_scroll)
     gdk_window_copy_area_scroll (window, &dest_rect, dx, dy);
   else
     gdk_window_guffaw_scroll (window, dx, dy);
+
+  /* Invalidate after the children moved, so that the client-side
+   * ones get the parts that scrolled in.
+   */
+  gdk_window_invalidate_region (window, invalidate_region, TRUE);
+  gdk_region_destroy (invalidate_region);
 }
 
 void
@@ -545,6 +561,60 @@ _gdk_x11_window_move_region (GdkWindow       *window,
   gdk_region_destroy (dest_region);
 }
 
+/**
+ * _gdk_x11_window_copy_region:
+ * @window: a native #GdkWindow
+ * @region: destination region, in @window coordinates
+ * @dx: amount to move in the X direction
+ * @dy: amount to move in the Y direction
+ *
+ * Copies the contents of @window to @region from (@dx, @dy)
+ * away, for the client-side windows drawing to @window. The
+ * update area is left alone; parts of the source the X server
+ * doesn't have get exposed.
+ **/
+void
+_gdk_x11_window_copy_region (GdkWindow       *window,
+                             const GdkRegion *region,
+                             gint             dx,
+                             gint             dy)
+{
+  GdkWindowImplX11 *impl;
+  GdkRegion *src_region;
+  GdkRectangle dest_extents;
+  gint x_offset, y_offset;
+  GdkGC *gc;
+
+  if (GDK_WINDOW_DESTROYED (window) || gdk_region_empty (region))
+    return;
+
+  impl = GDK_WINDOW_IMPL_X11 (GDK_WINDOW_OBJECT (window)->impl);
+  x_offset = impl->position_info.x_offset;
+  y_offset = impl->position_info.y_offset;
+
+  src_region = gdk_region_copy (region);
+  gdk_region_offset (src_region, -dx, -dy);
+  gdk_window_queue_translation (window, src_region, dx, dy);
+  gdk_region_destroy (src_region);
+
+  gdk_region_get_clipbox (region, &dest_extents);
+
+  gc = _gdk_drawable_get_scratch_gc (window, TRUE);
+  gdk_gc_set_clip_region (gc, region);
+  gdk_gc_set_clip_origin (gc, - x_offset, - y_offset);
+
+  XCopyArea (GDK_WINDOW_XDISPLAY (window),
+	     GDK_WINDOW_XID (window),
+	     GDK_WINDOW_XID (window),
+	     gdk_x11_gc_get_xgc (gc),
+	     dest_extents.x - dx - x_offset, dest_extents.y - dy - y_offset,
+	     dest_extents.width, dest_extents.height,
+	     dest_extents.x - x_offset, dest_extents.y - y_offset);
+
+  /* Unset clip region of cached GC */
+  gdk_gc_set_clip_region (gc, NULL);
+}
+
 static void
 reset_backgrounds (GdkWindow *window)
 {
@@ -855,6 +925,10 @@ gdk_window_premove (GdkWindow          *window,
   gint d_xoffset, d_yoffset;
   GdkWindowParentPos this_pos;
 
+  /* Client-side windows have no X window to move */
+  if (GDK_WINDOW_IS_EMULATED (window))
+    return;
+
   obj = (GdkWindowObject *) window;
   impl = GDK_WINDOW_IMPL_X11 (obj->impl);
   
@@ -895,6 +969,9 @@ gdk_window_postmove (GdkWindow          *window,
   gint d_xoffset, d_yoffset;
   GdkWindowParentPos this_pos;
 
+  if (GDK_WINDOW_IS_EMULATED (window))
+    return;
+
   obj = (GdkWindowObject *) window;
   impl = GDK_WINDOW_IMPL_X11 (obj->impl);
   
@@ -935,15 +1012,18 @@ expose_serial_predicate (Display *xdisplay,
   return False;
 }
 
-/* Find oldest possible serial for an outstanding expose event
+/* Find oldest possible serial for an outstanding expose event.
+ * Events we haven't read yet can't be older than the last reply
+ * or event we did read, so this doesn't need to sync with the server.
  */
 static gulong
 find_current_serial (Display *xdisplay)
 {
   XEvent xev;
-  gulong serial = NextRequest (xdisplay);
+  gulong serial;
   
-  XSync (xdisplay, False);
+  XEventsQueued (xdisplay, QueuedAfterReading);
+  serial = LastKnownRequestProcessed (xdisplay);
 
   XCheckIfEvent (xdisplay, &xev, expose_serial_predicate, (XPointer)&serial);
 
@@ -1138,7 +1218,7 @@ _gdk_window_process_expose (GdkWindow    *window,
   gdk_region_intersect (invalidate_region, clip_region);
 
   if (!gdk_region_empty (invalidate_region))
-    gdk_window_invalidate_region (window, invalidate_region, FALSE);
+    _gdk_window_invalidate_for_expose (window, invalidate_region);
   
   gdk_region_destroy (invalidate_region);
   gdk_region_destroy (clip_region);
@@ -1177,7 +1257,7 @@ gdk_window_clip_changed (GdkWindow *window, GdkRectangle *old_clip, GdkRectangle
   if (!gdk_region_empty (new_clip_region))
     {
       _gdk_x11_window_tmp_unset_bg (window, FALSE);;
-      gdk_window_invalidate_region (window, new_clip_region, FALSE);
+      _gdk_window_invalidate_for_expose (window, new_clip_region);
     }
 
   if (obj->parent)
@@ -357,6 +357,10 @@ gdk_input_set_extension_events (GdkWindow *window, gint mask,
   if (mode == GDK_EXTENSION_EVENTS_NONE)
     mask = 0;
 
+  /* Extension events are selected on X windows */
+  if (mask != 0 && !gdk_window_ensure_native (window))
+    return;
+
   iw = _gdk_input_window_find (window);
 
   if (mask != 0)
@@ -207,13 +207,20 @@ gdk_pointer_grab (GdkWindow *	  window,
 
   cursor_private = (GdkCursorPrivate*) cursor;
   
-  xwindow = GDK_WINDOW_XID (window);
-  serial = NextRequest (GDK_WINDOW_XDISPLAY (window));
+  /* A client-side window grabs through its native window; GDK
+   * routes the grabbed events to it and translates them. The
+   * window system can only confine the pointer to the exact area
+   * of a native window, though.
+   */
+  xwindow = GDK_WINDOW_XID (_gdk_window_get_native (window));
   
-  if (!confine_to || GDK_WINDOW_DESTROYED (confine_to))
+  if (!confine_to || GDK_WINDOW_DESTROYED (confine_to) ||
+      !gdk_window_ensure_native (confine_to))
     xconfine_to = None;
   else
     xconfine_to = GDK_WINDOW_XID (confine_to);
+
+  serial = NextRequest (GDK_WINDOW_XDISPLAY (window));
   
   if (!cursor)
     xcursor = None;
@@ -116,6 +116,9 @@ GdkImage *_gdk_x11_copy_to_image       (GdkDrawable *drawable,
 					gint         width,
 					gint         height);
 Pixmap   _gdk_x11_image_get_shm_pixmap (GdkImage    *image);
+cairo_surface_t *_gdk_x11_window_create_cairo_surface (GdkWindow *window,
+						       gint       x_offset,
+						       gint       y_offset);
 
 /* Routines from gdkgeometry-x11.c */
 void _gdk_window_init_position     (GdkWindow     *window);
@@ -135,6 +138,10 @@ void _gdk_x11_window_move_region   (GdkWindow       *window,
                                     const GdkRegion *region,
                                     gint             dx,
                                     gint             dy);
+void _gdk_x11_window_copy_region   (GdkWindow       *window,
+                                    const GdkRegion *region,
+                                    gint             dx,
+                                    gint             dy);
 
 void     _gdk_selection_window_destroyed   (GdkWindow            *window);
 gboolean _gdk_selection_filter_clear_event (XSelectionClearEvent *event);
@@ -172,6 +179,16 @@ void _gdk_xgrab_check_button_event (GdkWindow *window,
 gboolean _gdk_x11_display_is_root_window (GdkDisplay *display,
 					  Window      xroot_window);
 
+void _gdk_x11_display_note_round_trip (GdkDisplay  *display,
+				       const gchar *request,
+				       const gchar *function);
+
+/* Put before requests that wait for a reply from the server, so
+ * that GDK_DEBUG=roundtrips can count them.
+ */
+#define GDK_X11_ROUND_TRIP(display, request) \
+  GDK_NOTE (ROUND_TRIPS, _gdk_x11_display_note_round_trip ((display), (request), G_STRFUNC))
+
 void _gdk_x11_precache_atoms (GdkDisplay          *display,
 			      const gchar * const *atom_names,
 			      gint                 n_atoms);
@@ -192,6 +209,10 @@ PangoRenderer *_gdk_x11_renderer_get (GdkDrawable *drawable,
 
 void _gdk_x11_cursor_update_theme (GdkCursor *cursor);
 
+void _gdk_x11_window_make_native  (GdkWindow *window,
+				   gint       width,
+				   gint       height);
+
 gboolean _gdk_x11_get_xft_setting (GdkScreen   *screen,
 				   const gchar *name,
 				   GValue      *value);
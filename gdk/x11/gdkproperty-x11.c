@@ -551,7 +551,7 @@ gdk_property_get (GdkWindow   *window,
       GDK_NOTE (MULTIHEAD, g_message ("gdk_property_get(): window is NULL\n"));
     }
 
-  if (GDK_WINDOW_DESTROYED (window))
+  if (GDK_WINDOW_DESTROYED (window) || !gdk_window_ensure_native (window))
     return FALSE;
 
   display = gdk_drawable_get_display (window);
@@ -688,7 +688,7 @@ gdk_property_change (GdkWindow    *window,
     }
 
 
-  if (GDK_WINDOW_DESTROYED (window))
+  if (GDK_WINDOW_DESTROYED (window) || !gdk_window_ensure_native (window))
     return;
 
   display = gdk_drawable_get_display (window);
@@ -737,7 +737,7 @@ gdk_property_delete (GdkWindow *window,
 		g_message ("gdk_property_delete(): window is NULL\n"));
     }
 
-  if (GDK_WINDOW_DESTROYED (window))
+  if (GDK_WINDOW_DESTROYED (window) || !gdk_window_ensure_native (window))
     return;
 
   XDeleteProperty (GDK_WINDOW_XDISPLAY (window), GDK_WINDOW_XWINDOW (window),
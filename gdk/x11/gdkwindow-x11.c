@@ -298,7 +298,11 @@ _gdk_x11_window_tmp_unset_bg (GdkWindow *window,
   
   private = (GdkWindowObject *)window;
 
+  /* Client-side windows have no X background to unset, and
+   * neither have their children.
+   */
   if (private->input_only || private->destroyed ||
+      GDK_WINDOW_IS_EMULATED (window) ||
       (private->window_type != GDK_WINDOW_ROOT &&
        !GDK_WINDOW_IS_MAPPED (window)))
     {
@@ -331,6 +335,7 @@ _gdk_x11_window_tmp_reset_bg (GdkWindow *window,
   private = (GdkWindowObject *)window;
 
   if (private->input_only || private->destroyed ||
+      GDK_WINDOW_IS_EMULATED (window) ||
       (private->window_type != GDK_WINDOW_ROOT &&
        !GDK_WINDOW_IS_MAPPED (window)))
     {
@@ -364,17 +369,18 @@ gdk_window_impl_x11_get_colormap (GdkDrawable *drawable)
   if (!((GdkWindowObject *) drawable_impl->wrapper)->input_only && 
       drawable_impl->colormap == NULL)
     {
-      XWindowAttributes window_attributes;
+      GdkWindowInfoX11 info;
       GdkVisual *visual;
+      gboolean result;
 
-      XGetWindowAttributes (GDK_SCREEN_XDISPLAY (drawable_impl->screen),
-                            drawable_impl->xid,
-                            &window_attributes);
+      gdk_error_trap_push ();
+      result = _gdk_x11_get_window_info (gdk_screen_get_display (drawable_impl->screen),
+					 drawable_impl->xid, &info);
+      if (gdk_error_trap_pop () || !result)
+	return NULL;
 
-      visual = gdk_x11_screen_lookup_visual (drawable_impl->screen,
-					     window_attributes.visual->visualid);
-      drawable_impl->colormap = gdk_x11_colormap_foreign_new (visual,
-							      window_attributes.colormap);
+      visual = gdk_x11_screen_lookup_visual (drawable_impl->screen, info.visual);
+      drawable_impl->colormap = gdk_x11_colormap_foreign_new (visual, info.colormap);
     }
   
   return drawable_impl->colormap;
@@ -952,6 +958,147 @@ _gdk_window_new (GdkWindow     *parent,
   return window;
 }
 
+/**
+ * _gdk_x11_window_make_native:
+ * @window: a client-side #GdkWindow
+ * @width: width of @window
+ * @height: height of @window
+ *
+ * Creates an X window for @window, which so far has been drawing
+ * to the X window of its parent, and gives @window an impl of
+ * its own. The parent of @window must have an X window.
+ **/
+void
+_gdk_x11_window_make_native (GdkWindow *window,
+			     gint       width,
+			     gint       height)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GdkWindowObject *parent = private->parent;
+  GdkWindowImplX11 *impl;
+  GdkDrawableImplX11 *draw_impl;
+  GdkDrawableImplX11 *old_draw_impl;
+  GdkScreenX11 *screen_x11;
+  GdkColormap *colormap;
+  XSetWindowAttributes xattributes;
+  long xattributes_mask;
+  Display *xdisplay;
+  Visual *xvisual;
+  GdkWindow *above;
+  unsigned int class;
+  int depth;
+  GList *l;
+  int i;
+
+  old_draw_impl = GDK_DRAWABLE_IMPL_X11 (private->impl);
+  screen_x11 = GDK_SCREEN_X11 (old_draw_impl->screen);
+  xdisplay = screen_x11->xdisplay;
+
+  if (private->input_only)
+    colormap = gdk_screen_get_system_colormap (old_draw_impl->screen);
+  else
+    colormap = gdk_drawable_get_colormap (window);
+
+  impl = g_object_new (_gdk_window_impl_get_type (), NULL);
+  draw_impl = GDK_DRAWABLE_IMPL_X11 (impl);
+  draw_impl->wrapper = GDK_DRAWABLE (window);
+  draw_impl->screen = old_draw_impl->screen;
+  draw_impl->colormap = g_object_ref (colormap);
+  impl->width = width;
+  impl->height = height;
+
+  /* The impl was shared with the parent */
+  g_object_unref (private->impl);
+  private->impl = GDK_DRAWABLE (impl);
+
+  _gdk_window_init_position (window);
+
+  xattributes_mask = CWEventMask;
+  xattributes.event_mask = StructureNotifyMask | PropertyChangeMask;
+  for (i = 0; i < _gdk_nenvent_masks; i++)
+    {
+      if (private->event_mask & (1 << (i + 1)))
+	xattributes.event_mask |= _gdk_event_mask_table[i];
+    }
+
+  if (parent->guffaw_gravity)
+    {
+      xattributes.win_gravity = StaticGravity;
+      xattributes_mask |= CWWinGravity;
+    }
+
+  if (!private->input_only)
+    {
+      class = InputOutput;
+      depth = private->depth;
+      xvisual = GDK_VISUAL_XVISUAL (gdk_colormap_get_visual (colormap));
+
+      if (private->bg_pixmap == NULL)
+	{
+	  xattributes.background_pixel = private->bg_color.pixel;
+	  xattributes_mask |= CWBackPixel;
+	}
+      else
+	{
+	  if (private->bg_pixmap == GDK_NO_BG)
+	    xattributes.background_pixmap = None;
+	  else if (private->bg_pixmap == GDK_PARENT_RELATIVE_BG)
+	    xattributes.background_pixmap = ParentRelative;
+	  else
+	    xattributes.background_pixmap = GDK_PIXMAP_XID (private->bg_pixmap);
+	  xattributes_mask |= CWBackPixmap;
+	}
+
+      xattributes.border_pixel = BlackPixel (xdisplay, screen_x11->screen_num);
+      xattributes_mask |= CWBorderPixel;
+
+      if (private->guffaw_gravity)
+	xattributes.bit_gravity = StaticGravity;
+      else
+	xattributes.bit_gravity = NorthWestGravity;
+      xattributes_mask |= CWBitGravity;
+
+      xattributes.colormap = GDK_COLORMAP_XCOLORMAP (colormap);
+      xattributes_mask |= CWColormap;
+    }
+  else
+    {
+      class = InputOnly;
+      depth = 0;
+      xvisual = CopyFromParent;
+    }
+
+  draw_impl->xid = XCreateWindow (xdisplay, GDK_WINDOW_XID (parent),
+				  impl->position_info.x, impl->position_info.y,
+				  impl->position_info.width, impl->position_info.height,
+				  0, depth, class, xvisual,
+				  xattributes_mask, &xattributes);
+
+  g_object_ref (window);
+  _gdk_xid_table_insert (screen_x11->display, &draw_impl->xid, window);
+
+  /* A new X window is on top of its siblings; put it right below
+   * the nearest native sibling above it. Client-side siblings live
+   * in the parent window, so they stay below either way.
+   */
+  above = NULL;
+  for (l = parent->children; l && l->data != window; l = l->next)
+    if (!GDK_WINDOW_IS_EMULATED (l->data) && !GDK_WINDOW_DESTROYED (l->data))
+      above = l->data;
+
+  if (above)
+    {
+      Window xwindows[2];
+
+      xwindows[0] = GDK_WINDOW_XID (above);
+      xwindows[1] = draw_impl->xid;
+      XRestackWindows (xdisplay, xwindows, 2);
+    }
+
+  if (GDK_WINDOW_IS_MAPPED (window) && impl->position_info.mapped)
+    XMapWindow (xdisplay, draw_impl->xid);
+}
+
 static GdkEventMask
 x_event_mask_to_gdk_event_mask (long mask)
 {
@@ -994,35 +1141,19 @@ gdk_window_foreign_new_for_display (GdkDisplay     *display,
   GdkWindowObject *private;
   GdkWindowImplX11 *impl;
   GdkDrawableImplX11 *draw_impl;
-  GdkDisplayX11 *display_x11;
-  XWindowAttributes attrs;
-  Window root, parent;
-  Window *children = NULL;
-  guint nchildren;
+  GdkWindowInfoX11 info;
   gboolean result;
 
   g_return_val_if_fail (GDK_IS_DISPLAY (display), NULL);
 
-  display_x11 = GDK_DISPLAY_X11 (display);
-
   if ((window = gdk_xid_table_lookup_for_display (display, anid)) != NULL)
     return g_object_ref (window);
 
   gdk_error_trap_push ();
-  result = XGetWindowAttributes (display_x11->xdisplay, anid, &attrs);
-  if (gdk_error_trap_pop () || !result)
-    return NULL;
-
-  /* FIXME: This is pretty expensive. Maybe the caller should supply
-   *        the parent */
-  gdk_error_trap_push ();
-  result = XQueryTree (display_x11->xdisplay, anid, &root, &parent, &children, &nchildren);
+  result = _gdk_x11_get_window_info (display, anid, &info);
   if (gdk_error_trap_pop () || !result)
     return NULL;
 
-  if (children)
-    XFree (children);
-  
   window = g_object_new (GDK_TYPE_WINDOW, NULL);
 
   private = (GdkWindowObject *) window;
@@ -1031,9 +1162,9 @@ gdk_window_foreign_new_for_display (GdkDisplay     *display,
   impl = GDK_WINDOW_IMPL_X11 (private->impl);
   draw_impl = GDK_DRAWABLE_IMPL_X11 (private->impl);
   draw_impl->wrapper = GDK_DRAWABLE (window);
-  draw_impl->screen = _gdk_x11_display_screen_for_xrootwin (display, root);
+  draw_impl->screen = _gdk_x11_display_screen_for_xrootwin (display, info.root);
   
-  private->parent = gdk_xid_table_lookup_for_display (display, parent);
+  private->parent = gdk_xid_table_lookup_for_display (display, info.parent);
   
   if (!private->parent || GDK_WINDOW_TYPE (private->parent) == GDK_WINDOW_FOREIGN)
     private->parent = (GdkWindowObject *) gdk_screen_get_root_window (draw_impl->screen);
@@ -1042,21 +1173,21 @@ gdk_window_foreign_new_for_display (GdkDisplay     *display,
 
   draw_impl->xid = anid;
 
-  private->x = attrs.x;
-  private->y = attrs.y;
-  impl->width = attrs.width;
-  impl->height = attrs.height;
+  private->x = info.x;
+  private->y = info.y;
+  impl->width = info.width;
+  impl->height = info.height;
   private->window_type = GDK_WINDOW_FOREIGN;
   private->destroyed = FALSE;
 
-  private->event_mask = x_event_mask_to_gdk_event_mask (attrs.your_event_mask);
+  private->event_mask = x_event_mask_to_gdk_event_mask (info.your_event_mask);
 
-  if (attrs.map_state == IsUnmapped)
+  if (!info.is_mapped)
     private->state = GDK_WINDOW_STATE_WITHDRAWN;
   else
     private->state = 0;
 
-  private->depth = attrs.depth;
+  private->depth = info.depth;
   
   _gdk_window_init_position (GDK_WINDOW (private));
 
@@ -1908,6 +2039,7 @@ move_to_current_desktop (GdkWindow *window)
       /* Get current desktop, then set it; this is a race, but not
        * one that matters much in practice.
        */
+      GDK_X11_ROUND_TRIP (display, "GetProperty");
       XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), 
                           GDK_WINDOW_XROOTWIN (window),
 			  gdk_x11_get_xatom_by_name_for_display (display, "_NET_CURRENT_DESKTOP"),
@@ -2179,6 +2311,7 @@ gdk_window_get_type_hint (GdkWindow *window)
 
   display = gdk_drawable_get_display (window);
 
+  GDK_X11_ROUND_TRIP (display, "GetProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
                           gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_WINDOW_TYPE"),
                           0, G_MAXLONG, False, XA_ATOM, &type_return,
@@ -2950,6 +3083,7 @@ gdk_window_x11_get_geometry (GdkWindow *window,
   
   if (!GDK_WINDOW_DESTROYED (window))
     {
+      GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "GetGeometry");
       XGetGeometry (GDK_WINDOW_XDISPLAY (window),
 		    GDK_WINDOW_XID (window),
 		    &root, &tx, &ty, &twidth, &theight, &tborder_width, &tdepth);
@@ -2979,6 +3113,7 @@ gdk_window_x11_get_origin (GdkWindow *window,
   
   if (!GDK_WINDOW_DESTROYED (window))
     {
+      GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "TranslateCoords");
       return_val = XTranslateCoordinates (GDK_WINDOW_XDISPLAY (window),
 					  GDK_WINDOW_XID (window),
 					  GDK_WINDOW_XROOTWIN (window),
@@ -3034,9 +3169,13 @@ gdk_window_get_deskrelative_origin (GdkWindow *window,
 						    "ENLIGHTENMENT_DESKTOP");
       win = GDK_WINDOW_XID (window);
       
-      while (XQueryTree (GDK_WINDOW_XDISPLAY (window), win, &root, &parent,
-			 &child, (unsigned int *)&num_children))
+      while (TRUE)
 	{
+	  GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "QueryTree");
+	  if (!XQueryTree (GDK_WINDOW_XDISPLAY (window), win, &root, &parent,
+			   &child, (unsigned int *)&num_children))
+	    break;
+
 	  if ((child) && (num_children > 0))
 	    XFree (child);
 	  
@@ -3049,6 +3188,7 @@ gdk_window_get_deskrelative_origin (GdkWindow *window,
 	    break;
 	  
 	  data_return = NULL;
+	  GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "GetProperty");
 	  XGetWindowProperty (GDK_WINDOW_XDISPLAY (window), win, atom, 0, 0,
 			      False, XA_CARDINAL, &type_return, &format_return,
 			      &number_return, &bytes_after_return, &data_return);
@@ -3060,6 +3200,7 @@ gdk_window_get_deskrelative_origin (GdkWindow *window,
 	    }
 	}
       
+      GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "TranslateCoords");
       return_val = XTranslateCoordinates (GDK_WINDOW_XDISPLAY (window),
 					  GDK_WINDOW_XID (window),
 					  win,
@@ -3124,11 +3265,10 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   Window xparent;
   Window root;
   Window child;
-  Window *children;
   guchar *data;
   Window *vroots;
   Atom type_return;
-  guint nchildren;
+  GdkWindowInfoX11 info;
   guint nvroots;
   gulong nitems_return;
   gulong bytes_after_return;
@@ -3171,6 +3311,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   xwindow = GDK_WINDOW_XID (window);
 
   /* first try: use _NET_FRAME_EXTENTS */
+  GDK_X11_ROUND_TRIP (display, "GetProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xwindow,
 			  gdk_x11_get_xatom_by_name_for_display (display,
 								 "_NET_FRAME_EXTENTS"),
@@ -3186,6 +3327,8 @@ gdk_window_get_frame_extents (GdkWindow    *window,
 	  got_frame_extents = TRUE;
 
 	  /* try to get the real client window geometry */
+	  GDK_X11_ROUND_TRIP (display, "GetGeometry");
+	  GDK_X11_ROUND_TRIP (display, "TranslateCoords");
 	  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow,
 			    &root, &wx, &wy, &ww, &wh, &wb, &wd) &&
               XTranslateCoordinates (GDK_DISPLAY_XDISPLAY (display),
@@ -3218,6 +3361,7 @@ gdk_window_get_frame_extents (GdkWindow    *window,
   /* use NETWM_VIRTUAL_ROOTS if available */
   root = GDK_WINDOW_XROOTWIN (window);
 
+  GDK_X11_ROUND_TRIP (display, "GetProperty");
   if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), root,
 			  gdk_x11_get_xatom_by_name_for_display (display, 
 								 "_NET_VIRTUAL_ROOTS"),
@@ -3235,17 +3379,18 @@ gdk_window_get_frame_extents (GdkWindow    *window,
 
   xparent = GDK_WINDOW_XID (window);
 
+  /* The geometry comes with the parent, so the frame's geometry
+   * is known once the walk up the tree reaches it.
+   */
   do
     {
       xwindow = xparent;
 
-      if (!XQueryTree (GDK_DISPLAY_XDISPLAY (display), xwindow,
-		       &root, &xparent,
-		       &children, &nchildren))
+      if (!_gdk_x11_get_window_info (display, xwindow, &info))
 	goto out;
-      
-      if (children)
-	XFree (children);
+
+      root = info.root;
+      xparent = info.parent;
 
       /* check virtual roots */
       for (i = 0; i < nvroots; i++)
@@ -3259,14 +3404,10 @@ gdk_window_get_frame_extents (GdkWindow    *window,
     }
   while (xparent != root);
   
-  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow, 
-		    &root, &wx, &wy, &ww, &wh, &wb, &wd))
-    {
-      rect->x = wx;
-      rect->y = wy;
-      rect->width = ww;
-      rect->height = wh;
-    }
+  rect->x = info.x;
+  rect->y = info.y;
+  rect->width = info.width;
+  rect->height = info.height;
 
  out:
   if (vroots)
@@ -3302,6 +3443,7 @@ _gdk_windowing_get_pointer (GdkDisplay       *display,
   
   if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client)) 
     {
+      GDK_X11_ROUND_TRIP (display, "QueryPointer");
       XQueryPointer (xdisplay, xwindow,
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
     } 
@@ -3313,6 +3455,7 @@ _gdk_windowing_get_pointer (GdkDisplay       *display,
       w = XCreateWindow (xdisplay, xwindow, 0, 0, 1, 1, 0, 
 			 CopyFromParent, InputOnly, CopyFromParent, 
 			 0, &attributes);
+      GDK_X11_ROUND_TRIP (display, "QueryPointer");
       XQueryPointer (xdisplay, w, 
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
       XDestroyWindow (xdisplay, w);
@@ -3354,6 +3497,7 @@ _gdk_windowing_window_get_pointer (GdkDisplay      *display,
     {
       if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client)) 
 	{
+	  GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "QueryPointer");
 	  if (XQueryPointer (GDK_WINDOW_XDISPLAY (window),
 			     GDK_WINDOW_XID (window),
 			     &root, &child, &rootx, &rooty, &winx, &winy, &xmask))
@@ -3446,6 +3590,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
   gdk_x11_display_grab (display);
   if (G_LIKELY (GDK_DISPLAY_X11 (display)->trusted_client)) 
     {
+      GDK_X11_ROUND_TRIP (display, "QueryPointer");
       XQueryPointer (xdisplay, xwindow,
 		     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
       if (root == xwindow)
@@ -3456,6 +3601,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
       while (xwindow)
 	{
 	  xwindow_last = xwindow;
+	  GDK_X11_ROUND_TRIP (display, "QueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &xwindow, &rootx, &rooty, &winx, &winy, &xmask);
 	}
@@ -3475,6 +3621,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 	  window = GDK_WINDOW (list->data);
 	  xwindow = GDK_WINDOW_XWINDOW (window);
 	  gdk_error_trap_push ();
+	  GDK_X11_ROUND_TRIP (display, "QueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
 	  gdk_flush ();
@@ -3496,6 +3643,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 				 CopyFromParent, InputOnly, CopyFromParent, 
 				 0, &attributes);
 	      XMapWindow (xdisplay, w);
+	      GDK_X11_ROUND_TRIP (display, "QueryPointer");
 	      XQueryPointer (xdisplay, xwindow, 
 			     &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
 	      XDestroyWindow (xdisplay, w);
@@ -3516,6 +3664,7 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 	{
 	  xwindow_last = xwindow;
 	  gdk_error_trap_push ();
+	  GDK_X11_ROUND_TRIP (display, "QueryPointer");
 	  XQueryPointer (xdisplay, xwindow,
 			 &root, &xwindow, &rootx, &rooty, &winx, &winy, &xmask);
 	  gdk_flush ();
@@ -3536,18 +3685,18 @@ _gdk_windowing_window_at_pointer (GdkDisplay *display,
 static GdkEventMask
 gdk_window_x11_get_events (GdkWindow *window)
 {
-  XWindowAttributes attrs;
+  GdkWindowInfoX11 info;
   GdkEventMask event_mask;
 
   if (GDK_WINDOW_DESTROYED (window))
     return 0;
   else
     {
-      XGetWindowAttributes (GDK_WINDOW_XDISPLAY (window),
-			    GDK_WINDOW_XID (window), 
-			    &attrs);
+      if (!_gdk_x11_get_window_info (GDK_WINDOW_DISPLAY (window),
+				     GDK_WINDOW_XID (window), &info))
+	return GDK_WINDOW_OBJECT (window)->event_mask;
       
-      event_mask = x_event_mask_to_gdk_event_mask (attrs.your_event_mask);
+      event_mask = x_event_mask_to_gdk_event_mask (info.your_event_mask);
       GDK_WINDOW_OBJECT (window)->event_mask = event_mask;
   
       return event_mask;
@@ -3640,7 +3789,12 @@ do_shape_combine_mask (GdkWindow *window,
   gint xoffset, yoffset;
   
 #ifdef HAVE_SHAPE_EXT
-  if (GDK_WINDOW_DESTROYED (window))
+  /* Client-side windows need an X window to shape; without a
+   * shape, they are rectangular already.
+   */
+  if (GDK_WINDOW_DESTROYED (window) ||
+      (GDK_WINDOW_IS_EMULATED (window) &&
+       (mask == NULL || !gdk_window_ensure_native (window))))
     return;
 
   _gdk_x11_window_get_offsets (window, &xoffset, &yoffset);
@@ -3738,7 +3892,12 @@ do_shape_combine_region (GdkWindow       *window,
   gint xoffset, yoffset;
   
 #ifdef HAVE_SHAPE_EXT
-  if (GDK_WINDOW_DESTROYED (window))
+  /* Client-side windows need an X window to shape; without a
+   * shape, they are rectangular already.
+   */
+  if (GDK_WINDOW_DESTROYED (window) ||
+      (GDK_WINDOW_IS_EMULATED (window) &&
+       (shape_region == NULL || !gdk_window_ensure_native (window))))
     return;
 
   _gdk_x11_window_get_offsets (window, &xoffset, &yoffset);
@@ -4713,6 +4872,7 @@ gdk_window_get_mwm_hints (GdkWindow *window)
   
   hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
 
+  GDK_X11_ROUND_TRIP (display, "GetProperty");
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
 		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
 		      False, AnyPropertyType, &type, &format, &nitems,
@@ -4744,6 +4904,7 @@ gdk_window_set_mwm_hints (GdkWindow *window,
   
   hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
 
+  GDK_X11_ROUND_TRIP (GDK_WINDOW_DISPLAY (window), "GetProperty");
   XGetWindowProperty (GDK_WINDOW_XDISPLAY (window), GDK_WINDOW_XID (window),
 		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
 		      False, AnyPropertyType, &type, &format, &nitems,
@@ -5039,6 +5200,7 @@ gdk_add_rectangles (Display           *disp,
   gint rn, ord;
   XRectangle *rl;
   
+  GDK_X11_ROUND_TRIP (gdk_x11_lookup_xdisplay (disp), "ShapeGetRectangles");
   rl = XShapeGetRectangles (disp, win, ShapeBounding, &rn, &ord);
   if (rl)
     {
@@ -5074,15 +5236,18 @@ gdk_propagate_shapes (Display *disp,
 		      gboolean merge,
 		      int      shape)
 {
-  Window              rt, par, *list = NULL;
-  gint                i, j, num = 0, num_rects = 0;
+  GdkDisplay         *display = gdk_x11_lookup_xdisplay (disp);
+  Window              rt;
+  GdkChildInfoX11    *list = NULL;
+  guint               num = 0;
+  gint                i, j, num_rects = 0;
   gint                x, y, contig;
   guint               w, h, d;
   gint                baseh, basew;
   XRectangle         *rects = NULL;
   struct _gdk_span  **spans = NULL, *ptr1, *ptr2, *ptr3;
-  XWindowAttributes   xatt;
   
+  GDK_X11_ROUND_TRIP (display, "GetGeometry");
   XGetGeometry (disp, win, &rt, &x, &y, &w, &h, &d, &d);
   if (h <= 0)
     return;
@@ -5092,15 +5257,19 @@ gdk_propagate_shapes (Display *disp,
   
   for (i = 0; i < h; i++)
     spans[i] = NULL;
-  XQueryTree (disp, win, &rt, &par, &list, (unsigned int *)&num);
+  /* fetches the attributes and geometry of all children at once */
+  _gdk_x11_get_window_child_info (display, win, FALSE, NULL, &list, &num);
   if (list)
     {
       /* go through all child windows and create/insert spans */
       for (i = 0; i < num; i++)
 	{
-	  if (XGetWindowAttributes (disp, list[i], &xatt) && (xatt.map_state != IsUnmapped))
-	    if (XGetGeometry (disp, list[i], &rt, &x, &y, &w, &h, &d, &d))
-	      gdk_add_rectangles (disp, list[i], spans, basew, baseh, x, y);
+	  if (list[i].is_mapped)
+	    {
+	      x = list[i].x;
+	      y = list[i].y;
+	      gdk_add_rectangles (disp, list[i].window, spans, basew, baseh, x, y);
+	    }
 	}
       if (merge)
 	gdk_add_rectangles (disp, win, spans, basew, baseh, x, y);
@@ -5181,7 +5350,7 @@ gdk_propagate_shapes (Display *disp,
 				   ShapeSet, YXSorted);
 	  g_free (rects);
 	}
-      XFree (list);
+      g_free (list);
     }
   /* free up all the spans we made */
   for (i = 0; i < baseh; i++)
@@ -5197,6 +5366,23 @@ gdk_propagate_shapes (Display *disp,
   g_free (spans);
 }
 
+/* The shapes of the children come from the X server, so the
+ * window and its children need X windows.
+ */
+static gboolean
+ensure_native_children (GdkWindow *window)
+{
+  GList *tmp_list;
+
+  if (!gdk_window_ensure_native (window))
+    return FALSE;
+
+  for (tmp_list = GDK_WINDOW_OBJECT (window)->children; tmp_list; tmp_list = tmp_list->next)
+    gdk_window_ensure_native (tmp_list->data);
+
+  return TRUE;
+}
+
 #endif /* HAVE_SHAPE_EXT */
 
 static inline void
@@ -5205,7 +5391,8 @@ do_child_shapes (GdkWindow *window,
 {
 #ifdef HAVE_SHAPE_EXT
   if (!GDK_WINDOW_DESTROYED (window) &&
-      gdk_display_supports_shapes (GDK_WINDOW_DISPLAY (window)))
+      gdk_display_supports_shapes (GDK_WINDOW_DISPLAY (window)) &&
+      ensure_native_children (window))
     {
       gdk_propagate_shapes (GDK_WINDOW_XDISPLAY (window),
                             GDK_WINDOW_XID (window),
@@ -5233,7 +5420,8 @@ do_child_input_shapes (GdkWindow *window,
 {
 #if defined(HAVE_SHAPE_EXT) && defined(ShapeInput)
   if (!GDK_WINDOW_DESTROYED (window) &&
-      gdk_display_supports_shapes (GDK_WINDOW_DISPLAY (window)))
+      gdk_display_supports_shapes (GDK_WINDOW_DISPLAY (window)) &&
+      ensure_native_children (window))
     {
       gdk_propagate_shapes (GDK_WINDOW_XDISPLAY (window),
                             GDK_WINDOW_XID (window),
@@ -5342,7 +5530,8 @@ gdk_window_x11_set_static_gravities (GdkWindow *window,
       tmp_list = private->children;
       while (tmp_list)
 	{
-	  gdk_window_set_static_win_gravity (tmp_list->data, use_static);
+	  if (!GDK_WINDOW_IS_EMULATED (tmp_list->data))
+	    gdk_window_set_static_win_gravity (tmp_list->data, use_static);
 	  
 	  tmp_list = tmp_list->next;
 	}
@@ -117,6 +117,7 @@
 #include <gtk/gtklinkbutton.h>
 #include <gtk/gtkliststore.h>
 #include <gtk/gtkmain.h>
+#include <gtk/gtkmemoryaudit.h>
 #include <gtk/gtkmenu.h>
 #include <gtk/gtkmenubar.h>
 #include <gtk/gtkmenuitem.h>
@@ -32,6 +32,7 @@
 
 #include "gtkaccellabel.h"
 #include "gtkaccelmap.h"
+#include "gtklayoutcache.h"
 #include "gtkmain.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
@@ -253,6 +254,27 @@ gtk_accel_label_get_accel_width (GtkAccelLabel *accel_label)
 	  (accel_label->accel_string_width ? accel_label->accel_padding : 0));
 }
 
+/* Menus show the same few accelerator strings over and over,
+ * so share their layouts through the layout cache.
+ */
+static PangoLayout *
+gtk_accel_label_get_accel_layout (GtkAccelLabel *accel_label)
+{
+  GtkWidget *widget = GTK_WIDGET (accel_label);
+  const gchar *accel_string;
+  GtkLayoutCacheKey key;
+  PangoLayout *layout;
+
+  accel_string = gtk_accel_label_get_string (accel_label);
+
+  _gtk_layout_cache_key_init (&key, accel_string);
+  layout = _gtk_layout_cache_lookup (widget, &key);
+  if (!layout)
+    layout = gtk_widget_create_pango_layout (widget, accel_string);
+
+  return layout;
+}
+
 static void
 gtk_accel_label_size_request (GtkWidget	     *widget,
 			      GtkRequisition *requisition)
@@ -263,7 +285,7 @@ gtk_accel_label_size_request (GtkWidget	     *widget,
 
   GTK_WIDGET_CLASS (gtk_accel_label_parent_class)->size_request (widget, requisition);
 
-  layout = gtk_widget_create_pango_layout (widget, gtk_accel_label_get_string (accel_label));
+  layout = gtk_accel_label_get_accel_layout (accel_label);
   pango_layout_get_pixel_size (layout, &width, NULL);
   accel_label->accel_string_width = width;
   
@@ -308,7 +330,11 @@ gtk_accel_label_expose_event (GtkWidget      *widget,
 	  gint x;
 	  gint y;
 	  
-	  label_layout = gtk_label_get_layout (GTK_LABEL (accel_label));
+	  /* Only an ellipsized layout needs to be changed below */
+	  if (gtk_label_get_ellipsize (label))
+	    label_layout = gtk_label_get_layout (label);
+	  else
+	    label_layout = _gtk_label_peek_layout (label);
 
 	  if (direction == GTK_TEXT_DIR_RTL)
 	    widget->allocation.x += ac_width;
@@ -335,7 +361,7 @@ gtk_accel_label_expose_event (GtkWidget      *widget,
 
 	  gtk_label_get_layout_offsets (GTK_LABEL (accel_label), NULL, &y);
 
-	  accel_layout = gtk_widget_create_pango_layout (widget, gtk_accel_label_get_string (accel_label));
+	  accel_layout = gtk_accel_label_get_accel_layout (accel_label);
 
 	  y += get_first_baseline (label_layout) - get_first_baseline (accel_layout);
 
@@ -28,6 +28,7 @@
 #include "gtkbuilder.h"
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
+#include "gtkalignment.h"
 #include "gtkmain.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
@@ -50,12 +51,23 @@ static void gtk_builder_get_property   (GObject         *object,
                                         GParamSpec      *pspec);
 static GType gtk_builder_real_get_type_from_name (GtkBuilder  *builder,
                                                   const gchar *type_name);
+static void placeholder_map                 (GtkWidget             *placeholder,
+                                             GtkBuilder            *builder);
+static void gtk_builder_connect_signal_list (GtkBuilder            *builder,
+                                             GSList                *signals,
+                                             GtkBuilderConnectFunc  func,
+                                             gpointer               user_data);
 
 enum {
   PROP_0,
   PROP_TRANSLATION_DOMAIN,
 };
 
+typedef struct {
+  GModule *module;
+  gpointer data;
+} connect_args;
+
 struct _GtkBuilderPrivate
 {
   gchar *domain;
@@ -63,8 +75,43 @@ struct _GtkBuilderPrivate
   GSList *delayed_properties;
   GSList *signals;
   gchar *filename;
+
+  GSList *lazy_objects;
+  GHashTable *lazy_ids;
+  GtkBuilderConnectFunc connect_func;
+  gpointer connect_data;
+  connect_args *connect_args;
 };
 
+/* The recorded markup of an object with a lazy attribute, see
+ * _gtk_builder_add_lazy()
+ */
+typedef struct
+{
+  gchar *filename;
+  gchar *path;
+  GtkBuilderCache *cache;
+  GSList *ids;
+  GtkWidget *placeholder;
+} LazyObject;
+
+static void
+lazy_object_free (LazyObject *lazy)
+{
+  if (lazy->placeholder)
+    {
+      g_object_set_data (G_OBJECT (lazy->placeholder),
+                         I_("gtk-builder-lazy"), NULL);
+      g_object_unref (lazy->placeholder);
+    }
+  _gtk_builder_cache_unref (lazy->cache);
+  g_slist_foreach (lazy->ids, (GFunc) g_free, NULL);
+  g_slist_free (lazy->ids);
+  g_free (lazy->filename);
+  g_free (lazy->path);
+  g_slice_free (LazyObject, lazy);
+}
+
 G_DEFINE_TYPE (GtkBuilder, gtk_builder, G_TYPE_OBJECT)
 
 static void
@@ -128,6 +175,17 @@ gtk_builder_finalize (GObject *object)
 
   g_slist_foreach (priv->signals, (GFunc) _free_signal_info, NULL);
   g_slist_free (priv->signals);
+
+  g_slist_foreach (priv->lazy_objects, (GFunc) lazy_object_free, NULL);
+  g_slist_free (priv->lazy_objects);
+  if (priv->lazy_ids)
+    g_hash_table_destroy (priv->lazy_ids);
+
+  if (priv->connect_args)
+    {
+      g_module_close (priv->connect_args->module);
+      g_slice_free (connect_args, priv->connect_args);
+    }
   
   G_OBJECT_CLASS (gtk_builder_parent_class)->finalize (object);
 }
@@ -559,6 +617,172 @@ _gtk_builder_add_signals (GtkBuilder *builder,
                                            g_slist_copy (signals));
 }
 
+static void
+gtk_builder_construct_lazy (GtkBuilder *builder,
+                            LazyObject *lazy)
+{
+  GtkBuilderPrivate *priv = builder->priv;
+  GSList *l, *signals, *old_signals, *old_properties;
+  gchar *old_filename, *old_domain;
+  GObject *object;
+  GError *error = NULL;
+
+  /* Disconnecting from the placeholder may drop the last reference */
+  g_object_ref (builder);
+
+  priv->lazy_objects = g_slist_remove (priv->lazy_objects, lazy);
+  for (l = lazy->ids; l; l = l->next)
+    if (g_hash_table_lookup (priv->lazy_ids, l->data) == lazy)
+      g_hash_table_remove (priv->lazy_ids, l->data);
+
+  GTK_NOTE (BUILDER, g_print ("constructing lazy object %s\n",
+                              (gchar *) lazy->ids->data));
+
+  /* Replay the markup in the state the builder had when it was
+   * recorded. This may happen in the middle of parsing another
+   * file, so keep the signals and properties of that apart
+   */
+  old_filename = priv->filename;
+  old_domain = priv->domain;
+  old_signals = priv->signals;
+  old_properties = priv->delayed_properties;
+  priv->filename = lazy->path;
+  priv->domain = NULL;
+  priv->signals = NULL;
+  priv->delayed_properties = NULL;
+
+  _gtk_builder_parser_parse_cache (builder, lazy->filename, lazy->cache,
+                                   &error);
+
+  signals = priv->signals;
+  g_free (priv->domain);
+  priv->filename = old_filename;
+  priv->domain = old_domain;
+  priv->signals = old_signals;
+  priv->delayed_properties = g_slist_concat (priv->delayed_properties,
+                                             old_properties);
+
+  if (error)
+    {
+      g_warning ("Failed to construct lazy object %s: %s",
+                 (gchar *) lazy->ids->data, error->message);
+      g_error_free (error);
+    }
+
+  if (priv->connect_func)
+    gtk_builder_connect_signal_list (builder, g_slist_reverse (signals),
+                                     priv->connect_func, priv->connect_data);
+  else
+    priv->signals = g_slist_concat (priv->signals, signals);
+
+  if (lazy->placeholder)
+    {
+      g_signal_handlers_disconnect_by_func (lazy->placeholder,
+                                            placeholder_map, builder);
+
+      object = g_hash_table_lookup (priv->objects, lazy->ids->data);
+      if (GTK_IS_WIDGET (object) && !GTK_WIDGET (object)->parent)
+        {
+          gtk_container_add (GTK_CONTAINER (lazy->placeholder),
+                             GTK_WIDGET (object));
+          if (!GTK_WIDGET_VISIBLE (object))
+            gtk_widget_hide (lazy->placeholder);
+        }
+    }
+
+  lazy_object_free (lazy);
+
+  g_object_unref (builder);
+}
+
+static void
+placeholder_map (GtkWidget  *placeholder,
+                 GtkBuilder *builder)
+{
+  LazyObject *lazy;
+
+  lazy = g_object_get_data (G_OBJECT (placeholder), "gtk-builder-lazy");
+  if (lazy)
+    gtk_builder_construct_lazy (builder, lazy);
+}
+
+/*
+ * _gtk_builder_add_lazy:
+ * @builder: a #GtkBuilder
+ * @filename: the name of the file the markup comes from, for errors
+ * @cache: the recorded markup of the object and its children
+ * @ids: the ids of the objects in @cache, starting with the object
+ * @placeholder: whether the object is a child of another object
+ *
+ * Registers an object whose construction is deferred until it is
+ * asked for with gtk_builder_get_object() or referred to from another
+ * object. A child is replaced by a placeholder widget in its parent,
+ * and is constructed and put into the placeholder when the placeholder
+ * is mapped. The placeholder keeps the builder alive until then.
+ *
+ * Returns: the placeholder, or %NULL
+ */
+GObject *
+_gtk_builder_add_lazy (GtkBuilder      *builder,
+                       const gchar     *filename,
+                       GtkBuilderCache *cache,
+                       GSList          *ids,
+                       gboolean         placeholder)
+{
+  GtkBuilderPrivate *priv = builder->priv;
+  LazyObject *lazy;
+  GSList *l;
+
+  lazy = g_slice_new0 (LazyObject);
+  lazy->filename = g_strdup (filename);
+  lazy->path = g_strdup (priv->filename);
+  lazy->cache = _gtk_builder_cache_ref (cache);
+  lazy->ids = ids;
+
+  if (!priv->lazy_ids)
+    priv->lazy_ids = g_hash_table_new (g_str_hash, g_str_equal);
+
+  priv->lazy_objects = g_slist_prepend (priv->lazy_objects, lazy);
+  for (l = ids; l; l = l->next)
+    g_hash_table_insert (priv->lazy_ids, l->data, lazy);
+
+  GTK_NOTE (BUILDER, g_print ("deferring construction of %s\n",
+                              (gchar *) ids->data));
+
+  if (!placeholder)
+    return NULL;
+
+  lazy->placeholder = g_object_new (GTK_TYPE_ALIGNMENT,
+                                    "visible", TRUE,
+                                    NULL);
+  g_object_ref_sink (lazy->placeholder);
+  g_object_set_data (G_OBJECT (lazy->placeholder),
+                     I_("gtk-builder-lazy"), lazy);
+  g_signal_connect_data (lazy->placeholder, "map",
+                         G_CALLBACK (placeholder_map),
+                         g_object_ref (builder),
+                         (GClosureNotify) g_object_unref, 0);
+
+  return G_OBJECT (lazy->placeholder);
+}
+
+/* Looks up an object by name, constructing it first if it is lazy */
+static GObject *
+gtk_builder_lookup_object (GtkBuilder  *builder,
+                           const gchar *name)
+{
+  LazyObject *lazy;
+
+  if (builder->priv->lazy_ids)
+    {
+      lazy = g_hash_table_lookup (builder->priv->lazy_ids, name);
+      if (lazy)
+        gtk_builder_construct_lazy (builder, lazy);
+    }
+
+  return g_hash_table_lookup (builder->priv->objects, name);
+}
+
 static void
 gtk_builder_apply_delayed_properties (GtkBuilder *builder)
 {
@@ -598,7 +822,7 @@ gtk_builder_apply_delayed_properties (GtkBuilder *builder)
         {
           GObject *obj;
 
-          obj = g_hash_table_lookup (builder->priv->objects, property->value);
+          obj = gtk_builder_lookup_object (builder, property->value);
           if (!obj)
             g_warning ("No object called: %s", property->value);
           else
@@ -642,6 +866,12 @@ gtk_builder_new (void)
  *
  * Parses a file containing a <link linkend="BUILDER-UI">GtkBuilder 
  * UI definition</link> and merges it with the current contents of @builder. 
+ *
+ * A file is only parsed the first time it is added to a builder; as long
+ * as it isn't modified, later calls reuse the result. If a cache created
+ * with <link linkend="gtk-update-builder-cache">gtk-update-builder-cache</link>
+ * is found next to the file, it is used instead of parsing the file. 
+ * @filename can also be the name of such a cache.
  * 
  * Returns: A positive value on success, 0 if an error occurred
  *
@@ -652,8 +882,6 @@ gtk_builder_add_from_file (GtkBuilder   *builder,
                            const gchar  *filename,
                            GError      **error)
 {
-  gchar *buffer;
-  gsize length;
   GError *tmp_error;
 
   g_return_val_if_fail (GTK_IS_BUILDER (builder), 0);
@@ -662,21 +890,12 @@ gtk_builder_add_from_file (GtkBuilder   *builder,
 
   tmp_error = NULL;
 
-  if (!g_file_get_contents (filename, &buffer, &length, &tmp_error))
-    {
-      g_propagate_error (error, tmp_error);
-      return 0;
-    }
-  
   g_free (builder->priv->filename);
   builder->priv->filename = g_strdup (filename);
 
-  _gtk_builder_parser_parse_buffer (builder, filename,
-                                    buffer, length,
-                                    NULL,
-                                    &tmp_error);
-
-  g_free (buffer);
+  _gtk_builder_parser_parse_file (builder, filename,
+                                  NULL,
+                                  &tmp_error);
 
   if (tmp_error != NULL)
     {
@@ -714,8 +933,6 @@ gtk_builder_add_objects_from_file (GtkBuilder   *builder,
                                    gchar       **object_ids,
                                    GError      **error)
 {
-  gchar *buffer;
-  gsize length;
   GError *tmp_error;
 
   g_return_val_if_fail (GTK_IS_BUILDER (builder), 0);
@@ -725,21 +942,12 @@ gtk_builder_add_objects_from_file (GtkBuilder   *builder,
 
   tmp_error = NULL;
 
-  if (!g_file_get_contents (filename, &buffer, &length, &tmp_error))
-    {
-      g_propagate_error (error, tmp_error);
-      return 0;
-    }
-  
   g_free (builder->priv->filename);
   builder->priv->filename = g_strdup (filename);
 
-  _gtk_builder_parser_parse_buffer (builder, filename,
-                                    buffer, length,
-                                    object_ids,
-                                    &tmp_error);
-
-  g_free (buffer);
+  _gtk_builder_parser_parse_file (builder, filename,
+                                  object_ids,
+                                  &tmp_error);
 
   if (tmp_error != NULL)
     {
@@ -857,6 +1065,10 @@ gtk_builder_add_objects_from_string (GtkBuilder   *builder,
  * Gets the object named @name. Note that this function does not
  * increment the reference count of the returned object. 
  *
+ * If the object is part of an object with the "lazy" attribute that
+ * hasn't been constructed yet, that object and its children are
+ * constructed first.
+ *
  * Return value: the object named @name or %NULL if it could not be 
  *    found in the object tree. 
  *
@@ -869,7 +1081,7 @@ gtk_builder_get_object (GtkBuilder  *builder,
   g_return_val_if_fail (GTK_IS_BUILDER (builder), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (builder->priv->objects, name);
+  return gtk_builder_lookup_object (builder, name);
 }
 
 static void
@@ -886,7 +1098,8 @@ object_add_to_list (gchar    *object_id,
  *
  * Gets all objects that have been constructed by @builder. Note that 
  * this function does not increment the reference counts of the returned
- * objects.
+ * objects. Objects with the "lazy" attribute are only included once
+ * they have been constructed.
  *
  * Return value: a newly-allocated #GSList containing all the objects
  *   constructed by the #GtkBuilder instance. It should be freed by
@@ -950,11 +1163,6 @@ gtk_builder_get_translation_domain (GtkBuilder *builder)
   return builder->priv->domain;
 }
 
-typedef struct {
-  GModule *module;
-  gpointer data;
-} connect_args;
-
 static void
 gtk_builder_connect_signals_default (GtkBuilder    *builder,
 				     GObject       *object,
@@ -1020,9 +1228,22 @@ gtk_builder_connect_signals (GtkBuilder *builder,
   gtk_builder_connect_signals_full (builder,
                                     gtk_builder_connect_signals_default,
                                     args);
-  g_module_close (args->module);
 
-  g_slice_free (connect_args, args);
+  /* Keep the module open for lazy objects that are constructed later */
+  if (builder->priv->connect_data == args)
+    {
+      if (builder->priv->connect_args)
+        {
+          g_module_close (builder->priv->connect_args->module);
+          g_slice_free (connect_args, builder->priv->connect_args);
+        }
+      builder->priv->connect_args = args;
+    }
+  else
+    {
+      g_module_close (args->module);
+      g_slice_free (connect_args, args);
+    }
 }
 
 /**
@@ -1054,6 +1275,10 @@ gtk_builder_connect_signals (GtkBuilder *builder,
  * version of gtk_builder_connect_signals(), except that it does not
  * require GModule to function correctly.
  *
+ * If @builder has objects with the "lazy" attribute that haven't been
+ * constructed yet, @func is also used to connect their signals when
+ * they are constructed, so @user_data has to stay valid until then.
+ *
  * Since: 2.12
  */
 void
@@ -1061,18 +1286,37 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
                                   GtkBuilderConnectFunc  func,
                                   gpointer               user_data)
 {
-  GSList *l;
-  GObject *object;
-  GObject *connect_object;
-  
+  GSList *signals;
+
   g_return_if_fail (GTK_IS_BUILDER (builder));
   g_return_if_fail (func != NULL);
+
+  if (builder->priv->lazy_objects)
+    {
+      builder->priv->connect_func = func;
+      builder->priv->connect_data = user_data;
+    }
   
   if (!builder->priv->signals)
     return;
 
-  builder->priv->signals = g_slist_reverse (builder->priv->signals);
-  for (l = builder->priv->signals; l; l = l->next)
+  signals = g_slist_reverse (builder->priv->signals);
+  builder->priv->signals = NULL;
+
+  gtk_builder_connect_signal_list (builder, signals, func, user_data);
+}
+
+static void
+gtk_builder_connect_signal_list (GtkBuilder            *builder,
+                                 GSList                *signals,
+                                 GtkBuilderConnectFunc  func,
+                                 gpointer               user_data)
+{
+  GSList *l;
+  GObject *object;
+  GObject *connect_object;
+  
+  for (l = signals; l; l = l->next)
     {
       SignalInfo *signal = (SignalInfo*)l->data;
 
@@ -1087,8 +1331,8 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
       
       if (signal->connect_object_name)
 	{
-	  connect_object = g_hash_table_lookup (builder->priv->objects,
-						signal->connect_object_name);
+	  connect_object = gtk_builder_lookup_object (builder,
+						      signal->connect_object_name);
 	  if (!connect_object)
 	      g_warning ("Could not lookup object %s on signal %s of object %s",
 			 signal->connect_object_name, signal->name,
@@ -1099,9 +1343,8 @@ gtk_builder_connect_signals_full (GtkBuilder            *builder,
 	    connect_object, signal->flags, user_data);
     }
 
-  g_slist_foreach (builder->priv->signals, (GFunc)_free_signal_info, NULL);
-  g_slist_free (builder->priv->signals);
-  builder->priv->signals = NULL;
+  g_slist_foreach (signals, (GFunc)_free_signal_info, NULL);
+  g_slist_free (signals);
 }
 
 /**
@@ -0,0 +1,558 @@
+/* GTK - The GIMP Toolkit
+ * gtkbuildercache.c: Precompiled, mappable representation of UI files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The cache file produced by gtk-update-builder-cache is laid out
+ * as follows; all numbers are 32 bit big endian:
+ *
+ *   Header:
+ *     0  "GBLC"
+ *     4  major version (16 bit), minor version (16 bit)
+ *     8  mtime of the UI file (high, low)
+ *    16  size of the UI file (high, low)
+ *    24  number of records, offset of the record table
+ *    32  offset and size of the data area
+ *
+ *   Record:
+ *        type, line, column, string, length, attributes
+ *
+ * The string of START and END records is the element name and
+ * length is the number of attributes of START records; attributes
+ * points to a block of name and value strings. For TEXT records,
+ * string and length are the character data, which is followed by
+ * a nul byte.
+ *
+ * Strings live in the data area and are referenced by their offset
+ * into it; offset 0 means "none". All element names, attribute
+ * names and values are stored only once.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gtkdebug.h"
+#include "gtkbuildercache.h"
+#include "gtkalias.h"
+
+#define MAJOR_VERSION 1
+#define MINOR_VERSION 0
+
+#define HEADER_SIZE     40
+#define RECORD_SIZE     6
+
+#define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
+#define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
+
+#define DATA_UINT32(cache, offset, i) GET_UINT32 ((cache)->data, (offset) + 4 * (i))
+#define DATA_STRING(cache, offset) ((offset) ? (cache)->data + (offset) : NULL)
+
+struct _GtkBuilderCache
+{
+  gint ref_count;
+
+  GMappedFile *map;
+  gchar *contents;
+  const gchar *buffer;
+
+  guint32 n_records;
+  guint32 records_offset;
+
+  const gchar *data;
+  guint32 data_size;
+};
+
+struct _GtkBuilderCacheWriter
+{
+  guint64 mtime;
+  guint64 size;
+  GArray *records;
+  GByteArray *data;
+  GHashTable *strings;
+};
+
+static gboolean
+check_string (GtkBuilderCache *cache,
+              guint32          offset)
+{
+  return offset != 0 && offset < cache->data_size &&
+         memchr (cache->data + offset, 0, cache->data_size - offset) != NULL;
+}
+
+static gboolean
+check_record (GtkBuilderCache *cache,
+              guint            index,
+              GArray          *elements)
+{
+  guint32 offset = cache->records_offset + 4 * RECORD_SIZE * index;
+  guint32 type, string, length, attributes;
+  guint32 i;
+
+  type = GET_UINT32 (cache->buffer, offset);
+  string = GET_UINT32 (cache->buffer, offset + 12);
+  length = GET_UINT32 (cache->buffer, offset + 16);
+  attributes = GET_UINT32 (cache->buffer, offset + 20);
+
+  switch (type)
+    {
+    case GTK_BUILDER_CACHE_START:
+      if (!check_string (cache, string))
+        return FALSE;
+
+      if (length > 0)
+        {
+          if (attributes == 0 || attributes % 4 != 0 ||
+              attributes > cache->data_size ||
+              length > (cache->data_size - attributes) / 8)
+            return FALSE;
+
+          for (i = 0; i < 2 * length; i++)
+            if (!check_string (cache, DATA_UINT32 (cache, attributes, i)))
+              return FALSE;
+        }
+
+      g_array_append_val (elements, string);
+      return TRUE;
+
+    case GTK_BUILDER_CACHE_END:
+      /* names are stored once, so matching elements share the offset */
+      if (elements->len == 0 ||
+          g_array_index (elements, guint32, elements->len - 1) != string)
+        return FALSE;
+
+      g_array_set_size (elements, elements->len - 1);
+      return TRUE;
+
+    case GTK_BUILDER_CACHE_TEXT:
+      return string != 0 && string < cache->data_size &&
+             length < cache->data_size - string &&
+             cache->data[string + length] == '\0';
+
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+check_cache (GtkBuilderCache *cache,
+             gsize            size)
+{
+  GArray *elements;
+  gboolean retval = TRUE;
+  guint32 i;
+
+  if (size < HEADER_SIZE ||
+      memcmp (cache->buffer, "GBLC", 4) != 0 ||
+      GET_UINT16 (cache->buffer, 4) != MAJOR_VERSION)
+    return FALSE;
+
+  cache->n_records = GET_UINT32 (cache->buffer, 24);
+  cache->records_offset = GET_UINT32 (cache->buffer, 28);
+  cache->data = cache->buffer + GET_UINT32 (cache->buffer, 32);
+  cache->data_size = GET_UINT32 (cache->buffer, 36);
+
+  if (cache->n_records > size / (4 * RECORD_SIZE) ||
+      cache->records_offset % 4 != 0 ||
+      cache->records_offset > size ||
+      4 * RECORD_SIZE * cache->n_records > size - cache->records_offset ||
+      GET_UINT32 (cache->buffer, 32) % 4 != 0 ||
+      GET_UINT32 (cache->buffer, 32) > size ||
+      cache->data_size > size - GET_UINT32 (cache->buffer, 32))
+    return FALSE;
+
+  elements = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  for (i = 0; retval && i < cache->n_records; i++)
+    retval = check_record (cache, i, elements);
+
+  retval = retval && elements->len == 0;
+
+  g_array_free (elements, TRUE);
+
+  return retval;
+}
+
+/**
+ * _gtk_builder_cache_new:
+ * @filename: the cache file
+ *
+ * Maps a cache file written by gtk-update-builder-cache and checks
+ * that it is well-formed; every offset is verified here, so the
+ * accessors below don't need to. Whether the cache is still up to
+ * date with the UI file it was made from is for the caller to find
+ * out with _gtk_builder_cache_get_source().
+ *
+ * Return value: the cache, or %NULL if it doesn't exist or is broken
+ **/
+GtkBuilderCache *
+_gtk_builder_cache_new (const gchar *filename)
+{
+  GtkBuilderCache *cache;
+  GMappedFile *map;
+
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  if (!map)
+    return NULL;
+
+  /* UI files are checked for being a cache, too */
+  if (g_mapped_file_get_length (map) < 4 ||
+      memcmp (g_mapped_file_get_contents (map), "GBLC", 4) != 0)
+    {
+      g_mapped_file_free (map);
+      return NULL;
+    }
+
+  cache = g_new0 (GtkBuilderCache, 1);
+  cache->ref_count = 1;
+  cache->map = map;
+  cache->buffer = g_mapped_file_get_contents (map);
+
+  if (!check_cache (cache, g_mapped_file_get_length (map)))
+    {
+      GTK_NOTE (BUILDER, g_print ("ignoring invalid builder cache %s\n", filename));
+
+      _gtk_builder_cache_unref (cache);
+      return NULL;
+    }
+
+  return cache;
+}
+
+GtkBuilderCache *
+_gtk_builder_cache_ref (GtkBuilderCache *cache)
+{
+  cache->ref_count++;
+
+  return cache;
+}
+
+void
+_gtk_builder_cache_unref (GtkBuilderCache *cache)
+{
+  if (--cache->ref_count > 0)
+    return;
+
+  if (cache->map)
+    g_mapped_file_free (cache->map);
+  g_free (cache->contents);
+  g_free (cache);
+}
+
+void
+_gtk_builder_cache_get_source (GtkBuilderCache *cache,
+                               guint64         *mtime,
+                               guint64         *size)
+{
+  *mtime = ((guint64) GET_UINT32 (cache->buffer, 8) << 32) |
+           GET_UINT32 (cache->buffer, 12);
+  *size = ((guint64) GET_UINT32 (cache->buffer, 16) << 32) |
+          GET_UINT32 (cache->buffer, 20);
+}
+
+guint
+_gtk_builder_cache_get_n_records (GtkBuilderCache *cache)
+{
+  return cache->n_records;
+}
+
+void
+_gtk_builder_cache_get_record (GtkBuilderCache       *cache,
+                               guint                  index,
+                               GtkBuilderCacheRecord *record)
+{
+  guint32 offset;
+  guint32 string, length;
+
+  g_return_if_fail (index < cache->n_records);
+
+  offset = cache->records_offset + 4 * RECORD_SIZE * index;
+  string = GET_UINT32 (cache->buffer, offset + 12);
+  length = GET_UINT32 (cache->buffer, offset + 16);
+
+  memset (record, 0, sizeof (GtkBuilderCacheRecord));
+  record->type = GET_UINT32 (cache->buffer, offset);
+  record->line = GET_UINT32 (cache->buffer, offset + 4);
+  record->column = GET_UINT32 (cache->buffer, offset + 8);
+  record->attributes = GET_UINT32 (cache->buffer, offset + 20);
+
+  switch (record->type)
+    {
+    case GTK_BUILDER_CACHE_START:
+      record->element_name = DATA_STRING (cache, string);
+      record->n_attributes = length;
+      break;
+    case GTK_BUILDER_CACHE_END:
+      record->element_name = DATA_STRING (cache, string);
+      break;
+    case GTK_BUILDER_CACHE_TEXT:
+      record->text = DATA_STRING (cache, string);
+      record->text_length = length;
+      break;
+    default:
+      break;
+    }
+}
+
+/* @names and @values must have room for the attributes
+ * and the terminating %NULL
+ */
+void
+_gtk_builder_cache_get_attributes (GtkBuilderCache       *cache,
+                                   GtkBuilderCacheRecord *record,
+                                   const gchar          **names,
+                                   const gchar          **values)
+{
+  guint i;
+
+  for (i = 0; i < record->n_attributes; i++)
+    {
+      names[i] = DATA_STRING (cache, DATA_UINT32 (cache, record->attributes, 2 * i));
+      values[i] = DATA_STRING (cache, DATA_UINT32 (cache, record->attributes, 2 * i + 1));
+    }
+
+  names[i] = NULL;
+  values[i] = NULL;
+}
+
+GtkBuilderCacheWriter *
+_gtk_builder_cache_writer_new (guint64 mtime,
+                               guint64 size)
+{
+  GtkBuilderCacheWriter *writer;
+  guint32 none = 0;
+
+  writer = g_new (GtkBuilderCacheWriter, 1);
+  writer->mtime = mtime;
+  writer->size = size;
+  writer->records = g_array_new (FALSE, FALSE, sizeof (guint32));
+  writer->data = g_byte_array_new ();
+  writer->strings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* offset 0 means "none" */
+  g_byte_array_append (writer->data, (guint8 *) &none, 4);
+
+  return writer;
+}
+
+void
+_gtk_builder_cache_writer_free (GtkBuilderCacheWriter *writer)
+{
+  g_array_free (writer->records, TRUE);
+  g_byte_array_free (writer->data, TRUE);
+  g_hash_table_destroy (writer->strings);
+  g_free (writer);
+}
+
+static guint32
+writer_add_bytes (GtkBuilderCacheWriter *writer,
+                  const gchar           *bytes,
+                  gsize                  length)
+{
+  static const guint8 padding[4] = { 0, };
+  guint32 offset = writer->data->len;
+
+  g_byte_array_append (writer->data, (const guint8 *) bytes, length);
+  g_byte_array_append (writer->data, padding, 4 - length % 4);
+
+  return offset;
+}
+
+static guint32
+writer_add_string (GtkBuilderCacheWriter *writer,
+                   const gchar           *string)
+{
+  gpointer offset;
+
+  if (!g_hash_table_lookup_extended (writer->strings, string, NULL, &offset))
+    {
+      offset = GUINT_TO_POINTER (writer_add_bytes (writer, string, strlen (string)));
+      g_hash_table_insert (writer->strings, g_strdup (string), offset);
+    }
+
+  return GPOINTER_TO_UINT (offset);
+}
+
+static void
+writer_add_record (GtkBuilderCacheWriter     *writer,
+                   GtkBuilderCacheRecordType  type,
+                   gint                       line,
+                   gint                       column,
+                   guint32                    string,
+                   guint32                    length,
+                   guint32                    attributes)
+{
+  guint32 values[RECORD_SIZE];
+
+  values[0] = type;
+  values[1] = line;
+  values[2] = column;
+  values[3] = string;
+  values[4] = length;
+  values[5] = attributes;
+
+  g_array_append_vals (writer->records, values, RECORD_SIZE);
+}
+
+void
+_gtk_builder_cache_writer_add_start (GtkBuilderCacheWriter *writer,
+                                     gint                   line,
+                                     gint                   column,
+                                     const gchar           *element_name,
+                                     const gchar          **names,
+                                     const gchar          **values)
+{
+  GArray *attributes;
+  guint32 offset = 0;
+  guint n_attributes, i;
+
+  for (n_attributes = 0; names[n_attributes]; n_attributes++)
+    ;
+
+  if (n_attributes > 0)
+    {
+      attributes = g_array_sized_new (FALSE, FALSE, sizeof (guint32), 2 * n_attributes);
+      for (i = 0; i < n_attributes; i++)
+        {
+          guint32 name = GUINT32_TO_BE (writer_add_string (writer, names[i]));
+          guint32 value = GUINT32_TO_BE (writer_add_string (writer, values[i]));
+
+          g_array_append_val (attributes, name);
+          g_array_append_val (attributes, value);
+        }
+
+      offset = writer->data->len;
+      g_byte_array_append (writer->data, (guint8 *) attributes->data,
+                           4 * attributes->len);
+      g_array_free (attributes, TRUE);
+    }
+
+  writer_add_record (writer, GTK_BUILDER_CACHE_START, line, column,
+                     writer_add_string (writer, element_name),
+                     n_attributes, offset);
+}
+
+void
+_gtk_builder_cache_writer_add_end (GtkBuilderCacheWriter *writer,
+                                   gint                   line,
+                                   gint                   column,
+                                   const gchar           *element_name)
+{
+  writer_add_record (writer, GTK_BUILDER_CACHE_END, line, column,
+                     writer_add_string (writer, element_name), 0, 0);
+}
+
+void
+_gtk_builder_cache_writer_add_text (GtkBuilderCacheWriter *writer,
+                                    gint                   line,
+                                    gint                   column,
+                                    const gchar           *text,
+                                    gsize                  length)
+{
+  writer_add_record (writer, GTK_BUILDER_CACHE_TEXT, line, column,
+                     writer_add_bytes (writer, text, length), length, 0);
+}
+
+static void
+append_uint32 (GByteArray *array,
+               guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  g_byte_array_append (array, (guint8 *) &value, 4);
+}
+
+static GByteArray *
+writer_build (GtkBuilderCacheWriter *writer)
+{
+  GByteArray *buffer;
+  guint32 records_offset, data_offset;
+  guint16 version;
+  guint i;
+
+  records_offset = HEADER_SIZE;
+  data_offset = records_offset + 4 * writer->records->len;
+
+  buffer = g_byte_array_sized_new (data_offset + writer->data->len);
+
+  g_byte_array_append (buffer, (const guint8 *) "GBLC", 4);
+  version = GUINT16_TO_BE (MAJOR_VERSION);
+  g_byte_array_append (buffer, (guint8 *) &version, 2);
+  version = GUINT16_TO_BE (MINOR_VERSION);
+  g_byte_array_append (buffer, (guint8 *) &version, 2);
+  append_uint32 (buffer, writer->mtime >> 32);
+  append_uint32 (buffer, writer->mtime & 0xffffffff);
+  append_uint32 (buffer, writer->size >> 32);
+  append_uint32 (buffer, writer->size & 0xffffffff);
+  append_uint32 (buffer, writer->records->len / RECORD_SIZE);
+  append_uint32 (buffer, records_offset);
+  append_uint32 (buffer, data_offset);
+  append_uint32 (buffer, writer->data->len);
+
+  for (i = 0; i < writer->records->len; i++)
+    append_uint32 (buffer, g_array_index (writer->records, guint32, i));
+  g_byte_array_append (buffer, writer->data->data, writer->data->len);
+
+  return buffer;
+}
+
+/**
+ * _gtk_builder_cache_writer_finish:
+ * @writer: a #GtkBuilderCacheWriter
+ *
+ * Creates a cache in memory from the records that were added to
+ * @writer, without going through a file.
+ *
+ * Return value: the new cache
+ **/
+GtkBuilderCache *
+_gtk_builder_cache_writer_finish (GtkBuilderCacheWriter *writer)
+{
+  GtkBuilderCache *cache;
+  GByteArray *buffer;
+
+  buffer = writer_build (writer);
+
+  cache = g_new0 (GtkBuilderCache, 1);
+  cache->ref_count = 1;
+  cache->contents = (gchar *) buffer->data;
+  cache->buffer = cache->contents;
+  cache->n_records = writer->records->len / RECORD_SIZE;
+  cache->records_offset = HEADER_SIZE;
+  cache->data = cache->buffer + HEADER_SIZE + 4 * writer->records->len;
+  cache->data_size = writer->data->len;
+
+  g_byte_array_free (buffer, FALSE);
+
+  return cache;
+}
+
+gboolean
+_gtk_builder_cache_writer_write (GtkBuilderCacheWriter *writer,
+                                 const gchar           *filename,
+                                 GError               **error)
+{
+  GByteArray *buffer;
+  gboolean retval;
+
+  buffer = writer_build (writer);
+
+  retval = g_file_set_contents (filename, (gchar *) buffer->data, buffer->len, error);
+
+  g_byte_array_free (buffer, TRUE);
+
+  return retval;
+}
@@ -0,0 +1,98 @@
+/* GTK - The GIMP Toolkit
+ * gtkbuildercache.h: Precompiled, mappable representation of UI files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_BUILDER_CACHE_H__
+#define __GTK_BUILDER_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GTK_BUILDER_CACHE_SUFFIX ".cache"
+
+typedef struct _GtkBuilderCache        GtkBuilderCache;
+typedef struct _GtkBuilderCacheRecord  GtkBuilderCacheRecord;
+typedef struct _GtkBuilderCacheWriter  GtkBuilderCacheWriter;
+
+typedef enum
+{
+  GTK_BUILDER_CACHE_START,	/* an element starts */
+  GTK_BUILDER_CACHE_END,	/* an element ends */
+  GTK_BUILDER_CACHE_TEXT,	/* character data */
+  GTK_BUILDER_CACHE_LAST
+} GtkBuilderCacheRecordType;
+
+/* A cache holds the markup events of a UI file as GMarkup
+ * reported them, so they can be replayed without parsing.
+ */
+struct _GtkBuilderCacheRecord
+{
+  GtkBuilderCacheRecordType type;
+  gint                      line;
+  gint                      column;
+  const gchar              *element_name; /* START, END */
+  guint                     n_attributes; /* START */
+  const gchar              *text;         /* TEXT, nul-terminated */
+  gsize                     text_length;  /* TEXT */
+
+  /*< private >*/
+  guint32                   attributes;
+};
+
+GtkBuilderCache *_gtk_builder_cache_new            (const gchar           *filename);
+GtkBuilderCache *_gtk_builder_cache_ref            (GtkBuilderCache       *cache);
+void             _gtk_builder_cache_unref          (GtkBuilderCache       *cache);
+void             _gtk_builder_cache_get_source     (GtkBuilderCache       *cache,
+                                                    guint64               *mtime,
+                                                    guint64               *size);
+guint            _gtk_builder_cache_get_n_records  (GtkBuilderCache       *cache);
+void             _gtk_builder_cache_get_record     (GtkBuilderCache       *cache,
+                                                    guint                  index,
+                                                    GtkBuilderCacheRecord *record);
+void             _gtk_builder_cache_get_attributes (GtkBuilderCache       *cache,
+                                                    GtkBuilderCacheRecord *record,
+                                                    const gchar          **names,
+                                                    const gchar          **values);
+
+GtkBuilderCacheWriter *_gtk_builder_cache_writer_new       (guint64                mtime,
+                                                            guint64                size);
+void                   _gtk_builder_cache_writer_free      (GtkBuilderCacheWriter *writer);
+void                   _gtk_builder_cache_writer_add_start (GtkBuilderCacheWriter *writer,
+                                                            gint                   line,
+                                                            gint                   column,
+                                                            const gchar           *element_name,
+                                                            const gchar          **names,
+                                                            const gchar          **values);
+void                   _gtk_builder_cache_writer_add_end   (GtkBuilderCacheWriter *writer,
+                                                            gint                   line,
+                                                            gint                   column,
+                                                            const gchar           *element_name);
+void                   _gtk_builder_cache_writer_add_text  (GtkBuilderCacheWriter *writer,
+                                                            gint                   line,
+                                                            gint                   column,
+                                                            const gchar           *text,
+                                                            gsize                  length);
+GtkBuilderCache       *_gtk_builder_cache_writer_finish    (GtkBuilderCacheWriter *writer);
+gboolean               _gtk_builder_cache_writer_write     (GtkBuilderCacheWriter *writer,
+                                                            const gchar           *filename,
+                                                            GError               **error);
+
+G_END_DECLS
+
+#endif /* __GTK_BUILDER_CACHE_H__ */
@@ -20,8 +20,11 @@
 
 #include "config.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <gmodule.h>
+#include <glib/gstdio.h>
 
 #include "gtktypeutils.h"
 #include "gtkbuilderprivate.h"
@@ -30,11 +33,21 @@
 #include "gtkdebug.h"
 #include "gtkversion.h"
 #include "gtktypeutils.h"
+#include "gtkwidget.h"
 #include "gtkintl.h"
 #include "gtkalias.h"
 
 static void free_property_info (PropertyInfo *info);
 static void free_object_info (ObjectInfo *info);
+static gboolean can_defer_object (ParserData   *data,
+                                  const gchar  *object_class,
+                                  ChildInfo    *child_info);
+static void start_lazy_object (ParserData   *data,
+                               const gchar  *element_name,
+                               const gchar **names,
+                               const gchar **values,
+                               const gchar  *object_id,
+                               ChildInfo    *child_info);
 
 static inline void
 state_push (ParserData *data, gpointer info)
@@ -66,6 +79,34 @@ state_pop (ParserData *data)
 #define state_peek_info(data, st) ((st*)state_peek(data))
 #define state_pop_info(data, st) ((st*)state_pop(data))
 
+/* When the markup is replayed from a cache, the parse context
+ * doesn't know where we are
+ */
+static void
+get_position (ParserData *data,
+              gint       *line_number,
+              gint       *char_number)
+{
+  if (data->cache)
+    {
+      *line_number = data->line;
+      *char_number = data->column;
+    }
+  else
+    g_markup_parse_context_get_position (data->ctx,
+                                         line_number,
+                                         char_number);
+}
+
+static const gchar *
+get_element (ParserData *data)
+{
+  if (data->cache)
+    return data->elements ? data->elements->data : NULL;
+
+  return g_markup_parse_context_get_element (data->ctx);
+}
+
 static void
 error_missing_attribute (ParserData *data,
                          const gchar *tag,
@@ -74,9 +115,7 @@ error_missing_attribute (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   g_set_error (error,
                GTK_BUILDER_ERROR,
@@ -94,9 +133,7 @@ error_invalid_attribute (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   g_set_error (error,
                GTK_BUILDER_ERROR,
@@ -114,9 +151,7 @@ error_invalid_tag (ParserData *data,
 {
   gint line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   if (expected)
     g_set_error (error,
@@ -239,9 +274,7 @@ parse_requires (ParserData   *data,
   gint          i, version_major = 0, version_minor = 0;
   gint          line_number, char_number;
 
-  g_markup_parse_context_get_position (data->ctx,
-                                       &line_number,
-                                       &char_number);
+  get_position (data, &line_number, &char_number);
 
   for (i = 0; names[i] != NULL; i++)
     {
@@ -310,6 +343,7 @@ parse_object (ParserData   *data,
   gchar *object_class = NULL;
   gchar *object_id = NULL;
   gchar *constructor = NULL;
+  gboolean lazy = FALSE;
 
   child_info = state_peek_info (data, ChildInfo);
   if (child_info && strcmp (child_info->tag.name, "object") == 0)
@@ -326,6 +360,11 @@ parse_object (ParserData   *data,
         object_id = g_strdup (values[i]);
       else if (strcmp (names[i], "constructor") == 0)
         constructor = g_strdup (values[i]);
+      else if (strcmp (names[i], "lazy") == 0)
+        {
+          if (!_gtk_builder_boolean_from_string (values[i], &lazy, error))
+            return;
+        }
       else if (strcmp (names[i], "type-func") == 0)
         {
 	  /* Call the GType function, and return the name of the GType,
@@ -380,6 +419,16 @@ parse_object (ParserData   *data,
         return;
     }
 
+  if (lazy && can_defer_object (data, object_class, child_info))
+    {
+      start_lazy_object (data, element_name, names, values,
+                         object_id, child_info);
+      g_free (object_class);
+      g_free (object_id);
+      g_free (constructor);
+      return;
+    }
+
   object_info = g_slice_new0 (ObjectInfo);
   object_info->class_name = object_class;
   object_info->id = object_id;
@@ -802,6 +851,244 @@ parse_custom (GMarkupParseContext *context,
   return TRUE;
 }
 
+/* The markup is recorded as GMarkup reports it, with two exceptions:
+ * type functions of objects are resolved to the name of the type
+ * they return, and whitespace between structural elements, which
+ * no handler looks at, is dropped.
+ */
+static void
+record_start_element (GtkBuilderCacheWriter *writer,
+                      gint                   line_number,
+                      gint                   char_number,
+                      const gchar           *element_name,
+                      const gchar          **names,
+                      const gchar          **values)
+{
+  gchar *class_name = NULL;
+  const gchar **new_names = names;
+  const gchar **new_values = values;
+  int i, n;
+
+  if (strcmp (element_name, "object") == 0)
+    {
+      for (n = 0; names[n]; n++)
+        ;
+
+      for (i = 0; names[i]; i++)
+        if (strcmp (names[i], "type-func") == 0)
+          {
+            class_name = _get_type_by_symbol (values[i]);
+            break;
+          }
+
+      if (class_name)
+        {
+          new_names = g_newa (const gchar *, n + 1);
+          new_values = g_newa (const gchar *, n + 1);
+          memcpy (new_names, names, (n + 1) * sizeof (gchar *));
+          memcpy (new_values, values, (n + 1) * sizeof (gchar *));
+          new_names[i] = "class";
+          new_values[i] = class_name;
+        }
+    }
+
+  _gtk_builder_cache_writer_add_start (writer, line_number, char_number,
+                                       element_name, new_names, new_values);
+
+  g_free (class_name);
+}
+
+static void
+record_end_element (GtkBuilderCacheWriter *writer,
+                    gint                   line_number,
+                    gint                   char_number,
+                    const gchar           *element_name)
+{
+  _gtk_builder_cache_writer_add_end (writer, line_number, char_number,
+                                     element_name);
+}
+
+static void
+record_text (GtkBuilderCacheWriter *writer,
+             gint                   line_number,
+             gint                   char_number,
+             const gchar           *element,
+             const gchar           *text,
+             gsize                  text_len)
+{
+  gsize i;
+
+  if (!element ||
+      strcmp (element, "interface") == 0 ||
+      strcmp (element, "object") == 0 ||
+      strcmp (element, "child") == 0)
+    {
+      for (i = 0; i < text_len; i++)
+        if (!g_ascii_isspace (text[i]))
+          break;
+
+      if (i == text_len)
+        return;
+    }
+
+  _gtk_builder_cache_writer_add_text (writer, line_number, char_number,
+                                      text, text_len);
+}
+
+/* Objects with a lazy attribute are not constructed while parsing.
+ * Instead, the markup of the subtree is recorded as an interface of
+ * its own, which GtkBuilder replays when the object is needed.
+ */
+static gboolean
+can_defer_object (ParserData  *data,
+                  const gchar *object_class,
+                  ChildInfo   *child_info)
+{
+  GType type;
+
+  /* An object that was asked for explicitly is constructed right away */
+  if (data->requested_objects &&
+      data->cur_object_level == data->requested_object_level)
+    return FALSE;
+
+  if (!child_info)
+    return TRUE;
+
+  /* A child is replaced by a placeholder widget in its parent,
+   * so only widgets that aren't part of their parent can wait
+   */
+  if (child_info->internal_child)
+    return FALSE;
+
+  type = gtk_builder_get_type_from_name (data->builder, object_class);
+
+  return g_type_is_a (type, GTK_TYPE_WIDGET);
+}
+
+static void
+start_lazy_object (ParserData   *data,
+                   const gchar  *element_name,
+                   const gchar **names,
+                   const gchar **values,
+                   const gchar  *object_id,
+                   ChildInfo    *child_info)
+{
+  const gchar *interface_names[2] = { NULL, NULL };
+  const gchar *interface_values[2] = { NULL, NULL };
+  const gchar **new_names;
+  const gchar **new_values;
+  gint line_number, char_number;
+  int i, n;
+
+  get_position (data, &line_number, &char_number);
+
+  /* Keep the translation domain that is in effect now */
+  if (data->domain)
+    {
+      interface_names[0] = "domain";
+      interface_values[0] = data->domain;
+    }
+
+  for (n = 0; names[n]; n++)
+    ;
+
+  new_names = g_newa (const gchar *, n + 1);
+  new_values = g_newa (const gchar *, n + 1);
+  for (i = 0, n = 0; names[i]; i++)
+    if (strcmp (names[i], "lazy") != 0)
+      {
+        new_names[n] = names[i];
+        new_values[n] = values[i];
+        n++;
+      }
+  new_names[n] = NULL;
+  new_values[n] = NULL;
+
+  data->lazy_writer = _gtk_builder_cache_writer_new (0, 0);
+  record_start_element (data->lazy_writer, line_number, char_number,
+                        "interface", interface_names, interface_values);
+  record_start_element (data->lazy_writer, line_number, char_number,
+                        element_name, new_names, new_values);
+
+  data->lazy_level = 1;
+  data->lazy_child = child_info;
+  data->lazy_ids = g_slist_prepend (NULL, g_strdup (object_id));
+}
+
+static void
+lazy_start_element (ParserData   *data,
+                    const gchar  *element_name,
+                    const gchar **names,
+                    const gchar **values)
+{
+  gint line_number, char_number;
+  int i;
+
+  get_position (data, &line_number, &char_number);
+  record_start_element (data->lazy_writer, line_number, char_number,
+                        element_name, names, values);
+
+  data->lazy_level++;
+
+  /* Remember the ids in the subtree, so that asking for
+   * any of them constructs it
+   */
+  if (strcmp (element_name, "object") == 0)
+    for (i = 0; names[i]; i++)
+      if (strcmp (names[i], "id") == 0)
+        {
+          data->lazy_ids = g_slist_prepend (data->lazy_ids,
+                                            g_strdup (values[i]));
+          break;
+        }
+}
+
+static void
+lazy_end_element (ParserData  *data,
+                  const gchar *element_name)
+{
+  GtkBuilderCache *cache;
+  GObject *placeholder;
+  gint line_number, char_number;
+
+  get_position (data, &line_number, &char_number);
+  record_end_element (data->lazy_writer, line_number, char_number,
+                      element_name);
+
+  if (--data->lazy_level > 0)
+    return;
+
+  record_end_element (data->lazy_writer, line_number, char_number,
+                      "interface");
+  cache = _gtk_builder_cache_writer_finish (data->lazy_writer);
+  _gtk_builder_cache_writer_free (data->lazy_writer);
+  data->lazy_writer = NULL;
+
+  placeholder = _gtk_builder_add_lazy (data->builder, data->filename, cache,
+                                       g_slist_reverse (data->lazy_ids),
+                                       data->lazy_child != NULL);
+  _gtk_builder_cache_unref (cache);
+  data->lazy_ids = NULL;
+
+  if (data->lazy_child)
+    data->lazy_child->object = placeholder;
+  data->lazy_child = NULL;
+
+  --data->cur_object_level;
+}
+
+static void
+lazy_text (ParserData  *data,
+           const gchar *text,
+           gsize        text_len)
+{
+  gint line_number, char_number;
+
+  get_position (data, &line_number, &char_number);
+  record_text (data->lazy_writer, line_number, char_number,
+               get_element (data), text, text_len);
+}
+
 static void
 start_element (GMarkupParseContext *context,
                const gchar         *element_name,
@@ -811,6 +1098,20 @@ start_element (GMarkupParseContext *context,
                GError             **error)
 {
   ParserData *data = (ParserData*)user_data;
+  gint line_number, char_number;
+
+  if (data->writer)
+    {
+      get_position (data, &line_number, &char_number);
+      record_start_element (data->writer, line_number, char_number,
+                            element_name, names, values);
+    }
+
+  if (data->lazy_writer)
+    {
+      lazy_start_element (data, element_name, names, values);
+      return;
+    }
 
 #ifdef GTK_ENABLE_DEBUG
   if (gtk_debug_flags & GTK_DEBUG_BUILDER)
@@ -934,6 +1235,20 @@ end_element (GMarkupParseContext *context,
              GError             **error)
 {
   ParserData *data = (ParserData*)user_data;
+  gint line_number, char_number;
+
+  if (data->writer)
+    {
+      get_position (data, &line_number, &char_number);
+      record_end_element (data->writer, line_number, char_number,
+                          element_name);
+    }
+
+  if (data->lazy_writer)
+    {
+      lazy_end_element (data, element_name);
+      return;
+    }
 
   GTK_NOTE (BUILDER, g_print ("</%s>\n", element_name));
 
@@ -1070,6 +1385,20 @@ text (GMarkupParseContext *context,
 {
   ParserData *data = (ParserData*)user_data;
   CommonInfo *info;
+  gint line_number, char_number;
+
+  if (data->writer)
+    {
+      get_position (data, &line_number, &char_number);
+      record_text (data->writer, line_number, char_number,
+                   get_element (data), text, text_len);
+    }
+
+  if (data->lazy_writer)
+    {
+      lazy_text (data, text, text_len);
+      return;
+    }
 
   if (data->subparser && data->subparser->start)
     {
@@ -1089,7 +1418,7 @@ text (GMarkupParseContext *context,
   info = state_peek_info (data, CommonInfo);
   g_assert (info != NULL);
 
-  if (strcmp (g_markup_parse_context_get_element (context), "property") == 0)
+  if (strcmp (get_element (data), "property") == 0)
     {
       PropertyInfo *prop_info = (PropertyInfo*)info;
 
@@ -1122,13 +1451,84 @@ static const GMarkupParser parser = {
   NULL
 };
 
-void
-_gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
-                                  const gchar  *filename,
-                                  const gchar  *buffer,
-                                  gsize         length,
-                                  gchar       **requested_objs,
-                                  GError      **error)
+/* Feeds the records of @cache to the parser callbacks, like
+ * g_markup_parse_context_parse() would for the original markup
+ */
+static gboolean
+replay_cache (ParserData       *data,
+              GtkBuilderCache  *cache,
+              GError          **error)
+{
+  GtkBuilderCacheRecord record;
+  const gchar **names = NULL;
+  const gchar **values = NULL;
+  guint n_allocated = 0;
+  GError *tmp_error = NULL;
+  guint i, n_records;
+
+  n_records = _gtk_builder_cache_get_n_records (cache);
+
+  for (i = 0; i < n_records && !tmp_error; i++)
+    {
+      _gtk_builder_cache_get_record (cache, i, &record);
+
+      data->line = record.line;
+      data->column = record.column;
+
+      switch (record.type)
+        {
+        case GTK_BUILDER_CACHE_START:
+          if (record.n_attributes + 1 > n_allocated)
+            {
+              n_allocated = record.n_attributes + 1;
+              names = g_renew (const gchar *, names, n_allocated);
+              values = g_renew (const gchar *, values, n_allocated);
+            }
+          _gtk_builder_cache_get_attributes (cache, &record, names, values);
+
+          data->elements = g_slist_prepend (data->elements,
+                                            (gchar *) record.element_name);
+          start_element (data->ctx, record.element_name, names, values,
+                         data, &tmp_error);
+          break;
+
+        case GTK_BUILDER_CACHE_END:
+          end_element (data->ctx, record.element_name, data, &tmp_error);
+          data->elements = g_slist_delete_link (data->elements, data->elements);
+          break;
+
+        case GTK_BUILDER_CACHE_TEXT:
+          text (data->ctx, record.text, record.text_length, data, &tmp_error);
+          break;
+
+        default:
+          g_assert_not_reached ();
+        }
+    }
+
+  g_free (names);
+  g_free (values);
+  g_slist_free (data->elements);
+  data->elements = NULL;
+
+  if (tmp_error)
+    {
+      g_propagate_error (error, tmp_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+parse_markup (GtkBuilder             *builder,
+              const gchar            *filename,
+              const gchar            *buffer,
+              gsize                   length,
+              GtkBuilderCache        *cache,
+              GtkBuilderCacheWriter  *writer,
+              gchar                 **requested_objs,
+              GError                **error)
 {
   const gchar* domain;
   ParserData *data;
@@ -1145,6 +1545,8 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   data->builder = builder;
   data->filename = filename;
   data->domain = g_strdup (domain);
+  data->writer = writer;
+  data->cache = cache;
 
   data->requested_objects = NULL;
   if (requested_objs)
@@ -1168,7 +1570,13 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
                                           G_MARKUP_TREAT_CDATA_AS_TEXT, 
                                           data, NULL);
 
-  if (!g_markup_parse_context_parse (data->ctx, buffer, length, error))
+  if (cache)
+    {
+      /* The context is only there for custom tag parsers */
+      if (!replay_cache (data, cache, error))
+        goto out;
+    }
+  else if (!g_markup_parse_context_parse (data->ctx, buffer, length, error))
     goto out;
 
   _gtk_builder_finish (builder);
@@ -1196,6 +1604,10 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
 
  out:
 
+  if (data->lazy_writer)
+    _gtk_builder_cache_writer_free (data->lazy_writer);
+  g_slist_foreach (data->lazy_ids, (GFunc) g_free, NULL);
+  g_slist_free (data->lazy_ids);
   g_slist_foreach (data->stack, (GFunc)free_info, NULL);
   g_slist_free (data->stack);
   g_slist_foreach (data->custom_finalizers, (GFunc)free_subparser, NULL);
@@ -1210,3 +1622,286 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   /* restore the original domain */
   gtk_builder_set_translation_domain (builder, domain);
 }
+
+void
+_gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
+                                  const gchar  *filename,
+                                  const gchar  *buffer,
+                                  gsize         length,
+                                  gchar       **requested_objs,
+                                  GError      **error)
+{
+  parse_markup (builder, filename, buffer, length, NULL, NULL,
+                requested_objs, error);
+}
+
+void
+_gtk_builder_parser_parse_cache (GtkBuilder       *builder,
+                                 const gchar      *filename,
+                                 GtkBuilderCache  *cache,
+                                 GError          **error)
+{
+  parse_markup (builder, filename, NULL, 0, cache, NULL, NULL, error);
+}
+
+/* UI files that have been parsed in this process, with the mtime and
+ * size they had then. An application that builds the same dialog
+ * many times only parses its UI file once.
+ */
+typedef struct
+{
+  GtkBuilderCache *cache;
+  guint64 mtime;
+  guint64 size;
+} ParsedFile;
+
+static GHashTable *parsed_files = NULL;
+
+static void
+parsed_file_free (ParsedFile *file)
+{
+  _gtk_builder_cache_unref (file->cache);
+  g_slice_free (ParsedFile, file);
+}
+
+static void
+add_parsed_file (const gchar     *filename,
+                 struct stat     *statbuf,
+                 GtkBuilderCache *cache)
+{
+  ParsedFile *file;
+
+  if (!parsed_files)
+    parsed_files = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, (GDestroyNotify) parsed_file_free);
+
+  file = g_slice_new (ParsedFile);
+  file->cache = _gtk_builder_cache_ref (cache);
+  file->mtime = statbuf->st_mtime;
+  file->size = statbuf->st_size;
+
+  g_hash_table_replace (parsed_files, g_strdup (filename), file);
+}
+
+/* Finds markup for @filename that doesn't need to be parsed: from an
+ * earlier parse, from a FILE.cache made by gtk-update-builder-cache
+ * that is newer than the file, or @filename itself if it is a cache.
+ */
+static GtkBuilderCache *
+lookup_cache (const gchar *filename,
+              struct stat *statbuf)
+{
+  GtkBuilderCache *cache;
+  ParsedFile *file;
+  gchar *cache_file;
+  guint64 mtime, size;
+
+  if (parsed_files)
+    {
+      file = g_hash_table_lookup (parsed_files, filename);
+      if (file &&
+          file->mtime == (guint64) statbuf->st_mtime &&
+          file->size == (guint64) statbuf->st_size)
+        return _gtk_builder_cache_ref (file->cache);
+    }
+
+  cache_file = g_strconcat (filename, GTK_BUILDER_CACHE_SUFFIX, NULL);
+  cache = _gtk_builder_cache_new (cache_file);
+  g_free (cache_file);
+
+  if (cache)
+    {
+      _gtk_builder_cache_get_source (cache, &mtime, &size);
+      if (mtime != (guint64) statbuf->st_mtime || size != (guint64) statbuf->st_size)
+        {
+          GTK_NOTE (BUILDER, g_print ("ignoring outdated builder cache for %s\n", filename));
+
+          _gtk_builder_cache_unref (cache);
+          cache = NULL;
+        }
+    }
+
+  if (!cache)
+    cache = _gtk_builder_cache_new (filename);
+
+  if (cache)
+    add_parsed_file (filename, statbuf, cache);
+
+  return cache;
+}
+
+void
+_gtk_builder_parser_parse_file (GtkBuilder   *builder,
+                                const gchar  *filename,
+                                gchar       **requested_objs,
+                                GError      **error)
+{
+  GtkBuilderCacheWriter *writer = NULL;
+  GtkBuilderCache *cache = NULL;
+  struct stat statbuf;
+  gboolean regular;
+  GError *tmp_error = NULL;
+  gchar *buffer;
+  gsize length;
+
+  regular = g_stat (filename, &statbuf) == 0 && S_ISREG (statbuf.st_mode);
+
+  if (regular)
+    cache = lookup_cache (filename, &statbuf);
+
+  if (cache)
+    {
+      GTK_NOTE (BUILDER, g_print ("using cached markup for %s\n", filename));
+
+      parse_markup (builder, filename, NULL, 0, cache, NULL,
+                    requested_objs, error);
+      _gtk_builder_cache_unref (cache);
+
+      return;
+    }
+
+  if (!g_file_get_contents (filename, &buffer, &length, error))
+    return;
+
+  /* Without a stat we couldn't tell when the recording is outdated */
+  if (regular)
+    writer = _gtk_builder_cache_writer_new (statbuf.st_mtime, statbuf.st_size);
+
+  parse_markup (builder, filename, buffer, length, NULL, writer,
+                requested_objs, &tmp_error);
+
+  if (writer)
+    {
+      if (!tmp_error)
+        {
+          cache = _gtk_builder_cache_writer_finish (writer);
+          add_parsed_file (filename, &statbuf, cache);
+          _gtk_builder_cache_unref (cache);
+        }
+
+      _gtk_builder_cache_writer_free (writer);
+    }
+
+  if (tmp_error)
+    g_propagate_error (error, tmp_error);
+
+  g_free (buffer);
+}
+
+typedef struct
+{
+  GMarkupParseContext *ctx;
+  GtkBuilderCacheWriter *writer;
+} CompileData;
+
+static void
+compile_start_element (GMarkupParseContext *context,
+                       const gchar         *element_name,
+                       const gchar        **names,
+                       const gchar        **values,
+                       gpointer             user_data,
+                       GError             **error)
+{
+  CompileData *data = user_data;
+  gint line_number, char_number;
+
+  if (!g_markup_parse_context_get_element_stack (context)->next &&
+      strcmp (element_name, "interface") != 0)
+    {
+      g_set_error (error, GTK_BUILDER_ERROR, 
+		   GTK_BUILDER_ERROR_UNHANDLED_TAG,
+		   _("Invalid root element: '%s'"),
+		   element_name);
+      return;
+    }
+
+  g_markup_parse_context_get_position (context, &line_number, &char_number);
+  record_start_element (data->writer, line_number, char_number,
+                        element_name, names, values);
+}
+
+static void
+compile_end_element (GMarkupParseContext *context,
+                     const gchar         *element_name,
+                     gpointer             user_data,
+                     GError             **error)
+{
+  CompileData *data = user_data;
+  gint line_number, char_number;
+
+  g_markup_parse_context_get_position (context, &line_number, &char_number);
+  record_end_element (data->writer, line_number, char_number, element_name);
+}
+
+static void
+compile_text (GMarkupParseContext *context,
+              const gchar         *text,
+              gsize                text_len,
+              gpointer             user_data,
+              GError             **error)
+{
+  CompileData *data = user_data;
+  gint line_number, char_number;
+
+  g_markup_parse_context_get_position (context, &line_number, &char_number);
+  record_text (data->writer, line_number, char_number,
+               g_markup_parse_context_get_element (context),
+               text, text_len);
+}
+
+static const GMarkupParser compile_parser = {
+  compile_start_element,
+  compile_end_element,
+  compile_text,
+  NULL,
+  NULL
+};
+
+/**
+ * _gtk_builder_compile_file:
+ * @filename: a UI file
+ * @cache_file: where to write the cache
+ * @error: return location for an error, or %NULL
+ *
+ * Records the markup of a UI file in a cache file that GtkBuilder
+ * uses instead of parsing the UI file, as long as the UI file isn't
+ * modified. No objects are constructed, so errors that depend on the
+ * types in the file are only reported when it is loaded.
+ *
+ * Return value: %TRUE if the cache was written
+ **/
+gboolean
+_gtk_builder_compile_file (const gchar  *filename,
+                           const gchar  *cache_file,
+                           GError      **error)
+{
+  CompileData data;
+  struct stat statbuf;
+  gchar *buffer;
+  gsize length;
+  gboolean retval;
+
+  if (g_stat (filename, &statbuf) != 0 ||
+      !g_file_get_contents (filename, &buffer, &length, error))
+    {
+      if (error && !*error)
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+                     _("Can't find UI file \"%s\""), filename);
+      return FALSE;
+    }
+
+  data.writer = _gtk_builder_cache_writer_new (statbuf.st_mtime, statbuf.st_size);
+  data.ctx = g_markup_parse_context_new (&compile_parser,
+                                         G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                         &data, NULL);
+
+  retval = g_markup_parse_context_parse (data.ctx, buffer, length, error) &&
+           g_markup_parse_context_end_parse (data.ctx, error) &&
+           _gtk_builder_cache_writer_write (data.writer, cache_file, error);
+
+  g_markup_parse_context_free (data.ctx);
+  _gtk_builder_cache_writer_free (data.writer);
+  g_free (buffer);
+
+  return retval;
+}
@@ -22,6 +22,7 @@
 #define __GTK_BUILDER_PRIVATE_H__
 
 #include "gtkbuilder.h"
+#include "gtkbuildercache.h"
 
 typedef struct {
   const gchar *name;
@@ -101,6 +102,18 @@ typedef struct {
   gboolean inside_requested_object;
   gint requested_object_level;
   gint cur_object_level;
+
+  GtkBuilderCacheWriter *writer; /* records the markup, or NULL */
+
+  GtkBuilderCache *cache; /* the markup is replayed from here, or NULL */
+  gint line;
+  gint column;
+  GSList *elements;
+
+  GtkBuilderCacheWriter *lazy_writer; /* records a lazy object, or NULL */
+  gint lazy_level;
+  ChildInfo *lazy_child;
+  GSList *lazy_ids;
 } ParserData;
 
 typedef GType (*GTypeGetFunc) (void);
@@ -112,6 +125,17 @@ void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        gsize length,
                                        gchar **requested_objs,
                                        GError **error);
+void _gtk_builder_parser_parse_file (GtkBuilder   *builder,
+                                     const gchar  *filename,
+                                     gchar       **requested_objs,
+                                     GError      **error);
+void _gtk_builder_parser_parse_cache (GtkBuilder       *builder,
+                                      const gchar      *filename,
+                                      GtkBuilderCache  *cache,
+                                      GError          **error);
+gboolean _gtk_builder_compile_file (const gchar  *filename,
+                                    const gchar  *cache_file,
+                                    GError      **error);
 GObject * _gtk_builder_construct (GtkBuilder *builder,
                                   ObjectInfo *info,
 				  GError    **error);
@@ -119,6 +143,11 @@ void      _gtk_builder_add (GtkBuilder *builder,
                             ChildInfo *child_info);
 void      _gtk_builder_add_signals (GtkBuilder *builder,
 				    GSList     *signals);
+GObject * _gtk_builder_add_lazy (GtkBuilder      *builder,
+                                 const gchar     *filename,
+                                 GtkBuilderCache *cache,
+                                 GSList          *ids,
+                                 gboolean         placeholder);
 void      _gtk_builder_finish (GtkBuilder *builder);
 void _free_signal_info (SignalInfo *info,
                         gpointer user_data);
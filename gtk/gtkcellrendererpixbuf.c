@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include "gtkcellrendererpixbuf.h"
 #include "gtkiconfactory.h"
 #include "gtkicontheme.h"
@@ -63,9 +64,15 @@ enum {
   PROP_STOCK_DETAIL,
   PROP_FOLLOW_STATE,
   PROP_ICON_NAME,
-  PROP_GICON
+  PROP_GICON,
+  PROP_LOAD_ASYNC
 };
 
+/* Rendered icons of a renderer that loads them asynchronously;
+ * the table is cleared when it grows beyond this size
+ */
+#define MAX_ASYNC_ICONS 512
+
 
 #define GTK_CELL_RENDERER_PIXBUF_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_CELL_RENDERER_PIXBUF, GtkCellRendererPixbufPrivate))
 
@@ -78,8 +85,33 @@ struct _GtkCellRendererPixbufPrivate
   gboolean follow_state;
   gchar *icon_name;
   GIcon *gicon;
+
+  gboolean load_async;
+  GHashTable *async_icons;
+  guint async_serial;
+  gint load_size;
+  GtkIconTheme *icon_theme;
+  gulong theme_changed_id;
 };
 
+typedef struct
+{
+  gchar *icon_name;
+  GIcon *gicon;
+  gint size;
+  GdkPixbuf *pixbuf;
+  gboolean loading;
+} AsyncIcon;
+
+typedef struct
+{
+  GtkCellRendererPixbuf *cellpixbuf;
+  GtkWidget *widget;
+  GtkIconInfo *info;
+  AsyncIcon key;
+  guint serial;
+} AsyncLoad;
+
 G_DEFINE_TYPE (GtkCellRendererPixbuf, gtk_cell_renderer_pixbuf, GTK_TYPE_CELL_RENDERER)
 
 static void
@@ -207,7 +239,23 @@ gtk_cell_renderer_pixbuf_class_init (GtkCellRendererPixbufClass *class)
                                                         G_TYPE_ICON,
                                                         GTK_PARAM_READWRITE));
 
-
+  /**
+   * GtkCellRendererPixbuf:load-async:
+   *
+   * Whether icons given by #GtkCellRendererPixbuf:icon-name or
+   * #GtkCellRendererPixbuf:gicon are loaded asynchronously. Cells
+   * stay blank until their icon is loaded, and the widget is
+   * redrawn then.
+   *
+   * Since: 2.16
+   */
+  g_object_class_install_property (object_class,
+				   PROP_LOAD_ASYNC,
+				   g_param_spec_boolean ("load-async",
+							 P_("Load asynchronously"),
+							 P_("Whether icons are loaded without blocking"),
+							 FALSE,
+							 GTK_PARAM_READWRITE));
 
   g_type_class_add_private (object_class, sizeof (GtkCellRendererPixbufPrivate));
 }
@@ -234,6 +282,12 @@ gtk_cell_renderer_pixbuf_finalize (GObject *object)
   if (priv->gicon)
     g_object_unref (priv->gicon);
 
+  if (priv->async_icons)
+    g_hash_table_destroy (priv->async_icons);
+
+  if (priv->icon_theme)
+    g_signal_handler_disconnect (priv->icon_theme, priv->theme_changed_id);
+
   G_OBJECT_CLASS (gtk_cell_renderer_pixbuf_parent_class)->finalize (object);
 }
 
@@ -277,6 +331,9 @@ gtk_cell_renderer_pixbuf_get_property (GObject        *object,
     case PROP_GICON:
       g_value_set_object (value, priv->gicon);
       break;
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, priv->load_async);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
       break;
@@ -290,6 +347,8 @@ unset_image_properties (GtkCellRendererPixbuf *cell)
 
   priv = GTK_CELL_RENDERER_PIXBUF_GET_PRIVATE (cell);
 
+  priv->load_size = 0;
+
   if (priv->stock_id)
     {
       g_free (priv->stock_id);
@@ -365,6 +424,9 @@ gtk_cell_renderer_pixbuf_set_property (GObject      *object,
       unset_image_properties (cellpixbuf);
       priv->gicon = (GIcon *) g_value_dup_object (value);
       break;
+    case PROP_LOAD_ASYNC:
+      priv->load_async = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
       break;
@@ -409,6 +471,202 @@ gtk_cell_renderer_pixbuf_create_stock_pixbuf (GtkCellRendererPixbuf *cellpixbuf,
   g_object_notify (G_OBJECT (cellpixbuf), "pixbuf");
 }
 
+static guint
+async_icon_hash (gconstpointer key)
+{
+  const AsyncIcon *icon = key;
+  guint hash;
+
+  if (icon->icon_name)
+    hash = g_str_hash (icon->icon_name);
+  else
+    hash = g_icon_hash (icon->gicon);
+
+  return hash ^ icon->size;
+}
+
+static gboolean
+async_icon_equal (gconstpointer a,
+		  gconstpointer b)
+{
+  const AsyncIcon *icon_a = a;
+  const AsyncIcon *icon_b = b;
+
+  if (icon_a->size != icon_b->size)
+    return FALSE;
+
+  if (icon_a->icon_name && icon_b->icon_name)
+    return strcmp (icon_a->icon_name, icon_b->icon_name) == 0;
+
+  if (icon_a->gicon && icon_b->gicon)
+    return g_icon_equal (icon_a->gicon, icon_b->gicon);
+
+  return FALSE;
+}
+
+static void
+async_icon_free (AsyncIcon *icon)
+{
+  g_free (icon->icon_name);
+  if (icon->gicon)
+    g_object_unref (icon->gicon);
+  if (icon->pixbuf)
+    g_object_unref (icon->pixbuf);
+
+  g_slice_free (AsyncIcon, icon);
+}
+
+/* Forgets all icons loaded so far; loads that are still
+ * running are ignored when they finish
+ */
+static void
+clear_async_icons (GtkCellRendererPixbuf *cellpixbuf)
+{
+  GtkCellRendererPixbufPrivate *priv;
+
+  priv = GTK_CELL_RENDERER_PIXBUF_GET_PRIVATE (cellpixbuf);
+
+  if (priv->async_icons)
+    g_hash_table_remove_all (priv->async_icons);
+  priv->async_serial++;
+}
+
+static void
+icon_theme_changed (GtkIconTheme          *icon_theme,
+		    GtkCellRendererPixbuf *cellpixbuf)
+{
+  clear_async_icons (cellpixbuf);
+}
+
+static void
+icon_loaded_cb (GObject      *source,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+  AsyncLoad *load = user_data;
+  GtkCellRendererPixbufPrivate *priv;
+  AsyncIcon *icon;
+  GdkPixbuf *pixbuf;
+
+  gdk_threads_enter ();
+
+  priv = GTK_CELL_RENDERER_PIXBUF_GET_PRIVATE (load->cellpixbuf);
+  pixbuf = gtk_icon_info_load_icon_finish (load->info, result, NULL);
+
+  if (load->serial == priv->async_serial)
+    {
+      icon = g_hash_table_lookup (priv->async_icons, &load->key);
+      if (icon)
+	{
+	  icon->loading = FALSE;
+	  icon->pixbuf = pixbuf;
+	  pixbuf = NULL;
+
+	  gtk_widget_queue_draw (load->widget);
+	}
+    }
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  gtk_icon_info_free (load->info);
+  g_free (load->key.icon_name);
+  if (load->key.gicon)
+    g_object_unref (load->key.gicon);
+  g_object_unref (load->widget);
+  g_object_unref (load->cellpixbuf);
+  g_slice_free (AsyncLoad, load);
+
+  gdk_threads_leave ();
+}
+
+/* Sets the cell pixbuf to the icon if it has been loaded already,
+ * or starts loading it and leaves the cell blank
+ */
+static void
+gtk_cell_renderer_pixbuf_load_themed_async (GtkCellRendererPixbuf *cellpixbuf,
+					    GtkWidget             *widget,
+					    GtkIconTheme          *icon_theme,
+					    gint                   size)
+{
+  GtkCellRendererPixbufPrivate *priv;
+  GtkIconInfo *info;
+  AsyncIcon key, *icon;
+  AsyncLoad *load;
+
+  priv = GTK_CELL_RENDERER_PIXBUF_GET_PRIVATE (cellpixbuf);
+
+  if (priv->icon_theme != icon_theme)
+    {
+      if (priv->icon_theme)
+	g_signal_handler_disconnect (priv->icon_theme, priv->theme_changed_id);
+
+      /* Icon themes for screens live as long as the screen */
+      priv->icon_theme = icon_theme;
+      priv->theme_changed_id =
+	g_signal_connect (icon_theme, "changed",
+			  G_CALLBACK (icon_theme_changed), cellpixbuf);
+
+      clear_async_icons (cellpixbuf);
+    }
+
+  if (!priv->async_icons)
+    priv->async_icons = g_hash_table_new_full (async_icon_hash,
+					       async_icon_equal,
+					       (GDestroyNotify) async_icon_free,
+					       NULL);
+
+  key.icon_name = priv->icon_name;
+  key.gicon = priv->gicon;
+  key.size = size;
+
+  icon = g_hash_table_lookup (priv->async_icons, &key);
+  if (icon)
+    {
+      if (icon->pixbuf)
+	cellpixbuf->pixbuf = g_object_ref (icon->pixbuf);
+      else if (icon->loading)
+	priv->load_size = size;
+
+      return;
+    }
+
+  if (priv->icon_name)
+    info = gtk_icon_theme_lookup_icon (icon_theme, priv->icon_name, size,
+				       GTK_ICON_LOOKUP_USE_BUILTIN);
+  else
+    info = gtk_icon_theme_lookup_by_gicon (icon_theme, priv->gicon, size,
+					   GTK_ICON_LOOKUP_USE_BUILTIN);
+
+  if (g_hash_table_size (priv->async_icons) >= MAX_ASYNC_ICONS)
+    clear_async_icons (cellpixbuf);
+
+  icon = g_slice_new0 (AsyncIcon);
+  icon->icon_name = g_strdup (priv->icon_name);
+  if (priv->gicon)
+    icon->gicon = g_object_ref (priv->gicon);
+  icon->size = size;
+  g_hash_table_insert (priv->async_icons, icon, icon);
+
+  /* Icons that can't be found are remembered as such */
+  if (!info)
+    return;
+
+  icon->loading = TRUE;
+  priv->load_size = size;
+
+  load = g_slice_new (AsyncLoad);
+  load->cellpixbuf = g_object_ref (cellpixbuf);
+  load->widget = g_object_ref (widget);
+  load->info = info;
+  load->key.icon_name = g_strdup (priv->icon_name);
+  load->key.gicon = priv->gicon ? g_object_ref (priv->gicon) : NULL;
+  load->key.size = size;
+  load->serial = priv->async_serial;
+
+  gtk_icon_info_load_icon_async (info, NULL, icon_loaded_cb, load);
+}
+
 static void 
 gtk_cell_renderer_pixbuf_create_themed_pixbuf (GtkCellRendererPixbuf *cellpixbuf,
 					       GtkWidget             *widget)
@@ -439,7 +697,12 @@ gtk_cell_renderer_pixbuf_create_themed_pixbuf (GtkCellRendererPixbuf *cellpixbuf
       width = height = 24;
     }
 
-  if (priv->icon_name)
+  priv->load_size = 0;
+
+  if (priv->load_async)
+    gtk_cell_renderer_pixbuf_load_themed_async (cellpixbuf, widget, icon_theme,
+						MIN (width, height));
+  else if (priv->icon_name)
     cellpixbuf->pixbuf = gtk_icon_theme_load_icon (icon_theme,
 			                           priv->icon_name,
 			                           MIN (width, height), 
@@ -541,6 +804,11 @@ gtk_cell_renderer_pixbuf_get_size (GtkCellRenderer *cell,
       pixbuf_width  = gdk_pixbuf_get_width (cellpixbuf->pixbuf);
       pixbuf_height = gdk_pixbuf_get_height (cellpixbuf->pixbuf);
     }
+  else if (priv->load_size > 0)
+    {
+      /* Reserve the space of the icon that is being loaded */
+      pixbuf_width = pixbuf_height = priv->load_size;
+    }
   if (cellpixbuf->pixbuf_expander_open)
     {
       pixbuf_width  = MAX (pixbuf_width, gdk_pixbuf_get_width (cellpixbuf->pixbuf_expander_open));
@@ -24,6 +24,7 @@
 #include "gtkentry.h"
 #include "gtkmarshalers.h"
 #include "gtkintl.h"
+#include "gtklayoutcache.h"
 #include "gtkprivate.h"
 #include "gtktreeprivate.h"
 #include "gtkalias.h"
@@ -1359,27 +1360,30 @@ add_attr (PangoAttrList  *attr_list,
   pango_attr_list_insert (attr_list, attr);
 }
 
-static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            gboolean             will_render,
-            GtkCellRendererState flags)
+/* Fills in @key for the layout of @celltext. The attribute list
+ * in @key is newly created and must be unreffed by the caller.
+ */
+static void
+get_layout_key (GtkCellRendererText  *celltext,
+                GtkWidget            *widget,
+                gboolean              will_render,
+                GtkCellRendererState  flags,
+                GtkLayoutCacheKey    *key)
 {
   PangoAttrList *attr_list;
-  PangoLayout *layout;
   PangoUnderline uline;
   GtkCellRendererTextPrivate *priv;
 
   priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
-  
-  layout = gtk_widget_create_pango_layout (widget, celltext->text);
+
+  _gtk_layout_cache_key_init (key, celltext->text ? celltext->text : "");
 
   if (celltext->extra_attrs)
     attr_list = pango_attr_list_copy (celltext->extra_attrs);
   else
     attr_list = pango_attr_list_new ();
 
-  pango_layout_set_single_paragraph_mode (layout, priv->single_paragraph);
+  key->single_paragraph = priv->single_paragraph;
 
   if (will_render)
     {
@@ -1443,39 +1447,73 @@ get_layout (GtkCellRendererText *celltext,
     add_attr (attr_list, pango_attr_rise_new (celltext->rise));
 
   if (priv->ellipsize_set)
-    pango_layout_set_ellipsize (layout, priv->ellipsize);
+    key->ellipsize = priv->ellipsize;
   else
-    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
+    key->ellipsize = PANGO_ELLIPSIZE_NONE;
 
   if (priv->wrap_width != -1)
     {
-      pango_layout_set_width (layout, priv->wrap_width * PANGO_SCALE);
-      pango_layout_set_wrap (layout, priv->wrap_mode);
+      key->width = priv->wrap_width * PANGO_SCALE;
+      key->wrap_mode = priv->wrap_mode;
     }
   else
     {
-      pango_layout_set_width (layout, -1);
-      pango_layout_set_wrap (layout, PANGO_WRAP_CHAR);
+      key->width = -1;
+      key->wrap_mode = PANGO_WRAP_CHAR;
     }
 
   if (priv->align_set)
-    pango_layout_set_alignment (layout, priv->align);
+    key->alignment = priv->align;
   else
     {
-      PangoAlignment align;
-
       if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
-	align = PANGO_ALIGN_RIGHT;
+	key->alignment = PANGO_ALIGN_RIGHT;
       else
-	align = PANGO_ALIGN_LEFT;
-
-      pango_layout_set_alignment (layout, align);
+	key->alignment = PANGO_ALIGN_LEFT;
     }
 
-  pango_layout_set_attributes (layout, attr_list);
+  key->attrs = attr_list;
+}
+
+/* Tree views render the same strings in many rows, and for each
+ * row several times, so the layouts are shared through the layout
+ * cache where possible.
+ */
+static PangoLayout *
+get_layout_for_key (GtkWidget         *widget,
+                    GtkLayoutCacheKey *key)
+{
+  PangoLayout *layout;
+
+  layout = _gtk_layout_cache_lookup (widget, key);
+  if (layout)
+    return layout;
+
+  layout = gtk_widget_create_pango_layout (widget, key->text);
+
+  pango_layout_set_single_paragraph_mode (layout, key->single_paragraph);
+  pango_layout_set_ellipsize (layout, key->ellipsize);
+  pango_layout_set_width (layout, key->width);
+  pango_layout_set_wrap (layout, key->wrap_mode);
+  pango_layout_set_alignment (layout, key->alignment);
+  pango_layout_set_attributes (layout, key->attrs);
+
+  return layout;
+}
+
+static PangoLayout*
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget,
+            gboolean             will_render,
+            GtkCellRendererState flags)
+{
+  GtkLayoutCacheKey key;
+  PangoLayout *layout;
+
+  get_layout_key (celltext, widget, will_render, flags, &key);
+  layout = get_layout_for_key (widget, &key);
+  pango_attr_list_unref (key.attrs);
 
-  pango_attr_list_unref (attr_list);
-  
   return layout;
 }
 
@@ -1619,15 +1657,18 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
 
 {
   GtkCellRendererText *celltext = (GtkCellRendererText *) cell;
+  GtkLayoutCacheKey key;
   PangoLayout *layout;
   GtkStateType state;
   gint x_offset;
   gint y_offset;
+  gint width;
   GtkCellRendererTextPrivate *priv;
 
   priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (cell);
 
-  layout = get_layout (celltext, widget, TRUE, flags);
+  get_layout_key (celltext, widget, TRUE, flags, &key);
+  layout = get_layout_for_key (widget, &key);
   get_size (cell, widget, cell_area, layout, &x_offset, &y_offset, NULL, NULL);
 
   if (!cell->sensitive) 
@@ -1676,10 +1717,19 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
     }
 
   if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
-    pango_layout_set_width (layout, 
-			    (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE);
-  else if (priv->wrap_width == -1)
-    pango_layout_set_width (layout, -1);
+    width = (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE;
+  else
+    width = key.width;
+
+  /* The layout may be shared, so get one for the new width
+   * instead of changing it.
+   */
+  if (width != key.width)
+    {
+      key.width = width;
+      g_object_unref (layout);
+      layout = get_layout_for_key (widget, &key);
+    }
 
   gtk_paint_layout (widget->style,
                     window,
@@ -1693,6 +1743,7 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
                     layout);
 
   g_object_unref (layout);
+  pango_attr_list_unref (key.attrs);
 }
 
 static void
@@ -1328,13 +1328,13 @@ gtk_container_get_resize_container (GtkContainer *container)
 }
 
 static gboolean
-gtk_container_idle_sizer (gpointer data)
+gtk_container_layout_frame (GdkDisplay *display,
+			    gpointer    data)
 {
   /* we may be invoked with a container_resize_queue of NULL, because
-   * queue_resize could have been adding an extra idle function while
-   * the queue still got processed. we better just ignore such case
-   * than trying to explicitely work around them with some extra flags,
-   * since it doesn't cause any actual harm.
+   * the queue may have been emptied by the handler of another display.
+   * The queue is shared between displays, so all of it is processed
+   * here; the windows are exposed later in the same frame.
    */
   while (container_resize_queue)
     {
@@ -1350,11 +1350,36 @@ gtk_container_idle_sizer (gpointer data)
       gtk_container_check_resize (GTK_CONTAINER (widget));
     }
 
-  gdk_window_process_all_updates ();
-
   return FALSE;
 }
 
+static void
+gtk_container_queue_layout_frame (GtkContainer *container)
+{
+  static GQuark quark_layout_handler = 0;
+  GdkDisplay *display;
+  guint handler_id;
+
+  if (!quark_layout_handler)
+    quark_layout_handler = g_quark_from_static_string ("gtk-layout-handler");
+
+  display = gtk_widget_get_display (GTK_WIDGET (container));
+
+  handler_id = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (display),
+						     quark_layout_handler));
+  if (!handler_id)
+    {
+      handler_id = gdk_display_add_frame_handler (display,
+						  GDK_FRAME_PHASE_LAYOUT,
+						  gtk_container_layout_frame,
+						  NULL, NULL);
+      g_object_set_qdata (G_OBJECT (display), quark_layout_handler,
+			  GUINT_TO_POINTER (handler_id));
+    }
+
+  gdk_display_queue_frame_handler (display, handler_id);
+}
+
 void
 _gtk_container_queue_resize (GtkContainer *container)
 {
@@ -1365,16 +1390,23 @@ _gtk_container_queue_resize (GtkContainer *container)
 
   widget = GTK_WIDGET (container);
   resize_container = gtk_container_get_resize_container (container);
+
+  /* The request of @container depends on the visibility and the
+   * packing of its children, so it is always computed again. Further
+   * up, only the children requests matter, and the ancestors are
+   * requested again only if those change; see do_size_request().
+   */
+  GTK_PRIVATE_SET_FLAG (widget, GTK_REQUEST_NEEDED);
   
   while (TRUE)
     {
       GTK_PRIVATE_SET_FLAG (widget, GTK_ALLOC_NEEDED);
-      GTK_PRIVATE_SET_FLAG (widget, GTK_REQUEST_NEEDED);
       if ((resize_container && widget == GTK_WIDGET (resize_container)) ||
 	  !widget->parent)
 	break;
       
       widget = widget->parent;
+      GTK_PRIVATE_SET_FLAG (widget, GTK_CHILD_REQUEST_NEEDED);
     }
       
   if (resize_container)
@@ -1388,11 +1420,8 @@ _gtk_container_queue_resize (GtkContainer *container)
 	      if (!GTK_CONTAINER_RESIZE_PENDING (resize_container))
 		{
 		  GTK_PRIVATE_SET_FLAG (resize_container, GTK_RESIZE_PENDING);
-		  if (container_resize_queue == NULL)
-		    gdk_threads_add_idle_full (GTK_PRIORITY_RESIZE,
-				     gtk_container_idle_sizer,
-				     NULL, NULL);
 		  container_resize_queue = g_slist_prepend (container_resize_queue, resize_container);
+		  gtk_container_queue_layout_frame (resize_container);
 		}
 	      break;
 
@@ -140,6 +140,14 @@ struct _GtkEntryPrivate
   gint icon_margin;
   gint start_x;
   gint start_y;
+
+  /* Last character offset converted by gtk_entry_offset_to_index() */
+  gint cached_offset;
+  gint cached_index;
+
+  /* Log attrs of entry->cached_layout, computed on demand */
+  PangoLogAttr *log_attrs;
+  gint n_log_attrs;
 };
 
 typedef struct _GtkEntryPasswordHint GtkEntryPasswordHint;
@@ -408,6 +416,14 @@ static void         gtk_entry_draw_cursor              (GtkEntry       *entry,
 static PangoLayout *gtk_entry_ensure_layout            (GtkEntry       *entry,
                                                         gboolean        include_preedit);
 static void         gtk_entry_reset_layout             (GtkEntry       *entry);
+static PangoLogAttr *gtk_entry_get_log_attrs           (GtkEntry       *entry,
+                                                        gint           *n_attrs);
+static gint         gtk_entry_offset_to_index          (GtkEntry       *entry,
+                                                        gint            offset);
+static void         gtk_entry_set_offset_cache         (GtkEntry       *entry,
+                                                        gint            offset,
+                                                        gint            index);
+static void         gtk_entry_invalidate_offset_cache  (GtkEntry       *entry);
 static void         gtk_entry_queue_draw               (GtkEntry       *entry);
 static void         gtk_entry_recompute                (GtkEntry       *entry);
 static gint         gtk_entry_find_position            (GtkEntry       *entry,
@@ -2176,6 +2192,7 @@ gtk_entry_destroy (GtkObject *object)
 
   entry->n_bytes = 0;
   entry->current_pos = entry->selection_bound = entry->text_length = 0;
+  gtk_entry_invalidate_offset_cache (entry);
   _gtk_entry_reset_im_context (entry);
   gtk_entry_reset_layout (entry);
 
@@ -2238,8 +2255,7 @@ gtk_entry_finalize (GObject *object)
 
   gtk_entry_set_completion (entry, NULL);
 
-  if (entry->cached_layout)
-    g_object_unref (entry->cached_layout);
+  gtk_entry_reset_layout (entry);
 
   g_object_unref (entry->im_context);
 
@@ -3936,8 +3952,8 @@ gtk_entry_get_chars      (GtkEditable   *editable,
   start_pos = MIN (entry->text_length, start_pos);
   end_pos = MIN (entry->text_length, end_pos);
 
-  start_index = g_utf8_offset_to_pointer (entry->text, start_pos) - entry->text;
-  end_index = g_utf8_offset_to_pointer (entry->text, end_pos) - entry->text;
+  start_index = gtk_entry_offset_to_index (entry, start_pos);
+  end_index = gtk_entry_offset_to_index (entry, end_pos);
 
   return g_strndup (entry->text + start_index, end_index - start_index);
 }
@@ -4191,7 +4207,7 @@ gtk_entry_real_insert_text (GtkEditable *editable,
 	}
     }
 
-  index = g_utf8_offset_to_pointer (entry->text, *position) - entry->text;
+  index = gtk_entry_offset_to_index (entry, *position);
 
   g_memmove (entry->text + index + new_text_length, entry->text + index, entry->n_bytes - index);
   memcpy (entry->text + index, new_text, new_text_length);
@@ -4201,6 +4217,9 @@ gtk_entry_real_insert_text (GtkEditable *editable,
 
   /* NUL terminate for safety and convenience */
   entry->text[entry->n_bytes] = '\0';
+
+  /* Typing continues after the inserted text */
+  gtk_entry_set_offset_cache (entry, *position + n_chars, index + new_text_length);
   
   if (entry->current_pos > *position)
     entry->current_pos += n_chars;
@@ -4263,8 +4282,8 @@ gtk_entry_real_delete_text (GtkEditable *editable,
   
   if (start_pos < end_pos)
     {
-      gint start_index = g_utf8_offset_to_pointer (entry->text, start_pos) - entry->text;
-      gint end_index = g_utf8_offset_to_pointer (entry->text, end_pos) - entry->text;
+      gint start_index = gtk_entry_offset_to_index (entry, start_pos);
+      gint end_index = gtk_entry_offset_to_index (entry, end_pos);
       gint current_pos;
       gint selection_bound;
 
@@ -4272,6 +4291,8 @@ gtk_entry_real_delete_text (GtkEditable *editable,
       entry->text_length -= (end_pos - start_pos);
       entry->n_bytes -= (end_index - start_index);
 
+      gtk_entry_set_offset_cache (entry, start_pos, start_index);
+
       /* In password-mode, make sure we don't leave anything sensitive after
        * the terminating zero.  Note, that the terminating zero already trashed
        * one byte.
@@ -4567,11 +4588,10 @@ gtk_entry_backspace (GtkEntry *entry)
 
   if (prev_pos < entry->current_pos)
     {
-      PangoLayout *layout = gtk_entry_ensure_layout (entry, FALSE);
       PangoLogAttr *log_attrs;
       gint n_attrs;
 
-      pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+      log_attrs = gtk_entry_get_log_attrs (entry, &n_attrs);
 
       if (entry->visible &&
           log_attrs[entry->current_pos].backspace_deletes_character)
@@ -4606,8 +4626,6 @@ gtk_entry_backspace (GtkEntry *entry)
 	{
           gtk_editable_delete_text (editable, prev_pos, entry->current_pos);
 	}
-      
-      g_free (log_attrs);
     }
   else
     {
@@ -4773,7 +4791,7 @@ gtk_entry_retrieve_surrounding_cb (GtkIMContext *context,
   gtk_im_context_set_surrounding (context,
 				  entry->text,
 				  entry->n_bytes,
-				  g_utf8_offset_to_pointer (entry->text, entry->current_pos) - entry->text);
+				  gtk_entry_offset_to_index (entry, entry->current_pos));
 
   return TRUE;
 }
@@ -4864,11 +4882,96 @@ gtk_entry_set_positions (GtkEntry *entry,
 static void
 gtk_entry_reset_layout (GtkEntry *entry)
 {
+  GtkEntryPrivate *priv = GTK_ENTRY_GET_PRIVATE (entry);
+
   if (entry->cached_layout)
     {
       g_object_unref (entry->cached_layout);
       entry->cached_layout = NULL;
     }
+
+  g_free (priv->log_attrs);
+  priv->log_attrs = NULL;
+  priv->n_log_attrs = 0;
+}
+
+/* Returns the log attrs of the layout without preedit text. They
+ * are kept until the layout is reset, so cursor movement doesn't
+ * need to analyze the whole text for every keypress.
+ */
+static PangoLogAttr *
+gtk_entry_get_log_attrs (GtkEntry *entry,
+                         gint     *n_attrs)
+{
+  GtkEntryPrivate *priv = GTK_ENTRY_GET_PRIVATE (entry);
+  PangoLayout *layout;
+
+  layout = gtk_entry_ensure_layout (entry, FALSE);
+
+  if (!priv->log_attrs)
+    pango_layout_get_log_attrs (layout, &priv->log_attrs, &priv->n_log_attrs);
+
+  *n_attrs = priv->n_log_attrs;
+
+  return priv->log_attrs;
+}
+
+static void
+gtk_entry_set_offset_cache (GtkEntry *entry,
+                            gint      offset,
+                            gint      index)
+{
+  GtkEntryPrivate *priv = GTK_ENTRY_GET_PRIVATE (entry);
+
+  priv->cached_offset = offset;
+  priv->cached_index = index;
+}
+
+static void
+gtk_entry_invalidate_offset_cache (GtkEntry *entry)
+{
+  gtk_entry_set_offset_cache (entry, 0, 0);
+}
+
+/* Converts a character offset in entry->text to a byte index.
+ * Edits mostly happen at or near the cursor, so the conversion
+ * walks from the closest of the start, the end and the previously
+ * converted offset instead of always from the start of the text.
+ */
+static gint
+gtk_entry_offset_to_index (GtkEntry *entry,
+                           gint      offset)
+{
+  GtkEntryPrivate *priv = GTK_ENTRY_GET_PRIVATE (entry);
+  gint from_offset, from_index;
+  const gchar *p;
+
+  offset = CLAMP (offset, 0, entry->text_length);
+
+  if (priv->cached_offset > entry->text_length ||
+      priv->cached_index > entry->n_bytes)
+    gtk_entry_invalidate_offset_cache (entry);
+
+  from_offset = 0;
+  from_index = 0;
+
+  if (ABS (offset - priv->cached_offset) < offset)
+    {
+      from_offset = priv->cached_offset;
+      from_index = priv->cached_index;
+    }
+
+  if (entry->text_length - offset < ABS (offset - from_offset))
+    {
+      from_offset = entry->text_length;
+      from_index = entry->n_bytes;
+    }
+
+  p = g_utf8_offset_to_pointer (entry->text + from_index, offset - from_offset);
+
+  gtk_entry_set_offset_cache (entry, offset, p - entry->text);
+
+  return p - entry->text;
 }
 
 static void
@@ -4985,7 +5088,7 @@ gtk_entry_create_layout (GtkEntry *entry,
     {
       GString *tmp_string = g_string_new (NULL);
       
-      gint cursor_index = g_utf8_offset_to_pointer (entry->text, entry->current_pos) - entry->text;
+      gint cursor_index = gtk_entry_offset_to_index (entry, entry->current_pos);
       
       if (entry->visible)
         {
@@ -5707,11 +5810,10 @@ gtk_entry_move_logically (GtkEntry *entry,
     }
   else if (entry->text)
     {
-      PangoLayout *layout = gtk_entry_ensure_layout (entry, FALSE);
       PangoLogAttr *log_attrs;
       gint n_attrs;
 
-      pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+      log_attrs = gtk_entry_get_log_attrs (entry, &n_attrs);
 
       while (count > 0 && new_pos < entry->text_length)
 	{
@@ -5729,8 +5831,6 @@ gtk_entry_move_logically (GtkEntry *entry,
 	  
 	  count++;
 	}
-      
-      g_free (log_attrs);
     }
 
   return new_pos;
@@ -5750,19 +5850,16 @@ gtk_entry_move_forward_word (GtkEntry *entry,
     }
   else if (entry->text && (new_pos < entry->text_length))
     {
-      PangoLayout *layout = gtk_entry_ensure_layout (entry, FALSE);
       PangoLogAttr *log_attrs;
       gint n_attrs;
 
-      pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+      log_attrs = gtk_entry_get_log_attrs (entry, &n_attrs);
       
       /* Find the next word boundary */
       new_pos++;
       while (new_pos < n_attrs - 1 && !(log_attrs[new_pos].is_word_end ||
                                         (log_attrs[new_pos].is_word_start && allow_whitespace)))
 	new_pos++;
-
-      g_free (log_attrs);
     }
 
   return new_pos;
@@ -5783,11 +5880,10 @@ gtk_entry_move_backward_word (GtkEntry *entry,
     }
   else if (entry->text && start > 0)
     {
-      PangoLayout *layout = gtk_entry_ensure_layout (entry, FALSE);
       PangoLogAttr *log_attrs;
       gint n_attrs;
 
-      pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+      log_attrs = gtk_entry_get_log_attrs (entry, &n_attrs);
 
       new_pos = start - 1;
 
@@ -5795,8 +5891,6 @@ gtk_entry_move_backward_word (GtkEntry *entry,
       while (new_pos > 0 && !(log_attrs[new_pos].is_word_start || 
                               (log_attrs[new_pos].is_word_end && allow_whitespace)))
 	new_pos--;
-
-      g_free (log_attrs);
     }
 
   return new_pos;
@@ -5805,12 +5899,11 @@ gtk_entry_move_backward_word (GtkEntry *entry,
 static void
 gtk_entry_delete_whitespace (GtkEntry *entry)
 {
-  PangoLayout *layout = gtk_entry_ensure_layout (entry, FALSE);
   PangoLogAttr *log_attrs;
   gint n_attrs;
   gint start, end;
 
-  pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+  log_attrs = gtk_entry_get_log_attrs (entry, &n_attrs);
 
   start = end = entry->current_pos;
   
@@ -5820,8 +5913,6 @@ gtk_entry_delete_whitespace (GtkEntry *entry)
   while (end < n_attrs && log_attrs[end].is_white)
     end++;
 
-  g_free (log_attrs);
-
   if (start != end)
     gtk_editable_delete_text (GTK_EDITABLE (entry), start, end);
 }
@@ -198,7 +198,11 @@ gtk_gc_key_hash (gpointer key)
   guint hash_val;
 
   keyval = key;
-  hash_val = 0;
+
+  /* GCs of styles realized on different visuals would otherwise
+   * land in the same bucket whenever their pixels agree
+   */
+  hash_val = keyval->depth + GPOINTER_TO_UINT (keyval->colormap) + keyval->mask;
 
   if (keyval->mask & GDK_GC_FOREGROUND)
     {
@@ -206,7 +210,7 @@ gtk_gc_key_hash (gpointer key)
     }
   if (keyval->mask & GDK_GC_BACKGROUND)
     {
-      hash_val += keyval->values.background.pixel;
+      hash_val += keyval->values.background.pixel << 8;
     }
   if (keyval->mask & GDK_GC_FONT)
     {
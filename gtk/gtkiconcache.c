@@ -214,17 +214,14 @@ icon_name_hash (gconstpointer key)
   return h;
 }
 
-static gint
-find_image_offset (GtkIconCache *cache,
-		   const gchar  *icon_name,
-		   gint          directory_index)
+static guint32
+find_image_list (GtkIconCache *cache,
+		 const gchar  *icon_name)
 {
   guint32 hash_offset;
   guint32 n_buckets;
   guint32 chain_offset;
   int hash;
-  guint32 image_list_offset, n_images;
-  int i;
 
   chain_offset = cache->last_chain_offset;
   if (chain_offset)
@@ -233,7 +230,7 @@ find_image_offset (GtkIconCache *cache,
       gchar *name = cache->buffer + name_offset;
 
       if (strcmp (name, icon_name) == 0)
-        goto find_dir;
+        goto found;
     }
 
   hash_offset = GET_UINT32 (cache->buffer, 4);
@@ -249,7 +246,7 @@ find_image_offset (GtkIconCache *cache,
       if (strcmp (name, icon_name) == 0)
         {
           cache->last_chain_offset = chain_offset;
-          goto find_dir;
+          goto found;
 	}
   
       chain_offset = GET_UINT32 (cache->buffer, chain_offset);
@@ -258,9 +255,23 @@ find_image_offset (GtkIconCache *cache,
   cache->last_chain_offset = 0;
   return 0;
 
-find_dir:
+found:
+  return GET_UINT32 (cache->buffer, chain_offset + 8);
+}
+
+static gint
+find_image_offset (GtkIconCache *cache,
+		   const gchar  *icon_name,
+		   gint          directory_index)
+{
+  guint32 image_list_offset, n_images;
+  int i;
+
+  image_list_offset = find_image_list (cache, icon_name);
+  if (!image_list_offset)
+    return 0;
+
   /* We've found an icon list, now check if we have the right icon in it */
-  image_list_offset = GET_UINT32 (cache->buffer, chain_offset + 8);
   n_images = GET_UINT32 (cache->buffer, image_list_offset);
   
   for (i = 0; i < n_images; i++)
@@ -288,6 +299,98 @@ _gtk_icon_cache_get_icon_flags (GtkIconCache *cache,
   return GET_UINT16 (cache->buffer, image_offset + 2);
 }
 
+/**
+ * _gtk_icon_cache_get_icon_images:
+ * @cache: a #GtkIconCache
+ * @icon_name: the name of an icon
+ * @images: return location for the images of the icon
+ * @max_images: the number of elements in @images
+ *
+ * Finds all directories of @cache that contain @icon_name
+ * with a single hash lookup. If the cache has a size table,
+ * the images are returned in the order in which index.theme
+ * lists their directories.
+ *
+ * Return value: the number of images of the icon, which may
+ *   be larger than @max_images
+ */
+gint
+_gtk_icon_cache_get_icon_images (GtkIconCache      *cache,
+				 const gchar       *icon_name,
+				 GtkIconCacheImage *images,
+				 gint               max_images)
+{
+  guint32 image_list_offset, n_images;
+  int i;
+
+  image_list_offset = find_image_list (cache, icon_name);
+  if (!image_list_offset)
+    return 0;
+
+  n_images = GET_UINT32 (cache->buffer, image_list_offset);
+
+  for (i = 0; i < n_images && i < max_images; i++)
+    {
+      images[i].directory_index = GET_UINT16 (cache->buffer, image_list_offset + 4 + 8 * i);
+      images[i].flags = GET_UINT16 (cache->buffer, image_list_offset + 4 + 8 * i + 2);
+    }
+
+  return n_images;
+}
+
+static guint32
+get_size_table_offset (GtkIconCache *cache)
+{
+  /* The size table was added in version 1.1, which has
+   * a longer header; the hash table follows the header
+   */
+  if (GET_UINT16 (cache->buffer, 2) < 1 ||
+      GET_UINT32 (cache->buffer, 4) < 16)
+    return 0;
+
+  return GET_UINT32 (cache->buffer, 12);
+}
+
+/**
+ * _gtk_icon_cache_get_directory_size:
+ * @cache: a #GtkIconCache
+ * @directory_index: the index of a directory in @cache
+ * @dir_size: return location for the size information
+ *
+ * Gets the size information that was copied from index.theme
+ * for a directory when the cache was created. Since index.theme
+ * may be overridden in another location of the search path,
+ * callers must check that it agrees with the theme in use.
+ *
+ * Return value: %TRUE if @cache has a size table
+ */
+gboolean
+_gtk_icon_cache_get_directory_size (GtkIconCache        *cache,
+				    gint                 directory_index,
+				    GtkIconCacheDirSize *dir_size)
+{
+  guint32 size_table_offset, entry_offset;
+
+  size_table_offset = get_size_table_offset (cache);
+  if (!size_table_offset)
+    return FALSE;
+
+  if (directory_index < 0 ||
+      directory_index >= GET_UINT32 (cache->buffer, size_table_offset))
+    return FALSE;
+
+  entry_offset = size_table_offset + 4 + 12 * directory_index;
+
+  dir_size->order = GET_UINT16 (cache->buffer, entry_offset);
+  dir_size->type = GET_UINT16 (cache->buffer, entry_offset + 2);
+  dir_size->size = GET_UINT16 (cache->buffer, entry_offset + 4);
+  dir_size->min_size = GET_UINT16 (cache->buffer, entry_offset + 6);
+  dir_size->max_size = GET_UINT16 (cache->buffer, entry_offset + 8);
+  dir_size->threshold = GET_UINT16 (cache->buffer, entry_offset + 10);
+
+  return TRUE;
+}
+
 void
 _gtk_icon_cache_add_icons (GtkIconCache *cache,
 			   const gchar  *directory,
@@ -424,26 +527,15 @@ pixbuf_destroy_cb (guchar   *pixels,
   _gtk_icon_cache_unref (cache);
 }
 
-GdkPixbuf *
-_gtk_icon_cache_get_icon (GtkIconCache *cache,
-			  const gchar  *icon_name,
-			  gint          directory_index)
+static GdkPixbuf *
+pixbuf_from_pixel_data (GtkIconCache *cache,
+			guint32       pixel_data_offset)
 {
-  guint32 offset, image_data_offset, pixel_data_offset;
   guint32 length, type;
   GdkPixbuf *pixbuf;
   GdkPixdata pixdata;
   GError *error = NULL;
 
-  offset = find_image_offset (cache, icon_name, directory_index);
-  
-  image_data_offset = GET_UINT32 (cache->buffer, offset + 4);
-  
-  if (!image_data_offset)
-    return NULL;
-
-  pixel_data_offset = GET_UINT32 (cache->buffer, image_data_offset);
-
   type = GET_UINT32 (cache->buffer, pixel_data_offset);
 
   if (type != 0)
@@ -485,6 +577,80 @@ _gtk_icon_cache_get_icon (GtkIconCache *cache,
   return pixbuf;
 }
 
+GdkPixbuf *
+_gtk_icon_cache_get_icon (GtkIconCache *cache,
+			  const gchar  *icon_name,
+			  gint          directory_index)
+{
+  guint32 offset, image_data_offset, pixel_data_offset;
+
+  offset = find_image_offset (cache, icon_name, directory_index);
+  
+  image_data_offset = GET_UINT32 (cache->buffer, offset + 4);
+  
+  if (!image_data_offset)
+    return NULL;
+
+  pixel_data_offset = GET_UINT32 (cache->buffer, image_data_offset);
+
+  /* Renderings of scalable icons are only
+   * handed out for their particular size
+   */
+  if (!pixel_data_offset ||
+      GET_UINT32 (cache->buffer, pixel_data_offset) == 1)
+    return NULL;
+
+  return pixbuf_from_pixel_data (cache, pixel_data_offset);
+}
+
+/**
+ * _gtk_icon_cache_get_icon_at_size:
+ * @cache: a #GtkIconCache
+ * @icon_name: the name of a scalable icon
+ * @directory_index: the index of the directory of the icon
+ * @size: the size the icon should be rendered at
+ *
+ * Gets a rendering of a scalable icon at @size, if the
+ * cache contains one. The pixbuf refers to the pixel data
+ * in the cache, which has been rendered to fit into a
+ * @size x @size square while keeping the aspect ratio.
+ *
+ * Return value: a new #GdkPixbuf or %NULL
+ */
+GdkPixbuf *
+_gtk_icon_cache_get_icon_at_size (GtkIconCache *cache,
+				  const gchar  *icon_name,
+				  gint          directory_index,
+				  gint          size)
+{
+  guint32 offset, image_data_offset, pixel_data_offset;
+  guint32 n_sizes;
+  int i;
+
+  offset = find_image_offset (cache, icon_name, directory_index);
+  if (!offset)
+    return NULL;
+
+  image_data_offset = GET_UINT32 (cache->buffer, offset + 4);
+  if (!image_data_offset)
+    return NULL;
+
+  pixel_data_offset = GET_UINT32 (cache->buffer, image_data_offset);
+  if (!pixel_data_offset ||
+      GET_UINT32 (cache->buffer, pixel_data_offset) != 1)
+    return NULL;
+
+  n_sizes = GET_UINT32 (cache->buffer, pixel_data_offset + 8);
+  for (i = 0; i < n_sizes; i++)
+    {
+      if (GET_UINT32 (cache->buffer, pixel_data_offset + 12 + 8 * i) == size)
+	return pixbuf_from_pixel_data (cache,
+				       GET_UINT32 (cache->buffer, pixel_data_offset + 16 + 8 * i));
+    }
+
+  return NULL;
+}
+
 GtkIconData  *
 _gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
 				const gchar  *icon_name,
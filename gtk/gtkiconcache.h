@@ -24,6 +24,8 @@
 
 typedef struct _GtkIconCache GtkIconCache;
 typedef struct _GtkIconData GtkIconData;
+typedef struct _GtkIconCacheImage GtkIconCacheImage;
+typedef struct _GtkIconCacheDirSize GtkIconCacheDirSize;
 
 struct _GtkIconData
 {
@@ -36,6 +38,26 @@ struct _GtkIconData
   gchar *display_name;
 };
 
+struct _GtkIconCacheImage
+{
+  gint directory_index;
+  gint flags;
+};
+
+/* type is 0 for Fixed, 1 for Scalable and 2 for Threshold
+ * directories; order is the position of the directory in
+ * the Directories key of index.theme, or 0xffff
+ */
+struct _GtkIconCacheDirSize
+{
+  gint order;
+  gint type;
+  gint size;
+  gint min_size;
+  gint max_size;
+  gint threshold;
+};
+
 GtkIconCache *_gtk_icon_cache_new            (const gchar  *data);
 GtkIconCache *_gtk_icon_cache_new_for_path   (const gchar  *path);
 gint          _gtk_icon_cache_get_directory_index  (GtkIconCache *cache,
@@ -55,9 +77,20 @@ gint          _gtk_icon_cache_get_icon_flags (GtkIconCache *cache,
 GdkPixbuf    *_gtk_icon_cache_get_icon       (GtkIconCache *cache,
 					      const gchar  *icon_name,
 					      gint          directory_index);
+GdkPixbuf    *_gtk_icon_cache_get_icon_at_size (GtkIconCache *cache,
+						const gchar  *icon_name,
+						gint          directory_index,
+						gint          size);
 GtkIconData  *_gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
  					      const gchar  *icon_name,
  					      gint          directory_index);
+gint          _gtk_icon_cache_get_icon_images (GtkIconCache      *cache,
+					       const gchar       *icon_name,
+					       GtkIconCacheImage *images,
+					       gint               max_images);
+gboolean      _gtk_icon_cache_get_directory_size (GtkIconCache        *cache,
+						  gint                 directory_index,
+						  GtkIconCacheDirSize *dir_size);
 
 GtkIconCache *_gtk_icon_cache_ref            (GtkIconCache *cache);
 void          _gtk_icon_cache_unref          (GtkIconCache *cache);
@@ -67,12 +67,13 @@ get_uint32 (CacheInfo *info,
 }
 
 static gboolean 
-check_version (CacheInfo *info)
+check_version (CacheInfo *info,
+               guint16   *minor)
 {
-  guint16 major, minor;
+  guint16 major;
 
   check ("major version", get_uint16 (info, 0, &major) && major == 1);
-  check ("minor version", get_uint16 (info, 2, &minor) && minor == 0);
+  check ("minor version", get_uint16 (info, 2, minor) && *minor <= 1);
 
   return TRUE;
 }
@@ -148,6 +149,28 @@ check_directory_list (CacheInfo *info,
   return TRUE;
 }
 
+static gboolean 
+check_size_table (CacheInfo *info, 
+                  guint32    offset)
+{
+  guint32 n_directories;
+  guint16 order, type;
+  gint i;
+
+  check ("offset, size table", get_uint32 (info, offset, &n_directories));
+  check ("size table length", n_directories == info->n_directories);
+
+  for (i = 0; i < n_directories; i++) 
+    {
+      check ("offset, size order", get_uint16 (info, offset + 4 + 12 * i, &order));
+      check ("offset, size type", get_uint16 (info, offset + 4 + 12 * i + 2, &type));
+      check ("offset, size entry", offset + 4 + 12 * (i + 1) <= info->cache_size);
+      check ("size type", type <= 2);
+    }
+
+  return TRUE;
+}
+
 static gboolean 
 check_pixel_data (CacheInfo *info, 
                   guint32    offset)
@@ -158,9 +181,32 @@ check_pixel_data (CacheInfo *info,
   check ("offset, pixel data type", get_uint32 (info, offset, &type));
   check ("offset, pixel data length", get_uint32 (info, offset + 4, &length));
 
-  check ("pixel data type", type == 0);
+  check ("pixel data type", type == 0 || type == 1);
   check ("pixel data length", offset + 8 + length < info->cache_size);
 
+  if (type == 1)
+    {
+      guint32 n_sizes, size, render_offset;
+      gint i;
+
+      /* Renderings of a scalable icon, each of type 0 */
+      check ("offset, render list", get_uint32 (info, offset + 8, &n_sizes));
+      check ("render list length", 4 + 8 * n_sizes <= length);
+
+      for (i = 0; i < n_sizes; i++)
+        {
+          check ("offset, render size", get_uint32 (info, offset + 12 + 8 * i, &size));
+          check ("offset, render data", get_uint32 (info, offset + 16 + 8 * i, &render_offset));
+          check ("render data offset", render_offset >= offset + 12 + 8 * n_sizes &&
+                                       render_offset < offset + 8 + length);
+          check ("render data type", get_uint32 (info, render_offset, &type) && type == 0);
+          if (!check_pixel_data (info, render_offset))
+            return FALSE;
+        }
+
+      return TRUE;
+    }
+
   if (info->flags & CHECK_PIXBUFS) 
     {
       GdkPixdata data; 
@@ -385,16 +431,26 @@ check_hash (CacheInfo *info,
 gboolean 
 _gtk_icon_cache_validate (CacheInfo *info)
 {
+  guint16 minor;
   guint32 hash_offset;
   guint32 directory_list_offset;
+  guint32 size_table_offset;
 
-  if (!check_version (info))
+  if (!check_version (info, &minor))
     return FALSE;
   check ("header, hash offset", get_uint32 (info, 4, &hash_offset));
   check ("header, directory list offset", get_uint32 (info, 8, &directory_list_offset));
   if (!check_directory_list (info, directory_list_offset))
     return FALSE;
 
+  if (minor >= 1)
+    {
+      check ("header, size table offset", get_uint32 (info, 12, &size_table_offset));
+      check ("header, hash offset", hash_offset >= 16);
+      if (size_table_offset != 0 && !check_size_table (info, size_table_offset))
+        return FALSE;
+    }
+
   if (!check_hash (info, hash_offset))
     return FALSE;
 
@@ -50,6 +50,15 @@
 
 #define DEFAULT_THEME_NAME "hicolor"
 
+/* Number of looked up icons each icon theme remembers */
+#define INFO_CACHE_LRU_SIZE 64
+
+/* Default memory budget of the scaled pixbuf cache, which can
+ * be changed with the GTK_ICON_PIXBUF_CACHE_SIZE environment
+ * variable, in kilobytes; 0 disables the cache
+ */
+#define DEFAULT_PIXBUF_CACHE_SIZE (2 * 1024 * 1024)
+
 typedef enum
 {
   ICON_THEME_DIR_FIXED,  
@@ -103,6 +112,13 @@ struct _GtkIconThemePrivate
   GList *dir_mtimes;
 
   gulong reset_styles_idle;
+
+  /* Results of recent lookups, most recently used first */
+  GHashTable *info_cache;
+  GQueue info_lru;
+  guint info_cache_serial;
+  guint info_hits;
+  guint info_misses;
 };
 
 struct _GtkIconInfo
@@ -136,6 +152,7 @@ struct _GtkIconInfo
   gint desired_size;
   guint raw_coordinates : 1;
   guint forced_size     : 1;
+  guint prerendered     : 1; /* cache_pixbuf is a rendering at desired_size */
 
   /* Cached information if we go ahead and try to load
    * the icon.
@@ -156,6 +173,11 @@ typedef struct
 
   /* In search order */
   GList *dirs;
+
+  /* The icon caches of the theme, if they all have size
+   * tables that agree with index.theme, NULL otherwise
+   */
+  GList *caches;
 } IconTheme;
 
 typedef struct
@@ -176,8 +198,28 @@ typedef struct
   
   GHashTable *icons;
   GHashTable *icon_data;
+
+  int order;    /* position in the Directories key of index.theme */
+  int position; /* position in the dirs list of the theme */
 } IconThemeDir;
 
+/* Maps the directories of an icon cache to those of a theme */
+typedef struct
+{
+  GtkIconCache *cache;
+  IconThemeDir **dirs;
+  gint n_dirs;
+} IconThemeCache;
+
+/* The state of the search for the closest directory */
+typedef struct
+{
+  IconThemeDir *min_dir;
+  int min_difference;
+  gboolean has_larger;
+  gboolean match;
+} IconThemeDirMatch;
+
 typedef struct
 {
   char *svg_filename;
@@ -198,6 +240,49 @@ typedef struct
   GtkIconCache *cache;
 } IconThemeDirMtime;
 
+typedef struct
+{
+  gchar **icon_names;
+  gint size;
+  GtkIconLookupFlags flags;
+} IconInfoKey;
+
+typedef struct
+{
+  IconInfoKey key;
+  GtkIconInfo *info;
+  GList *link;
+} IconInfoCacheEntry;
+
+/* A scaled pixbuf, together with everything that went into
+ * deciding its scale
+ */
+typedef struct
+{
+  gchar *filename;
+  gint desired_size;
+  IconThemeDirType dir_type;
+  gint dir_size;
+  gint threshold;
+  gboolean forced_size;
+
+  GdkPixbuf *pixbuf;
+  gdouble scale;
+  gsize size;
+  GList *link;
+} PixbufCacheEntry;
+
+typedef struct
+{
+  GHashTable *entries;
+  GQueue lru;
+  gsize size;
+  gsize max_size;
+  guint hits;
+  guint misses;
+  guint evictions;
+} PixbufCache;
+
 static void  gtk_icon_theme_finalize   (GObject              *object);
 static void  theme_dir_destroy         (IconThemeDir         *dir);
 
@@ -215,7 +300,9 @@ static void         theme_list_contexts  (IconTheme        *theme,
 static void         theme_subdir_load (GtkIconTheme     *icon_theme,
 				       IconTheme        *theme,
 				       GKeyFile         *theme_file,
-				       char             *subdir);
+				       char             *subdir,
+				       int               order);
+static void         theme_setup_caches (IconTheme       *theme);
 static void         do_theme_change   (GtkIconTheme     *icon_theme);
 
 static void     blow_themes               (GtkIconTheme    *icon_themes);
@@ -233,6 +320,16 @@ static IconSuffix theme_dir_get_icon_suffix (IconThemeDir *dir,
 
 static GtkIconInfo *icon_info_new             (void);
 static GtkIconInfo *icon_info_new_builtin     (BuiltinIcon *icon);
+static GtkIconInfo *icon_info_dup             (GtkIconInfo *icon_info);
+
+static guint    icon_info_key_hash         (gconstpointer        data);
+static gboolean icon_info_key_equal        (gconstpointer        a,
+					    gconstpointer        b);
+static void     info_cache_clear           (GtkIconThemePrivate *priv);
+static void     pixbuf_cache_flush         (void);
+#ifdef G_ENABLE_DEBUG
+static void     debug_track_screen_theme   (GtkIconTheme        *icon_theme);
+#endif
 
 static IconSuffix suffix_from_name (const char *name);
 
@@ -245,6 +342,16 @@ static guint signal_changed = 0;
 
 static GHashTable *icon_theme_builtin_icons;
 
+/* Shared by all icon themes */
+/* Icons may be loaded in threads, see gtk_icon_info_load_icon_async() */
+static PixbufCache *pixbuf_cache = NULL;
+G_LOCK_DEFINE_STATIC (pixbuf_cache);
+
+/* Incremented when builtin icons are added, which can change
+ * the results of lookups
+ */
+static guint builtin_icons_serial = 0;
+
 /* also used in gtkiconfactory.c */
 GtkIconCache *_builtin_cache = NULL;
 static GList *builtin_dirs = NULL;
@@ -329,6 +436,8 @@ gtk_icon_theme_get_for_screen (GdkScreen *screen)
       priv->is_screen_singleton = TRUE;
 
       g_object_set_data (G_OBJECT (screen), I_("gtk-icon-theme"), icon_theme);
+
+      GTK_NOTE (ICONTHEME, debug_track_screen_theme (icon_theme));
     }
 
   return icon_theme;
@@ -587,6 +696,9 @@ gtk_icon_theme_init (GtkIconTheme *icon_theme)
   priv->unthemed_icons = NULL;
   
   priv->pixbuf_supports_svg = pixbuf_supports_svg ();
+
+  priv->info_cache = g_hash_table_new (icon_info_key_hash, icon_info_key_equal);
+  g_queue_init (&priv->info_lru);
 }
 
 static void
@@ -646,6 +758,12 @@ blow_themes (GtkIconTheme *icon_theme)
   
   if (priv->themes_valid)
     {
+      /* The cached icons may come from the old themes, and the
+       * files they were loaded from may have changed
+       */
+      info_cache_clear (priv);
+      pixbuf_cache_flush ();
+
       g_hash_table_destroy (priv->all_icons);
       g_list_foreach (priv->themes, (GFunc)theme_destroy, NULL);
       g_list_free (priv->themes);
@@ -660,6 +778,67 @@ blow_themes (GtkIconTheme *icon_theme)
   priv->themes_valid = FALSE;
 }
 
+#ifdef G_ENABLE_DEBUG
+/* The screen singletons are usually never finalized, so with
+ * GTK_DEBUG=icontheme their statistics are reported at exit
+ */
+static GSList *debug_screen_themes = NULL;
+
+static void
+print_lookup_stats (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  g_print ("icon theme lookups: %u hits, %u misses, %u cached\n",
+	   priv->info_hits, priv->info_misses,
+	   g_queue_get_length (&priv->info_lru));
+}
+
+static void
+print_pixbuf_cache_stats (void)
+{
+  G_LOCK (pixbuf_cache);
+  get_pixbuf_cache ();
+  g_print ("icon pixbufs: %u hits, %u misses, %u evictions, %u cached, "
+	   "%" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes\n",
+	   pixbuf_cache->hits, pixbuf_cache->misses, pixbuf_cache->evictions,
+	   g_hash_table_size (pixbuf_cache->entries),
+	   pixbuf_cache->size, pixbuf_cache->max_size);
+  G_UNLOCK (pixbuf_cache);
+}
+
+/* Reports how the lookup cache of @icon_theme and the pixbuf
+ * cache shared by all icon themes performed
+ */
+static void
+print_cache_stats (GtkIconTheme *icon_theme)
+{
+  print_lookup_stats (icon_theme);
+  print_pixbuf_cache_stats ();
+}
+
+static void
+print_exit_cache_stats (void)
+{
+  g_slist_foreach (debug_screen_themes, (GFunc) print_lookup_stats, NULL);
+  print_pixbuf_cache_stats ();
+}
+
+static void
+debug_track_screen_theme (GtkIconTheme *icon_theme)
+{
+  static gboolean registered = FALSE;
+
+  if (!registered)
+    {
+      g_atexit (print_exit_cache_stats);
+      registered = TRUE;
+    }
+
+  debug_screen_themes = g_slist_prepend (debug_screen_themes, icon_theme);
+}
+#endif
+
 static void
 gtk_icon_theme_finalize (GObject *object)
 {
@@ -670,6 +849,11 @@ gtk_icon_theme_finalize (GObject *object)
   icon_theme = GTK_ICON_THEME (object);
   priv = icon_theme->priv;
 
+  GTK_NOTE (ICONTHEME, print_cache_stats (icon_theme));
+#ifdef G_ENABLE_DEBUG
+  debug_screen_themes = g_slist_remove (debug_screen_themes, icon_theme);
+#endif
+
   if (priv->reset_styles_idle)
     {
       g_source_remove (priv->reset_styles_idle);
@@ -689,6 +873,9 @@ gtk_icon_theme_finalize (GObject *object)
 
   blow_themes (icon_theme);
 
+  info_cache_clear (priv);
+  g_hash_table_destroy (priv->info_cache);
+
   G_OBJECT_CLASS (gtk_icon_theme_parent_class)->finalize (object);  
 }
 
@@ -988,11 +1175,12 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 
   theme->dirs = NULL;
   for (i = 0; dirs[i] != NULL; i++)
-    theme_subdir_load (icon_theme, theme, theme_file, dirs[i]);
+    theme_subdir_load (icon_theme, theme, theme_file, dirs[i], i);
 
   g_strfreev (dirs);
 
   theme->dirs = g_list_reverse (theme->dirs);
+  theme_setup_caches (theme);
 
   themes = g_key_file_get_string_list (theme_file,
 				       "Icon Theme",
@@ -1236,6 +1424,117 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
   priv->loading_themes = FALSE;
 }
 
+static guint
+icon_info_key_hash (gconstpointer data)
+{
+  const IconInfoKey *key = data;
+  guint hash = 0;
+  gint i;
+
+  for (i = 0; key->icon_names[i]; i++)
+    hash = hash * 31 + g_str_hash (key->icon_names[i]);
+
+  return hash ^ (key->size << 8) ^ key->flags;
+}
+
+static gboolean
+icon_info_key_equal (gconstpointer a,
+		     gconstpointer b)
+{
+  const IconInfoKey *key_a = a;
+  const IconInfoKey *key_b = b;
+  gint i;
+
+  if (key_a->size != key_b->size || key_a->flags != key_b->flags)
+    return FALSE;
+
+  for (i = 0; key_a->icon_names[i] && key_b->icon_names[i]; i++)
+    if (strcmp (key_a->icon_names[i], key_b->icon_names[i]) != 0)
+      return FALSE;
+
+  return key_a->icon_names[i] == NULL && key_b->icon_names[i] == NULL;
+}
+
+static void
+info_cache_remove (GtkIconThemePrivate *priv,
+		   IconInfoCacheEntry  *entry)
+{
+  g_hash_table_remove (priv->info_cache, &entry->key);
+  g_queue_delete_link (&priv->info_lru, entry->link);
+
+  g_strfreev (entry->key.icon_names);
+  gtk_icon_info_free (entry->info);
+  g_slice_free (IconInfoCacheEntry, entry);
+}
+
+static void
+info_cache_clear (GtkIconThemePrivate *priv)
+{
+  while (priv->info_lru.head)
+    info_cache_remove (priv, priv->info_lru.head->data);
+}
+
+/* The cached infos are never handed out, since callers may change
+ * them, e.g. by setting raw coordinates or adding emblems.
+ */
+static GtkIconInfo *
+info_cache_lookup (GtkIconThemePrivate *priv,
+		   const gchar         *icon_names[],
+		   gint                 size,
+		   GtkIconLookupFlags   flags)
+{
+  IconInfoCacheEntry *entry;
+  IconInfoKey key;
+
+  if (priv->info_cache_serial != builtin_icons_serial)
+    {
+      info_cache_clear (priv);
+      priv->info_cache_serial = builtin_icons_serial;
+    }
+
+  key.icon_names = (gchar **) icon_names;
+  key.size = size;
+  key.flags = flags;
+
+  entry = g_hash_table_lookup (priv->info_cache, &key);
+  if (!entry)
+    {
+      priv->info_misses++;
+      return NULL;
+    }
+
+  priv->info_hits++;
+
+  g_queue_unlink (&priv->info_lru, entry->link);
+  g_queue_push_head_link (&priv->info_lru, entry->link);
+
+  return icon_info_dup (entry->info);
+}
+
+static void
+info_cache_insert (GtkIconThemePrivate *priv,
+		   const gchar         *icon_names[],
+		   gint                 size,
+		   GtkIconLookupFlags   flags,
+		   GtkIconInfo         *icon_info)
+{
+  IconInfoCacheEntry *entry;
+
+  if (g_queue_get_length (&priv->info_lru) >= INFO_CACHE_LRU_SIZE)
+    info_cache_remove (priv, priv->info_lru.tail->data);
+
+  entry = g_slice_new (IconInfoCacheEntry);
+  entry->key.icon_names = g_strdupv ((gchar **) icon_names);
+  entry->key.size = size;
+  entry->key.flags = flags;
+  entry->info = icon_info_dup (icon_info);
+
+  g_queue_push_head (&priv->info_lru, entry);
+  entry->link = priv->info_lru.head;
+
+  g_hash_table_insert (priv->info_cache, &entry->key, entry);
+}
+
 static GtkIconInfo *
 choose_icon (GtkIconTheme       *icon_theme,
 	     const gchar        *icon_names[],
@@ -1263,6 +1562,10 @@ choose_icon (GtkIconTheme       *icon_theme,
   
   ensure_valid_themes (icon_theme);
 
+  icon_info = info_cache_lookup (priv, icon_names, size, flags);
+  if (icon_info)
+    return icon_info;
+
   for (l = priv->themes; l; l = l->next)
     {
       IconTheme *theme = l->data;
@@ -1336,6 +1639,8 @@ choose_icon (GtkIconTheme       *icon_theme,
     {
       icon_info->desired_size = size;
       icon_info->forced_size = (flags & GTK_ICON_LOOKUP_FORCE_SIZE) != 0;
+
+      info_cache_insert (priv, icon_names, size, flags, icon_info);
     }
   else
     {
@@ -1942,9 +2247,102 @@ gtk_icon_theme_rescan_if_needed (GtkIconTheme *icon_theme)
   return retval;
 }
 
+static void
+theme_caches_free (IconTheme *theme)
+{
+  GList *l;
+
+  for (l = theme->caches; l; l = l->next)
+    {
+      IconThemeCache *theme_cache = l->data;
+
+      g_free (theme_cache->dirs);
+      g_slice_free (IconThemeCache, theme_cache);
+    }
+
+  g_list_free (theme->caches);
+  theme->caches = NULL;
+}
+
+/* Decides whether lookups in the theme can use the image lists
+ * of the icon caches directly. That requires that all directories
+ * of the theme are cached, and that the caches were created from
+ * the same index.theme that we loaded, since a user can override
+ * index.theme further up in the search path.
+ */
+static void
+theme_setup_caches (IconTheme *theme)
+{
+  GtkIconCacheDirSize dir_size;
+  IconThemeCache *theme_cache;
+  IconThemeDir *dir;
+  GList *l, *c;
+  int position;
+
+  for (l = theme->dirs, position = 0; l; l = l->next, position++)
+    {
+      dir = l->data;
+      dir->position = position;
+
+      if (dir->cache == NULL)
+	goto fail;
+
+      /* The directory has no icons */
+      if (dir->subdir_index < 0)
+	continue;
+
+      if (!_gtk_icon_cache_get_directory_size (dir->cache, dir->subdir_index, &dir_size) ||
+	  dir_size.order != dir->order ||
+	  dir_size.type != dir->type ||
+	  dir_size.size != dir->size ||
+	  dir_size.min_size != dir->min_size ||
+	  dir_size.max_size != dir->max_size ||
+	  dir_size.threshold != dir->threshold)
+	goto fail;
+
+      theme_cache = NULL;
+      for (c = theme->caches; c; c = c->next)
+	{
+	  if (((IconThemeCache *)c->data)->cache == dir->cache)
+	    {
+	      theme_cache = c->data;
+	      break;
+	    }
+	}
+
+      if (theme_cache == NULL)
+	{
+	  /* The directories hold a reference on the cache */
+	  theme_cache = g_slice_new0 (IconThemeCache);
+	  theme_cache->cache = dir->cache;
+	  theme->caches = g_list_append (theme->caches, theme_cache);
+	}
+
+      if (dir->subdir_index >= theme_cache->n_dirs)
+	{
+	  theme_cache->dirs = g_renew (IconThemeDir *, theme_cache->dirs, dir->subdir_index + 1);
+	  memset (theme_cache->dirs + theme_cache->n_dirs, 0,
+		  (dir->subdir_index + 1 - theme_cache->n_dirs) * sizeof (IconThemeDir *));
+	  theme_cache->n_dirs = dir->subdir_index + 1;
+	}
+
+      theme_cache->dirs[dir->subdir_index] = dir;
+    }
+
+  GTK_NOTE (ICONTHEME,
+	    g_print ("theme %s uses cached size tables\n", theme->name));
+
+  return;
+
+ fail:
+  theme_caches_free (theme);
+}
+
 static void
 theme_destroy (IconTheme *theme)
 {
+  theme_caches_free (theme);
+
   g_free (theme->display_name);
   g_free (theme->comment);
   g_free (theme->name);
@@ -2083,6 +2481,142 @@ theme_dir_get_icon_suffix (IconThemeDir *dir,
   return suffix;
 }
 
+/* Considers @dir, which contains the icon, as the closest
+ * match for @size. Returns %TRUE if no later directory can
+ * be a better match.
+ */
+static gboolean
+theme_dir_match (IconThemeDir      *dir,
+		 int                size,
+		 IconThemeDirMatch *m)
+{
+  gboolean smaller;
+  int difference;
+
+  difference = theme_dir_size_difference (dir, size, &smaller);
+
+  if (difference == 0)
+    {
+      if (dir->type == ICON_THEME_DIR_SCALABLE)
+        {
+          /* don't pick scalable if we already found
+           * a matching non-scalable dir
+           */
+          if (!m->match)
+            {
+	      m->min_dir = dir;
+	      return TRUE;
+            }
+        }
+      else
+        {
+          /* for a matching non-scalable dir keep
+           * going and look for a closer match
+           */             
+          difference = abs (size - dir->size);
+          if (!m->match || difference < m->min_difference)
+            {
+              m->match = TRUE;
+              m->min_difference = difference;
+	      m->min_dir = dir;
+            }
+          if (difference == 0)
+            return TRUE;
+        }
+    } 
+  
+  if (!m->match)
+    {
+      if (!m->has_larger)
+        {
+          if (difference < m->min_difference || smaller)
+  	    {
+	      m->min_difference = difference;
+	      m->min_dir = dir;
+	      m->has_larger = smaller;
+ 	    }
+        }
+      else
+        {
+          if (difference < m->min_difference && smaller)
+	    {
+	      m->min_difference = difference;
+	      m->min_dir = dir;
+	    }
+        }
+    }
+
+  return FALSE;
+}
+
+#define MAX_CACHED_CANDIDATES 64
+
+/* Looks at the directories that contain the icon, as listed
+ * by one hash lookup per icon cache, instead of checking every
+ * directory of the theme. Returns %FALSE if the caches of the
+ * theme can't be used.
+ */
+static gboolean
+theme_lookup_cached (IconTheme         *theme,
+		     const char        *icon_name,
+		     int                size,
+		     gboolean           allow_svg,
+		     IconThemeDirMatch *m)
+{
+  GtkIconCacheImage images[MAX_CACHED_CANDIDATES];
+  IconThemeDir *candidates[MAX_CACHED_CANDIDATES];
+  IconThemeCache *theme_cache;
+  IconThemeDir *dir;
+  IconSuffix suffix;
+  GList *l;
+  int n_candidates, n_images;
+  int i, j;
+
+  if (theme->caches == NULL)
+    return FALSE;
+
+  n_candidates = 0;
+  for (l = theme->caches; l; l = l->next)
+    {
+      theme_cache = l->data;
+
+      n_images = _gtk_icon_cache_get_icon_images (theme_cache->cache, icon_name,
+						  images, MAX_CACHED_CANDIDATES - n_candidates);
+      if (n_images > MAX_CACHED_CANDIDATES - n_candidates)
+	return FALSE;
+
+      for (i = 0; i < n_images; i++)
+	{
+	  if (images[i].directory_index >= theme_cache->n_dirs)
+	    continue;
+
+	  dir = theme_cache->dirs[images[i].directory_index];
+	  suffix = (IconSuffix)(images[i].flags & ~HAS_ICON_FILE);
+	  if (dir == NULL || best_suffix (suffix, allow_svg) == ICON_SUFFIX_NONE)
+	    continue;
+
+	  /* Keep the candidates in search order. The image lists
+	   * are sorted like index.theme, so this rarely moves anything.
+	   */
+	  for (j = n_candidates; j > 0 && candidates[j - 1]->position > dir->position; j--)
+	    candidates[j] = candidates[j - 1];
+	  candidates[j] = dir;
+	  n_candidates++;
+	}
+    }
+
+  for (i = 0; i < n_candidates; i++)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("theme_lookup_icon dir %s (cached)\n", candidates[i]->dir));
+
+      if (theme_dir_match (candidates[i], size, m))
+	break;
+    }
+
+  return TRUE;
+}
+
 static GtkIconInfo *
 theme_lookup_icon (IconTheme          *theme,
 		   const char         *icon_name,
@@ -2090,18 +2624,17 @@ theme_lookup_icon (IconTheme          *theme,
 		   gboolean            allow_svg,
 		   gboolean            use_builtin)
 {
-  GList *dirs, *l;
+  GList *l;
   IconThemeDir *dir, *min_dir;
   char *file;
-  int min_difference, difference;
   BuiltinIcon *closest_builtin = NULL;
-  gboolean smaller, has_larger, match;
+  IconThemeDirMatch m;
   IconSuffix suffix;
 
-  min_difference = G_MAXINT;
-  min_dir = NULL;
-  has_larger = FALSE;
-  match = FALSE;
+  m.min_difference = G_MAXINT;
+  m.min_dir = NULL;
+  m.has_larger = FALSE;
+  m.match = FALSE;
 
   /* Builtin icons are logically part of the default theme and
    * are searched before other subdirectories of the default theme.
@@ -2110,90 +2643,43 @@ theme_lookup_icon (IconTheme          *theme,
     {
       closest_builtin = find_builtin_icon (icon_name, 
 					   size,
-					   &min_difference,
-					   &has_larger);
+					   &m.min_difference,
+					   &m.has_larger);
 
-      if (min_difference == 0)
+      if (m.min_difference == 0)
 	return icon_info_new_builtin (closest_builtin);
 
-      dirs = builtin_dirs;
+      for (l = builtin_dirs; l; l = l->next)
+	{
+	  dir = l->data;
+
+	  GTK_NOTE (ICONTHEME,
+		    g_print ("theme_lookup_icon dir %s\n", dir->dir));
+	  suffix = theme_dir_get_icon_suffix (dir, icon_name, NULL);
+	  if (best_suffix (suffix, allow_svg) != ICON_SUFFIX_NONE &&
+	      theme_dir_match (dir, size, &m))
+	    goto found;
+	}
     }
-  else
-    dirs = theme->dirs;
 
-  l = dirs;
-  while (l != NULL)
+  if (!theme_lookup_cached (theme, icon_name, size, allow_svg, &m))
     {
-      dir = l->data;
-
-      GTK_NOTE (ICONTHEME,
-		g_print ("theme_lookup_icon dir %s\n", dir->dir));
-      suffix = theme_dir_get_icon_suffix (dir, icon_name, NULL);
-      if (best_suffix (suffix, allow_svg) != ICON_SUFFIX_NONE)
+      for (l = theme->dirs; l; l = l->next)
 	{
-	  difference = theme_dir_size_difference (dir, size, &smaller);
-
-	  if (difference == 0)
-	    {
-              if (dir->type == ICON_THEME_DIR_SCALABLE)
-                {
-                  /* don't pick scalable if we already found
-                   * a matching non-scalable dir
-                   */
-                  if (!match)
-                    {
-	              min_dir = dir;
-	              break;
-                    }
-                }
-              else
-                {
-                  /* for a matching non-scalable dir keep
-                   * going and look for a closer match
-                   */             
-                  difference = abs (size - dir->size);
-                  if (!match || difference < min_difference)
-                    {
-                      match = TRUE;
-                      min_difference = difference;
-	              min_dir = dir;
-                    }
-                  if (difference == 0)
-                    break;
-                }
-	    } 
-  
-          if (!match)
-            {
-	      if (!has_larger)
-	        {
-	          if (difference < min_difference || smaller)
-	  	    {
-		      min_difference = difference;
-		      min_dir = dir;
-		      has_larger = smaller;
-	 	    }
-	        }
-	      else
-	        {
-	          if (difference < min_difference && smaller)
-		    {
-		      min_difference = difference;
-		      min_dir = dir;
-		    }
-	        }
-	    }
-        }
-
-      l = l->next;
-
-      if (l == NULL && dirs == builtin_dirs)
-	{
-	  dirs = theme->dirs;
-	  l = dirs;
+	  dir = l->data;
+
+	  GTK_NOTE (ICONTHEME,
+		    g_print ("theme_lookup_icon dir %s\n", dir->dir));
+	  suffix = theme_dir_get_icon_suffix (dir, icon_name, NULL);
+	  if (best_suffix (suffix, allow_svg) != ICON_SUFFIX_NONE &&
+	      theme_dir_match (dir, size, &m))
+	    break;
 	}
     }
 
+ found:
+  min_dir = m.min_dir;
+
   if (min_dir)
     {
       GtkIconInfo *icon_info = icon_info_new ();
@@ -2261,6 +2747,13 @@ theme_lookup_icon (IconTheme          *theme,
 	{
 	  icon_info->cache_pixbuf = _gtk_icon_cache_get_icon (min_dir->cache, icon_name,
 							      min_dir->subdir_index);
+
+	  if (icon_info->cache_pixbuf == NULL && suffix == ICON_SUFFIX_SVG)
+	    {
+	      icon_info->cache_pixbuf = _gtk_icon_cache_get_icon_at_size (min_dir->cache, icon_name,
+									  min_dir->subdir_index, size);
+	      icon_info->prerendered = icon_info->cache_pixbuf != NULL;
+	    }
 	}
 
       icon_info->dir_type = min_dir->type;
@@ -2465,7 +2958,8 @@ static void
 theme_subdir_load (GtkIconTheme *icon_theme,
 		   IconTheme    *theme,
 		   GKeyFile     *theme_file,
-		   char         *subdir)
+		   char         *subdir,
+		   int           order)
 {
   GList *d;
   char *type_string;
@@ -2567,6 +3061,8 @@ theme_subdir_load (GtkIconTheme *icon_theme,
 	  dir->dir = full_dir;
 	  dir->icon_data = NULL;
 	  dir->subdir = g_strdup (subdir);
+	  dir->order = order;
+	  dir->position = 0;
 	  if (dir_mtime->cache != NULL)
             {
 	      dir->cache = _gtk_icon_cache_ref (dir_mtime->cache);
@@ -2635,6 +3131,33 @@ icon_info_new_builtin (BuiltinIcon *icon)
   return icon_info;
 }
 
+/* Copies the result of a lookup into a new info, without
+ * anything that was loaded from it
+ */
+static GtkIconInfo *
+icon_info_dup (GtkIconInfo *icon_info)
+{
+  GtkIconInfo *dup = icon_info_new ();
+
+  dup->filename = g_strdup (icon_info->filename);
+#if defined (G_OS_WIN32) && !defined (_WIN64)
+  dup->cp_filename = g_strdup (icon_info->cp_filename);
+#endif
+  if (icon_info->loadable)
+    dup->loadable = g_object_ref (icon_info->loadable);
+  if (icon_info->cache_pixbuf)
+    dup->cache_pixbuf = g_object_ref (icon_info->cache_pixbuf);
+  dup->data = icon_info->data;
+  dup->dir_type = icon_info->dir_type;
+  dup->dir_size = icon_info->dir_size;
+  dup->threshold = icon_info->threshold;
+  dup->desired_size = icon_info->desired_size;
+  dup->forced_size = icon_info->forced_size;
+  dup->prerendered = icon_info->prerendered;
+
+  return dup;
+}
+
 /**
  * gtk_icon_info_copy:
  * @icon_info: a #GtkIconInfo
@@ -2847,6 +3370,185 @@ apply_emblems (GtkIconInfo *info)
     }
 }
 
+static guint
+pixbuf_cache_entry_hash (gconstpointer data)
+{
+  const PixbufCacheEntry *entry = data;
+
+  return g_str_hash (entry->filename) ^ (entry->desired_size << 8) ^ entry->dir_size;
+}
+
+static gboolean
+pixbuf_cache_entry_equal (gconstpointer a,
+			  gconstpointer b)
+{
+  const PixbufCacheEntry *entry_a = a;
+  const PixbufCacheEntry *entry_b = b;
+
+  return (entry_a->desired_size == entry_b->desired_size &&
+	  entry_a->dir_type == entry_b->dir_type &&
+	  entry_a->dir_size == entry_b->dir_size &&
+	  entry_a->threshold == entry_b->threshold &&
+	  entry_a->forced_size == entry_b->forced_size &&
+	  strcmp (entry_a->filename, entry_b->filename) == 0);
+}
+
+static PixbufCache *
+get_pixbuf_cache (void)
+{
+  if (!pixbuf_cache)
+    {
+      const gchar *env;
+
+      pixbuf_cache = g_new0 (PixbufCache, 1);
+      pixbuf_cache->entries = g_hash_table_new (pixbuf_cache_entry_hash,
+						pixbuf_cache_entry_equal);
+      g_queue_init (&pixbuf_cache->lru);
+      pixbuf_cache->max_size = DEFAULT_PIXBUF_CACHE_SIZE;
+
+      env = g_getenv ("GTK_ICON_PIXBUF_CACHE_SIZE");
+      if (env)
+	pixbuf_cache->max_size = (gsize) strtoul (env, NULL, 10) * 1024;
+    }
+
+  return pixbuf_cache;
+}
+
+static void
+pixbuf_cache_remove (PixbufCacheEntry *entry)
+{
+  g_hash_table_remove (pixbuf_cache->entries, entry);
+  g_queue_delete_link (&pixbuf_cache->lru, entry->link);
+  pixbuf_cache->size -= entry->size;
+
+  g_free (entry->filename);
+  g_object_unref (entry->pixbuf);
+  g_slice_free (PixbufCacheEntry, entry);
+}
+
+static void
+pixbuf_cache_flush (void)
+{
+  G_LOCK (pixbuf_cache);
+
+  if (pixbuf_cache)
+    {
+      while (pixbuf_cache->lru.head)
+	pixbuf_cache_remove (pixbuf_cache->lru.head->data);
+    }
+
+  G_UNLOCK (pixbuf_cache);
+}
+
+static void
+pixbuf_cache_entry_init (PixbufCacheEntry *entry,
+			 GtkIconInfo      *icon_info)
+{
+  entry->filename = icon_info->filename;
+  entry->desired_size = icon_info->desired_size;
+  entry->dir_type = icon_info->dir_type;
+  entry->dir_size = icon_info->dir_size;
+  entry->threshold = icon_info->threshold;
+  entry->forced_size = icon_info->forced_size;
+}
+
+/* Only icons that are loaded from files are cached; builtin icons
+ * and icons from the icon cache are in memory already.
+ */
+static gboolean
+pixbuf_cache_lookup (GtkIconInfo *icon_info)
+{
+  PixbufCacheEntry key;
+  PixbufCacheEntry *entry;
+
+  if (!icon_info->filename || icon_info->cache_pixbuf)
+    return FALSE;
+
+  G_LOCK (pixbuf_cache);
+
+  get_pixbuf_cache ();
+
+  pixbuf_cache_entry_init (&key, icon_info);
+  entry = g_hash_table_lookup (pixbuf_cache->entries, &key);
+  if (!entry)
+    {
+      pixbuf_cache->misses++;
+      G_UNLOCK (pixbuf_cache);
+
+      return FALSE;
+    }
+
+  pixbuf_cache->hits++;
+
+  g_queue_unlink (&pixbuf_cache->lru, entry->link);
+  g_queue_push_head_link (&pixbuf_cache->lru, entry->link);
+
+  icon_info->pixbuf = g_object_ref (entry->pixbuf);
+  icon_info->scale = entry->scale;
+
+  G_UNLOCK (pixbuf_cache);
+
+  return TRUE;
+}
+
+/* Called with the scaled pixbuf, before emblems are applied */
+static void
+pixbuf_cache_insert (GtkIconInfo *icon_info)
+{
+  PixbufCacheEntry *entry;
+  gsize size;
+
+  if (!icon_info->filename || icon_info->cache_pixbuf)
+    return;
+
+  G_LOCK (pixbuf_cache);
+
+  get_pixbuf_cache ();
+
+  size = gdk_pixbuf_get_rowstride (icon_info->pixbuf) *
+	 gdk_pixbuf_get_height (icon_info->pixbuf);
+
+  if (size > pixbuf_cache->max_size / 4)
+    {
+      G_UNLOCK (pixbuf_cache);
+      return;
+    }
+
+  entry = g_slice_new (PixbufCacheEntry);
+  pixbuf_cache_entry_init (entry, icon_info);
+  entry->filename = g_strdup (icon_info->filename);
+  entry->pixbuf = g_object_ref (icon_info->pixbuf);
+  entry->scale = icon_info->scale;
+  entry->size = size;
+
+  /* The same icon may have been loaded through another info
+   * in the meantime
+   */
+  if (g_hash_table_lookup (pixbuf_cache->entries, entry))
+    pixbuf_cache_remove (g_hash_table_lookup (pixbuf_cache->entries, entry));
+
+  g_queue_push_head (&pixbuf_cache->lru, entry);
+  entry->link = pixbuf_cache->lru.head;
+  g_hash_table_insert (pixbuf_cache->entries, entry, entry);
+  pixbuf_cache->size += size;
+
+  while (pixbuf_cache->size > pixbuf_cache->max_size)
+    {
+      pixbuf_cache_remove (pixbuf_cache->lru.tail->data);
+      pixbuf_cache->evictions++;
+    }
+
+  GTK_NOTE (ICONTHEME,
+	    if (pixbuf_cache->misses % 256 == 0)
+	      g_print ("icon pixbuf cache: %u entries, %" G_GSIZE_FORMAT " bytes, "
+		       "%u hits, %u misses, %u evictions\n",
+		       g_hash_table_size (pixbuf_cache->entries), pixbuf_cache->size,
+		       pixbuf_cache->hits, pixbuf_cache->misses,
+		       pixbuf_cache->evictions));
+
+  G_UNLOCK (pixbuf_cache);
+}
+
 /* This function contains the complicated logic for deciding
  * on the size at which to load the icon and loading it at
  * that size.
@@ -2871,6 +3573,29 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
   if (icon_info->load_error)
     return FALSE;
 
+  /* A scalable icon that was rendered at the desired size when
+   * the icon cache was created; use it like a loaded SVG
+   */
+  if (icon_info->prerendered)
+    {
+      icon_info->scale = icon_info->desired_size / 1000.;
+
+      if (scale_only)
+	return TRUE;
+
+      icon_info->pixbuf = g_object_ref (icon_info->cache_pixbuf);
+      apply_emblems (icon_info);
+
+      return TRUE;
+    }
+
+  if (pixbuf_cache_lookup (icon_info))
+    {
+      apply_emblems (icon_info);
+
+      return TRUE;
+    }
+
   /* SVG icons are a special case - we just immediately scale them
    * to the desired size
    */
@@ -2933,6 +3658,7 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
       if (!icon_info->pixbuf)
         return FALSE;
 
+      pixbuf_cache_insert (icon_info);
       apply_emblems (icon_info);
         
       return TRUE;
@@ -3026,6 +3752,7 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
       g_object_unref (source_pixbuf);
     }
 
+  pixbuf_cache_insert (icon_info);
   apply_emblems (icon_info);
 
   return TRUE;
@@ -3078,6 +3805,148 @@ gtk_icon_info_load_icon (GtkIconInfo *icon_info,
   return g_object_ref (icon_info->pixbuf);
 }
 
+/* The GSimpleAsyncResults of gtk_icon_info_load_icon_async()
+ * need a source object, but icon infos aren't objects
+ */
+static GObject *
+get_load_source (void)
+{
+  static GObject *load_source = NULL;
+
+  if (!load_source)
+    load_source = g_object_new (G_TYPE_OBJECT, NULL);
+
+  return load_source;
+}
+
+static void
+load_icon_thread (GSimpleAsyncResult *result,
+		  GObject            *object,
+		  GCancellable       *cancellable)
+{
+  GtkIconInfo *icon_info;
+  GError *error = NULL;
+
+  /* This is a copy of the icon info that was passed in, which
+   * isn't shared with the main thread until we're done
+   */
+  icon_info = g_simple_async_result_get_op_res_gpointer (result);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    ;
+  else if (!icon_info_ensure_scale_and_pixbuf (icon_info, FALSE))
+    {
+      if (icon_info->load_error)
+	error = g_error_copy (icon_info->load_error);
+      else
+	g_set_error_literal (&error,
+			     GTK_ICON_THEME_ERROR,
+			     GTK_ICON_THEME_NOT_FOUND,
+			     _("Failed to load icon"));
+    }
+
+  if (error)
+    {
+      g_simple_async_result_set_from_error (result, error);
+      g_error_free (error);
+    }
+}
+
+/**
+ * gtk_icon_info_load_icon_async:
+ * @icon_info: a #GtkIconInfo structure from gtk_icon_theme_lookup_icon()
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @callback: a #GAsyncReadyCallback to call when the icon is loaded
+ * @user_data: the data to pass to @callback
+ *
+ * Asynchronously renders an icon previously looked up in an icon
+ * theme, like gtk_icon_info_load_icon(). The icon is loaded and
+ * scaled in a thread if threads have been initialized, otherwise
+ * from an idle handler. The source object passed to @callback is
+ * not meaningful.
+ *
+ * When the operation is finished, @callback is called and you can
+ * call gtk_icon_info_load_icon_finish() to get the result. The icon
+ * info must not be freed before that.
+ *
+ * Since: 2.16
+ **/
+void
+gtk_icon_info_load_icon_async (GtkIconInfo         *icon_info,
+			       GCancellable        *cancellable,
+			       GAsyncReadyCallback  callback,
+			       gpointer             user_data)
+{
+  GSimpleAsyncResult *result;
+
+  g_return_if_fail (icon_info != NULL);
+
+  result = g_simple_async_result_new (get_load_source (), callback, user_data,
+				      gtk_icon_info_load_icon_async);
+
+  if (icon_info->pixbuf)
+    g_simple_async_result_complete_in_idle (result);
+  else
+    {
+      g_simple_async_result_set_op_res_gpointer (result,
+						 icon_info_dup (icon_info),
+						 (GDestroyNotify) gtk_icon_info_free);
+      g_simple_async_result_run_in_thread (result, load_icon_thread,
+					   G_PRIORITY_DEFAULT, cancellable);
+    }
+
+  g_object_unref (result);
+}
+
+/**
+ * gtk_icon_info_load_icon_finish:
+ * @icon_info: the #GtkIconInfo passed to gtk_icon_info_load_icon_async()
+ * @result: a #GAsyncResult
+ * @error: location to store error information on failure, or %NULL.
+ *
+ * Finishes an asynchronous icon load started with
+ * gtk_icon_info_load_icon_async(). Afterwards, gtk_icon_info_load_icon()
+ * returns the same icon without loading it again.
+ *
+ * Return value: the rendered icon, or %NULL if loading failed or was
+ *  cancelled; see gtk_icon_info_load_icon(). Use g_object_unref() to
+ *  release your reference to the icon.
+ *
+ * Since: 2.16
+ **/
+GdkPixbuf *
+gtk_icon_info_load_icon_finish (GtkIconInfo   *icon_info,
+				GAsyncResult  *result,
+				GError       **error)
+{
+  GSimpleAsyncResult *simple;
+  GtkIconInfo *loaded;
+
+  g_return_val_if_fail (icon_info != NULL, NULL);
+  g_return_val_if_fail (G_IS_SIMPLE_ASYNC_RESULT (result), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+  g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == gtk_icon_info_load_icon_async);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  loaded = g_simple_async_result_get_op_res_gpointer (simple);
+
+  /* Emblems are applied here rather than in the thread, since
+   * the emblem infos belong to @icon_info
+   */
+  if (loaded && !icon_info->pixbuf)
+    {
+      icon_info->pixbuf = g_object_ref (loaded->pixbuf);
+      icon_info->scale = loaded->scale;
+      apply_emblems (icon_info);
+    }
+
+  return g_object_ref (icon_info->pixbuf);
+}
+
 /**
  * gtk_icon_info_set_raw_coordinates:
  * @icon_info: a #GtkIconInfo
@@ -3326,6 +4195,8 @@ gtk_icon_theme_add_builtin_icon (const gchar *icon_name,
   /* Replaces value, leaves key untouched
    */
   g_hash_table_insert (icon_theme_builtin_icons, key, icons);
+
+  builtin_icons_serial++;
 }
 
 /* Look up a builtin icon; the min_difference_p and
@@ -3425,6 +4296,7 @@ _gtk_icon_theme_check_reload (GdkDisplay *display)
 }
 
 
+
 /**
  * gtk_icon_theme_lookup_by_gicon:
  * @icon_theme: a #GtkIconTheme
@@ -45,6 +45,11 @@ struct _GtkImagePrivate
   gchar *filename;
 
   gint pixel_size;
+
+  /* Only used with GTK_IMAGE_ICON_NAME, GTK_IMAGE_GICON */
+  guint load_async : 1;
+  GCancellable *load_cancellable;
+  gint load_size;
 };
 
 #define GTK_IMAGE_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_IMAGE, GtkImagePrivate))
@@ -63,6 +68,7 @@ static void gtk_image_screen_changed (GtkWidget    *widget,
 				      GdkScreen    *prev_screen);
 static void gtk_image_destroy      (GtkObject      *object);
 static void gtk_image_reset        (GtkImage       *image);
+static void gtk_image_cancel_load  (GtkImage       *image);
 static void gtk_image_calc_size    (GtkImage       *image);
 
 static void gtk_image_update_size  (GtkImage       *image,
@@ -95,7 +101,8 @@ enum
   PROP_PIXBUF_ANIMATION,
   PROP_ICON_NAME,
   PROP_STORAGE_TYPE,
-  PROP_GICON
+  PROP_GICON,
+  PROP_LOAD_ASYNC
 };
 
 G_DEFINE_TYPE (GtkImage, gtk_image, GTK_TYPE_MISC)
@@ -258,6 +265,23 @@ gtk_image_class_init (GtkImageClass *class)
                                                       GTK_IMAGE_EMPTY,
                                                       GTK_PARAM_READABLE));
 
+  /**
+   * GtkImage:load-async:
+   *
+   * Whether named and #GIcon images are loaded asynchronously.
+   * While the icon is loading, the image is blank, but takes
+   * the size of the icon.
+   *
+   * Since: 2.16
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_LOAD_ASYNC,
+                                   g_param_spec_boolean ("load-async",
+                                                         P_("Load asynchronously"),
+                                                         P_("Whether icons are loaded without blocking"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
+
   g_type_class_add_private (object_class, sizeof (GtkImagePrivate));
 }
 
@@ -379,6 +403,9 @@ gtk_image_set_property (GObject      *object,
       gtk_image_set_from_gicon (image, g_value_get_object (value),
 				image->icon_size);
       break;
+    case PROP_LOAD_ASYNC:
+      gtk_image_set_load_async (image, g_value_get_boolean (value));
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -477,6 +504,9 @@ gtk_image_get_property (GObject     *object,
     case PROP_STORAGE_TYPE:
       g_value_set_enum (value, image->storage_type);
       break;
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, priv->load_async);
+      break;
       
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1499,6 +1529,8 @@ animation_timeout (gpointer data)
 static void
 icon_theme_changed (GtkImage *image)
 {
+  gtk_image_cancel_load (image);
+
   if (image->storage_type == GTK_IMAGE_ICON_NAME) 
     {
       if (image->data.name.pixbuf)
@@ -1517,6 +1549,111 @@ icon_theme_changed (GtkImage *image)
     }
 }
 
+typedef struct
+{
+  GtkImage *image;
+  GtkIconInfo *info;
+  GCancellable *cancellable;
+} AsyncLoad;
+
+static void
+gtk_image_cancel_load (GtkImage *image)
+{
+  GtkImagePrivate *priv = GTK_IMAGE_GET_PRIVATE (image);
+
+  if (priv->load_cancellable)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_object_unref (priv->load_cancellable);
+      priv->load_cancellable = NULL;
+    }
+}
+
+static void
+icon_loaded_cb (GObject      *source,
+		GAsyncResult *result,
+		gpointer      user_data)
+{
+  AsyncLoad *load = user_data;
+  GtkImage *image = load->image;
+  GtkImagePrivate *priv;
+  GdkPixbuf *pixbuf;
+
+  gdk_threads_enter ();
+
+  priv = GTK_IMAGE_GET_PRIVATE (image);
+  pixbuf = gtk_icon_info_load_icon_finish (load->info, result, NULL);
+
+  /* Loads that were cancelled have been replaced or are no
+   * longer wanted; anything else is the current one
+   */
+  if (priv->load_cancellable == load->cancellable)
+    {
+      g_object_unref (priv->load_cancellable);
+      priv->load_cancellable = NULL;
+
+      if (pixbuf == NULL)
+	pixbuf = gtk_widget_render_icon (GTK_WIDGET (image),
+					 GTK_STOCK_MISSING_IMAGE,
+					 image->icon_size,
+					 NULL);
+
+      if (image->storage_type == GTK_IMAGE_ICON_NAME)
+	{
+	  image->data.name.pixbuf = pixbuf;
+	  pixbuf = NULL;
+	}
+      else if (image->storage_type == GTK_IMAGE_GICON)
+	{
+	  image->data.gicon.pixbuf = pixbuf;
+	  pixbuf = NULL;
+	}
+
+      gtk_widget_queue_resize (GTK_WIDGET (image));
+    }
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  g_object_unref (load->image);
+  g_object_unref (load->cancellable);
+  gtk_icon_info_free (load->info);
+  g_slice_free (AsyncLoad, load);
+
+  gdk_threads_leave ();
+}
+
+/* Starts loading the icon for a named or GIcon image; until the
+ * load finishes, the image is drawn blank at the given size.
+ * Returns %FALSE if there is no icon to load.
+ */
+static gboolean
+gtk_image_load_async (GtkImage    *image,
+		      GtkIconInfo *info,
+		      gint         size)
+{
+  GtkImagePrivate *priv = GTK_IMAGE_GET_PRIVATE (image);
+  AsyncLoad *load;
+
+  if (info == NULL)
+    return FALSE;
+
+  gtk_image_cancel_load (image);
+
+  priv->load_cancellable = g_cancellable_new ();
+  priv->load_size = size;
+
+  load = g_slice_new (AsyncLoad);
+  load->image = g_object_ref (image);
+  load->info = info;
+  load->cancellable = g_object_ref (priv->load_cancellable);
+
+  gtk_icon_info_load_icon_async (info, load->cancellable,
+				 icon_loaded_cb, load);
+
+  return TRUE;
+}
+
 static void
 ensure_pixbuf_for_icon_name (GtkImage *image)
 {
@@ -1536,7 +1673,7 @@ ensure_pixbuf_for_icon_name (GtkImage *image)
   icon_theme = gtk_icon_theme_get_for_screen (screen);
   settings = gtk_settings_get_for_screen (screen);
   flags = GTK_ICON_LOOKUP_USE_BUILTIN;
-  if (image->data.name.pixbuf == NULL)
+  if (image->data.name.pixbuf == NULL && !priv->load_cancellable)
     {
       if (priv->pixel_size != -1)
 	{
@@ -1585,13 +1722,25 @@ ensure_pixbuf_for_icon_name (GtkImage *image)
 	      width = height = 24;
 	    }
 	}
-      image->data.name.pixbuf =
-	gtk_icon_theme_load_icon (icon_theme,
-				  image->data.name.icon_name,
-				  MIN (width, height), flags, &error);
+      if (priv->load_async)
+	{
+	  GtkIconInfo *info;
+
+	  info = gtk_icon_theme_lookup_icon (icon_theme,
+					     image->data.name.icon_name,
+					     MIN (width, height), flags);
+	  if (gtk_image_load_async (image, info, MIN (width, height)))
+	    return;
+	}
+      else
+	image->data.name.pixbuf =
+	  gtk_icon_theme_load_icon (icon_theme,
+				    image->data.name.icon_name,
+				    MIN (width, height), flags, &error);
       if (image->data.name.pixbuf == NULL)
 	{
-	  g_error_free (error);
+	  if (error)
+	    g_error_free (error);
 	  image->data.name.pixbuf =
 	    gtk_widget_render_icon (GTK_WIDGET (image),
 				    GTK_STOCK_MISSING_IMAGE,
@@ -1619,7 +1768,7 @@ ensure_pixbuf_for_gicon (GtkImage *image)
   icon_theme = gtk_icon_theme_get_for_screen (screen);
   settings = gtk_settings_get_for_screen (screen);
   flags = GTK_ICON_LOOKUP_USE_BUILTIN;
-  if (image->data.gicon.pixbuf == NULL)
+  if (image->data.gicon.pixbuf == NULL && !priv->load_cancellable)
     {
       if (priv->pixel_size != -1)
 	{
@@ -1642,7 +1791,12 @@ ensure_pixbuf_for_gicon (GtkImage *image)
       info = gtk_icon_theme_lookup_by_gicon (icon_theme,
 					     image->data.gicon.icon,
 					     MIN (width, height), flags);
-      if (info)
+      if (priv->load_async)
+	{
+	  if (gtk_image_load_async (image, info, MIN (width, height)))
+	    return;
+	}
+      else if (info)
         {
           image->data.gicon.pixbuf = gtk_icon_info_load_icon (info, NULL);
           gtk_icon_info_free (info);
@@ -2018,6 +2172,8 @@ gtk_image_reset (GtkImage *image)
 
   priv = GTK_IMAGE_GET_PRIVATE (image);
 
+  gtk_image_cancel_load (image);
+
   g_object_freeze_notify (G_OBJECT (image));
   
   if (image->storage_type != GTK_IMAGE_EMPTY)
@@ -2205,6 +2361,14 @@ gtk_image_calc_size (GtkImage *image)
 
       g_object_unref (pixbuf);
     }
+  else if (GTK_IMAGE_GET_PRIVATE (image)->load_cancellable)
+    {
+      /* Reserve the space of the icon that is being loaded */
+      gint size = GTK_IMAGE_GET_PRIVATE (image)->load_size;
+
+      widget->requisition.width = size + GTK_MISC (image)->xpad * 2;
+      widget->requisition.height = size + GTK_MISC (image)->ypad * 2;
+    }
 }
 
 static void
@@ -2286,6 +2450,8 @@ gtk_image_set_pixel_size (GtkImage *image,
   if (priv->pixel_size != pixel_size)
     {
       priv->pixel_size = pixel_size;
+
+      gtk_image_cancel_load (image);
       
       if (image->storage_type == GTK_IMAGE_ICON_NAME)
 	{
@@ -2335,6 +2501,61 @@ gtk_image_get_pixel_size (GtkImage *image)
   return priv->pixel_size;
 }
 
+/**
+ * gtk_image_set_load_async:
+ * @image: a #GtkImage
+ * @load_async: whether to load icons asynchronously
+ *
+ * Sets whether icons of named and #GIcon images are loaded with
+ * gtk_icon_info_load_icon_async(), so that showing the image never
+ * waits for the icon to be read from disk. While the icon is loading,
+ * the image is blank.
+ *
+ * Since: 2.16
+ */
+void
+gtk_image_set_load_async (GtkImage *image,
+			  gboolean  load_async)
+{
+  GtkImagePrivate *priv;
+
+  g_return_if_fail (GTK_IS_IMAGE (image));
+
+  priv = GTK_IMAGE_GET_PRIVATE (image);
+
+  load_async = load_async != FALSE;
+
+  if (priv->load_async != load_async)
+    {
+      priv->load_async = load_async;
+
+      g_object_notify (G_OBJECT (image), "load-async");
+    }
+}
+
+/**
+ * gtk_image_get_load_async:
+ * @image: a #GtkImage
+ *
+ * Gets whether icons are loaded asynchronously.
+ * See gtk_image_set_load_async().
+ *
+ * Returns: %TRUE if icons are loaded asynchronously
+ *
+ * Since: 2.16
+ */
+gboolean
+gtk_image_get_load_async (GtkImage *image)
+{
+  GtkImagePrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_IMAGE (image), FALSE);
+
+  priv = GTK_IMAGE_GET_PRIVATE (image);
+
+  return priv->load_async;
+}
+
 #if defined (G_OS_WIN32) && !defined (_WIN64)
 
 #undef gtk_image_new_from_file
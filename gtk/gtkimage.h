@@ -205,6 +205,8 @@ void gtk_image_set_from_gicon     (GtkImage        *image,
 				   GtkIconSize      size);
 void gtk_image_set_pixel_size     (GtkImage        *image,
 				   gint             pixel_size);
+void gtk_image_set_load_async     (GtkImage        *image,
+				   gboolean         load_async);
 
 GtkImageType gtk_image_get_storage_type (GtkImage   *image);
 
@@ -229,6 +231,7 @@ void       gtk_image_get_gicon     (GtkImage              *image,
 				    GIcon                **gicon,
 				    GtkIconSize           *size);
 gint       gtk_image_get_pixel_size (GtkImage             *image);
+gboolean   gtk_image_get_load_async (GtkImage             *image);
 
 #ifndef GTK_DISABLE_DEPRECATED
 /* These three are deprecated */
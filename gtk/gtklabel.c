@@ -45,6 +45,7 @@
 #include "gtkstock.h"
 #include "gtkbindings.h"
 #include "gtkbuildable.h"
+#include "gtklayoutcache.h"
 #include "gtkprivate.h"
 #include "gtkalias.h"
 
@@ -55,6 +56,11 @@ typedef struct
   gint wrap_width;
   gint width_chars;
   gint max_width_chars;
+
+  /* label->layout comes from the layout cache and is shared */
+  guint layout_shared  : 1;
+  /* gtk_label_get_layout() was called, never share the layout */
+  guint private_layout : 1;
 }
 GtkLabelPrivate;
 
@@ -2328,11 +2334,66 @@ gtk_label_finalize (GObject *object)
 static void
 gtk_label_clear_layout (GtkLabel *label)
 {
+  GtkLabelPrivate *priv = GTK_LABEL_GET_PRIVATE (label);
+
   if (label->layout)
     {
       g_object_unref (label->layout);
       label->layout = NULL;
     }
+
+  priv->layout_shared = FALSE;
+}
+
+static void
+gtk_label_get_layout_key (GtkLabel          *label,
+                          GtkLayoutCacheKey *key)
+{
+  PangoLayout *layout = label->layout;
+
+  _gtk_layout_cache_key_init (key, pango_layout_get_text (layout));
+  key->attrs = pango_layout_get_attributes (layout);
+  key->width = pango_layout_get_width (layout);
+  key->ellipsize = pango_layout_get_ellipsize (layout);
+  key->wrap_mode = pango_layout_get_wrap (layout);
+  key->alignment = pango_layout_get_alignment (layout);
+  key->justify = pango_layout_get_justify (layout);
+  key->single_paragraph = pango_layout_get_single_paragraph_mode (layout);
+}
+
+/* Returns a layout like label->layout, but with the given width.
+ * A private layout is simply changed, a shared layout can't be
+ * changed, so a matching layout is looked up in the cache instead.
+ */
+static PangoLayout *
+gtk_label_get_layout_for_width (GtkLabel *label,
+                                gint      width)
+{
+  GtkLabelPrivate *priv = GTK_LABEL_GET_PRIVATE (label);
+  GtkLayoutCacheKey key;
+  PangoLayout *layout;
+
+  if (!priv->layout_shared)
+    {
+      pango_layout_set_width (label->layout, width);
+
+      return g_object_ref (label->layout);
+    }
+
+  if (pango_layout_get_width (label->layout) == width)
+    return g_object_ref (label->layout);
+
+  gtk_label_get_layout_key (label, &key);
+  key.width = width;
+
+  layout = _gtk_layout_cache_lookup (GTK_WIDGET (label), &key);
+  if (!layout)
+    {
+      layout = pango_layout_copy (label->layout);
+      pango_layout_set_width (layout, width);
+    }
+
+  return layout;
 }
 
 static gint
@@ -2356,10 +2417,12 @@ get_label_char_width (GtkLabel *label)
   
   if (priv->width_chars < 0)
     {
+      PangoLayout *layout;
       PangoRectangle rect;
-      
-      pango_layout_set_width (label->layout, -1);
-      pango_layout_get_extents (label->layout, NULL, &rect);
+
+      layout = gtk_label_get_layout_for_width (label, -1);
+      pango_layout_get_extents (layout, NULL, &rect);
+      g_object_unref (layout);
       
       w = char_pixels * MAX (priv->max_width_chars, 3);
       w = MIN (rect.width, w);
@@ -2408,20 +2471,46 @@ get_label_wrap_width (GtkLabel *label)
   return priv->wrap_width;
 }
 
+static gboolean
+gtk_label_can_share_layout (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = GTK_LABEL_GET_PRIVATE (label);
+  GtkWidgetAuxInfo *aux_info;
+
+  if (priv->private_layout || label->select_info || label->have_transform)
+    return FALSE;
+
+  /* Wrapping without a set width searches for a balanced width
+   * by shaping the text repeatedly, that isn't worth caching.
+   */
+  if (label->wrap && !label->ellipsize)
+    {
+      aux_info = _gtk_widget_get_aux_info (GTK_WIDGET (label), FALSE);
+
+      if (!aux_info || aux_info->width <= 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gtk_label_ensure_layout (GtkLabel *label)
 {
   GtkWidget *widget;
+  GtkLabelPrivate *priv;
   PangoRectangle logical_rect;
   gboolean rtl;
 
   widget = GTK_WIDGET (label);
+  priv = GTK_LABEL_GET_PRIVATE (label);
 
   rtl = gtk_widget_get_direction(widget) == GTK_TEXT_DIR_RTL;
 
   if (!label->layout)
     {
       PangoAlignment align = PANGO_ALIGN_LEFT; /* Quiet gcc */
+      gboolean justify = FALSE;
       gdouble angle = gtk_label_get_angle (label);
 
       if (angle != 0.0 && !label->wrap && !label->ellipsize && !label->select_info)
@@ -2446,11 +2535,6 @@ gtk_label_ensure_layout (GtkLabel *label)
 	  label->have_transform = FALSE;
 	}
 
-      label->layout = gtk_widget_create_pango_layout (widget, label->text);
-
-      if (label->effective_attrs)
-	pango_layout_set_attributes (label->layout, label->effective_attrs);
-      
       switch (label->jtype)
 	{
 	case GTK_JUSTIFY_LEFT:
@@ -2464,12 +2548,49 @@ gtk_label_ensure_layout (GtkLabel *label)
 	  break;
 	case GTK_JUSTIFY_FILL:
 	  align = rtl ? PANGO_ALIGN_RIGHT : PANGO_ALIGN_LEFT;
-	  pango_layout_set_justify (label->layout, TRUE);
+	  justify = TRUE;
 	  break;
 	default:
 	  g_assert_not_reached();
 	}
 
+      if (gtk_label_can_share_layout (label))
+        {
+          GtkLayoutCacheKey key;
+          GtkWidgetAuxInfo *aux_info;
+
+          _gtk_layout_cache_key_init (&key, label->text);
+          key.attrs = label->effective_attrs;
+          key.alignment = align;
+          key.justify = justify;
+          key.ellipsize = label->ellipsize;
+          key.single_paragraph = label->single_line_mode;
+
+          if (label->ellipsize)
+            key.width = widget->allocation.width * PANGO_SCALE;
+          else if (label->wrap)
+            {
+              aux_info = _gtk_widget_get_aux_info (widget, FALSE);
+              key.wrap_mode = label->wrap_mode;
+              key.width = aux_info->width * PANGO_SCALE;
+            }
+
+          label->layout = _gtk_layout_cache_lookup (widget, &key);
+          if (label->layout)
+            {
+              priv->layout_shared = TRUE;
+              return;
+            }
+        }
+
+      priv->layout_shared = FALSE;
+
+      label->layout = gtk_widget_create_pango_layout (widget, label->text);
+
+      if (label->effective_attrs)
+	pango_layout_set_attributes (label->layout, label->effective_attrs);
+
+      pango_layout_set_justify (label->layout, justify);
       pango_layout_set_alignment (label->layout, align);
       pango_layout_set_ellipsize (label->layout, label->ellipsize);
       pango_layout_set_single_paragraph_mode (label->layout, label->single_line_mode);
@@ -2652,16 +2773,23 @@ gtk_label_size_allocate (GtkWidget     *widget,
     {
       if (label->layout)
 	{
+	  PangoLayout *layout;
 	  gint width;
 	  PangoRectangle logical;
 
 	  width = (allocation->width - label->misc.xpad * 2) * PANGO_SCALE;
 
-	  pango_layout_set_width (label->layout, -1);
-	  pango_layout_get_extents (label->layout, NULL, &logical);
+	  layout = gtk_label_get_layout_for_width (label, -1);
+	  pango_layout_get_extents (layout, NULL, &logical);
 
 	  if (logical.width > width)
-	    pango_layout_set_width (label->layout, width);
+	    {
+	      g_object_unref (layout);
+	      layout = gtk_label_get_layout_for_width (label, width);
+	    }
+
+	  g_object_unref (label->layout);
+	  label->layout = layout;
 	}
     }
 
@@ -2722,8 +2850,14 @@ gtk_label_direction_changed (GtkWidget        *widget,
 			     GtkTextDirection previous_dir)
 {
   GtkLabel *label = GTK_LABEL (widget);
+  GtkLabelPrivate *priv = GTK_LABEL_GET_PRIVATE (label);
 
-  if (label->layout)
+  /* A shared layout has a context of its own, look up a
+   * layout for the new direction instead.
+   */
+  if (priv->layout_shared)
+    gtk_label_clear_layout (label);
+  else if (label->layout)
     pango_layout_context_changed (label->layout);
 
   GTK_WIDGET_CLASS (gtk_label_parent_class)->direction_changed (widget, previous_dir);
@@ -3996,6 +4130,31 @@ gtk_label_get_selection_bounds (GtkLabel  *label,
  **/
 PangoLayout*
 gtk_label_get_layout (GtkLabel *label)
+{
+  GtkLabelPrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_LABEL (label), NULL);
+
+  priv = GTK_LABEL_GET_PRIVATE (label);
+
+  /* The caller may change the layout, so it can't be shared */
+  if (!priv->private_layout)
+    {
+      priv->private_layout = TRUE;
+      if (priv->layout_shared)
+        gtk_label_clear_layout (label);
+    }
+
+  gtk_label_ensure_layout (label);
+
+  return label->layout;
+}
+
+/* Like gtk_label_get_layout(), but the returned layout may be
+ * shared with other labels and must not be modified.
+ */
+PangoLayout *
+_gtk_label_peek_layout (GtkLabel *label)
 {
   g_return_val_if_fail (GTK_IS_LABEL (label), NULL);
 
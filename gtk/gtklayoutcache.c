@@ -0,0 +1,473 @@
+/* GTK - The GIMP Toolkit
+ * gtklayoutcache.c: Shared cache of shaped PangoLayouts
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Widgets that show the same short strings over and over (labels in
+ * dashboards, menu accelerators, tree view cells) spend most of their
+ * size negotiation shaping identical text. This cache keeps shaped
+ * PangoLayouts around, keyed by everything that affects the result,
+ * so that such widgets can share one layout.
+ *
+ * The layouts handed out are shared, callers must treat them as
+ * read-only. Each layout uses a PangoContext owned by the cache,
+ * set up like the context of the widget that caused it to be
+ * created, so later changes to a widget's context can't affect the
+ * shared layout. The cache is kept below a size limit by dropping
+ * the least recently used layouts; the limit can be set in kilobytes
+ * with the GTK_LAYOUT_CACHE_SIZE environment variable, 0 disables
+ * the cache. With GTK_DEBUG=misc, the hits and misses are reported
+ * every 1024 misses and at exit.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pango/pangocairo.h>
+
+#include "gtklayoutcache.h"
+#include "gtkdebug.h"
+#include "gtkalias.h"
+
+#define DEFAULT_MAX_SIZE   (4 * 1024 * 1024)
+
+/* Long texts are rarely shown more than once, and are
+ * expensive to hash and compare.
+ */
+#define MAX_TEXT_LENGTH    1024
+
+/* Rough estimate of the memory used by a layout, the fixed part
+ * covers the layout, context and entry, the per byte part the
+ * lines, runs and glyph strings.
+ */
+#define ENTRY_OVERHEAD     512
+#define BYTES_PER_CHAR     48
+
+typedef struct
+{
+  /* Layout parameters */
+  gchar *text;
+  PangoAttrList *attrs;
+  gint width;
+  PangoEllipsizeMode ellipsize;
+  PangoWrapMode wrap_mode;
+  PangoAlignment alignment;
+  gboolean justify;
+  gboolean single_paragraph;
+
+  /* Context parameters */
+  GdkScreen *screen;
+  PangoFontDescription *font_desc;
+  PangoDirection base_dir;
+  PangoLanguage *language;
+  gdouble resolution;
+  cairo_font_options_t *font_options;
+
+  guint hash;
+
+  PangoLayout *layout;
+  gsize size;
+  GList *link;
+} CacheEntry;
+
+typedef struct
+{
+  GHashTable *entries;
+
+  /* Most recently used first */
+  GQueue lru;
+
+  gsize size;
+  gsize max_size;
+
+  guint hits;
+  guint misses;
+  guint evictions;
+} LayoutCache;
+
+static LayoutCache *cache = NULL;
+
+static gboolean
+collect_attr (PangoAttribute *attr,
+              gpointer        data)
+{
+  GSList **list = data;
+
+  *list = g_slist_prepend (*list, attr);
+
+  return FALSE;
+}
+
+static GSList *
+list_attrs (PangoAttrList *attrs)
+{
+  GSList *list = NULL;
+
+  if (attrs)
+    pango_attr_list_filter (attrs, collect_attr, &list);
+
+  return list;
+}
+
+static guint
+attrs_hash (PangoAttrList *attrs)
+{
+  GSList *list, *l;
+  guint hash = 0;
+
+  list = list_attrs (attrs);
+
+  for (l = list; l; l = l->next)
+    {
+      PangoAttribute *attr = l->data;
+
+      hash = (hash << 5) - hash + attr->klass->type;
+      hash ^= attr->start_index * 7 + attr->end_index * 13;
+    }
+
+  g_slist_free (list);
+
+  return hash;
+}
+
+static gboolean
+attrs_equal (PangoAttrList *a,
+             PangoAttrList *b)
+{
+  GSList *list_a, *list_b, *la, *lb;
+  gboolean equal = TRUE;
+
+  if (a == b)
+    return TRUE;
+
+  list_a = list_attrs (a);
+  list_b = list_attrs (b);
+
+  for (la = list_a, lb = list_b; la && lb; la = la->next, lb = lb->next)
+    {
+      PangoAttribute *attr_a = la->data;
+      PangoAttribute *attr_b = lb->data;
+
+      if (attr_a->start_index != attr_b->start_index ||
+          attr_a->end_index != attr_b->end_index ||
+          !pango_attribute_equal (attr_a, attr_b))
+        {
+          equal = FALSE;
+          break;
+        }
+    }
+
+  if (la || lb)
+    equal = FALSE;
+
+  g_slist_free (list_a);
+  g_slist_free (list_b);
+
+  return equal;
+}
+
+static guint
+entry_hash (gconstpointer data)
+{
+  const CacheEntry *entry = data;
+
+  return entry->hash;
+}
+
+static gboolean
+entry_equal (gconstpointer a,
+             gconstpointer b)
+{
+  const CacheEntry *entry_a = a;
+  const CacheEntry *entry_b = b;
+
+  return entry_a->hash == entry_b->hash &&
+    entry_a->width == entry_b->width &&
+    entry_a->ellipsize == entry_b->ellipsize &&
+    entry_a->wrap_mode == entry_b->wrap_mode &&
+    entry_a->alignment == entry_b->alignment &&
+    entry_a->justify == entry_b->justify &&
+    entry_a->single_paragraph == entry_b->single_paragraph &&
+    entry_a->screen == entry_b->screen &&
+    entry_a->base_dir == entry_b->base_dir &&
+    entry_a->language == entry_b->language &&
+    entry_a->resolution == entry_b->resolution &&
+    strcmp (entry_a->text, entry_b->text) == 0 &&
+    pango_font_description_equal (entry_a->font_desc, entry_b->font_desc) &&
+    (entry_a->font_options == entry_b->font_options ||
+     (entry_a->font_options && entry_b->font_options &&
+      cairo_font_options_equal (entry_a->font_options, entry_b->font_options))) &&
+    attrs_equal (entry_a->attrs, entry_b->attrs);
+}
+
+static void
+entry_free (CacheEntry *entry)
+{
+  g_free (entry->text);
+  if (entry->attrs)
+    pango_attr_list_unref (entry->attrs);
+  pango_font_description_free (entry->font_desc);
+  if (entry->font_options)
+    cairo_font_options_destroy (entry->font_options);
+  g_object_unref (entry->layout);
+  g_free (entry);
+}
+
+static void
+remove_entry (CacheEntry *entry)
+{
+  g_queue_delete_link (&cache->lru, entry->link);
+  g_hash_table_remove (cache->entries, entry);
+  cache->size -= entry->size;
+
+  entry_free (entry);
+}
+
+static void
+display_closed (GdkDisplay *display,
+                gboolean    is_error,
+                gpointer    data)
+{
+  _gtk_layout_cache_flush ();
+}
+
+static LayoutCache *
+get_cache (void)
+{
+  if (!cache)
+    {
+      const gchar *env;
+
+      cache = g_new0 (LayoutCache, 1);
+      cache->entries = g_hash_table_new (entry_hash, entry_equal);
+      g_queue_init (&cache->lru);
+      cache->max_size = DEFAULT_MAX_SIZE;
+
+      env = g_getenv ("GTK_LAYOUT_CACHE_SIZE");
+      if (env)
+        cache->max_size = (gsize) strtoul (env, NULL, 10) * 1024;
+    }
+
+  return cache;
+}
+
+#ifdef G_ENABLE_DEBUG
+static void
+print_stats (void)
+{
+  g_print ("layout cache: %u entries, %" G_GSIZE_FORMAT " bytes, "
+           "%u hits, %u misses, %u evictions\n",
+           g_hash_table_size (cache->entries), cache->size,
+           cache->hits, cache->misses, cache->evictions);
+}
+
+static void
+print_stats_at_exit (void)
+{
+  static gboolean registered = FALSE;
+
+  if (!registered)
+    {
+      g_atexit (print_stats);
+      registered = TRUE;
+    }
+}
+#endif
+
+static void
+trim_cache (void)
+{
+  while (cache->size > cache->max_size && cache->lru.tail)
+    {
+      remove_entry (cache->lru.tail->data);
+      cache->evictions++;
+    }
+}
+
+/**
+ * _gtk_layout_cache_key_init:
+ * @key: a #GtkLayoutCacheKey
+ * @text: the text of the layout
+ *
+ * Initializes @key with the settings of a newly created #PangoLayout.
+ */
+void
+_gtk_layout_cache_key_init (GtkLayoutCacheKey *key,
+                            const gchar       *text)
+{
+  key->text = text;
+  key->attrs = NULL;
+  key->width = -1;
+  key->ellipsize = PANGO_ELLIPSIZE_NONE;
+  key->wrap_mode = PANGO_WRAP_WORD;
+  key->alignment = PANGO_ALIGN_LEFT;
+  key->justify = FALSE;
+  key->single_paragraph = FALSE;
+}
+
+/**
+ * _gtk_layout_cache_lookup:
+ * @widget: the widget the layout is for
+ * @key: the parameters of the layout
+ *
+ * Looks for a layout described by @key, for a context like the
+ * one of @widget, creating it if necessary. The returned layout
+ * may be shared with other widgets, so it must not be modified.
+ *
+ * Return value: a new reference to a shared #PangoLayout, or %NULL
+ *   if the layout can't be cached. In that case the caller should
+ *   create a layout of its own.
+ */
+PangoLayout *
+_gtk_layout_cache_lookup (GtkWidget               *widget,
+                          const GtkLayoutCacheKey *key)
+{
+  PangoContext *widget_context;
+  PangoContext *context;
+  const cairo_font_options_t *font_options;
+  CacheEntry probe;
+  CacheEntry *entry;
+
+  get_cache ();
+
+  GTK_NOTE (MISC, print_stats_at_exit ());
+
+  if (cache->max_size == 0)
+    return NULL;
+
+  if (!key->text || strlen (key->text) > MAX_TEXT_LENGTH)
+    return NULL;
+
+  widget_context = gtk_widget_get_pango_context (widget);
+
+  /* Transformed contexts are rare, don't bother */
+  if (pango_context_get_matrix (widget_context))
+    return NULL;
+
+  font_options = pango_cairo_context_get_font_options (widget_context);
+
+  probe.text = (gchar *) key->text;
+  probe.attrs = key->attrs;
+  probe.width = key->width;
+  probe.ellipsize = key->ellipsize;
+  probe.wrap_mode = key->wrap_mode;
+  probe.alignment = key->alignment;
+  probe.justify = key->justify;
+  probe.single_paragraph = key->single_paragraph;
+  probe.screen = gtk_widget_get_screen (widget);
+  probe.font_desc = (PangoFontDescription *) pango_context_get_font_description (widget_context);
+  probe.base_dir = pango_context_get_base_dir (widget_context);
+  probe.language = pango_context_get_language (widget_context);
+  probe.resolution = pango_cairo_context_get_resolution (widget_context);
+  probe.font_options = (cairo_font_options_t *) font_options;
+
+  probe.hash = g_str_hash (probe.text);
+  probe.hash ^= attrs_hash (probe.attrs);
+  probe.hash ^= probe.width * 31;
+  probe.hash ^= (probe.ellipsize << 3) | (probe.wrap_mode << 5) | (probe.alignment << 7);
+  probe.hash ^= (probe.justify << 9) | (probe.single_paragraph << 10) | (probe.base_dir << 11);
+  probe.hash ^= pango_font_description_hash (probe.font_desc);
+  probe.hash ^= GPOINTER_TO_UINT (probe.screen) ^ GPOINTER_TO_UINT (probe.language);
+  probe.hash ^= (guint) probe.resolution;
+  if (font_options)
+    probe.hash ^= cairo_font_options_hash (font_options);
+
+  entry = g_hash_table_lookup (cache->entries, &probe);
+
+  if (entry)
+    {
+      cache->hits++;
+
+      g_queue_unlink (&cache->lru, entry->link);
+      g_queue_push_head_link (&cache->lru, entry->link);
+
+      return g_object_ref (entry->layout);
+    }
+
+  cache->misses++;
+
+  entry = g_new0 (CacheEntry, 1);
+  *entry = probe;
+  entry->text = g_strdup (probe.text);
+  entry->attrs = probe.attrs ? pango_attr_list_copy (probe.attrs) : NULL;
+  entry->font_desc = pango_font_description_copy (probe.font_desc);
+  entry->font_options = font_options ? cairo_font_options_copy (font_options) : NULL;
+
+  context = gdk_pango_context_get_for_screen (probe.screen);
+  pango_context_set_font_description (context, entry->font_desc);
+  pango_context_set_base_dir (context, entry->base_dir);
+  pango_context_set_language (context, entry->language);
+  pango_cairo_context_set_resolution (context, entry->resolution);
+  pango_cairo_context_set_font_options (context, entry->font_options);
+
+  entry->layout = pango_layout_new (context);
+  g_object_unref (context);
+
+  pango_layout_set_text (entry->layout, entry->text, -1);
+  if (entry->attrs)
+    pango_layout_set_attributes (entry->layout, entry->attrs);
+  pango_layout_set_width (entry->layout, entry->width);
+  pango_layout_set_ellipsize (entry->layout, entry->ellipsize);
+  pango_layout_set_wrap (entry->layout, entry->wrap_mode);
+  pango_layout_set_alignment (entry->layout, entry->alignment);
+  pango_layout_set_justify (entry->layout, entry->justify);
+  pango_layout_set_single_paragraph_mode (entry->layout, entry->single_paragraph);
+
+  entry->size = ENTRY_OVERHEAD + strlen (entry->text) * BYTES_PER_CHAR;
+
+  g_hash_table_insert (cache->entries, entry, entry);
+  g_queue_push_head (&cache->lru, entry);
+  entry->link = cache->lru.head;
+  cache->size += entry->size;
+
+  if (!g_object_get_data (G_OBJECT (gdk_screen_get_display (probe.screen)),
+                          "gtk-layout-cache-connected"))
+    {
+      GdkDisplay *display = gdk_screen_get_display (probe.screen);
+
+      g_object_set_data (G_OBJECT (display), "gtk-layout-cache-connected",
+                         GINT_TO_POINTER (TRUE));
+      g_signal_connect (display, "closed", G_CALLBACK (display_closed), NULL);
+    }
+
+  trim_cache ();
+
+  GTK_NOTE (MISC,
+            if (cache->misses % 1024 == 0)
+              print_stats ());
+
+  return g_object_ref (entry->layout);
+}
+
+/**
+ * _gtk_layout_cache_flush:
+ *
+ * Drops all layouts from the cache. This needs to be called when
+ * the fonts change in a way that is not reflected in the contexts,
+ * e.g. when fonts get installed.
+ */
+void
+_gtk_layout_cache_flush (void)
+{
+  if (!cache)
+    return;
+
+  while (cache->lru.head)
+    remove_entry (cache->lru.head->data);
+}
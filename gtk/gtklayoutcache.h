@@ -0,0 +1,56 @@
+/* GTK - The GIMP Toolkit
+ * gtklayoutcache.h: Shared cache of shaped PangoLayouts
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_LAYOUT_CACHE_H__
+#define __GTK_LAYOUT_CACHE_H__
+
+#include <pango/pango.h>
+#include <gtk/gtklabel.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkLayoutCacheKey   GtkLayoutCacheKey;
+
+/* Everything that determines the shaped result of a layout,
+ * apart from the PangoContext, which is taken from the widget.
+ */
+struct _GtkLayoutCacheKey
+{
+  const gchar        *text;
+  PangoAttrList      *attrs;
+  gint                width;
+  PangoEllipsizeMode  ellipsize;
+  PangoWrapMode       wrap_mode;
+  PangoAlignment      alignment;
+  guint               justify          : 1;
+  guint               single_paragraph : 1;
+};
+
+void         _gtk_layout_cache_key_init   (GtkLayoutCacheKey       *key,
+                                           const gchar             *text);
+PangoLayout *_gtk_layout_cache_lookup     (GtkWidget               *widget,
+                                           const GtkLayoutCacheKey *key);
+void         _gtk_layout_cache_flush      (void);
+
+/* in gtklabel.c */
+PangoLayout *_gtk_label_peek_layout       (GtkLabel                *label);
+
+G_END_DECLS
+
+#endif /* __GTK_LAYOUT_CACHE_H__ */
@@ -53,6 +53,7 @@
 #include "gtkdnd.h"
 #include "gtkversion.h"
 #include "gtkmain.h"
+#include "gtkmemoryaudit.h"
 #include "gtkmodules.h"
 #include "gtkrc.h"
 #include "gtkrecentmanager.h"
@@ -65,6 +66,7 @@
 #include "gtkalias.h"
 
 #include "gdk/gdkprivate.h" /* for GDK_WINDOW_DESTROYED */
+#include "gdk/gdkkeysyms.h"
 
 #ifdef G_OS_WIN32
 
@@ -214,7 +216,9 @@ static const GDebugKey gtk_debug_keys[] = {
   {"geometry", GTK_DEBUG_GEOMETRY},
   {"icontheme", GTK_DEBUG_ICONTHEME},
   {"printing", GTK_DEBUG_PRINTING},
-  {"builder", GTK_DEBUG_BUILDER}
+  {"builder", GTK_DEBUG_BUILDER},
+  {"signals", GTK_DEBUG_SIGNALS},
+  {"memory", GTK_DEBUG_MEMORY}
 };
 #endif /* G_ENABLE_DEBUG */
 
@@ -672,6 +676,24 @@ gettext_initialization (void)
 #endif  
 }
 
+/* With GTK_DEBUG=memory, Control-Shift-M prints a memory report
+ */
+static gint
+memory_audit_snooper (GtkWidget   *grab_widget,
+		      GdkEventKey *event,
+		      gpointer     data)
+{
+  if (event->type == GDK_KEY_PRESS &&
+      (event->keyval == GDK_M || event->keyval == GDK_m) &&
+      (event->state & gtk_accelerator_get_default_mod_mask ()) == (GDK_CONTROL_MASK | GDK_SHIFT_MASK))
+    {
+      gtk_memory_audit_print ();
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 static void
 do_post_parse_initialization (int    *argc,
 			      char ***argv)
@@ -693,6 +715,9 @@ do_post_parse_initialization (int    *argc,
   if (gtk_debug_flags & GTK_DEBUG_UPDATES)
     gdk_window_set_debug_updates (TRUE);
 
+  if (gtk_debug_flags & GTK_DEBUG_MEMORY)
+    gtk_key_snooper_install (memory_audit_snooper, NULL);
+
   {
   /* Translate to default:RTL if you want your widgets
    * to be RTL, otherwise translate to default:LTR.
@@ -1429,8 +1454,8 @@ rewrite_event_for_grabs (GdkEvent *event)
     return NULL;
 }
 
-void 
-gtk_main_do_event (GdkEvent *event)
+static void
+gtk_main_dispatch_event (GdkEvent *event)
 {
   GtkWidget *event_widget;
   GtkWidget *grab_widget;
@@ -1646,6 +1671,22 @@ gtk_main_do_event (GdkEvent *event)
     gdk_event_free (rewritten_event);
 }
 
+void 
+gtk_main_do_event (GdkEvent *event)
+{
+  if (G_UNLIKELY (gdk_trace_is_enabled ()))
+    {
+      guint32 id = gdk_trace_get_event_id (event);
+      GdkEventType type = event->type;
+
+      gdk_trace_record (GDK_TRACE_DISPATCH_BEGIN, id, type);
+      gtk_main_dispatch_event (event);
+      gdk_trace_record (GDK_TRACE_DISPATCH_END, id, type);
+    }
+  else
+    gtk_main_dispatch_event (event);
+}
+
 gboolean
 gtk_true (void)
 {
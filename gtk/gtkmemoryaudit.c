@@ -0,0 +1,345 @@
+/* GTK - The GIMP Toolkit
+ * gtkmemoryaudit.c: Per type accounting of widget tree memory
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "gtkcontainer.h"
+#include "gtkentry.h"
+#include "gtkimage.h"
+#include "gtklabel.h"
+#include "gtkmemoryaudit.h"
+#include "gtkstyle.h"
+#include "gtkwindow.h"
+#include "gtkalias.h"
+
+/**
+ * SECTION:gtkmemoryaudit
+ * @short_description: Accounting of the memory used by widget trees
+ *
+ * gtk_memory_audit() reports how many widgets, styles, graphics
+ * contexts, Pango layouts, windows and pixmaps the widget trees
+ * of an application use, and estimates the memory they take,
+ * by type. This is meant to find where memory goes in long
+ * running applications, and to let tests check for leaks.
+ */
+
+typedef struct
+{
+  GType  type;
+  guint  n_instances;
+  gsize  size;
+  gsize  server_size;
+} AuditEntry;
+
+typedef struct
+{
+  GHashTable *seen;     /* objects already accounted for */
+  GHashTable *entries;  /* GType -> AuditEntry */
+} MemoryAudit;
+
+static gsize
+type_instance_size (GType type)
+{
+  GTypeQuery query;
+
+  g_type_query (type, &query);
+
+  return query.instance_size;
+}
+
+static void
+audit_add (MemoryAudit *audit,
+	   GType        type,
+	   gsize        size,
+	   gsize        server_size)
+{
+  AuditEntry *entry;
+
+  entry = g_hash_table_lookup (audit->entries, GSIZE_TO_POINTER (type));
+  if (!entry)
+    {
+      entry = g_new0 (AuditEntry, 1);
+      entry->type = type;
+      g_hash_table_insert (audit->entries, GSIZE_TO_POINTER (type), entry);
+    }
+
+  entry->n_instances++;
+  entry->size += size;
+  entry->server_size += server_size;
+}
+
+/* Adds @object once, no matter how many widgets share it.
+ * Returns %FALSE if it was accounted for already.
+ */
+static gboolean
+audit_object (MemoryAudit *audit,
+	      gpointer     object,
+	      gsize        extra_size,
+	      gsize        server_size)
+{
+  GType type;
+
+  if (!object || g_hash_table_lookup (audit->seen, object))
+    return FALSE;
+
+  g_hash_table_insert (audit->seen, object, object);
+
+  type = G_OBJECT_TYPE (object);
+  audit_add (audit, type, type_instance_size (type) + extra_size, server_size);
+
+  return TRUE;
+}
+
+/* The X server pads pixels to 8, 16 or 32 bits, except for
+ * bitmaps.
+ */
+static gsize
+pixmap_server_size (GdkPixmap *pixmap)
+{
+  gint width, height, depth, bits;
+
+  gdk_drawable_get_size (pixmap, &width, &height);
+  depth = gdk_drawable_get_depth (pixmap);
+
+  if (depth == 1)
+    bits = 1;
+  else if (depth <= 8)
+    bits = 8;
+  else if (depth <= 16)
+    bits = 16;
+  else
+    bits = 32;
+
+  return (gsize) ((width * bits + 7) / 8) * height;
+}
+
+static void
+audit_pixmap (MemoryAudit *audit,
+	      GdkPixmap   *pixmap)
+{
+  GdkDrawable *impl;
+
+  if (!pixmap || pixmap == (GdkPixmap *) GDK_PARENT_RELATIVE)
+    return;
+
+  impl = GDK_PIXMAP_OBJECT (pixmap)->impl;
+  audit_object (audit, pixmap,
+		impl ? type_instance_size (G_OBJECT_TYPE (impl)) : 0,
+		pixmap_server_size (pixmap));
+}
+
+static void
+audit_window (MemoryAudit *audit,
+	      GdkWindow   *window)
+{
+  GdkWindowObject *private = (GdkWindowObject *) window;
+  GList *l;
+
+  if (!window ||
+      !audit_object (audit, window,
+		     private->impl ? type_instance_size (G_OBJECT_TYPE (private->impl)) : 0,
+		     0))
+    return;
+
+  audit_pixmap (audit, private->bg_pixmap);
+
+  for (l = gdk_window_peek_children (window); l; l = l->next)
+    audit_window (audit, l->data);
+}
+
+static void
+audit_style (MemoryAudit *audit,
+	     GtkStyle    *style)
+{
+  gint i;
+
+  if (!audit_object (audit, style, 0, 0))
+    return;
+
+  for (i = 0; i < 5; i++)
+    {
+      audit_object (audit, style->fg_gc[i], 0, 0);
+      audit_object (audit, style->bg_gc[i], 0, 0);
+      audit_object (audit, style->light_gc[i], 0, 0);
+      audit_object (audit, style->dark_gc[i], 0, 0);
+      audit_object (audit, style->mid_gc[i], 0, 0);
+      audit_object (audit, style->text_gc[i], 0, 0);
+      audit_object (audit, style->base_gc[i], 0, 0);
+      audit_object (audit, style->text_aa_gc[i], 0, 0);
+      audit_pixmap (audit, style->bg_pixmap[i]);
+    }
+
+  audit_object (audit, style->black_gc, 0, 0);
+  audit_object (audit, style->white_gc, 0, 0);
+}
+
+/* Layouts are estimated by their text and lines; the glyph
+ * strings Pango keeps for each run aren't reachable from here.
+ */
+static void
+audit_layout (MemoryAudit *audit,
+	      PangoLayout *layout)
+{
+  const gchar *text;
+
+  if (!layout)
+    return;
+
+  text = pango_layout_get_text (layout);
+  audit_object (audit, layout,
+		(text ? strlen (text) + 1 : 0) +
+		pango_layout_get_line_count (layout) * sizeof (PangoLayoutLine),
+		0);
+}
+
+static void
+audit_widget (GtkWidget *widget,
+	      gpointer   data)
+{
+  MemoryAudit *audit = data;
+
+  if (!audit_object (audit, widget, 0, 0))
+    return;
+
+  if (widget->style)
+    audit_style (audit, widget->style);
+
+  audit_window (audit, widget->window);
+
+  audit_object (audit, g_object_get_data (G_OBJECT (widget), "gtk-pango-context"), 0, 0);
+
+  /* Don't use the getters here, they create the layouts
+   */
+  if (GTK_IS_LABEL (widget))
+    audit_layout (audit, GTK_LABEL (widget)->layout);
+  else if (GTK_IS_ENTRY (widget))
+    audit_layout (audit, GTK_ENTRY (widget)->cached_layout);
+  else if (GTK_IS_IMAGE (widget) &&
+	   gtk_image_get_storage_type (GTK_IMAGE (widget)) == GTK_IMAGE_PIXMAP)
+    {
+      GdkPixmap *pixmap;
+      GdkBitmap *mask;
+
+      gtk_image_get_pixmap (GTK_IMAGE (widget), &pixmap, &mask);
+      audit_pixmap (audit, pixmap);
+      audit_pixmap (audit, mask);
+    }
+
+  if (GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget), audit_widget, audit);
+}
+
+static gint
+audit_entry_compare (gconstpointer a,
+		     gconstpointer b)
+{
+  const AuditEntry *ea = a;
+  const AuditEntry *eb = b;
+
+  return strcmp (g_type_name (ea->type), g_type_name (eb->type));
+}
+
+/**
+ * gtk_memory_audit:
+ *
+ * Walks the widget trees of all toplevel windows and accounts
+ * for the widgets, styles, graphics contexts, Pango contexts
+ * and layouts, windows and pixmaps they use. Objects shared
+ * between widgets are counted once.
+ *
+ * The report has a line per type, sorted by type name, with
+ * the type name, the number of instances, the estimated number
+ * of bytes they use in the client and the estimated number of
+ * bytes of X server memory, separated by spaces. Lines starting
+ * with '#' are comments.
+ *
+ * The byte counts are estimates: they include the instance
+ * structures and some of the data hanging off them, but not
+ * private allocations of the objects.
+ *
+ * Return value: a newly allocated string with the report
+ *
+ * Since: 2.16
+ **/
+gchar *
+gtk_memory_audit (void)
+{
+  MemoryAudit audit;
+  GList *toplevels, *entries, *l;
+  GString *report;
+  gsize size = 0, server_size = 0;
+
+  audit.seen = g_hash_table_new (NULL, NULL);
+  audit.entries = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  toplevels = gtk_window_list_toplevels ();
+  g_list_foreach (toplevels, (GFunc) g_object_ref, NULL);
+  for (l = toplevels; l; l = l->next)
+    audit_widget (l->data, &audit);
+  g_list_foreach (toplevels, (GFunc) g_object_unref, NULL);
+  g_list_free (toplevels);
+
+  entries = g_hash_table_get_values (audit.entries);
+  entries = g_list_sort (entries, audit_entry_compare);
+
+  report = g_string_new ("# type instances bytes server-bytes\n");
+  for (l = entries; l; l = l->next)
+    {
+      AuditEntry *entry = l->data;
+
+      g_string_append_printf (report,
+			      "%s %u %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT "\n",
+			      g_type_name (entry->type), entry->n_instances,
+			      entry->size, entry->server_size);
+      size += entry->size;
+      server_size += entry->server_size;
+    }
+  g_string_append_printf (report,
+			  "# total %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT "\n",
+			  size, server_size);
+
+  g_list_free (entries);
+  g_hash_table_destroy (audit.entries);
+  g_hash_table_destroy (audit.seen);
+
+  return g_string_free (report, FALSE);
+}
+
+/**
+ * gtk_memory_audit_print:
+ *
+ * Prints the report of gtk_memory_audit() to stderr. With
+ * <envar>GTK_DEBUG</envar>=memory, this is also done when
+ * Control-Shift-M is pressed.
+ *
+ * Since: 2.16
+ **/
+void
+gtk_memory_audit_print (void)
+{
+  gchar *report;
+
+  report = gtk_memory_audit ();
+  g_printerr ("%s", report);
+  g_free (report);
+}
+
+#define __GTK_MEMORY_AUDIT_C__
+#include "gtkaliasdef.c"
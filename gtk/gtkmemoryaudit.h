@@ -0,0 +1,36 @@
+/* GTK - The GIMP Toolkit
+ * gtkmemoryaudit.h: Per type accounting of widget tree memory
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#if defined(GTK_DISABLE_SINGLE_INCLUDES) && !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#ifndef __GTK_MEMORY_AUDIT_H__
+#define __GTK_MEMORY_AUDIT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gchar *gtk_memory_audit       (void);
+void   gtk_memory_audit_print (void);
+
+G_END_DECLS
+
+#endif /* __GTK_MEMORY_AUDIT_H__ */
@@ -533,6 +533,16 @@ settings_destroy_notify (gpointer data)
   g_slist_free (modules);
 }
 
+/* Modules may install emission hooks on any signal, e.g. for
+ * ATK global event listeners, so widgets only skip signal
+ * emissions when this returns %FALSE.
+ */
+gboolean
+_gtk_modules_loaded (void)
+{
+  return gtk_modules != NULL;
+}
+
 void
 _gtk_modules_settings_changed (GtkSettings *settings, 
 			       const gchar *modules)
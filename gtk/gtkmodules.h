@@ -42,6 +42,7 @@ void    _gtk_modules_init             (gint         *argc,
 				       const gchar  *gtk_modules_args);
 void    _gtk_modules_settings_changed (GtkSettings  *settings,
 				       const gchar  *modules);
+gboolean _gtk_modules_loaded          (void);
 
 typedef void	 (*GtkModuleInitFunc)        (gint	  *argc,
 					      gchar      ***argv);
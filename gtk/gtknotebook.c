@@ -2124,13 +2124,17 @@ gtk_notebook_size_allocate (GtkWidget     *widget,
 	    }
 	}
 
+      /* Only the current page is child-visible; the others get
+       * allocated when switching to them, since that queues a resize.
+       */
       children = notebook->children;
       while (children)
 	{
 	  page = children->data;
 	  children = children->next;
 	  
-	  if (GTK_WIDGET_VISIBLE (page->child))
+	  if (GTK_WIDGET_VISIBLE (page->child) &&
+	      gtk_widget_get_child_visible (page->child))
 	    gtk_widget_size_allocate (page->child, &child_allocation);
 	}
 
@@ -832,6 +832,7 @@ gtk_paned_size_allocate (GtkWidget     *widget,
       GtkAllocation child1_allocation;
       GtkAllocation child2_allocation;
       GdkRectangle old_handle_pos;
+      gboolean handle_moved;
       gint handle_size;
 
       gtk_widget_style_get (widget, "handle-size", &handle_size, NULL);
@@ -893,11 +894,12 @@ gtk_paned_size_allocate (GtkWidget     *widget,
           child2_allocation.height = MAX (1, widget->allocation.y + widget->allocation.height - child2_allocation.y - border_width);
         }
 
-      if (GTK_WIDGET_MAPPED (widget) &&
-          (old_handle_pos.x != paned->handle_pos.x ||
-           old_handle_pos.y != paned->handle_pos.y ||
-           old_handle_pos.width != paned->handle_pos.width ||
-           old_handle_pos.height != paned->handle_pos.height))
+      handle_moved = (old_handle_pos.x != paned->handle_pos.x ||
+                      old_handle_pos.y != paned->handle_pos.y ||
+                      old_handle_pos.width != paned->handle_pos.width ||
+                      old_handle_pos.height != paned->handle_pos.height);
+
+      if (GTK_WIDGET_MAPPED (widget) && handle_moved)
         {
           gdk_window_invalidate_rect (widget->window, &old_handle_pos, FALSE);
           gdk_window_invalidate_rect (widget->window, &paned->handle_pos, FALSE);
@@ -905,25 +907,18 @@ gtk_paned_size_allocate (GtkWidget     *widget,
 
       if (GTK_WIDGET_REALIZED (widget))
 	{
-	  if (GTK_WIDGET_MAPPED (widget))
+	  if (GTK_WIDGET_MAPPED (widget) && !gdk_window_is_visible (paned->handle))
 	    gdk_window_show (paned->handle);
 
-          if (paned->priv->orientation == GTK_ORIENTATION_HORIZONTAL)
-            {
-              gdk_window_move_resize (paned->handle,
-                                      paned->handle_pos.x,
-                                      paned->handle_pos.y,
-                                      handle_size,
-                                      paned->handle_pos.height);
-            }
-          else
-            {
-              gdk_window_move_resize (paned->handle,
-                                      paned->handle_pos.x,
-                                      paned->handle_pos.y,
-                                      paned->handle_pos.width,
-                                      handle_size);
-            }
+          /* The handle is created at handle_pos, so it only needs
+           * to be moved when handle_pos changes
+           */
+          if (handle_moved)
+            gdk_window_move_resize (paned->handle,
+                                    paned->handle_pos.x,
+                                    paned->handle_pos.y,
+                                    paned->handle_pos.width,
+                                    paned->handle_pos.height);
 	}
 
       /* Now allocate the childen, making sure, when resizing not to
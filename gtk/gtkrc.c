@@ -46,6 +46,7 @@
 
 #include "gtkversion.h"
 #include "gtkrc.h"
+#include "gtkrccache.h"
 #include "gtkbindings.h"
 #include "gtkthemes.h"
 #include "gtkintl.h"
@@ -65,6 +66,8 @@
 typedef struct _GtkRcSet    GtkRcSet;
 typedef struct _GtkRcNode   GtkRcNode;
 typedef struct _GtkRcFile   GtkRcFile;
+typedef struct _GtkRcSetIndex GtkRcSetIndex;
+typedef struct _GtkRcMatchKey GtkRcMatchKey;
 
 enum 
 {
@@ -93,8 +96,35 @@ struct _GtkRcSet
 
   GtkRcStyle   *rc_style;
   gint          priority;
+
+  gchar        *last_component;	/* the literal last path component
+				 * a path must have to match, or NULL */
+  guint         position;	/* position in the list, set when indexing */
+};
+
+/* Splits a list of rc sets by the last path component they require,
+ * so that matching a path only has to look at the sets that can
+ * possibly match it. Both the buckets and the generic list keep the
+ * order of the original list.
+ */
+struct _GtkRcSetIndex
+{
+  GHashTable *literal;
+  GSList     *generic;
+};
+
+struct _GtkRcMatchKey
+{
+  gchar *widget_path;
+  gchar *class_path;
+  GType  type;
 };
 
+/* Upper bound on the number of distinct paths for which matching
+ * results are remembered
+ */
+#define GTK_RC_MATCH_CACHE_SIZE 1024
+
 struct _GtkRcFile
 {
   time_t mtime;
@@ -128,6 +158,14 @@ struct _GtkRcContext
 
   GHashTable *color_hash;
 
+  /* Indexes of the rc_sets lists and the results of matching
+   * them; cleared whenever any of the lists changes
+   */
+  GtkRcSetIndex *widget_index;
+  GtkRcSetIndex *widget_class_index;
+  GtkRcSetIndex *class_index;
+  GHashTable *match_cache;
+
   guint reloading : 1;
 };
 
@@ -138,6 +176,12 @@ typedef struct _GtkRcStylePrivate GtkRcStylePrivate;
 struct _GtkRcStylePrivate
 {
   GSList *color_hashes;
+
+  /* an immutable copy with the same contents, shared by all
+   * modifier styles that look alike
+   */
+  GtkRcStyle *shared;
+  guint interned : 1;
 };
 
 static GtkRcContext *gtk_rc_context_get              (GtkSettings     *settings);
@@ -148,13 +192,18 @@ static gboolean    gtk_rc_style_equal                (const gchar     *a,
 static guint       gtk_rc_styles_hash                (const GSList    *rc_styles);
 static gboolean    gtk_rc_styles_equal               (const GSList    *a,
                                                       const GSList    *b);
+static GtkRcStyle* gtk_rc_style_get_shared           (GtkRcStyle      *rc_style);
 static GtkRcStyle* gtk_rc_style_find                 (GtkRcContext    *context,
 						      const gchar     *name);
 static GSList *    gtk_rc_styles_match               (GSList          *rc_styles,
-                                                      GSList          *sets,
+                                                      GtkRcSetIndex   *index,
                                                       guint            path_length,
                                                       gchar           *path,
                                                       gchar           *path_reversed);
+static GSList *    gtk_rc_context_match_styles       (GtkRcContext    *context,
+                                                      const gchar     *widget_path,
+                                                      const gchar     *class_path,
+                                                      GType            type);
 static GtkStyle *  gtk_rc_style_to_style             (GtkRcContext    *context,
 						      GtkRcStyle      *rc_style);
 static GtkStyle*   gtk_rc_init_style                 (GtkRcContext    *context,
@@ -171,6 +220,22 @@ static void        gtk_rc_parse_any                  (GtkRcContext    *context,
 						      const gchar     *input_name,
                                                       gint             input_fd,
                                                       const gchar     *input_string);
+static void        gtk_rc_parse_scanner              (GtkRcContext    *context,
+						      GScanner        *scanner);
+static gboolean    gtk_rc_context_parse_cache        (GtkRcContext    *context,
+						      GtkRcFile       *rc_file,
+						      struct stat     *statbuf);
+static void        gtk_rc_compile_one_file           (GtkRcContext    *context,
+						      GtkRcFile       *rc_file,
+						      const gchar     *filename,
+						      struct stat     *statbuf);
+static void        gtk_rc_compile_statement          (GtkRcContext    *context,
+						      GScanner        *scanner,
+						      guint            token,
+						      gsize            start,
+						      guint            line);
+static void        gtk_rc_compile_set_setting        (const gchar     *name,
+						      const GValue    *value);
 static guint       gtk_rc_parse_statement            (GtkRcContext    *context,
 						      GScanner        *scanner);
 static guint       gtk_rc_parse_style                (GtkRcContext    *context,
@@ -211,6 +276,11 @@ static guint       gtk_rc_parse_module_path          (GScanner        *scanner);
 static guint       gtk_rc_parse_im_module_file       (GScanner        *scanner);
 static guint       gtk_rc_parse_path_pattern         (GtkRcContext    *context,
 						      GScanner        *scanner);
+static void        gtk_rc_context_add_rc_set         (GtkRcContext    *context,
+						      GtkPathType      path_type,
+						      const gchar     *pattern,
+						      GtkRcStyle      *rc_style,
+						      gint             priority);
 static guint       gtk_rc_parse_stock                (GtkRcContext    *context,
 						      GScanner        *scanner,
                                                       GtkRcStyle      *rc_style,
@@ -223,6 +293,7 @@ static void        gtk_rc_clear_hash_node            (gpointer         key,
                                                       gpointer         data,
                                                       gpointer         user_data);
 static void        gtk_rc_clear_styles               (GtkRcContext    *context);
+static void        gtk_rc_context_clear_match_cache  (GtkRcContext    *context);
 static void        gtk_rc_add_initial_default_files  (void);
 
 static void        gtk_rc_style_finalize             (GObject         *object);
@@ -368,6 +439,7 @@ static const struct
 };
 
 static GHashTable *realized_style_ht = NULL;
+static GHashTable *shared_rc_style_ht = NULL;
 
 static gchar *im_module_file = NULL;
 
@@ -380,6 +452,33 @@ static gchar **gtk_rc_default_files = NULL;
  */
 static GSList *current_files_stack = NULL;
 
+/* While _gtk_rc_compile_file() runs, every statement parsed is
+ * also written to the cache.
+ */
+typedef struct
+{
+  const gchar *text;
+  GArray      *line_offsets;	/* of gsize, the offset each line starts at */
+} GtkRcCompileFile;
+
+typedef struct
+{
+  GtkRcCacheWriter *writer;
+  GSList           *files;		/* stack of GtkRcCompileFile */
+  GHashTable       *defined_styles;	/* styles seen so far */
+  GHashTable       *plain_styles;	/* ...and which of them were stored precompiled */
+  gchar            *setting_name;	/* the setting assigned by the last statement */
+  GValue            setting_value;
+  gboolean          failed;
+} GtkRcCompileState;
+
+static GtkRcCompileState *rc_compile_state = NULL;
+
+/* Patterns without an explicit priority get this while compiling,
+ * so the loader can substitute the priority of the including file.
+ */
+#define GTK_RC_COMPILE_DEFAULT_PRIORITY (-1)
+
 /* RC files and strings that are parsed for every context
  */
 static GSList *global_rc_files = NULL;
@@ -388,6 +487,15 @@ static GSList *global_rc_files = NULL;
  */
 static GSList *rc_contexts;
 
+/* Properties and settings carry the file and line they were set
+ * in when GTK_DEBUG is set, so that they can be traced back
+ */
+static gboolean
+gtk_rc_record_origins (void)
+{
+  return g_getenv ("GTK_DEBUG") != NULL;
+}
+
 /* RC file handling */
 
 static gchar *
@@ -681,6 +789,10 @@ gtk_rc_context_get (GtkSettings *settings)
       context->rc_sets_class = NULL;
       context->rc_files = NULL;
       context->default_style = NULL;
+      context->widget_index = NULL;
+      context->widget_class_index = NULL;
+      context->class_index = NULL;
+      context->match_cache = NULL;
       context->reloading = FALSE;
 
       g_object_get (settings,
@@ -755,6 +867,9 @@ _gtk_rc_context_destroy (GtkSettings *settings)
   gtk_rc_clear_styles (context);
   gtk_rc_clear_rc_files (context);
 
+  if (context->match_cache)
+    g_hash_table_destroy (context->match_cache);
+
   if (context->default_style)
     g_object_unref (context->default_style);
 
@@ -997,22 +1112,27 @@ gtk_rc_context_parse_one_file (GtkRcContext *context,
       
       rc_file->mtime = statbuf.st_mtime;
 
-      fd = g_open (rc_file->canonical_name, O_RDONLY, 0);
-      if (fd < 0)
-	goto out;
-
       /* Temporarily push information for this file on
        * a stack of current files while parsing it.
        */
       current_files_stack = g_slist_prepend (current_files_stack, rc_file);
-      gtk_rc_parse_any (context, filename, fd, NULL);
+
+      if (rc_compile_state)
+	gtk_rc_compile_one_file (context, rc_file, filename, &statbuf);
+      else if (!gtk_rc_context_parse_cache (context, rc_file, &statbuf))
+	{
+	  fd = g_open (rc_file->canonical_name, O_RDONLY, 0);
+	  if (fd >= 0)
+	    {
+	      gtk_rc_parse_any (context, filename, fd, NULL);
+	      close (fd);
+	    }
+	}
+
       current_files_stack = g_slist_delete_link (current_files_stack,
 						 current_files_stack);
-
-      close (fd);
     }
 
- out:
   context->default_priority = saved_priority;
 }
 
@@ -1030,18 +1150,16 @@ strchr_len (const gchar *str, gint len, char c)
   return NULL;
 }
 
-static void
-gtk_rc_context_parse_file (GtkRcContext *context,
-			   const gchar  *filename,
-			   gint          priority,
-			   gboolean      reload)
+/* Determines the suffixes of the locale specific variants of RC
+ * files for the current locale.
+ */
+static gint
+gtk_rc_get_locale_suffixes (gchar *locale_suffixes[2])
 {
-  gchar *locale_suffixes[2];
   gint n_locale_suffixes = 0;
   gchar *p;
   gchar *locale;
-  gint length, j;
-  gboolean found = FALSE;
+  gint length;
 
   locale = _gtk_get_lc_ctype ();
 
@@ -1070,6 +1188,26 @@ gtk_rc_context_parse_file (GtkRcContext *context,
     }
 
   g_free (locale);
+
+  return n_locale_suffixes;
+}
+
+static void
+gtk_rc_context_parse_file (GtkRcContext *context,
+			   const gchar  *filename,
+			   gint          priority,
+			   gboolean      reload)
+{
+  gchar *locale_suffixes[2];
+  gint n_locale_suffixes = 0;
+  gint j;
+  gboolean found = FALSE;
+
+  /* Caches are compiled without the locale specific variants;
+   * the loader checks that none exist before using one.
+   */
+  if (!rc_compile_state)
+    n_locale_suffixes = gtk_rc_get_locale_suffixes (locale_suffixes);
   
   gtk_rc_context_parse_one_file (context, filename, priority, reload);
   for (j = 0; j < n_locale_suffixes; j++)
@@ -1135,6 +1273,8 @@ gtk_rc_style_init (GtkRcStyle *style)
   style->icon_factories = NULL;
 
   priv->color_hashes = NULL;
+  priv->shared = NULL;
+  priv->interned = FALSE;
 }
 
 static void
@@ -1163,6 +1303,12 @@ gtk_rc_style_finalize (GObject *object)
   rc_style = GTK_RC_STYLE (object);
   rc_priv = GTK_RC_STYLE_GET_PRIVATE (rc_style);
 
+  /* the hash of an interned style needs all of its contents */
+  if (rc_priv->interned)
+    g_hash_table_remove (shared_rc_style_ht, rc_style);
+  if (rc_priv->shared)
+    g_object_unref (rc_priv->shared);
+
   g_free (rc_style->name);
   if (rc_style->font_desc)
     pango_font_description_free (rc_style->font_desc);
@@ -1595,6 +1741,8 @@ gtk_rc_clear_styles (GtkRcContext *context)
   gtk_rc_free_rc_sets (context->rc_sets_class);
   g_slist_free (context->rc_sets_class);
   context->rc_sets_class = NULL;
+
+  gtk_rc_context_clear_match_cache (context);
 }
 
 /* Reset all our widgets. Also, we have to invalidate cached icons in
@@ -1842,20 +1990,115 @@ gtk_rc_reparse_all (void)
   return result;
 }
 
+static gchar *
+gtk_rc_pattern_get_last_component (const gchar *pattern)
+{
+  const gchar *last;
+
+  /* Only patterns that end in a literal component can be indexed;
+   * "*.GtkLabel" needs the path to end in ".GtkLabel", so the last
+   * component of every path it matches is "GtkLabel".
+   */
+  last = strrchr (pattern, '.');
+  last = last ? last + 1 : pattern;
+
+  if (strpbrk (last, "*?<>"))
+    return NULL;
+
+  return g_strdup (last);
+}
+
+static GtkRcSetIndex *
+gtk_rc_set_index_new (GSList *sets)
+{
+  GtkRcSetIndex *index;
+  GSList *reversed, *tmp_list;
+  guint position;
+
+  index = g_slice_new (GtkRcSetIndex);
+  index->literal = g_hash_table_new (g_str_hash, g_str_equal);
+  index->generic = NULL;
+
+  /* Walk the sets back to front, so that prepending keeps the
+   * original order in every list
+   */
+  position = g_slist_length (sets);
+  reversed = g_slist_reverse (g_slist_copy (sets));
+
+  for (tmp_list = reversed; tmp_list; tmp_list = tmp_list->next)
+    {
+      GtkRcSet *rc_set = tmp_list->data;
+
+      rc_set->position = --position;
+
+      if (rc_set->last_component)
+	{
+	  GSList *bucket = g_hash_table_lookup (index->literal, rc_set->last_component);
+
+	  g_hash_table_insert (index->literal, rc_set->last_component,
+			       g_slist_prepend (bucket, rc_set));
+	}
+      else
+	index->generic = g_slist_prepend (index->generic, rc_set);
+    }
+
+  g_slist_free (reversed);
+
+  return index;
+}
+
+static void
+free_bucket (gpointer key,
+	     gpointer value,
+	     gpointer data)
+{
+  g_slist_free (value);
+}
+
+static void
+gtk_rc_set_index_free (GtkRcSetIndex *index)
+{
+  if (!index)
+    return;
+
+  g_hash_table_foreach (index->literal, free_bucket, NULL);
+  g_hash_table_destroy (index->literal);
+  g_slist_free (index->generic);
+
+  g_slice_free (GtkRcSetIndex, index);
+}
+
 static GSList *
-gtk_rc_styles_match (GSList       *rc_styles,
-		     GSList	  *sets,
-		     guint         path_length,
-		     gchar        *path,
-		     gchar        *path_reversed)
+gtk_rc_styles_match (GSList        *rc_styles,
+		     GtkRcSetIndex *index,
+		     guint          path_length,
+		     gchar         *path,
+		     gchar         *path_reversed)
 		     
 {
   GtkRcSet *rc_set;
+  GSList *literal, *generic;
+  const gchar *last;
 
-  while (sets)
+  last = strrchr (path, '.');
+  literal = g_hash_table_lookup (index->literal, last ? last + 1 : path);
+  generic = index->generic;
+
+  /* Merge both lists, so the sets are tried in their original order */
+  while (literal || generic)
     {
-      rc_set = sets->data;
-      sets = sets->next;
+      if (!generic ||
+	  (literal &&
+	   ((GtkRcSet *) literal->data)->position < ((GtkRcSet *) generic->data)->position))
+	{
+	  rc_set = literal->data;
+	  literal = literal->next;
+	}
+      else
+	{
+	  rc_set = generic->data;
+	  generic = generic->next;
+	}
 
       if (rc_set->type == GTK_PATH_WIDGET_CLASS)
         {
@@ -1872,6 +2115,26 @@ gtk_rc_styles_match (GSList       *rc_styles,
   return rc_styles;
 }
 
+static GSList *
+gtk_rc_styles_match_path (GSList        *rc_styles,
+			  GtkRcSetIndex *index,
+			  const gchar   *path)
+{
+  gchar *path_copy;
+  gchar *path_reversed;
+
+  path_copy = g_strdup (path);
+  path_reversed = g_strdup (path);
+  g_strreverse (path_reversed);
+
+  rc_styles = gtk_rc_styles_match (rc_styles, index, strlen (path), path_copy, path_reversed);
+
+  g_free (path_copy);
+  g_free (path_reversed);
+
+  return rc_styles;
+}
+
 static gint
 rc_set_compare (gconstpointer a, gconstpointer b)
 {
@@ -1914,6 +2177,136 @@ sort_and_dereference_sets (GSList *styles)
   return styles;
 }
 
+static guint
+gtk_rc_match_key_hash (gconstpointer key)
+{
+  const GtkRcMatchKey *match_key = key;
+  guint hash = match_key->type;
+
+  if (match_key->widget_path)
+    hash = hash * 31 + g_str_hash (match_key->widget_path);
+  if (match_key->class_path)
+    hash = hash * 31 + g_str_hash (match_key->class_path);
+
+  return hash;
+}
+
+static gboolean
+gtk_rc_match_key_equal (gconstpointer a,
+			gconstpointer b)
+{
+  const GtkRcMatchKey *key_a = a;
+  const GtkRcMatchKey *key_b = b;
+
+  return (key_a->type == key_b->type &&
+	  g_strcmp0 (key_a->widget_path, key_b->widget_path) == 0 &&
+	  g_strcmp0 (key_a->class_path, key_b->class_path) == 0);
+}
+
+static void
+gtk_rc_match_key_free (gpointer data)
+{
+  GtkRcMatchKey *key = data;
+
+  g_free (key->widget_path);
+  g_free (key->class_path);
+  g_slice_free (GtkRcMatchKey, key);
+}
+
+static void
+gtk_rc_context_clear_match_cache (GtkRcContext *context)
+{
+  gtk_rc_set_index_free (context->widget_index);
+  context->widget_index = NULL;
+  gtk_rc_set_index_free (context->widget_class_index);
+  context->widget_class_index = NULL;
+  gtk_rc_set_index_free (context->class_index);
+  context->class_index = NULL;
+
+  if (context->match_cache)
+    g_hash_table_remove_all (context->match_cache);
+}
+
+/* Finds the rc styles for the given widget path, class path and
+ * type, sorted by precedence. Any of them may be omitted by passing
+ * %NULL or %G_TYPE_NONE. The returned list belongs to the caller.
+ *
+ * Realizing a window resolves styles for many widgets with the same
+ * paths, so the results are remembered until the rc sets change.
+ */
+static GSList *
+gtk_rc_context_match_styles (GtkRcContext *context,
+			     const gchar  *widget_path,
+			     const gchar  *class_path,
+			     GType         type)
+{
+  GtkRcMatchKey key;
+  GtkRcMatchKey *new_key;
+  GSList *rc_styles = NULL;
+  gpointer cached;
+
+  /* Leave out what can't match anything, so that such
+   * lookups share their cache entries
+   */
+  key.widget_path = context->rc_sets_widget ? (gchar *) widget_path : NULL;
+  key.class_path = context->rc_sets_widget_class ? (gchar *) class_path : NULL;
+  key.type = context->rc_sets_class ? type : G_TYPE_NONE;
+
+  if (!key.widget_path && !key.class_path && key.type == G_TYPE_NONE)
+    return NULL;
+
+  if (!context->match_cache)
+    context->match_cache = g_hash_table_new_full (gtk_rc_match_key_hash,
+						  gtk_rc_match_key_equal,
+						  gtk_rc_match_key_free,
+						  (GDestroyNotify) g_slist_free);
+  else if (g_hash_table_lookup_extended (context->match_cache, &key, NULL, &cached))
+    return g_slist_copy (cached);
+
+  if (key.widget_path)
+    {
+      if (!context->widget_index)
+	context->widget_index = gtk_rc_set_index_new (context->rc_sets_widget);
+
+      rc_styles = gtk_rc_styles_match_path (rc_styles, context->widget_index, key.widget_path);
+    }
+
+  if (key.class_path)
+    {
+      if (!context->widget_class_index)
+	context->widget_class_index = gtk_rc_set_index_new (context->rc_sets_widget_class);
+
+      rc_styles = gtk_rc_styles_match_path (rc_styles, context->widget_class_index, key.class_path);
+    }
+
+  if (key.type != G_TYPE_NONE)
+    {
+      GType tmp_type;
+
+      if (!context->class_index)
+	context->class_index = gtk_rc_set_index_new (context->rc_sets_class);
+
+      for (tmp_type = key.type; tmp_type; tmp_type = g_type_parent (tmp_type))
+	rc_styles = gtk_rc_styles_match_path (rc_styles, context->class_index, g_type_name (tmp_type));
+    }
+
+  rc_styles = sort_and_dereference_sets (rc_styles);
+
+  /* Widget names can make the number of distinct paths grow
+   * without bound, so start over once the cache gets large
+   */
+  if (g_hash_table_size (context->match_cache) >= GTK_RC_MATCH_CACHE_SIZE)
+    g_hash_table_remove_all (context->match_cache);
+
+  new_key = g_slice_new (GtkRcMatchKey);
+  new_key->widget_path = g_strdup (key.widget_path);
+  new_key->class_path = g_strdup (key.class_path);
+  new_key->type = key.type;
+  g_hash_table_insert (context->match_cache, new_key, g_slist_copy (rc_styles));
+
+  return rc_styles;
+}
+
 /**
  * gtk_rc_get_style:
  * @widget: a #GtkWidget
@@ -1935,6 +2328,8 @@ gtk_rc_get_style (GtkWidget *widget)
   GtkRcStyle *widget_rc_style;
   GSList *rc_styles = NULL;
   GtkRcContext *context;
+  gchar *path = NULL;
+  gchar *class_path = NULL;
 
   static guint rc_style_key_id = 0;
 
@@ -1949,57 +2344,21 @@ gtk_rc_get_style (GtkWidget *widget)
     rc_style_key_id = g_quark_from_static_string ("gtk-rc-style");
 
   if (context->rc_sets_widget)
-    {
-      gchar *path, *path_reversed;
-      guint path_length;
-
-      gtk_widget_path (widget, &path_length, &path, &path_reversed);
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
-    }
+    gtk_widget_path (widget, NULL, &path, NULL);
   
   if (context->rc_sets_widget_class)
-    {
-      gchar *path, *path_reversed;
-      guint path_length;
-
-      gtk_widget_class_path (widget, &path_length, &path, &path_reversed);
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget_class, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
-    }
-
-  if (context->rc_sets_class)
-    {
-      GType type;
+    gtk_widget_class_path (widget, NULL, &class_path, NULL);
 
-      type = G_TYPE_FROM_INSTANCE (widget);
-      while (type)
-	{
-	  gchar *path;
-          gchar *path_reversed;
-	  guint path_length;
-
-	  path = g_strdup (g_type_name (type));
-	  path_length = strlen (path);
-	  path_reversed = g_strdup (path);
-	  g_strreverse (path_reversed);
-	  
-	  rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_class, path_length, path, path_reversed);
-	  g_free (path);
-	  g_free (path_reversed);
-      
-	  type = g_type_parent (type);
-	}
-    }
-  
-  rc_styles = sort_and_dereference_sets (rc_styles);
+  rc_styles = gtk_rc_context_match_styles (context, path, class_path,
+					   G_TYPE_FROM_INSTANCE (widget));
+  g_free (path);
+  g_free (class_path);
   
   widget_rc_style = g_object_get_qdata (G_OBJECT (widget), rc_style_key_id);
 
+  /* Widgets with equal modifications share one style */
   if (widget_rc_style)
-    rc_styles = g_slist_prepend (rc_styles, widget_rc_style);
+    rc_styles = g_slist_prepend (rc_styles, gtk_rc_style_get_shared (widget_rc_style));
 
   if (rc_styles)
     return gtk_rc_init_style (context, rc_styles);
@@ -2052,71 +2411,14 @@ gtk_rc_get_style_by_paths (GtkSettings *settings,
 			   const char  *class_path,
 			   GType        type)
 {
-  /* We duplicate the code from above to avoid slowing down the above
-   * by generating paths when we don't need them. I don't know if
-   * this is really worth it.
-   */
-  GSList *rc_styles = NULL;
+  GSList *rc_styles;
   GtkRcContext *context;
 
   g_return_val_if_fail (GTK_IS_SETTINGS (settings), NULL);
 
   context = gtk_rc_context_get (settings);
 
-  if (widget_path && context->rc_sets_widget)
-    {
-      gchar *path;
-      gchar *path_reversed;
-      guint path_length;
-
-      path_length = strlen (widget_path);
-      path = g_strdup (widget_path);
-      path_reversed = g_strdup (widget_path);
-      g_strreverse (path_reversed);
-
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
-    }
-  
-  if (class_path && context->rc_sets_widget_class)
-    {
-      gchar *path;
-      gchar *path_reversed;
-      guint path_length;
-
-      path = g_strdup (class_path);
-      path_length = strlen (class_path);
-      path_reversed = g_strdup (class_path);
-      g_strreverse (path_reversed);
-
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget_class, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
-    }
-
-  if (type != G_TYPE_NONE && context->rc_sets_class)
-    {
-      while (type)
-	{
-	  gchar *path;
-          gchar *path_reversed;
-	  guint path_length;
-
-	  path = g_strdup (g_type_name (type));
-	  path_length = strlen (path);
-	  path_reversed = g_strdup (path);
-	  g_strreverse (path_reversed);
-	  
-	  rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_class, path_length, path, path_reversed);
-	  g_free (path);
-	  g_free (path_reversed);
-      
-	  type = g_type_parent (type);
-	}
-    }
- 
-  rc_styles = sort_and_dereference_sets (rc_styles);
+  rc_styles = gtk_rc_context_match_styles (context, widget_path, class_path, type);
   
   if (rc_styles)
     return gtk_rc_init_style (context, rc_styles);
@@ -2158,6 +2460,7 @@ gtk_rc_add_rc_sets (GSList      *slist,
     }
   
   rc_set->rc_style = rc_style;
+  rc_set->last_component = gtk_rc_pattern_get_last_component (pattern);
   
   return g_slist_prepend (slist, rc_set);
 }
@@ -2174,6 +2477,7 @@ gtk_rc_add_widget_name_style (GtkRcStyle  *rc_style,
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
   context->rc_sets_widget = gtk_rc_add_rc_sets (context->rc_sets_widget, rc_style, pattern, GTK_PATH_WIDGET);
+  gtk_rc_context_clear_match_cache (context);
 }
 
 void
@@ -2188,6 +2492,7 @@ gtk_rc_add_widget_class_style (GtkRcStyle  *rc_style,
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
   context->rc_sets_widget_class = gtk_rc_add_rc_sets (context->rc_sets_widget_class, rc_style, pattern, GTK_PATH_WIDGET_CLASS);
+  gtk_rc_context_clear_match_cache (context);
 }
 
 void
@@ -2202,6 +2507,7 @@ gtk_rc_add_class_style (GtkRcStyle  *rc_style,
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
   context->rc_sets_class = gtk_rc_add_rc_sets (context->rc_sets_class, rc_style, pattern, GTK_PATH_CLASS);
+  gtk_rc_context_clear_match_cache (context);
 }
 
 GScanner*
@@ -2217,8 +2523,6 @@ gtk_rc_parse_any (GtkRcContext *context,
 		  const gchar  *input_string)
 {
   GScanner *scanner;
-  guint	   i;
-  gboolean done;
 
   scanner = gtk_rc_scanner_new ();
   
@@ -2236,24 +2540,72 @@ gtk_rc_parse_any (GtkRcContext *context,
     }
   scanner->input_name = input_name;
 
+  gtk_rc_parse_scanner (context, scanner);
+  
+  g_scanner_destroy (scanner);
+}
+
+static void
+gtk_rc_scanner_add_symbols (GScanner *scanner)
+{
+  guint i;
+
   for (i = 0; i < G_N_ELEMENTS (symbols); i++)
     g_scanner_scope_add_symbol (scanner, 0, symbol_names + symbols[i].name_offset, GINT_TO_POINTER (symbols[i].token));
+}
+
+static gsize
+gtk_rc_compile_get_offset (GScanner *scanner)
+{
+  GtkRcCompileFile *file = rc_compile_state->files->data;
+
+  /* line and position are those of the last token consumed,
+   * not of one that has only been peeked at
+   */
+  return g_array_index (file->line_offsets, gsize, scanner->line - 1) + scanner->position;
+}
+
+static void
+gtk_rc_parse_scanner (GtkRcContext *context,
+		      GScanner     *scanner)
+{
+  guint	   i;
+  gboolean done;
+
+  gtk_rc_scanner_add_symbols (scanner);
   done = FALSE;
   while (!done)
     {
-      if (g_scanner_peek_next_token (scanner) == G_TOKEN_EOF)
+      guint token = g_scanner_peek_next_token (scanner);
+
+      if (token == G_TOKEN_EOF)
 	done = TRUE;
       else
 	{
 	  guint expected_token;
+	  gboolean compiling = rc_compile_state && rc_compile_state->files;
+	  gsize start = 0;
+	  guint line = 0;
+
+	  if (compiling)
+	    {
+	      start = gtk_rc_compile_get_offset (scanner);
+	      line = scanner->line;
+	    }
 	  
 	  expected_token = gtk_rc_parse_statement (context, scanner);
 
+	  if (compiling && expected_token == G_TOKEN_NONE)
+	    gtk_rc_compile_statement (context, scanner, token, start, line);
+
 	  if (expected_token != G_TOKEN_NONE)
 	    {
 	      const gchar *symbol_name = NULL;
 	      gchar *msg = NULL;
 
+	      if (compiling)
+		rc_compile_state->failed = TRUE;
+
 	      if (scanner->scope_id == 0)
 		{
 		  /* if we are in scope 0, we know the symbol names
@@ -2296,22 +2648,610 @@ gtk_rc_parse_any (GtkRcContext *context,
 	    }
 	}
     }
-  
-  g_scanner_destroy (scanner);
 }
 
-static guint	   
-gtk_rc_styles_hash (const GSList *rc_styles)
+/* Precompiled RC files
+ *
+ * gtk-update-rc-cache stores a parsed RC file and everything it
+ * includes next to it, as FILE.cache. Each statement is recorded
+ * either in a precompiled form or, when its meaning depends on
+ * the context it is parsed in (engines, stock icons, symbolic
+ * colors, pixmaps, bindings, ...), as text that goes through the
+ * scanner again. A cache is only used while none of the files it
+ * was made from changed.
+ */
+
+static gboolean
+gtk_rc_cache_is_current (GtkRcCache  *cache,
+			 struct stat *statbuf)
 {
-  guint result;
-  
-  result = 0;
-  while (rc_styles)
-    {
-      result += (result << 9) + GPOINTER_TO_UINT (rc_styles->data);
-      rc_styles = rc_styles->next;
-    }
-  
+  gchar *locale_suffixes[2];
+  gint n_locale_suffixes;
+  gboolean current = TRUE;
+  guint64 mtime, size;
+  guint i;
+  gint j;
+
+  _gtk_rc_cache_get_file (cache, 0, &mtime, &size);
+  if (mtime != (guint64) statbuf->st_mtime || size != (guint64) statbuf->st_size)
+    return FALSE;
+
+  n_locale_suffixes = gtk_rc_get_locale_suffixes (locale_suffixes);
+
+  for (i = 1; current && i < _gtk_rc_cache_get_n_files (cache); i++)
+    {
+      const gchar *name = _gtk_rc_cache_get_file (cache, i, &mtime, &size);
+      struct stat buf;
+
+      if (!g_path_is_absolute (name) ||
+	  g_lstat (name, &buf) != 0 ||
+	  mtime != (guint64) buf.st_mtime ||
+	  size != (guint64) buf.st_size)
+	current = FALSE;
+
+      /* Included files are compiled without their locale specific
+       * variants, see gtk_rc_context_parse_file()
+       */
+      for (j = 0; current && j < n_locale_suffixes; j++)
+	{
+	  gchar *locale_name = g_strconcat (name, ".", locale_suffixes[j], NULL);
+
+	  current = !g_file_test (locale_name, G_FILE_TEST_EXISTS);
+	  g_free (locale_name);
+	}
+    }
+
+  for (j = 0; j < n_locale_suffixes; j++)
+    g_free (locale_suffixes[j]);
+
+  return current;
+}
+
+/* Does what gtk_rc_context_parse_one_file() does for an included
+ * file before parsing it.
+ */
+static gboolean
+gtk_rc_context_push_cached_file (GtkRcContext *context,
+				 GtkRcCache   *cache,
+				 guint         index)
+{
+  GtkRcFile *rc_file;
+  const gchar *name;
+  guint64 mtime, size;
+
+  name = _gtk_rc_cache_get_file (cache, index, &mtime, &size);
+  rc_file = add_to_rc_file_list (&context->rc_files, name, FALSE);
+
+  if (!rc_file->canonical_name)
+    {
+      rc_file->canonical_name = rc_file->name;
+      rc_file->directory = g_path_get_dirname (rc_file->canonical_name);
+    }
+
+  if (g_slist_find (current_files_stack, rc_file))
+    return FALSE;
+
+  rc_file->mtime = mtime;
+  current_files_stack = g_slist_prepend (current_files_stack, rc_file);
+
+  return TRUE;
+}
+
+static void
+gtk_rc_context_parse_cached_text (GtkRcContext     *context,
+				  GtkRcCacheRecord *record)
+{
+  GtkRcFile *rc_file = current_files_stack->data;
+  GScanner *scanner;
+
+  scanner = gtk_rc_scanner_new ();
+  g_scanner_input_text (scanner, record->text, record->text_length);
+  scanner->input_name = rc_file->name;
+  scanner->line = record->line;
+
+  gtk_rc_parse_scanner (context, scanner);
+
+  g_scanner_destroy (scanner);
+}
+
+static gboolean
+gtk_rc_context_apply_cached_style (GtkRcContext     *context,
+				   GtkRcCache       *cache,
+				   GtkRcCacheRecord *record,
+				   GHashTable       *plain_styles)
+{
+  GtkRcStyle *rc_style;
+  GtkRcStyle *parent_style = NULL;
+
+  /* Reopening a style, or deriving from one that wasn't made from
+   * the cache, has to be done by the parser
+   */
+  if (gtk_rc_style_find (context, record->name))
+    return FALSE;
+
+  if (record->parent)
+    {
+      parent_style = g_hash_table_lookup (plain_styles, record->parent);
+      if (!parent_style || parent_style != gtk_rc_style_find (context, record->parent))
+	return FALSE;
+    }
+
+  rc_style = gtk_rc_style_new ();
+  rc_style->name = g_strdup (record->name);
+  _gtk_rc_cache_get_style (cache, record, rc_style);
+
+  gtk_rc_style_copy_icons_and_colors (rc_style, parent_style, context);
+
+  if (!context->rc_style_ht)
+    context->rc_style_ht = g_hash_table_new ((GHashFunc) gtk_rc_style_hash,
+					     (GEqualFunc) gtk_rc_style_equal);
+
+  g_hash_table_replace (context->rc_style_ht, rc_style->name, rc_style);
+  g_hash_table_insert (plain_styles, (gpointer) record->name, rc_style);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_rc_context_parse_cache (GtkRcContext *context,
+			    GtkRcFile    *rc_file,
+			    struct stat  *statbuf)
+{
+  GtkRcCache *cache;
+  GHashTable *plain_styles;
+  gchar *cache_file;
+  guint skip = 0;
+  guint i;
+
+  cache_file = g_strconcat (rc_file->canonical_name, GTK_RC_CACHE_SUFFIX, NULL);
+  cache = _gtk_rc_cache_new (cache_file);
+  g_free (cache_file);
+
+  if (!cache)
+    return FALSE;
+
+  if (!gtk_rc_cache_is_current (cache, statbuf))
+    {
+      _gtk_rc_cache_free (cache);
+      return FALSE;
+    }
+
+  /* styles made from the cache in this run, keyed by names that
+   * point into the cache; the values are only compared, never used
+   */
+  plain_styles = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < _gtk_rc_cache_get_n_records (cache); i++)
+    {
+      GtkRcCacheRecord record;
+      GtkRcStyle *rc_style;
+
+      _gtk_rc_cache_get_record (cache, i, &record);
+
+      /* Skip files that are already being parsed, like
+       * gtk_rc_context_parse_one_file() does
+       */
+      if (skip > 0)
+	{
+	  if (record.type == GTK_RC_CACHE_FILE_BEGIN)
+	    skip++;
+	  else if (record.type == GTK_RC_CACHE_FILE_END)
+	    skip--;
+	  continue;
+	}
+
+      switch (record.type)
+	{
+	case GTK_RC_CACHE_FILE_BEGIN:
+	  if (!gtk_rc_context_push_cached_file (context, cache, record.file))
+	    skip = 1;
+	  break;
+
+	case GTK_RC_CACHE_FILE_END:
+	  current_files_stack = g_slist_delete_link (current_files_stack,
+						     current_files_stack);
+	  break;
+
+	case GTK_RC_CACHE_STYLE:
+	  /* precompiled styles don't know where their properties
+	   * came from, so let the parser record that
+	   */
+	  if (!gtk_rc_record_origins () &&
+	      gtk_rc_context_apply_cached_style (context, cache, &record, plain_styles))
+	    break;
+	  /* fall through */
+	case GTK_RC_CACHE_TEXT:
+	  gtk_rc_context_parse_cached_text (context, &record);
+	  if (record.name)
+	    g_hash_table_remove (plain_styles, record.name);
+	  break;
+
+	case GTK_RC_CACHE_PATTERN:
+	  rc_style = gtk_rc_style_find (context, record.name);
+	  if (rc_style)
+	    gtk_rc_context_add_rc_set (context, record.path_type, record.pattern, rc_style,
+				       record.priority < 0 ? context->default_priority : record.priority);
+	  else
+	    gtk_rc_context_parse_cached_text (context, &record);
+	  break;
+
+	case GTK_RC_CACHE_SETTING:
+	  {
+	    GtkSettingsValue svalue = { NULL, { 0, }, };
+	    GtkRcFile *current_file = current_files_stack->data;
+
+	    if (gtk_rc_record_origins ())
+	      svalue.origin = g_strdup_printf ("%s:%u", current_file->name, record.line);
+
+	    _gtk_rc_cache_get_value (cache, &record, &svalue.value);
+	    _gtk_settings_set_property_value_from_rc (context->settings,
+						      record.name,
+						      &svalue);
+	    g_value_unset (&svalue.value);
+	    g_free (svalue.origin);
+	  }
+	  break;
+
+	case GTK_RC_CACHE_PIXMAP_PATH:
+	  gtk_rc_parse_pixmap_path_string (context, NULL, record.value);
+	  break;
+
+	default:
+	  g_assert_not_reached ();
+	}
+    }
+
+  GTK_NOTE (MISC, g_print ("parsed %s from its rc cache\n", rc_file->name));
+
+  g_hash_table_destroy (plain_styles);
+  _gtk_rc_cache_free (cache);
+
+  return TRUE;
+}
+
+static void
+gtk_rc_compile_one_file (GtkRcContext *context,
+			 GtkRcFile    *rc_file,
+			 const gchar  *filename,
+			 struct stat  *statbuf)
+{
+  GtkRcCompileState *state = rc_compile_state;
+  GtkRcCompileFile file;
+  GError *error = NULL;
+  gchar *contents;
+  gsize length;
+  gsize offset;
+  guint index;
+
+  if (!g_file_get_contents (rc_file->canonical_name, &contents, &length, &error))
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      state->failed = TRUE;
+      return;
+    }
+
+  index = _gtk_rc_cache_writer_add_file (state->writer, rc_file->canonical_name,
+					 statbuf->st_mtime, statbuf->st_size);
+
+  /* the records of the file we compile aren't bracketed */
+  if (state->files)
+    _gtk_rc_cache_writer_begin_file (state->writer, index);
+
+  file.text = contents;
+  file.line_offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+  offset = 0;
+  g_array_append_val (file.line_offsets, offset);
+  for (offset = 1; offset <= length; offset++)
+    if (contents[offset - 1] == '\n')
+      g_array_append_val (file.line_offsets, offset);
+
+  state->files = g_slist_prepend (state->files, &file);
+  gtk_rc_parse_any (context, filename, -1, contents);
+  state->files = g_slist_delete_link (state->files, state->files);
+
+  if (state->files)
+    _gtk_rc_cache_writer_end_file (state->writer);
+
+  g_array_free (file.line_offsets, TRUE);
+  g_free (contents);
+}
+
+static void
+gtk_rc_compile_set_setting (const gchar  *name,
+			    const GValue *value)
+{
+  GtkRcCompileState *state = rc_compile_state;
+
+  g_free (state->setting_name);
+  if (G_VALUE_TYPE (&state->setting_value))
+    g_value_unset (&state->setting_value);
+
+  state->setting_name = g_strdup (name);
+  g_value_init (&state->setting_value, G_VALUE_TYPE (value));
+  g_value_copy (value, &state->setting_value);
+}
+
+static GScanner *
+gtk_rc_compile_scanner_new (const gchar *text,
+			    gsize        length)
+{
+  GScanner *scanner;
+
+  scanner = gtk_rc_scanner_new ();
+  g_scanner_input_text (scanner, text, length);
+  gtk_rc_scanner_add_symbols (scanner);
+
+  return scanner;
+}
+
+/* Finds name and parent of a style statement, and whether
+ * it contains anything we can't precompile.
+ */
+static gboolean
+gtk_rc_compile_scan_style (const gchar  *text,
+			   gsize         length,
+			   gchar       **name,
+			   gchar       **parent)
+{
+  GScanner *scanner;
+  gboolean plain = TRUE;
+  guint token;
+
+  scanner = gtk_rc_compile_scanner_new (text, length);
+
+  if (g_scanner_get_next_token (scanner) == GTK_RC_TOKEN_STYLE &&
+      g_scanner_get_next_token (scanner) == G_TOKEN_STRING)
+    {
+      *name = g_strdup (scanner->value.v_string);
+
+      if (g_scanner_peek_next_token (scanner) == G_TOKEN_EQUAL_SIGN)
+	{
+	  g_scanner_get_next_token (scanner);
+	  if (g_scanner_get_next_token (scanner) == G_TOKEN_STRING)
+	    *parent = g_strdup (scanner->value.v_string);
+	}
+
+      do
+	{
+	  token = g_scanner_get_next_token (scanner);
+	  switch (token)
+	    {
+	    case GTK_RC_TOKEN_ENGINE:
+	    case GTK_RC_TOKEN_STOCK:
+	    case GTK_RC_TOKEN_COLOR:
+	    case GTK_RC_TOKEN_BG_PIXMAP:
+	    case G_TOKEN_ERROR:
+	      plain = FALSE;
+	      break;
+	    default:
+	      break;
+	    }
+	}
+      while (token != G_TOKEN_EOF && token != G_TOKEN_ERROR);
+    }
+  else
+    plain = FALSE;
+
+  g_scanner_destroy (scanner);
+
+  return plain;
+}
+
+/* Finds the pattern of a widget, widget_class or class statement;
+ * returns %FALSE for patterns that bind key bindings.
+ */
+static gboolean
+gtk_rc_compile_scan_pattern (const gchar  *text,
+			     gsize         length,
+			     gchar       **pattern)
+{
+  GScanner *scanner;
+  gboolean is_style = FALSE;
+
+  scanner = gtk_rc_compile_scanner_new (text, length);
+
+  g_scanner_get_next_token (scanner);
+  if (g_scanner_get_next_token (scanner) == G_TOKEN_STRING)
+    {
+      *pattern = g_strdup (scanner->value.v_string);
+      is_style = g_scanner_get_next_token (scanner) == GTK_RC_TOKEN_STYLE;
+    }
+
+  g_scanner_destroy (scanner);
+
+  return is_style;
+}
+
+static void
+gtk_rc_compile_statement (GtkRcContext *context,
+			  GScanner     *scanner,
+			  guint         token,
+			  gsize         start,
+			  guint         line)
+{
+  GtkRcCompileState *state = rc_compile_state;
+  GtkRcCompileFile *file = state->files->data;
+  const gchar *text = file->text + start;
+  gsize length = gtk_rc_compile_get_offset (scanner) - start;
+  gboolean plain;
+  gchar *name = NULL;
+  gchar *parent = NULL;
+  gchar *path;
+  GtkRcStyle *rc_style;
+  GtkRcSet *rc_set;
+  gint i;
+
+  /* symbolic colors are resolved against the color scheme
+   * of the settings at parse time
+   */
+  plain = memchr (text, '@', length) == NULL;
+
+  switch (token)
+    {
+    case GTK_RC_TOKEN_INCLUDE:
+      /* the statements of the included file have been recorded */
+      break;
+
+    case GTK_RC_TOKEN_STYLE:
+      plain &= gtk_rc_compile_scan_style (text, length, &name, &parent);
+      rc_style = name ? gtk_rc_style_find (context, name) : NULL;
+
+      plain &= rc_style != NULL &&
+	       G_OBJECT_TYPE (rc_style) == GTK_TYPE_RC_STYLE &&
+	       rc_style->icon_factories == NULL &&
+	       !g_hash_table_lookup (state->defined_styles, name) &&
+	       (!parent || g_hash_table_lookup (state->plain_styles, parent));
+      for (i = 0; plain && i < 5; i++)
+	plain = rc_style->bg_pixmap_name[i] == NULL;
+
+      if (name)
+	g_hash_table_replace (state->defined_styles, g_strdup (name), GINT_TO_POINTER (TRUE));
+
+      if (plain &&
+	  _gtk_rc_cache_writer_add_style (state->writer, line, text, length, rc_style, parent))
+	g_hash_table_replace (state->plain_styles, g_strdup (name), GINT_TO_POINTER (TRUE));
+      else
+	{
+	  if (name)
+	    g_hash_table_remove (state->plain_styles, name);
+	  _gtk_rc_cache_writer_add_text (state->writer, line, text, length, name);
+	}
+      break;
+
+    case GTK_RC_TOKEN_WIDGET:
+    case GTK_RC_TOKEN_WIDGET_CLASS:
+    case GTK_RC_TOKEN_CLASS:
+      if (gtk_rc_compile_scan_pattern (text, length, &name))
+	{
+	  if (token == GTK_RC_TOKEN_WIDGET)
+	    rc_set = context->rc_sets_widget->data;
+	  else if (token == GTK_RC_TOKEN_WIDGET_CLASS)
+	    rc_set = context->rc_sets_widget_class->data;
+	  else
+	    rc_set = context->rc_sets_class->data;
+
+	  _gtk_rc_cache_writer_add_pattern (state->writer, line, text, length,
+					    rc_set->type, name, rc_set->priority,
+					    rc_set->rc_style->name);
+	}
+      else
+	_gtk_rc_cache_writer_add_text (state->writer, line, text, length, NULL);
+      break;
+
+    case GTK_RC_TOKEN_PIXMAP_PATH:
+      path = g_strjoinv (G_SEARCHPATH_SEPARATOR_S, context->pixmap_path);
+      _gtk_rc_cache_writer_add_pixmap_path (state->writer, line, text, length, path);
+      g_free (path);
+      break;
+
+    case G_TOKEN_IDENTIFIER:
+      if (!plain || !state->setting_name ||
+	  !_gtk_rc_cache_writer_add_setting (state->writer, line, text, length,
+					     state->setting_name, &state->setting_value))
+	_gtk_rc_cache_writer_add_text (state->writer, line, text, length, NULL);
+
+      g_free (state->setting_name);
+      state->setting_name = NULL;
+      if (G_VALUE_TYPE (&state->setting_value))
+	g_value_unset (&state->setting_value);
+      break;
+
+    default:
+      _gtk_rc_cache_writer_add_text (state->writer, line, text, length, NULL);
+      break;
+    }
+
+  g_free (name);
+  g_free (parent);
+}
+
+/**
+ * _gtk_rc_compile_file:
+ * @filename: an RC file
+ * @cache_file: where to write the compiled form of @filename
+ * @error: return location for a #GError, or %NULL
+ *
+ * Parses @filename and the files it includes into a context of its
+ * own and writes the result to @cache_file. This is what
+ * gtk-update-rc-cache uses.
+ *
+ * Return value: %TRUE if the cache was written
+ **/
+gboolean
+_gtk_rc_compile_file (const gchar  *filename,
+		      const gchar  *cache_file,
+		      GError      **error)
+{
+  GtkRcCompileState state;
+  GtkSettings *settings;
+  GtkRcContext *context;
+  GSList *saved_files_stack;
+  gboolean retval = FALSE;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (cache_file != NULL, FALSE);
+  g_return_val_if_fail (rc_compile_state == NULL, FALSE);
+
+  if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+		   _("Can't find RC file \"%s\""), filename);
+      return FALSE;
+    }
+
+  memset (&state, 0, sizeof (GtkRcCompileState));
+  state.writer = _gtk_rc_cache_writer_new ();
+  state.defined_styles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  state.plain_styles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* A settings object without a screen gives us a context
+   * that nothing else has been parsed into
+   */
+  settings = g_object_new (GTK_TYPE_SETTINGS, NULL);
+  context = gtk_rc_context_get (settings);
+
+  saved_files_stack = current_files_stack;
+  current_files_stack = NULL;
+  rc_compile_state = &state;
+
+  gtk_rc_context_parse_one_file (context, filename,
+				 GTK_RC_COMPILE_DEFAULT_PRIORITY, FALSE);
+
+  rc_compile_state = NULL;
+  current_files_stack = saved_files_stack;
+
+  if (state.failed)
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+		 _("Failed to parse RC file \"%s\""), filename);
+  else
+    retval = _gtk_rc_cache_writer_write (state.writer, cache_file, error);
+
+  g_object_unref (settings);
+
+  g_free (state.setting_name);
+  if (G_VALUE_TYPE (&state.setting_value))
+    g_value_unset (&state.setting_value);
+  g_hash_table_destroy (state.defined_styles);
+  g_hash_table_destroy (state.plain_styles);
+  _gtk_rc_cache_writer_free (state.writer);
+
+  return retval;
+}
+
+static guint	   
+gtk_rc_styles_hash (const GSList *rc_styles)
+{
+  guint result;
+  
+  result = 0;
+  while (rc_styles)
+    {
+      result += (result << 9) + GPOINTER_TO_UINT (rc_styles->data);
+      rc_styles = rc_styles->next;
+    }
+  
   return result;
 }
 
@@ -2330,6 +3270,182 @@ gtk_rc_styles_equal (const GSList *a,
   return (a == b);
 }
 
+static gboolean
+gtk_rc_strings_equal (const gchar *a,
+		      const gchar *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return strcmp (a, b) == 0;
+}
+
+/* Modifier styles can only be compared by their contents if
+ * they don't carry anything beyond the plain GtkRcStyle fields.
+ * The properties set by gtk_widget_modify_cursor() are strings.
+ */
+static gboolean
+gtk_rc_style_can_share (GtkRcStyle *rc_style)
+{
+  GtkRcStylePrivate *priv = GTK_RC_STYLE_GET_PRIVATE (rc_style);
+  guint i;
+
+  if (G_OBJECT_TYPE (rc_style) != GTK_TYPE_RC_STYLE ||
+      rc_style->engine_specified ||
+      rc_style->icon_factories != NULL ||
+      priv->color_hashes != NULL)
+    return FALSE;
+
+  if (rc_style->rc_properties)
+    for (i = 0; i < rc_style->rc_properties->len; i++)
+      {
+	GtkRcProperty *node = &g_array_index (rc_style->rc_properties, GtkRcProperty, i);
+
+	if (!G_VALUE_HOLDS_STRING (&node->value))
+	  return FALSE;
+      }
+
+  return TRUE;
+}
+
+static guint
+gtk_rc_style_content_hash (GtkRcStyle *rc_style)
+{
+  guint result;
+  guint i;
+
+  result = rc_style->xthickness + (rc_style->ythickness << 8);
+
+  for (i = 0; i < 5; i++)
+    {
+      result += (result << 5) + rc_style->color_flags[i];
+      if (rc_style->color_flags[i] & GTK_RC_FG)
+	result += (result << 5) + gdk_color_hash (&rc_style->fg[i]);
+      if (rc_style->color_flags[i] & GTK_RC_BG)
+	result += (result << 5) + gdk_color_hash (&rc_style->bg[i]);
+      if (rc_style->color_flags[i] & GTK_RC_TEXT)
+	result += (result << 5) + gdk_color_hash (&rc_style->text[i]);
+      if (rc_style->color_flags[i] & GTK_RC_BASE)
+	result += (result << 5) + gdk_color_hash (&rc_style->base[i]);
+      if (rc_style->bg_pixmap_name[i])
+	result += (result << 5) + g_str_hash (rc_style->bg_pixmap_name[i]);
+    }
+
+  if (rc_style->font_desc)
+    result += (result << 5) + pango_font_description_hash (rc_style->font_desc);
+
+  if (rc_style->rc_properties)
+    result += (result << 5) + rc_style->rc_properties->len;
+
+  return result;
+}
+
+static gboolean
+gtk_rc_style_content_equal (GtkRcStyle *a,
+			    GtkRcStyle *b)
+{
+  guint n_props_a, n_props_b;
+  guint i;
+
+  if (a->xthickness != b->xthickness ||
+      a->ythickness != b->ythickness)
+    return FALSE;
+
+  for (i = 0; i < 5; i++)
+    {
+      if (a->color_flags[i] != b->color_flags[i])
+	return FALSE;
+      if ((a->color_flags[i] & GTK_RC_FG) && !gdk_color_equal (&a->fg[i], &b->fg[i]))
+	return FALSE;
+      if ((a->color_flags[i] & GTK_RC_BG) && !gdk_color_equal (&a->bg[i], &b->bg[i]))
+	return FALSE;
+      if ((a->color_flags[i] & GTK_RC_TEXT) && !gdk_color_equal (&a->text[i], &b->text[i]))
+	return FALSE;
+      if ((a->color_flags[i] & GTK_RC_BASE) && !gdk_color_equal (&a->base[i], &b->base[i]))
+	return FALSE;
+      if (!gtk_rc_strings_equal (a->bg_pixmap_name[i], b->bg_pixmap_name[i]))
+	return FALSE;
+    }
+
+  if (a->font_desc == NULL || b->font_desc == NULL)
+    {
+      if (a->font_desc != b->font_desc)
+	return FALSE;
+    }
+  else if (!pango_font_description_equal (a->font_desc, b->font_desc))
+    return FALSE;
+
+  n_props_a = a->rc_properties ? a->rc_properties->len : 0;
+  n_props_b = b->rc_properties ? b->rc_properties->len : 0;
+  if (n_props_a != n_props_b)
+    return FALSE;
+
+  /* properties are kept sorted, so they can be compared in order */
+  for (i = 0; i < n_props_a; i++)
+    {
+      GtkRcProperty *node_a = &g_array_index (a->rc_properties, GtkRcProperty, i);
+      GtkRcProperty *node_b = &g_array_index (b->rc_properties, GtkRcProperty, i);
+
+      if (node_a->type_name != node_b->type_name ||
+	  node_a->property_name != node_b->property_name ||
+	  !gtk_rc_strings_equal (node_a->origin, node_b->origin) ||
+	  !gtk_rc_strings_equal (g_value_get_string (&node_a->value),
+				 g_value_get_string (&node_b->value)))
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Returns the rc style to use in place of @rc_style when matching
+ * styles. Every widget gets its own copy of the modifier style in
+ * gtk_widget_modify_style(), so without this, each modified widget
+ * ends up with a GtkStyle of its own even when the modifications
+ * are the same. The interned copy is never handed out, so it can't
+ * change under the hash table; changing a modifier style always
+ * goes through a new copy and a new lookup.
+ */
+static GtkRcStyle *
+gtk_rc_style_get_shared (GtkRcStyle *rc_style)
+{
+  GtkRcStylePrivate *priv = GTK_RC_STYLE_GET_PRIVATE (rc_style);
+  GtkRcStyle *shared;
+
+  if (priv->interned)
+    return rc_style;
+
+  if (priv->shared)
+    {
+      if (gtk_rc_style_can_share (rc_style) &&
+	  gtk_rc_style_content_equal (priv->shared, rc_style))
+	return priv->shared;
+
+      g_object_unref (priv->shared);
+      priv->shared = NULL;
+    }
+
+  if (!gtk_rc_style_can_share (rc_style))
+    return rc_style;
+
+  if (!shared_rc_style_ht)
+    shared_rc_style_ht = g_hash_table_new ((GHashFunc) gtk_rc_style_content_hash,
+					   (GEqualFunc) gtk_rc_style_content_equal);
+
+  shared = g_hash_table_lookup (shared_rc_style_ht, rc_style);
+  if (shared)
+    g_object_ref (shared);
+  else
+    {
+      shared = gtk_rc_style_copy (rc_style);
+      GTK_RC_STYLE_GET_PRIVATE (shared)->interned = TRUE;
+      g_hash_table_insert (shared_rc_style_ht, shared, shared);
+    }
+
+  priv->shared = shared;
+
+  return shared;
+}
+
 static guint
 gtk_rc_style_hash (const gchar *name)
 {
@@ -2629,7 +3745,7 @@ gtk_rc_parse_assignment (GScanner      *scanner,
   scanner->config->numbers_2_int        = MY_NUMBERS_2_INT;
 
   /* record location */
-  if (g_getenv ("GTK_DEBUG"))
+  if (gtk_rc_record_origins ())
     prop->origin = g_strdup_printf ("%s:%u", scanner->input_name, scanner->line);
   else
     prop->origin = NULL;
@@ -2931,9 +4047,16 @@ gtk_rc_parse_statement (GtkRcContext *context,
 	      svalue.origin = prop.origin;
 	      memcpy (&svalue.value, &prop.value, sizeof (prop.value));
 	      g_strcanon (name, G_CSET_DIGITS "-" G_CSET_a_2_z G_CSET_A_2_Z, '-');
-	      _gtk_settings_set_property_value_from_rc (context->settings,
-							name,
-							&svalue);
+
+	      /* the settings of the context we compile into are
+	       * not hooked up to a screen, so leave them alone
+	       */
+	      if (rc_compile_state)
+		gtk_rc_compile_set_setting (name, &prop.value);
+	      else
+		_gtk_settings_set_property_value_from_rc (context->settings,
+							  name,
+							  &svalue);
 	    }
 	  g_free (prop.origin);
 	  if (G_VALUE_TYPE (&prop.value))
@@ -2975,6 +4098,8 @@ fixup_rc_sets (GtkRcContext *context,
   fixup_rc_set (context->rc_sets_widget, orig, new);
   fixup_rc_set (context->rc_sets_widget_class, orig, new);
   fixup_rc_set (context->rc_sets_class, orig, new);
+
+  gtk_rc_context_clear_match_cache (context);
 }
 
 static guint
@@ -4207,7 +5332,6 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
   else
     {
       GtkRcStyle *rc_style;
-      GtkRcSet *rc_set;
 
       rc_style = gtk_rc_style_find (context, scanner->value.v_string);
       
@@ -4217,35 +5341,50 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
 	  return G_TOKEN_STRING;
 	}
 
-      rc_set = g_new (GtkRcSet, 1);
-      rc_set->type = path_type;
-      
-      if (path_type == GTK_PATH_WIDGET_CLASS)
-        {
-          rc_set->pspec = NULL;
-          rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
-        }
-      else
-        {
-          rc_set->pspec = g_pattern_spec_new (pattern);
-          rc_set->path = NULL;
-        }
-      
-      rc_set->rc_style = rc_style;
-      rc_set->priority = priority;
-
-      if (path_type == GTK_PATH_WIDGET)
-	context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
-      else if (path_type == GTK_PATH_WIDGET_CLASS)
-	context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
-      else
-	context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+      gtk_rc_context_add_rc_set (context, path_type, pattern, rc_style, priority);
     }
 
   g_free (pattern);
   return G_TOKEN_NONE;
 }
 
+static void
+gtk_rc_context_add_rc_set (GtkRcContext *context,
+			   GtkPathType   path_type,
+			   const gchar  *pattern,
+			   GtkRcStyle   *rc_style,
+			   gint          priority)
+{
+  GtkRcSet *rc_set;
+
+  rc_set = g_new (GtkRcSet, 1);
+  rc_set->type = path_type;
+  
+  if (path_type == GTK_PATH_WIDGET_CLASS)
+    {
+      rc_set->pspec = NULL;
+      rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
+    }
+  else
+    {
+      rc_set->pspec = g_pattern_spec_new (pattern);
+      rc_set->path = NULL;
+    }
+  
+  rc_set->rc_style = rc_style;
+  rc_set->priority = priority;
+  rc_set->last_component = gtk_rc_pattern_get_last_component (pattern);
+
+  if (path_type == GTK_PATH_WIDGET)
+    context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
+  else if (path_type == GTK_PATH_WIDGET_CLASS)
+    context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
+  else
+    context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+
+  gtk_rc_context_clear_match_cache (context);
+}
+
 static guint
 gtk_rc_parse_hash_key (GScanner  *scanner,
                        gchar    **hash_key)
@@ -4673,6 +5812,7 @@ gtk_rc_set_free (GtkRcSet *rc_set)
     g_pattern_spec_free (rc_set->pspec);
 
   _gtk_rc_free_widget_class_path (rc_set->path);
+  g_free (rc_set->last_component);
   
   g_free (rc_set);
 }
@@ -0,0 +1,858 @@
+/* GTK - The GIMP Toolkit
+ * gtkrccache.c: Precompiled, mappable representation of RC files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The cache file produced by gtk-update-rc-cache is laid out as
+ * follows; all numbers are 32 bit big endian:
+ *
+ *   Header:
+ *     0  "GRCC"
+ *     4  major version (16 bit), minor version (16 bit)
+ *     8  number of files, offset of the file table
+ *    16  number of records, offset of the record table
+ *    24  offset and size of the data area
+ *
+ *   File (the first one is the RC file the cache belongs to):
+ *        name, mtime (high, low), size (high, low)
+ *
+ *   Record:
+ *        type, line, text, text length, payload
+ *
+ * Strings, statement texts and payload blocks live in the data
+ * area and are referenced by their offset into it; offset 0 means
+ * "none".  The payload of FILE_BEGIN is the index of the file,
+ * that of TEXT the name of the style it defines (if any) and that
+ * of PIXMAP_PATH the path string.  The other record types point to
+ * blocks:
+ *
+ *   STYLE:    name, parent, font, xthickness, ythickness,
+ *             color flags[5], { fg, bg, text, base }[5] as r, g, b,
+ *             number of properties, then per property
+ *             type name, property name, value kind, value
+ *   PATTERN:  path type, priority, pattern, style name
+ *   SETTING:  name, value kind, value
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "gtkdebug.h"
+#include "gtkrccache.h"
+#include "gtkalias.h"
+
+#define MAJOR_VERSION 1
+#define MINOR_VERSION 0
+
+#define HEADER_SIZE     32
+#define FILE_SIZE       5
+#define RECORD_SIZE     5
+#define STYLE_SIZE      71
+#define PROPERTY_SIZE   4
+#define PATTERN_SIZE    4
+#define SETTING_SIZE    3
+
+#define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
+#define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
+
+#define DATA_UINT32(cache, offset, i) GET_UINT32 ((cache)->data, (offset) + 4 * (i))
+#define DATA_STRING(cache, offset) ((offset) ? (cache)->data + (offset) : NULL)
+
+typedef enum
+{
+  VALUE_LONG,
+  VALUE_DOUBLE,
+  VALUE_STRING,
+  VALUE_GSTRING,
+  VALUE_LAST
+} ValueKind;
+
+struct _GtkRcCache
+{
+  GMappedFile *map;
+  const gchar *buffer;
+
+  guint32 n_files;
+  guint32 files_offset;
+  guint32 n_records;
+  guint32 records_offset;
+
+  const gchar *data;
+  guint32 data_size;
+};
+
+struct _GtkRcCacheWriter
+{
+  GArray *files;
+  GArray *records;
+  GByteArray *data;
+  GHashTable *strings;
+};
+
+static gboolean
+check_string (GtkRcCache *cache,
+              guint32     offset,
+              gboolean    optional)
+{
+  if (offset == 0)
+    return optional;
+
+  return offset < cache->data_size &&
+         memchr (cache->data + offset, 0, cache->data_size - offset) != NULL;
+}
+
+static gboolean
+check_block (GtkRcCache *cache,
+             guint32     offset,
+             guint32     n_values)
+{
+  return offset != 0 && offset % 4 == 0 &&
+         offset <= cache->data_size &&
+         n_values <= (cache->data_size - offset) / 4;
+}
+
+static gboolean
+check_record (GtkRcCache *cache,
+              guint       index,
+              gint       *depth)
+{
+  guint32 offset = cache->records_offset + 4 * RECORD_SIZE * index;
+  guint32 type, text, text_length, payload;
+  guint32 n_properties, i;
+
+  type = GET_UINT32 (cache->buffer, offset);
+  text = GET_UINT32 (cache->buffer, offset + 8);
+  text_length = GET_UINT32 (cache->buffer, offset + 12);
+  payload = GET_UINT32 (cache->buffer, offset + 16);
+
+  if (type >= GTK_RC_CACHE_LAST)
+    return FALSE;
+
+  if (type != GTK_RC_CACHE_FILE_BEGIN && type != GTK_RC_CACHE_FILE_END)
+    {
+      /* statement texts are nul-terminated */
+      if (text == 0 || text >= cache->data_size ||
+          text_length >= cache->data_size - text ||
+          cache->data[text + text_length] != '\0')
+        return FALSE;
+    }
+
+  switch (type)
+    {
+    case GTK_RC_CACHE_FILE_BEGIN:
+      (*depth)++;
+      return payload > 0 && payload < cache->n_files;
+
+    case GTK_RC_CACHE_FILE_END:
+      (*depth)--;
+      return *depth >= 0;
+
+    case GTK_RC_CACHE_TEXT:
+      return check_string (cache, payload, TRUE);
+
+    case GTK_RC_CACHE_STYLE:
+      if (!check_block (cache, payload, STYLE_SIZE) ||
+          !check_string (cache, DATA_UINT32 (cache, payload, 0), FALSE) ||
+          !check_string (cache, DATA_UINT32 (cache, payload, 1), TRUE) ||
+          !check_string (cache, DATA_UINT32 (cache, payload, 2), TRUE))
+        return FALSE;
+
+      n_properties = DATA_UINT32 (cache, payload, STYLE_SIZE - 1);
+      if (n_properties > cache->data_size / (4 * PROPERTY_SIZE))
+        return FALSE;
+      payload += 4 * STYLE_SIZE;
+      if (!check_block (cache, payload, PROPERTY_SIZE * n_properties))
+        return FALSE;
+
+      for (i = 0; i < n_properties; i++, payload += 4 * PROPERTY_SIZE)
+        if (!check_string (cache, DATA_UINT32 (cache, payload, 0), FALSE) ||
+            !check_string (cache, DATA_UINT32 (cache, payload, 1), FALSE) ||
+            DATA_UINT32 (cache, payload, 2) >= VALUE_LAST ||
+            !check_string (cache, DATA_UINT32 (cache, payload, 3), FALSE))
+          return FALSE;
+      return TRUE;
+
+    case GTK_RC_CACHE_PATTERN:
+      return check_block (cache, payload, PATTERN_SIZE) &&
+             DATA_UINT32 (cache, payload, 0) <= GTK_PATH_CLASS &&
+             check_string (cache, DATA_UINT32 (cache, payload, 2), FALSE) &&
+             check_string (cache, DATA_UINT32 (cache, payload, 3), FALSE);
+
+    case GTK_RC_CACHE_SETTING:
+      return check_block (cache, payload, SETTING_SIZE) &&
+             check_string (cache, DATA_UINT32 (cache, payload, 0), FALSE) &&
+             DATA_UINT32 (cache, payload, 1) < VALUE_LAST &&
+             check_string (cache, DATA_UINT32 (cache, payload, 2), FALSE);
+
+    case GTK_RC_CACHE_PIXMAP_PATH:
+      return check_string (cache, payload, FALSE);
+
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+check_cache (GtkRcCache *cache,
+             gsize       size)
+{
+  guint32 i;
+  gint depth = 0;
+
+  if (size < HEADER_SIZE ||
+      memcmp (cache->buffer, "GRCC", 4) != 0 ||
+      GET_UINT16 (cache->buffer, 4) != MAJOR_VERSION)
+    return FALSE;
+
+  cache->n_files = GET_UINT32 (cache->buffer, 8);
+  cache->files_offset = GET_UINT32 (cache->buffer, 12);
+  cache->n_records = GET_UINT32 (cache->buffer, 16);
+  cache->records_offset = GET_UINT32 (cache->buffer, 20);
+  cache->data = cache->buffer + GET_UINT32 (cache->buffer, 24);
+  cache->data_size = GET_UINT32 (cache->buffer, 28);
+
+  if (cache->n_files == 0 ||
+      cache->n_files > size / (4 * FILE_SIZE) ||
+      cache->n_records > size / (4 * RECORD_SIZE) ||
+      cache->files_offset % 4 != 0 ||
+      cache->files_offset > size ||
+      4 * FILE_SIZE * cache->n_files > size - cache->files_offset ||
+      cache->records_offset % 4 != 0 ||
+      cache->records_offset > size ||
+      4 * RECORD_SIZE * cache->n_records > size - cache->records_offset ||
+      GET_UINT32 (cache->buffer, 24) % 4 != 0 ||
+      GET_UINT32 (cache->buffer, 24) > size ||
+      cache->data_size > size - GET_UINT32 (cache->buffer, 24))
+    return FALSE;
+
+  for (i = 0; i < cache->n_files; i++)
+    if (!check_string (cache,
+                       GET_UINT32 (cache->buffer, cache->files_offset + 4 * FILE_SIZE * i),
+                       FALSE))
+      return FALSE;
+
+  for (i = 0; i < cache->n_records; i++)
+    if (!check_record (cache, i, &depth))
+      return FALSE;
+
+  return depth == 0;
+}
+
+/**
+ * _gtk_rc_cache_new:
+ * @filename: the cache file
+ *
+ * Maps a cache file written by gtk-update-rc-cache and checks that it
+ * is well-formed; every offset is verified here, so the accessors
+ * below don't need to. Whether the cache is still up to date with
+ * the RC files it was made from is for the caller to find out.
+ *
+ * Return value: the cache, or %NULL if it doesn't exist or is broken
+ **/
+GtkRcCache *
+_gtk_rc_cache_new (const gchar *filename)
+{
+  GtkRcCache *cache;
+  GMappedFile *map;
+
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  if (!map)
+    return NULL;
+
+  cache = g_new0 (GtkRcCache, 1);
+  cache->map = map;
+  cache->buffer = g_mapped_file_get_contents (map);
+
+  if (!check_cache (cache, g_mapped_file_get_length (map)))
+    {
+      GTK_NOTE (MISC, g_print ("ignoring invalid rc cache %s\n", filename));
+
+      _gtk_rc_cache_free (cache);
+      return NULL;
+    }
+
+  return cache;
+}
+
+void
+_gtk_rc_cache_free (GtkRcCache *cache)
+{
+  g_mapped_file_free (cache->map);
+  g_free (cache);
+}
+
+guint
+_gtk_rc_cache_get_n_files (GtkRcCache *cache)
+{
+  return cache->n_files;
+}
+
+const gchar *
+_gtk_rc_cache_get_file (GtkRcCache *cache,
+                        guint       index,
+                        guint64    *mtime,
+                        guint64    *size)
+{
+  guint32 offset;
+
+  g_return_val_if_fail (index < cache->n_files, NULL);
+
+  offset = cache->files_offset + 4 * FILE_SIZE * index;
+
+  *mtime = ((guint64) GET_UINT32 (cache->buffer, offset + 4) << 32) |
+           GET_UINT32 (cache->buffer, offset + 8);
+  *size = ((guint64) GET_UINT32 (cache->buffer, offset + 12) << 32) |
+          GET_UINT32 (cache->buffer, offset + 16);
+
+  return cache->data + GET_UINT32 (cache->buffer, offset);
+}
+
+guint
+_gtk_rc_cache_get_n_records (GtkRcCache *cache)
+{
+  return cache->n_records;
+}
+
+void
+_gtk_rc_cache_get_record (GtkRcCache       *cache,
+                          guint             index,
+                          GtkRcCacheRecord *record)
+{
+  guint32 offset;
+  guint32 payload;
+
+  g_return_if_fail (index < cache->n_records);
+
+  offset = cache->records_offset + 4 * RECORD_SIZE * index;
+  payload = GET_UINT32 (cache->buffer, offset + 16);
+
+  memset (record, 0, sizeof (GtkRcCacheRecord));
+  record->type = GET_UINT32 (cache->buffer, offset);
+  record->line = GET_UINT32 (cache->buffer, offset + 4);
+  record->text = DATA_STRING (cache, GET_UINT32 (cache->buffer, offset + 8));
+  record->text_length = GET_UINT32 (cache->buffer, offset + 12);
+  record->payload = payload;
+
+  switch (record->type)
+    {
+    case GTK_RC_CACHE_FILE_BEGIN:
+      record->file = payload;
+      break;
+    case GTK_RC_CACHE_TEXT:
+      record->name = DATA_STRING (cache, payload);
+      break;
+    case GTK_RC_CACHE_STYLE:
+      record->name = DATA_STRING (cache, DATA_UINT32 (cache, payload, 0));
+      record->parent = DATA_STRING (cache, DATA_UINT32 (cache, payload, 1));
+      break;
+    case GTK_RC_CACHE_PATTERN:
+      record->path_type = DATA_UINT32 (cache, payload, 0);
+      record->priority = (gint32) DATA_UINT32 (cache, payload, 1);
+      record->pattern = DATA_STRING (cache, DATA_UINT32 (cache, payload, 2));
+      record->name = DATA_STRING (cache, DATA_UINT32 (cache, payload, 3));
+      break;
+    case GTK_RC_CACHE_SETTING:
+      record->name = DATA_STRING (cache, DATA_UINT32 (cache, payload, 0));
+      record->value = DATA_STRING (cache, DATA_UINT32 (cache, payload, 2));
+      break;
+    case GTK_RC_CACHE_PIXMAP_PATH:
+      record->value = DATA_STRING (cache, payload);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+decode_value (ValueKind    kind,
+              const gchar *string,
+              GValue      *value)
+{
+  switch (kind)
+    {
+    case VALUE_LONG:
+      g_value_init (value, G_TYPE_LONG);
+      g_value_set_long (value, g_ascii_strtoll (string, NULL, 10));
+      break;
+    case VALUE_DOUBLE:
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, g_ascii_strtod (string, NULL));
+      break;
+    case VALUE_STRING:
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, string);
+      break;
+    case VALUE_GSTRING:
+      g_value_init (value, G_TYPE_GSTRING);
+      g_value_take_boxed (value, g_string_new (string));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gchar *
+encode_value (const GValue *value,
+              ValueKind    *kind)
+{
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+  GString *gstring;
+
+  switch (G_VALUE_TYPE (value))
+    {
+    case G_TYPE_LONG:
+      *kind = VALUE_LONG;
+      return g_strdup_printf ("%ld", g_value_get_long (value));
+    case G_TYPE_DOUBLE:
+      *kind = VALUE_DOUBLE;
+      return g_strdup (g_ascii_dtostr (buf, sizeof (buf), g_value_get_double (value)));
+    case G_TYPE_STRING:
+      *kind = VALUE_STRING;
+      return g_value_dup_string (value);
+    default:
+      if (G_VALUE_HOLDS (value, G_TYPE_GSTRING))
+        {
+          *kind = VALUE_GSTRING;
+          gstring = g_value_get_boxed (value);
+          return g_strdup (gstring ? gstring->str : "");
+        }
+      return NULL;
+    }
+}
+
+/**
+ * _gtk_rc_cache_get_style:
+ * @cache: a #GtkRcCache
+ * @record: a %GTK_RC_CACHE_STYLE record
+ * @rc_style: a fresh #GtkRcStyle
+ *
+ * Fills in colors, thickness, font and style properties of @rc_style
+ * from @record. Name, icon factories and color hashes are left to the
+ * caller.
+ **/
+void
+_gtk_rc_cache_get_style (GtkRcCache       *cache,
+                         GtkRcCacheRecord *record,
+                         GtkRcStyle       *rc_style)
+{
+  guint32 payload = record->payload;
+  const gchar *font;
+  guint32 n_properties, i, k;
+
+  g_return_if_fail (record->type == GTK_RC_CACHE_STYLE);
+
+  font = DATA_STRING (cache, DATA_UINT32 (cache, payload, 2));
+  if (font)
+    rc_style->font_desc = pango_font_description_from_string (font);
+
+  rc_style->xthickness = (gint32) DATA_UINT32 (cache, payload, 3);
+  rc_style->ythickness = (gint32) DATA_UINT32 (cache, payload, 4);
+
+  for (i = 0; i < 5; i++)
+    {
+      GdkColor *colors[4];
+
+      colors[0] = &rc_style->fg[i];
+      colors[1] = &rc_style->bg[i];
+      colors[2] = &rc_style->text[i];
+      colors[3] = &rc_style->base[i];
+
+      rc_style->color_flags[i] = DATA_UINT32 (cache, payload, 5 + i);
+
+      for (k = 0; k < 4; k++)
+        {
+          guint32 base = 10 + 12 * i + 3 * k;
+
+          colors[k]->pixel = 0;
+          colors[k]->red = DATA_UINT32 (cache, payload, base);
+          colors[k]->green = DATA_UINT32 (cache, payload, base + 1);
+          colors[k]->blue = DATA_UINT32 (cache, payload, base + 2);
+        }
+    }
+
+  n_properties = DATA_UINT32 (cache, payload, STYLE_SIZE - 1);
+  payload += 4 * STYLE_SIZE;
+
+  for (i = 0; i < n_properties; i++, payload += 4 * PROPERTY_SIZE)
+    {
+      GtkRcProperty prop = { 0, 0, NULL, { 0, }, };
+
+      prop.type_name = g_quark_from_string (DATA_STRING (cache, DATA_UINT32 (cache, payload, 0)));
+      prop.property_name = g_quark_from_string (DATA_STRING (cache, DATA_UINT32 (cache, payload, 1)));
+      decode_value (DATA_UINT32 (cache, payload, 2),
+                    DATA_STRING (cache, DATA_UINT32 (cache, payload, 3)),
+                    &prop.value);
+
+      _gtk_rc_style_set_rc_property (rc_style, &prop);
+      g_value_unset (&prop.value);
+    }
+}
+
+/**
+ * _gtk_rc_cache_get_value:
+ * @cache: a #GtkRcCache
+ * @record: a %GTK_RC_CACHE_SETTING record
+ * @value: an uninitialized #GValue
+ *
+ * Initializes @value to the value assigned by @record.
+ *
+ * Return value: %TRUE if @record is a setting
+ **/
+gboolean
+_gtk_rc_cache_get_value (GtkRcCache       *cache,
+                         GtkRcCacheRecord *record,
+                         GValue           *value)
+{
+  if (record->type != GTK_RC_CACHE_SETTING)
+    return FALSE;
+
+  decode_value (DATA_UINT32 (cache, record->payload, 1), record->value, value);
+
+  return TRUE;
+}
+
+GtkRcCacheWriter *
+_gtk_rc_cache_writer_new (void)
+{
+  GtkRcCacheWriter *writer;
+  guint32 none = 0;
+
+  writer = g_new (GtkRcCacheWriter, 1);
+  writer->files = g_array_new (FALSE, FALSE, sizeof (guint32));
+  writer->records = g_array_new (FALSE, FALSE, sizeof (guint32));
+  writer->data = g_byte_array_new ();
+  writer->strings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* offset 0 means "none" */
+  g_byte_array_append (writer->data, (guint8 *) &none, 4);
+
+  return writer;
+}
+
+void
+_gtk_rc_cache_writer_free (GtkRcCacheWriter *writer)
+{
+  g_array_free (writer->files, TRUE);
+  g_array_free (writer->records, TRUE);
+  g_byte_array_free (writer->data, TRUE);
+  g_hash_table_destroy (writer->strings);
+  g_free (writer);
+}
+
+static guint32
+writer_add_bytes (GtkRcCacheWriter *writer,
+                  const gchar      *bytes,
+                  gsize             length)
+{
+  static const guint8 padding[4] = { 0, };
+  guint32 offset = writer->data->len;
+
+  g_byte_array_append (writer->data, (const guint8 *) bytes, length);
+  g_byte_array_append (writer->data, padding, 4 - length % 4);
+
+  return offset;
+}
+
+static guint32
+writer_add_string (GtkRcCacheWriter *writer,
+                   const gchar      *string)
+{
+  gpointer offset;
+
+  if (!string)
+    return 0;
+
+  if (!g_hash_table_lookup_extended (writer->strings, string, NULL, &offset))
+    {
+      offset = GUINT_TO_POINTER (writer_add_bytes (writer, string, strlen (string)));
+      g_hash_table_insert (writer->strings, g_strdup (string), offset);
+    }
+
+  return GPOINTER_TO_UINT (offset);
+}
+
+static guint32
+writer_add_block (GtkRcCacheWriter *writer,
+                  const guint32    *values,
+                  guint             n_values)
+{
+  guint32 offset = writer->data->len;
+  guint i;
+
+  for (i = 0; i < n_values; i++)
+    {
+      guint32 value = GUINT32_TO_BE (values[i]);
+
+      g_byte_array_append (writer->data, (guint8 *) &value, 4);
+    }
+
+  return offset;
+}
+
+static void
+writer_add_record (GtkRcCacheWriter     *writer,
+                   GtkRcCacheRecordType  type,
+                   guint                 line,
+                   const gchar          *text,
+                   gsize                 length,
+                   guint32               payload)
+{
+  guint32 values[RECORD_SIZE];
+
+  values[0] = type;
+  values[1] = line;
+  values[2] = text ? writer_add_bytes (writer, text, length) : 0;
+  values[3] = text ? length : 0;
+  values[4] = payload;
+
+  g_array_append_vals (writer->records, values, RECORD_SIZE);
+}
+
+guint
+_gtk_rc_cache_writer_add_file (GtkRcCacheWriter *writer,
+                               const gchar      *name,
+                               guint64           mtime,
+                               guint64           size)
+{
+  guint32 values[FILE_SIZE];
+
+  values[0] = writer_add_string (writer, name);
+  values[1] = mtime >> 32;
+  values[2] = mtime & 0xffffffff;
+  values[3] = size >> 32;
+  values[4] = size & 0xffffffff;
+
+  g_array_append_vals (writer->files, values, FILE_SIZE);
+
+  return writer->files->len / FILE_SIZE - 1;
+}
+
+void
+_gtk_rc_cache_writer_begin_file (GtkRcCacheWriter *writer,
+                                 guint             file)
+{
+  writer_add_record (writer, GTK_RC_CACHE_FILE_BEGIN, 0, NULL, 0, file);
+}
+
+void
+_gtk_rc_cache_writer_end_file (GtkRcCacheWriter *writer)
+{
+  writer_add_record (writer, GTK_RC_CACHE_FILE_END, 0, NULL, 0, 0);
+}
+
+void
+_gtk_rc_cache_writer_add_text (GtkRcCacheWriter *writer,
+                               guint             line,
+                               const gchar      *text,
+                               gsize             length,
+                               const gchar      *style_name)
+{
+  writer_add_record (writer, GTK_RC_CACHE_TEXT, line, text, length,
+                     writer_add_string (writer, style_name));
+}
+
+gboolean
+_gtk_rc_cache_writer_add_style (GtkRcCacheWriter *writer,
+                                guint             line,
+                                const gchar      *text,
+                                gsize             length,
+                                GtkRcStyle       *rc_style,
+                                const gchar      *parent)
+{
+  guint32 values[STYLE_SIZE];
+  guint32 *properties;
+  guint n_properties;
+  gchar *font;
+  guint32 payload;
+  guint i, k;
+
+  n_properties = rc_style->rc_properties ? rc_style->rc_properties->len : 0;
+  properties = g_new (guint32, PROPERTY_SIZE * n_properties + 1);
+
+  for (i = 0; i < n_properties; i++)
+    {
+      GtkRcProperty *prop = &g_array_index (rc_style->rc_properties, GtkRcProperty, i);
+      ValueKind kind;
+      gchar *value;
+
+      value = encode_value (&prop->value, &kind);
+      if (!value)
+        {
+          g_free (properties);
+          return FALSE;
+        }
+
+      properties[PROPERTY_SIZE * i] = writer_add_string (writer, g_quark_to_string (prop->type_name));
+      properties[PROPERTY_SIZE * i + 1] = writer_add_string (writer, g_quark_to_string (prop->property_name));
+      properties[PROPERTY_SIZE * i + 2] = kind;
+      properties[PROPERTY_SIZE * i + 3] = writer_add_string (writer, value);
+      g_free (value);
+    }
+
+  font = rc_style->font_desc ? pango_font_description_to_string (rc_style->font_desc) : NULL;
+
+  values[0] = writer_add_string (writer, rc_style->name);
+  values[1] = writer_add_string (writer, parent);
+  values[2] = writer_add_string (writer, font);
+  values[3] = rc_style->xthickness;
+  values[4] = rc_style->ythickness;
+
+  for (i = 0; i < 5; i++)
+    {
+      GdkColor *colors[4];
+
+      colors[0] = &rc_style->fg[i];
+      colors[1] = &rc_style->bg[i];
+      colors[2] = &rc_style->text[i];
+      colors[3] = &rc_style->base[i];
+
+      values[5 + i] = rc_style->color_flags[i];
+
+      for (k = 0; k < 4; k++)
+        {
+          guint base = 10 + 12 * i + 3 * k;
+
+          values[base] = colors[k]->red;
+          values[base + 1] = colors[k]->green;
+          values[base + 2] = colors[k]->blue;
+        }
+    }
+
+  values[STYLE_SIZE - 1] = n_properties;
+
+  /* the property block has to follow the style block directly */
+  payload = writer_add_block (writer, values, STYLE_SIZE);
+  writer_add_block (writer, properties, PROPERTY_SIZE * n_properties);
+
+  writer_add_record (writer, GTK_RC_CACHE_STYLE, line, text, length, payload);
+
+  g_free (properties);
+  g_free (font);
+
+  return TRUE;
+}
+
+void
+_gtk_rc_cache_writer_add_pattern (GtkRcCacheWriter *writer,
+                                  guint             line,
+                                  const gchar      *text,
+                                  gsize             length,
+                                  GtkPathType       path_type,
+                                  const gchar      *pattern,
+                                  gint              priority,
+                                  const gchar      *style_name)
+{
+  guint32 values[PATTERN_SIZE];
+
+  values[0] = path_type;
+  values[1] = (guint32) priority;
+  values[2] = writer_add_string (writer, pattern);
+  values[3] = writer_add_string (writer, style_name);
+
+  writer_add_record (writer, GTK_RC_CACHE_PATTERN, line, text, length,
+                     writer_add_block (writer, values, PATTERN_SIZE));
+}
+
+gboolean
+_gtk_rc_cache_writer_add_setting (GtkRcCacheWriter *writer,
+                                  guint             line,
+                                  const gchar      *text,
+                                  gsize             length,
+                                  const gchar      *name,
+                                  const GValue     *value)
+{
+  guint32 values[SETTING_SIZE];
+  ValueKind kind;
+  gchar *string;
+
+  string = encode_value (value, &kind);
+  if (!string)
+    return FALSE;
+
+  values[0] = writer_add_string (writer, name);
+  values[1] = kind;
+  values[2] = writer_add_string (writer, string);
+  g_free (string);
+
+  writer_add_record (writer, GTK_RC_CACHE_SETTING, line, text, length,
+                     writer_add_block (writer, values, SETTING_SIZE));
+
+  return TRUE;
+}
+
+void
+_gtk_rc_cache_writer_add_pixmap_path (GtkRcCacheWriter *writer,
+                                      guint             line,
+                                      const gchar      *text,
+                                      gsize             length,
+                                      const gchar      *path)
+{
+  writer_add_record (writer, GTK_RC_CACHE_PIXMAP_PATH, line, text, length,
+                     writer_add_string (writer, path));
+}
+
+static void
+append_uint32 (GByteArray *array,
+               guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  g_byte_array_append (array, (guint8 *) &value, 4);
+}
+
+gboolean
+_gtk_rc_cache_writer_write (GtkRcCacheWriter *writer,
+                            const gchar      *filename,
+                            GError          **error)
+{
+  GByteArray *buffer;
+  guint32 files_offset, records_offset, data_offset;
+  guint16 version;
+  gboolean retval;
+  guint i;
+
+  files_offset = HEADER_SIZE;
+  records_offset = files_offset + 4 * writer->files->len;
+  data_offset = records_offset + 4 * writer->records->len;
+
+  buffer = g_byte_array_sized_new (data_offset + writer->data->len);
+
+  g_byte_array_append (buffer, (const guint8 *) "GRCC", 4);
+  version = GUINT16_TO_BE (MAJOR_VERSION);
+  g_byte_array_append (buffer, (guint8 *) &version, 2);
+  version = GUINT16_TO_BE (MINOR_VERSION);
+  g_byte_array_append (buffer, (guint8 *) &version, 2);
+  append_uint32 (buffer, writer->files->len / FILE_SIZE);
+  append_uint32 (buffer, files_offset);
+  append_uint32 (buffer, writer->records->len / RECORD_SIZE);
+  append_uint32 (buffer, records_offset);
+  append_uint32 (buffer, data_offset);
+  append_uint32 (buffer, writer->data->len);
+
+  for (i = 0; i < writer->files->len; i++)
+    append_uint32 (buffer, g_array_index (writer->files, guint32, i));
+  for (i = 0; i < writer->records->len; i++)
+    append_uint32 (buffer, g_array_index (writer->records, guint32, i));
+  g_byte_array_append (buffer, writer->data->data, writer->data->len);
+
+  retval = g_file_set_contents (filename, (gchar *) buffer->data, buffer->len, error);
+
+  g_byte_array_free (buffer, TRUE);
+
+  return retval;
+}
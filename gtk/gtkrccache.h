@@ -0,0 +1,136 @@
+/* GTK - The GIMP Toolkit
+ * gtkrccache.h: Precompiled, mappable representation of RC files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_RC_CACHE_H__
+#define __GTK_RC_CACHE_H__
+
+#include <gtk/gtkrc.h>
+
+G_BEGIN_DECLS
+
+#define GTK_RC_CACHE_SUFFIX ".cache"
+
+typedef struct _GtkRcCache        GtkRcCache;
+typedef struct _GtkRcCacheRecord  GtkRcCacheRecord;
+typedef struct _GtkRcCacheWriter  GtkRcCacheWriter;
+
+typedef enum
+{
+  GTK_RC_CACHE_FILE_BEGIN,	/* an included file starts */
+  GTK_RC_CACHE_FILE_END,	/* an included file ends */
+  GTK_RC_CACHE_TEXT,		/* a statement that has to go through the scanner */
+  GTK_RC_CACHE_STYLE,		/* a style block without runtime dependencies */
+  GTK_RC_CACHE_PATTERN,		/* widget, widget_class or class pattern */
+  GTK_RC_CACHE_SETTING,		/* a GtkSettings assignment */
+  GTK_RC_CACHE_PIXMAP_PATH,	/* a pixmap_path statement */
+  GTK_RC_CACHE_LAST
+} GtkRcCacheRecordType;
+
+/* Every record carries the source text of its statement, so the
+ * loader can always fall back to the scanner when the precompiled
+ * form can't be used in the current context.
+ */
+struct _GtkRcCacheRecord
+{
+  GtkRcCacheRecordType type;
+  guint                line;
+  const gchar         *text;
+  gsize                text_length;
+
+  guint                file;        /* FILE_BEGIN */
+  const gchar         *name;        /* style, setting or pattern style name */
+  const gchar         *parent;      /* STYLE, or NULL */
+  const gchar         *pattern;     /* PATTERN */
+  GtkPathType          path_type;   /* PATTERN */
+  gint                 priority;    /* PATTERN, < 0 for the default */
+  const gchar         *value;       /* SETTING, PIXMAP_PATH */
+
+  /*< private >*/
+  guint32              payload;
+};
+
+GtkRcCache  *_gtk_rc_cache_new            (const gchar       *filename);
+void         _gtk_rc_cache_free           (GtkRcCache        *cache);
+guint        _gtk_rc_cache_get_n_files    (GtkRcCache        *cache);
+const gchar *_gtk_rc_cache_get_file       (GtkRcCache        *cache,
+                                           guint              index,
+                                           guint64           *mtime,
+                                           guint64           *size);
+guint        _gtk_rc_cache_get_n_records  (GtkRcCache        *cache);
+void         _gtk_rc_cache_get_record     (GtkRcCache        *cache,
+                                           guint              index,
+                                           GtkRcCacheRecord  *record);
+void         _gtk_rc_cache_get_style      (GtkRcCache        *cache,
+                                           GtkRcCacheRecord  *record,
+                                           GtkRcStyle        *rc_style);
+gboolean     _gtk_rc_cache_get_value      (GtkRcCache        *cache,
+                                           GtkRcCacheRecord  *record,
+                                           GValue            *value);
+
+GtkRcCacheWriter *_gtk_rc_cache_writer_new           (void);
+void              _gtk_rc_cache_writer_free          (GtkRcCacheWriter *writer);
+guint             _gtk_rc_cache_writer_add_file      (GtkRcCacheWriter *writer,
+                                                      const gchar      *name,
+                                                      guint64           mtime,
+                                                      guint64           size);
+void              _gtk_rc_cache_writer_begin_file    (GtkRcCacheWriter *writer,
+                                                      guint             file);
+void              _gtk_rc_cache_writer_end_file      (GtkRcCacheWriter *writer);
+void              _gtk_rc_cache_writer_add_text      (GtkRcCacheWriter *writer,
+                                                      guint             line,
+                                                      const gchar      *text,
+                                                      gsize             length,
+                                                      const gchar      *style_name);
+gboolean          _gtk_rc_cache_writer_add_style     (GtkRcCacheWriter *writer,
+                                                      guint             line,
+                                                      const gchar      *text,
+                                                      gsize             length,
+                                                      GtkRcStyle       *rc_style,
+                                                      const gchar      *parent);
+void              _gtk_rc_cache_writer_add_pattern   (GtkRcCacheWriter *writer,
+                                                      guint             line,
+                                                      const gchar      *text,
+                                                      gsize             length,
+                                                      GtkPathType       path_type,
+                                                      const gchar      *pattern,
+                                                      gint              priority,
+                                                      const gchar      *style_name);
+gboolean          _gtk_rc_cache_writer_add_setting   (GtkRcCacheWriter *writer,
+                                                      guint             line,
+                                                      const gchar      *text,
+                                                      gsize             length,
+                                                      const gchar      *name,
+                                                      const GValue     *value);
+void              _gtk_rc_cache_writer_add_pixmap_path (GtkRcCacheWriter *writer,
+                                                        guint             line,
+                                                        const gchar      *text,
+                                                        gsize             length,
+                                                        const gchar      *path);
+gboolean          _gtk_rc_cache_writer_write         (GtkRcCacheWriter *writer,
+                                                      const gchar      *filename,
+                                                      GError          **error);
+
+/* in gtkrc.c, for gtk-update-rc-cache */
+gboolean          _gtk_rc_compile_file               (const gchar      *filename,
+                                                      const gchar      *cache_file,
+                                                      GError          **error);
+
+G_END_DECLS
+
+#endif /* __GTK_RC_CACHE_H__ */
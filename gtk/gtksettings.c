@@ -26,6 +26,7 @@
 #include "gtksettings.h"
 #include "gtkrc.h"
 #include "gtkintl.h"
+#include "gtklayoutcache.h"
 #include "gtkwidget.h"
 #include "gtkprivate.h"
 #include "gtkalias.h"
@@ -2110,6 +2111,9 @@ settings_update_fontconfig (GtkSettings *settings)
 	  pango_fc_font_map_cache_clear (PANGO_FC_FONT_MAP (fontmap));
 	  if (FcInitReinitialize ())
 	    update_needed = TRUE;
+
+	  /* Cached layouts may use fonts that are gone now */
+	  _gtk_layout_cache_flush ();
 	}
 
       last_update_timestamp = timestamp;
@@ -22,6 +22,7 @@
 #include <string.h>
 #include "gtkcontainer.h"
 #include "gtkintl.h"
+#include "gtkmenushell.h"
 #include "gtkprivate.h"
 #include "gtksizegroup.h"
 #include "gtkbuildable.h"
@@ -610,16 +611,58 @@ get_base_dimension (GtkWidget        *widget,
     }
 }
 
+static void do_size_request (GtkWidget *widget);
+
+static void
+request_dirty_child (GtkWidget *child,
+		     gpointer   data)
+{
+  gboolean *changed = data;
+  GtkRequisition old_requisition;
+
+  if (!GTK_WIDGET_REQUEST_NEEDED (child) &&
+      !GTK_WIDGET_CHILD_REQUEST_NEEDED (child))
+    return;
+
+  old_requisition = child->requisition;
+  do_size_request (child);
+
+  if (child->requisition.width != old_requisition.width ||
+      child->requisition.height != old_requisition.height)
+    *changed = TRUE;
+}
+
 static void
 do_size_request (GtkWidget *widget)
 {
+  if (GTK_WIDGET_CHILD_REQUEST_NEEDED (widget))
+    {
+      GTK_PRIVATE_UNSET_FLAG (widget, GTK_CHILD_REQUEST_NEEDED);
+
+      /* Only descendants were queued for resize; request them
+       * first, and keep our own request if none of the children
+       * requests changed. Menu shells also size the toggle area of
+       * their items from the item images, so they can't take this
+       * shortcut.
+       */
+      if (!GTK_WIDGET_REQUEST_NEEDED (widget) && !GTK_IS_MENU_SHELL (widget))
+	{
+	  gboolean changed = FALSE;
+
+	  gtk_container_forall (GTK_CONTAINER (widget),
+				request_dirty_child, &changed);
+	  if (!changed)
+	    return;
+	}
+
+      GTK_PRIVATE_SET_FLAG (widget, GTK_REQUEST_NEEDED);
+    }
+
   if (GTK_WIDGET_REQUEST_NEEDED (widget))
     {
       gtk_widget_ensure_style (widget);      
       GTK_PRIVATE_UNSET_FLAG (widget, GTK_REQUEST_NEEDED);
-      g_signal_emit_by_name (widget,
-			     "size-request",
-			     &widget->requisition);
+      _gtk_widget_emit_size_request (widget, &widget->requisition);
     }
 }
 
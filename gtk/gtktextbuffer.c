@@ -56,6 +56,10 @@ struct _GtkTextBufferPrivate
   GtkTargetList  *paste_target_list;
   GtkTargetEntry *paste_target_entries;
   gint            n_paste_target_entries;
+
+  /* GtkTextBufferChange, sorted by offset, not overlapping */
+  GArray         *pending_changes;
+  guint           flush_changes_idle;
 };
 
 
@@ -83,6 +87,7 @@ enum {
   REMOVE_TAG,
   BEGIN_USER_ACTION,
   END_USER_ACTION,
+  BATCH_CHANGED,
   LAST_SIGNAL
 };
 
@@ -138,6 +143,14 @@ static GtkTextBuffer *create_clipboard_contents_buffer (GtkTextBuffer *buffer);
 
 static void gtk_text_buffer_free_target_lists     (GtkTextBuffer *buffer);
 
+static void record_insertion (GtkTextBuffer     *buffer,
+                              const GtkTextIter *iter,
+                              const gchar       *text,
+                              gint               len);
+static void record_deletion  (GtkTextBuffer     *buffer,
+                              const GtkTextIter *start,
+                              const GtkTextIter *end);
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static void gtk_text_buffer_set_property (GObject         *object,
@@ -581,6 +594,43 @@ gtk_text_buffer_class_init (GtkTextBufferClass *klass)
                   G_TYPE_NONE,
                   0);
 
+  /**
+   * GtkTextBuffer::batch-changed:
+   * @textbuffer: the object which received the signal
+   * @n_changes: the number of changed ranges
+   * @changes: an array of #GtkTextBufferChange
+   *
+   * The ::batch-changed signal is emitted after the text of the
+   * buffer changed, with the changed ranges merged into as few
+   * as possible. It is emitted once at the end of each outermost
+   * user action, and for changes made outside of user actions,
+   * once from an idle handler before the next redraw, or when
+   * gtk_text_buffer_flush_changes() is called.
+   *
+   * Consumers that rescan the text after changes, like spell
+   * checkers or syntax highlighters, can use this signal instead
+   * of #GtkTextBuffer::insert-text and #GtkTextBuffer::delete-range
+   * to do work proportional to the size of the change. Only changes
+   * to the text are reported, not changes to tags or marks, and
+   * only changes made while a handler was connected.
+   *
+   * The ranges are sorted and do not overlap. Their offsets refer
+   * to the text at the time of the emission.
+   *
+   * Since: 2.16
+   */
+  signals[BATCH_CHANGED] =
+    g_signal_new (I_("batch-changed"),
+                  G_OBJECT_CLASS_TYPE (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  _gtk_marshal_VOID__UINT_POINTER,
+                  G_TYPE_NONE,
+                  2,
+                  G_TYPE_UINT,
+                  G_TYPE_POINTER);
+
   g_type_class_add_private (object_class, sizeof (GtkTextBufferPrivate));
 }
 
@@ -592,6 +642,7 @@ gtk_text_buffer_init (GtkTextBuffer *buffer)
 
   /* allow copying of arbiatray stuff in the internal rich text format */
   gtk_text_buffer_register_serialize_tagset (buffer, NULL);
+  gtk_text_buffer_register_serialize_compact_tagset (buffer, NULL);
 }
 
 static void
@@ -733,8 +784,10 @@ static void
 gtk_text_buffer_finalize (GObject *object)
 {
   GtkTextBuffer *buffer;
+  GtkTextBufferPrivate *priv;
 
   buffer = GTK_TEXT_BUFFER (object);
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
 
   remove_all_selection_clipboards (buffer);
 
@@ -758,6 +811,12 @@ gtk_text_buffer_finalize (GObject *object)
 
   gtk_text_buffer_free_target_lists (buffer);
 
+  if (priv->flush_changes_idle)
+    g_source_remove (priv->flush_changes_idle);
+
+  if (priv->pending_changes)
+    g_array_free (priv->pending_changes, TRUE);
+
   G_OBJECT_CLASS (gtk_text_buffer_parent_class)->finalize (object);
 }
 
@@ -842,7 +901,9 @@ gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
 {
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (iter != NULL);
-  
+
+  record_insertion (buffer, iter, text, len);
+
   _gtk_text_btree_insert (iter, text, len);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -1558,6 +1619,8 @@ gtk_text_buffer_real_delete_range (GtkTextBuffer *buffer,
   g_return_if_fail (start != NULL);
   g_return_if_fail (end != NULL);
 
+  record_deletion (buffer, start, end);
+
   _gtk_text_btree_delete (start, end);
 
   /* may have deleted the selection... */
@@ -1848,6 +1911,8 @@ gtk_text_buffer_real_insert_pixbuf (GtkTextBuffer *buffer,
                                     GtkTextIter   *iter,
                                     GdkPixbuf     *pixbuf)
 { 
+  record_insertion (buffer, iter, NULL, 0);
+
   _gtk_text_btree_insert_pixbuf (iter, pixbuf);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -1892,6 +1957,8 @@ gtk_text_buffer_real_insert_anchor (GtkTextBuffer      *buffer,
                                     GtkTextIter        *iter,
                                     GtkTextChildAnchor *anchor)
 {
+  record_insertion (buffer, iter, NULL, 0);
+
   _gtk_text_btree_insert_child_anchor (iter, anchor);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -4068,7 +4135,228 @@ gtk_text_buffer_end_user_action (GtkTextBuffer *buffer)
     {
       /* Ended the outermost-nested user action end, so emit the signal */
       g_signal_emit (buffer, signals[END_USER_ACTION], 0);
+
+      gtk_text_buffer_flush_changes (buffer);
+    }
+}
+
+/*
+ * Change batching
+ */
+
+static gboolean
+flush_changes_idle (gpointer data)
+{
+  GtkTextBuffer *buffer = data;
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  priv->flush_changes_idle = 0;
+
+  /* The end of the user action will flush */
+  if (buffer->user_action_count == 0)
+    gtk_text_buffer_flush_changes (buffer);
+
+  return FALSE;
+}
+
+static GArray *
+get_pending_changes (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  /* Once changes are pending, all following ones must be
+   * recorded too, to keep the offsets consistent.
+   */
+  if (!priv->pending_changes)
+    {
+      if (!g_signal_has_handler_pending (buffer, signals[BATCH_CHANGED], 0, TRUE))
+        return NULL;
+
+      priv->pending_changes = g_array_new (FALSE, FALSE, sizeof (GtkTextBufferChange));
     }
+
+  if (buffer->user_action_count == 0 && !priv->flush_changes_idle)
+    priv->flush_changes_idle =
+      gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE + 15, /* between resize and redraw */
+                                 flush_changes_idle, buffer, NULL);
+
+  return priv->pending_changes;
+}
+
+/* Records the insertion of @len bytes of @text at @iter, or of
+ * a single pixbuf or child anchor if @text is %NULL.
+ */
+static void
+record_insertion (GtkTextBuffer     *buffer,
+                  const GtkTextIter *iter,
+                  const gchar       *text,
+                  gint               len)
+{
+  GArray *changes;
+  GtkTextBufferChange *change;
+  gint offset, n_chars;
+  gboolean extended = FALSE;
+  guint i;
+
+  changes = get_pending_changes (buffer);
+  if (!changes)
+    return;
+
+  offset = gtk_text_iter_get_offset (iter);
+  n_chars = text ? g_utf8_strlen (text, len) : 1;
+
+  if (n_chars == 0)
+    return;
+
+  for (i = 0; i < changes->len; i++)
+    {
+      change = &g_array_index (changes, GtkTextBufferChange, i);
+
+      if (offset < change->offset)
+        break;
+
+      /* Inserting into or right next to a changed range extends it */
+      if (offset <= change->offset + change->n_inserted)
+        {
+          change->n_inserted += n_chars;
+          extended = TRUE;
+          i++;
+          break;
+        }
+    }
+
+  if (!extended)
+    {
+      GtkTextBufferChange new_change;
+
+      new_change.offset = offset;
+      new_change.n_inserted = n_chars;
+      new_change.n_deleted = 0;
+
+      g_array_insert_val (changes, i, new_change);
+      i++;
+    }
+
+  for (; i < changes->len; i++)
+    g_array_index (changes, GtkTextBufferChange, i).offset += n_chars;
+}
+
+static void
+record_deletion (GtkTextBuffer     *buffer,
+                 const GtkTextIter *start_iter,
+                 const GtkTextIter *end_iter)
+{
+  GArray *changes;
+  GtkTextBufferChange *change;
+  GtkTextBufferChange merged;
+  gint start, end;
+  gint n_deleted, n_inserted_before;
+  guint first, last;
+
+  changes = get_pending_changes (buffer);
+  if (!changes)
+    return;
+
+  start = gtk_text_iter_get_offset (start_iter);
+  end = gtk_text_iter_get_offset (end_iter);
+
+  if (start > end)
+    {
+      gint tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  if (start == end)
+    return;
+
+  n_deleted = end - start;
+
+  /* Find the changed ranges touching the deleted one */
+  for (first = 0; first < changes->len; first++)
+    {
+      change = &g_array_index (changes, GtkTextBufferChange, first);
+
+      if (change->offset + change->n_inserted >= start)
+        break;
+    }
+
+  merged.offset = start;
+  merged.n_deleted = 0;
+  n_inserted_before = 0;
+
+  for (last = first; last < changes->len; last++)
+    {
+      change = &g_array_index (changes, GtkTextBufferChange, last);
+
+      if (change->offset > end)
+        break;
+
+      merged.offset = MIN (merged.offset, change->offset);
+      end = MAX (end, change->offset + change->n_inserted);
+      n_inserted_before += change->n_inserted;
+      merged.n_deleted += change->n_deleted;
+    }
+
+  /* Everything in the merged range that wasn't inserted before
+   * counts as deleted, everything that remains as inserted.
+   */
+  merged.n_deleted += end - merged.offset - n_inserted_before;
+  merged.n_inserted = end - merged.offset - n_deleted;
+
+  if (last > first)
+    g_array_remove_range (changes, first, last - first);
+
+  if (merged.n_inserted > 0 || merged.n_deleted > 0)
+    {
+      g_array_insert_val (changes, first, merged);
+      first++;
+    }
+
+  for (; first < changes->len; first++)
+    g_array_index (changes, GtkTextBufferChange, first).offset -= n_deleted;
+}
+
+/**
+ * gtk_text_buffer_flush_changes:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Emits #GtkTextBuffer::batch-changed for the changes collected
+ * so far, if there are any, instead of waiting for the end of the
+ * current user action or for the idle handler.
+ *
+ * Since: 2.16
+ **/
+void
+gtk_text_buffer_flush_changes (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv;
+  GArray *changes;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (priv->flush_changes_idle)
+    {
+      g_source_remove (priv->flush_changes_idle);
+      priv->flush_changes_idle = 0;
+    }
+
+  changes = priv->pending_changes;
+  if (!changes)
+    return;
+
+  /* Handlers may change the buffer again, collect those
+   * changes for the next emission.
+   */
+  priv->pending_changes = NULL;
+
+  if (changes->len > 0)
+    g_signal_emit (buffer, signals[BATCH_CHANGED], 0,
+                   changes->len, changes->data);
+
+  g_array_free (changes, TRUE);
 }
 
 static void
@@ -70,6 +70,7 @@ typedef struct _GtkTextLogAttrCache GtkTextLogAttrCache;
 #define GTK_TEXT_BUFFER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_TEXT_BUFFER, GtkTextBufferClass))
 
 typedef struct _GtkTextBufferClass GtkTextBufferClass;
+typedef struct _GtkTextBufferChange GtkTextBufferChange;
 
 struct _GtkTextBuffer
 {
@@ -152,6 +153,26 @@ struct _GtkTextBufferClass
   void (*_gtk_reserved6) (void);
 };
 
+/**
+ * GtkTextBufferChange:
+ * @offset: character offset of the changed range in the current text
+ * @n_inserted: number of characters in the changed range
+ * @n_deleted: number of characters the changed range replaced
+ *
+ * Describes a range of a #GtkTextBuffer that changed since the last
+ * emission of #GtkTextBuffer::batch-changed. The characters from
+ * @offset to @offset + @n_inserted replace @n_deleted characters of
+ * the previous text.
+ *
+ * Since: 2.16
+ */
+struct _GtkTextBufferChange
+{
+  gint offset;
+  gint n_inserted;
+  gint n_deleted;
+};
+
 GType        gtk_text_buffer_get_type       (void) G_GNUC_CONST;
 
 
@@ -386,6 +407,7 @@ gboolean        gtk_text_buffer_delete_selection        (GtkTextBuffer *buffer,
 /* Called to specify atomic user actions, used to implement undo */
 void            gtk_text_buffer_begin_user_action       (GtkTextBuffer *buffer);
 void            gtk_text_buffer_end_user_action         (GtkTextBuffer *buffer);
+void            gtk_text_buffer_flush_changes           (GtkTextBuffer *buffer);
 
 GtkTargetList * gtk_text_buffer_get_copy_target_list    (GtkTextBuffer *buffer);
 GtkTargetList * gtk_text_buffer_get_paste_target_list   (GtkTextBuffer *buffer);
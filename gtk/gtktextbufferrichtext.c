@@ -50,6 +50,10 @@ static GList   * unregister_format (GList             *formats,
                                     GdkAtom            atom);
 static GdkAtom * get_formats       (GList             *formats,
                                     gint              *n_formats);
+static GtkRichTextFormat *
+                 find_format       (GtkTextBuffer     *buffer,
+                                    GQuark             quark,
+                                    GdkAtom            atom);
 static void      free_format       (GtkRichTextFormat *format);
 static void      free_format_list  (GList             *formats);
 static GQuark    serialize_quark   (void);
@@ -238,6 +242,96 @@ gtk_text_buffer_register_deserialize_tagset (GtkTextBuffer *buffer,
   return format;
 }
 
+/**
+ * gtk_text_buffer_register_serialize_compact_tagset:
+ * @buffer: a #GtkTextBuffer
+ * @tagset_name: an optional tagset name, on %NULL
+ *
+ * This function registers the compact variant of GTK+'s internal rich
+ * text serialization format with the passed @buffer. It carries the
+ * same information as the format registered by
+ * gtk_text_buffer_register_serialize_tagset(), but uses a binary
+ * encoding that is smaller and faster to produce and parse, and that
+ * can be written and read in a single pass.
+ *
+ * The mime type used for registering is
+ * "application/x-gtk-text-buffer-rich-text-compact", or
+ * "application/x-gtk-text-buffer-rich-text-compact;format=@tagset_name"
+ * if a @tagset_name was passed.
+ *
+ * Return value: the #GdkAtom that corresponds to the newly registered
+ *               format's mime-type.
+ *
+ * Since: 2.16
+ **/
+GdkAtom
+gtk_text_buffer_register_serialize_compact_tagset (GtkTextBuffer *buffer,
+                                                   const gchar   *tagset_name)
+{
+  gchar   *mime_type = "application/x-gtk-text-buffer-rich-text-compact";
+  GdkAtom  format;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), GDK_NONE);
+  g_return_val_if_fail (tagset_name == NULL || *tagset_name != '\0', GDK_NONE);
+
+  if (tagset_name)
+    mime_type =
+      g_strdup_printf ("application/x-gtk-text-buffer-rich-text-compact;format=%s",
+                       tagset_name);
+
+  format = gtk_text_buffer_register_serialize_format (buffer, mime_type,
+                                                      _gtk_text_buffer_serialize_compact_rich_text,
+                                                      NULL, NULL);
+
+  if (tagset_name)
+    g_free (mime_type);
+
+  return format;
+}
+
+/**
+ * gtk_text_buffer_register_deserialize_compact_tagset:
+ * @buffer: a #GtkTextBuffer
+ * @tagset_name: an optional tagset name, on %NULL
+ *
+ * This function registers the compact variant of GTK+'s internal rich
+ * text serialization format with the passed @buffer. See
+ * gtk_text_buffer_register_serialize_compact_tagset() for details.
+ *
+ * When pasting, formats are tried in the order they were registered,
+ * so register this format before the one from
+ * gtk_text_buffer_register_deserialize_tagset() to prefer it.
+ *
+ * Return value: the #GdkAtom that corresponds to the newly registered
+ *               format's mime-type.
+ *
+ * Since: 2.16
+ **/
+GdkAtom
+gtk_text_buffer_register_deserialize_compact_tagset (GtkTextBuffer *buffer,
+                                                     const gchar   *tagset_name)
+{
+  gchar   *mime_type = "application/x-gtk-text-buffer-rich-text-compact";
+  GdkAtom  format;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), GDK_NONE);
+  g_return_val_if_fail (tagset_name == NULL || *tagset_name != '\0', GDK_NONE);
+
+  if (tagset_name)
+    mime_type =
+      g_strdup_printf ("application/x-gtk-text-buffer-rich-text-compact;format=%s",
+                       tagset_name);
+
+  format = gtk_text_buffer_register_deserialize_format (buffer, mime_type,
+                                                        _gtk_text_buffer_deserialize_compact_rich_text,
+                                                        NULL, NULL);
+
+  if (tagset_name)
+    g_free (mime_type);
+
+  return format;
+}
+
 /**
  * gtk_text_buffer_unregister_serialize_format:
  * @buffer: a #GtkTextBuffer
@@ -484,8 +578,7 @@ gtk_text_buffer_serialize (GtkTextBuffer     *register_buffer,
                            const GtkTextIter *end,
                            gsize             *length)
 {
-  GList *formats;
-  GList *list;
+  GtkRichTextFormat *fmt;
 
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), NULL);
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), NULL);
@@ -496,23 +589,309 @@ gtk_text_buffer_serialize (GtkTextBuffer     *register_buffer,
 
   *length = 0;
 
-  formats = g_object_get_qdata (G_OBJECT (register_buffer),
-                                serialize_quark ());
+  fmt = find_format (register_buffer, serialize_quark (), format);
 
-  for (list = formats; list; list = g_list_next (list))
+  if (fmt)
     {
-      GtkRichTextFormat *fmt = list->data;
+      GtkTextBufferSerializeFunc function = fmt->function;
 
-      if (fmt->atom == format)
+      return function (register_buffer, content_buffer,
+                       start, end, length, fmt->user_data);
+    }
+
+  return NULL;
+}
+
+/**
+ * gtk_text_buffer_serialize_to_stream:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to serialize
+ * @format: the rich text format to use for serializing
+ * @start: start of block of text to serialize
+ * @end: end of block of test to serialize
+ * @stream: the #GOutputStream to write the serialized data to
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @error: return location for a #GError
+ *
+ * This function serializes the portion of text between @start
+ * and @end in the rich text format represented by @format, and
+ * writes the result to @stream.
+ *
+ * For GTK+'s internal rich text formats, the data is written
+ * while it is produced, so serializing large amounts of text
+ * doesn't need memory proportional to the size of the text.
+ * For other formats, the data is produced by the registered
+ * #GtkTextBufferSerializeFunc and then written to @stream.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise.
+ *
+ * Since: 2.16
+ **/
+gboolean
+gtk_text_buffer_serialize_to_stream (GtkTextBuffer     *register_buffer,
+                                     GtkTextBuffer     *content_buffer,
+                                     GdkAtom            format,
+                                     const GtkTextIter *start,
+                                     const GtkTextIter *end,
+                                     GOutputStream     *stream,
+                                     GCancellable      *cancellable,
+                                     GError           **error)
+{
+  GtkRichTextFormat *fmt;
+  guint8 *data;
+  gsize length;
+  gboolean retval;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
+  g_return_val_if_fail (format != GDK_NONE, FALSE);
+  g_return_val_if_fail (start != NULL, FALSE);
+  g_return_val_if_fail (end != NULL, FALSE);
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fmt = find_format (register_buffer, serialize_quark (), format);
+
+  if (!fmt)
+    {
+      g_set_error (error, 0, 0,
+                   _("No serialize function found for format %s"),
+                   gdk_atom_name (format));
+      return FALSE;
+    }
+
+  if (fmt->function == _gtk_text_buffer_serialize_rich_text)
+    return _gtk_text_buffer_serialize_rich_text_to_stream (register_buffer,
+                                                           content_buffer,
+                                                           start, end,
+                                                           stream,
+                                                           cancellable,
+                                                           error);
+
+  if (fmt->function == _gtk_text_buffer_serialize_compact_rich_text)
+    return _gtk_text_buffer_serialize_compact_rich_text_to_stream (register_buffer,
+                                                                   content_buffer,
+                                                                   start, end,
+                                                                   stream,
+                                                                   cancellable,
+                                                                   error);
+
+  data = gtk_text_buffer_serialize (register_buffer, content_buffer,
+                                    format, start, end, &length);
+
+  retval = g_output_stream_write_all (stream, data, length, NULL,
+                                      cancellable, error);
+  g_free (data);
+
+  return retval;
+}
+
+static gboolean
+deserialize_from_stream (GtkTextBuffer      *register_buffer,
+                         GtkTextBuffer      *content_buffer,
+                         GtkRichTextFormat  *fmt,
+                         GtkTextIter        *iter,
+                         GInputStream       *stream,
+                         GCancellable       *cancellable,
+                         GError            **error)
+{
+  GtkTextBufferDeserializeFunc function = fmt->function;
+  GByteArray *data;
+  guint8 buf[8192];
+  gssize n_read;
+  gboolean retval;
+
+  if (fmt->function == _gtk_text_buffer_deserialize_rich_text)
+    return _gtk_text_buffer_deserialize_rich_text_from_stream (register_buffer,
+                                                               content_buffer,
+                                                               iter, stream,
+                                                               fmt->can_create_tags,
+                                                               cancellable,
+                                                               error);
+
+  /* Other formats need all of the data at once */
+  data = g_byte_array_new ();
+
+  while ((n_read = g_input_stream_read (stream, buf, sizeof (buf),
+                                        cancellable, error)) > 0)
+    g_byte_array_append (data, buf, n_read);
+
+  if (n_read < 0)
+    retval = FALSE;
+  else if (data->len == 0)
+    {
+      g_set_error (error, 0, 0,
+                   _("No data to deserialize in format %s"),
+                   gdk_atom_name (fmt->atom));
+      retval = FALSE;
+    }
+  else
+    retval = function (register_buffer, content_buffer,
+                       iter, data->data, data->len,
+                       fmt->can_create_tags,
+                       fmt->user_data,
+                       error);
+
+  g_byte_array_free (data, TRUE);
+
+  return retval;
+}
+
+static gboolean
+deserialize_with_format (GtkTextBuffer      *register_buffer,
+                         GtkTextBuffer      *content_buffer,
+                         GtkRichTextFormat  *fmt,
+                         GtkTextIter        *iter,
+                         const guint8       *data,
+                         gsize               length,
+                         GInputStream       *stream,
+                         GCancellable       *cancellable,
+                         GError            **error)
+{
+  GtkTextBufferDeserializeFunc function = fmt->function;
+  gboolean                     success;
+  GSList                      *split_tags;
+  GSList                      *list;
+  GtkTextMark                 *left_end        = NULL;
+  GtkTextMark                 *right_start     = NULL;
+  GSList                      *left_start_list = NULL;
+  GSList                      *right_end_list  = NULL;
+
+  /*  We don't want the tags that are effective at the insertion
+   *  point to affect the pasted text, therefore we remove and
+   *  remember them, so they can be re-applied left and right of
+   *  the inserted text after pasting
+   */
+  split_tags = gtk_text_iter_get_tags (iter);
+
+  list = split_tags;
+  while (list)
+    {
+      GtkTextTag *tag = list->data;
+
+      list = g_slist_next (list);
+
+      /*  If a tag begins at the insertion point, ignore it
+       *  because it doesn't affect the pasted text
+       */
+      if (gtk_text_iter_begins_tag (iter, tag))
+        split_tags = g_slist_remove (split_tags, tag);
+    }
+
+  if (split_tags)
+    {
+      /*  Need to remember text marks, because text iters
+       *  don't survive pasting
+       */
+      left_end = gtk_text_buffer_create_mark (content_buffer,
+                                              NULL, iter, TRUE);
+      right_start = gtk_text_buffer_create_mark (content_buffer,
+                                                 NULL, iter, FALSE);
+
+      for (list = split_tags; list; list = g_slist_next (list))
         {
-          GtkTextBufferSerializeFunc function = fmt->function;
+          GtkTextTag  *tag             = list->data;
+          GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
+          GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
+          GtkTextMark *left_start      = NULL;
+          GtkTextMark *right_end       = NULL;
+
+          gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
+          left_start = gtk_text_buffer_create_mark (content_buffer,
+                                                    NULL,
+                                                    backward_toggle,
+                                                    FALSE);
+
+          gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
+          right_end = gtk_text_buffer_create_mark (content_buffer,
+                                                   NULL,
+                                                   forward_toggle,
+                                                   TRUE);
+
+          left_start_list = g_slist_prepend (left_start_list, left_start);
+          right_end_list = g_slist_prepend (right_end_list, right_end);
+
+          gtk_text_buffer_remove_tag (content_buffer, tag,
+                                      backward_toggle,
+                                      forward_toggle);
+
+          gtk_text_iter_free (forward_toggle);
+          gtk_text_iter_free (backward_toggle);
+        }
+
+      left_start_list = g_slist_reverse (left_start_list);
+      right_end_list = g_slist_reverse (right_end_list);
+    }
 
-          return function (register_buffer, content_buffer,
-                           start, end, length, fmt->user_data);
+  if (stream)
+    success = deserialize_from_stream (register_buffer, content_buffer,
+                                       fmt, iter, stream, cancellable,
+                                       error);
+  else
+    success = function (register_buffer, content_buffer,
+                        iter, data, length,
+                        fmt->can_create_tags,
+                        fmt->user_data,
+                        error);
+
+  if (!success && error != NULL && *error == NULL)
+    g_set_error (error, 0, 0,
+                 _("Unknown error when trying to deserialize %s"),
+                 gdk_atom_name (fmt->atom));
+
+  if (split_tags)
+    {
+      GSList      *left_list;
+      GSList      *right_list;
+      GtkTextIter  left_e;
+      GtkTextIter  right_s;
+
+      /*  Turn the remembered marks back into iters so they
+       *  can by used to re-apply the remembered tags
+       */
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &left_e, left_end);
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &right_s, right_start);
+
+      for (list = split_tags,
+             left_list = left_start_list,
+             right_list = right_end_list;
+           list && left_list && right_list;
+           list = g_slist_next (list),
+             left_list = g_slist_next (left_list),
+             right_list = g_slist_next (right_list))
+        {
+          GtkTextTag  *tag        = list->data;
+          GtkTextMark *left_start = left_list->data;
+          GtkTextMark *right_end  = right_list->data;
+          GtkTextIter  left_s;
+          GtkTextIter  right_e;
+
+          gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                            &left_s, left_start);
+          gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                            &right_e, right_end);
+
+          gtk_text_buffer_apply_tag (content_buffer, tag,
+                                     &left_s, &left_e);
+          gtk_text_buffer_apply_tag (content_buffer, tag,
+                                     &right_s, &right_e);
+
+          gtk_text_buffer_delete_mark (content_buffer, left_start);
+          gtk_text_buffer_delete_mark (content_buffer, right_end);
         }
+
+      gtk_text_buffer_delete_mark (content_buffer, left_end);
+      gtk_text_buffer_delete_mark (content_buffer, right_start);
+
+      g_slist_free (split_tags);
+      g_slist_free (left_start_list);
+      g_slist_free (right_end_list);
     }
 
-  return NULL;
+
+  return success;
 }
 
 /**
@@ -545,8 +924,7 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
                              gsize           length,
                              GError        **error)
 {
-  GList    *formats;
-  GList    *list;
+  GtkRichTextFormat *fmt;
 
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
@@ -556,155 +934,68 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
   g_return_val_if_fail (length > 0, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  formats = g_object_get_qdata (G_OBJECT (register_buffer),
-                                deserialize_quark ());
+  fmt = find_format (register_buffer, deserialize_quark (), format);
 
-  for (list = formats; list; list = g_list_next (list))
-    {
-      GtkRichTextFormat *fmt = list->data;
+  if (fmt)
+    return deserialize_with_format (register_buffer, content_buffer, fmt,
+                                    iter, data, length, NULL, NULL, error);
 
-      if (fmt->atom == format)
-        {
-          GtkTextBufferDeserializeFunc function = fmt->function;
-          gboolean                     success;
-          GSList                      *split_tags;
-          GSList                      *list;
-          GtkTextMark                 *left_end        = NULL;
-          GtkTextMark                 *right_start     = NULL;
-          GSList                      *left_start_list = NULL;
-          GSList                      *right_end_list  = NULL;
-
-          /*  We don't want the tags that are effective at the insertion
-           *  point to affect the pasted text, therefore we remove and
-           *  remember them, so they can be re-applied left and right of
-           *  the inserted text after pasting
-           */
-          split_tags = gtk_text_iter_get_tags (iter);
-
-          list = split_tags;
-          while (list)
-            {
-              GtkTextTag *tag = list->data;
-
-              list = g_slist_next (list);
-
-              /*  If a tag begins at the insertion point, ignore it
-               *  because it doesn't affect the pasted text
-               */
-              if (gtk_text_iter_begins_tag (iter, tag))
-                split_tags = g_slist_remove (split_tags, tag);
-            }
-
-          if (split_tags)
-            {
-              /*  Need to remember text marks, because text iters
-               *  don't survive pasting
-               */
-              left_end = gtk_text_buffer_create_mark (content_buffer,
-                                                      NULL, iter, TRUE);
-              right_start = gtk_text_buffer_create_mark (content_buffer,
-                                                         NULL, iter, FALSE);
-
-              for (list = split_tags; list; list = g_slist_next (list))
-                {
-                  GtkTextTag  *tag             = list->data;
-                  GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
-                  GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
-                  GtkTextMark *left_start      = NULL;
-                  GtkTextMark *right_end       = NULL;
-
-                  gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
-                  left_start = gtk_text_buffer_create_mark (content_buffer,
-                                                            NULL,
-                                                            backward_toggle,
-                                                            FALSE);
-
-                  gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
-                  right_end = gtk_text_buffer_create_mark (content_buffer,
-                                                           NULL,
-                                                           forward_toggle,
-                                                           TRUE);
-
-                  left_start_list = g_slist_prepend (left_start_list, left_start);
-                  right_end_list = g_slist_prepend (right_end_list, right_end);
-
-                  gtk_text_buffer_remove_tag (content_buffer, tag,
-                                              backward_toggle,
-                                              forward_toggle);
-
-                  gtk_text_iter_free (forward_toggle);
-                  gtk_text_iter_free (backward_toggle);
-                }
-
-              left_start_list = g_slist_reverse (left_start_list);
-              right_end_list = g_slist_reverse (right_end_list);
-            }
-
-          success = function (register_buffer, content_buffer,
-                              iter, data, length,
-                              fmt->can_create_tags,
-                              fmt->user_data,
-                              error);
-
-          if (!success && error != NULL && *error == NULL)
-            g_set_error (error, 0, 0,
-                         _("Unknown error when trying to deserialize %s"),
-                         gdk_atom_name (format));
-
-          if (split_tags)
-            {
-              GSList      *left_list;
-              GSList      *right_list;
-              GtkTextIter  left_e;
-              GtkTextIter  right_s;
-
-              /*  Turn the remembered marks back into iters so they
-               *  can by used to re-apply the remembered tags
-               */
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &left_e, left_end);
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &right_s, right_start);
-
-              for (list = split_tags,
-                     left_list = left_start_list,
-                     right_list = right_end_list;
-                   list && left_list && right_list;
-                   list = g_slist_next (list),
-                     left_list = g_slist_next (left_list),
-                     right_list = g_slist_next (right_list))
-                {
-                  GtkTextTag  *tag        = list->data;
-                  GtkTextMark *left_start = left_list->data;
-                  GtkTextMark *right_end  = right_list->data;
-                  GtkTextIter  left_s;
-                  GtkTextIter  right_e;
-
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &left_s, left_start);
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &right_e, right_end);
-
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &left_s, &left_e);
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &right_s, &right_e);
-
-                  gtk_text_buffer_delete_mark (content_buffer, left_start);
-                  gtk_text_buffer_delete_mark (content_buffer, right_end);
-                }
-
-              gtk_text_buffer_delete_mark (content_buffer, left_end);
-              gtk_text_buffer_delete_mark (content_buffer, right_start);
-
-              g_slist_free (split_tags);
-              g_slist_free (left_start_list);
-              g_slist_free (right_end_list);
-            }
-
-          return success;
-        }
-    }
+  g_set_error (error, 0, 0,
+               _("No deserialize function found for format %s"),
+               gdk_atom_name (format));
+
+  return FALSE;
+}
+
+/**
+ * gtk_text_buffer_deserialize_from_stream:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to deserialize into
+ * @format: the rich text format to use for deserializing
+ * @iter: insertion point for the deserialized text
+ * @stream: the #GInputStream to read the data from
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @error: return location for a #GError
+ *
+ * This function reads rich text in format @format from @stream
+ * and inserts it at @iter.
+ *
+ * For GTK+'s internal XML based rich text format, the text is
+ * inserted while it is parsed, so deserializing large amounts of
+ * text doesn't need memory proportional to the size of the text.
+ * Note that this means that if an error occurs, the text that was
+ * read before the error stays in @content_buffer. For other formats,
+ * all of @stream is read before calling the registered
+ * #GtkTextBufferDeserializeFunc.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise.
+ *
+ * Since: 2.16
+ **/
+gboolean
+gtk_text_buffer_deserialize_from_stream (GtkTextBuffer  *register_buffer,
+                                         GtkTextBuffer  *content_buffer,
+                                         GdkAtom         format,
+                                         GtkTextIter    *iter,
+                                         GInputStream   *stream,
+                                         GCancellable   *cancellable,
+                                         GError        **error)
+{
+  GtkRichTextFormat *fmt;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
+  g_return_val_if_fail (format != GDK_NONE, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fmt = find_format (register_buffer, deserialize_quark (), format);
+
+  if (fmt)
+    return deserialize_with_format (register_buffer, content_buffer, fmt,
+                                    iter, NULL, 0, stream, cancellable,
+                                    error);
 
   g_set_error (error, 0, 0,
                _("No deserialize function found for format %s"),
@@ -784,6 +1075,26 @@ get_formats (GList *formats,
   return array;
 }
 
+static GtkRichTextFormat *
+find_format (GtkTextBuffer *buffer,
+             GQuark         quark,
+             GdkAtom        atom)
+{
+  GList *list;
+
+  for (list = g_object_get_qdata (G_OBJECT (buffer), quark);
+       list;
+       list = g_list_next (list))
+    {
+      GtkRichTextFormat *format = list->data;
+
+      if (format->atom == atom)
+        return format;
+    }
+
+  return NULL;
+}
+
 static void
 free_format (GtkRichTextFormat *format)
 {
@@ -26,6 +26,7 @@
 #ifndef __GTK_TEXT_BUFFER_RICH_TEXT_H__
 #define __GTK_TEXT_BUFFER_RICH_TEXT_H__
 
+#include <gio/gio.h>
 #include <gtk/gtktextbuffer.h>
 
 G_BEGIN_DECLS
@@ -61,6 +62,11 @@ GdkAtom   gtk_text_buffer_register_deserialize_format (GtkTextBuffer
 GdkAtom   gtk_text_buffer_register_deserialize_tagset (GtkTextBuffer                *buffer,
                                                        const gchar                  *tagset_name);
 
+GdkAtom   gtk_text_buffer_register_serialize_compact_tagset   (GtkTextBuffer        *buffer,
+                                                               const gchar          *tagset_name);
+GdkAtom   gtk_text_buffer_register_deserialize_compact_tagset (GtkTextBuffer        *buffer,
+                                                               const gchar          *tagset_name);
+
 void    gtk_text_buffer_unregister_serialize_format   (GtkTextBuffer                *buffer,
                                                        GdkAtom                       format);
 void    gtk_text_buffer_unregister_deserialize_format (GtkTextBuffer                *buffer,
@@ -91,6 +97,22 @@ gboolean  gtk_text_buffer_deserialize                 (GtkTextBuffer
                                                        gsize                         length,
                                                        GError                      **error);
 
+gboolean  gtk_text_buffer_serialize_to_stream         (GtkTextBuffer                *register_buffer,
+                                                       GtkTextBuffer                *content_buffer,
+                                                       GdkAtom                       format,
+                                                       const GtkTextIter            *start,
+                                                       const GtkTextIter            *end,
+                                                       GOutputStream                *stream,
+                                                       GCancellable                 *cancellable,
+                                                       GError                      **error);
+gboolean  gtk_text_buffer_deserialize_from_stream     (GtkTextBuffer                *register_buffer,
+                                                       GtkTextBuffer                *content_buffer,
+                                                       GdkAtom                       format,
+                                                       GtkTextIter                  *iter,
+                                                       GInputStream                 *stream,
+                                                       GCancellable                 *cancellable,
+                                                       GError                      **error);
+
 G_END_DECLS
 
 #endif /* __GTK_TEXT_BUFFER_RICH_TEXT_H__ */
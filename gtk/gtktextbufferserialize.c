@@ -25,6 +25,7 @@
 
 #include "config.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -46,8 +47,122 @@ typedef struct
   GList *pixbufs;
   gint tag_id;
   GHashTable *tag_id_tags;
+
+  /* When streaming, text_str only holds the output that has not
+   * been written to the stream yet.
+   */
+  GOutputStream *stream;
+  GCancellable *cancellable;
+  GError *error;
+
+  /* When counting, the text is not stored at all, only text_len
+   * is updated, so we can write the section header before the text.
+   */
+  gboolean counting;
+  gsize text_len;
 } SerializationContext;
 
+/* Amount of output we collect before writing it to the stream */
+#define OUTPUT_CHUNK_SIZE 8192
+
+/* Number of characters we escape at once when serializing a run
+ * of text, so huge untagged runs don't need a huge temporary copy.
+ */
+#define SLICE_CHUNK_CHARS 4096
+
+static void
+output_flush (SerializationContext *context)
+{
+  if (context->stream == NULL || context->error != NULL)
+    return;
+
+  if (context->text_str->len > 0 &&
+      !g_output_stream_write_all (context->stream,
+                                  context->text_str->str,
+                                  context->text_str->len,
+                                  NULL,
+                                  context->cancellable,
+                                  &context->error))
+    return;
+
+  g_string_truncate (context->text_str, 0);
+}
+
+static void
+output_append_len (SerializationContext *context,
+                   const gchar          *data,
+                   gssize                len)
+{
+  if (context->error != NULL)
+    return;
+
+  if (len < 0)
+    len = strlen (data);
+
+  context->text_len += len;
+
+  if (context->counting)
+    return;
+
+  g_string_append_len (context->text_str, data, len);
+
+  if (context->stream && context->text_str->len >= OUTPUT_CHUNK_SIZE)
+    output_flush (context);
+}
+
+static void
+output_append (SerializationContext *context,
+               const gchar          *data)
+{
+  output_append_len (context, data, -1);
+}
+
+static void
+output_append_printf (SerializationContext *context,
+                      const gchar          *format,
+                      ...)
+{
+  va_list args;
+  gchar *tmp;
+
+  va_start (args, format);
+  tmp = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  output_append (context, tmp);
+  g_free (tmp);
+}
+
+static void
+output_append_slice (SerializationContext *context,
+                     const GtkTextIter    *start,
+                     const GtkTextIter    *end)
+{
+  GtkTextIter chunk_start, chunk_end;
+  gchar *tmp_text, *escaped_text;
+
+  chunk_start = *start;
+
+  while (gtk_text_iter_compare (&chunk_start, end) < 0 &&
+         context->error == NULL)
+    {
+      chunk_end = chunk_start;
+      gtk_text_iter_forward_chars (&chunk_end, SLICE_CHUNK_CHARS);
+
+      if (gtk_text_iter_compare (&chunk_end, end) > 0)
+        chunk_end = *end;
+
+      tmp_text = gtk_text_iter_get_slice (&chunk_start, &chunk_end);
+      escaped_text = g_markup_escape_text (tmp_text, -1);
+      g_free (tmp_text);
+
+      output_append (context, escaped_text);
+      g_free (escaped_text);
+
+      chunk_start = chunk_end;
+    }
+}
+
 static gchar *
 serialize_value (GValue *value)
 {
@@ -59,7 +174,7 @@ serialize_value (GValue *value)
       g_value_init (&text_value, G_TYPE_STRING);
       g_value_transform (value, &text_value);
 
-      tmp = g_markup_escape_text (g_value_get_string (&text_value), -1);
+      tmp = g_value_dup_string (&text_value);
       g_value_unset (&text_value);
 
       return tmp;
@@ -320,7 +435,9 @@ serialize_tag (gpointer key,
 	continue;
 
       /* Now serialize the attr */
-      tmp2 = serialize_value (&value);
+      tmp = serialize_value (&value);
+      tmp2 = tmp ? g_markup_escape_text (tmp, -1) : NULL;
+      g_free (tmp);
 
       if (tmp2)
 	{
@@ -436,7 +553,7 @@ serialize_text (GtkTextBuffer        *buffer,
   GSList *tag_list, *new_tag_list;
   GSList *active_tags;
 
-  g_string_append (context->text_str, "<text>");
+  output_append (context, "<text>");
 
   iter = context->start;
   tag_list = NULL;
@@ -446,7 +563,6 @@ serialize_text (GtkTextBuffer        *buffer,
     {
       GList *added, *removed;
       GList *tmp;
-      gchar *tmp_text, *escaped_text;
 
       new_tag_list = gtk_text_iter_get_tags (&iter);
       find_list_delta (tag_list, new_tag_list, &added, &removed);
@@ -461,7 +577,7 @@ serialize_text (GtkTextBuffer        *buffer,
            */
           if (g_slist_find (active_tags, tag))
             {
-              g_string_append (context->text_str, "</apply_tag>");
+              output_append (context, "</apply_tag>");
 
               /* Drop all tags that were opened after this one (which are
                * above this on in the stack)
@@ -470,7 +586,7 @@ serialize_text (GtkTextBuffer        *buffer,
                 {
                   added = g_list_prepend (added, active_tags->data);
                   active_tags = g_slist_remove (active_tags, active_tags->data);
-                  g_string_append_printf (context->text_str, "</apply_tag>");
+                  output_append (context, "</apply_tag>");
                 }
 
               active_tags = g_slist_remove (active_tags, active_tags->data);
@@ -490,7 +606,7 @@ serialize_text (GtkTextBuffer        *buffer,
 	    {
 	      tag_name = g_markup_escape_text (tag->name, -1);
 
-	      g_string_append_printf (context->text_str, "<apply_tag name=\"%s\">", tag_name);
+	      output_append_printf (context, "<apply_tag name=\"%s\">", tag_name);
 	      g_free (tag_name);
 	    }
 	  else
@@ -506,7 +622,7 @@ serialize_text (GtkTextBuffer        *buffer,
 		  g_hash_table_insert (context->tag_id_tags, tag, tag_id);
 		}
 
-	      g_string_append_printf (context->text_str, "<apply_tag id=\"%d\">", GPOINTER_TO_INT (tag_id));
+	      output_append_printf (context, "<apply_tag id=\"%d\">", GPOINTER_TO_INT (tag_id));
 	    }
 
 	  active_tags = g_slist_prepend (active_tags, tag);
@@ -532,18 +648,13 @@ serialize_text (GtkTextBuffer        *buffer,
 	      if (pixbuf)
 		{
 		  /* Append the text before the pixbuf */
-		  tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-		  escaped_text = g_markup_escape_text (tmp_text, -1);
-		  g_free (tmp_text);
+		  output_append_slice (context, &old_iter, &iter);
 
 		  /* Forward so we don't get the 0xfffc char */
 		  gtk_text_iter_forward_char (&iter);
 		  old_iter = iter;
 
-		  g_string_append (context->text_str, escaped_text);
-		  g_free (escaped_text);
-
-		  g_string_append_printf (context->text_str, "<pixbuf index=\"%d\" />", context->n_pixbufs);
+		  output_append_printf (context, "<pixbuf index=\"%d\" />", context->n_pixbufs);
 
 		  context->n_pixbufs++;
 		  context->pixbufs = g_list_prepend (context->pixbufs, pixbuf);
@@ -565,30 +676,26 @@ serialize_text (GtkTextBuffer        *buffer,
 	iter = context->end;
 
       /* Append the text */
-      tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-      escaped_text = g_markup_escape_text (tmp_text, -1);
-      g_free (tmp_text);
-
-      g_string_append (context->text_str, escaped_text);
-      g_free (escaped_text);
+      output_append_slice (context, &old_iter, &iter);
     }
-  while (!gtk_text_iter_equal (&iter, &context->end));
+  while (!gtk_text_iter_equal (&iter, &context->end) &&
+         context->error == NULL);
 
   /* Close any open tags */
   for (tag_list = active_tags; tag_list; tag_list = tag_list->next)
-    g_string_append (context->text_str, "</apply_tag>");
+    output_append (context, "</apply_tag>");
 
   g_slist_free (active_tags);
-  g_string_append (context->text_str, "</text>\n</text_view_markup>\n");
+  output_append (context, "</text>\n</text_view_markup>\n");
 }
 
 static void
-serialize_pixbufs (SerializationContext *context,
-		   GString              *text)
+serialize_pixbufs_list (GList   *pixbufs,
+                        GString *text)
 {
   GList *list;
 
-  for (list = context->pixbufs; list != NULL; list = list->next)
+  for (list = pixbufs; list != NULL; list = list->next)
     {
       GdkPixbuf *pixbuf = list->data;
       GdkPixdata pixdata;
@@ -604,6 +711,47 @@ serialize_pixbufs (SerializationContext *context,
     }
 }
 
+static void
+serialize_pixbufs (SerializationContext *context,
+		   GString              *text)
+{
+  serialize_pixbufs_list (context->pixbufs, text);
+}
+
+static void
+serialization_context_init (SerializationContext *context,
+                            const GtkTextIter    *start,
+                            const GtkTextIter    *end)
+{
+  context->tags = g_hash_table_new (NULL, NULL);
+  context->text_str = g_string_new (NULL);
+  context->tag_table_str = g_string_new (NULL);
+  context->start = *start;
+  context->end = *end;
+  context->n_pixbufs = 0;
+  context->pixbufs = NULL;
+  context->tag_id = 0;
+  context->tag_id_tags = g_hash_table_new (NULL, NULL);
+  context->stream = NULL;
+  context->cancellable = NULL;
+  context->error = NULL;
+  context->counting = FALSE;
+  context->text_len = 0;
+}
+
+static void
+serialization_context_clear (SerializationContext *context)
+{
+  g_hash_table_destroy (context->tags);
+  g_list_free (context->pixbufs);
+  g_string_free (context->text_str, TRUE);
+  g_string_free (context->tag_table_str, TRUE);
+  g_hash_table_destroy (context->tag_id_tags);
+
+  if (context->error)
+    g_error_free (context->error);
+}
+
 guint8 *
 _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
                                       GtkTextBuffer     *content_buffer,
@@ -615,15 +763,7 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   SerializationContext context;
   GString *text;
 
-  context.tags = g_hash_table_new (NULL, NULL);
-  context.text_str = g_string_new (NULL);
-  context.tag_table_str = g_string_new (NULL);
-  context.start = *start;
-  context.end = *end;
-  context.n_pixbufs = 0;
-  context.pixbufs = NULL;
-  context.tag_id = 0;
-  context.tag_id_tags = g_hash_table_new (NULL, NULL);
+  serialization_context_init (&context, start, end);
 
   /* We need to serialize the text before the tag table so we know
      what tags are used */
@@ -640,17 +780,88 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   context.pixbufs = g_list_reverse (context.pixbufs);
   serialize_pixbufs (&context, text);
 
-  g_hash_table_destroy (context.tags);
-  g_list_free (context.pixbufs);
-  g_string_free (context.text_str, TRUE);
-  g_string_free (context.tag_table_str, TRUE);
-  g_hash_table_destroy (context.tag_id_tags);
+  serialization_context_clear (&context);
 
   *length = text->len;
 
   return (guint8 *) g_string_free (text, FALSE);
 }
 
+/* Writes the same data as _gtk_text_buffer_serialize_rich_text(),
+ * but never holds more than OUTPUT_CHUNK_SIZE bytes of the text
+ * section (and one pixbuf) in memory. Since the section header
+ * contains the length of the section, the text is walked twice:
+ * once to collect the tags and measure it, and once to write it.
+ */
+gboolean
+_gtk_text_buffer_serialize_rich_text_to_stream (GtkTextBuffer     *register_buffer,
+                                                GtkTextBuffer     *content_buffer,
+                                                const GtkTextIter *start,
+                                                const GtkTextIter *end,
+                                                GOutputStream     *stream,
+                                                GCancellable      *cancellable,
+                                                GError           **error)
+{
+  SerializationContext context;
+  GString *pixbuf_str;
+  gboolean retval;
+
+  serialization_context_init (&context, start, end);
+  context.cancellable = cancellable;
+
+  /* First pass, only measure */
+  context.counting = TRUE;
+  serialize_text (content_buffer, &context);
+  serialize_tags (&context);
+
+  /* Second pass, write the header, the tags and the text */
+  context.counting = FALSE;
+  context.stream = stream;
+
+  serialize_section_header (context.text_str, "GTKTEXTBUFFERCONTENTS-0001",
+                            context.tag_table_str->len + context.text_len);
+  g_string_append_len (context.text_str,
+                       context.tag_table_str->str, context.tag_table_str->len);
+
+  g_list_free (context.pixbufs);
+  context.pixbufs = NULL;
+  context.n_pixbufs = 0;
+
+  serialize_text (content_buffer, &context);
+  output_flush (&context);
+
+  /* Pixbufs are written one at a time */
+  context.pixbufs = g_list_reverse (context.pixbufs);
+  pixbuf_str = g_string_new (NULL);
+
+  while (context.pixbufs && context.error == NULL)
+    {
+      GList single = { context.pixbufs->data, NULL, NULL };
+
+      g_string_truncate (pixbuf_str, 0);
+      serialize_pixbufs_list (&single, pixbuf_str);
+
+      g_output_stream_write_all (stream, pixbuf_str->str, pixbuf_str->len,
+                                 NULL, cancellable, &context.error);
+
+      context.pixbufs = g_list_delete_link (context.pixbufs, context.pixbufs);
+    }
+
+  g_string_free (pixbuf_str, TRUE);
+
+  retval = context.error == NULL;
+
+  if (context.error)
+    {
+      g_propagate_error (error, context.error);
+      context.error = NULL;
+    }
+
+  serialization_context_clear (&context);
+
+  return retval;
+}
+
 typedef enum
 {
   STATE_START,
@@ -713,8 +924,24 @@ typedef struct
 
   gboolean parsed_text;
   gboolean parsed_tags;
+
+  /* When deserializing from a stream, text is inserted at
+   * insert_iter as soon as it is parsed instead of being
+   * collected in spans. Pixbufs are only read after the text,
+   * so their positions and tags are remembered in pending_pixbufs.
+   */
+  GtkTextIter *insert_iter;
+  GtkTextMark *insert_mark;
+  GList *pending_pixbufs;
 } ParseInfo;
 
+typedef struct
+{
+  GtkTextMark *mark;
+  gint index;
+  GSList *tags;
+} PendingPixbuf;
+
 static void
 set_error (GError              **err,
            GMarkupParseContext  *context,
@@ -1125,11 +1352,28 @@ parse_apply_tag_element (GMarkupParseContext  *context,
 	return;
 
       int_id = atoi (pixbuf_id);
+
+      if (info->insert_iter)
+        {
+          PendingPixbuf *pending;
+
+          pending = g_new0 (PendingPixbuf, 1);
+          pending->index = int_id;
+          pending->mark = gtk_text_buffer_create_mark (info->buffer, NULL,
+                                                       info->insert_iter, TRUE);
+          pending->tags = g_slist_copy (info->tag_stack);
+
+          info->pending_pixbufs = g_list_prepend (info->pending_pixbufs, pending);
+
+          push_state (info, STATE_PIXBUF);
+          return;
+        }
+
       pixbuf = get_pixbuf_from_headers (info->headers, int_id, error);
 
       span = g_new0 (TextSpan, 1);
       span->pixbuf = pixbuf;
-      span->tags = NULL;
+      span->tags = g_slist_copy (info->tag_stack);
 
       info->spans = g_list_prepend (info->spans, span);
 
@@ -1532,6 +1776,41 @@ end_element_handler (GMarkupParseContext  *context,
     }
 }
 
+/* Inserts a run of text or a pixbuf at @iter and applies @tags to it.
+ * info->insert_mark has to be at @iter, it is moved to the end of the
+ * inserted run.
+ */
+static void
+insert_span (ParseInfo   *info,
+             GtkTextIter *iter,
+             const gchar *text,
+             gint         len,
+             GdkPixbuf   *pixbuf,
+             GSList      *tags)
+{
+  GtkTextIter start_iter;
+
+  if (text)
+    gtk_text_buffer_insert (info->buffer, iter, text, len);
+  else
+    gtk_text_buffer_insert_pixbuf (info->buffer, iter, pixbuf);
+
+  gtk_text_buffer_get_iter_at_mark (info->buffer, &start_iter, info->insert_mark);
+
+  /* Apply tags */
+  while (tags)
+    {
+      GtkTextTag *tag = tags->data;
+
+      gtk_text_buffer_apply_tag (info->buffer, tag,
+                                 &start_iter, iter);
+
+      tags = tags->next;
+    }
+
+  gtk_text_buffer_move_mark (info->buffer, info->insert_mark, iter);
+}
+
 static gboolean
 all_whitespace (const char *text,
                 int         text_len)
@@ -1578,6 +1857,13 @@ text_handler (GMarkupParseContext  *context,
       if (text_len == 0)
 	return;
 
+      if (info->insert_iter)
+        {
+          insert_span (info, info->insert_iter, text, text_len,
+                       NULL, info->tag_stack);
+          return;
+        }
+
       span = g_new0 (TextSpan, 1);
       span->text = g_strndup (text, text_len);
       span->tags = g_slist_copy (info->tag_stack);
@@ -1610,6 +1896,9 @@ parse_info_init (ParseInfo     *info,
   info->current_tag = NULL;
   info->current_tag_prio = -1;
   info->tag_priorities = NULL;
+  info->insert_iter = NULL;
+  info->insert_mark = NULL;
+  info->pending_pixbufs = NULL;
 
   info->buffer = buffer;
 }
@@ -1658,54 +1947,48 @@ parse_info_free (ParseInfo *info)
     }
   g_list_free (info->tag_priorities);
 
+  list = info->pending_pixbufs;
+  while (list)
+    {
+      PendingPixbuf *pending = list->data;
+
+      gtk_text_buffer_delete_mark (info->buffer, pending->mark);
+      g_slist_free (pending->tags);
+      g_free (pending);
+
+      list = list->next;
+    }
+  g_list_free (info->pending_pixbufs);
+
+  if (info->insert_mark)
+    gtk_text_buffer_delete_mark (info->buffer, info->insert_mark);
 }
 
 static void
 insert_text (ParseInfo   *info,
 	     GtkTextIter *iter)
 {
-  GtkTextIter start_iter;
-  GtkTextMark *mark;
   GList *tmp;
-  GSList *tags;
-
-  start_iter = *iter;
 
-  mark = gtk_text_buffer_create_mark (info->buffer, "deserialize_insert_point",
-  				      &start_iter, TRUE);
+  info->insert_mark = gtk_text_buffer_create_mark (info->buffer,
+                                                   "deserialize_insert_point",
+                                                   iter, TRUE);
 
   tmp = info->spans;
   while (tmp)
     {
       TextSpan *span = tmp->data;
 
-      if (span->text)
-	gtk_text_buffer_insert (info->buffer, iter, span->text, -1);
-      else
-	{
-	  gtk_text_buffer_insert_pixbuf (info->buffer, iter, span->pixbuf);
-	  g_object_unref (span->pixbuf);
-	}
-      gtk_text_buffer_get_iter_at_mark (info->buffer, &start_iter, mark);
-
-      /* Apply tags */
-      tags = span->tags;
-      while (tags)
-	{
-	  GtkTextTag *tag = tags->data;
-
-	  gtk_text_buffer_apply_tag (info->buffer, tag,
-				     &start_iter, iter);
-
-	  tags = tags->next;
-	}
+      insert_span (info, iter, span->text, -1, span->pixbuf, span->tags);
 
-      gtk_text_buffer_move_mark (info->buffer, mark, iter);
+      if (span->pixbuf)
+        g_object_unref (span->pixbuf);
 
       tmp = tmp->next;
     }
 
-  gtk_text_buffer_delete_mark (info->buffer, mark);
+  gtk_text_buffer_delete_mark (info->buffer, info->insert_mark);
+  info->insert_mark = NULL;
 }
 
 
@@ -1870,3 +2153,936 @@ _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer *register_buffer,
 
   return retval;
 }
+
+/* Reads a section header, returns FALSE at the end of the stream.
+ * @id must have room for 27 bytes.
+ */
+static gboolean
+read_stream_header (GInputStream  *stream,
+                    gchar         *id,
+                    gint          *length,
+                    GCancellable  *cancellable,
+                    GError       **error)
+{
+  guchar buf[30];
+  gsize bytes_read;
+
+  if (!g_input_stream_read_all (stream, buf, sizeof (buf), &bytes_read,
+                                cancellable, error))
+    return FALSE;
+
+  if (bytes_read == 0)
+    return FALSE;
+
+  if (bytes_read < sizeof (buf) || read_int (buf + 26) < 0)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      return FALSE;
+    }
+
+  memcpy (id, buf, 26);
+  id[26] = '\0';
+  *length = read_int (buf + 26);
+
+  return TRUE;
+}
+
+static GdkPixbuf *
+read_stream_pixbuf (GInputStream  *stream,
+                    gint           length,
+                    GCancellable  *cancellable,
+                    GError       **error)
+{
+  guint8 *data;
+  gsize bytes_read;
+  GdkPixdata pixdata;
+  GdkPixbuf *pixbuf = NULL;
+
+  data = g_malloc (length);
+
+  if (!g_input_stream_read_all (stream, data, length, &bytes_read,
+                                cancellable, error))
+    goto out;
+
+  if (bytes_read < length)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      goto out;
+    }
+
+  if (gdk_pixdata_deserialize (&pixdata, length, data, error))
+    pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, error);
+
+ out:
+  g_free (data);
+
+  return pixbuf;
+}
+
+/* Unlike _gtk_text_buffer_deserialize_rich_text(), this inserts the
+ * text while it is being parsed, so if an error occurs, the text that
+ * was parsed up to that point stays in the buffer.
+ */
+gboolean
+_gtk_text_buffer_deserialize_rich_text_from_stream (GtkTextBuffer  *register_buffer,
+                                                    GtkTextBuffer  *content_buffer,
+                                                    GtkTextIter    *iter,
+                                                    GInputStream   *stream,
+                                                    gboolean        create_tags,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error)
+{
+  static const GMarkupParser rich_text_parser = {
+    start_element_handler,
+    end_element_handler,
+    text_handler,
+    NULL,
+    NULL
+  };
+
+  GMarkupParseContext *context;
+  ParseInfo info;
+  gchar id[27];
+  gint length;
+  gchar *buf;
+  GPtrArray *pixbufs;
+  GtkTextMark *end_mark;
+  GList *list;
+  GError *tmp_error = NULL;
+
+  if (!read_stream_header (stream, id, &length, cancellable, &tmp_error))
+    {
+      if (tmp_error)
+        g_propagate_error (error, tmp_error);
+      else
+        g_set_error_literal (error,
+                             G_MARKUP_ERROR,
+                             G_MARKUP_ERROR_PARSE,
+                             _("Serialized data is malformed"));
+      return FALSE;
+    }
+
+  if (strcmp (id, "GTKTEXTBUFFERCONTENTS-0001") != 0)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed. First section isn't GTKTEXTBUFFERCONTENTS-0001"));
+      return FALSE;
+    }
+
+  parse_info_init (&info, content_buffer, create_tags, NULL);
+  info.insert_iter = iter;
+  info.insert_mark = gtk_text_buffer_create_mark (content_buffer, NULL,
+                                                  iter, TRUE);
+
+  context = g_markup_parse_context_new (&rich_text_parser,
+                                        0, &info, NULL);
+
+  buf = g_malloc (OUTPUT_CHUNK_SIZE);
+  pixbufs = g_ptr_array_new ();
+
+  while (length > 0)
+    {
+      gssize n_read;
+
+      n_read = g_input_stream_read (stream, buf,
+                                    MIN (length, OUTPUT_CHUNK_SIZE),
+                                    cancellable, &tmp_error);
+      if (n_read < 0)
+        goto out;
+
+      if (n_read == 0)
+        {
+          g_set_error_literal (&tmp_error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Serialized data is malformed"));
+          goto out;
+        }
+
+      if (!g_markup_parse_context_parse (context, buf, n_read, &tmp_error))
+        goto out;
+
+      length -= n_read;
+    }
+
+  if (!g_markup_parse_context_end_parse (context, &tmp_error))
+    goto out;
+
+  /* The pixbufs follow the text */
+  while (read_stream_header (stream, id, &length, cancellable, &tmp_error))
+    {
+      GdkPixbuf *pixbuf;
+
+      if (strcmp (id, "GTKTEXTBUFFERPIXBDATA-0001") != 0)
+        break;
+
+      pixbuf = read_stream_pixbuf (stream, length, cancellable, &tmp_error);
+
+      if (!pixbuf)
+        goto out;
+
+      g_ptr_array_add (pixbufs, pixbuf);
+    }
+
+  if (tmp_error)
+    goto out;
+
+  /* The pending pixbufs are in reverse order, which makes pixbufs
+   * that follow each other without text in between come out in the
+   * right order, since all the marks have left gravity.
+   */
+  end_mark = gtk_text_buffer_create_mark (content_buffer, NULL, iter, FALSE);
+
+  for (list = info.pending_pixbufs; list; list = list->next)
+    {
+      PendingPixbuf *pending = list->data;
+      GtkTextIter pixbuf_iter, start_iter;
+      GSList *tags;
+
+      if (pending->index < 0 || pending->index >= pixbufs->len)
+        continue;
+
+      gtk_text_buffer_get_iter_at_mark (content_buffer, &pixbuf_iter,
+                                        pending->mark);
+      gtk_text_buffer_insert_pixbuf (content_buffer, &pixbuf_iter,
+                                     g_ptr_array_index (pixbufs, pending->index));
+
+      /* The mark has left gravity, so it is before the pixbuf now */
+      gtk_text_buffer_get_iter_at_mark (content_buffer, &start_iter,
+                                        pending->mark);
+      for (tags = pending->tags; tags; tags = tags->next)
+        gtk_text_buffer_apply_tag (content_buffer, tags->data,
+                                   &start_iter, &pixbuf_iter);
+    }
+
+  /* Inserting the pixbufs invalidated the iter */
+  gtk_text_buffer_get_iter_at_mark (content_buffer, iter, end_mark);
+  gtk_text_buffer_delete_mark (content_buffer, end_mark);
+
+ out:
+  g_ptr_array_foreach (pixbufs, (GFunc) g_object_unref, NULL);
+  g_ptr_array_free (pixbufs, TRUE);
+  g_free (buf);
+
+  g_markup_parse_context_free (context);
+  parse_info_free (&info);
+
+  if (tmp_error)
+    {
+      g_propagate_error (error, tmp_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+/* The compact format
+ *
+ * The compact format carries the same information as the XML format,
+ * but is a flat list of binary records that can be written and read
+ * in a single pass. It starts with COMPACT_MAGIC, followed by records
+ * that each start with an opcode byte. Integers are stored as
+ * variable length, 7 bits per byte, least significant group first.
+ * Strings are stored as their length followed by the bytes, without
+ * a trailing nul.
+ *
+ *  'T' name priority n_attrs (name type value)*
+ *     defines the next tag index, an empty name means anonymous
+ *  'S' n_tags tag_index* text
+ *     a run of text with the given tags applied
+ *  'P' n_tags tag_index* length pixdata
+ *     a pixbuf in serialized GdkPixdata form
+ *
+ * Tags are defined right before the first record that uses them.
+ */
+#define COMPACT_MAGIC "GTKTEXTBUFFERCOMPACT-0001"
+
+#define COMPACT_OP_TAG    'T'
+#define COMPACT_OP_TEXT   'S'
+#define COMPACT_OP_PIXBUF 'P'
+
+static void
+compact_put_uint (SerializationContext *context,
+                  guint32               value)
+{
+  gchar buf[5];
+  gint len = 0;
+
+  do
+    {
+      buf[len] = value & 0x7f;
+      value >>= 7;
+      if (value)
+        buf[len] |= 0x80;
+      len++;
+    }
+  while (value);
+
+  output_append_len (context, buf, len);
+}
+
+static void
+compact_put_string (SerializationContext *context,
+                    const gchar          *str,
+                    gssize                len)
+{
+  if (len < 0)
+    len = str ? strlen (str) : 0;
+
+  compact_put_uint (context, len);
+
+  if (len > 0)
+    output_append_len (context, str, len);
+}
+
+static void
+compact_put_op (SerializationContext *context,
+                gchar                 op)
+{
+  output_append_len (context, &op, 1);
+}
+
+static gint
+compact_tag_index (SerializationContext *context,
+                   GtkTextTag           *tag)
+{
+  gpointer index;
+  GParamSpec **pspecs;
+  guint n_pspecs;
+  GPtrArray *attrs;
+  gint i;
+
+  if (g_hash_table_lookup_extended (context->tag_id_tags, tag, NULL, &index))
+    return GPOINTER_TO_INT (index);
+
+  index = GINT_TO_POINTER (context->tag_id++);
+  g_hash_table_insert (context->tag_id_tags, tag, index);
+
+  /* Collect the attributes first, since we need their number */
+  attrs = g_ptr_array_new ();
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (tag), &n_pspecs);
+
+  for (i = 0; i < n_pspecs; i++)
+    {
+      GValue value = { 0 };
+      gchar *tmp;
+
+      if (!(pspecs[i]->flags & G_PARAM_READABLE) ||
+	  !(pspecs[i]->flags & G_PARAM_WRITABLE))
+	continue;
+
+      if (!is_param_set (G_OBJECT (tag), pspecs[i], &value))
+	continue;
+
+      tmp = serialize_value (&value);
+      g_value_unset (&value);
+
+      if (tmp)
+        {
+          g_ptr_array_add (attrs, pspecs[i]);
+          g_ptr_array_add (attrs, tmp);
+        }
+    }
+
+  g_free (pspecs);
+
+  compact_put_op (context, COMPACT_OP_TAG);
+  compact_put_string (context, tag->name, -1);
+  compact_put_uint (context, tag->priority);
+  compact_put_uint (context, attrs->len / 2);
+
+  for (i = 0; i < attrs->len; i += 2)
+    {
+      GParamSpec *pspec = g_ptr_array_index (attrs, i);
+      gchar *value = g_ptr_array_index (attrs, i + 1);
+
+      compact_put_string (context, pspec->name, -1);
+      compact_put_string (context, g_type_name (pspec->value_type), -1);
+      compact_put_string (context, value, -1);
+
+      g_free (value);
+    }
+
+  g_ptr_array_free (attrs, TRUE);
+
+  return GPOINTER_TO_INT (index);
+}
+
+static void
+compact_put_tags (SerializationContext *context,
+                  GArray               *indices)
+{
+  gint i;
+
+  compact_put_uint (context, indices->len);
+
+  for (i = 0; i < indices->len; i++)
+    compact_put_uint (context, g_array_index (indices, gint, i));
+}
+
+static void
+compact_put_text (SerializationContext *context,
+                  GArray               *indices,
+                  const GtkTextIter    *start,
+                  const GtkTextIter    *end)
+{
+  GtkTextIter chunk_start, chunk_end;
+  gchar *text;
+
+  chunk_start = *start;
+
+  while (gtk_text_iter_compare (&chunk_start, end) < 0 &&
+         context->error == NULL)
+    {
+      chunk_end = chunk_start;
+      gtk_text_iter_forward_chars (&chunk_end, SLICE_CHUNK_CHARS);
+
+      if (gtk_text_iter_compare (&chunk_end, end) > 0)
+        chunk_end = *end;
+
+      text = gtk_text_iter_get_slice (&chunk_start, &chunk_end);
+
+      compact_put_op (context, COMPACT_OP_TEXT);
+      compact_put_tags (context, indices);
+      compact_put_string (context, text, -1);
+
+      g_free (text);
+
+      chunk_start = chunk_end;
+    }
+}
+
+static void
+compact_put_pixbuf (SerializationContext *context,
+                    GArray               *indices,
+                    GdkPixbuf            *pixbuf)
+{
+  GdkPixdata pixdata;
+  guint8 *data;
+  guint len;
+
+  gdk_pixdata_from_pixbuf (&pixdata, pixbuf, FALSE);
+  data = gdk_pixdata_serialize (&pixdata, &len);
+
+  compact_put_op (context, COMPACT_OP_PIXBUF);
+  compact_put_tags (context, indices);
+  compact_put_string (context, (gchar *) data, len);
+
+  g_free (data);
+}
+
+static gboolean
+is_object_char (gunichar ch,
+                gpointer user_data)
+{
+  return ch == 0xFFFC;
+}
+
+static void
+serialize_compact (GtkTextBuffer        *buffer,
+                   SerializationContext *context)
+{
+  GtkTextIter iter, run_end, text_start, pos;
+  GArray *indices;
+
+  output_append (context, COMPACT_MAGIC);
+
+  indices = g_array_new (FALSE, FALSE, sizeof (gint));
+  iter = context->start;
+
+  while (gtk_text_iter_compare (&iter, &context->end) < 0 &&
+         context->error == NULL)
+    {
+      GSList *tags, *l;
+
+      run_end = iter;
+      gtk_text_iter_forward_to_tag_toggle (&run_end, NULL);
+
+      if (gtk_text_iter_compare (&run_end, &context->end) > 0)
+        run_end = context->end;
+
+      g_array_set_size (indices, 0);
+      tags = gtk_text_iter_get_tags (&iter);
+
+      for (l = tags; l; l = l->next)
+        {
+          gint index = compact_tag_index (context, l->data);
+
+          g_array_append_val (indices, index);
+        }
+
+      g_slist_free (tags);
+
+      /* Split the run at pixbufs */
+      text_start = iter;
+      pos = iter;
+
+      while (gtk_text_iter_compare (&pos, &run_end) < 0)
+        {
+          GdkPixbuf *pixbuf = NULL;
+
+          if (gtk_text_iter_get_char (&pos) == 0xFFFC)
+            pixbuf = gtk_text_iter_get_pixbuf (&pos);
+
+          if (pixbuf)
+            {
+              compact_put_text (context, indices, &text_start, &pos);
+              compact_put_pixbuf (context, indices, pixbuf);
+
+              gtk_text_iter_forward_char (&pos);
+              text_start = pos;
+            }
+          else if (!gtk_text_iter_forward_find_char (&pos, is_object_char,
+                                                     NULL, &run_end))
+            break;
+        }
+
+      compact_put_text (context, indices, &text_start, &run_end);
+
+      iter = run_end;
+    }
+
+  g_array_free (indices, TRUE);
+}
+
+guint8 *
+_gtk_text_buffer_serialize_compact_rich_text (GtkTextBuffer     *register_buffer,
+                                              GtkTextBuffer     *content_buffer,
+                                              const GtkTextIter *start,
+                                              const GtkTextIter *end,
+                                              gsize             *length,
+                                              gpointer           user_data)
+{
+  SerializationContext context;
+  gchar *data;
+
+  serialization_context_init (&context, start, end);
+
+  serialize_compact (content_buffer, &context);
+
+  *length = context.text_str->len;
+  data = g_string_free (context.text_str, FALSE);
+  context.text_str = g_string_new (NULL);
+
+  serialization_context_clear (&context);
+
+  return (guint8 *) data;
+}
+
+gboolean
+_gtk_text_buffer_serialize_compact_rich_text_to_stream (GtkTextBuffer     *register_buffer,
+                                                        GtkTextBuffer     *content_buffer,
+                                                        const GtkTextIter *start,
+                                                        const GtkTextIter *end,
+                                                        GOutputStream     *stream,
+                                                        GCancellable      *cancellable,
+                                                        GError           **error)
+{
+  SerializationContext context;
+  gboolean retval;
+
+  serialization_context_init (&context, start, end);
+  context.stream = stream;
+  context.cancellable = cancellable;
+
+  serialize_compact (content_buffer, &context);
+  output_flush (&context);
+
+  retval = context.error == NULL;
+
+  if (context.error)
+    {
+      g_propagate_error (error, context.error);
+      context.error = NULL;
+    }
+
+  serialization_context_clear (&context);
+
+  return retval;
+}
+
+typedef struct
+{
+  const guchar *p;
+  const guchar *end;
+} CompactReader;
+
+static void
+unref_tag (gpointer tag,
+           gpointer user_data)
+{
+  if (tag)
+    g_object_unref (tag);
+}
+
+static gboolean
+compact_get_uint (CompactReader *reader,
+                  guint32       *value)
+{
+  gint shift = 0;
+
+  *value = 0;
+
+  while (reader->p < reader->end && shift < 32)
+    {
+      guchar byte = *reader->p++;
+
+      *value |= (guint32) (byte & 0x7f) << shift;
+
+      if (!(byte & 0x80))
+        return TRUE;
+
+      shift += 7;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+compact_get_string (CompactReader  *reader,
+                    const gchar   **str,
+                    guint32        *len)
+{
+  if (!compact_get_uint (reader, len))
+    return FALSE;
+
+  if (*len > reader->end - reader->p)
+    return FALSE;
+
+  *str = (const gchar *) reader->p;
+  reader->p += *len;
+
+  return TRUE;
+}
+
+static gboolean
+compact_get_tags (CompactReader *reader,
+                  GPtrArray     *tags,
+                  GSList       **tag_list)
+{
+  guint32 n_tags, index, i;
+
+  *tag_list = NULL;
+
+  if (!compact_get_uint (reader, &n_tags))
+    return FALSE;
+
+  for (i = 0; i < n_tags; i++)
+    {
+      if (!compact_get_uint (reader, &index) || index >= tags->len)
+        {
+          g_slist_free (*tag_list);
+          *tag_list = NULL;
+          return FALSE;
+        }
+
+      if (g_ptr_array_index (tags, index))
+        *tag_list = g_slist_prepend (*tag_list, g_ptr_array_index (tags, index));
+    }
+
+  return TRUE;
+}
+
+/* Reads a tag definition. When @dry_run is set, only checks that the
+ * tag could be created or found and appends %NULL to @tags.
+ */
+static gboolean
+compact_get_tag (CompactReader  *reader,
+                 ParseInfo      *info,
+                 GPtrArray      *tags,
+                 GArray         *priorities,
+                 gboolean        dry_run,
+                 GError        **error)
+{
+  const gchar *str;
+  guint32 len, priority, n_attrs, i;
+  gchar *name = NULL;
+  GtkTextTag *tag = NULL;
+
+  if (!compact_get_string (reader, &str, &len) ||
+      !compact_get_uint (reader, &priority) ||
+      !compact_get_uint (reader, &n_attrs))
+    goto malformed;
+
+  if (len > 0)
+    name = g_strndup (str, len);
+
+  if (!info->create_tags)
+    {
+      if (!name)
+        {
+          g_set_error_literal (error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Anonymous tag found and tags can not be created."));
+          return FALSE;
+        }
+
+      tag = gtk_text_tag_table_lookup (gtk_text_buffer_get_tag_table (info->buffer),
+                                       name);
+
+      if (!tag)
+        {
+          g_set_error (error,
+                       G_MARKUP_ERROR,
+                       G_MARKUP_ERROR_PARSE,
+                       _("Tag \"%s\" does not exist in buffer and tags can not be created."),
+                       name);
+          g_free (name);
+          return FALSE;
+        }
+
+      g_object_ref (tag);
+    }
+  else if (!dry_run)
+    {
+      if (name)
+        {
+          gchar *tag_name = get_tag_name (info, name);
+
+          tag = gtk_text_tag_new (tag_name);
+          g_free (tag_name);
+        }
+      else
+        tag = gtk_text_tag_new (NULL);
+    }
+
+  for (i = 0; i < n_attrs; i++)
+    {
+      const gchar *attr_name, *type_name, *value;
+      guint32 attr_name_len, type_name_len, value_len;
+
+      if (!compact_get_string (reader, &attr_name, &attr_name_len) ||
+          !compact_get_string (reader, &type_name, &type_name_len) ||
+          !compact_get_string (reader, &value, &value_len))
+        goto malformed;
+
+      if (info->create_tags && !dry_run)
+        {
+          gchar *attr = g_strndup (attr_name, attr_name_len);
+          gchar *type = g_strndup (type_name, type_name_len);
+          gchar *val = g_strndup (value, value_len);
+          GParamSpec *pspec;
+          GType gtype;
+          GValue gvalue = { 0 };
+
+          gtype = g_type_from_name (type);
+          pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (tag), attr);
+
+          /* Skip attributes this version doesn't know about */
+          if (gtype != G_TYPE_INVALID && pspec)
+            {
+              g_value_init (&gvalue, gtype);
+
+              if (deserialize_value (val, &gvalue) &&
+                  !g_param_value_validate (pspec, &gvalue))
+                g_object_set_property (G_OBJECT (tag), attr, &gvalue);
+
+              g_value_unset (&gvalue);
+            }
+
+          g_free (attr);
+          g_free (type);
+          g_free (val);
+        }
+    }
+
+  if (info->create_tags && !dry_run)
+    {
+      GtkTextTagTable *table;
+      gint n_higher = 0;
+      gint prio = priority;
+
+      /* Keep the relative order of the priorities of the tags
+       * we create, the new tag starts out with the highest one.
+       */
+      for (i = 0; i < priorities->len; i++)
+        if (g_array_index (priorities, gint, i) > prio)
+          n_higher++;
+
+      table = gtk_text_buffer_get_tag_table (info->buffer);
+      gtk_text_tag_table_add (table, tag);
+      gtk_text_tag_set_priority (tag, gtk_text_tag_table_get_size (table) - 1 - n_higher);
+
+      g_array_append_val (priorities, prio);
+    }
+
+  g_ptr_array_add (tags, dry_run ? NULL : tag);
+
+  if (dry_run && tag)
+    g_object_unref (tag);
+
+  g_free (name);
+
+  return TRUE;
+
+ malformed:
+  g_free (name);
+  if (tag)
+    g_object_unref (tag);
+
+  g_set_error_literal (error,
+                       G_MARKUP_ERROR,
+                       G_MARKUP_ERROR_PARSE,
+                       _("Serialized data is malformed"));
+  return FALSE;
+}
+
+static gboolean
+deserialize_compact (ParseInfo     *info,
+                     GtkTextIter   *iter,
+                     const guint8  *data,
+                     gsize          length,
+                     gboolean       dry_run,
+                     GError       **error)
+{
+  CompactReader reader;
+  GPtrArray *tags;
+  GArray *priorities;
+  gboolean retval = FALSE;
+
+  reader.p = data + strlen (COMPACT_MAGIC);
+  reader.end = data + length;
+
+  tags = g_ptr_array_new ();
+  priorities = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  if (!dry_run)
+    info->insert_mark = gtk_text_buffer_create_mark (info->buffer, NULL,
+                                                     iter, TRUE);
+
+  while (reader.p < reader.end)
+    {
+      guchar op = *reader.p++;
+      const gchar *str;
+      guint32 len;
+      GSList *tag_list;
+
+      switch (op)
+        {
+        case COMPACT_OP_TAG:
+          if (!compact_get_tag (&reader, info, tags, priorities, dry_run, error))
+            goto out;
+          break;
+
+        case COMPACT_OP_TEXT:
+          if (!compact_get_tags (&reader, tags, &tag_list))
+            goto malformed;
+
+          if (!compact_get_string (&reader, &str, &len))
+            {
+              g_slist_free (tag_list);
+              goto malformed;
+            }
+
+          if (dry_run)
+            {
+              if (!g_utf8_validate (str, len, NULL))
+                goto malformed;
+            }
+          else
+            insert_span (info, iter, str, len, NULL, tag_list);
+
+          g_slist_free (tag_list);
+          break;
+
+        case COMPACT_OP_PIXBUF:
+          {
+            GdkPixdata pixdata;
+            GdkPixbuf *pixbuf;
+
+            if (!compact_get_tags (&reader, tags, &tag_list))
+              goto malformed;
+
+            if (!compact_get_string (&reader, &str, &len) ||
+                !gdk_pixdata_deserialize (&pixdata, len, (const guint8 *) str, error))
+              {
+                g_slist_free (tag_list);
+                if (error && *error)
+                  goto out;
+                goto malformed;
+              }
+
+            if (!dry_run)
+              {
+                pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, NULL);
+
+                if (pixbuf)
+                  {
+                    insert_span (info, iter, NULL, 0, pixbuf, tag_list);
+                    g_object_unref (pixbuf);
+                  }
+              }
+
+            g_slist_free (tag_list);
+          }
+          break;
+
+        default:
+          goto malformed;
+        }
+    }
+
+  retval = TRUE;
+  goto out;
+
+ malformed:
+  g_set_error_literal (error,
+                       G_MARKUP_ERROR,
+                       G_MARKUP_ERROR_PARSE,
+                       _("Serialized data is malformed"));
+
+ out:
+  g_ptr_array_foreach (tags, (GFunc) unref_tag, NULL);
+  g_ptr_array_free (tags, TRUE);
+  g_array_free (priorities, TRUE);
+
+  return retval;
+}
+
+gboolean
+_gtk_text_buffer_deserialize_compact_rich_text (GtkTextBuffer *register_buffer,
+                                                GtkTextBuffer *content_buffer,
+                                                GtkTextIter   *iter,
+                                                const guint8  *data,
+                                                gsize          length,
+                                                gboolean       create_tags,
+                                                gpointer       user_data,
+                                                GError       **error)
+{
+  ParseInfo info;
+  gboolean retval;
+
+  if (length < strlen (COMPACT_MAGIC) ||
+      strncmp ((const gchar *) data, COMPACT_MAGIC, strlen (COMPACT_MAGIC)) != 0)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      return FALSE;
+    }
+
+  parse_info_init (&info, content_buffer, create_tags, NULL);
+
+  /* Like the XML format, don't touch the buffer unless all of
+   * the data can be inserted.
+   */
+  retval = deserialize_compact (&info, iter, data, length, TRUE, error);
+
+  if (retval)
+    retval = deserialize_compact (&info, iter, data, length, FALSE, error);
+
+  parse_info_free (&info);
+
+  return retval;
+}
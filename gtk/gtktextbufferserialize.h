@@ -21,6 +21,7 @@
 #ifndef __GTK_TEXT_BUFFER_SERIALIZE_H__
 #define __GTK_TEXT_BUFFER_SERIALIZE_H__
 
+#include <gio/gio.h>
 #include <gtk/gtktextbuffer.h>
 
 guint8 * _gtk_text_buffer_serialize_rich_text   (GtkTextBuffer     *register_buffer,
@@ -39,5 +40,44 @@ gboolean _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer     *register_buf
                                                  gpointer           user_data,
                                                  GError           **error);
 
+gboolean _gtk_text_buffer_serialize_rich_text_to_stream     (GtkTextBuffer     *register_buffer,
+                                                             GtkTextBuffer     *content_buffer,
+                                                             const GtkTextIter *start,
+                                                             const GtkTextIter *end,
+                                                             GOutputStream     *stream,
+                                                             GCancellable      *cancellable,
+                                                             GError           **error);
+
+gboolean _gtk_text_buffer_deserialize_rich_text_from_stream (GtkTextBuffer     *register_buffer,
+                                                             GtkTextBuffer     *content_buffer,
+                                                             GtkTextIter       *iter,
+                                                             GInputStream      *stream,
+                                                             gboolean           create_tags,
+                                                             GCancellable      *cancellable,
+                                                             GError           **error);
+
+guint8 * _gtk_text_buffer_serialize_compact_rich_text   (GtkTextBuffer     *register_buffer,
+                                                         GtkTextBuffer     *content_buffer,
+                                                         const GtkTextIter *start,
+                                                         const GtkTextIter *end,
+                                                         gsize             *length,
+                                                         gpointer           user_data);
+
+gboolean _gtk_text_buffer_serialize_compact_rich_text_to_stream (GtkTextBuffer     *register_buffer,
+                                                                 GtkTextBuffer     *content_buffer,
+                                                                 const GtkTextIter *start,
+                                                                 const GtkTextIter *end,
+                                                                 GOutputStream     *stream,
+                                                                 GCancellable      *cancellable,
+                                                                 GError           **error);
+
+gboolean _gtk_text_buffer_deserialize_compact_rich_text (GtkTextBuffer     *register_buffer,
+                                                         GtkTextBuffer     *content_buffer,
+                                                         GtkTextIter       *iter,
+                                                         const guint8      *data,
+                                                         gsize              length,
+                                                         gboolean           create_tags,
+                                                         gpointer           user_data,
+                                                         GError           **error);
 
 #endif /* __GTK_TEXT_BUFFER_SERIALIZE_H__ */
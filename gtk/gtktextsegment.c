@@ -159,6 +159,14 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
 #define TSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + sizeof (GtkTextToggleBody)))
 
+/* Char segments are allocated with g_slice, which doesn't add a
+ * header to every block and packs small blocks densely. Large
+ * buffers consist mostly of short lines with one char segment each,
+ * so this is a good part of the memory used per line.
+ */
+#define char_segment_alloc(chars) ((GtkTextLineSegment *) g_slice_alloc (CSEG_SIZE (chars)))
+#define char_segment_free(seg)    (g_slice_free1 (CSEG_SIZE ((seg)->byte_count), (seg)))
+
 /*
  * Type functions
  */
@@ -195,7 +203,7 @@ _gtk_char_segment_new (const gchar *text, guint len)
 
   g_assert (gtk_text_byte_begins_utf8_char (text));
 
-  seg = g_malloc (CSEG_SIZE (len));
+  seg = char_segment_alloc (len);
   seg->type = (GtkTextLineSegmentClass *)&gtk_text_char_type;
   seg->next = NULL;
   seg->byte_count = len;
@@ -223,7 +231,7 @@ _gtk_char_segment_new_from_two_strings (const gchar *text1,
   g_assert (gtk_text_byte_begins_utf8_char (text1));
   g_assert (gtk_text_byte_begins_utf8_char (text2));
 
-  seg = g_malloc (CSEG_SIZE (len1+len2));
+  seg = char_segment_alloc (len1 + len2);
   seg->type = &gtk_text_char_type;
   seg->next = NULL;
   seg->byte_count = len1 + len2;
@@ -286,7 +294,7 @@ char_segment_split_func (GtkTextLineSegment *seg, int index)
       char_segment_self_check (new2);
     }
 
-  g_free (seg);
+  char_segment_free (seg);
   return new1;
 }
 
@@ -341,8 +349,8 @@ char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
   if (gtk_debug_flags & GTK_DEBUG_TEXT)
     char_segment_self_check (newPtr);
 
-  g_free (segPtr);
-  g_free (segPtr2);
+  char_segment_free (segPtr);
+  char_segment_free (segPtr2);
   return newPtr;
 }
 
@@ -372,7 +380,7 @@ char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
 static int
 char_segment_delete_func (GtkTextLineSegment *segPtr, GtkTextLine *line, int treeGone)
 {
-  g_free ((char*) segPtr);
+  char_segment_free (segPtr);
   return 0;
 }
 
@@ -79,6 +79,7 @@ struct _Node {
   GList *uifiles;
 
   guint dirty : 1;
+  guint children_dirty : 1;
   guint expand : 1;  /* used for separators */
   guint popup_accels : 1;
 };
@@ -97,10 +98,17 @@ struct _GtkUIManagerPrivate
   guint update_tag;  
 
   gboolean add_tearoffs;
+  gboolean updating;
+
+  /* unused menu and tool items, kept for reuse by later merges */
+  GSList *proxy_pool;
+  guint n_pooled_proxies;
 };
 
 #define NODE_INFO(node) ((Node *)node->data)
 
+#define PROXY_POOL_SIZE 128
+
 typedef struct _NodeUIReference NodeUIReference;
 
 struct _NodeUIReference 
@@ -124,6 +132,8 @@ static GtkAction * gtk_ui_manager_real_get_action (GtkUIManager      *manager,
                                                    const gchar       *path);
 static void        queue_update                   (GtkUIManager      *self);
 static void        dirty_all_nodes                (GtkUIManager      *self);
+static void        dirty_group_nodes              (GtkUIManager      *self,
+                                                   GtkActionGroup    *action_group);
 static void        mark_node_dirty                (GNode             *node);
 static GNode     * get_child_node                 (GtkUIManager      *self,
                                                    GNode             *parent,
@@ -391,6 +401,10 @@ gtk_ui_manager_init (GtkUIManager *self)
 
   self->private_data->last_merge_id = 0;
   self->private_data->add_tearoffs = FALSE;
+  self->private_data->updating = FALSE;
+
+  self->private_data->proxy_pool = NULL;
+  self->private_data->n_pooled_proxies = 0;
 
   merge_id = gtk_ui_manager_new_merge_id (self);
   node = get_child_node (self, NULL, NULL, "ui", 2,
@@ -414,6 +428,14 @@ gtk_ui_manager_finalize (GObject *object)
 		   (GNodeTraverseFunc)free_node, NULL);
   g_node_destroy (self->private_data->root_node);
   self->private_data->root_node = NULL;
+
+  g_slist_foreach (self->private_data->proxy_pool,
+                   (GFunc) gtk_widget_destroy, NULL);
+  g_slist_foreach (self->private_data->proxy_pool,
+                   (GFunc) g_object_unref, NULL);
+  g_slist_free (self->private_data->proxy_pool);
+  self->private_data->proxy_pool = NULL;
+  self->private_data->n_pooled_proxies = 0;
   
   g_list_foreach (self->private_data->action_groups,
                   (GFunc) g_object_unref, NULL);
@@ -733,8 +755,8 @@ gtk_ui_manager_insert_action_group (GtkUIManager   *self,
 		    "object-signal::post-activate", G_CALLBACK (cb_proxy_post_activate), self,
 		    NULL);
 
-  /* dirty all nodes, as action bindings may change */
-  dirty_all_nodes (self);
+  /* dirty the nodes whose action bindings may change */
+  dirty_group_nodes (self, action_group);
 
   g_signal_emit (self, ui_manager_signals[ACTIONS_CHANGED], 0);
 }
@@ -767,10 +789,10 @@ gtk_ui_manager_remove_action_group (GtkUIManager   *self,
                        "any-signal::pre-activate", G_CALLBACK (cb_proxy_pre_activate), self,
                        "any-signal::post-activate", G_CALLBACK (cb_proxy_post_activate), self, 
                        NULL);
-  g_object_unref (action_group);
 
-  /* dirty all nodes, as action bindings may change */
-  dirty_all_nodes (self);
+  /* dirty the nodes whose action bindings may change */
+  dirty_group_nodes (self, action_group);
+  g_object_unref (action_group);
 
   g_signal_emit (self, ui_manager_signals[ACTIONS_CHANGED], 0);
 }
@@ -2209,6 +2231,109 @@ update_smart_separators (GtkWidget *proxy)
     }
 }
 
+static void
+cb_proxy_visible_changed (GtkWidget    *proxy,
+			  GParamSpec   *pspec,
+			  GtkUIManager *self)
+{
+  /* While updating, the smart separators of all changed menus
+   * and toolbars are fixed up once their children are done.
+   */
+  if (self->private_data->updating)
+    return;
+
+  update_smart_separators (proxy);
+}
+
+/* Menu and tool items of dead nodes are kept around so that
+ * later merges can reconnect them instead of creating new
+ * widgets. Only items of the types GtkAction creates by default
+ * are reused, since subclasses may set them up differently.
+ */
+static gboolean
+pool_proxy (GtkUIManager *self,
+	    Node         *info,
+	    gboolean      in_popup)
+{
+  GtkWidget *proxy = info->proxy;
+
+  if (in_popup || info->action == NULL ||
+      gtk_widget_get_action (proxy) != info->action ||
+      self->private_data->n_pooled_proxies >= PROXY_POOL_SIZE)
+    return FALSE;
+
+  if (info->type == NODE_TYPE_MENUITEM)
+    {
+      if (!GTK_IS_MENU_ITEM (proxy) ||
+	  gtk_menu_item_get_submenu (GTK_MENU_ITEM (proxy)) != NULL)
+	return FALSE;
+    }
+  else if (info->type == NODE_TYPE_TOOLITEM)
+    {
+      if (!GTK_IS_TOOL_ITEM (proxy) || GTK_IS_MENU_TOOL_BUTTON (proxy))
+	return FALSE;
+    }
+  else
+    return FALSE;
+
+  g_signal_handlers_disconnect_by_func (proxy,
+					G_CALLBACK (cb_proxy_visible_changed),
+					self);
+  gtk_action_disconnect_proxy (info->action, proxy);
+  if (proxy->parent)
+    gtk_container_remove (GTK_CONTAINER (proxy->parent), proxy);
+
+  /* the pool takes over the reference of the node */
+  self->private_data->proxy_pool = 
+    g_slist_prepend (self->private_data->proxy_pool, proxy);
+  self->private_data->n_pooled_proxies++;
+  info->proxy = NULL;
+
+  return TRUE;
+}
+
+static GtkWidget *
+get_pooled_proxy (GtkUIManager *self,
+		  GtkAction    *action,
+		  NodeType      type)
+{
+  GtkActionClass *action_class = GTK_ACTION_GET_CLASS (action);
+  GtkActionClass *default_class = g_type_class_peek (GTK_TYPE_ACTION);
+  GType proxy_type;
+  GSList *l;
+
+  if (type == NODE_TYPE_MENUITEM)
+    {
+      if (action_class->create_menu_item != default_class->create_menu_item)
+	return NULL;
+      proxy_type = action_class->menu_item_type;
+    }
+  else
+    {
+      if (action_class->create_tool_item != default_class->create_tool_item)
+	return NULL;
+      proxy_type = action_class->toolbar_item_type;
+    }
+
+  for (l = self->private_data->proxy_pool; l; l = l->next)
+    {
+      GtkWidget *proxy = l->data;
+
+      if (G_OBJECT_TYPE (proxy) == proxy_type)
+	{
+	  self->private_data->proxy_pool = 
+	    g_slist_delete_link (self->private_data->proxy_pool, l);
+	  self->private_data->n_pooled_proxies--;
+
+	  gtk_action_connect_proxy (action, proxy);
+
+	  return proxy;
+	}
+    }
+
+  return NULL;
+}
+
 static void
 update_node (GtkUIManager *self, 
 	     GNode        *node,
@@ -2230,15 +2355,21 @@ update_node (GtkUIManager *self,
 
   info = NODE_INFO (node);
   
-  if (!info->dirty)
+  if (!info->dirty && !info->children_dirty)
     return;
 
+  info->children_dirty = FALSE;
+
   if (info->type == NODE_TYPE_POPUP)
     {
       in_popup = TRUE;
       popup_accels = info->popup_accels;
     }
 
+  /* only descendants changed, the proxy of this node is up to date */
+  if (!info->dirty)
+    goto recurse_children;
+
 #ifdef DEBUG_UI_MANAGER
   g_print ("update_node name=%s dirty=%d popup %d (", 
 	   info->name, info->dirty, in_popup);
@@ -2407,7 +2538,7 @@ update_node (GtkUIManager *self,
 		     info->proxy = gtk_action_create_menu_item (action);
 		     g_object_ref_sink (info->proxy);
 		     g_signal_connect (info->proxy, "notify::visible",
-		   		       G_CALLBACK (update_smart_separators), NULL);
+		   		       G_CALLBACK (cb_proxy_visible_changed), self);
 		     gtk_widget_set_name (info->proxy, info->name);
 		
 		     gtk_menu_item_set_submenu (GTK_MENU_ITEM (info->proxy), menu);
@@ -2557,8 +2688,8 @@ update_node (GtkUIManager *self,
 	  G_OBJECT_TYPE (info->proxy) != GTK_ACTION_GET_CLASS (action)->menu_item_type)
 	{
 	  g_signal_handlers_disconnect_by_func (info->proxy,
-						G_CALLBACK (update_smart_separators),
-						NULL);  
+						G_CALLBACK (cb_proxy_visible_changed),
+						self);  
 	  gtk_action_disconnect_proxy (info->action, info->proxy);
 	  gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
 				info->proxy);
@@ -2573,8 +2704,12 @@ update_node (GtkUIManager *self,
 	  
 	  if (find_menu_position (node, &menushell, &pos))
             {
-	      info->proxy = gtk_action_create_menu_item (action);
-	      g_object_ref_sink (info->proxy);
+	      info->proxy = get_pooled_proxy (self, action, info->type);
+	      if (info->proxy == NULL)
+		{
+		  info->proxy = gtk_action_create_menu_item (action);
+		  g_object_ref_sink (info->proxy);
+		}
 	      gtk_widget_set_name (info->proxy, info->name);
 	  
 	      gtk_menu_shell_insert (GTK_MENU_SHELL (menushell),
@@ -2584,8 +2719,8 @@ update_node (GtkUIManager *self,
       else
 	{
 	  g_signal_handlers_disconnect_by_func (info->proxy,
-						G_CALLBACK (update_smart_separators),
-						NULL);
+						G_CALLBACK (cb_proxy_visible_changed),
+						self);
 	  gtk_menu_item_set_submenu (GTK_MENU_ITEM (info->proxy), NULL);
 	  gtk_action_connect_proxy (action, info->proxy);
 	}
@@ -2593,7 +2728,7 @@ update_node (GtkUIManager *self,
       if (info->proxy)
         {
           g_signal_connect (info->proxy, "notify::visible",
-			    G_CALLBACK (update_smart_separators), NULL);
+			    G_CALLBACK (cb_proxy_visible_changed), self);
           if (in_popup && !popup_accels)
 	    {
 	      /* don't show accels in popups */
@@ -2609,8 +2744,8 @@ update_node (GtkUIManager *self,
 	  G_OBJECT_TYPE (info->proxy) != GTK_ACTION_GET_CLASS (action)->toolbar_item_type)
 	{
 	  g_signal_handlers_disconnect_by_func (info->proxy,
-						G_CALLBACK (update_smart_separators),
-						NULL);
+						G_CALLBACK (cb_proxy_visible_changed),
+						self);
 	  gtk_action_disconnect_proxy (info->action, info->proxy);
 	  gtk_container_remove (GTK_CONTAINER (info->proxy->parent),
 				info->proxy);
@@ -2625,8 +2760,12 @@ update_node (GtkUIManager *self,
 	  
 	  if (find_toolbar_position (node, &toolbar, &pos))
             {
-	      info->proxy = gtk_action_create_tool_item (action);
-	      g_object_ref_sink (info->proxy);
+	      info->proxy = get_pooled_proxy (self, action, info->type);
+	      if (info->proxy == NULL)
+		{
+		  info->proxy = gtk_action_create_tool_item (action);
+		  g_object_ref_sink (info->proxy);
+		}
 	      gtk_widget_set_name (info->proxy, info->name);
 	      
 	      gtk_toolbar_insert (GTK_TOOLBAR (toolbar),
@@ -2636,15 +2775,15 @@ update_node (GtkUIManager *self,
       else
 	{
 	  g_signal_handlers_disconnect_by_func (info->proxy,
-						G_CALLBACK (update_smart_separators),
-						NULL);
+						G_CALLBACK (cb_proxy_visible_changed),
+						self);
 	  gtk_action_connect_proxy (action, info->proxy);
 	}
 
       if (info->proxy)
         {
           g_signal_connect (info->proxy, "notify::visible",
-			    G_CALLBACK (update_smart_separators), NULL);
+			    G_CALLBACK (cb_proxy_visible_changed), self);
         }
       break;
     case NODE_TYPE_SEPARATOR:
@@ -2749,7 +2888,7 @@ update_node (GtkUIManager *self,
   /* handle cleanup of dead nodes */
   if (node->children == NULL && info->uifiles == NULL)
     {
-      if (info->proxy)
+      if (info->proxy && !pool_proxy (self, info, in_popup))
 	gtk_widget_destroy (info->proxy);
       if (info->extra)
 	gtk_widget_destroy (info->extra);
@@ -2775,7 +2914,9 @@ do_updates (GtkUIManager *self)
    *    the proxy is reconnected to the new action (or a new proxy widget
    *    is created and added to the parent container).
    */
+  self->private_data->updating = TRUE;
   update_node (self, self->private_data->root_node, FALSE, FALSE);
+  self->private_data->updating = FALSE;
 
   self->private_data->update_tag = 0;
 
@@ -2851,14 +2992,47 @@ dirty_all_nodes (GtkUIManager *self)
   queue_update (self);
 }
 
+static gboolean
+dirty_group_traverse_func (GNode   *node,
+			   gpointer data)
+{
+  GtkActionGroup *action_group = data;
+  Node *info = NODE_INFO (node);
+  NodeUIReference *ref;
+
+  if (info->uifiles == NULL)
+    return FALSE;
+
+  ref = info->uifiles->data;
+  if (ref->action_quark != 0 &&
+      gtk_action_group_get_action (action_group, 
+				   g_quark_to_string (ref->action_quark)))
+    mark_node_dirty (node);
+
+  return FALSE;
+}
+
+static void
+dirty_group_nodes (GtkUIManager   *self,
+		   GtkActionGroup *action_group)
+{
+  g_node_traverse (self->private_data->root_node,
+		   G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+		   dirty_group_traverse_func, action_group);
+  queue_update (self);
+}
+
 static void
 mark_node_dirty (GNode *node)
 {
   GNode *p;
 
-  /* FIXME could optimize this */
-  for (p = node; p; p = p->parent)
-    NODE_INFO (p)->dirty = TRUE;  
+  /* ancestors only need to be revisited for the sake of their
+   * children, so update_node() can skip their own proxies
+   */
+  NODE_INFO (node)->dirty = TRUE;
+  for (p = node->parent; p; p = p->parent)
+    NODE_INFO (p)->children_dirty = TRUE;
 }
 
 static const gchar *
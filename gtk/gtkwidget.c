@@ -35,6 +35,7 @@
 #include "gtkintl.h"
 #include "gtkmain.h"
 #include "gtkmarshalers.h"
+#include "gtkmodules.h"
 #include "gtkrc.h"
 #include "gtkselection.h"
 #include "gtksettings.h"
@@ -167,6 +168,22 @@ struct _GtkStateData
   guint		use_forall : 1;
 };
 
+#define GTK_WIDGET_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_WIDGET, GtkWidgetPrivate))
+
+typedef struct _GtkWidgetPrivate GtkWidgetPrivate;
+
+/* The topmost ancestor and the depth of a widget are cached,
+ * and are valid while hierarchy_stamp equals the stamp. Any
+ * parent change bumps the stamp, and the caches are refilled
+ * lazily from the parent's, so most lookups cost one step.
+ */
+struct _GtkWidgetPrivate
+{
+  GtkWidget *toplevel;
+  guint      depth;
+  guint      stamp;
+};
+
 /* --- prototypes --- */
 static void	gtk_widget_class_init		(GtkWidgetClass     *klass);
 static void	gtk_widget_base_class_finalize	(GtkWidgetClass     *klass);
@@ -242,6 +259,8 @@ static AtkObject*	gtk_widget_ref_accessible		(AtkImplementor *implementor);
 static void             gtk_widget_invalidate_widget_windows    (GtkWidget        *widget,
 								 GdkRegion        *region);
 static GdkScreen *      gtk_widget_get_screen_unchecked         (GtkWidget        *widget);
+static void             gtk_widget_invalidate_hierarchy         (void);
+static GtkWidgetPrivate *gtk_widget_get_hierarchy               (GtkWidget        *widget);
 static void		gtk_widget_queue_shallow_draw		(GtkWidget        *widget);
 static gboolean         gtk_widget_real_can_activate_accel      (GtkWidget *widget,
                                                                  guint      signal_id);
@@ -280,11 +299,13 @@ static void gtk_widget_set_usize_internal (GtkWidget *widget,
 					   gint       height);
 static void gtk_widget_get_draw_rectangle (GtkWidget    *widget,
 					   GdkRectangle *rect);
+static void gtk_widget_remove_tick_callbacks (GtkWidget *widget);
 
 
 /* --- variables --- */
 static gpointer         gtk_widget_parent_class = NULL;
 static guint            widget_signals[LAST_SIGNAL] = { 0 };
+static guint            hierarchy_stamp = 1;
 static GtkStyle        *gtk_default_style = NULL;
 static GSList          *colormap_stack = NULL;
 static guint            composite_child_stack = 0;
@@ -309,6 +330,9 @@ static GQuark		quark_mnemonic_labels = 0;
 static GQuark		quark_tooltip_markup = 0;
 static GQuark		quark_has_tooltip = 0;
 static GQuark		quark_tooltip_window = 0;
+static GQuark		quark_tick_callbacks = 0;
+static GQuark		quark_direct_expose = 0;
+static GQuark		quark_direct_motion = 0;
 GParamSpecPool         *_gtk_widget_child_property_pool = NULL;
 GObjectNotifyContext   *_gtk_widget_child_property_notify_context = NULL;
 
@@ -379,6 +403,8 @@ gtk_widget_class_init (GtkWidgetClass *klass)
 
   gtk_widget_parent_class = g_type_class_peek_parent (klass);
 
+  g_type_class_add_private (klass, sizeof (GtkWidgetPrivate));
+
   quark_property_parser = g_quark_from_static_string ("gtk-rc-property-parser");
   quark_aux_info = g_quark_from_static_string ("gtk-aux-info");
   quark_accel_path = g_quark_from_static_string ("gtk-accel-path");
@@ -397,6 +423,9 @@ gtk_widget_class_init (GtkWidgetClass *klass)
   quark_tooltip_markup = g_quark_from_static_string ("gtk-tooltip-markup");
   quark_has_tooltip = g_quark_from_static_string ("gtk-has-tooltip");
   quark_tooltip_window = g_quark_from_static_string ("gtk-tooltip-window");
+  quark_tick_callbacks = g_quark_from_static_string ("gtk-tick-callbacks");
+  quark_direct_expose = g_quark_from_static_string ("gtk-direct-expose");
+  quark_direct_motion = g_quark_from_static_string ("gtk-direct-motion");
 
   style_property_spec_pool = g_param_spec_pool_new (FALSE);
   _gtk_widget_child_property_pool = g_param_spec_pool_new (TRUE);
@@ -2909,6 +2938,7 @@ gtk_widget_unparent (GtkWidget *widget)
     
   old_parent = widget->parent;
   widget->parent = NULL;
+  gtk_widget_invalidate_hierarchy ();
   gtk_widget_set_parent_window (widget, NULL);
   g_signal_emit (widget, widget_signals[PARENT_SET], 0, old_parent);
   if (toplevel)
@@ -3664,6 +3694,156 @@ gtk_widget_draw (GtkWidget          *widget,
     }
 }
 
+#ifdef G_ENABLE_DEBUG
+
+/* GTK_DEBUG=signals keeps per widget type counts and times
+ * of the signals emitted while handling events, resizing and
+ * drawing. Times include nested emissions, e.g. the expose of
+ * a container includes the exposes of its children.
+ */
+typedef struct
+{
+  GType   type;
+  guint   signal_id;
+  guint   n_emissions;
+  guint   n_direct;
+  gdouble elapsed;
+} SignalProfile;
+
+static GHashTable *signal_profiles = NULL;
+static GTimer *signal_profile_timer = NULL;
+
+static guint
+signal_profile_hash (gconstpointer key)
+{
+  const SignalProfile *profile = key;
+
+  return (guint) profile->type ^ (profile->signal_id << 16);
+}
+
+static gboolean
+signal_profile_equal (gconstpointer a,
+		      gconstpointer b)
+{
+  const SignalProfile *pa = a;
+  const SignalProfile *pb = b;
+
+  return pa->type == pb->type && pa->signal_id == pb->signal_id;
+}
+
+static gint
+signal_profile_compare (gconstpointer a,
+			gconstpointer b)
+{
+  const SignalProfile *pa = a;
+  const SignalProfile *pb = b;
+
+  if (pa->elapsed > pb->elapsed)
+    return -1;
+  else if (pa->elapsed < pb->elapsed)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+signal_profiles_report (void)
+{
+  GList *profiles, *l;
+
+  profiles = g_hash_table_get_values (signal_profiles);
+  profiles = g_list_sort (profiles, signal_profile_compare);
+
+  g_printerr ("%-28s %-22s %10s %10s %12s\n",
+	      "type", "signal", "emissions", "direct", "time (ms)");
+  for (l = profiles; l; l = l->next)
+    {
+      SignalProfile *profile = l->data;
+
+      g_printerr ("%-28s %-22s %10u %10u %12.3f\n",
+		  g_type_name (profile->type),
+		  g_signal_name (profile->signal_id),
+		  profile->n_emissions, profile->n_direct,
+		  1000 * profile->elapsed);
+    }
+
+  g_list_free (profiles);
+}
+
+static gdouble
+signal_profile_begin (void)
+{
+  if (G_UNLIKELY (!signal_profile_timer))
+    {
+      signal_profile_timer = g_timer_new ();
+      signal_profiles = g_hash_table_new_full (signal_profile_hash,
+					       signal_profile_equal,
+					       g_free, NULL);
+      g_atexit (signal_profiles_report);
+    }
+
+  return g_timer_elapsed (signal_profile_timer, NULL);
+}
+
+static void
+signal_profile_end (GtkWidget *widget,
+		    guint      signal_id,
+		    gdouble    start,
+		    gboolean   direct)
+{
+  SignalProfile key, *profile;
+
+  key.type = G_OBJECT_TYPE (widget);
+  key.signal_id = signal_id;
+
+  profile = g_hash_table_lookup (signal_profiles, &key);
+  if (!profile)
+    {
+      profile = g_new0 (SignalProfile, 1);
+      profile->type = key.type;
+      profile->signal_id = signal_id;
+      g_hash_table_insert (signal_profiles, profile, profile);
+    }
+
+  profile->n_emissions++;
+  if (direct)
+    profile->n_direct++;
+  profile->elapsed += g_timer_elapsed (signal_profile_timer, NULL) - start;
+}
+
+#define SIGNAL_PROFILE_BEGIN(start)					\
+  G_STMT_START {							\
+    if (G_UNLIKELY (gtk_debug_flags & GTK_DEBUG_SIGNALS))		\
+      start = signal_profile_begin ();					\
+  } G_STMT_END
+
+#define SIGNAL_PROFILE_END(widget, signal_id, start, direct)		\
+  G_STMT_START {							\
+    if (G_UNLIKELY (gtk_debug_flags & GTK_DEBUG_SIGNALS))		\
+      signal_profile_end (widget, signal_id, start, direct);		\
+  } G_STMT_END
+
+#else /* !G_ENABLE_DEBUG */
+
+#define SIGNAL_PROFILE_BEGIN(start) (void) (start)
+#define SIGNAL_PROFILE_END(widget, signal_id, start, direct)
+
+#endif /* G_ENABLE_DEBUG */
+
+/* Emits ::size-request on behalf of the size group code, which
+ * used to look the signal up by name for every request.
+ */
+void
+_gtk_widget_emit_size_request (GtkWidget      *widget,
+			       GtkRequisition *requisition)
+{
+  gdouble start = 0;
+
+  SIGNAL_PROFILE_BEGIN (start);
+  g_signal_emit (widget, widget_signals[SIZE_REQUEST], 0, requisition);
+  SIGNAL_PROFILE_END (widget, widget_signals[SIZE_REQUEST], start, FALSE);
+}
+
 /**
  * gtk_widget_size_request:
  * @widget: a #GtkWidget
@@ -3801,6 +3981,27 @@ gtk_widget_queue_shallow_draw (GtkWidget *widget)
   gdk_region_destroy (region);
 }
 
+/* While a no-window widget whose area gets redrawn in full is
+ * allocating its children, this is the window it draws on and the
+ * area it will invalidate; descendants drawing on the same window
+ * within that area don't need to invalidate anything themselves.
+ */
+static GdkWindow    *allocation_redraw_window = NULL;
+static GdkRectangle  allocation_redraw_area;
+
+static gboolean
+allocation_redrawn (GtkWidget    *widget,
+		    GdkRectangle *area)
+{
+  return (allocation_redraw_window != NULL &&
+	  GTK_WIDGET_NO_WINDOW (widget) &&
+	  widget->window == allocation_redraw_window &&
+	  area->x >= allocation_redraw_area.x &&
+	  area->y >= allocation_redraw_area.y &&
+	  area->x + area->width <= allocation_redraw_area.x + allocation_redraw_area.width &&
+	  area->y + area->height <= allocation_redraw_area.y + allocation_redraw_area.height);
+}
+
 /**
  * gtk_widget_size_allocate:
  * @widget: a #GtkWidget
@@ -3816,9 +4017,14 @@ gtk_widget_size_allocate (GtkWidget	*widget,
   GtkWidgetAuxInfo *aux_info;
   GdkRectangle real_allocation;
   GdkRectangle old_allocation;
+  GdkRectangle redraw_area;
+  GdkWindow *saved_redraw_window;
+  GdkRectangle saved_redraw_area;
   gboolean alloc_needed;
   gboolean size_changed;
   gboolean position_changed;
+  gboolean redrawn;
+  gdouble start = 0;
   
   g_return_if_fail (GTK_IS_WIDGET (widget));
  
@@ -3845,7 +4051,8 @@ gtk_widget_size_allocate (GtkWidget	*widget,
 #endif /* G_ENABLE_DEBUG */
  
   alloc_needed = GTK_WIDGET_ALLOC_NEEDED (widget);
-  if (!GTK_WIDGET_REQUEST_NEEDED (widget))      /* Preserve request/allocate ordering */
+  if (!GTK_WIDGET_REQUEST_NEEDED (widget) &&    /* Preserve request/allocate ordering */
+      !GTK_WIDGET_CHILD_REQUEST_NEEDED (widget))
     GTK_PRIVATE_UNSET_FLAG (widget, GTK_ALLOC_NEEDED);
 
   old_allocation = widget->allocation;
@@ -3877,22 +4084,29 @@ gtk_widget_size_allocate (GtkWidget	*widget,
 
   if (!alloc_needed && !size_changed && !position_changed)
     return;
+
+  gdk_rectangle_union (&old_allocation, &real_allocation, &redraw_area);
+  redrawn = allocation_redrawn (widget, &redraw_area);
+
+  saved_redraw_window = allocation_redraw_window;
+  saved_redraw_area = allocation_redraw_area;
+
+  if (!redrawn && GTK_WIDGET_MAPPED (widget) && GTK_WIDGET_NO_WINDOW (widget) &&
+      GTK_WIDGET_REDRAW_ON_ALLOC (widget) && (size_changed || position_changed))
+    {
+      allocation_redraw_window = widget->window;
+      allocation_redraw_area = redraw_area;
+    }
   
+  SIGNAL_PROFILE_BEGIN (start);
   g_signal_emit (widget, widget_signals[SIZE_ALLOCATE], 0, &real_allocation);
+  SIGNAL_PROFILE_END (widget, widget_signals[SIZE_ALLOCATE], start, FALSE);
 
-  if (GTK_WIDGET_MAPPED (widget))
-    {
-      if (GTK_WIDGET_NO_WINDOW (widget) && GTK_WIDGET_REDRAW_ON_ALLOC (widget) && position_changed)
-	{
-	  /* Invalidate union(old_allaction,widget->allocation) in widget->window
-	   */
-	  GdkRegion *invalidate = gdk_region_rectangle (&widget->allocation);
-	  gdk_region_union_with_rect (invalidate, &old_allocation);
+  allocation_redraw_window = saved_redraw_window;
+  allocation_redraw_area = saved_redraw_area;
 
-	  gdk_window_invalidate_region (widget->window, invalidate, FALSE);
-	  gdk_region_destroy (invalidate);
-	}
-      
+  if (GTK_WIDGET_MAPPED (widget) && !redrawn)
+    {
       if (size_changed)
 	{
 	  if (GTK_WIDGET_REDRAW_ON_ALLOC (widget))
@@ -3900,16 +4114,27 @@ gtk_widget_size_allocate (GtkWidget	*widget,
 	      /* Invalidate union(old_allaction,widget->allocation) in widget->window and descendents owned by widget
 	       */
 	      GdkRegion *invalidate = gdk_region_rectangle (&widget->allocation);
-	      gdk_region_union_with_rect (invalidate, &old_allocation);
+	      gdk_region_union_with_rect (invalidate, &redraw_area);
 
 	      gtk_widget_invalidate_widget_windows (widget, invalidate);
 	      gdk_region_destroy (invalidate);
 	    }
 	}
+      else if (GTK_WIDGET_NO_WINDOW (widget) && GTK_WIDGET_REDRAW_ON_ALLOC (widget) && position_changed)
+	{
+	  /* Invalidate union(old_allaction,widget->allocation) in widget->window
+	   */
+	  GdkRegion *invalidate = gdk_region_rectangle (&widget->allocation);
+	  gdk_region_union_with_rect (invalidate, &redraw_area);
+
+	  gdk_window_invalidate_region (widget->window, invalidate, FALSE);
+	  gdk_region_destroy (invalidate);
+	}
     }
 
   if ((size_changed || position_changed) && widget->parent &&
-      GTK_WIDGET_REALIZED (widget->parent) && GTK_CONTAINER (widget->parent)->reallocate_redraws)
+      GTK_WIDGET_REALIZED (widget->parent) && GTK_CONTAINER (widget->parent)->reallocate_redraws &&
+      !allocation_redrawn (widget->parent, &widget->parent->allocation))
     {
       GdkRegion *invalidate = gdk_region_rectangle (&widget->parent->allocation);
       gtk_widget_invalidate_widget_windows (widget->parent, invalidate);
@@ -3933,28 +4158,20 @@ static GtkWidget *
 gtk_widget_common_ancestor (GtkWidget *widget_a,
 			    GtkWidget *widget_b)
 {
-  GtkWidget *parent_a;
-  GtkWidget *parent_b;
-  gint depth_a = 0;
-  gint depth_b = 0;
-
-  parent_a = widget_a;
-  while (parent_a->parent)
-    {
-      parent_a = parent_a->parent;
-      depth_a++;
-    }
+  GtkWidgetPrivate *priv_a;
+  GtkWidgetPrivate *priv_b;
+  guint depth_a;
+  guint depth_b;
 
-  parent_b = widget_b;
-  while (parent_b->parent)
-    {
-      parent_b = parent_b->parent;
-      depth_b++;
-    }
+  priv_a = gtk_widget_get_hierarchy (widget_a);
+  priv_b = gtk_widget_get_hierarchy (widget_b);
 
-  if (parent_a != parent_b)
+  if (priv_a->toplevel != priv_b->toplevel)
     return NULL;
 
+  depth_a = priv_a->depth;
+  depth_b = priv_b->depth;
+
   while (depth_a > depth_b)
     {
       widget_a = widget_a->parent;
@@ -4637,6 +4854,154 @@ event_window_is_still_viewable (GdkEvent *event)
     }
 }
 
+/* Expose and motion events are the bulk of what a widget
+ * handles, and most widgets only have their class handler for
+ * them. With no handlers connected the class handler is called
+ * directly, saving the marshalling of a full emission.
+ *
+ * GObject doesn't tell whether a class closure was overridden,
+ * so the first event of each type goes through a real emission,
+ * with the class handler temporarily replaced by a probe. If the
+ * probe doesn't run, the class closure is overridden and the type
+ * keeps emitting. The result is stored on the type. Emission hooks
+ * are installed by GTK+ modules, e.g. for accessibility, so there
+ * is no direct call while modules are loaded.
+ */
+typedef gboolean (* WidgetEventFunc) (GtkWidget *widget,
+				      GdkEvent  *event);
+
+enum {
+  DIRECT_DISPATCH_UNKNOWN,
+  DIRECT_DISPATCH_SAFE,
+  DIRECT_DISPATCH_UNSAFE
+};
+
+static WidgetEventFunc probe_event_func = NULL;
+static gboolean        probe_event_func_called = FALSE;
+
+static gboolean
+gtk_widget_probe_event_func (GtkWidget *widget,
+			     GdkEvent  *event)
+{
+  probe_event_func_called = TRUE;
+
+  return probe_event_func (widget, event);
+}
+
+/* Returns the class handler slot of @signal_id if the signal may
+ * be dispatched directly to @widget, along with the quark the
+ * result of probing the type is stored under.
+ */
+static WidgetEventFunc *
+gtk_widget_get_direct_event_slot (GtkWidget *widget,
+				  guint      signal_id,
+				  GQuark    *quark)
+{
+  WidgetEventFunc *slot;
+
+  if (signal_id == widget_signals[EXPOSE_EVENT])
+    {
+      slot = (WidgetEventFunc *) &GTK_WIDGET_GET_CLASS (widget)->expose_event;
+      *quark = quark_direct_expose;
+    }
+  else if (signal_id == widget_signals[MOTION_NOTIFY_EVENT])
+    {
+      slot = (WidgetEventFunc *) &GTK_WIDGET_GET_CLASS (widget)->motion_notify_event;
+      *quark = quark_direct_motion;
+    }
+  else
+    return NULL;
+
+  if (!*slot ||
+      probe_event_func != NULL ||
+      _gtk_modules_loaded () ||
+      g_signal_has_handler_pending (widget, signal_id, 0, TRUE))
+    return NULL;
+
+  return slot;
+}
+
+/* Emits the signal with the class handler replaced by a probe,
+ * and records on the type whether the class handler ran.
+ */
+static void
+gtk_widget_probe_event_signal (GtkWidget       *widget,
+			       guint            signal_id,
+			       GdkEvent        *event,
+			       gboolean        *return_val,
+			       WidgetEventFunc *slot,
+			       GQuark           quark)
+{
+  probe_event_func = *slot;
+  probe_event_func_called = FALSE;
+  *slot = gtk_widget_probe_event_func;
+
+  g_signal_emit (widget, signal_id, 0, event, return_val);
+
+  *slot = probe_event_func;
+  probe_event_func = NULL;
+
+  g_type_set_qdata (G_OBJECT_TYPE (widget), quark,
+		    GUINT_TO_POINTER (probe_event_func_called ?
+				      DIRECT_DISPATCH_SAFE :
+				      DIRECT_DISPATCH_UNSAFE));
+}
+
+/* Emits one of the event signals, recording the time its
+ * handlers take when event dispatch is traced.
+ */
+static void
+gtk_widget_emit_event_signal (GtkWidget *widget,
+			      guint      signal_id,
+			      GdkEvent  *event,
+			      gboolean  *return_val)
+{
+  WidgetEventFunc *slot = NULL;
+  gboolean direct = FALSE;
+  guint32 trace_id = 0;
+  gboolean tracing;
+  gdouble start = 0;
+  GQuark quark;
+  guint state;
+
+  tracing = gdk_trace_is_enabled ();
+  if (G_UNLIKELY (tracing))
+    {
+      trace_id = gdk_trace_get_event_id (event);
+      gdk_trace_record (GDK_TRACE_SIGNAL_BEGIN, trace_id, signal_id);
+    }
+
+  SIGNAL_PROFILE_BEGIN (start);
+
+  if (return_val)
+    slot = gtk_widget_get_direct_event_slot (widget, signal_id, &quark);
+
+  if (slot)
+    {
+      state = GPOINTER_TO_UINT (g_type_get_qdata (G_OBJECT_TYPE (widget), quark));
+
+      if (state == DIRECT_DISPATCH_SAFE)
+	{
+	  *return_val = (*slot) (widget, event);
+	  direct = TRUE;
+	}
+      else if (state == DIRECT_DISPATCH_UNKNOWN)
+	gtk_widget_probe_event_signal (widget, signal_id, event, return_val,
+				       slot, quark);
+      else
+	g_signal_emit (widget, signal_id, 0, event, return_val);
+    }
+  else if (return_val)
+    g_signal_emit (widget, signal_id, 0, event, return_val);
+  else
+    g_signal_emit (widget, signal_id, 0, event);
+
+  SIGNAL_PROFILE_END (widget, signal_id, start, direct);
+
+  if (G_UNLIKELY (tracing))
+    gdk_trace_record (GDK_TRACE_SIGNAL_END, trace_id, signal_id);
+}
+
 static gint
 gtk_widget_event_internal (GtkWidget *widget,
 			   GdkEvent  *event)
@@ -4653,7 +5018,7 @@ gtk_widget_event_internal (GtkWidget *widget,
 
   g_object_ref (widget);
 
-  g_signal_emit (widget, widget_signals[EVENT], 0, event, &return_val);
+  gtk_widget_emit_event_signal (widget, widget_signals[EVENT], event, &return_val);
   return_val |= !WIDGET_REALIZED_FOR_EVENT (widget, event);
   if (!return_val)
     {
@@ -4758,10 +5123,10 @@ gtk_widget_event_internal (GtkWidget *widget,
 	  break;
 	}
       if (signal_num != -1)
-	g_signal_emit (widget, widget_signals[signal_num], 0, event, &return_val);
+	gtk_widget_emit_event_signal (widget, widget_signals[signal_num], event, &return_val);
     }
   if (WIDGET_REALIZED_FOR_EVENT (widget, event))
-    g_signal_emit (widget, widget_signals[EVENT_AFTER], 0, event);
+    gtk_widget_emit_event_signal (widget, widget_signals[EVENT_AFTER], event, NULL);
   else
     return_val = TRUE;
 
@@ -5600,6 +5965,7 @@ gtk_widget_set_parent (GtkWidget *widget,
 
   g_object_ref_sink (widget);
   widget->parent = parent;
+  gtk_widget_invalidate_hierarchy ();
 
   if (GTK_WIDGET_STATE (parent) != GTK_STATE_NORMAL)
     data.state = GTK_WIDGET_STATE (parent);
@@ -7309,6 +7675,39 @@ gtk_widget_set_extension_events (GtkWidget *widget,
   g_object_notify (G_OBJECT (widget), "extension-events");
 }
 
+static void
+gtk_widget_invalidate_hierarchy (void)
+{
+  if (++hierarchy_stamp == 0)
+    hierarchy_stamp = 1;
+}
+
+static GtkWidgetPrivate *
+gtk_widget_get_hierarchy (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = GTK_WIDGET_GET_PRIVATE (widget);
+
+  if (priv->stamp != hierarchy_stamp)
+    {
+      if (widget->parent)
+	{
+	  GtkWidgetPrivate *parent_priv = gtk_widget_get_hierarchy (widget->parent);
+
+	  priv->toplevel = parent_priv->toplevel;
+	  priv->depth = parent_priv->depth + 1;
+	}
+      else
+	{
+	  priv->toplevel = widget;
+	  priv->depth = 0;
+	}
+
+      priv->stamp = hierarchy_stamp;
+    }
+
+  return priv;
+}
+
 /**
  * gtk_widget_get_toplevel:
  * @widget: a #GtkWidget
@@ -7346,10 +7745,7 @@ gtk_widget_get_toplevel (GtkWidget *widget)
 {
   g_return_val_if_fail (GTK_IS_WIDGET (widget), NULL);
   
-  while (widget->parent)
-    widget = widget->parent;
-  
-  return widget;
+  return gtk_widget_get_hierarchy (widget)->toplevel;
 }
 
 /**
@@ -7573,17 +7969,26 @@ gboolean
 gtk_widget_is_ancestor (GtkWidget *widget,
 			GtkWidget *ancestor)
 {
+  GtkWidgetPrivate *priv, *ancestor_priv;
+  guint depth;
+
   g_return_val_if_fail (GTK_IS_WIDGET (widget), FALSE);
   g_return_val_if_fail (ancestor != NULL, FALSE);
   
-  while (widget)
-    {
-      if (widget->parent == ancestor)
-	return TRUE;
-      widget = widget->parent;
-    }
+  priv = gtk_widget_get_hierarchy (widget);
+  ancestor_priv = gtk_widget_get_hierarchy (ancestor);
+
+  if (priv->toplevel != ancestor_priv->toplevel ||
+      priv->depth <= ancestor_priv->depth)
+    return FALSE;
+
+  /* Only the ancestor of @widget at the depth of @ancestor
+   * can be it.
+   */
+  for (depth = priv->depth; depth > ancestor_priv->depth; depth--)
+    widget = widget->parent;
   
-  return FALSE;
+  return widget == ancestor;
 }
 
 static GQuark quark_composite_name = 0;
@@ -7918,6 +8323,8 @@ gtk_widget_real_destroy (GtkObject *object)
 
   /* Callers of add_mnemonic_label() should disconnect on ::destroy */
   g_object_set_qdata (G_OBJECT (widget), quark_mnemonic_labels, NULL);
+
+  gtk_widget_remove_tick_callbacks (widget);
   
   gtk_grab_remove (widget);
   
@@ -10254,5 +10661,182 @@ gtk_widget_get_window (GtkWidget *widget)
   return widget->window;
 }
 
+typedef struct
+{
+  GtkWidget       *widget;
+  GtkTickCallback  callback;
+  gpointer         data;
+  GDestroyNotify   notify;
+  GdkDisplay      *display;
+  guint            handler_id;
+  guint            removed : 1;
+} TickCallback;
+
+static gboolean
+gtk_widget_tick (GdkDisplay *display,
+		 gpointer    data)
+{
+  TickCallback *tick = data;
+  GtkWidget *widget = tick->widget;
+  gboolean again;
+
+  g_object_ref (widget);
+
+  again = tick->callback (widget, tick->data);
+
+  /* The callback may have removed itself, or destroyed the widget
+   */
+  if (!again && !tick->removed)
+    {
+      tick->removed = TRUE;
+      gdk_display_remove_frame_handler (display, tick->handler_id);
+    }
+
+  g_object_unref (widget);
+
+  return again;
+}
+
+/* Called by GDK when the frame handler goes away, either because
+ * it was removed or because the display was closed.
+ */
+static void
+tick_callback_free (gpointer data)
+{
+  TickCallback *tick = data;
+  GSList *ticks;
+
+  if (tick->widget)
+    {
+      ticks = g_object_steal_qdata (G_OBJECT (tick->widget), quark_tick_callbacks);
+      ticks = g_slist_remove (ticks, tick);
+      g_object_set_qdata (G_OBJECT (tick->widget), quark_tick_callbacks, ticks);
+    }
+
+  if (tick->notify)
+    tick->notify (tick->data);
+
+  g_slice_free (TickCallback, tick);
+}
+
+/**
+ * gtk_widget_add_tick_callback:
+ * @widget: a #GtkWidget
+ * @callback: function to call for updating animations
+ * @data: data to pass to @callback
+ * @notify: function to call to free @data when the callback is removed,
+ *   or %NULL
+ *
+ * Queues an animation update for @widget. @callback is called once
+ * at the start of each frame of the display of @widget, before
+ * resizes and redraws are processed, for as long as it returns
+ * %TRUE. Use gtk_widget_queue_draw() or gtk_widget_queue_resize()
+ * from @callback to have the new state of the animation shown in
+ * the same frame.
+ *
+ * Unlike timeouts, tick callbacks are paced to the frame interval
+ * of the display (see gdk_display_set_frame_interval()), and all
+ * animations running on a display are updated together.
+ *
+ * The callback is removed when it returns %FALSE, when
+ * gtk_widget_remove_tick_callback() is called, or when @widget
+ * is destroyed.
+ *
+ * Return value: an ID for the callback, to be passed to
+ *   gtk_widget_remove_tick_callback()
+ *
+ * Since: 2.16
+ */
+guint
+gtk_widget_add_tick_callback (GtkWidget       *widget,
+			      GtkTickCallback  callback,
+			      gpointer         data,
+			      GDestroyNotify   notify)
+{
+  TickCallback *tick;
+  GSList *ticks;
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), 0);
+  g_return_val_if_fail (callback != NULL, 0);
+
+  tick = g_slice_new (TickCallback);
+  tick->widget = widget;
+  tick->callback = callback;
+  tick->data = data;
+  tick->notify = notify;
+  tick->removed = FALSE;
+  tick->display = gtk_widget_get_display (widget);
+  tick->handler_id = gdk_display_add_frame_handler (tick->display,
+						    GDK_FRAME_PHASE_UPDATE,
+						    gtk_widget_tick, tick,
+						    tick_callback_free);
+
+  ticks = g_object_steal_qdata (G_OBJECT (widget), quark_tick_callbacks);
+  ticks = g_slist_prepend (ticks, tick);
+  g_object_set_qdata (G_OBJECT (widget), quark_tick_callbacks, ticks);
+
+  gdk_display_queue_frame_handler (tick->display, tick->handler_id);
+
+  return tick->handler_id;
+}
+
+/**
+ * gtk_widget_remove_tick_callback:
+ * @widget: a #GtkWidget
+ * @id: an ID returned by gtk_widget_add_tick_callback()
+ *
+ * Removes a tick callback previously added with
+ * gtk_widget_add_tick_callback().
+ *
+ * Since: 2.16
+ */
+void
+gtk_widget_remove_tick_callback (GtkWidget *widget,
+				 guint      id)
+{
+  GSList *l;
+
+  g_return_if_fail (GTK_IS_WIDGET (widget));
+
+  for (l = g_object_get_qdata (G_OBJECT (widget), quark_tick_callbacks); l; l = l->next)
+    {
+      TickCallback *tick = l->data;
+
+      if (tick->handler_id == id && !tick->removed)
+	{
+	  tick->removed = TRUE;
+	  gdk_display_remove_frame_handler (tick->display, id);
+	  return;
+	}
+    }
+
+  g_warning ("%s: no tick callback with id %u on widget %p",
+	     G_STRLOC, id, widget);
+}
+
+static void
+gtk_widget_remove_tick_callbacks (GtkWidget *widget)
+{
+  GSList *ticks, *l;
+
+  /* If a frame is in progress, GDK frees the handlers only at
+   * the end of it, when the widget may be gone already; so
+   * detach the callbacks from the widget first.
+   */
+  ticks = g_object_steal_qdata (G_OBJECT (widget), quark_tick_callbacks);
+  for (l = ticks; l; l = l->next)
+    {
+      TickCallback *tick = l->data;
+
+      tick->widget = NULL;
+      if (!tick->removed)
+	{
+	  tick->removed = TRUE;
+	  gdk_display_remove_frame_handler (tick->display, tick->handler_id);
+	}
+    }
+  g_slist_free (ticks);
+}
+
 #define __GTK_WIDGET_C__
 #include "gtkaliasdef.c"
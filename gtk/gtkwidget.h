@@ -148,6 +148,8 @@ typedef struct _GtkTooltip         GtkTooltip;
 typedef struct _GtkWindow          GtkWindow;
 typedef void     (*GtkCallback)        (GtkWidget        *widget,
 					gpointer	  data);
+typedef gboolean (*GtkTickCallback)    (GtkWidget        *widget,
+					gpointer	  data);
 
 /* A requisition is a desired amount of space which a
  *  widget may request.
@@ -811,6 +813,13 @@ void       gtk_widget_set_has_tooltip       (GtkWidget   *widget,
 					     gboolean     has_tooltip);
 gboolean   gtk_widget_get_has_tooltip       (GtkWidget   *widget);
 
+guint      gtk_widget_add_tick_callback     (GtkWidget       *widget,
+                                             GtkTickCallback  callback,
+                                             gpointer         data,
+                                             GDestroyNotify   notify);
+void       gtk_widget_remove_tick_callback  (GtkWidget       *widget,
+                                             guint            id);
+
 GType           gtk_requisition_get_type (void) G_GNUC_CONST;
 GtkRequisition *gtk_requisition_copy     (const GtkRequisition *requisition);
 void            gtk_requisition_free     (GtkRequisition       *requisition);
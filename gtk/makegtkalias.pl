@@ -73,7 +73,7 @@ while (<>) {
       next;
   }
 
-  if ($_ =~ /^\#ifdef\s+(INCLUDE_VARIABLES|ALL_FILES)/)
+  if ($_ =~ /^\#ifdef\s+(INCLUDE_VARIABLES|INCLUDE_INTERNAL_SYMBOLS|ALL_FILES)/)
   {
       $in_skipped_section = 1;
   }
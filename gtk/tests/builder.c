@@ -19,13 +19,19 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <string.h>
+#include <unistd.h>
+#include <utime.h>
 #include <libintl.h>
 #include <locale.h>
 #include <math.h>
 
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
+#include "gtk/gtkbuilderprivate.h"
 
 /* Copied from gtkiconfactory.c; keep in sync! */
 struct _GtkIconSet
@@ -2430,6 +2436,269 @@ test_menus (void)
 }
 
 
+static void
+count_connections (GtkBuilder    *builder,
+                   GObject       *object,
+                   const gchar   *signal_name,
+                   const gchar   *handler_name,
+                   GObject       *connect_object,
+                   GConnectFlags  flags,
+                   gpointer       user_data)
+{
+  gint *connections = user_data;
+
+  g_assert (GTK_IS_BUTTON (object));
+  g_assert_cmpstr (handler_name, ==, "on_ok_clicked");
+  (*connections)++;
+}
+
+static void
+test_lazy (void)
+{
+  GtkBuilder *builder;
+  const gchar buffer[] =
+    "<interface>"
+    "  <object class=\"GtkListStore\" id=\"liststore1\" lazy=\"yes\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "  </object>"
+    "  <object class=\"GtkDialog\" id=\"dialog1\" lazy=\"yes\">"
+    "    <child internal-child=\"vbox\">"
+    "      <object class=\"GtkVBox\" id=\"dialog1-vbox\">"
+    "        <child>"
+    "          <object class=\"GtkButton\" id=\"ok_button\">"
+    "            <signal name=\"clicked\" handler=\"on_ok_clicked\"/>"
+    "          </object>"
+    "        </child>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <child>"
+    "      <object class=\"GtkNotebook\" id=\"notebook1\">"
+    "        <child>"
+    "          <object class=\"GtkTreeView\" id=\"treeview1\">"
+    "            <property name=\"visible\">True</property>"
+    "            <property name=\"model\">liststore1</property>"
+    "          </object>"
+    "        </child>"
+    "        <child>"
+    "          <object class=\"GtkLabel\" id=\"label1\" lazy=\"yes\">"
+    "            <property name=\"visible\">True</property>"
+    "            <property name=\"label\">first</property>"
+    "          </object>"
+    "        </child>"
+    "        <child type=\"tab\">"
+    "          <object class=\"GtkLabel\" id=\"tab1\">"
+    "            <property name=\"label\">First</property>"
+    "          </object>"
+    "        </child>"
+    "        <child>"
+    "          <object class=\"GtkVBox\" id=\"vbox1\" lazy=\"yes\">"
+    "            <property name=\"visible\">True</property>"
+    "            <child>"
+    "              <object class=\"GtkLabel\" id=\"label2\">"
+    "                <property name=\"visible\">True</property>"
+    "              </object>"
+    "            </child>"
+    "          </object>"
+    "        </child>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  GObject *window, *notebook, *treeview, *dialog, *button, *label, *vbox;
+  GtkWidget *page;
+  GSList *objects;
+  gint connections = 0;
+
+  builder = builder_new_from_string (buffer, -1, NULL);
+
+  /* The model is needed by the tree view right away */
+  treeview = gtk_builder_get_object (builder, "treeview1");
+  g_assert (GTK_IS_LIST_STORE (gtk_tree_view_get_model (GTK_TREE_VIEW (treeview))));
+
+  objects = gtk_builder_get_objects (builder);
+  g_assert_cmpint (g_slist_length (objects), ==, 5);
+  g_slist_free (objects);
+
+  gtk_builder_connect_signals_full (builder, count_connections, &connections);
+  g_assert_cmpint (connections, ==, 0);
+
+  /* Asking for a child of a lazy object constructs all of it */
+  button = gtk_builder_get_object (builder, "ok_button");
+  g_assert (GTK_IS_BUTTON (button));
+  dialog = gtk_builder_get_object (builder, "dialog1");
+  g_assert (GTK_IS_DIALOG (dialog));
+  g_assert (gtk_widget_get_toplevel (GTK_WIDGET (button)) == GTK_WIDGET (dialog));
+  g_assert_cmpint (connections, ==, 1);
+
+  window = gtk_builder_get_object (builder, "window1");
+  notebook = gtk_builder_get_object (builder, "notebook1");
+  g_assert_cmpint (gtk_notebook_get_n_pages (GTK_NOTEBOOK (notebook)), ==, 3);
+
+  /* Lazy children are constructed into their placeholder */
+  page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook), 1);
+  g_assert_cmpstr (gtk_notebook_get_tab_label_text (GTK_NOTEBOOK (notebook), page),
+                   ==, "First");
+  g_assert (GTK_IS_ALIGNMENT (page));
+  g_assert (GTK_BIN (page)->child == NULL);
+  label = gtk_builder_get_object (builder, "label1");
+  g_assert (GTK_IS_LABEL (label));
+  g_assert (GTK_BIN (page)->child == GTK_WIDGET (label));
+  g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, "first");
+
+  /* ...or when the placeholder is mapped */
+  page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook), 2);
+  g_assert (GTK_IS_ALIGNMENT (page));
+  g_assert (GTK_BIN (page)->child == NULL);
+  gtk_widget_show_all (GTK_WIDGET (window));
+  gtk_notebook_set_current_page (GTK_NOTEBOOK (notebook), 2);
+  vbox = G_OBJECT (GTK_BIN (page)->child);
+  g_assert (GTK_IS_VBOX (vbox));
+  g_assert (GTK_WIDGET_MAPPED (vbox));
+  g_assert (gtk_builder_get_object (builder, "vbox1") == vbox);
+  g_assert (GTK_IS_LABEL (gtk_builder_get_object (builder, "label2")));
+
+  gtk_widget_destroy (GTK_WIDGET (window));
+  gtk_widget_destroy (GTK_WIDGET (dialog));
+  g_object_unref (builder);
+}
+
+static gchar *
+write_ui_file (const gchar *contents)
+{
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp ("builder-XXXXXX.ui", &filename, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+
+  g_assert (g_file_set_contents (filename, contents, -1, NULL));
+
+  return filename;
+}
+
+static void
+check_cached_objects (GtkBuilder  *builder,
+                      const gchar *label_text)
+{
+  GObject *window, *label, *liststore;
+  GtkTreeIter iter;
+  gchar *text;
+
+  window = gtk_builder_get_object (builder, "window1");
+  g_assert (GTK_IS_WINDOW (window));
+  g_assert_cmpstr (gtk_window_get_title (GTK_WINDOW (window)), ==, "Cached & Quick");
+
+  label = gtk_builder_get_object (builder, "label1");
+  g_assert (GTK_IS_LABEL (label));
+  g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, label_text);
+  g_assert (GTK_WIDGET (label)->parent == GTK_WIDGET (window));
+
+  liststore = gtk_builder_get_object (builder, "liststore1");
+  g_assert (GTK_IS_LIST_STORE (liststore));
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (liststore), &iter));
+  gtk_tree_model_get (GTK_TREE_MODEL (liststore), &iter, 0, &text, -1);
+  g_assert_cmpstr (text, ==, "John");
+  g_free (text);
+  g_assert (!gtk_tree_model_iter_next (GTK_TREE_MODEL (liststore), &iter));
+
+  gtk_widget_destroy (GTK_WIDGET (window));
+}
+
+static void
+test_cache (void)
+{
+  const gchar buffer[] =
+    "<interface>"
+    "  <object class=\"GtkListStore\" id=\"liststore1\">"
+    "    <columns>"
+    "      <column type=\"gchararray\"/>"
+    "    </columns>"
+    "    <data>"
+    "      <row>"
+    "        <col id=\"0\">John</col>"
+    "      </row>"
+    "    </data>"
+    "  </object>"
+    "  <object class=\"GtkWindow\" id=\"window1\">"
+    "    <property name=\"title\">Cached &amp; Quick</property>"
+    "    <child>"
+    "      <object class=\"GtkLabel\" id=\"label1\">"
+    "        <property name=\"label\">first</property>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder;
+  GError *error = NULL;
+  struct stat statbuf;
+  struct utimbuf times;
+  gchar *filename, *cache_file, *changed;
+
+  filename = write_ui_file (buffer);
+  cache_file = g_strconcat (filename, ".cache", NULL);
+
+  g_assert (_gtk_builder_compile_file (filename, cache_file, &error));
+  g_assert (error == NULL);
+  g_assert (g_file_test (cache_file, G_FILE_TEST_IS_REGULAR));
+
+  /* Change the text without changing size or mtime, so the
+   * objects below can only come from the cache
+   */
+  g_assert (g_stat (filename, &statbuf) == 0);
+  changed = g_strdup (buffer);
+  memcpy (strstr (changed, "first"), "other", 5);
+  g_assert (g_file_set_contents (filename, changed, -1, NULL));
+  times.actime = statbuf.st_atime;
+  times.modtime = statbuf.st_mtime;
+  g_assert (utime (filename, &times) == 0);
+
+  builder = gtk_builder_new ();
+  g_assert (gtk_builder_add_from_file (builder, filename, &error));
+  check_cached_objects (builder, "first");
+  g_object_unref (builder);
+
+  /* The second load reuses the markup of the first one */
+  builder = gtk_builder_new ();
+  g_assert (gtk_builder_add_from_file (builder, filename, &error));
+  check_cached_objects (builder, "first");
+  g_object_unref (builder);
+
+  /* A cache file can be loaded by itself */
+  builder = gtk_builder_new ();
+  g_assert (gtk_builder_add_from_file (builder, cache_file, &error));
+  check_cached_objects (builder, "first");
+  g_object_unref (builder);
+
+  /* Once the file is modified, it is parsed again */
+  g_unlink (cache_file);
+  times.modtime = statbuf.st_mtime + 1;
+  g_assert (utime (filename, &times) == 0);
+
+  builder = gtk_builder_new ();
+  g_assert (gtk_builder_add_from_file (builder, filename, &error));
+  check_cached_objects (builder, "other");
+  g_object_unref (builder);
+
+  g_assert (g_file_set_contents (filename, "<child/>", -1, NULL));
+  g_assert (!_gtk_builder_compile_file (filename, cache_file, &error));
+  g_assert (g_error_matches (error,
+                             GTK_BUILDER_ERROR,
+                             GTK_BUILDER_ERROR_UNHANDLED_TAG));
+  g_assert (!g_file_test (cache_file, G_FILE_TEST_EXISTS));
+  g_error_free (error);
+
+  g_unlink (filename);
+  g_free (changed);
+  g_free (cache_file);
+  g_free (filename);
+}
+
+
 static void 
 test_file (const gchar *filename)
 {
@@ -2516,6 +2785,8 @@ main (int argc, char **argv)
   g_test_add_func ("/Builder/Requires", test_requires);
   g_test_add_func ("/Builder/AddObjects", test_add_objects);
   g_test_add_func ("/Builder/Menus", test_menus);
+  g_test_add_func ("/Builder/Cache", test_cache);
+  g_test_add_func ("/Builder/Lazy", test_lazy);
 
   return g_test_run();
 }
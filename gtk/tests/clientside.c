@@ -0,0 +1,481 @@
+/* Client-side window tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+
+/* GDK only routes events that come from the X server, so the
+ * events are sent to the X window of the toplevel, and come
+ * back to us.
+ */
+static void
+send_pointer_event (GtkWidget *toplevel,
+                    gint       type,
+                    gint       x,
+                    gint       y,
+                    guint      state,
+                    guint      button)
+{
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  XEvent xevent = { 0, };
+
+  xevent.type = type;
+  xevent.xany.display = xdisplay;
+  xevent.xany.window = GDK_WINDOW_XID (toplevel->window);
+
+  switch (type)
+    {
+    case MotionNotify:
+      xevent.xmotion.root = DefaultRootWindow (xdisplay);
+      xevent.xmotion.time = CurrentTime;
+      xevent.xmotion.x = xevent.xmotion.x_root = x;
+      xevent.xmotion.y = xevent.xmotion.y_root = y;
+      xevent.xmotion.state = state;
+      xevent.xmotion.same_screen = True;
+      break;
+    case ButtonPress:
+    case ButtonRelease:
+      xevent.xbutton.root = DefaultRootWindow (xdisplay);
+      xevent.xbutton.time = CurrentTime;
+      xevent.xbutton.x = xevent.xbutton.x_root = x;
+      xevent.xbutton.y = xevent.xbutton.y_root = y;
+      xevent.xbutton.state = state;
+      xevent.xbutton.button = button;
+      xevent.xbutton.same_screen = True;
+      break;
+    case EnterNotify:
+    case LeaveNotify:
+      xevent.xcrossing.root = DefaultRootWindow (xdisplay);
+      xevent.xcrossing.time = CurrentTime;
+      xevent.xcrossing.x = xevent.xcrossing.x_root = x;
+      xevent.xcrossing.y = xevent.xcrossing.y_root = y;
+      xevent.xcrossing.mode = NotifyNormal;
+      xevent.xcrossing.detail = NotifyAncestor;
+      xevent.xcrossing.same_screen = True;
+      xevent.xcrossing.state = state;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  XSendEvent (xdisplay, xevent.xany.window, False, 0, &xevent);
+}
+
+static void
+process_events (void)
+{
+  gdk_display_sync (gdk_display_get_default ());
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+  gdk_window_process_all_updates ();
+}
+
+/* Number of X children of the X window of @widget */
+static guint
+count_x_children (GtkWidget *widget)
+{
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  Window root, parent, *children;
+  guint n_children;
+
+  XQueryTree (xdisplay, GDK_WINDOW_XID (widget->window),
+              &root, &parent, &children, &n_children);
+  if (children)
+    XFree (children);
+
+  return n_children;
+}
+
+static gboolean
+record_event (GtkWidget *widget,
+              GdkEvent  *event,
+              GString   *log)
+{
+  const gchar *name = gtk_widget_get_name (widget);
+
+  switch (event->type)
+    {
+    case GDK_ENTER_NOTIFY:
+      g_string_append_printf (log, "enter %s;", name);
+      break;
+    case GDK_LEAVE_NOTIFY:
+      g_string_append_printf (log, "leave %s;", name);
+      break;
+    case GDK_MOTION_NOTIFY:
+      g_string_append_printf (log, "motion %s %d;", name, (gint) event->motion.x);
+      break;
+    case GDK_BUTTON_PRESS:
+      g_string_append_printf (log, "press %s;", name);
+      break;
+    case GDK_BUTTON_RELEASE:
+      g_string_append_printf (log, "release %s %d;", name, (gint) event->button.x);
+      break;
+    default:
+      break;
+    }
+
+  return FALSE;
+}
+
+static GtkWidget *
+create_event_box (const gchar *name,
+                  GString     *log)
+{
+  GtkWidget *box;
+
+  box = gtk_event_box_new ();
+  gtk_widget_set_name (box, name);
+  gtk_widget_set_size_request (box, 100, 100);
+  gtk_widget_add_events (box, GDK_POINTER_MOTION_MASK);
+  g_signal_connect (box, "enter-notify-event", G_CALLBACK (record_event), log);
+  g_signal_connect (box, "leave-notify-event", G_CALLBACK (record_event), log);
+  g_signal_connect (box, "motion-notify-event", G_CALLBACK (record_event), log);
+  g_signal_connect (box, "button-press-event", G_CALLBACK (record_event), log);
+  g_signal_connect (box, "button-release-event", G_CALLBACK (record_event), log);
+
+  return box;
+}
+
+/* A toplevel with two event boxes side by side, 100 pixels each */
+static GtkWidget *
+create_toplevel (GString    *log,
+                 GtkWidget **left,
+                 GtkWidget **right)
+{
+  GtkWidget *window, *hbox;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  hbox = gtk_hbox_new (TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (window), hbox);
+
+  *left = create_event_box ("left", log);
+  gtk_box_pack_start (GTK_BOX (hbox), *left, TRUE, TRUE, 0);
+  *right = create_event_box ("right", log);
+  gtk_box_pack_start (GTK_BOX (hbox), *right, TRUE, TRUE, 0);
+
+  gtk_widget_show_all (window);
+  process_events ();
+
+  return window;
+}
+
+static void
+test_crossing (void)
+{
+  GtkWidget *window, *left, *right;
+  GString *log;
+
+  log = g_string_new (NULL);
+  window = create_toplevel (log, &left, &right);
+
+  /* the event boxes have no X windows of their own, the
+   * only child is the focus window of the toplevel
+   */
+  g_assert_cmpuint (count_x_children (window), ==, 1);
+
+  send_pointer_event (window, EnterNotify, 50, 50, 0, 0);
+  process_events ();
+  g_assert_cmpstr (log->str, ==, "enter left;");
+  g_string_truncate (log, 0);
+
+  send_pointer_event (window, MotionNotify, 150, 50, 0, 0);
+  process_events ();
+  g_assert_cmpstr (log->str, ==, "leave left;enter right;motion right 50;");
+  g_string_truncate (log, 0);
+
+  send_pointer_event (window, LeaveNotify, 250, 50, 0, 0);
+  process_events ();
+  g_assert_cmpstr (log->str, ==, "leave right;");
+
+  gtk_widget_destroy (window);
+  g_string_free (log, TRUE);
+}
+
+static void
+test_implicit_grab (void)
+{
+  GtkWidget *window, *left, *right;
+  GString *log;
+
+  log = g_string_new (NULL);
+  window = create_toplevel (log, &left, &right);
+
+  send_pointer_event (window, EnterNotify, 50, 50, 0, 0);
+  send_pointer_event (window, ButtonPress, 50, 50, 0, 1);
+  process_events ();
+  g_string_truncate (log, 0);
+
+  /* while the button is down, the events go to the window
+   * it was pressed in, in its coordinates
+   */
+  send_pointer_event (window, MotionNotify, 150, 50, GDK_BUTTON1_MASK, 0);
+  send_pointer_event (window, ButtonRelease, 150, 50, GDK_BUTTON1_MASK, 1);
+  process_events ();
+  g_assert (g_str_has_prefix (log->str, "motion left 150;"));
+  g_assert (strstr (log->str, "release left 150;") != NULL);
+  g_assert (strstr (log->str, "motion right") == NULL);
+  g_assert (strstr (log->str, "release right") == NULL);
+  g_string_truncate (log, 0);
+
+  /* and after the release, to the window under the pointer */
+  send_pointer_event (window, MotionNotify, 160, 50, 0, 0);
+  process_events ();
+  g_assert (g_str_has_suffix (log->str, "motion right 60;"));
+
+  gtk_widget_destroy (window);
+  g_string_free (log, TRUE);
+}
+
+static void
+test_reparent (void)
+{
+  GtkWidget *window1, *window2, *left, *right, *hbox;
+  GString *log;
+
+  log = g_string_new (NULL);
+  window1 = create_toplevel (log, &left, &right);
+
+  window2 = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  hbox = gtk_hbox_new (TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (window2), hbox);
+  gtk_widget_show_all (window2);
+  process_events ();
+
+  gtk_widget_reparent (right, hbox);
+  process_events ();
+
+  g_assert (gdk_window_get_toplevel (right->window) == window2->window);
+  g_assert_cmpuint (count_x_children (window2), ==, 1);
+
+  /* the events of the new toplevel go to the event box... */
+  send_pointer_event (window2, EnterNotify, 50, 50, 0, 0);
+  send_pointer_event (window2, MotionNotify, 60, 50, 0, 0);
+  process_events ();
+  g_assert_cmpstr (log->str, ==, "enter right;motion right 60;");
+  g_string_truncate (log, 0);
+
+  /* ...and those of the old one don't */
+  send_pointer_event (window1, EnterNotify, 150, 50, 0, 0);
+  send_pointer_event (window1, MotionNotify, 160, 50, 0, 0);
+  process_events ();
+  g_assert (strstr (log->str, "right") == NULL);
+
+  gtk_widget_destroy (window1);
+  gtk_widget_destroy (window2);
+  g_string_free (log, TRUE);
+}
+
+static gulong
+get_pixel (GdkDrawable *drawable,
+           gint         x,
+           gint         y)
+{
+  GdkImage *image;
+  gulong pixel;
+
+  image = gdk_drawable_get_image (drawable, x, y, 1, 1);
+  pixel = gdk_image_get_pixel (image, 0, 0);
+  g_object_unref (image);
+
+  return pixel;
+}
+
+static void
+test_draw_clipping (void)
+{
+  GdkWindowAttr attributes;
+  GdkWindow *window, *child;
+  GdkColormap *colormap;
+  GdkColor red = { 0, 0xffff, 0, 0 };
+  GdkColor blue = { 0, 0, 0, 0xffff };
+  GdkGC *gc;
+
+  colormap = gdk_screen_get_system_colormap (gdk_screen_get_default ());
+  gdk_rgb_find_color (colormap, &red);
+  gdk_rgb_find_color (colormap, &blue);
+
+  attributes.window_type = GDK_WINDOW_TOPLEVEL;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.width = 100;
+  attributes.height = 100;
+  attributes.event_mask = GDK_EXPOSURE_MASK;
+  attributes.override_redirect = TRUE;
+  window = gdk_window_new (NULL, &attributes, GDK_WA_NOREDIR);
+
+  attributes.window_type = GDK_WINDOW_CHILD;
+  attributes.x = 0;
+  attributes.y = 0;
+  attributes.width = 50;
+  child = gdk_window_new (window, &attributes, GDK_WA_X | GDK_WA_Y);
+
+  gdk_window_show (child);
+  gdk_window_show (window);
+  process_events ();
+
+  gc = gdk_gc_new (window);
+  gdk_gc_set_foreground (gc, &red);
+  gdk_draw_rectangle (child, gc, TRUE, 0, 0, 50, 100);
+
+  /* drawing to the parent leaves the child alone... */
+  gdk_gc_set_foreground (gc, &blue);
+  gdk_draw_rectangle (window, gc, TRUE, 0, 0, 100, 100);
+  g_assert_cmphex (get_pixel (window, 25, 50), ==, red.pixel);
+  g_assert_cmphex (get_pixel (window, 75, 50), ==, blue.pixel);
+
+  /* ...unless the GC includes inferiors */
+  gdk_gc_set_subwindow (gc, GDK_INCLUDE_INFERIORS);
+  gdk_draw_rectangle (window, gc, TRUE, 0, 0, 100, 100);
+  g_assert_cmphex (get_pixel (window, 25, 50), ==, blue.pixel);
+
+  /* drawing to the child stays within it */
+  gdk_gc_set_foreground (gc, &red);
+  gdk_draw_rectangle (child, gc, TRUE, 0, 0, 100, 100);
+  g_assert_cmphex (get_pixel (window, 25, 50), ==, red.pixel);
+  g_assert_cmphex (get_pixel (window, 75, 50), ==, blue.pixel);
+
+  g_object_unref (gc);
+  gdk_window_destroy (window);
+}
+
+static void
+test_ensure_native (void)
+{
+  GtkWidget *window, *left, *right;
+  GString *log;
+  guint n_children;
+
+  log = g_string_new (NULL);
+  window = create_toplevel (log, &left, &right);
+
+  n_children = count_x_children (window);
+  g_assert (gdk_window_ensure_native (left->window));
+  g_assert_cmpuint (count_x_children (window), ==, n_children + 1);
+  g_assert_cmphex (GDK_WINDOW_XID (left->window), !=, GDK_WINDOW_XID (window->window));
+
+  /* getting the XID makes a window native too */
+  g_assert_cmphex (GDK_WINDOW_XID (right->window), !=, GDK_WINDOW_XID (window->window));
+  g_assert_cmpuint (count_x_children (window), ==, n_children + 2);
+
+  /* the native windows get their events */
+  g_string_truncate (log, 0);
+  XWarpPointer (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), None,
+                GDK_WINDOW_XID (left->window), 0, 0, 0, 0, 50, 50);
+  process_events ();
+  g_assert (strstr (log->str, "enter left;") != NULL);
+
+  gtk_widget_destroy (window);
+  g_string_free (log, TRUE);
+}
+
+static GdkWindow *
+create_child_window (GdkWindow *parent)
+{
+  GdkWindowAttr attributes;
+
+  attributes.window_type = GDK_WINDOW_CHILD;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.x = 0;
+  attributes.y = 0;
+  attributes.width = 50;
+  attributes.height = 50;
+  attributes.event_mask = 0;
+
+  return gdk_window_new (parent, &attributes, GDK_WA_X | GDK_WA_Y);
+}
+
+static void
+test_ensure_native_stacking (void)
+{
+  GtkWidget *window;
+  GdkWindow *bottom, *middle, *top;
+  Window root, parent, *children;
+  guint n_children;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_show (window);
+  process_events ();
+
+  bottom = create_child_window (window->window);
+  middle = create_child_window (window->window);
+  top = create_child_window (window->window);
+  g_assert (gdk_window_ensure_native (bottom));
+  g_assert (gdk_window_ensure_native (top));
+
+  /* the new X window goes between its native siblings */
+  g_assert (gdk_window_ensure_native (middle));
+
+  XQueryTree (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()),
+              GDK_WINDOW_XID (window->window),
+              &root, &parent, &children, &n_children);
+  g_assert_cmpuint (n_children, ==, 3);
+  g_assert_cmphex (children[0], ==, GDK_WINDOW_XID (bottom));
+  g_assert_cmphex (children[1], ==, GDK_WINDOW_XID (middle));
+  g_assert_cmphex (children[2], ==, GDK_WINDOW_XID (top));
+  XFree (children);
+
+  gdk_window_destroy (bottom);
+  gdk_window_destroy (middle);
+  gdk_window_destroy (top);
+  gtk_widget_destroy (window);
+}
+
+static void
+test_grab_confine (void)
+{
+  GtkWidget *window, *left, *right;
+  GString *log;
+  guint n_children;
+
+  log = g_string_new (NULL);
+  window = create_toplevel (log, &left, &right);
+  n_children = count_x_children (window);
+
+  /* the grab window stays on the client side, but the pointer
+   * can only be confined to a native window
+   */
+  g_assert_cmpint (gdk_pointer_grab (left->window, FALSE,
+                                     GDK_BUTTON_RELEASE_MASK,
+                                     right->window, NULL,
+                                     GDK_CURRENT_TIME), ==, GDK_GRAB_SUCCESS);
+  g_assert_cmpuint (count_x_children (window), ==, n_children + 1);
+  gdk_pointer_ungrab (GDK_CURRENT_TIME);
+
+  gtk_widget_destroy (window);
+  g_string_free (log, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  /* The tests are about client-side windows */
+  if (g_getenv ("GDK_NATIVE_WINDOWS"))
+    return 0;
+
+  g_test_add_func ("/ClientSide/Crossing", test_crossing);
+  g_test_add_func ("/ClientSide/ImplicitGrab", test_implicit_grab);
+  g_test_add_func ("/ClientSide/Reparent", test_reparent);
+  g_test_add_func ("/ClientSide/DrawClipping", test_draw_clipping);
+  g_test_add_func ("/ClientSide/EnsureNative", test_ensure_native);
+  g_test_add_func ("/ClientSide/EnsureNativeStacking", test_ensure_native_stacking);
+  g_test_add_func ("/ClientSide/GrabConfine", test_grab_confine);
+
+  return g_test_run ();
+}
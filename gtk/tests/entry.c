@@ -0,0 +1,181 @@
+/* GtkEntry tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+
+static const gchar *pieces[] = {
+  "a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9d\x84\x9e", "xyz", "\xd7\xa9\xd7\x9c"
+};
+
+/* Applies the same edit to the entry and to a plain string */
+static void
+insert_both (GtkEntry    *entry,
+             GString     *expected,
+             const gchar *text,
+             gint         position)
+{
+  gint pos = position;
+  gsize index;
+
+  index = g_utf8_offset_to_pointer (expected->str, position) - expected->str;
+  g_string_insert (expected, index, text);
+
+  gtk_editable_insert_text (GTK_EDITABLE (entry), text, -1, &pos);
+  g_assert_cmpint (pos, ==, position + g_utf8_strlen (text, -1));
+}
+
+static void
+delete_both (GtkEntry *entry,
+             GString  *expected,
+             gint      start,
+             gint      end)
+{
+  gsize start_index, end_index;
+
+  start_index = g_utf8_offset_to_pointer (expected->str, start) - expected->str;
+  end_index = g_utf8_offset_to_pointer (expected->str, end) - expected->str;
+  g_string_erase (expected, start_index, end_index - start_index);
+
+  gtk_editable_delete_text (GTK_EDITABLE (entry), start, end);
+}
+
+static void
+check_contents (GtkEntry *entry,
+                GString  *expected)
+{
+  glong n_chars;
+  gint i;
+
+  n_chars = g_utf8_strlen (expected->str, -1);
+
+  g_assert_cmpstr (gtk_entry_get_text (entry), ==, expected->str);
+  g_assert_cmpint (gtk_entry_get_text_length (entry), ==, n_chars);
+
+  /* Check some substrings, in an order that exercises
+   * conversions going both forward and backward
+   */
+  for (i = 0; i <= n_chars; i += 3)
+    {
+      gint end = MIN (i + 5, n_chars);
+      gchar *chars;
+      gsize start_index, end_index;
+
+      start_index = g_utf8_offset_to_pointer (expected->str, n_chars - end) - expected->str;
+      end_index = g_utf8_offset_to_pointer (expected->str, n_chars - i) - expected->str;
+
+      chars = gtk_editable_get_chars (GTK_EDITABLE (entry), n_chars - end, n_chars - i);
+      g_assert_cmpint (strlen (chars), ==, end_index - start_index);
+      g_assert (strncmp (chars, expected->str + start_index, end_index - start_index) == 0);
+      g_free (chars);
+    }
+}
+
+static void
+test_edits (void)
+{
+  GtkWidget *entry;
+  GString *expected;
+  GRand *rand;
+  gint i;
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+
+  expected = g_string_new (NULL);
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i < 500; i++)
+    {
+      gint n_chars = g_utf8_strlen (expected->str, -1);
+
+      if (n_chars > 0 && g_rand_int_range (rand, 0, 4) == 0)
+        {
+          gint start = g_rand_int_range (rand, 0, n_chars);
+          gint end = g_rand_int_range (rand, start, MIN (start + 4, n_chars) + 1);
+
+          delete_both (GTK_ENTRY (entry), expected, start, end);
+        }
+      else
+        {
+          const gchar *text = pieces[g_rand_int_range (rand, 0, G_N_ELEMENTS (pieces))];
+
+          /* Mostly type at a moving "cursor", sometimes jump */
+          if (g_rand_int_range (rand, 0, 5) == 0)
+            insert_both (GTK_ENTRY (entry), expected, text,
+                         g_rand_int_range (rand, 0, n_chars + 1));
+          else
+            insert_both (GTK_ENTRY (entry), expected, text, n_chars / 2);
+        }
+
+      if (i % 50 == 0)
+        check_contents (GTK_ENTRY (entry), expected);
+    }
+
+  check_contents (GTK_ENTRY (entry), expected);
+
+  gtk_entry_set_text (GTK_ENTRY (entry), "\xe2\x82\xac\xe2\x82\xac");
+  g_string_assign (expected, "\xe2\x82\xac\xe2\x82\xac");
+  check_contents (GTK_ENTRY (entry), expected);
+
+  g_rand_free (rand);
+  g_string_free (expected, TRUE);
+  g_object_unref (entry);
+}
+
+static void
+test_word_motion (void)
+{
+  GtkWidget *entry;
+  gint pos;
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+
+  gtk_entry_set_text (GTK_ENTRY (entry), "one two three");
+  gtk_editable_set_position (GTK_EDITABLE (entry), 0);
+
+  g_signal_emit_by_name (entry, "move-cursor", GTK_MOVEMENT_WORDS, 1, FALSE);
+  pos = gtk_editable_get_position (GTK_EDITABLE (entry));
+  g_assert_cmpint (pos, ==, 3);
+
+  /* The text changed, so the motion must use fresh word boundaries */
+  gtk_editable_delete_text (GTK_EDITABLE (entry), 0, 4);
+  gtk_editable_set_position (GTK_EDITABLE (entry), 0);
+
+  g_signal_emit_by_name (entry, "move-cursor", GTK_MOVEMENT_WORDS, 1, FALSE);
+  pos = gtk_editable_get_position (GTK_EDITABLE (entry));
+  g_assert_cmpint (pos, ==, 3);
+
+  g_signal_emit_by_name (entry, "move-cursor", GTK_MOVEMENT_WORDS, 1, FALSE);
+  pos = gtk_editable_get_position (GTK_EDITABLE (entry));
+  g_assert_cmpint (pos, ==, 9);
+
+  g_object_unref (entry);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Entry/Edits", test_edits);
+  g_test_add_func ("/Entry/Word motion", test_word_motion);
+
+  return g_test_run ();
+}
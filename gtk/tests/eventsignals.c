@@ -0,0 +1,221 @@
+/* Event signal tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* A widget that counts the calls of its class handlers */
+typedef GtkDrawingArea      TestWidget;
+typedef GtkDrawingAreaClass TestWidgetClass;
+
+static guint n_class_exposes = 0;
+static guint n_class_motions = 0;
+
+G_DEFINE_TYPE (TestWidget, test_widget, GTK_TYPE_DRAWING_AREA)
+
+static gboolean
+test_widget_expose (GtkWidget      *widget,
+                    GdkEventExpose *event)
+{
+  n_class_exposes++;
+  return FALSE;
+}
+
+static gboolean
+test_widget_motion (GtkWidget      *widget,
+                    GdkEventMotion *event)
+{
+  n_class_motions++;
+  return FALSE;
+}
+
+static void
+test_widget_class_init (TestWidgetClass *class)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
+
+  widget_class->expose_event = test_widget_expose;
+  widget_class->motion_notify_event = test_widget_motion;
+}
+
+static void
+test_widget_init (TestWidget *widget)
+{
+}
+
+/* A subclass that overrides the class closure of ::expose-event */
+typedef TestWidget      TestOverride;
+typedef TestWidgetClass TestOverrideClass;
+
+static guint n_override_exposes = 0;
+
+G_DEFINE_TYPE (TestOverride, test_override, test_widget_get_type ())
+
+static gboolean
+test_override_expose (GtkWidget      *widget,
+                      GdkEventExpose *event)
+{
+  n_override_exposes++;
+  return FALSE;
+}
+
+static void
+test_override_class_init (TestOverrideClass *class)
+{
+  g_signal_override_class_closure (g_signal_lookup ("expose-event", GTK_TYPE_WIDGET),
+                                   test_override_get_type (),
+                                   g_cclosure_new (G_CALLBACK (test_override_expose),
+                                                   NULL, NULL));
+}
+
+static void
+test_override_init (TestOverride *widget)
+{
+}
+
+static GtkWidget *
+create_shown (GType type)
+{
+  GtkWidget *window, *widget;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  widget = g_object_new (type, NULL);
+  gtk_widget_add_events (widget, GDK_POINTER_MOTION_MASK);
+  gtk_container_add (GTK_CONTAINER (window), widget);
+  gtk_widget_show_all (window);
+
+  while (!gdk_window_is_viewable (widget->window))
+    gtk_main_iteration ();
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  return widget;
+}
+
+static void
+send_events (GtkWidget *widget)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (GDK_EXPOSE);
+  event->expose.window = g_object_ref (widget->window);
+  event->expose.area.width = 10;
+  event->expose.area.height = 10;
+  event->expose.region = gdk_region_rectangle (&event->expose.area);
+  gtk_widget_send_expose (widget, event);
+  gdk_event_free (event);
+
+  event = gdk_event_new (GDK_MOTION_NOTIFY);
+  event->motion.window = g_object_ref (widget->window);
+  event->motion.device = gdk_device_get_core_pointer ();
+  gtk_widget_event (widget, event);
+  gdk_event_free (event);
+}
+
+static guint n_handler_calls = 0;
+
+static gboolean
+count_handler (GtkWidget *widget,
+               GdkEvent  *event)
+{
+  n_handler_calls++;
+  return FALSE;
+}
+
+static void
+reset_counts (void)
+{
+  n_class_exposes = n_class_motions = 0;
+  n_override_exposes = 0;
+  n_handler_calls = 0;
+}
+
+static void
+test_handlers (void)
+{
+  GtkWidget *widget;
+
+  widget = create_shown (test_widget_get_type ());
+  g_signal_connect (widget, "expose-event", G_CALLBACK (count_handler), NULL);
+  g_signal_connect (widget, "motion-notify-event", G_CALLBACK (count_handler), NULL);
+
+  /* connected handlers always run, along with the class handlers */
+  reset_counts ();
+  send_events (widget);
+  g_assert_cmpuint (n_handler_calls, ==, 2);
+  g_assert_cmpuint (n_class_exposes, ==, 1);
+  g_assert_cmpuint (n_class_motions, ==, 1);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (widget));
+}
+
+static void
+test_class_handlers (void)
+{
+  GtkWidget *widget;
+  gint i;
+
+  widget = create_shown (test_widget_get_type ());
+
+  /* the first events probe the type, later ones call the class
+   * handlers directly; either way they run once per event
+   */
+  for (i = 0; i < 3; i++)
+    {
+      reset_counts ();
+      send_events (widget);
+      g_assert_cmpuint (n_class_exposes, ==, 1);
+      g_assert_cmpuint (n_class_motions, ==, 1);
+    }
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (widget));
+}
+
+static void
+test_override_class_closure (void)
+{
+  GtkWidget *widget;
+  gint i;
+
+  widget = create_shown (test_override_get_type ());
+
+  /* the overriding closure runs instead of the class handler,
+   * also after the type has been probed
+   */
+  for (i = 0; i < 3; i++)
+    {
+      reset_counts ();
+      send_events (widget);
+      g_assert_cmpuint (n_override_exposes, ==, 1);
+      g_assert_cmpuint (n_class_exposes, ==, 0);
+      g_assert_cmpuint (n_class_motions, ==, 1);
+    }
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (widget));
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/EventSignals/Handlers", test_handlers);
+  g_test_add_func ("/EventSignals/ClassHandlers", test_class_handlers);
+  g_test_add_func ("/EventSignals/OverrideClassClosure", test_override_class_closure);
+
+  return g_test_run ();
+}
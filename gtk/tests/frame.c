@@ -0,0 +1,228 @@
+/* Frame scheduler tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static gboolean
+count_ticks (GtkWidget *widget,
+             gpointer   data)
+{
+  gint *n_ticks = data;
+
+  (*n_ticks)++;
+  gtk_widget_queue_draw (widget);
+
+  return *n_ticks < 3;
+}
+
+static void
+set_flag (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+}
+
+static void
+test_tick_callback (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkFrameStats stats;
+  GtkWidget *window;
+  gint n_ticks = 0;
+  gboolean removed = FALSE;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_show_now (window);
+
+  gdk_display_reset_frame_stats (display);
+  gtk_widget_add_tick_callback (window, count_ticks, &n_ticks, set_flag);
+
+  /* one tick per frame, until the callback returns FALSE */
+  while (!removed)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpint (n_ticks, ==, 3);
+  gdk_display_get_frame_stats (display, &stats);
+  g_assert_cmpuint (stats.n_frames, >=, 3);
+
+  gtk_widget_destroy (window);
+}
+
+static void
+test_tick_destroy (void)
+{
+  GtkWidget *window;
+  gint n_ticks = 0;
+  gboolean removed = FALSE;
+  guint id;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+
+  id = gtk_widget_add_tick_callback (window, count_ticks, &n_ticks, set_flag);
+  g_assert (id != 0);
+
+  gtk_widget_destroy (window);
+  g_assert (removed);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+  g_assert_cmpint (n_ticks, ==, 0);
+}
+
+typedef struct
+{
+  guint    id;
+  gint     n_ticks;
+  gint     n_notifies;
+  gboolean destroy;
+} SelfRemoval;
+
+static gboolean
+remove_self (GtkWidget *widget,
+             gpointer   data)
+{
+  SelfRemoval *removal = data;
+
+  removal->n_ticks++;
+
+  if (removal->destroy)
+    gtk_widget_destroy (widget);
+  else
+    gtk_widget_remove_tick_callback (widget, removal->id);
+
+  return FALSE;
+}
+
+static void
+count_notify (gpointer data)
+{
+  SelfRemoval *removal = data;
+
+  removal->n_notifies++;
+}
+
+static void
+test_tick_remove_self (void)
+{
+  GtkWidget *window;
+  SelfRemoval removal = { 0, };
+  gint i;
+
+  /* the callback removes itself and returns FALSE; then it
+   * destroys its widget and returns FALSE
+   */
+  for (i = 0; i < 2; i++)
+    {
+      removal.n_ticks = 0;
+      removal.n_notifies = 0;
+      removal.destroy = i == 1;
+
+      window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+      g_object_ref_sink (window);
+
+      removal.id = gtk_widget_add_tick_callback (window, remove_self,
+                                                 &removal, count_notify);
+
+      while (removal.n_notifies == 0)
+        g_main_context_iteration (NULL, TRUE);
+      while (gtk_events_pending ())
+        gtk_main_iteration ();
+
+      g_assert_cmpint (removal.n_ticks, ==, 1);
+      g_assert_cmpint (removal.n_notifies, ==, 1);
+
+      if (!removal.destroy)
+        gtk_widget_destroy (window);
+      g_object_unref (window);
+    }
+}
+
+static gboolean
+record_frame (GtkWidget *widget,
+              gpointer   arg1,
+              gpointer   data)
+{
+  GdkFrameStats stats;
+
+  gdk_display_get_frame_stats (gtk_widget_get_display (widget), &stats);
+  *(gint *) data = stats.n_frames;
+
+  return FALSE;
+}
+
+static void
+test_layout_frame (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkFrameStats stats;
+  GtkWidget *window, *label;
+  gint width;
+  gint allocate_frame = -1;
+  gint expose_frame = -1;
+
+  /* big enough that the toplevel doesn't need to be resized
+   * on the server, which would take another frame
+   */
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 400, 200);
+  label = gtk_label_new ("label");
+  gtk_container_add (GTK_CONTAINER (window), label);
+  gtk_widget_show_all (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_signal_connect (label, "size-allocate",
+                    G_CALLBACK (record_frame), &allocate_frame);
+  g_signal_connect (label, "expose-event",
+                    G_CALLBACK (record_frame), &expose_frame);
+
+  gdk_display_reset_frame_stats (display);
+  width = label->requisition.width;
+
+  /* a resize and a redraw requested together are handled in one frame */
+  gtk_label_set_text (GTK_LABEL (label), "a longer label");
+  gtk_widget_queue_draw (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert_cmpint (label->requisition.width, >, width);
+  gdk_display_get_frame_stats (display, &stats);
+  g_assert_cmpuint (stats.n_frames, ==, 1);
+
+  /* frames are counted once they are done, so both happened
+   * while the first one was running
+   */
+  g_assert_cmpint (allocate_frame, ==, 0);
+  g_assert_cmpint (expose_frame, ==, 0);
+
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Frame/TickCallback", test_tick_callback);
+  g_test_add_func ("/Frame/TickDestroy", test_tick_destroy);
+  g_test_add_func ("/Frame/TickRemoveSelf", test_tick_remove_self);
+  g_test_add_func ("/Frame/Layout", test_layout_frame);
+
+  return g_test_run ();
+}
@@ -0,0 +1,184 @@
+/* Widget hierarchy tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* Checks the toplevel and the ancestors of @widget against a walk
+ * of the parent chain, and that nothing else is an ancestor.
+ */
+static void
+check_hierarchy (GtkWidget *widget,
+                 GtkWidget *unrelated)
+{
+  GtkWidget *toplevel, *parent;
+
+  toplevel = widget;
+  while (toplevel->parent)
+    toplevel = toplevel->parent;
+  g_assert (gtk_widget_get_toplevel (widget) == toplevel);
+
+  for (parent = widget->parent; parent; parent = parent->parent)
+    {
+      g_assert (gtk_widget_is_ancestor (widget, parent));
+      g_assert (!gtk_widget_is_ancestor (parent, widget));
+    }
+
+  g_assert (!gtk_widget_is_ancestor (widget, widget));
+  g_assert (!gtk_widget_is_ancestor (widget, unrelated));
+}
+
+/* window > outer > inner > button, plus an other window with a box */
+typedef struct {
+  GtkWidget *window;
+  GtkWidget *outer;
+  GtkWidget *inner;
+  GtkWidget *button;
+  GtkWidget *other_window;
+  GtkWidget *other_box;
+} Tree;
+
+static void
+tree_build (Tree *tree)
+{
+  tree->window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  tree->outer = gtk_vbox_new (FALSE, 0);
+  tree->inner = gtk_hbox_new (FALSE, 0);
+  tree->button = gtk_button_new ();
+  gtk_container_add (GTK_CONTAINER (tree->window), tree->outer);
+  gtk_container_add (GTK_CONTAINER (tree->outer), tree->inner);
+  gtk_container_add (GTK_CONTAINER (tree->inner), tree->button);
+
+  tree->other_window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  tree->other_box = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (tree->other_window), tree->other_box);
+}
+
+static void
+test_reparent (void)
+{
+  Tree tree;
+
+  tree_build (&tree);
+
+  /* Look everything up once, so the caches are filled */
+  check_hierarchy (tree.button, tree.other_box);
+  check_hierarchy (tree.inner, tree.other_box);
+  g_assert (gtk_widget_get_toplevel (tree.other_box) == tree.other_window);
+
+  /* Move the button up to a shallower place in the other window */
+  gtk_widget_reparent (tree.button, tree.other_box);
+  g_assert (gtk_widget_get_toplevel (tree.button) == tree.other_window);
+  check_hierarchy (tree.button, tree.inner);
+  g_assert (gtk_widget_is_ancestor (tree.button, tree.other_box));
+  g_assert (!gtk_widget_is_ancestor (tree.button, tree.outer));
+
+  /* Move a subtree; its descendants follow it */
+  gtk_widget_reparent (tree.outer, tree.other_box);
+  g_assert (gtk_widget_get_toplevel (tree.inner) == tree.other_window);
+  check_hierarchy (tree.inner, tree.window);
+  g_assert (gtk_widget_is_ancestor (tree.inner, tree.other_box));
+
+  /* And back down below the original depth of the button */
+  gtk_widget_reparent (tree.button, tree.inner);
+  check_hierarchy (tree.button, tree.window);
+  g_assert (gtk_widget_is_ancestor (tree.button, tree.outer));
+  g_assert (gtk_widget_is_ancestor (tree.button, tree.other_window));
+  g_assert (!gtk_widget_is_ancestor (tree.other_box, tree.button));
+
+  gtk_widget_destroy (tree.window);
+  gtk_widget_destroy (tree.other_window);
+}
+
+static void
+test_unparent (void)
+{
+  Tree tree;
+
+  tree_build (&tree);
+  check_hierarchy (tree.button, tree.other_window);
+
+  /* A removed subtree is its own hierarchy */
+  g_object_ref (tree.inner);
+  gtk_container_remove (GTK_CONTAINER (tree.outer), tree.inner);
+  g_assert (gtk_widget_get_toplevel (tree.inner) == tree.inner);
+  g_assert (gtk_widget_get_toplevel (tree.button) == tree.inner);
+  check_hierarchy (tree.button, tree.window);
+  g_assert (!gtk_widget_is_ancestor (tree.button, tree.outer));
+  g_assert (!gtk_widget_is_ancestor (tree.inner, tree.window));
+
+  /* Adding it elsewhere joins the hierarchies again */
+  gtk_container_add (GTK_CONTAINER (tree.other_box), tree.inner);
+  g_object_unref (tree.inner);
+  g_assert (gtk_widget_get_toplevel (tree.button) == tree.other_window);
+  check_hierarchy (tree.button, tree.window);
+  g_assert (gtk_widget_is_ancestor (tree.button, tree.other_box));
+
+  gtk_widget_destroy (tree.window);
+  gtk_widget_destroy (tree.other_window);
+}
+
+static void
+test_destroy (void)
+{
+  Tree tree;
+
+  tree_build (&tree);
+  check_hierarchy (tree.button, tree.other_window);
+
+  /* Destroying a container takes its children along, and
+   * both drop out of the hierarchy
+   */
+  g_object_ref (tree.inner);
+  g_object_ref (tree.button);
+  gtk_widget_destroy (tree.inner);
+  g_assert (tree.inner->parent == NULL);
+  g_assert (tree.button->parent == NULL);
+  g_assert (gtk_widget_get_toplevel (tree.inner) == tree.inner);
+  g_assert (gtk_widget_get_toplevel (tree.button) == tree.button);
+  g_assert (!gtk_widget_is_ancestor (tree.button, tree.inner));
+  g_assert (!gtk_widget_is_ancestor (tree.inner, tree.window));
+  g_assert (gtk_widget_get_toplevel (tree.outer) == tree.window);
+  g_object_unref (tree.button);
+  g_object_unref (tree.inner);
+
+  tree.button = gtk_button_new ();
+  gtk_container_add (GTK_CONTAINER (tree.outer), tree.button);
+  check_hierarchy (tree.button, tree.other_window);
+  g_assert (gtk_widget_is_ancestor (tree.button, tree.window));
+
+  /* A new widget may reuse the memory of a destroyed one */
+  gtk_widget_destroy (tree.other_window);
+  tree.other_window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  check_hierarchy (tree.button, tree.other_window);
+  g_assert (gtk_widget_get_toplevel (tree.other_window) == tree.other_window);
+
+  gtk_widget_destroy (tree.window);
+  gtk_widget_destroy (tree.other_window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Hierarchy/Reparent", test_reparent);
+  g_test_add_func ("/Hierarchy/Unparent", test_unparent);
+  g_test_add_func ("/Hierarchy/Destroy", test_destroy);
+
+  return g_test_run ();
+}
@@ -0,0 +1,229 @@
+/* Asynchronous icon loading tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+#define ICON_SIZE 16
+
+static gchar *icon_dir = NULL;
+
+/* Writes a single colored, unthemed icon into the icon directory */
+static gchar *
+write_icon (const gchar *name,
+            guint32      color)
+{
+  GdkPixbuf *pixbuf;
+  gchar *basename, *filename;
+
+  basename = g_strconcat (name, ".png", NULL);
+  filename = g_build_filename (icon_dir, basename, NULL);
+  g_free (basename);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, ICON_SIZE, ICON_SIZE);
+  gdk_pixbuf_fill (pixbuf, color);
+  g_assert (gdk_pixbuf_save (pixbuf, filename, "png", NULL, NULL));
+  g_object_unref (pixbuf);
+
+  return filename;
+}
+
+static guchar
+get_red (GdkPixbuf *pixbuf)
+{
+  return gdk_pixbuf_get_pixels (pixbuf)[0];
+}
+
+typedef struct {
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  GError *error;
+  gboolean done;
+} LoadData;
+
+static void
+load_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  LoadData *data = user_data;
+
+  data->pixbuf = gtk_icon_info_load_icon_finish (data->info, result,
+                                                 &data->error);
+  data->done = TRUE;
+}
+
+static void
+run_load (LoadData     *data,
+          GCancellable *cancellable)
+{
+  gtk_icon_info_load_icon_async (data->info, cancellable, load_done, data);
+
+  /* The result is never delivered before returning to the main loop */
+  g_assert (!data->done);
+
+  while (!data->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static GtkIconInfo *
+lookup_icon (const gchar *name)
+{
+  GtkIconInfo *info;
+
+  info = gtk_icon_theme_lookup_icon (gtk_icon_theme_get_default (),
+                                     name, ICON_SIZE, 0);
+  g_assert (info != NULL);
+
+  return info;
+}
+
+static void
+test_load (void)
+{
+  LoadData data = { NULL, };
+  GdkPixbuf *pixbuf;
+
+  data.info = lookup_icon ("iconload-red");
+  run_load (&data, NULL);
+
+  g_assert (data.error == NULL);
+  g_assert (GDK_IS_PIXBUF (data.pixbuf));
+  g_assert_cmpint (gdk_pixbuf_get_width (data.pixbuf), ==, ICON_SIZE);
+  g_assert_cmpint (get_red (data.pixbuf), ==, 0xff);
+
+  /* The info keeps the loaded pixbuf */
+  pixbuf = gtk_icon_info_load_icon (data.info, NULL);
+  g_assert (pixbuf == data.pixbuf);
+  g_object_unref (pixbuf);
+
+  g_object_unref (data.pixbuf);
+  gtk_icon_info_free (data.info);
+}
+
+static void
+test_cancel (void)
+{
+  LoadData data = { NULL, };
+  GCancellable *cancellable;
+
+  data.info = lookup_icon ("iconload-red");
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+  run_load (&data, cancellable);
+
+  g_assert (data.pixbuf == NULL);
+  g_assert (g_error_matches (data.error, G_IO_ERROR, G_IO_ERROR_CANCELLED));
+  g_error_free (data.error);
+
+  g_object_unref (cancellable);
+  gtk_icon_info_free (data.info);
+}
+
+static void
+test_already_loaded (void)
+{
+  LoadData data = { NULL, };
+  GdkPixbuf *pixbuf;
+
+  data.info = lookup_icon ("iconload-red");
+  pixbuf = gtk_icon_info_load_icon (data.info, NULL);
+  g_assert (GDK_IS_PIXBUF (pixbuf));
+
+  /* Completes from an idle, with the pixbuf the info already holds */
+  run_load (&data, NULL);
+
+  g_assert (data.error == NULL);
+  g_assert (data.pixbuf == pixbuf);
+
+  g_object_unref (data.pixbuf);
+  g_object_unref (pixbuf);
+  gtk_icon_info_free (data.info);
+}
+
+static void
+test_image_change (void)
+{
+  GtkWidget *image;
+  GtkRequisition requisition;
+
+  image = gtk_image_new ();
+  g_object_ref_sink (image);
+  gtk_image_set_load_async (GTK_IMAGE (image), TRUE);
+  gtk_image_set_pixel_size (GTK_IMAGE (image), ICON_SIZE);
+
+  /* The size request starts the load and reserves room for the icon */
+  gtk_image_set_from_icon_name (GTK_IMAGE (image), "iconload-red",
+                                GTK_ICON_SIZE_BUTTON);
+  gtk_widget_size_request (image, &requisition);
+  g_assert (GTK_IMAGE (image)->data.name.pixbuf == NULL);
+  g_assert_cmpint (requisition.width, ==, ICON_SIZE);
+  g_assert_cmpint (requisition.height, ==, ICON_SIZE);
+
+  /* Replace the icon while the first load is still pending */
+  gtk_image_set_from_icon_name (GTK_IMAGE (image), "iconload-green",
+                                GTK_ICON_SIZE_BUTTON);
+  gtk_widget_size_request (image, &requisition);
+  g_assert (GTK_IMAGE (image)->data.name.pixbuf == NULL);
+
+  /* Each pending load holds a reference on the image; wait until
+   * both have called back, so the stale one had its chance
+   */
+  while (G_OBJECT (image)->ref_count > 1)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpstr (gtk_image_get_icon_name (GTK_IMAGE (image), NULL),
+                   ==, "iconload-green");
+  g_assert (GDK_IS_PIXBUF (GTK_IMAGE (image)->data.name.pixbuf));
+  g_assert_cmpint (get_red (GTK_IMAGE (image)->data.name.pixbuf), ==, 0);
+
+  g_object_unref (image);
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar *red, *green;
+  gint result;
+
+  g_thread_init (NULL);
+  gtk_test_init (&argc, &argv);
+
+  icon_dir = g_strdup_printf ("%s/iconload-%d", g_get_tmp_dir (), getpid ());
+  g_mkdir_with_parents (icon_dir, 0700);
+  red = write_icon ("iconload-red", 0xff0000ff);
+  green = write_icon ("iconload-green", 0x00ff00ff);
+  gtk_icon_theme_append_search_path (gtk_icon_theme_get_default (), icon_dir);
+
+  g_test_add_func ("/IconLoad/Load", test_load);
+  g_test_add_func ("/IconLoad/Cancel", test_cancel);
+  g_test_add_func ("/IconLoad/AlreadyLoaded", test_already_loaded);
+  g_test_add_func ("/IconLoad/ImageChange", test_image_change);
+
+  result = g_test_run ();
+
+  g_unlink (red);
+  g_unlink (green);
+  g_rmdir (icon_dir);
+  g_free (red);
+  g_free (green);
+  g_free (icon_dir);
+
+  return result;
+}
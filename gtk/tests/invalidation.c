@@ -0,0 +1,155 @@
+/* Invalidation tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* Nothing runs the main loop in these tests, so the update area
+ * of the toplevel only holds what the tested code invalidated.
+ */
+static void
+clear_update_area (GtkWidget *window)
+{
+  GdkRegion *update_area;
+
+  gdk_window_process_all_updates ();
+
+  update_area = gdk_window_get_update_area (window->window);
+  if (update_area)
+    gdk_region_destroy (update_area);
+}
+
+static void
+check_update_area (GtkWidget    *window,
+                   GdkRectangle *expected)
+{
+  GdkRegion *update_area;
+  GdkRegion *expected_area;
+
+  update_area = gdk_window_get_update_area (window->window);
+  g_assert (update_area != NULL);
+
+  expected_area = gdk_region_rectangle (expected);
+  g_assert (gdk_region_equal (update_area, expected_area));
+
+  gdk_region_destroy (expected_area);
+  gdk_region_destroy (update_area);
+}
+
+static gboolean
+allocation_equal (GtkAllocation *a,
+                  GtkAllocation *b)
+{
+  return a->x == b->x && a->y == b->y &&
+    a->width == b->width && a->height == b->height;
+}
+
+/* Moving the handle redraws the paned and nothing next to it,
+ * and moves the handle window along
+ */
+static void
+test_paned_handle (void)
+{
+  GtkWidget *window, *vbox, *paned, *child1, *bystander;
+  GtkAllocation bystander_allocation;
+  gint x, y;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 200);
+  vbox = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (window), vbox);
+  paned = gtk_hpaned_new ();
+  gtk_paned_add1 (GTK_PANED (paned), gtk_label_new ("Left"));
+  gtk_paned_add2 (GTK_PANED (paned), gtk_label_new ("Right"));
+  gtk_box_pack_start (GTK_BOX (vbox), paned, TRUE, TRUE, 0);
+  bystander = gtk_label_new ("Bystander");
+  gtk_box_pack_start (GTK_BOX (vbox), bystander, FALSE, FALSE, 0);
+  gtk_widget_show_all (window);
+
+  gtk_paned_set_position (GTK_PANED (paned), 100);
+  gtk_container_check_resize (GTK_CONTAINER (window));
+  clear_update_area (window);
+
+  bystander_allocation = bystander->allocation;
+
+  gtk_paned_set_position (GTK_PANED (paned), 150);
+  gtk_container_check_resize (GTK_CONTAINER (window));
+
+  child1 = gtk_paned_get_child1 (GTK_PANED (paned));
+  g_assert_cmpint (child1->allocation.width, ==, 150);
+  g_assert (allocation_equal (&bystander->allocation, &bystander_allocation));
+  check_update_area (window, &paned->allocation);
+
+  gdk_window_get_position (GTK_PANED (paned)->handle, &x, &y);
+  g_assert_cmpint (x, ==, child1->allocation.x + child1->allocation.width);
+  g_assert_cmpint (y, ==, paned->allocation.y);
+
+  gtk_widget_destroy (window);
+}
+
+/* Only the current page is allocated, and shrinking the notebook
+ * redraws just the area it used to cover
+ */
+static void
+test_notebook_hidden_pages (void)
+{
+  GtkWidget *window, *notebook, *page1, *page2;
+  GtkAllocation allocation, old_allocation, hidden_allocation;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 200);
+  notebook = gtk_notebook_new ();
+  gtk_container_add (GTK_CONTAINER (window), notebook);
+  page1 = gtk_label_new ("First page");
+  gtk_notebook_append_page (GTK_NOTEBOOK (notebook), page1, NULL);
+  page2 = gtk_label_new ("Second page");
+  gtk_notebook_append_page (GTK_NOTEBOOK (notebook), page2, NULL);
+  gtk_widget_show_all (window);
+  clear_update_area (window);
+
+  old_allocation = notebook->allocation;
+  hidden_allocation = page2->allocation;
+  allocation = old_allocation;
+  allocation.width -= 50;
+  allocation.height -= 50;
+
+  gtk_widget_size_allocate (notebook, &allocation);
+
+  check_update_area (window, &old_allocation);
+  g_assert_cmpint (page1->allocation.width, <, old_allocation.width - 50);
+  g_assert (allocation_equal (&page2->allocation, &hidden_allocation));
+
+  /* switching pages queues a resize, which allocates the new page */
+  gtk_notebook_set_current_page (GTK_NOTEBOOK (notebook), 1);
+  clear_update_area (window);
+  gtk_widget_size_allocate (notebook, &allocation);
+
+  g_assert (allocation_equal (&page2->allocation, &page1->allocation));
+
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Invalidation/PanedHandle", test_paned_handle);
+  g_test_add_func ("/Invalidation/NotebookHiddenPages", test_notebook_hidden_pages);
+
+  return g_test_run ();
+}
@@ -0,0 +1,128 @@
+/* Layout cache tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+static GtkWidget *
+create_label (const gchar *text)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new (text);
+  g_object_ref_sink (label);
+
+  /* so that gtk_widget_modify_font() takes effect right away */
+  gtk_widget_ensure_style (label);
+
+  return label;
+}
+
+static gint
+request_width (GtkWidget *label)
+{
+  GtkRequisition requisition;
+
+  gtk_widget_size_request (label, &requisition);
+
+  return requisition.width;
+}
+
+static void
+modify_font (GtkWidget   *label,
+             const gchar *font)
+{
+  PangoFontDescription *font_desc;
+
+  font_desc = pango_font_description_from_string (font);
+  gtk_widget_modify_font (label, font_desc);
+  pango_font_description_free (font_desc);
+}
+
+#ifdef G_ENABLE_DEBUG
+/* The cache reports its statistics at exit with GTK_DEBUG=misc */
+static void
+test_hits_and_misses (void)
+{
+  if (g_test_trap_fork (0, G_TEST_TRAP_SILENCE_STDOUT))
+    {
+      GtkWidget *a, *b, *c;
+
+      gtk_debug_flags |= GTK_DEBUG_MISC;
+
+      a = create_label ("Cached layout");
+      b = create_label ("Cached layout");
+      c = create_label ("Cached layout");
+
+      /* one miss, then the other labels share the layout */
+      request_width (a);
+      request_width (b);
+      request_width (c);
+
+      /* a different font or text needs a layout of its own */
+      modify_font (c, "Sans 40");
+      request_width (c);
+      gtk_label_set_text (GTK_LABEL (b), "Cached layout, changed");
+      request_width (b);
+
+      exit (0);
+    }
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stdout ("*layout cache: 3 entries, * bytes, 2 hits, 3 misses, 0 evictions*");
+}
+#endif
+
+static void
+test_invalidation (void)
+{
+  GtkWidget *a, *b;
+  gint width;
+
+  a = create_label ("Shared layout");
+  b = create_label ("Shared layout");
+
+  width = request_width (a);
+  g_assert_cmpint (request_width (b), ==, width);
+
+  modify_font (b, "Sans 40");
+  g_assert_cmpint (request_width (b), >, width);
+  g_assert_cmpint (request_width (a), ==, width);
+
+  gtk_label_set_text (GTK_LABEL (a), "Shared layout, changed");
+  g_assert_cmpint (request_width (a), >, width);
+
+  gtk_label_set_text (GTK_LABEL (a), "Shared layout");
+  g_assert_cmpint (request_width (a), ==, width);
+
+  g_object_unref (a);
+  g_object_unref (b);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+#ifdef G_ENABLE_DEBUG
+  /* first, so that nothing is cached yet when it forks */
+  g_test_add_func ("/LayoutCache/HitsAndMisses", test_hits_and_misses);
+#endif
+  g_test_add_func ("/LayoutCache/Invalidation", test_invalidation);
+
+  return g_test_run ();
+}
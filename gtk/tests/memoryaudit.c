@@ -0,0 +1,123 @@
+/* Memory audit tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gtk/gtk.h>
+
+typedef struct
+{
+  guint n_instances;
+  gsize size;
+  gsize server_size;
+} AuditLine;
+
+/* Finds the line for @type in @report; returns %FALSE if the
+ * type doesn't appear.
+ */
+static gboolean
+find_line (const gchar *report,
+           const gchar *type,
+           AuditLine   *line)
+{
+  gchar **lines;
+  gboolean found = FALSE;
+  gint i;
+
+  memset (line, 0, sizeof (AuditLine));
+
+  lines = g_strsplit (report, "\n", -1);
+  for (i = 0; lines[i] && !found; i++)
+    {
+      gchar name[128];
+      gulong size, server_size;
+
+      if (lines[i][0] == '#' || lines[i][0] == '\0')
+        continue;
+
+      g_assert_cmpint (sscanf (lines[i], "%127s %u %lu %lu", name,
+                               &line->n_instances, &size, &server_size), ==, 4);
+      if (strcmp (name, type) == 0)
+        {
+          line->size = size;
+          line->server_size = server_size;
+          found = TRUE;
+        }
+    }
+  g_strfreev (lines);
+
+  return found;
+}
+
+static void
+test_counts (void)
+{
+  GtkWidget *window, *box, *image;
+  GdkPixmap *pixmap;
+  AuditLine line;
+  gchar *report;
+  gint i;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+  for (i = 0; i < 3; i++)
+    gtk_box_pack_start (GTK_BOX (box), gtk_label_new ("Label"), FALSE, FALSE, 0);
+  gtk_widget_realize (window);
+
+  pixmap = gdk_pixmap_new (window->window, 16, 16, -1);
+  image = gtk_image_new_from_pixmap (pixmap, NULL);
+  gtk_box_pack_start (GTK_BOX (box), image, FALSE, FALSE, 0);
+  gtk_widget_show_all (window);
+
+  report = gtk_memory_audit ();
+
+  g_assert (find_line (report, "GtkLabel", &line));
+  g_assert_cmpuint (line.n_instances, ==, 3);
+  g_assert_cmpuint (line.size, >=, 3 * sizeof (GtkLabel));
+
+  g_assert (find_line (report, "GtkVBox", &line));
+  g_assert_cmpuint (line.n_instances, ==, 1);
+
+  /* the labels share the style of the box */
+  g_assert (find_line (report, "GtkStyle", &line));
+  g_assert_cmpuint (line.n_instances, <, 5);
+
+  g_assert (find_line (report, "GdkPixmap", &line));
+  g_assert_cmpuint (line.server_size, >=, 16 * 16);
+
+  g_free (report);
+
+  /* destroyed widgets are gone from the report */
+  gtk_widget_destroy (window);
+  g_object_unref (pixmap);
+
+  report = gtk_memory_audit ();
+  g_assert (!find_line (report, "GtkLabel", &line));
+  g_free (report);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/MemoryAudit/Counts", test_counts);
+
+  return g_test_run ();
+}
@@ -0,0 +1,133 @@
+/* Motion compression tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static void
+put_motion (GdkWindow *window,
+            gint       x,
+            guint      state)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (GDK_MOTION_NOTIFY);
+  event->motion.window = g_object_ref (window);
+  event->motion.time = x;
+  event->motion.x = x;
+  event->motion.y = 0;
+  event->motion.state = state;
+  event->motion.device = gdk_device_get_core_pointer ();
+
+  gdk_event_put (event);
+  gdk_event_free (event);
+}
+
+static void
+flush_events (void)
+{
+  GdkEvent *event;
+
+  while ((event = gdk_event_get ()) != NULL)
+    gdk_event_free (event);
+}
+
+static void
+test_compression (void)
+{
+  GtkWidget *window;
+  GdkEvent *event;
+  GList *history, *l;
+  gint x;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_realize (window);
+  flush_events ();
+
+  g_assert (!gdk_window_get_motion_compression (window->window));
+  gdk_window_set_motion_compression (window->window, TRUE);
+  g_assert (gdk_window_get_motion_compression (window->window));
+
+  for (x = 0; x < 5; x++)
+    put_motion (window->window, x, 0);
+
+  /* the last event stands for the others */
+  event = gdk_event_get ();
+  g_assert (event != NULL);
+  g_assert_cmpint (event->type, ==, GDK_MOTION_NOTIFY);
+  g_assert_cmpint ((gint) event->motion.x, ==, 4);
+
+  history = gdk_event_get_motion_history (event);
+  g_assert_cmpuint (g_list_length (history), ==, 4);
+  for (l = history, x = 0; l; l = l->next, x++)
+    g_assert_cmpint ((gint) ((GdkEvent *) l->data)->motion.x, ==, x);
+
+  gdk_event_free (event);
+  g_assert (gdk_event_get () == NULL);
+
+  gtk_widget_destroy (window);
+}
+
+static void
+test_compression_boundaries (void)
+{
+  GtkWidget *window;
+  GdkEvent *event;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_realize (window);
+  flush_events ();
+
+  /* without compression, every event is delivered */
+  put_motion (window->window, 0, 0);
+  put_motion (window->window, 1, 0);
+
+  event = gdk_event_get ();
+  g_assert_cmpint ((gint) event->motion.x, ==, 0);
+  g_assert (gdk_event_get_motion_history (event) == NULL);
+  gdk_event_free (event);
+  flush_events ();
+
+  /* a change of modifier state ends a run of motions */
+  gdk_window_set_motion_compression (window->window, TRUE);
+  put_motion (window->window, 0, 0);
+  put_motion (window->window, 1, 0);
+  put_motion (window->window, 2, GDK_BUTTON1_MASK);
+
+  event = gdk_event_get ();
+  g_assert_cmpint ((gint) event->motion.x, ==, 1);
+  g_assert_cmpuint (g_list_length (gdk_event_get_motion_history (event)), ==, 1);
+  gdk_event_free (event);
+
+  event = gdk_event_get ();
+  g_assert_cmpint ((gint) event->motion.x, ==, 2);
+  g_assert (gdk_event_get_motion_history (event) == NULL);
+  gdk_event_free (event);
+
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Motion/Compression", test_compression);
+  g_test_add_func ("/Motion/CompressionBoundaries", test_compression_boundaries);
+
+  return g_test_run ();
+}
@@ -0,0 +1,148 @@
+/* RC file cache tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include "gtk/gtkrccache.h"
+
+/* The first style compiles to a style record, the second one
+ * depends on a symbolic color and is kept as text
+ */
+static const gchar *rc_text =
+  "color \"cache_blue\" = \"#0000ff\"\n"
+  "style \"cache-plain\"\n"
+  "{\n"
+  "  bg[NORMAL] = \"#ff0000\"\n"
+  "  xthickness = 7\n"
+  "}\n"
+  "style \"cache-symbolic\" = \"cache-plain\"\n"
+  "{\n"
+  "  fg[NORMAL] = @cache_blue\n"
+  "}\n"
+  "widget \"*.cache-plain\" style \"cache-plain\"\n"
+  "widget \"*.cache-symbolic\" style \"cache-symbolic\"\n";
+
+static gchar *
+write_rc_file (const gchar *contents)
+{
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp ("gtkrc-XXXXXX", &filename, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+
+  g_assert (g_file_set_contents (filename, contents, -1, NULL));
+
+  return filename;
+}
+
+static GtkStyle *
+get_style (const gchar *path)
+{
+  return gtk_rc_get_style_by_paths (gtk_settings_get_default (),
+				    path, NULL, GTK_TYPE_LABEL);
+}
+
+static void
+test_load (void)
+{
+  GError *error = NULL;
+  struct stat statbuf;
+  struct utimbuf times;
+  gchar *filename, *cache_file, *changed;
+  GtkStyle *style;
+
+  filename = write_rc_file (rc_text);
+  cache_file = g_strconcat (filename, ".cache", NULL);
+
+  g_assert (_gtk_rc_compile_file (filename, cache_file, &error));
+  g_assert (error == NULL);
+  g_assert (g_file_test (cache_file, G_FILE_TEST_IS_REGULAR));
+
+  /* Change the text without changing size or mtime, so the
+   * results below can only come from the cache
+   */
+  g_assert (g_stat (filename, &statbuf) == 0);
+  changed = g_strdup (rc_text);
+  memcpy (strstr (changed, "#ff0000"), "#00ff00", 7);
+  g_assert (g_file_set_contents (filename, changed, -1, NULL));
+  times.actime = statbuf.st_atime;
+  times.modtime = statbuf.st_mtime;
+  g_assert (utime (filename, &times) == 0);
+
+  gtk_rc_parse (filename);
+
+  style = get_style ("window.cache-plain");
+  g_assert (style != NULL);
+  g_assert_cmpuint (style->bg[GTK_STATE_NORMAL].red, ==, 0xffff);
+  g_assert_cmpuint (style->bg[GTK_STATE_NORMAL].green, ==, 0);
+  g_assert_cmpint (style->xthickness, ==, 7);
+
+  style = get_style ("window.cache-symbolic");
+  g_assert (style != NULL);
+  g_assert_cmpuint (style->bg[GTK_STATE_NORMAL].red, ==, 0xffff);
+  g_assert_cmpuint (style->fg[GTK_STATE_NORMAL].blue, ==, 0xffff);
+  g_assert_cmpint (style->xthickness, ==, 7);
+
+  g_unlink (cache_file);
+  g_unlink (filename);
+  g_free (changed);
+  g_free (cache_file);
+  g_free (filename);
+}
+
+static void
+test_invalid (void)
+{
+  GError *error = NULL;
+  gchar *filename, *cache_file;
+
+  filename = write_rc_file ("style \"cache-broken\" {\n  bg[NORMAL] = \n");
+  cache_file = g_strconcat (filename, ".cache", NULL);
+
+  g_assert (!_gtk_rc_compile_file (filename, cache_file, &error));
+  g_assert (error != NULL);
+  g_assert (error->domain == G_FILE_ERROR && error->code == G_FILE_ERROR_INVAL);
+  g_assert (!g_file_test (cache_file, G_FILE_TEST_EXISTS));
+
+  g_error_free (error);
+  g_unlink (filename);
+  g_free (cache_file);
+  g_free (filename);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  /* make sure there is a context for gtk_rc_parse() to fill */
+  gtk_settings_get_default ();
+
+  g_test_add_func ("/RcCache/Load", test_load);
+  g_test_add_func ("/RcCache/Invalid", test_invalid);
+
+  return g_test_run ();
+}
@@ -0,0 +1,116 @@
+/* X server round trip tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+
+/* With GDK_DEBUG=roundtrips, GDK logs a message for each
+ * request that waits for the X server
+ */
+static guint n_round_trips = 0;
+
+static void
+count_round_trips (const gchar    *log_domain,
+                   GLogLevelFlags  log_level,
+                   const gchar    *message,
+                   gpointer        data)
+{
+  if (g_str_has_prefix (message, "round trip "))
+    n_round_trips++;
+}
+
+static Window
+create_foreign_window (void)
+{
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  Window xwindow;
+
+  xwindow = XCreateSimpleWindow (xdisplay, DefaultRootWindow (xdisplay),
+                                 10, 20, 100, 50, 0, 0, 0);
+  XSync (xdisplay, False);
+
+  return xwindow;
+}
+
+static void
+test_foreign_window (void)
+{
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  GdkWindow *window;
+  Window xwindow;
+  gint x, y, width, height;
+
+  xwindow = create_foreign_window ();
+
+  n_round_trips = 0;
+  window = gdk_window_foreign_new (xwindow);
+  g_assert (window != NULL);
+  g_assert_cmpuint (n_round_trips, ==, 1);
+
+  gdk_window_get_position (window, &x, &y);
+  gdk_drawable_get_size (window, &width, &height);
+  g_assert_cmpint (x, ==, 10);
+  g_assert_cmpint (y, ==, 20);
+  g_assert_cmpint (width, ==, 100);
+  g_assert_cmpint (height, ==, 50);
+
+  n_round_trips = 0;
+  g_assert (gdk_drawable_get_colormap (window) != NULL);
+  g_assert_cmpuint (n_round_trips, ==, 1);
+
+  g_object_unref (window);
+  XDestroyWindow (xdisplay, xwindow);
+}
+
+static void
+test_destroyed_foreign_window (void)
+{
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  Window xwindow;
+
+  /* the BadWindow error must be trapped, not reach the
+   * default error handler
+   */
+  xwindow = create_foreign_window ();
+  XDestroyWindow (xdisplay, xwindow);
+  XSync (xdisplay, False);
+
+  n_round_trips = 0;
+  g_assert (gdk_window_foreign_new (xwindow) == NULL);
+  g_assert_cmpuint (n_round_trips, ==, 1);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_setenv ("GDK_DEBUG", "roundtrips", TRUE);
+  gtk_test_init (&argc, &argv);
+
+  g_log_set_handler ("Gdk", G_LOG_LEVEL_MESSAGE, count_round_trips, NULL);
+
+  /* GDK only counts round trips when built with debugging
+   */
+  gdk_display_sync (gdk_display_get_default ());
+  if (n_round_trips == 0)
+    return 0;
+
+  g_test_add_func ("/RoundTrips/ForeignWindow", test_foreign_window);
+  g_test_add_func ("/RoundTrips/DestroyedForeignWindow", test_destroyed_foreign_window);
+
+  return g_test_run ();
+}
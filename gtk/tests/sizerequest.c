@@ -0,0 +1,109 @@
+/* Size request caching tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static gboolean
+record_request (GSignalInvocationHint *ihint,
+                guint                  n_param_values,
+                const GValue          *param_values,
+                gpointer               data)
+{
+  GHashTable *requested = data;
+
+  g_hash_table_insert (requested, g_value_get_object (&param_values[0]), NULL);
+
+  return TRUE;
+}
+
+#define REQUESTED(widget) g_hash_table_lookup_extended (requested, widget, NULL, NULL)
+
+static void
+test_request_cutoff (void)
+{
+  GtkWidget *window, *vbox, *hbox1, *hbox2;
+  GtkWidget *label1, *label2, *label3;
+  GHashTable *requested;
+  guint signal_id;
+  gulong hook_id;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  vbox = gtk_vbox_new (FALSE, 0);
+  hbox1 = gtk_hbox_new (FALSE, 0);
+  hbox2 = gtk_hbox_new (FALSE, 0);
+  label1 = gtk_label_new ("one");
+  label2 = gtk_label_new ("two");
+  label3 = gtk_label_new ("three");
+
+  gtk_container_add (GTK_CONTAINER (window), vbox);
+  gtk_box_pack_start (GTK_BOX (vbox), hbox1, FALSE, FALSE, 0);
+  gtk_box_pack_start (GTK_BOX (vbox), hbox2, FALSE, FALSE, 0);
+  gtk_box_pack_start (GTK_BOX (hbox1), label1, FALSE, FALSE, 0);
+  gtk_box_pack_start (GTK_BOX (hbox1), label2, FALSE, FALSE, 0);
+  gtk_box_pack_start (GTK_BOX (hbox2), label3, FALSE, FALSE, 0);
+  gtk_widget_show_all (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  requested = g_hash_table_new (NULL, NULL);
+  signal_id = g_signal_lookup ("size-request", GTK_TYPE_WIDGET);
+  hook_id = g_signal_add_emission_hook (signal_id, 0, record_request, requested, NULL);
+
+  /* a resize that doesn't change the request stops at the parent */
+  gtk_widget_queue_resize (label1);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert (REQUESTED (label1));
+  g_assert (REQUESTED (hbox1));
+  g_assert (!REQUESTED (vbox));
+  g_assert (!REQUESTED (window));
+  g_assert (!REQUESTED (label2));
+  g_assert (!REQUESTED (hbox2));
+  g_assert (!REQUESTED (label3));
+
+  /* a new request goes up to the toplevel, but not to the siblings */
+  g_hash_table_remove_all (requested);
+  gtk_label_set_text (GTK_LABEL (label1), "a much longer text");
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert (REQUESTED (label1));
+  g_assert (REQUESTED (hbox1));
+  g_assert (REQUESTED (vbox));
+  g_assert (REQUESTED (window));
+  g_assert (!REQUESTED (label2));
+  g_assert (!REQUESTED (hbox2));
+  g_assert (!REQUESTED (label3));
+  g_assert_cmpint (vbox->requisition.width, >=, label1->requisition.width);
+
+  g_signal_remove_emission_hook (signal_id, hook_id);
+  g_hash_table_destroy (requested);
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/SizeRequest/Cutoff", test_request_cutoff);
+
+  return g_test_run ();
+}
@@ -0,0 +1,75 @@
+/* GtkStyle sharing tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static void
+test_modify_sharing (void)
+{
+  GdkColor red = { 0, 0xffff, 0, 0 };
+  GdkColor blue = { 0, 0, 0, 0xffff };
+  GtkWidget *plain, *a, *b;
+  GtkStyle *plain_style;
+
+  plain = g_object_ref_sink (gtk_label_new ("plain"));
+  a = g_object_ref_sink (gtk_label_new ("a"));
+  b = g_object_ref_sink (gtk_label_new ("b"));
+
+  gtk_widget_ensure_style (plain);
+  plain_style = gtk_widget_get_style (plain);
+
+  /* equal modifications give one style */
+  gtk_widget_modify_fg (a, GTK_STATE_NORMAL, &red);
+  gtk_widget_modify_fg (b, GTK_STATE_NORMAL, &red);
+  gtk_widget_ensure_style (a);
+  gtk_widget_ensure_style (b);
+  g_assert (gtk_widget_get_style (a) == gtk_widget_get_style (b));
+  g_assert (gtk_widget_get_style (a) != plain_style);
+  g_assert (gdk_color_equal (&gtk_widget_get_style (a)->fg[GTK_STATE_NORMAL], &red));
+
+  /* changing one of them leaves the other alone */
+  gtk_widget_modify_fg (b, GTK_STATE_NORMAL, &blue);
+  g_assert (gtk_widget_get_style (a) != gtk_widget_get_style (b));
+  g_assert (gdk_color_equal (&gtk_widget_get_style (a)->fg[GTK_STATE_NORMAL], &red));
+  g_assert (gdk_color_equal (&gtk_widget_get_style (b)->fg[GTK_STATE_NORMAL], &blue));
+
+  /* and changing it back shares again */
+  gtk_widget_modify_fg (b, GTK_STATE_NORMAL, &red);
+  g_assert (gtk_widget_get_style (a) == gtk_widget_get_style (b));
+
+  /* the shared style outlives the widget it was made for */
+  g_object_unref (a);
+  g_assert (gdk_color_equal (&gtk_widget_get_style (b)->fg[GTK_STATE_NORMAL], &red));
+
+  gtk_widget_modify_fg (b, GTK_STATE_NORMAL, NULL);
+  g_assert (gdk_color_equal (&gtk_widget_get_style (b)->fg[GTK_STATE_NORMAL],
+                             &plain_style->fg[GTK_STATE_NORMAL]));
+
+  g_object_unref (b);
+  g_object_unref (plain);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/Style/ModifySharing", test_modify_sharing);
+
+  return g_test_run ();
+}
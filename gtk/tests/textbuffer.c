@@ -22,8 +22,13 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef HAVE_MALLINFO
+#include <malloc.h>
+#endif
+
 #include <gtk/gtk.h>
 #include "gtk/gtktexttypes.h" /* Private header, for UNKNOWN_CHAR */
+#include "gtk/gtktextbtree.h" /* Private header, for the line structures */
 
 static void
 gtk_text_iter_spew (const GtkTextIter *iter, const gchar *desc)
@@ -1284,6 +1289,404 @@ test_tag (void)
   g_object_unref (buffer);
 }
 
+/* Copies the contents of @buffer to a new buffer through the
+ * rich text format
+ */
+static GtkTextBuffer *
+serialize_roundtrip (GtkTextBuffer *buffer,
+                     gboolean       compact,
+                     gboolean       use_streams)
+{
+  GtkTextBuffer *buffer2;
+  GtkTextIter start, end, iter;
+  GdkAtom serialize_format, deserialize_format;
+  GError *error = NULL;
+  gboolean retval;
+
+  buffer2 = gtk_text_buffer_new (NULL);
+
+  if (compact)
+    {
+      serialize_format = gtk_text_buffer_register_serialize_compact_tagset (buffer, "test");
+      deserialize_format = gtk_text_buffer_register_deserialize_compact_tagset (buffer2, "test");
+    }
+  else
+    {
+      serialize_format = gtk_text_buffer_register_serialize_tagset (buffer, "test");
+      deserialize_format = gtk_text_buffer_register_deserialize_tagset (buffer2, "test");
+    }
+
+  gtk_text_buffer_deserialize_set_can_create_tags (buffer2, deserialize_format, TRUE);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_get_start_iter (buffer2, &iter);
+
+  if (use_streams)
+    {
+      GOutputStream *output;
+      GInputStream *input;
+
+      output = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+      retval = gtk_text_buffer_serialize_to_stream (buffer, buffer,
+                                                    serialize_format,
+                                                    &start, &end,
+                                                    output, NULL, &error);
+      g_assert (error == NULL);
+      g_assert (retval);
+      g_output_stream_close (output, NULL, NULL);
+
+      input = g_memory_input_stream_new_from_data (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (output)),
+                                                   g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (output)),
+                                                   NULL);
+      retval = gtk_text_buffer_deserialize_from_stream (buffer2, buffer2,
+                                                        deserialize_format,
+                                                        &iter, input,
+                                                        NULL, &error);
+      g_object_unref (input);
+      g_object_unref (output);
+    }
+  else
+    {
+      guint8 *data;
+      gsize length;
+
+      data = gtk_text_buffer_serialize (buffer, buffer, serialize_format,
+                                        &start, &end, &length);
+      retval = gtk_text_buffer_deserialize (buffer2, buffer2,
+                                            deserialize_format, &iter,
+                                            data, length, &error);
+      g_free (data);
+    }
+
+  g_assert (error == NULL);
+  g_assert (retval);
+
+  return buffer2;
+}
+
+static void
+check_serialize_roundtrip (GtkTextBuffer *buffer,
+                           gboolean       compact,
+                           gboolean       use_streams)
+{
+  GtkTextBuffer *buffer2;
+  GtkTextIter start, end, iter;
+  gchar *text, *text2;
+
+  buffer2 = serialize_roundtrip (buffer, compact, use_streams);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+  gtk_text_buffer_get_bounds (buffer2, &start, &end);
+  text2 = gtk_text_buffer_get_slice (buffer2, &start, &end, TRUE);
+
+  g_assert_cmpstr (text, ==, text2);
+
+  /* The pixbufs were inserted in the right places */
+  gtk_text_buffer_get_start_iter (buffer2, &iter);
+  g_assert (gtk_text_iter_get_pixbuf (&iter) != NULL);
+
+  /* The tags made it over */
+  g_assert (gtk_text_tag_table_lookup (gtk_text_buffer_get_tag_table (buffer2),
+                                       "fg_blue") != NULL);
+
+  g_free (text);
+  g_free (text2);
+
+  g_object_unref (buffer2);
+}
+
+static void
+test_serialize (void)
+{
+  GtkTextBuffer *buffer;
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  fill_buffer (buffer);
+
+  check_serialize_roundtrip (buffer, FALSE, FALSE);
+  check_serialize_roundtrip (buffer, FALSE, TRUE);
+  check_serialize_roundtrip (buffer, TRUE, FALSE);
+  check_serialize_roundtrip (buffer, TRUE, TRUE);
+
+  g_object_unref (buffer);
+}
+
+static void
+test_bulk_lines (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GtkTextTag *tag;
+  GString *expected;
+  gchar *text;
+  gint i;
+
+  /* Lines inserted in bulk, then tagged, marked, deleted and
+   * edited in the middle.
+   */
+  expected = g_string_new (NULL);
+  for (i = 0; i < 2000; i++)
+    g_string_append_printf (expected, "line %d\n", i);
+
+  buffer = gtk_text_buffer_new (NULL);
+  tag = gtk_text_buffer_create_tag (buffer, "bold", "weight", PANGO_WEIGHT_BOLD, NULL);
+  gtk_text_buffer_set_text (buffer, expected->str, expected->len);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 2001);
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 500, 2);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &end, 500, 4);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  gtk_text_buffer_create_mark (buffer, "mark", &start, TRUE);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 100);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 200);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  g_string_erase (expected,
+                  strlen ("line 0\n") * 10 + strlen ("line 10\n") * 90,
+                  strlen ("line 100\n") * 100);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 1000);
+  gtk_text_buffer_insert (buffer, &start, "x", 1);
+  g_string_insert_c (expected,
+                     strlen ("line 0\n") * 10 + strlen ("line 10\n") * 90 +
+                     strlen ("line 200\n") * 800 + strlen ("line 1000\n") * 100,
+                     'x');
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, expected->str);
+  g_free (text);
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &start,
+                                    gtk_text_buffer_get_mark (buffer, "mark"));
+  g_assert_cmpint (gtk_text_iter_get_line (&start), ==, 400);
+  g_assert (gtk_text_iter_has_tag (&start, tag));
+
+  g_string_free (expected, TRUE);
+  g_object_unref (buffer);
+}
+
+#ifdef HAVE_MALLINFO
+static glong
+memory_in_use (void)
+{
+  struct mallinfo info = mallinfo ();
+
+  return info.uordblks + info.hblkhd;
+}
+#endif
+
+static void
+test_bytes_per_line (void)
+{
+#ifdef HAVE_MALLINFO
+  const gint n_lines = 20000;
+  const gint line_length = 40;
+  GtkTextBuffer *buffer;
+  GString *text;
+  glong before;
+  gdouble bytes, packed;
+  gint i, j;
+
+  text = g_string_sized_new (n_lines * (line_length + 1));
+  for (i = 0; i < n_lines; i++)
+    {
+      for (j = 0; j < line_length; j++)
+        g_string_append_c (text, 'a' + (i + j) % 26);
+      g_string_append_c (text, '\n');
+    }
+
+  before = memory_in_use ();
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  bytes = (gdouble) (memory_in_use () - before) / n_lines;
+
+  g_test_minimized_result (bytes, "%.1f bytes per line of %d characters",
+                           bytes, line_length);
+
+  /* A plain line is a GtkTextLine and one char segment, plus a
+   * share of its btree node. Both come from g_slice, which packs
+   * them without a header each; with per-block headers or extra
+   * segments a line exceeds this.
+   */
+  packed = sizeof (GtkTextLine) +
+           G_STRUCT_OFFSET (GtkTextLineSegment, body) + line_length + 1;
+  if (g_getenv ("G_SLICE") == NULL)
+    g_assert_cmpfloat (bytes, <, packed + 8 * sizeof (gpointer));
+
+  g_object_unref (buffer);
+  g_string_free (text, TRUE);
+#endif
+}
+
+static void
+check_tagged_pixbuf_roundtrip (GtkTextBuffer *buffer,
+                               gboolean       compact,
+                               gboolean       use_streams)
+{
+  GtkTextBuffer *buffer2;
+  GtkTextTag *tag;
+  GtkTextIter iter;
+
+  buffer2 = serialize_roundtrip (buffer, compact, use_streams);
+
+  tag = gtk_text_tag_table_lookup (gtk_text_buffer_get_tag_table (buffer2),
+                                   "fg_blue");
+  g_assert (tag != NULL);
+
+  /* "a", pixbuf, pixbuf, "b"; only the pixbufs are tagged */
+  gtk_text_buffer_get_start_iter (buffer2, &iter);
+  g_assert (!gtk_text_iter_has_tag (&iter, tag));
+  gtk_text_iter_forward_char (&iter);
+  g_assert (gtk_text_iter_get_pixbuf (&iter) != NULL);
+  g_assert (gtk_text_iter_has_tag (&iter, tag));
+  gtk_text_iter_forward_char (&iter);
+  g_assert (gtk_text_iter_get_pixbuf (&iter) != NULL);
+  g_assert (gtk_text_iter_has_tag (&iter, tag));
+  gtk_text_iter_forward_char (&iter);
+  g_assert_cmpint (gtk_text_iter_get_char (&iter), ==, 'b');
+  g_assert (!gtk_text_iter_has_tag (&iter, tag));
+
+  g_object_unref (buffer2);
+}
+
+static void
+test_serialize_tagged_pixbuf (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GdkPixbuf *pixbuf;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_create_tag (buffer, "fg_blue", "foreground", "blue", NULL);
+
+  pixbuf = gdk_pixbuf_new_from_xpm_data (book_closed_xpm);
+  gtk_text_buffer_set_text (buffer, "ab", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_insert_pixbuf (buffer, &start, pixbuf);
+  gtk_text_buffer_insert_pixbuf (buffer, &start, pixbuf);
+  g_object_unref (pixbuf);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 3);
+  gtk_text_buffer_apply_tag_by_name (buffer, "fg_blue", &start, &end);
+
+  check_tagged_pixbuf_roundtrip (buffer, FALSE, FALSE);
+  check_tagged_pixbuf_roundtrip (buffer, FALSE, TRUE);
+  check_tagged_pixbuf_roundtrip (buffer, TRUE, FALSE);
+  check_tagged_pixbuf_roundtrip (buffer, TRUE, TRUE);
+
+  g_object_unref (buffer);
+}
+
+static void
+batch_changed_cb (GtkTextBuffer       *buffer,
+                  guint                n_changes,
+                  GtkTextBufferChange *changes,
+                  GArray              *result)
+{
+  g_array_set_size (result, 0);
+  g_array_append_vals (result, changes, n_changes);
+}
+
+static void
+check_change (GArray *result,
+              guint   i,
+              gint    offset,
+              gint    n_inserted,
+              gint    n_deleted)
+{
+  GtkTextBufferChange *change;
+
+  g_assert_cmpuint (i, <, result->len);
+  change = &g_array_index (result, GtkTextBufferChange, i);
+
+  g_assert_cmpint (change->offset, ==, offset);
+  g_assert_cmpint (change->n_inserted, ==, n_inserted);
+  g_assert_cmpint (change->n_deleted, ==, n_deleted);
+}
+
+static void
+test_batch_changed (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GArray *result;
+
+  buffer = gtk_text_buffer_new (NULL);
+  result = g_array_new (FALSE, FALSE, sizeof (GtkTextBufferChange));
+
+  /* Changes without handlers are not collected */
+  gtk_text_buffer_set_text (buffer, "0123456789", -1);
+  gtk_text_buffer_flush_changes (buffer);
+
+  g_signal_connect (buffer, "batch-changed",
+                    G_CALLBACK (batch_changed_cb), result);
+
+  /* Typing coalesces into one range */
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 2);
+  gtk_text_buffer_insert (buffer, &start, "a", -1);
+  gtk_text_buffer_insert (buffer, &start, "b", -1);
+  gtk_text_buffer_insert (buffer, &start, "\xc3\xa9", -1);
+  g_assert_cmpuint (result->len, ==, 0);
+  gtk_text_buffer_end_user_action (buffer);
+
+  g_assert_cmpuint (result->len, ==, 1);
+  check_change (result, 0, 2, 3, 0);
+
+  /* Separate ranges stay separate and are shifted */
+  g_array_set_size (result, 0);
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 10);
+  gtk_text_buffer_insert (buffer, &start, "xy", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 0);
+  gtk_text_buffer_insert (buffer, &start, "z", -1);
+  gtk_text_buffer_end_user_action (buffer);
+
+  g_assert_cmpuint (result->len, ==, 2);
+  check_change (result, 0, 0, 1, 0);
+  check_change (result, 1, 11, 2, 0);
+
+  /* Deleting part of an insertion and some old text */
+  g_array_set_size (result, 0);
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 4);
+  gtk_text_buffer_insert (buffer, &start, "ABC", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 6);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 9);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_end_user_action (buffer);
+
+  g_assert_cmpuint (result->len, ==, 1);
+  check_change (result, 4, 2, 2);
+
+  /* Inserting and deleting the same text cancels out */
+  g_array_set_size (result, 0);
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_insert (buffer, &start, "QQ", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 3);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_end_user_action (buffer);
+
+  g_assert_cmpuint (result->len, ==, 0);
+
+  /* Outside of user actions, changes are flushed later */
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_insert (buffer, &end, "!", -1);
+  g_assert_cmpuint (result->len, ==, 0);
+  gtk_text_buffer_flush_changes (buffer);
+  g_assert_cmpuint (result->len, ==, 1);
+  check_change (result, 0, gtk_text_buffer_get_char_count (buffer) - 1, 1, 0);
+
+  g_array_free (result, TRUE);
+  g_object_unref (buffer);
+}
+
 extern void pixbuf_init (void);
 
 int
@@ -1303,6 +1706,11 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
+  g_test_add_func ("/TextBuffer/Bulk lines", test_bulk_lines);
+  g_test_add_func ("/TextBuffer/Bytes per line", test_bytes_per_line);
+  g_test_add_func ("/TextBuffer/Serialize", test_serialize);
+  g_test_add_func ("/TextBuffer/Serialize tagged pixbuf", test_serialize_tagged_pixbuf);
+  g_test_add_func ("/TextBuffer/Batch changed", test_batch_changed);
   
   return g_test_run();
 }
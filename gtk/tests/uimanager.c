@@ -0,0 +1,156 @@
+/* UI manager tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static GtkActionEntry entries[] = {
+  { "File", NULL, "_File" },
+  { "Open", GTK_STOCK_OPEN, NULL, NULL, NULL, NULL },
+  { "Save", GTK_STOCK_SAVE, NULL, NULL, NULL, NULL },
+  { "Quit", GTK_STOCK_QUIT, NULL, NULL, NULL, NULL }
+};
+
+#define UI_INFO(action)					\
+  "<ui>"						\
+  "  <menubar name='MenuBar'>"				\
+  "    <menu action='File'>"				\
+  "      <menuitem name='Item' action='" action "'/>"	\
+  "    </menu>"						\
+  "  </menubar>"					\
+  "  <toolbar name='ToolBar'>"				\
+  "    <toolitem name='Item' action='" action "'/>"	\
+  "  </toolbar>"					\
+  "</ui>"
+
+static GtkUIManager *
+create_ui_manager (void)
+{
+  GtkUIManager *manager;
+  GtkActionGroup *group;
+
+  group = gtk_action_group_new ("Actions");
+  gtk_action_group_add_actions (group, entries, G_N_ELEMENTS (entries), NULL);
+
+  /* Open is the plain one, Save is insensitive and Quit hidden */
+  gtk_action_set_sensitive (gtk_action_group_get_action (group, "Save"), FALSE);
+  gtk_action_set_visible (gtk_action_group_get_action (group, "Quit"), FALSE);
+
+  manager = gtk_ui_manager_new ();
+  gtk_ui_manager_insert_action_group (manager, group, 0);
+  g_object_unref (group);
+
+  return manager;
+}
+
+static guint
+merge (GtkUIManager *manager,
+       const gchar  *ui_info)
+{
+  GError *error = NULL;
+  guint merge_id;
+
+  merge_id = gtk_ui_manager_add_ui_from_string (manager, ui_info, -1, &error);
+  g_assert (error == NULL);
+  g_assert (merge_id != 0);
+  gtk_ui_manager_ensure_update (manager);
+
+  return merge_id;
+}
+
+static void
+unmerge (GtkUIManager *manager,
+         guint         merge_id)
+{
+  gtk_ui_manager_remove_ui (manager, merge_id);
+  gtk_ui_manager_ensure_update (manager);
+}
+
+static void
+check_proxy (GtkUIManager *manager,
+             const gchar  *path,
+             GtkWidget    *expected,
+             const gchar  *action_name)
+{
+  GtkWidget *proxy;
+  GtkAction *action;
+
+  proxy = gtk_ui_manager_get_widget (manager, path);
+  action = gtk_ui_manager_get_action (manager, path);
+
+  g_assert (proxy == expected);
+  g_assert_cmpstr (gtk_action_get_name (action), ==, action_name);
+  g_assert (gtk_widget_get_action (proxy) == action);
+  g_assert (GTK_WIDGET_VISIBLE (proxy) == gtk_action_get_visible (action));
+  g_assert (GTK_WIDGET_SENSITIVE (proxy) == gtk_action_get_sensitive (action));
+}
+
+/* Items that are removed are pooled and reconnected to the action
+ * of the next merge, which has to set them up like new ones
+ */
+static void
+test_proxy_reuse (void)
+{
+  GtkUIManager *manager;
+  GtkWidget *menu_item, *tool_item;
+  guint merge_id;
+
+  manager = create_ui_manager ();
+
+  merge_id = merge (manager, UI_INFO ("Open"));
+  menu_item = g_object_ref (gtk_ui_manager_get_widget (manager, "/MenuBar/File/Item"));
+  tool_item = g_object_ref (gtk_ui_manager_get_widget (manager, "/ToolBar/Item"));
+  check_proxy (manager, "/MenuBar/File/Item", menu_item, "Open");
+  check_proxy (manager, "/ToolBar/Item", tool_item, "Open");
+
+  unmerge (manager, merge_id);
+  g_assert (gtk_ui_manager_get_widget (manager, "/MenuBar/File/Item") == NULL);
+  g_assert (menu_item->parent == NULL);
+  g_assert (tool_item->parent == NULL);
+
+  merge_id = merge (manager, UI_INFO ("Save"));
+  check_proxy (manager, "/MenuBar/File/Item", menu_item, "Save");
+  check_proxy (manager, "/ToolBar/Item", tool_item, "Save");
+  g_assert (!GTK_WIDGET_SENSITIVE (menu_item));
+  unmerge (manager, merge_id);
+
+  merge_id = merge (manager, UI_INFO ("Quit"));
+  check_proxy (manager, "/MenuBar/File/Item", menu_item, "Quit");
+  check_proxy (manager, "/ToolBar/Item", tool_item, "Quit");
+  g_assert (!GTK_WIDGET_VISIBLE (menu_item));
+  unmerge (manager, merge_id);
+
+  merge_id = merge (manager, UI_INFO ("Open"));
+  check_proxy (manager, "/MenuBar/File/Item", menu_item, "Open");
+  check_proxy (manager, "/ToolBar/Item", tool_item, "Open");
+  g_assert (GTK_WIDGET_VISIBLE (menu_item));
+  g_assert (GTK_WIDGET_SENSITIVE (menu_item));
+
+  g_object_unref (menu_item);
+  g_object_unref (tool_item);
+  g_object_unref (manager);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/UIManager/ProxyReuse", test_proxy_reuse);
+
+  return g_test_run ();
+}
@@ -0,0 +1,103 @@
+/* updatebuildercache.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib-object.h>
+
+#include "gtk/gtkbuilderprivate.h"
+
+static gboolean quiet = FALSE;
+
+static GOptionEntry args[] = {
+  { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet, N_("Turn off verbose output"), NULL },
+  { NULL }
+};
+
+static gboolean
+update_ui_file (const gchar *filename)
+{
+  GError *error = NULL;
+  gchar *cache_file;
+  gboolean retval;
+
+  cache_file = g_strconcat (filename, GTK_BUILDER_CACHE_SUFFIX, NULL);
+
+  retval = _gtk_builder_compile_file (filename, cache_file, &error);
+  if (!retval)
+    {
+      if (!quiet)
+	g_printerr (_("Failed to write cache file %s: %s\n"), cache_file, error->message);
+      g_error_free (error);
+    }
+  else if (!quiet)
+    g_printerr (_("Cache file created successfully: %s\n"), cache_file);
+
+  g_free (cache_file);
+
+  return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  gint status = 0;
+  gint i;
+
+  setlocale (LC_ALL, "");
+
+  bindtextdomain (GETTEXT_PACKAGE, GTK_LOCALEDIR);
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+
+  g_type_init ();
+
+  context = g_option_context_new ("UIFILE...");
+  g_option_context_add_main_entries (context, args, GETTEXT_PACKAGE);
+
+  g_option_context_parse (context, &argc, &argv, NULL);
+
+  if (argc < 2)
+    return 0;
+
+  for (i = 1; i < argc; i++)
+    {
+      gchar *path = argv[i];
+
+#ifdef G_OS_WIN32
+      path = g_locale_to_utf8 (path, -1, NULL, NULL, NULL);
+#endif
+
+      if (!update_ui_file (path))
+	status = 1;
+
+#ifdef G_OS_WIN32
+      g_free (path);
+#endif
+    }
+
+  g_option_context_free (context);
+
+  return status;
+}
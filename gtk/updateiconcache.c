@@ -48,6 +48,8 @@ static gboolean ignore_theme_index = FALSE;
 static gboolean quiet = FALSE;
 static gboolean index_only = FALSE;
 static gboolean validate = FALSE;
+static gboolean size_table = FALSE;
+static gboolean render_scalable = FALSE;
 static gchar *var_name = "-";
 
 /* Quite ugly - if we just add the c file to the
@@ -66,6 +68,10 @@ static gchar *var_name = "-";
 #define MINOR_VERSION 0
 #define HASH_OFFSET 12
 
+/* Caches with a size table use a longer header */
+#define SIZE_TABLE_MINOR_VERSION 1
+#define SIZE_TABLE_HASH_OFFSET 16
+
 #define ALIGN_VALUE(this, boundary) \
   (( ((unsigned long)(this)) + (((unsigned long)(boundary)) -1)) & (~(((unsigned long)(boundary))-1)))
 
@@ -163,12 +169,132 @@ has_theme_index (const gchar *path)
 }
 
 
+/* The size information of a directory, as found in index.theme.
+ * The type values are 0 for Fixed, 1 for Scalable and 2 for
+ * Threshold, order is the position of the directory in the
+ * Directories key or 0xffff if it isn't listed there.
+ */
+typedef struct
+{
+  guint16 order;
+  guint16 type;
+  guint16 size;
+  guint16 min_size;
+  guint16 max_size;
+  guint16 threshold;
+} DirSize;
+
+static DirSize *dir_sizes = NULL;
+static gint n_dir_sizes = 0;
+
+static gint
+get_key_file_integer (GKeyFile    *key_file,
+		      const gchar *group,
+		      const gchar *key,
+		      gint         default_value)
+{
+  GError *error = NULL;
+  gint value;
+
+  value = g_key_file_get_integer (key_file, group, key, &error);
+  if (error)
+    {
+      g_error_free (error);
+      return default_value;
+    }
+
+  return CLAMP (value, 0, G_MAXUINT16);
+}
+
+/* Looks up the index.theme data of all directories that
+ * ended up in the cache, with the same defaults that GTK+
+ * uses when it loads the theme.
+ */
+static gboolean
+load_dir_sizes (const gchar *path,
+		GList       *directories)
+{
+  GKeyFile *theme_file;
+  gchar *index_path;
+  gchar **dirs;
+  GList *d;
+  gint i, j;
+
+  index_path = g_build_filename (path, "index.theme", NULL);
+  theme_file = g_key_file_new ();
+  g_key_file_set_list_separator (theme_file, ',');
+
+  if (!g_key_file_load_from_file (theme_file, index_path, 0, NULL))
+    {
+      g_key_file_free (theme_file);
+      g_free (index_path);
+      return FALSE;
+    }
+  g_free (index_path);
+
+  dirs = g_key_file_get_string_list (theme_file, "Icon Theme", "Directories", NULL, NULL);
+
+  n_dir_sizes = g_list_length (directories);
+  dir_sizes = g_new0 (DirSize, n_dir_sizes);
+
+  for (d = directories, i = 0; d; d = d->next, i++)
+    {
+      const gchar *subdir = d->data;
+      DirSize *dir_size = &dir_sizes[i];
+      gchar *type;
+
+      dir_size->order = 0xffff;
+
+      for (j = 0; dirs && dirs[j]; j++)
+	{
+	  if (strcmp (dirs[j], subdir) == 0)
+	    break;
+	}
+
+      if (dirs == NULL || dirs[j] == NULL ||
+	  !g_key_file_has_key (theme_file, subdir, "Size", NULL))
+	continue;
+
+      dir_size->order = MIN (j, 0xfffe);
+      dir_size->size = get_key_file_integer (theme_file, subdir, "Size", 0);
+      dir_size->min_size = get_key_file_integer (theme_file, subdir, "MinSize", dir_size->size);
+      dir_size->max_size = get_key_file_integer (theme_file, subdir, "MaxSize", dir_size->size);
+      dir_size->threshold = get_key_file_integer (theme_file, subdir, "Threshold", 2);
+
+      dir_size->type = 2;
+      type = g_key_file_get_string (theme_file, subdir, "Type", NULL);
+      if (type)
+	{
+	  if (strcmp (type, "Fixed") == 0)
+	    dir_size->type = 0;
+	  else if (strcmp (type, "Scalable") == 0)
+	    dir_size->type = 1;
+	  g_free (type);
+	}
+    }
+
+  g_strfreev (dirs);
+  g_key_file_free (theme_file);
+
+  return TRUE;
+}
+
+/* The pixel sizes at which scalable icons are rendered,
+ * those of the predefined GtkIconSizes
+ */
+static const gint scalable_sizes[] = { 16, 18, 20, 24, 32, 48 };
+
 typedef struct 
 {
   GdkPixdata pixdata;
   gboolean has_pixdata;
   guint32 offset;
   guint size;
+
+  /* Renderings of a scalable icon, at scalable_sizes */
+  gint n_renders;
+  gint render_sizes[G_N_ELEMENTS (scalable_sizes)];
+  GdkPixdata renders[G_N_ELEMENTS (scalable_sizes)];
 } ImageData;
 
 typedef struct 
@@ -466,49 +592,64 @@ follow_links (const gchar *path)
   return path2;
 }
 
-static void
-maybe_cache_image_data (Image       *image, 
-			const gchar *path)
+/* Finds the ImageData that is shared by all paths
+ * which are symlinks to the same file
+ */
+static ImageData *
+lookup_image_data (const gchar *path)
 {
-  if (!index_only && !image->image_data && 
-      (g_str_has_suffix (path, ".png") || g_str_has_suffix (path, ".xpm")))
-    {
-      GdkPixbuf *pixbuf;
-      ImageData *idata;
-      gchar *path2;
+  ImageData *idata;
+  gchar *path2;
 
-      idata = g_hash_table_lookup (image_data_hash, path);
-      path2 = follow_links (path);
+  idata = g_hash_table_lookup (image_data_hash, path);
+  path2 = follow_links (path);
 
-      if (path2)
-	{
-	  ImageData *idata2;
+  if (path2)
+    {
+      ImageData *idata2;
 
-	  canonicalize_filename (path2);
+      canonicalize_filename (path2);
   
-	  idata2 = g_hash_table_lookup (image_data_hash, path2);
+      idata2 = g_hash_table_lookup (image_data_hash, path2);
 
-	  if (idata && idata2 && idata != idata2)
-	    g_error (_("different idatas found for symlinked '%s' and '%s'\n"),
-		     path, path2);
+      if (idata && idata2 && idata != idata2)
+	g_error (_("different idatas found for symlinked '%s' and '%s'\n"),
+		 path, path2);
 
-	  if (idata && !idata2)
-	    g_hash_table_insert (image_data_hash, g_strdup (path2), idata);
+      if (idata && !idata2)
+	g_hash_table_insert (image_data_hash, g_strdup (path2), idata);
 
-	  if (!idata && idata2)
-	    {
-	      g_hash_table_insert (image_data_hash, g_strdup (path), idata2);
-	      idata = idata2;
-	    }
-	}
-      
-      if (!idata)
+      if (!idata && idata2)
 	{
-	  idata = g_new0 (ImageData, 1);
-	  g_hash_table_insert (image_data_hash, g_strdup (path), idata);
-	  if (path2)
-	    g_hash_table_insert (image_data_hash, g_strdup (path2), idata);  
+	  g_hash_table_insert (image_data_hash, g_strdup (path), idata2);
+	  idata = idata2;
 	}
+    }
+      
+  if (!idata)
+    {
+      idata = g_new0 (ImageData, 1);
+      g_hash_table_insert (image_data_hash, g_strdup (path), idata);
+      if (path2)
+	g_hash_table_insert (image_data_hash, g_strdup (path2), idata);  
+    }
+
+  g_free (path2);
+
+  return idata;
+}
+
+static void
+maybe_cache_image_data (Image       *image, 
+			const gchar *path)
+{
+  if (!index_only && !image->image_data && 
+      (g_str_has_suffix (path, ".png") || g_str_has_suffix (path, ".xpm")))
+    {
+      GdkPixbuf *pixbuf;
+      ImageData *idata;
+
+      idata = lookup_image_data (path);
 
       if (!idata->has_pixdata)
 	{
@@ -523,9 +664,73 @@ maybe_cache_image_data (Image       *image,
 	}
 
       image->image_data = idata;
+    }
+}
 
-      g_free (path2);
+/* Renders a scalable icon at the sizes in scalable_sizes, the same
+ * way GTK+ renders it at runtime, so that it can be used straight
+ * from the mapped cache. Icons that also have a raster image in the
+ * same directory are skipped, since GTK+ prefers the raster image.
+ */
+static void
+maybe_render_scalable (Image       *image,
+		       const gchar *path)
+{
+  GdkPixbuf *pixbuf;
+  ImageData *idata;
+  gint i;
+
+  if (index_only || !render_scalable || image->image_data ||
+      (image->flags & HAS_SUFFIX_SVG) == 0 ||
+      (image->flags & (HAS_SUFFIX_PNG | HAS_SUFFIX_XPM)) != 0)
+    return;
+
+  idata = lookup_image_data (path);
+
+  if (!idata->has_pixdata)
+    {
+      /* Type, length and number of sizes */
+      idata->size = 12;
+
+      for (i = 0; i < G_N_ELEMENTS (scalable_sizes); i++)
+	{
+	  pixbuf = gdk_pixbuf_new_from_file_at_scale (path,
+						      scalable_sizes[i],
+						      scalable_sizes[i],
+						      TRUE, NULL);
+	  if (!pixbuf)
+	    continue;
+
+	  gdk_pixdata_from_pixbuf (&idata->renders[idata->n_renders], pixbuf, FALSE);
+	  idata->render_sizes[idata->n_renders] = scalable_sizes[i];
+	  idata->size += 8 + 8 + idata->renders[idata->n_renders].length;
+	  idata->n_renders++;
+	}
+
+      if (idata->n_renders == 0)
+	return;
+
+      idata->has_pixdata = TRUE;
     }
+
+  image->image_data = idata;
+}
+
+static void
+render_scalable_func (gpointer key, gpointer value, gpointer user_data)
+{
+  gchar *basename = key;
+  Image *image = value;
+  gchar *dir_path = user_data;
+  gchar *name, *path;
+
+  name = g_strconcat (basename, ".svg", NULL);
+  path = g_build_filename (dir_path, name, NULL);
+
+  maybe_render_scalable (image, path);
+
+  g_free (path);
+  g_free (name);
 }
 
 static void
@@ -681,6 +886,10 @@ scan_directory (const gchar *base_path,
 
   g_dir_close (dir);
 
+  /* Now that we know which icons have raster images */
+  if (render_scalable && !index_only)
+    g_hash_table_foreach (dir_hash, render_scalable_func, dir_path);
+
   /* Move dir into the big file hash */
   g_hash_table_foreach_remove (dir_hash, foreach_remove_func, files);
   
@@ -717,6 +926,24 @@ typedef struct {
   HashNode **nodes;
 } HashContext;
 
+/* With a size table, the images of an icon are sorted in the
+ * order in which the theme lists their directories, so a
+ * lookup can walk the image list instead of probing every
+ * directory of the theme.
+ */
+static gint
+compare_image_order (gconstpointer a, gconstpointer b)
+{
+  const Image *image_a = a;
+  const Image *image_b = b;
+  gint order_a, order_b;
+
+  order_a = image_a->dir_index < n_dir_sizes ? dir_sizes[image_a->dir_index].order : 0xffff;
+  order_b = image_b->dir_index < n_dir_sizes ? dir_sizes[image_b->dir_index].order : 0xffff;
+
+  return order_a - order_b;
+}
+
 static gboolean
 convert_to_hash (gpointer key, gpointer value, gpointer user_data)
 {
@@ -731,6 +958,9 @@ convert_to_hash (gpointer key, gpointer value, gpointer user_data)
   node->name = key;
   node->image_list = value;
 
+  if (dir_sizes)
+    node->image_list = g_list_sort (node->image_list, compare_image_order);
+
   if (context->nodes[hash] != NULL)
     node->next = context->nodes[hash];
 
@@ -798,12 +1028,11 @@ write_card32 (FILE *cache, guint32 n)
 
 
 static gboolean
-write_image_data (FILE *cache, ImageData *image_data, int offset)
+write_pixdata (FILE *cache, GdkPixdata *pixdata)
 {
   guint8 *s;
   guint len;
   gint i;
-  GdkPixdata *pixdata = &image_data->pixdata;
 
   /* Type 0 is GdkPixdata */
   if (!write_card32 (cache, 0))
@@ -824,6 +1053,41 @@ write_image_data (FILE *cache, ImageData *image_data, int offset)
   return i == 1;
 }
 
+static gboolean
+write_image_data (FILE *cache, ImageData *image_data, int offset)
+{
+  gint i, ofs;
+
+  if (image_data->n_renders == 0)
+    return write_pixdata (cache, &image_data->pixdata);
+
+  /* Type 1 is a list of GdkPixdata renderings of a scalable
+   * icon, with the length covering everything that follows it
+   */
+  if (!write_card32 (cache, 1) ||
+      !write_card32 (cache, image_data->size - 8) ||
+      !write_card32 (cache, image_data->n_renders))
+    return FALSE;
+
+  ofs = offset + 12 + 8 * image_data->n_renders;
+  for (i = 0; i < image_data->n_renders; i++)
+    {
+      if (!write_card32 (cache, image_data->render_sizes[i]) ||
+	  !write_card32 (cache, ofs))
+	return FALSE;
+
+      ofs += 8 + image_data->renders[i].length;
+    }
+
+  for (i = 0; i < image_data->n_renders; i++)
+    {
+      if (!write_pixdata (cache, &image_data->renders[i]))
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 write_icon_data (FILE *cache, IconData *icon_data, int offset)
 {
@@ -940,14 +1204,45 @@ write_icon_data (FILE *cache, IconData *icon_data, int offset)
 }
 
 static gboolean
-write_header (FILE *cache, guint32 dir_list_offset)
+write_header (FILE *cache, guint32 dir_list_offset, guint32 size_table_offset)
 {
+  if (dir_sizes)
+    return (write_card16 (cache, MAJOR_VERSION) &&
+	    write_card16 (cache, SIZE_TABLE_MINOR_VERSION) &&
+	    write_card32 (cache, SIZE_TABLE_HASH_OFFSET) &&
+	    write_card32 (cache, dir_list_offset) &&
+	    write_card32 (cache, size_table_offset));
+
   return (write_card16 (cache, MAJOR_VERSION) &&
 	  write_card16 (cache, MINOR_VERSION) &&
 	  write_card32 (cache, HASH_OFFSET) &&
 	  write_card32 (cache, dir_list_offset));
 }
 
+static gboolean
+write_size_table (FILE *cache)
+{
+  gint i;
+
+  if (!write_card32 (cache, n_dir_sizes))
+    return FALSE;
+
+  for (i = 0; i < n_dir_sizes; i++)
+    {
+      DirSize *dir_size = &dir_sizes[i];
+
+      if (!write_card16 (cache, dir_size->order) ||
+	  !write_card16 (cache, dir_size->type) ||
+	  !write_card16 (cache, dir_size->size) ||
+	  !write_card16 (cache, dir_size->min_size) ||
+	  !write_card16 (cache, dir_size->max_size) ||
+	  !write_card16 (cache, dir_size->threshold))
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
 static gint
 get_image_meta_data_size (Image *image)
 {
@@ -1242,7 +1537,7 @@ write_bucket (FILE *cache, HashNode *node, int *offset)
 static gboolean
 write_hash_table (FILE *cache, HashContext *context, int *new_offset)
 {
-  int offset = HASH_OFFSET;
+  int offset = dir_sizes ? SIZE_TABLE_HASH_OFFSET : HASH_OFFSET;
   int node_offset;
   int i;
 
@@ -1357,6 +1652,7 @@ write_file (FILE *cache, GHashTable *files, GList *directories)
 {
   HashContext context;
   int new_offset;
+  int size_table_offset = 0;
 
   /* Convert the hash table into something looking a bit more
    * like what we want to write to disk.
@@ -1369,7 +1665,7 @@ write_file (FILE *cache, GHashTable *files, GList *directories)
   /* Now write the file */
   /* We write 0 as the directory list offset and go
    * back and change it later */
-  if (!write_header (cache, 0))
+  if (!write_header (cache, 0, 0))
     {
       g_printerr (_("Failed to write header\n"));
       return FALSE;
@@ -1386,10 +1682,21 @@ write_file (FILE *cache, GHashTable *files, GList *directories)
       g_printerr (_("Failed to write folder index\n"));
       return FALSE;
     }
+
+  if (dir_sizes)
+    {
+      size_table_offset = ftell (cache);
+
+      if (!write_size_table (cache))
+	{
+	  g_printerr (_("Failed to write size table\n"));
+	  return FALSE;
+	}
+    }
   
   rewind (cache);
 
-  if (!write_header (cache, new_offset))
+  if (!write_header (cache, new_offset, size_table_offset))
     {
       g_printerr (_("Failed to rewrite header\n"));
       return FALSE;
@@ -1480,6 +1787,12 @@ build_cache (const gchar *path)
       g_unlink (cache_path);
       exit (0);
     }
+
+  if (size_table && !load_dir_sizes (path, directories))
+    {
+      if (!quiet)
+	g_printerr (_("Could not read the theme index, not writing a size table\n"));
+    }
     
   /* FIXME: Handle failure */
   retval = write_file (cache, files, directories);
@@ -1598,6 +1911,8 @@ static GOptionEntry args[] = {
   { "source", 'c', 0, G_OPTION_ARG_STRING, &var_name, N_("Output a C header file"), "NAME" },
   { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet, N_("Turn off verbose output"), NULL },
   { "validate", 'v', 0, G_OPTION_ARG_NONE, &validate, N_("Validate existing icon cache"), NULL },
+  { "size-table", 's', 0, G_OPTION_ARG_NONE, &size_table, N_("Include the directory sizes of the theme in the cache"), NULL },
+  { "render-scalable", 'r', 0, G_OPTION_ARG_NONE, &render_scalable, N_("Include renderings of scalable icons in the cache"), NULL },
   { NULL }
 };
 
@@ -25,6 +25,14 @@ struct _GtkWidgetProfilerPrivate {
 
   GdkAtom profiler_atom;
 
+  guint size_request_signal_id;
+  gulong size_request_hook_id;
+  guint n_size_requests;
+
+  guint size_allocate_signal_id;
+  gulong size_allocate_hook_id;
+  guint n_size_allocates;
+
   guint profiling : 1;
 };
 
@@ -71,6 +79,42 @@ gtk_widget_profiler_class_init (GtkWidgetProfilerClass *class)
   object_class->finalize = gtk_widget_profiler_finalize;
 }
 
+/* Counts the widgets that really compute their size request; widgets
+ * with a valid cached request don't emit "size-request".
+ */
+static gboolean
+size_request_emission_hook (GSignalInvocationHint *ihint,
+			    guint                  n_param_values,
+			    const GValue          *param_values,
+			    gpointer               data)
+{
+  GtkWidgetProfiler *profiler;
+
+  profiler = GTK_WIDGET_PROFILER (data);
+  if (profiler->priv->profiling)
+    profiler->priv->n_size_requests++;
+
+  return TRUE;
+}
+
+/* Likewise, widgets whose allocation didn't change don't emit
+ * "size-allocate".
+ */
+static gboolean
+size_allocate_emission_hook (GSignalInvocationHint *ihint,
+			     guint                  n_param_values,
+			     const GValue          *param_values,
+			     gpointer               data)
+{
+  GtkWidgetProfiler *profiler;
+
+  profiler = GTK_WIDGET_PROFILER (data);
+  if (profiler->priv->profiling)
+    profiler->priv->n_size_allocates++;
+
+  return TRUE;
+}
+
 static void
 gtk_widget_profiler_init (GtkWidgetProfiler *profiler)
 {
@@ -85,6 +129,16 @@ gtk_widget_profiler_init (GtkWidgetProfiler *profiler)
   priv->timer = g_timer_new ();
 
   priv->profiler_atom = gdk_atom_intern ("GtkWidgetProfiler", FALSE);
+
+  priv->size_request_signal_id = g_signal_lookup ("size-request", GTK_TYPE_WIDGET);
+  priv->size_request_hook_id = g_signal_add_emission_hook (priv->size_request_signal_id, 0,
+							   size_request_emission_hook,
+							   profiler, NULL);
+
+  priv->size_allocate_signal_id = g_signal_lookup ("size-allocate", GTK_TYPE_WIDGET);
+  priv->size_allocate_hook_id = g_signal_add_emission_hook (priv->size_allocate_signal_id, 0,
+							    size_allocate_emission_hook,
+							    profiler, NULL);
 }
 
 static void
@@ -122,6 +176,9 @@ gtk_widget_profiler_finalize (GObject *object)
   reset_state (profiler);
   g_timer_destroy (priv->timer);
 
+  g_signal_remove_emission_hook (priv->size_request_signal_id, priv->size_request_hook_id);
+  g_signal_remove_emission_hook (priv->size_allocate_signal_id, priv->size_allocate_hook_id);
+
   g_free (priv);
 
   G_OBJECT_CLASS (gtk_widget_profiler_parent_class)->finalize (object);
@@ -156,6 +213,9 @@ report (GtkWidgetProfiler      *profiler,
   priv = profiler->priv;
 
   g_signal_emit (profiler, signals[REPORT], 0, report, priv->profiled_widget, elapsed);
+
+  priv->n_size_requests = 0;
+  priv->n_size_allocates = 0;
 }
 
 static GtkWidget *
@@ -468,3 +528,239 @@ gtk_widget_profiler_profile_expose (GtkWidgetProfiler *profiler)
 
   reset_state (profiler);
 }
+
+/* Resolving the styles of all the widgets in the toplevel again is
+ * what happens on a theme change.  With the RC styles unchanged, this
+ * is dominated by matching the widgets against the RC patterns.
+ */
+static void
+profile_style (GtkWidgetProfiler *profiler)
+{
+  GtkWidgetProfilerPrivate *priv;
+  gdouble elapsed;
+
+  priv = profiler->priv;
+
+  g_assert (priv->state == STATE_INSTRUMENTED_MAPPED);
+
+  g_timer_reset (priv->timer);
+  gtk_widget_reset_rc_styles (priv->toplevel);
+  elapsed = g_timer_elapsed (priv->timer, NULL);
+
+  report (profiler, GTK_WIDGET_PROFILER_REPORT_STYLE, elapsed);
+}
+
+void
+gtk_widget_profiler_profile_style (GtkWidgetProfiler *profiler)
+{
+  GtkWidgetProfilerPrivate *priv;
+  gdouble elapsed;
+  int i, n;
+
+  g_return_if_fail (GTK_IS_WIDGET_PROFILER (profiler));
+
+  priv = profiler->priv;
+  g_return_if_fail (!priv->profiling);
+
+  reset_state (profiler);
+  priv->profiling = TRUE;
+
+  create_widget (profiler);
+
+  /* The first resolution happens when the widgets get shown */
+  g_timer_reset (priv->timer);
+  map_widget (profiler);
+  elapsed = g_timer_elapsed (priv->timer, NULL);
+
+  report (profiler, GTK_WIDGET_PROFILER_REPORT_MAP, elapsed);
+
+  n = priv->n_iterations;
+  for (i = 0; i < n; i++)
+    profile_style (profiler);
+
+  priv->profiling = FALSE;
+
+  reset_state (profiler);
+}
+
+static GtkWidget *
+find_label (GtkWidget *widget)
+{
+  GList *children, *l;
+  GtkWidget *label;
+
+  if (GTK_IS_LABEL (widget))
+    return widget;
+
+  if (!GTK_IS_CONTAINER (widget))
+    return NULL;
+
+  label = NULL;
+  children = gtk_container_get_children (GTK_CONTAINER (widget));
+  for (l = children; l && !label; l = l->next)
+    label = find_label (l->data);
+  g_list_free (children);
+
+  return label;
+}
+
+/* Changing the text of a label is what most updates of an application
+ * window come down to.  Only the label and the containers whose size
+ * request depends on it should compute their request again; the
+ * number of size requests in each frame is available from
+ * gtk_widget_profiler_get_n_size_requests() in the report.
+ */
+static void
+profile_resize (GtkWidgetProfiler *profiler,
+		GtkWidget         *label,
+		int                i)
+{
+  GtkWidgetProfilerPrivate *priv;
+  gdouble elapsed;
+
+  priv = profiler->priv;
+
+  g_assert (priv->state == STATE_INSTRUMENTED_MAPPED);
+
+  g_timer_reset (priv->timer);
+  priv->n_size_requests = 0;
+  priv->n_size_allocates = 0;
+
+  gtk_label_set_text (GTK_LABEL (label), (i % 2) ? "A longer label" : "Label");
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  elapsed = g_timer_elapsed (priv->timer, NULL);
+
+  report (profiler, GTK_WIDGET_PROFILER_REPORT_RESIZE, elapsed);
+}
+
+void
+gtk_widget_profiler_profile_resize (GtkWidgetProfiler *profiler)
+{
+  GtkWidgetProfilerPrivate *priv;
+  GtkWidget *label;
+  gdouble elapsed;
+  int i, n;
+
+  g_return_if_fail (GTK_IS_WIDGET_PROFILER (profiler));
+
+  priv = profiler->priv;
+  g_return_if_fail (!priv->profiling);
+
+  reset_state (profiler);
+  priv->profiling = TRUE;
+
+  create_widget (profiler);
+
+  label = find_label (priv->profiled_widget);
+  if (!label)
+    g_error ("The widget returned by the \"create-widget\" handler must contain a GtkLabel");
+
+  g_timer_reset (priv->timer);
+  priv->n_size_requests = 0;
+  priv->n_size_allocates = 0;
+  map_widget (profiler);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+  elapsed = g_timer_elapsed (priv->timer, NULL);
+
+  report (profiler, GTK_WIDGET_PROFILER_REPORT_MAP, elapsed);
+
+  n = priv->n_iterations;
+  for (i = 0; i < n; i++)
+    profile_resize (profiler, label, i);
+
+  priv->profiling = FALSE;
+
+  reset_state (profiler);
+}
+
+#define ALLOCATE_STEP 20
+
+/* Resizing the toplevel is what happens when the user resizes the
+ * window.  Subtrees whose allocation doesn't change shouldn't be
+ * allocated or redrawn again; the number of widgets allocated in
+ * each frame is available from gtk_widget_profiler_get_n_size_allocates()
+ * in the report.
+ */
+static void
+profile_allocate (GtkWidgetProfiler *profiler,
+		  int                i)
+{
+  GtkWidgetProfilerPrivate *priv;
+  GtkAllocation allocation;
+  gdouble elapsed;
+
+  priv = profiler->priv;
+
+  g_assert (priv->state == STATE_INSTRUMENTED_MAPPED);
+
+  g_timer_reset (priv->timer);
+  priv->n_size_requests = 0;
+  priv->n_size_allocates = 0;
+
+  /* Do what a configure event from the window manager would do */
+  allocation = priv->toplevel->allocation;
+  allocation.width += (i % 2) ? -ALLOCATE_STEP : ALLOCATE_STEP;
+  gdk_window_resize (priv->toplevel->window, allocation.width, allocation.height);
+  gtk_widget_size_allocate (priv->toplevel, &allocation);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  elapsed = g_timer_elapsed (priv->timer, NULL);
+
+  report (profiler, GTK_WIDGET_PROFILER_REPORT_ALLOCATE, elapsed);
+}
+
+void
+gtk_widget_profiler_profile_allocate (GtkWidgetProfiler *profiler)
+{
+  GtkWidgetProfilerPrivate *priv;
+  int i, n;
+
+  g_return_if_fail (GTK_IS_WIDGET_PROFILER (profiler));
+
+  priv = profiler->priv;
+  g_return_if_fail (!priv->profiling);
+
+  reset_state (profiler);
+  priv->profiling = TRUE;
+
+  create_widget (profiler);
+  map_widget (profiler);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  n = priv->n_iterations;
+  for (i = 0; i < n; i++)
+    profile_allocate (profiler, i);
+
+  priv->profiling = FALSE;
+
+  reset_state (profiler);
+}
+
+/* Returns the number of widgets that computed their size request
+ * during the stage being reported; only meaningful from a "report"
+ * signal handler.
+ */
+guint
+gtk_widget_profiler_get_n_size_requests (GtkWidgetProfiler *profiler)
+{
+  g_return_val_if_fail (GTK_IS_WIDGET_PROFILER (profiler), 0);
+
+  return profiler->priv->n_size_requests;
+}
+
+/* Returns the number of widgets that were allocated during the stage
+ * being reported; only meaningful from a "report" signal handler.
+ */
+guint
+gtk_widget_profiler_get_n_size_allocates (GtkWidgetProfiler *profiler)
+{
+  g_return_val_if_fail (GTK_IS_WIDGET_PROFILER (profiler), 0);
+
+  return profiler->priv->n_size_allocates;
+}
@@ -17,7 +17,10 @@ typedef enum
   GTK_WIDGET_PROFILER_REPORT_CREATE,
   GTK_WIDGET_PROFILER_REPORT_MAP,
   GTK_WIDGET_PROFILER_REPORT_EXPOSE,
-  GTK_WIDGET_PROFILER_REPORT_DESTROY
+  GTK_WIDGET_PROFILER_REPORT_DESTROY,
+  GTK_WIDGET_PROFILER_REPORT_STYLE,
+  GTK_WIDGET_PROFILER_REPORT_RESIZE,
+  GTK_WIDGET_PROFILER_REPORT_ALLOCATE
 } GtkWidgetProfilerReport;
 
 typedef struct _GtkWidgetProfiler GtkWidgetProfiler;
@@ -54,6 +57,16 @@ void gtk_widget_profiler_profile_boot (GtkWidgetProfiler *profiler);
 
 void gtk_widget_profiler_profile_expose (GtkWidgetProfiler *profiler);
 
+void gtk_widget_profiler_profile_style (GtkWidgetProfiler *profiler);
+
+void gtk_widget_profiler_profile_resize (GtkWidgetProfiler *profiler);
+
+void gtk_widget_profiler_profile_allocate (GtkWidgetProfiler *profiler);
+
+guint gtk_widget_profiler_get_n_size_requests (GtkWidgetProfiler *profiler);
+
+guint gtk_widget_profiler_get_n_size_allocates (GtkWidgetProfiler *profiler);
+
 
 G_END_DECLS
 
@@ -1,9 +1,13 @@
 #include <stdio.h>
+#include <string.h>
 #include <gtk/gtk.h>
 #include "gtkwidgetprofiler.h"
 #include "widgets.h"
 
 #define ITERS 100000
+#define STYLE_ITERS 100
+#define RESIZE_ITERS 100
+#define ALLOCATE_ITERS 100
 
 static GtkWidget *
 create_widget_cb (GtkWidgetProfiler *profiler, gpointer data)
@@ -11,6 +15,12 @@ create_widget_cb (GtkWidgetProfiler *profiler, gpointer data)
   return appwindow_new ();
 }
 
+static GtkWidget *
+create_widget_tree_cb (GtkWidgetProfiler *profiler, gpointer data)
+{
+  return widget_tree_new ();
+}
+
 static void
 report_cb (GtkWidgetProfiler *profiler, GtkWidgetProfilerReport report, GtkWidget *widget, gdouble elapsed, gpointer data)
 {
@@ -33,12 +43,32 @@ report_cb (GtkWidgetProfiler *profiler, GtkWidgetProfilerReport report, GtkWidge
     type = "widget destruction";
     break;
 
+  case GTK_WIDGET_PROFILER_REPORT_STYLE:
+    type = "style resolution";
+    break;
+
+  case GTK_WIDGET_PROFILER_REPORT_RESIZE:
+    type = "label resize";
+    break;
+
+  case GTK_WIDGET_PROFILER_REPORT_ALLOCATE:
+    type = "window resize";
+    break;
+
   default:
     g_assert_not_reached ();
     type = NULL;
   }
 
-  fprintf (stdout, "%s: %g sec\n", type, elapsed);
+  if (report == GTK_WIDGET_PROFILER_REPORT_MAP
+      || report == GTK_WIDGET_PROFILER_REPORT_RESIZE)
+    fprintf (stdout, "%s: %g sec, %u size requests\n", type, elapsed,
+	     gtk_widget_profiler_get_n_size_requests (profiler));
+  else if (report == GTK_WIDGET_PROFILER_REPORT_ALLOCATE)
+    fprintf (stdout, "%s: %g sec, %u size allocations\n", type, elapsed,
+	     gtk_widget_profiler_get_n_size_allocates (profiler));
+  else
+    fprintf (stdout, "%s: %g sec\n", type, elapsed);
 
   if (report == GTK_WIDGET_PROFILER_REPORT_DESTROY)
     fputs ("\n", stdout);
@@ -52,11 +82,48 @@ main (int argc, char **argv)
   gtk_init (&argc, &argv);
 
   profiler = gtk_widget_profiler_new ();
-  g_signal_connect (profiler, "create-widget",
-		    G_CALLBACK (create_widget_cb), NULL);
   g_signal_connect (profiler, "report",
 		    G_CALLBACK (report_cb), NULL);
 
+  /* testperf --style times resolving the styles of a large widget tree */
+  if (argc > 1 && strcmp (argv[1], "--style") == 0)
+    {
+      g_signal_connect (profiler, "create-widget",
+			G_CALLBACK (create_widget_tree_cb), NULL);
+
+      gtk_widget_profiler_set_num_iterations (profiler, STYLE_ITERS);
+      gtk_widget_profiler_profile_style (profiler);
+
+      return 0;
+    }
+
+  /* testperf --resize counts the size requests done for a label change */
+  if (argc > 1 && strcmp (argv[1], "--resize") == 0)
+    {
+      g_signal_connect (profiler, "create-widget",
+			G_CALLBACK (create_widget_tree_cb), NULL);
+
+      gtk_widget_profiler_set_num_iterations (profiler, RESIZE_ITERS);
+      gtk_widget_profiler_profile_resize (profiler);
+
+      return 0;
+    }
+
+  /* testperf --allocate times resizing a window with about 10000 widgets */
+  if (argc > 1 && strcmp (argv[1], "--allocate") == 0)
+    {
+      g_signal_connect (profiler, "create-widget",
+			G_CALLBACK (create_widget_tree_cb), NULL);
+
+      gtk_widget_profiler_set_num_iterations (profiler, ALLOCATE_ITERS);
+      gtk_widget_profiler_profile_allocate (profiler);
+
+      return 0;
+    }
+
+  g_signal_connect (profiler, "create-widget",
+		    G_CALLBACK (create_widget_cb), NULL);
+
   gtk_widget_profiler_set_num_iterations (profiler, ITERS);
 
 /*   gtk_widget_profiler_profile_boot (profiler); */
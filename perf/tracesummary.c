@@ -0,0 +1,437 @@
+/* tracesummary.c
+ * Prints latency histograms from an event dispatch trace, as written
+ * by GDK when run with GDK_DEBUG=trace.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gdk/gdk.h>
+#include <gdk/gdkprivate.h>
+
+#define N_BUCKETS 24
+
+static gboolean histograms = FALSE;
+
+static GOptionEntry entries[] = {
+  { "histograms", 'H', 0, G_OPTION_ARG_NONE, &histograms, "Print a histogram for each row", NULL },
+  { NULL }
+};
+
+/* The durations, in microseconds, measured for one thing */
+typedef struct
+{
+  gchar  *name;
+  GArray *samples;
+} Series;
+
+typedef struct
+{
+  const gchar *title;
+  GHashTable  *series;
+} Section;
+
+typedef struct
+{
+  guint64 time;
+  guint32 id;
+  guint32 detail;
+} OpenRecord;
+
+static void
+series_free (Series *series)
+{
+  g_free (series->name);
+  g_array_free (series->samples, TRUE);
+  g_free (series);
+}
+
+static void
+section_init (Section     *section,
+              const gchar *title)
+{
+  section->title = title;
+  section->series = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, (GDestroyNotify) series_free);
+}
+
+static void
+section_add (Section     *section,
+             const gchar *name,
+             guint64      duration)
+{
+  Series *series;
+
+  series = g_hash_table_lookup (section->series, name);
+  if (!series)
+    {
+      series = g_new (Series, 1);
+      series->name = g_strdup (name);
+      series->samples = g_array_new (FALSE, FALSE, sizeof (guint64));
+      g_hash_table_insert (section->series, series->name, series);
+    }
+
+  g_array_append_val (series->samples, duration);
+}
+
+static gint
+compare_samples (gconstpointer a,
+                 gconstpointer b)
+{
+  guint64 x = *(const guint64 *) a;
+  guint64 y = *(const guint64 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+static gint
+compare_series (gconstpointer a,
+                gconstpointer b)
+{
+  const Series *x = *(Series * const *) a;
+  const Series *y = *(Series * const *) b;
+
+  return (gint) y->samples->len - (gint) x->samples->len;
+}
+
+static void
+print_histogram (Series *series)
+{
+  guint buckets[N_BUCKETS] = { 0 };
+  guint max = 0;
+  guint i;
+
+  /* bucket i holds the durations in [2^i, 2^(i+1)) microseconds */
+  for (i = 0; i < series->samples->len; i++)
+    {
+      guint64 d = g_array_index (series->samples, guint64, i);
+      guint b = 0;
+
+      while (d > 1 && b < N_BUCKETS - 1)
+        {
+          d >>= 1;
+          b++;
+        }
+
+      buckets[b]++;
+      max = MAX (max, buckets[b]);
+    }
+
+  for (i = 0; i < N_BUCKETS; i++)
+    {
+      if (buckets[i])
+        {
+          gchar *bar = g_strnfill (1 + 50 * (buckets[i] - 1) / max, '#');
+
+          g_print ("    %10.3f ms %8u %s\n", (1 << i) / 1000.0, buckets[i], bar);
+          g_free (bar);
+        }
+    }
+}
+
+static void
+print_section (Section *section)
+{
+  GPtrArray *all;
+  GHashTableIter iter;
+  gpointer value;
+  guint i;
+
+  if (g_hash_table_size (section->series) == 0)
+    return;
+
+  all = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, section->series);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (all, value);
+  g_ptr_array_sort (all, compare_series);
+
+  g_print ("%s\n", section->title);
+  g_print ("  %-28s %8s %10s %10s %10s %10s\n",
+           "", "count", "mean ms", "median ms", "95% ms", "max ms");
+
+  for (i = 0; i < all->len; i++)
+    {
+      Series *series = all->pdata[i];
+      GArray *samples = series->samples;
+      guint64 total = 0;
+      guint j;
+
+      g_array_sort (samples, compare_samples);
+      for (j = 0; j < samples->len; j++)
+        total += g_array_index (samples, guint64, j);
+
+      g_print ("  %-28s %8u %10.3f %10.3f %10.3f %10.3f\n",
+               series->name, samples->len,
+               total / 1000.0 / samples->len,
+               g_array_index (samples, guint64, samples->len / 2) / 1000.0,
+               g_array_index (samples, guint64, samples->len * 95 / 100) / 1000.0,
+               g_array_index (samples, guint64, samples->len - 1) / 1000.0);
+
+      if (histograms)
+        print_histogram (series);
+    }
+
+  g_print ("\n");
+  g_ptr_array_free (all, TRUE);
+}
+
+static const gchar *
+event_type_name (guint32 type)
+{
+  static GEnumClass *enum_class = NULL;
+  GEnumValue *value;
+
+  if (!enum_class)
+    enum_class = g_type_class_ref (GDK_TYPE_EVENT_TYPE);
+
+  value = g_enum_get_value (enum_class, type);
+
+  return value ? value->value_nick : "unknown";
+}
+
+static gboolean
+is_input_event (guint32 type)
+{
+  switch (type)
+    {
+    case GDK_MOTION_NOTIFY:
+    case GDK_BUTTON_PRESS:
+    case GDK_2BUTTON_PRESS:
+    case GDK_3BUTTON_PRESS:
+    case GDK_BUTTON_RELEASE:
+    case GDK_KEY_PRESS:
+    case GDK_KEY_RELEASE:
+    case GDK_SCROLL:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/* Reads the signal table that follows the records */
+static GHashTable *
+read_signal_names (const gchar *data,
+                   gsize        length,
+                   guint        n_signals)
+{
+  GHashTable *names;
+  guint i;
+
+  names = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  for (i = 0; i < n_signals; i++)
+    {
+      guint32 entry[2];
+
+      if (length < sizeof (entry))
+        break;
+      memcpy (entry, data, sizeof (entry));
+      data += sizeof (entry);
+      length -= sizeof (entry);
+
+      if (length < entry[1])
+        break;
+      g_hash_table_insert (names, GUINT_TO_POINTER (entry[0]),
+                           g_strndup (data, entry[1]));
+      data += entry[1];
+      length -= entry[1];
+    }
+
+  return names;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  gchar *contents;
+  gsize length;
+  GdkTraceHeader header;
+  const GdkTraceRecord *records;
+  GHashTable *signal_names;
+  GHashTable *queued;
+  GArray *dispatches, *emissions;
+  GArray *waiting;
+  Section queue_latency, dispatch_time, signal_time, paint_latency, paint_time;
+  guint paint_depth = 0;
+  guint64 paint_start = 0;
+  guint i;
+
+  g_type_init ();
+
+  context = g_option_context_new ("TRACEFILE - summarize an event dispatch trace");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  if (argc != 2)
+    {
+      g_printerr ("Usage: %s [--histograms] TRACEFILE\n", argv[0]);
+      return 1;
+    }
+
+  if (!g_file_get_contents (argv[1], &contents, &length, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  if (length < sizeof (header))
+    {
+      g_printerr ("%s: not a trace file\n", argv[1]);
+      return 1;
+    }
+  memcpy (&header, contents, sizeof (header));
+
+  if (memcmp (header.magic, GDK_TRACE_MAGIC, sizeof (header.magic)) != 0 ||
+      header.version != GDK_TRACE_VERSION ||
+      (length - sizeof (header)) / sizeof (GdkTraceRecord) < header.n_records)
+    {
+      g_printerr ("%s: not a trace file, or written by another version\n", argv[1]);
+      return 1;
+    }
+
+  records = (const GdkTraceRecord *) (contents + sizeof (header));
+  signal_names = read_signal_names ((gchar *) (records + header.n_records),
+                                    length - sizeof (header) - header.n_records * sizeof (GdkTraceRecord),
+                                    header.n_signals);
+
+  section_init (&queue_latency, "Time from queueing to dispatch");
+  section_init (&dispatch_time, "Time in gtk_main_do_event()");
+  section_init (&signal_time, "Time in signal handlers");
+  section_init (&paint_latency, "Time from queueing input to the end of the next paint");
+  section_init (&paint_time, "Time painting");
+
+  queued = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  dispatches = g_array_new (FALSE, FALSE, sizeof (OpenRecord));
+  emissions = g_array_new (FALSE, FALSE, sizeof (OpenRecord));
+  waiting = g_array_new (FALSE, FALSE, sizeof (OpenRecord));
+
+  for (i = 0; i < header.n_records; i++)
+    {
+      const GdkTraceRecord *record = &records[i];
+      OpenRecord open;
+      const gchar *name;
+      guint64 *time;
+
+      open.time = record->time;
+      open.id = record->id;
+      open.detail = record->detail;
+
+      switch (record->type)
+        {
+        case GDK_TRACE_EVENT_QUEUED:
+          time = g_new (guint64, 1);
+          *time = record->time;
+          g_hash_table_insert (queued, GUINT_TO_POINTER (record->id), time);
+          break;
+
+        case GDK_TRACE_DISPATCH_BEGIN:
+          time = g_hash_table_lookup (queued, GUINT_TO_POINTER (record->id));
+          if (time)
+            section_add (&queue_latency, event_type_name (record->detail),
+                         record->time - *time);
+          g_array_append_val (dispatches, open);
+          break;
+
+        case GDK_TRACE_DISPATCH_END:
+          if (dispatches->len == 0)
+            break;
+          open = g_array_index (dispatches, OpenRecord, dispatches->len - 1);
+          g_array_set_size (dispatches, dispatches->len - 1);
+          section_add (&dispatch_time, event_type_name (open.detail),
+                       record->time - open.time);
+
+          time = g_hash_table_lookup (queued, GUINT_TO_POINTER (open.id));
+          if (time && is_input_event (open.detail))
+            {
+              open.time = *time;
+              g_array_append_val (waiting, open);
+            }
+          g_hash_table_remove (queued, GUINT_TO_POINTER (open.id));
+          break;
+
+        case GDK_TRACE_SIGNAL_BEGIN:
+          g_array_append_val (emissions, open);
+          break;
+
+        case GDK_TRACE_SIGNAL_END:
+          if (emissions->len == 0)
+            break;
+          open = g_array_index (emissions, OpenRecord, emissions->len - 1);
+          g_array_set_size (emissions, emissions->len - 1);
+          name = g_hash_table_lookup (signal_names, GUINT_TO_POINTER (open.detail));
+          section_add (&signal_time, name && *name ? name : "unknown",
+                       record->time - open.time);
+          break;
+
+        case GDK_TRACE_PAINT_BEGIN:
+          if (paint_depth++ == 0)
+            paint_start = record->time;
+          break;
+
+        case GDK_TRACE_PAINT_END:
+          if (paint_depth == 0 || --paint_depth > 0)
+            break;
+          section_add (&paint_time, "all windows", record->time - paint_start);
+
+          /* This paint shows the result of the input handled so far */
+          while (waiting->len > 0)
+            {
+              open = g_array_index (waiting, OpenRecord, waiting->len - 1);
+              g_array_set_size (waiting, waiting->len - 1);
+              section_add (&paint_latency, event_type_name (open.detail),
+                           record->time - open.time);
+            }
+          break;
+
+        default:
+          break;
+        }
+    }
+
+  g_print ("%u records", header.n_records);
+  if (header.n_dropped)
+    g_print (", %u older records were dropped", header.n_dropped);
+  g_print ("\n\n");
+
+  print_section (&queue_latency);
+  print_section (&dispatch_time);
+  print_section (&signal_time);
+  print_section (&paint_time);
+  print_section (&paint_latency);
+
+  g_hash_table_destroy (queue_latency.series);
+  g_hash_table_destroy (dispatch_time.series);
+  g_hash_table_destroy (signal_time.series);
+  g_hash_table_destroy (paint_time.series);
+  g_hash_table_destroy (paint_latency.series);
+  g_hash_table_destroy (queued);
+  g_hash_table_destroy (signal_names);
+  g_array_free (dispatches, TRUE);
+  g_array_free (emissions, TRUE);
+  g_array_free (waiting, TRUE);
+  g_option_context_free (context);
+  g_free (contents);
+
+  return 0;
+}
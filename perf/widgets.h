@@ -5,3 +5,5 @@ GtkWidget *appwindow_new (void);
 GtkWidget *text_view_new (void);
 
 GtkWidget *tree_view_new (void);
+
+GtkWidget *widget_tree_new (void);
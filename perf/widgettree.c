@@ -0,0 +1,95 @@
+/* This file creates a large tree of about 10000 simple widgets, along
+ * with an RC file that has patterns of all kinds, to measure how long
+ * it takes to resolve the styles of many widgets and to lay them out.
+ */
+
+#include <gtk/gtk.h>
+
+#include "widgets.h"
+
+#define N_ROWS    130
+#define N_COLUMNS 50
+
+static const char *rc_text =
+  "style \"perf-frame\" { xthickness = 3 ythickness = 3 }\n"
+  "style \"perf-button\" { bg[PRELIGHT] = \"#dcdad5\" }\n"
+  "style \"perf-label\" { fg[NORMAL] = \"#101010\" }\n"
+  "style \"perf-entry\" { base[NORMAL] = \"#ffffff\" }\n"
+  "style \"perf-odd\" { bg[NORMAL] = \"#eeeeee\" }\n"
+  "style \"perf-named\" { fg[ACTIVE] = \"#0000aa\" }\n"
+  "class \"GtkFrame\" style \"perf-frame\"\n"
+  "class \"GtkButton\" style \"perf-button\"\n"
+  "class \"GtkEntry\" style \"perf-entry\"\n"
+  "widget_class \"*.GtkButton.GtkLabel\" style \"perf-label\"\n"
+  "widget_class \"*<GtkFrame>*GtkLabel\" style \"perf-label\"\n"
+  "widget_class \"GtkWindow.*.GtkEntry\" style \"perf-entry\"\n"
+  "widget \"*.odd-row\" style \"perf-odd\"\n"
+  "widget \"*.odd-row.*\" style \"perf-odd\"\n"
+  "widget \"*named*\" style \"perf-named\"\n"
+  "widget \"perf-window.*.GtkButton\" style \"perf-button\"\n";
+
+static GtkWidget *
+create_row (int row)
+{
+  GtkWidget *hbox;
+  int i;
+
+  hbox = gtk_hbox_new (FALSE, 0);
+  if (row % 2)
+    gtk_widget_set_name (hbox, "odd-row");
+
+  for (i = 0; i < N_COLUMNS; i++)
+    {
+      GtkWidget *widget;
+
+      switch (i % 4)
+	{
+	case 0:
+	  widget = gtk_button_new_with_label ("Button");
+	  break;
+	case 1:
+	  widget = gtk_label_new ("Label");
+	  break;
+	case 2:
+	  widget = gtk_entry_new ();
+	  gtk_entry_set_width_chars (GTK_ENTRY (widget), 4);
+	  break;
+	default:
+	  widget = gtk_frame_new (NULL);
+	  gtk_container_add (GTK_CONTAINER (widget), gtk_label_new ("Frame"));
+	  if (i % 3 == 0)
+	    gtk_widget_set_name (widget, "named-frame");
+	  break;
+	}
+
+      gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, FALSE, 0);
+    }
+
+  return hbox;
+}
+
+GtkWidget *
+widget_tree_new (void)
+{
+  static gboolean rc_parsed = FALSE;
+  GtkWidget *window;
+  GtkWidget *vbox;
+  int i;
+
+  if (!rc_parsed)
+    {
+      gtk_rc_parse_string (rc_text);
+      rc_parsed = TRUE;
+    }
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_widget_set_name (window, "perf-window");
+
+  vbox = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (window), vbox);
+
+  for (i = 0; i < N_ROWS; i++)
+    gtk_box_pack_start (GTK_BOX (vbox), create_row (i), FALSE, FALSE, 0);
+
+  return window;
+}
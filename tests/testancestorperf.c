@@ -0,0 +1,127 @@
+/* testancestorperf.c
+ * Measures toplevel, ancestor and coordinate translation lookups
+ * in a deeply nested widget tree.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+static gint depth = 40;
+static gint n_iterations = 1000000;
+
+static GOptionEntry entries[] = {
+  { "depth", 'd', 0, G_OPTION_ARG_INT, &depth, "Nesting depth of the widget tree", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations, "Lookups per measurement", "N" },
+  { NULL }
+};
+
+static void
+report (const gchar *what,
+        gdouble      elapsed)
+{
+  g_print ("%-32s %8.3fs  %8.1f ns/lookup\n",
+           what, elapsed, 1e9 * elapsed / n_iterations);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GtkWidget *window;
+  GtkWidget *parent, *vbox, *leaf, *middle, *sibling;
+  GTimer *timer;
+  gint i, x, y;
+
+  gtk_init (&argc, &argv);
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, NULL);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+
+  /* A chain of event boxes, alternating with and without
+   * windows, ending in a box with two labels.
+   */
+  parent = window;
+  middle = window;
+  for (i = 0; i < depth; i++)
+    {
+      GtkWidget *box = gtk_event_box_new ();
+
+      gtk_event_box_set_visible_window (GTK_EVENT_BOX (box), i % 2);
+      gtk_container_add (GTK_CONTAINER (parent), box);
+
+      if (i == depth / 2)
+        middle = box;
+
+      parent = box;
+    }
+
+  vbox = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (parent), vbox);
+  leaf = gtk_label_new ("Leaf");
+  gtk_box_pack_start (GTK_BOX (vbox), leaf, FALSE, FALSE, 0);
+  sibling = gtk_label_new ("Sibling");
+  gtk_box_pack_start (GTK_BOX (vbox), sibling, FALSE, FALSE, 0);
+
+  gtk_widget_show_all (window);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_print ("depth %d, %d lookups\n\n", depth, n_iterations);
+
+  timer = g_timer_new ();
+
+  g_timer_start (timer);
+  for (i = 0; i < n_iterations; i++)
+    gtk_widget_get_toplevel (leaf);
+  g_timer_stop (timer);
+  report ("gtk_widget_get_toplevel", g_timer_elapsed (timer, NULL));
+
+  g_timer_start (timer);
+  for (i = 0; i < n_iterations; i++)
+    gtk_widget_is_ancestor (leaf, middle);
+  g_timer_stop (timer);
+  report ("gtk_widget_is_ancestor", g_timer_elapsed (timer, NULL));
+
+  g_timer_start (timer);
+  for (i = 0; i < n_iterations; i++)
+    gtk_widget_get_ancestor (leaf, GTK_TYPE_WINDOW);
+  g_timer_stop (timer);
+  report ("gtk_widget_get_ancestor", g_timer_elapsed (timer, NULL));
+
+  g_timer_start (timer);
+  for (i = 0; i < n_iterations; i++)
+    gtk_widget_translate_coordinates (leaf, sibling, 0, 0, &x, &y);
+  g_timer_stop (timer);
+  report ("translate to sibling", g_timer_elapsed (timer, NULL));
+
+  g_timer_start (timer);
+  for (i = 0; i < n_iterations; i++)
+    gtk_widget_translate_coordinates (leaf, window, 0, 0, &x, &y);
+  g_timer_stop (timer);
+  report ("translate to toplevel", g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+
+  gtk_widget_destroy (window);
+
+  return 0;
+}
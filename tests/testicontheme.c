@@ -33,9 +33,44 @@ usage (void)
 	   "usage: test-icon-theme display <theme name> <icon name> [size]\n"
 	   " or\n"
 	   "usage: test-icon-theme contexts <theme name>\n"
+	   " or\n"
+	   "usage: test-icon-theme profile <theme name> <icon name>...\n"
 	   );
 }
 
+/* Loads the icons at the usual sizes a number of times, the way
+ * many widgets showing the same icons would. Run with
+ * GTK_DEBUG=icontheme to see how the icon theme caches performed.
+ */
+static void
+profile (GtkIconTheme *icon_theme,
+	 gchar       **icon_names,
+	 gint          n_icon_names)
+{
+  static const gint sizes[] = { 16, 22, 24, 32, 48 };
+  GTimer *timer;
+  gint i, j, k;
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < 100; i++)
+    for (j = 0; j < n_icon_names; j++)
+      for (k = 0; k < G_N_ELEMENTS (sizes); k++)
+	{
+	  GdkPixbuf *pixbuf;
+
+	  pixbuf = gtk_icon_theme_load_icon (icon_theme, icon_names[j], sizes[k], 0, NULL);
+	  if (pixbuf)
+	    g_object_unref (pixbuf);
+
+	  if (i == 0 && j == n_icon_names - 1 && k == G_N_ELEMENTS (sizes) - 1)
+	    g_print ("first pass: %g sec\n", g_timer_elapsed (timer, NULL));
+	}
+
+  g_print ("100 passes: %g sec\n", g_timer_elapsed (timer, NULL));
+  g_timer_destroy (timer);
+}
+
 
 int
 main (int argc, char *argv[])
@@ -131,6 +166,17 @@ main (int argc, char *argv[])
 	  list = list->next;
 	}
     }
+  else if (strcmp (argv[1], "profile") == 0)
+    {
+      if (argc < 4)
+	{
+	  g_object_unref (icon_theme);
+	  usage ();
+	  return 1;
+	}
+
+      profile (icon_theme, argv + 3, argc - 3);
+    }
   else if (strcmp (argv[1], "lookup") == 0)
     {
       if (argc < 4)
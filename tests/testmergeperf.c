@@ -0,0 +1,213 @@
+/* testmergeperf.c
+ * Measures how long GtkUIManager takes to merge and remove UI fragments.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+static gint n_fragments = 100;
+static gint n_iterations = 20;
+static gint n_items = 5;
+static gboolean with_window = FALSE;
+
+static GOptionEntry entries[] = {
+  { "fragments", 'f', 0, G_OPTION_ARG_INT, &n_fragments, "Number of UI fragments", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations, "Times to merge and remove all fragments", "N" },
+  { "items", 'n', 0, G_OPTION_ARG_INT, &n_items, "Menu and tool items per fragment", "N" },
+  { "window", 'w', 0, G_OPTION_ARG_NONE, &with_window, "Show the menubar and toolbar in a window", NULL },
+  { NULL }
+};
+
+static void
+add_widget (GtkUIManager *merge,
+            GtkWidget    *widget,
+            GtkBox       *box)
+{
+  gtk_box_pack_start (box, widget, FALSE, FALSE, 0);
+}
+
+static GtkActionGroup *
+make_actions (void)
+{
+  GtkActionGroup *group;
+  gint i, j;
+
+  group = gtk_action_group_new ("Actions");
+
+  for (i = 0; i < n_fragments; i++)
+    {
+      gchar *name = g_strdup_printf ("Menu%d", i);
+      GtkAction *action = gtk_action_new (name, name, NULL, NULL);
+
+      gtk_action_group_add_action (group, action);
+      g_object_unref (action);
+      g_free (name);
+
+      for (j = 0; j < n_items; j++)
+        {
+          name = g_strdup_printf ("Action%d_%d", i, j);
+          action = gtk_action_new (name, name, NULL, GTK_STOCK_OPEN);
+          gtk_action_group_add_action (group, action);
+          g_object_unref (action);
+          g_free (name);
+        }
+    }
+
+  return group;
+}
+
+/* Each fragment adds a menu to the menubar, and the same actions
+ * to a shared menu and to the toolbar.
+ */
+static gchar *
+make_fragment (gint i)
+{
+  GString *ui;
+  gint j;
+
+  ui = g_string_new ("<ui><menubar name='MenuBar'>");
+
+  g_string_append_printf (ui, "<menu action='Menu%d'>", i);
+  for (j = 0; j < n_items; j++)
+    g_string_append_printf (ui, "<menuitem action='Action%d_%d'/>", i, j);
+  g_string_append (ui, "</menu>");
+
+  g_string_append (ui, "<menu action='Menu0'><separator/>");
+  for (j = 0; j < n_items; j++)
+    g_string_append_printf (ui, "<menuitem name='Shared%d_%d' action='Action%d_%d'/>", i, j, i, j);
+  g_string_append (ui, "</menu></menubar><toolbar name='ToolBar'>");
+
+  for (j = 0; j < n_items; j++)
+    g_string_append_printf (ui, "<toolitem action='Action%d_%d'/>", i, j);
+  g_string_append (ui, "<separator/></toolbar></ui>");
+
+  return g_string_free (ui, FALSE);
+}
+
+static void
+report (const gchar *what,
+        gdouble      elapsed)
+{
+  g_print ("%-24s %8.3fs  %8.3f ms/fragment\n",
+           what, elapsed, 1000 * elapsed / (n_fragments * n_iterations));
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GtkUIManager *merge;
+  GtkActionGroup *group;
+  GtkWidget *window;
+  GtkWidget *box;
+  GTimer *timer;
+  gchar **fragments;
+  guint *merge_ids;
+  gdouble merge_time, remove_time;
+  gint i, k;
+
+  gtk_init (&argc, &argv);
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, NULL);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_vbox_new (FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+
+  merge = gtk_ui_manager_new ();
+  g_signal_connect (merge, "add-widget", G_CALLBACK (add_widget), box);
+
+  group = make_actions ();
+  gtk_ui_manager_insert_action_group (merge, group, 0);
+
+  fragments = g_new (gchar *, n_fragments);
+  merge_ids = g_new (guint, n_fragments);
+  for (i = 0; i < n_fragments; i++)
+    fragments[i] = make_fragment (i);
+
+  /* Keep the menubar and the toolbar alive between iterations */
+  gtk_ui_manager_add_ui_from_string (merge,
+                                     "<ui><menubar name='MenuBar'/>"
+                                     "<toolbar name='ToolBar'/></ui>",
+                                     -1, NULL);
+  gtk_ui_manager_ensure_update (merge);
+
+  if (with_window)
+    gtk_widget_show_all (window);
+
+  g_print ("%d fragments of %d items, %d iterations\n\n",
+           n_fragments, n_items, n_iterations);
+
+  timer = g_timer_new ();
+  merge_time = remove_time = 0;
+
+  for (k = 0; k < n_iterations; k++)
+    {
+      g_timer_start (timer);
+      for (i = 0; i < n_fragments; i++)
+        {
+          merge_ids[i] = gtk_ui_manager_add_ui_from_string (merge, fragments[i], -1, NULL);
+          gtk_ui_manager_ensure_update (merge);
+        }
+      g_timer_stop (timer);
+      merge_time += g_timer_elapsed (timer, NULL);
+
+      if (with_window)
+        while (gtk_events_pending ())
+          gtk_main_iteration ();
+
+      g_timer_start (timer);
+      for (i = n_fragments - 1; i >= 0; i--)
+        {
+          gtk_ui_manager_remove_ui (merge, merge_ids[i]);
+          gtk_ui_manager_ensure_update (merge);
+        }
+      g_timer_stop (timer);
+      remove_time += g_timer_elapsed (timer, NULL);
+    }
+
+  report ("merging fragments", merge_time);
+  report ("removing fragments", remove_time);
+
+  /* All fragments at once, with a single update */
+  g_timer_start (timer);
+  for (i = 0; i < n_fragments; i++)
+    merge_ids[i] = gtk_ui_manager_add_ui_from_string (merge, fragments[i], -1, NULL);
+  gtk_ui_manager_ensure_update (merge);
+  for (i = 0; i < n_fragments; i++)
+    gtk_ui_manager_remove_ui (merge, merge_ids[i]);
+  gtk_ui_manager_ensure_update (merge);
+  g_timer_stop (timer);
+  g_print ("%-24s %8.3fs\n", "batched merge and remove", g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+
+  for (i = 0; i < n_fragments; i++)
+    g_free (fragments[i]);
+  g_free (fragments);
+  g_free (merge_ids);
+
+  gtk_widget_destroy (window);
+  g_object_unref (merge);
+  g_object_unref (group);
+
+  return 0;
+}
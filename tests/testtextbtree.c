@@ -0,0 +1,162 @@
+/* testtextbtree.c
+ * Measures the memory used per line of text by GtkTextBuffer.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef HAVE_MALLINFO
+#include <malloc.h>
+#endif
+
+#include <gtk/gtk.h>
+
+static gint n_lines = 100000;
+static gint line_length = 40;
+static gboolean with_view = FALSE;
+
+static GOptionEntry entries[] = {
+  { "lines", 'n', 0, G_OPTION_ARG_INT, &n_lines, "Number of lines", "N" },
+  { "line-length", 'l', 0, G_OPTION_ARG_INT, &line_length, "Characters per line", "L" },
+  { "view", 'v', 0, G_OPTION_ARG_NONE, &with_view, "Also lay out the buffer in a text view", NULL },
+  { NULL }
+};
+
+static glong
+memory_in_use (void)
+{
+#ifdef HAVE_MALLINFO
+  struct mallinfo info = mallinfo ();
+
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+static gchar *
+make_text (void)
+{
+  GString *text;
+  gint i, j;
+
+  text = g_string_sized_new ((gsize) n_lines * (line_length + 1));
+
+  for (i = 0; i < n_lines; i++)
+    {
+      for (j = 0; j < line_length; j++)
+        g_string_append_c (text, 'a' + (i + j) % 26);
+      g_string_append_c (text, '\n');
+    }
+
+  return g_string_free (text, FALSE);
+}
+
+static void
+report (const gchar *what,
+        glong        before,
+        gdouble      elapsed)
+{
+  glong used = memory_in_use () - before;
+
+  g_print ("%-24s %8.3fs  %10ldk  %8.1f bytes/line  %8.1f overhead/line\n",
+           what, elapsed, used / 1024,
+           (gdouble) used / n_lines,
+           (gdouble) used / n_lines - (line_length + 1));
+}
+
+static void
+fill_view (GtkTextBuffer *buffer)
+{
+  GtkWidget *window;
+  GtkWidget *view;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  view = gtk_text_view_new_with_buffer (buffer);
+  gtk_container_add (GTK_CONTAINER (window), view);
+  gtk_widget_show_all (window);
+
+  /* Validates the whole buffer */
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GTimer *timer;
+  gchar *text;
+  glong before;
+  gint i;
+
+  gtk_init (&argc, &argv);
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_parse (context, &argc, &argv, NULL);
+
+#ifndef HAVE_MALLINFO
+  g_print ("mallinfo() is not available, memory use can't be measured\n");
+#endif
+
+  text = make_text ();
+  timer = g_timer_new ();
+
+  g_print ("%d lines of %d characters\n\n", n_lines, line_length);
+
+  /* All lines in one insertion, like loading a file */
+  before = memory_in_use ();
+  g_timer_start (timer);
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text, -1);
+  g_timer_stop (timer);
+  report ("single insertion", before, g_timer_elapsed (timer, NULL));
+
+  if (with_view)
+    {
+      g_timer_start (timer);
+      fill_view (buffer);
+      g_timer_stop (timer);
+      report ("with view", before, g_timer_elapsed (timer, NULL));
+    }
+
+  g_object_unref (buffer);
+
+  /* One line at a time, like a growing log */
+  before = memory_in_use ();
+  g_timer_start (timer);
+  buffer = gtk_text_buffer_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    {
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+      gtk_text_buffer_insert (buffer, &iter, text + i * (line_length + 1), line_length + 1);
+    }
+  g_timer_stop (timer);
+  report ("appending lines", before, g_timer_elapsed (timer, NULL));
+
+  g_object_unref (buffer);
+
+  g_timer_destroy (timer);
+  g_free (text);
+
+  return 0;
+}